@@ -43,6 +43,7 @@
 
 #include <fstream>
 #include <string>
+#include <vector>
 
 static bool gbGotError = false;
 static void CPL_STDCALL myErrorHandler(CPLErr, CPLErrorNum, const char*)
@@ -2508,4 +2509,117 @@ namespace tut
         ensure_equals(counter,400);
     }
 
+    // Test VSIFAcquireReadViewL() / VSIFReleaseReadViewL()
+    template<>
+    template<>
+    void object::test<37>()
+    {
+        std::vector<GByte> abyData(256 * 1024);
+        for( size_t i = 0; i < abyData.size(); i++ )
+            abyData[i] = static_cast<GByte>(i * 7 + i / 251);
+
+        const CPLString aosFilenames[] = {
+            "/vsimem/test_read_view.bin",
+            CPLGenerateTempFilename("test_read_view") };
+        for( const CPLString& osFilename : aosFilenames )
+        {
+            const char* pszFilename = osFilename.c_str();
+            VSILFILE* fp = VSIFOpenL(pszFilename, "wb+");
+            if( fp == nullptr )
+                continue;
+            ensure_equals( VSIFWriteL(&abyData[0], 1, abyData.size(), fp),
+                           abyData.size() );
+            ensure_equals( VSIFSeekL(fp, 123, SEEK_SET), 0 );
+
+            // Small and large (memory mapped for local files) ranges,
+            // at unaligned offsets.
+            const vsi_l_offset anOffsets[] = { 1, 4097, 0, 100000 };
+            const size_t anSizes[] = { 1000, 100000, abyData.size(),
+                                       abyData.size() - 100000 };
+            for( size_t i = 0; i < CPL_ARRAYSIZE(anOffsets); i++ )
+            {
+                void* pViewHandle = nullptr;
+                const GByte* pabyView = static_cast<const GByte*>(
+                    VSIFAcquireReadViewL(fp, anOffsets[i], anSizes[i],
+                                         &pViewHandle));
+                ensure( pabyView != nullptr );
+                ensure( memcmp(pabyView,
+                               &abyData[static_cast<size_t>(anOffsets[i])],
+                               anSizes[i]) == 0 );
+                VSIFReleaseReadViewL(fp, pViewHandle);
+            }
+            ensure_equals( VSIFTellL(fp), static_cast<vsi_l_offset>(123) );
+
+            // Beyond end of file
+            void* pViewHandle = nullptr;
+            ensure( VSIFAcquireReadViewL(fp, abyData.size() - 10, 11,
+                                         &pViewHandle) == nullptr );
+            ensure( pViewHandle == nullptr );
+
+            VSIFCloseL(fp);
+            VSIUnlink(pszFilename);
+        }
+    }
+
+    // Test VSIFReadMultiRangeL() and large reads on local files, with
+    // concurrent positional reads
+    template<>
+    template<>
+    void object::test<38>()
+    {
+        std::vector<GByte> abyData(5 * 1024 * 1024 + 17);
+        for( size_t i = 0; i < abyData.size(); i++ )
+            abyData[i] = static_cast<GByte>(i * 7 + i / 251);
+
+        const CPLString osFilename(CPLGenerateTempFilename("test_multirange"));
+        for( const char* pszThreads : { "1", "4" } )
+        {
+            CPLSetConfigOption("CPL_VSIL_LOCAL_READ_NUM_THREADS", pszThreads);
+            VSILFILE* fp = VSIFOpenL(osFilename, "wb+");
+            ensure( fp != nullptr );
+            ensure_equals( VSIFWriteL(&abyData[0], 1, abyData.size(), fp),
+                           abyData.size() );
+
+            const vsi_l_offset anOffsets[] = { 3, 100000, 3000000 };
+            const size_t anSizes[] = { 50000, 2000000, 2000000 };
+            std::vector<GByte> abyBuffer(anSizes[0] + anSizes[1] + anSizes[2]);
+            void* apData[] = { &abyBuffer[0],
+                               &abyBuffer[anSizes[0]],
+                               &abyBuffer[anSizes[0] + anSizes[1]] };
+            ensure_equals( VSIFReadMultiRangeL(3, apData, anOffsets, anSizes,
+                                               fp), 0 );
+            for( int i = 0; i < 3; i++ )
+            {
+                ensure( memcmp(apData[i],
+                               &abyData[static_cast<size_t>(anOffsets[i])],
+                               anSizes[i]) == 0 );
+            }
+
+            // Range extending beyond end of file
+            const vsi_l_offset nOffsetEOF = abyData.size() - 10;
+            ensure( VSIFReadMultiRangeL(1, apData, &nOffsetEOF, &anSizes[1],
+                                        fp) != 0 );
+
+            // Large read ending with a partial element
+            ensure_equals( VSIFSeekL(fp, 11, SEEK_SET), 0 );
+            std::vector<GByte> abyRead(abyData.size());
+            const size_t nRead = VSIFReadL(&abyRead[0], 4,
+                                           abyData.size() / 4, fp);
+            ensure_equals( nRead, (abyData.size() - 11) / 4 );
+            ensure( memcmp(&abyRead[0], &abyData[11], nRead * 4) == 0 );
+            ensure( VSIFEofL(fp) != 0 );
+            ensure_equals( VSIFTellL(fp),
+                           static_cast<vsi_l_offset>(abyData.size()) );
+
+            GByte byVal = 0;
+            ensure_equals( VSIFSeekL(fp, 12345, SEEK_SET), 0 );
+            ensure_equals( VSIFReadL(&byVal, 1, 1, fp), 1U );
+            ensure_equals( byVal, abyData[12345] );
+
+            VSIFCloseL(fp);
+        }
+        CPLSetConfigOption("CPL_VSIL_LOCAL_READ_NUM_THREADS", nullptr);
+        VSIUnlink(osFilename);
+    }
+
 } // namespace tut
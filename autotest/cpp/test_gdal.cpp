@@ -25,7 +25,10 @@
 
 #include "gdal_unit_test.h"
 
+#include "cpl_multiproc.h"
+#include "gdal_alg.h"
 #include "gdal_priv.h"
+#include "gdal_proxy.h"
 #include "gdal_utils.h"
 #include "gdal_priv_templates.hpp"
 #include "gdal.h"
@@ -622,4 +625,85 @@ namespace tut
 
     }
 
+    struct ProxyPoolThreadData
+    {
+        GDALRasterBandH hBand;
+        int nExpectedChecksum;
+        bool bOK;
+    };
+
+    static void ProxyPoolChecksumFunc( void* pData )
+    {
+        ProxyPoolThreadData* psData = static_cast<ProxyPoolThreadData*>(pData);
+        for( int i = 0; i < 20; i++ )
+        {
+            if( GDALChecksumImage(psData->hBand, 0, 0, 20, 20) !=
+                                                psData->nExpectedChecksum )
+                psData->bOK = false;
+        }
+    }
+
+    // Test GDALProxyPoolDataset statistics and use from several threads
+    template<> template<> void object::test<18>()
+    {
+        const char* pszFilename = "/vsimem/test_gdal_proxy_pool.tif";
+        GDALDatasetUniquePtr poSrcDS(
+            GDALDriver::FromHandle(
+                GDALGetDriverByName("GTiff"))->Create(pszFilename, 20, 20, 1,
+                                                       GDT_Byte, nullptr));
+        ensure( poSrcDS != nullptr );
+        poSrcDS->GetRasterBand(1)->Fill(7);
+        const int nExpectedChecksum = GDALChecksumImage(
+            GDALRasterBand::ToHandle(poSrcDS->GetRasterBand(1)), 0, 0, 20, 20);
+        poSrcDS.reset();
+
+        GIntBig nHitsBefore = 0;
+        GIntBig nMissesBefore = 0;
+        int nOpenDatasetsBefore = 0;
+        GDALProxyPoolGetStatistics(&nHitsBefore, &nMissesBefore,
+                                   nullptr, &nOpenDatasetsBefore);
+
+        GDALProxyPoolDataset* poProxyDS =
+            new GDALProxyPoolDataset(pszFilename, 20, 20);
+        poProxyDS->AddSrcBandDescription(GDT_Byte, 20, 1);
+        GDALRasterBandH hBand =
+            GDALRasterBand::ToHandle(poProxyDS->GetRasterBand(1));
+        ensure_equals( GDALChecksumImage(hBand, 0, 0, 20, 20),
+                       nExpectedChecksum );
+        ensure_equals( GDALChecksumImage(hBand, 0, 0, 20, 20),
+                       nExpectedChecksum );
+
+        GIntBig nHits = 0;
+        GIntBig nMisses = 0;
+        int nOpenDatasets = 0;
+        GDALProxyPoolGetStatistics(&nHits, &nMisses, nullptr, &nOpenDatasets);
+        ensure( nMisses > nMissesBefore );
+        ensure( nHits > nHitsBefore );
+        ensure( nOpenDatasets >= 1 );
+
+        // Each thread gets its own handle on the file when the other one
+        // is busy
+        ProxyPoolThreadData sData1 = { hBand, nExpectedChecksum, true };
+        ProxyPoolThreadData sData2 = { hBand, nExpectedChecksum, true };
+        CPLJoinableThread* hThread1 =
+            CPLCreateJoinableThread(ProxyPoolChecksumFunc, &sData1);
+        CPLJoinableThread* hThread2 =
+            CPLCreateJoinableThread(ProxyPoolChecksumFunc, &sData2);
+        CPLJoinThread(hThread1);
+        CPLJoinThread(hThread2);
+        ensure( sData1.bOK );
+        ensure( sData2.bOK );
+
+        // All the handles opened on the file are closed with the proxy.
+        // Another proxy keeps the pool alive meanwhile.
+        GDALProxyPoolDataset* poOtherProxyDS =
+            new GDALProxyPoolDataset("/vsimem/test_gdal_proxy_pool_other.tif",
+                                     20, 20);
+        delete poProxyDS;
+        GDALProxyPoolGetStatistics(nullptr, nullptr, nullptr, &nOpenDatasets);
+        ensure_equals( nOpenDatasets, nOpenDatasetsBefore );
+        delete poOtherProxyDS;
+        VSIUnlink(pszFilename);
+    }
+
 } // namespace tut
@@ -29,6 +29,7 @@
 #include "../../gdal/ogr/ogrsf_frmts/osm/gpb.h"
 
 #include <string>
+#include <vector>
 
 namespace tut
 {
@@ -1355,4 +1356,637 @@ namespace tut
         poFeatureDefn->Release();
     }
 
+    // Check the column buffers of a row of a feature batch against the
+    // feature returned by GetNextFeature()
+    static void CheckFeatureBatchRow(const OGRFeatureBatch& oBatch, int iRow,
+                                     const OGRFeature* poExpected)
+    {
+        OGRFeatureDefn* poDefn = oBatch.GetDefn();
+        for( int iField = 0; iField < poDefn->GetFieldCount(); iField++ )
+        {
+            // The batch does not distinguish unset and null fields
+            const bool bSet = CPL_TO_BOOL(
+                poExpected->IsFieldSetAndNotNull(iField));
+            const GByte* pabyValidity = oBatch.GetFieldValidity(iField);
+            ensure( pabyValidity != nullptr );
+            ensure_equals( ((pabyValidity[iRow / 8] >> (iRow % 8)) & 1) != 0,
+                           bSet );
+            ensure_equals( oBatch.IsFieldSetAndNotNull(iRow, iField), bSet );
+
+            const void* pValues = oBatch.GetFieldValues(iField);
+            const size_t* panOffsets = oBatch.GetFieldOffsets(iField);
+            const OGRFieldType eType = poDefn->GetFieldDefn(iField)->GetType();
+            switch( eType )
+            {
+                case OFTInteger:
+                    ensure( pValues != nullptr );
+                    ensure( panOffsets == nullptr );
+                    if( bSet )
+                    {
+                        ensure_equals(
+                            static_cast<const int*>(pValues)[iRow],
+                            poExpected->GetFieldAsInteger(iField) );
+                    }
+                    break;
+
+                case OFTInteger64:
+                    ensure( pValues != nullptr );
+                    ensure( panOffsets == nullptr );
+                    if( bSet )
+                    {
+                        ensure_equals(
+                            static_cast<const GIntBig*>(pValues)[iRow],
+                            poExpected->GetFieldAsInteger64(iField) );
+                    }
+                    break;
+
+                case OFTReal:
+                    ensure( pValues != nullptr );
+                    ensure( panOffsets == nullptr );
+                    if( bSet )
+                    {
+                        ensure_equals(
+                            static_cast<const double*>(pValues)[iRow],
+                            poExpected->GetFieldAsDouble(iField) );
+                    }
+                    break;
+
+                case OFTDate:
+                case OFTTime:
+                case OFTDateTime:
+                    ensure( pValues != nullptr );
+                    ensure( panOffsets == nullptr );
+                    if( bSet )
+                    {
+                        const OGRField* psField =
+                            static_cast<const OGRField*>(pValues) + iRow;
+                        const OGRField* psExpected =
+                            poExpected->GetRawFieldRef(iField);
+                        ensure_equals( psField->Date.Year,
+                                       psExpected->Date.Year );
+                        ensure_equals( psField->Date.Month,
+                                       psExpected->Date.Month );
+                        ensure_equals( psField->Date.Day,
+                                       psExpected->Date.Day );
+                        ensure_equals( psField->Date.Hour,
+                                       psExpected->Date.Hour );
+                        ensure_equals( psField->Date.Minute,
+                                       psExpected->Date.Minute );
+                        ensure_equals( psField->Date.Second,
+                                       psExpected->Date.Second );
+                        ensure_equals( psField->Date.TZFlag,
+                                       psExpected->Date.TZFlag );
+                    }
+                    break;
+
+                case OFTString:
+                {
+                    ensure( pValues == nullptr );
+                    ensure( panOffsets != nullptr );
+                    const GByte* pabyData = oBatch.GetFieldData(iField);
+                    if( bSet )
+                    {
+                        ensure( panOffsets[iRow] <= panOffsets[iRow + 1] );
+                        ensure_equals(
+                            std::string(reinterpret_cast<const char*>(
+                                            pabyData + panOffsets[iRow]),
+                                        panOffsets[iRow + 1] -
+                                            panOffsets[iRow]),
+                            std::string(poExpected->GetFieldAsString(iField)) );
+                    }
+                    else
+                    {
+                        ensure_equals( panOffsets[iRow + 1], panOffsets[iRow] );
+                    }
+                    break;
+                }
+
+                default:
+                    break;
+            }
+        }
+
+        for( int iGeomField = 0; iGeomField < poDefn->GetGeomFieldCount();
+             iGeomField++ )
+        {
+            const OGRGeometry* poExpectedGeom =
+                poExpected->GetGeomFieldRef(iGeomField);
+            const GByte* pabyValidity = oBatch.GetGeomFieldValidity(iGeomField);
+            const size_t* panOffsets = oBatch.GetGeomFieldOffsets(iGeomField);
+            const GByte* pabyData = oBatch.GetGeomFieldData(iGeomField);
+            ensure( pabyValidity != nullptr );
+            ensure( panOffsets != nullptr );
+            ensure_equals( ((pabyValidity[iRow / 8] >> (iRow % 8)) & 1) != 0,
+                           poExpectedGeom != nullptr );
+            const size_t nLen = panOffsets[iRow + 1] - panOffsets[iRow];
+            if( poExpectedGeom == nullptr )
+            {
+                ensure_equals( nLen, static_cast<size_t>(0) );
+                continue;
+            }
+            ensure_equals( nLen,
+                           static_cast<size_t>(poExpectedGeom->WkbSize()) );
+            // ISO WKB, little endian
+            ensure_equals( static_cast<int>(pabyData[panOffsets[iRow]]), 1 );
+            OGRGeometry* poGeom = nullptr;
+            ensure_equals( OGRGeometryFactory::createFromWkb(
+                               pabyData + panOffsets[iRow], nullptr, &poGeom,
+                               static_cast<int>(nLen), wkbVariantIso),
+                           OGRERR_NONE );
+            ensure( poGeom->Equals(poExpectedGeom) );
+            delete poGeom;
+        }
+    }
+
+    // Check that GetNextFeatureBatch() returns the same content as
+    // GetNextFeature(), whatever the batch size. A short batch marks the
+    // end of the layer.
+    static void CheckFeatureBatch(OGRLayer* poLayer, int nMaxRows)
+    {
+        std::vector<OGRFeatureUniquePtr> apoFeatures;
+        poLayer->ResetReading();
+        for( auto& poFeature: poLayer )
+            apoFeatures.push_back(std::move(poFeature));
+
+        OGRFeatureBatch oBatch(poLayer->GetLayerDefn());
+        size_t iFeature = 0;
+        poLayer->ResetReading();
+        int nRows = nMaxRows;
+        while( nRows == nMaxRows )
+        {
+            nRows = poLayer->GetNextFeatureBatch(&oBatch, nMaxRows);
+            ensure( nRows <= nMaxRows );
+            ensure_equals( oBatch.GetRowCount(), nRows );
+            for( int iRow = 0; iRow < nRows; iRow++, iFeature++ )
+            {
+                ensure( iFeature < apoFeatures.size() );
+                const OGRFeature* poExpected = apoFeatures[iFeature].get();
+                ensure_equals( oBatch.GetFIDs()[iRow], poExpected->GetFID() );
+                CheckFeatureBatchRow(oBatch, iRow, poExpected);
+
+                // And the feature rebuilt from the batch
+                OGRFeatureUniquePtr poFeature(oBatch.GetFeature(iRow));
+                ensure_equals( poFeature->GetFID(), poExpected->GetFID() );
+                for( int iField = 0;
+                     iField < poLayer->GetLayerDefn()->GetFieldCount();
+                     iField++ )
+                {
+                    if( poExpected->IsFieldSetAndNotNull(iField) )
+                    {
+                        ensure_equals(
+                            CPLString(poFeature->GetFieldAsString(iField)),
+                            CPLString(poExpected->GetFieldAsString(iField)) );
+                    }
+                }
+                const OGRGeometry* poGeom = poFeature->GetGeometryRef();
+                const OGRGeometry* poExpectedGeom =
+                    poExpected->GetGeometryRef();
+                ensure_equals( poGeom == nullptr, poExpectedGeom == nullptr );
+                if( poGeom != nullptr )
+                    ensure( poGeom->Equals(poExpectedGeom) );
+            }
+        }
+        ensure_equals( iFeature, apoFeatures.size() );
+    }
+
+    // Test OGRLayer::GetNextFeatureBatch() on the drivers that implement it
+    template<>
+    template<>
+    void object::test<15>()
+    {
+        const char* const apszDrivers[] = {
+            "ESRI Shapefile", "GPKG", "CSV", "Memory" };
+        for( const char* pszDriver: apszDrivers )
+        {
+            GDALDriver* poDriver =
+                GetGDALDriverManager()->GetDriverByName(pszDriver);
+            if( poDriver == nullptr )
+                continue;
+            CPLString osFilename("/vsimem/test_ogr_batch");
+            if( EQUAL(pszDriver, "GPKG") )
+                osFilename += ".gpkg";
+            GDALDataset* poDS = poDriver->Create(osFilename, 0, 0, 0,
+                                                 GDT_Unknown, nullptr);
+            ensure( poDS != nullptr );
+            const bool bCSV = EQUAL(pszDriver, "CSV");
+            const bool bShape = EQUAL(pszDriver, "ESRI Shapefile");
+            OGRLayer* poLayer = poDS->CreateLayer("test", nullptr,
+                                                  bCSV ? wkbNone : wkbUnknown);
+            ensure( poLayer != nullptr );
+            OGRFieldDefn oFieldStr("str", OFTString);
+            poLayer->CreateField(&oFieldStr);
+            OGRFieldDefn oFieldInt("int", OFTInteger);
+            poLayer->CreateField(&oFieldInt);
+            OGRFieldDefn oFieldInt64("int64", OFTInteger64);
+            poLayer->CreateField(&oFieldInt64);
+            OGRFieldDefn oFieldReal("real", OFTReal);
+            poLayer->CreateField(&oFieldReal);
+            if( !bCSV )
+            {
+                OGRFieldDefn oFieldDate("date", OFTDate);
+                poLayer->CreateField(&oFieldDate);
+            }
+            const char* const apszWKT[] = {
+                "POINT (1 2)", "LINESTRING (0 0,1 1)",
+                "POLYGON ((0 0,0 1,1 1,0 0))", "MULTIPOINT (1 2,3 4)" };
+            for( int i = 0; i < 25; i++ )
+            {
+                OGRFeature oFeature(poLayer->GetLayerDefn());
+                if( (i % 3) != 0 )
+                    oFeature.SetField(0, CPLSPrintf("value %d", i));
+                if( (i % 4) != 0 )
+                    oFeature.SetField(1, i * 10);
+                oFeature.SetField(2, static_cast<GIntBig>(i) << 33);
+                if( (i % 5) != 0 )
+                    oFeature.SetField(3, i + 0.5);
+                if( !bCSV && (i % 2) == 0 )
+                    oFeature.SetField(4, 2018, 1 + i % 12, 1 + i);
+                if( !bCSV && (i % 7) != 0 )
+                {
+                    OGRGeometry* poGeom = nullptr;
+                    // Shapefile layers are single geometry type
+                    OGRGeometryFactory::createFromWkt(
+                        apszWKT[bShape ? 1 : i % 4], nullptr, &poGeom);
+                    oFeature.SetGeometryDirectly(poGeom);
+                }
+                ensure_equals( poLayer->CreateFeature(&oFeature),
+                               OGRERR_NONE );
+            }
+            if( bShape )
+            {
+                GDALClose(poDS);
+                poDS = reinterpret_cast<GDALDataset*>(
+                    GDALOpenEx(osFilename, GDAL_OF_VECTOR, nullptr,
+                               nullptr, nullptr));
+                ensure( poDS != nullptr );
+                poLayer = poDS->GetLayer(0);
+            }
+            else
+            {
+                poDS->FlushCache();
+            }
+            CheckFeatureBatch(poLayer, 1);
+            CheckFeatureBatch(poLayer, 7);
+            CheckFeatureBatch(poLayer, 100);
+
+            poLayer->SetAttributeFilter("int > 50");
+            CheckFeatureBatch(poLayer, 7);
+            poLayer->SetAttributeFilter(nullptr);
+
+            GDALClose(poDS);
+            if( !EQUAL(pszDriver, "Memory") )
+                poDriver->Delete(osFilename);
+        }
+
+        std::string file(data_ + SEP + "poly.shp");
+        GDALDatasetUniquePtr poDS(
+            GDALDataset::Open(file.c_str(), GDAL_OF_VECTOR));
+        ensure( poDS != nullptr );
+        OGRLayer* poLayer = poDS->GetLayer(0);
+        CheckFeatureBatch(poLayer, 3);
+        poLayer->SetSpatialFilterRect(479750, 4764500, 480000, 4765000);
+        CheckFeatureBatch(poLayer, 3);
+    }
+
+    // Check that FillNextFeature() returns the same features as
+    // GetNextFeature(), when the same feature object is refilled.
+    static void CheckFillNextFeature(OGRLayer* poLayer)
+    {
+        std::vector<OGRFeatureUniquePtr> apoFeatures;
+        poLayer->ResetReading();
+        for( auto& poFeature: poLayer )
+            apoFeatures.push_back(std::move(poFeature));
+
+        OGRFeature oFeature(poLayer->GetLayerDefn());
+        size_t iFeature = 0;
+        poLayer->ResetReading();
+        while( poLayer->FillNextFeature(&oFeature) )
+        {
+            ensure( iFeature < apoFeatures.size() );
+            ensure( CPL_TO_BOOL(
+                oFeature.Equal(apoFeatures[iFeature].get())) );
+            iFeature++;
+        }
+        ensure_equals( iFeature, apoFeatures.size() );
+    }
+
+    // Test OGRLayer::FillNextFeature()
+    template<>
+    template<>
+    void object::test<16>()
+    {
+        const char* const apszDrivers[] = {
+            "ESRI Shapefile", "GPKG", "Memory" };
+        for( const char* pszDriver: apszDrivers )
+        {
+            GDALDriver* poDriver =
+                GetGDALDriverManager()->GetDriverByName(pszDriver);
+            if( poDriver == nullptr )
+                continue;
+            CPLString osFilename("/vsimem/test_ogr_fill");
+            if( EQUAL(pszDriver, "GPKG") )
+                osFilename += ".gpkg";
+            GDALDataset* poDS = poDriver->Create(osFilename, 0, 0, 0,
+                                                 GDT_Unknown, nullptr);
+            ensure( poDS != nullptr );
+            const bool bShape = EQUAL(pszDriver, "ESRI Shapefile");
+            OGRLayer* poLayer = poDS->CreateLayer("test", nullptr,
+                                                  wkbUnknown);
+            ensure( poLayer != nullptr );
+            OGRFieldDefn oFieldStr("str", OFTString);
+            poLayer->CreateField(&oFieldStr);
+            OGRFieldDefn oFieldInt("int", OFTInteger);
+            poLayer->CreateField(&oFieldInt);
+            OGRFieldDefn oFieldDate("date", OFTDate);
+            poLayer->CreateField(&oFieldDate);
+            // Geometries of varying size and type, so that the reused
+            // ones have to grow, shrink or be replaced.
+            const char* const apszWKT[] = {
+                "LINESTRING (0 0,1 1,2 2,3 3)", "LINESTRING (0 0,1 1)",
+                "MULTILINESTRING ((0 0,1 1),(2 2,3 3))",
+                "LINESTRING (5 5,6 6,7 7,8 8,9 9,10 10)",
+                "POINT (1 2)", "POLYGON ((0 0,0 1,1 1,0 0))" };
+            for( int i = 0; i < 25; i++ )
+            {
+                OGRFeature oFeature(poLayer->GetLayerDefn());
+                if( (i % 3) != 0 )
+                {
+                    oFeature.SetField(0,
+                        CPLString().Printf("%.*s", 1 + (i * 7) % 13,
+                                           "abcdefghijklmnopqrstuvwxyz"));
+                }
+                if( (i % 4) != 0 )
+                    oFeature.SetField(1, i * 10);
+                if( (i % 2) == 0 )
+                    oFeature.SetField(2, 2018, 1 + i % 12, 1 + i);
+                if( (i % 7) != 0 )
+                {
+                    OGRGeometry* poGeom = nullptr;
+                    // Shapefile layers are single geometry type
+                    OGRGeometryFactory::createFromWkt(
+                        apszWKT[i % (bShape ? 4 : 6)], nullptr, &poGeom);
+                    oFeature.SetGeometryDirectly(poGeom);
+                }
+                ensure_equals( poLayer->CreateFeature(&oFeature),
+                               OGRERR_NONE );
+            }
+            if( bShape )
+            {
+                GDALClose(poDS);
+                poDS = reinterpret_cast<GDALDataset*>(
+                    GDALOpenEx(osFilename, GDAL_OF_VECTOR, nullptr,
+                               nullptr, nullptr));
+                ensure( poDS != nullptr );
+                poLayer = poDS->GetLayer(0);
+            }
+            CheckFillNextFeature(poLayer);
+
+            poLayer->SetAttributeFilter("int > 50");
+            CheckFillNextFeature(poLayer);
+            poLayer->SetAttributeFilter(nullptr);
+
+            // A feature of another definition is rejected
+            OGRFeatureDefn* poOtherDefn = new OGRFeatureDefn();
+            poOtherDefn->Reference();
+            {
+                OGRFeature oOtherFeature(poOtherDefn);
+                CPLPushErrorHandler(CPLQuietErrorHandler);
+                ensure( !poLayer->FillNextFeature(&oOtherFeature) );
+                CPLPopErrorHandler();
+            }
+            poOtherDefn->Release();
+
+            GDALClose(poDS);
+            if( !EQUAL(pszDriver, "Memory") )
+                poDriver->Delete(osFilename);
+        }
+
+        std::string file(data_ + SEP + "poly.shp");
+        GDALDatasetUniquePtr poDS(
+            GDALDataset::Open(file.c_str(), GDAL_OF_VECTOR));
+        ensure( poDS != nullptr );
+        OGRLayer* poLayer = poDS->GetLayer(0);
+        CheckFillNextFeature(poLayer);
+        poLayer->SetSpatialFilterRect(479750, 4764500, 480000, 4765000);
+        CheckFillNextFeature(poLayer);
+    }
+
+    // Test that the compiled evaluation of attribute filters gives the same
+    // results as the SQL interpreter, on features and feature batches.
+    template<>
+    template<>
+    void object::test<17>()
+    {
+        OGRFeatureDefn* poDefn = new OGRFeatureDefn();
+        poDefn->Reference();
+        OGRFieldDefn oFieldStr("str", OFTString);
+        poDefn->AddFieldDefn(&oFieldStr);
+        OGRFieldDefn oFieldInt("int", OFTInteger);
+        poDefn->AddFieldDefn(&oFieldInt);
+        OGRFieldDefn oFieldInt64("int64", OFTInteger64);
+        poDefn->AddFieldDefn(&oFieldInt64);
+        OGRFieldDefn oFieldReal("real", OFTReal);
+        poDefn->AddFieldDefn(&oFieldReal);
+        OGRFieldDefn oFieldBool("flag", OFTInteger);
+        oFieldBool.SetSubType(OFSTBoolean);
+        poDefn->AddFieldDefn(&oFieldBool);
+        OGRFieldDefn oFieldDate("date", OFTDate);
+        poDefn->AddFieldDefn(&oFieldDate);
+
+        std::vector<OGRFeatureUniquePtr> apoFeatures;
+        OGRFeatureBatch oBatch(poDefn);
+        for( int i = 0; i < 40; i++ )
+        {
+            OGRFeatureUniquePtr poFeature(new OGRFeature(poDefn));
+            poFeature->SetFID(i == 39 ? OGRNullFID : i);
+            if( (i % 3) != 0 )
+                poFeature->SetField(0, CPLSPrintf("Value %d", i));
+            if( (i % 4) != 0 )
+                poFeature->SetField(1, i * 10 - 100);
+            else if( (i % 8) == 0 )
+                poFeature->SetFieldNull(1);
+            poFeature->SetField(2, (static_cast<GIntBig>(i) << 40) - 7);
+            if( (i % 5) != 0 )
+                poFeature->SetField(3, i + 0.5);
+            poFeature->SetField(4, i % 2);
+            if( (i % 2) == 0 )
+                poFeature->SetField(5, 2018, 1 + i % 12, 1 + i % 28);
+            oBatch.AddFeature(poFeature.get());
+            apoFeatures.push_back(std::move(poFeature));
+        }
+
+        const char* const apszExpr[] = {
+            "int > 50", "int = 30 OR int = 70", "int IN (10, 20, 30)",
+            "int NOT IN (10, 20)", "int IN (10, int64, 30)",
+            "int BETWEEN 20 AND 100", "int IS NULL", "int IS NOT NULL",
+            "int + 5 > 40", "int * 2 = 60", "int / 0 = 2147483647",
+            "int % 7 = 1", "int - int64 > 0", "-int < 0",
+            "int64 > 8589934592", "int64 + 1 > 0",
+            "int64 * 1000000 > 0", "int64 * 1000000 IS NULL",
+            "real > 10.5", "real + int > 40", "int > 10.5", "real * 2 < 20",
+            "real IN (1.5, 2.5, 12.5)", "real BETWEEN 2 AND 12",
+            "real / 0 > 0", "real % 3 = 0.5", "real = int",
+            "str = 'value 4'", "str = 'Value 4'", "str <> 'value 4'",
+            "str > 'value 5'", "str <= 'Value 2'", "str LIKE 'value 1%'",
+            "str LIKE 'V_lue 2_'", "str LIKE 'Value 1!%' ESCAPE '!'",
+            "str IN ('value 1', 'Value 2', NULL)",
+            "str BETWEEN 'value 1' AND 'value 3'", "str IS NULL",
+            "NOT (str IS NULL)", "str + 'x' = 'value 1x'",
+            "flag = 1", "flag <> 0 AND int > 0", "NOT flag = 1",
+            "date IS NULL", "date > '2018/03/01'", "date IS NOT NULL",
+            "FID < 5", "FID IN (1, 3)", "FID IS NULL",
+            "int > 50 AND str IS NOT NULL", "int IS NULL OR real > 10",
+            "int = 20 OR real IS NULL", "int > 0 OR int64 * 1000000 > 0",
+            "(int > 10 AND int < 100) OR (str LIKE '%3')",
+            "NOT (int > 10 AND real < 30)", "int < int64",
+            "1", "0", "int", "int64", "str", "real", "1 = 1",
+            "int > 0 AND int < 1000 AND int <> 50 AND int <> 70 AND "
+            "int <> 90 AND int <> 110 AND int <> 130 AND int <> 150 AND "
+            "int <> 170 AND int <> 190 AND int <> 210 AND int <> 230 AND "
+            "int <> 250 AND int <> 270 AND int <> 290 AND int <> 310 AND "
+            "int <> 330 AND int <> 350 AND int <> 370 AND int <> 390 AND "
+            "int <> 410 AND int <> 430 AND int <> 450 AND int <> 470 AND "
+            "int <> 490 AND int <> 510 AND int <> 530 AND int <> 550 AND "
+            "int <> 570 AND int <> 590 AND int <> 610 AND int <> 630",
+        };
+        CPLPushErrorHandler(CPLQuietErrorHandler);
+        for( const char* pszExpr: apszExpr )
+        {
+            OGRFeatureQuery oInterpreted;
+            OGRErr eErr;
+            {
+                CPLConfigOptionSetter oSetter("OGR_SQL_COMPILE_EXPRESSIONS",
+                                              "NO", false);
+                eErr = oInterpreted.Compile(poDefn, pszExpr);
+            }
+            OGRFeatureQuery oCompiled;
+            ensure_equals( pszExpr, oCompiled.Compile(poDefn, pszExpr), eErr );
+            if( eErr != OGRERR_NONE )
+                continue;
+
+            std::vector<GByte> abyMatches(apoFeatures.size());
+            int nMatches = 0;
+            for( size_t i = 0; i < apoFeatures.size(); i++ )
+            {
+                const int bExpected =
+                    oInterpreted.Evaluate(apoFeatures[i].get());
+                ensure_equals( CPLSPrintf("%s, feature %d", pszExpr,
+                                          static_cast<int>(i)),
+                               oCompiled.Evaluate(apoFeatures[i].get()),
+                               bExpected );
+                abyMatches[i] = static_cast<GByte>(bExpected);
+                nMatches += bExpected;
+            }
+
+            std::vector<GByte> abyBatchMatches(apoFeatures.size());
+            ensure_equals( pszExpr,
+                           oCompiled.EvaluateBatch(&oBatch,
+                                                   &abyBatchMatches[0]),
+                           nMatches );
+            ensure( pszExpr, abyBatchMatches == abyMatches );
+            ensure_equals( pszExpr,
+                           oInterpreted.EvaluateBatch(&oBatch,
+                                                      &abyBatchMatches[0]),
+                           nMatches );
+            ensure( pszExpr, abyBatchMatches == abyMatches );
+        }
+        CPLPopErrorHandler();
+        poDefn->Release();
+    }
+
+    // Test that a line string read from WKT or WKB can be promoted to Z and
+    // M and have its points updated without writing past its coordinate
+    // arrays.
+    template<>
+    template<>
+    void object::test<18>()
+    {
+        OGRLineString oLS;
+        const char* pszWKT = "LINESTRING (0 0,1 1,2 2)";
+        ensure_equals( oLS.importFromWkt(&pszWKT), OGRERR_NONE );
+        oLS.set3D(TRUE);
+        oLS.setMeasured(TRUE);
+        for( int i = 0; i < 3; i++ )
+            oLS.setPoint(i, i, i, i * 10, i * 100);
+        // Grow up to the capacity reserved while reading the WKT.
+        for( int i = 3; i < 12; i++ )
+            oLS.addPoint(i, i, i * 10, i * 100);
+        ensure_equals( oLS.getNumPoints(), 12 );
+        for( int i = 0; i < 12; i++ )
+        {
+            ensure_equals( oLS.getZ(i), i * 10.0 );
+            ensure_equals( oLS.getM(i), i * 100.0 );
+        }
+
+        // Same with a geometry reused for a larger 2D line.
+        std::string osWKT("LINESTRING (");
+        for( int i = 0; i < 50; i++ )
+        {
+            if( i > 0 )
+                osWKT += ",";
+            osWKT += CPLSPrintf("%d %d", i, i);
+        }
+        osWKT += ")";
+        pszWKT = osWKT.c_str();
+        ensure_equals( oLS.importFromWkt(&pszWKT), OGRERR_NONE );
+        ensure_equals( oLS.getNumPoints(), 50 );
+        ensure( !oLS.Is3D() );
+        oLS.setMeasured(TRUE);
+        oLS.set3D(TRUE);
+        for( int i = 0; i < 50; i++ )
+            oLS.setPoint(i, i, i, -i, 2 * i);
+        for( int i = 0; i < 50; i++ )
+        {
+            ensure_equals( oLS.getZ(i), -i * 1.0 );
+            ensure_equals( oLS.getM(i), 2.0 * i );
+        }
+
+        // Segmentizing a measured line keeps its M array in sync.
+        OGRLineString oLSM;
+        pszWKT = "LINESTRING M (0 0 1,10 0 2)";
+        ensure_equals( oLSM.importFromWkt(&pszWKT), OGRERR_NONE );
+        oLSM.segmentize(1.0);
+        ensure_equals( oLSM.getNumPoints(), 11 );
+        oLSM.set3D(TRUE);
+        oLSM.setPoint(10, 10, 0, 5, 3);
+        ensure_equals( oLSM.getM(0), 1.0 );
+        ensure_equals( oLSM.getM(10), 3.0 );
+        ensure_equals( oLSM.getZ(10), 5.0 );
+
+        // Reading a smaller ZM line from WKB into a 2D line that has room
+        // for its points.
+        OGRLineString oLS2D;
+        for( int i = 0; i < 20; i++ )
+            oLS2D.addPoint(i, i);
+        std::vector<GByte> abyWKB(oLS2D.WkbSize());
+        oLS2D.exportToWkb(wkbNDR, &abyWKB[0], wkbVariantIso);
+        OGRLineString oLSZM;
+        for( int i = 0; i < 5; i++ )
+            oLSZM.addPoint(i, i, i * 10, i * 100);
+        std::vector<GByte> abyWKBZM(oLSZM.WkbSize());
+        oLSZM.exportToWkb(wkbNDR, &abyWKBZM[0], wkbVariantIso);
+        OGRLineString oLSReused;
+        int nBytesConsumed = 0;
+        ensure_equals( oLSReused.importFromWkb(&abyWKB[0],
+                                               static_cast<int>(abyWKB.size()),
+                                               wkbVariantIso,
+                                               nBytesConsumed),
+                       OGRERR_NONE );
+        ensure_equals( oLSReused.importFromWkb(&abyWKBZM[0],
+                                               static_cast<int>(abyWKBZM.size()),
+                                               wkbVariantIso,
+                                               nBytesConsumed),
+                       OGRERR_NONE );
+        ensure( CPL_TO_BOOL(oLSReused.Equals(&oLSZM)) );
+        ensure_equals( oLSReused.getM(4), 400.0 );
+        ensure_equals( oLSReused.importFromWkb(&abyWKB[0],
+                                               static_cast<int>(abyWKB.size()),
+                                               wkbVariantIso,
+                                               nBytesConsumed),
+                       OGRERR_NONE );
+        for( int i = 0; i < 20; i++ )
+            oLSReused.setPoint(i, i, i, i, i);
+        ensure_equals( oLSReused.getZ(19), 19.0 );
+    }
+
 } // namespace tut
@@ -0,0 +1,280 @@
+/******************************************************************************
+ * $Id$
+ *
+ * Project:  GDAL Core
+ * Purpose:  Test performance of the LERC codec, as used by the GTiff and MRF
+ *           drivers, on elevation models
+ *
+ ******************************************************************************
+ * Copyright (c) 2018, GDAL contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ ****************************************************************************/
+
+#include "cpl_conv.h"
+#include "cpl_string.h"
+#include "cpl_vsi.h"
+#include "gdal.h"
+#include "gdal_alg.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+static const float NODATA = -9999.0f;
+
+// Synthetic terrain: a few octaves of smooth relief plus a little noise,
+// with an optional hole of nodata in the middle.
+static void MakeDEM( int nXSize, int nYSize, bool bNoData,
+                     std::vector<float>& afDEM )
+{
+    afDEM.resize(static_cast<size_t>(nXSize) * nYSize);
+    unsigned int nSeed = 1;
+    for( int iY = 0; iY < nYSize; iY++ )
+    {
+        for( int iX = 0; iX < nXSize; iX++ )
+        {
+            double dfZ = 1000.0;
+            double dfAmplitude = 400.0;
+            double dfFreq = 2 * M_PI / nXSize;
+            for( int iOctave = 0; iOctave < 5; iOctave++ )
+            {
+                dfZ += dfAmplitude * sin(dfFreq * iX * (1 + 0.1 * iOctave)) *
+                                     cos(dfFreq * iY * (1.3 - 0.1 * iOctave));
+                dfAmplitude /= 2.5;
+                dfFreq *= 2.1;
+            }
+            nSeed = nSeed * 1103515245U + 12345U;
+            dfZ += ((nSeed >> 16) % 1000) / 1000.0;
+            const double dfDX = iX - nXSize / 2.0;
+            const double dfDY = iY - nYSize / 2.0;
+            if( bNoData &&
+                dfDX * dfDX + dfDY * dfDY < nXSize * nYSize / 16.0 )
+            {
+                dfZ = NODATA;
+            }
+            afDEM[static_cast<size_t>(iY) * nXSize + iX] =
+                static_cast<float>(dfZ);
+        }
+    }
+}
+
+// FNV-1a hash of a file, so that the output of two builds can be compared.
+static unsigned int HashFile( const char* pszFilename )
+{
+    unsigned int nHash = 2166136261U;
+    VSILFILE* fp = VSIFOpenL(pszFilename, "rb");
+    if( fp == nullptr )
+        return 0;
+    GByte abyBuffer[65536];
+    size_t nRead = 0;
+    while( (nRead = VSIFReadL(abyBuffer, 1, sizeof(abyBuffer), fp)) > 0 )
+    {
+        for( size_t i = 0; i < nRead; i++ )
+        {
+            nHash ^= abyBuffer[i];
+            nHash *= 16777619U;
+        }
+    }
+    VSIFCloseL(fp);
+    return nHash;
+}
+
+struct Case
+{
+    const char* pszName;
+    const char* pszDriver;
+    const char* pszFilename;
+    const char* pszDataFilename;
+    GDALDataType eDT;
+    bool bNoData;
+    const char* const* papszOptions;
+};
+
+static bool Run( const Case& oCase, const std::vector<float>& afDEM,
+                 int nXSize, int nYSize, int nIterations )
+{
+    const double dfMPixels =
+        static_cast<double>(nXSize) * nYSize / 1e6;
+
+    // Encode
+    const auto oStartEncode = std::chrono::steady_clock::now();
+    GDALDatasetH hDS = GDALCreate(GDALGetDriverByName(oCase.pszDriver),
+                                  oCase.pszFilename, nXSize, nYSize, 1,
+                                  oCase.eDT,
+                                  const_cast<char**>(oCase.papszOptions));
+    if( hDS == nullptr )
+    {
+        printf("%-36s: unavailable\n", oCase.pszName);
+        return true;
+    }
+    GDALRasterBandH hBand = GDALGetRasterBand(hDS, 1);
+    if( oCase.bNoData )
+        GDALSetRasterNoDataValue(hBand, NODATA);
+    CPLErr eErr = GDALRasterIO(hBand, GF_Write, 0, 0, nXSize, nYSize,
+                               const_cast<float*>(&afDEM[0]),
+                               nXSize, nYSize, GDT_Float32, 0, 0);
+    GDALClose(hDS);
+    const double dfEncode = std::chrono::duration<double>(
+        std::chrono::steady_clock::now() - oStartEncode).count();
+    if( eErr != CE_None )
+        return false;
+
+    // Decode: reopen each time so that no block comes from the cache
+    std::vector<float> afResult(afDEM.size());
+    int nChecksum = 0;
+    const auto oStartDecode = std::chrono::steady_clock::now();
+    for( int i = 0; i < nIterations && eErr == CE_None; i++ )
+    {
+        hDS = GDALOpen(oCase.pszFilename, GA_ReadOnly);
+        if( hDS == nullptr )
+            return false;
+        hBand = GDALGetRasterBand(hDS, 1);
+        eErr = GDALRasterIO(hBand, GF_Read, 0, 0, nXSize, nYSize,
+                            &afResult[0], nXSize, nYSize, GDT_Float32, 0, 0);
+        if( i == 0 )
+            nChecksum = GDALChecksumImage(hBand, 0, 0, nXSize, nYSize);
+        GDALClose(hDS);
+    }
+    const double dfDecode = std::chrono::duration<double>(
+        std::chrono::steady_clock::now() - oStartDecode).count();
+    if( eErr != CE_None )
+        return false;
+
+    vsi_l_offset nSize = 0;
+    VSIStatBufL sStat;
+    if( VSIStatL(oCase.pszDataFilename, &sStat) == 0 )
+        nSize = sStat.st_size;
+    printf("%-36s: encode %.1f Mpixels/s, decode %.1f Mpixels/s, "
+           "%d bytes, hash %08x, checksum %d\n",
+           oCase.pszName, dfMPixels / dfEncode,
+           dfMPixels * nIterations / dfDecode,
+           static_cast<int>(nSize), HashFile(oCase.pszDataFilename),
+           nChecksum);
+    return true;
+}
+
+int main( int argc, char* argv[] )
+{
+    int nSize = 2048;
+    int nIterations = 5;
+    const char* pszInput = nullptr;
+    for( int i = 1; i < argc; i++ )
+    {
+        if( EQUAL(argv[i], "-size") && i + 1 < argc )
+            nSize = std::max(1, atoi(argv[++i]));
+        else if( EQUAL(argv[i], "-iterations") && i + 1 < argc )
+            nIterations = std::max(1, atoi(argv[++i]));
+        else if( argv[i][0] != '-' && pszInput == nullptr )
+            pszInput = argv[i];
+        else
+        {
+            printf("Usage: testperflerc [-size N] [-iterations N] "
+                   "[dem_filename]\n");
+            return 1;
+        }
+    }
+
+    GDALAllRegister();
+
+    int nXSize = nSize;
+    int nYSize = nSize;
+    std::vector<float> afDEM;
+    std::vector<float> afDEMNoData;
+    if( pszInput )
+    {
+        // A real DEM: its own nodata value, if any, is mapped to ours
+        GDALDatasetH hSrcDS = GDALOpen(pszInput, GA_ReadOnly);
+        if( hSrcDS == nullptr )
+            return 1;
+        GDALRasterBandH hBand = GDALGetRasterBand(hSrcDS, 1);
+        nXSize = GDALGetRasterXSize(hSrcDS);
+        nYSize = GDALGetRasterYSize(hSrcDS);
+        afDEMNoData.resize(static_cast<size_t>(nXSize) * nYSize);
+        if( GDALRasterIO(hBand, GF_Read, 0, 0, nXSize, nYSize,
+                         &afDEMNoData[0], nXSize, nYSize, GDT_Float32,
+                         0, 0) != CE_None )
+            return 1;
+        int bHasNoData = FALSE;
+        const double dfNoData = GDALGetRasterNoDataValue(hBand, &bHasNoData);
+        afDEM = afDEMNoData;
+        float fFill = 0.0f;
+        for( size_t i = 0; i < afDEM.size(); i++ )
+        {
+            if( bHasNoData && afDEM[i] == static_cast<float>(dfNoData) )
+            {
+                afDEMNoData[i] = NODATA;
+                afDEM[i] = fFill;
+            }
+            else
+                fFill = afDEM[i];
+        }
+        GDALClose(hSrcDS);
+    }
+    else
+    {
+        MakeDEM(nXSize, nYSize, false, afDEM);
+        MakeDEM(nXSize, nYSize, true, afDEMNoData);
+    }
+    // Make sure the block cache does not hide the decoding
+    GDALSetCacheMax64(static_cast<GIntBig>(nXSize) * nYSize * 4 * 2);
+
+    const char* const apszGTiffFloat[] =
+        { "COMPRESS=LERC", "MAX_Z_ERROR=0.01", "TILED=YES", nullptr };
+    const char* const apszGTiffInt16[] =
+        { "COMPRESS=LERC", "TILED=YES", nullptr };
+    const char* const apszMRFLerc2[] =
+        { "COMPRESS=LERC", "OPTIONS=LERC_PREC=0.01", nullptr };
+    const char* const apszMRFLerc1[] =
+        { "COMPRESS=LERC", "OPTIONS=LERC_PREC=0.01 V1=ON", nullptr };
+    const Case aoCases[] = {
+        { "GTiff LERC Float32 MAX_Z_ERROR=0.01", "GTiff",
+          "/vsimem/testperflerc_f32.tif", "/vsimem/testperflerc_f32.tif",
+          GDT_Float32, false, apszGTiffFloat },
+        { "GTiff LERC Int16 lossless", "GTiff",
+          "/vsimem/testperflerc_i16.tif", "/vsimem/testperflerc_i16.tif",
+          GDT_Int16, false, apszGTiffInt16 },
+        { "MRF LERC2 Float32 with nodata", "MRF",
+          "/vsimem/testperflerc_l2.mrf", "/vsimem/testperflerc_l2.lrc",
+          GDT_Float32, true, apszMRFLerc2 },
+        { "MRF LERC1 Float32 with nodata", "MRF",
+          "/vsimem/testperflerc_l1.mrf", "/vsimem/testperflerc_l1.lrc",
+          GDT_Float32, true, apszMRFLerc1 },
+    };
+
+    int nRet = 0;
+    for( const auto& oCase : aoCases )
+    {
+        if( !Run(oCase, oCase.bNoData ? afDEMNoData : afDEM,
+                 nXSize, nYSize, nIterations) )
+        {
+            printf("%-36s: failed\n", oCase.pszName);
+            nRet = 1;
+        }
+        GDALDriverH hDriver = GDALGetDriverByName(oCase.pszDriver);
+        if( hDriver )
+            GDALDeleteDataset(hDriver, oCase.pszFilename);
+    }
+
+    GDALDestroyDriverManager();
+    return nRet;
+}
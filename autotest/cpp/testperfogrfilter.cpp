@@ -0,0 +1,188 @@
+/******************************************************************************
+ * $Id$
+ *
+ * Project:  GDAL Core
+ * Purpose:  Test performance and heap allocations of the evaluation of OGR
+ *           attribute filters, compiled or interpreted
+ *
+ ******************************************************************************
+ * Copyright (c) 2018, GDAL contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ ****************************************************************************/
+
+#include "cpl_conv.h"
+#include "cpl_string.h"
+#include "ogr_api.h"
+#include "ogr_feature.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+// Count the heap allocations by interposing the allocator of the C library.
+static GUIntBig nAllocCount = 0;
+
+#ifdef __GLIBC__
+extern "C"
+{
+void* __libc_malloc(size_t);
+void* __libc_calloc(size_t, size_t);
+void* __libc_realloc(void*, size_t);
+
+void* malloc(size_t nSize)
+{
+    nAllocCount++;
+    return __libc_malloc(nSize);
+}
+
+void* calloc(size_t nCount, size_t nSize)
+{
+    nAllocCount++;
+    return __libc_calloc(nCount, nSize);
+}
+
+void* realloc(void* pPtr, size_t nSize)
+{
+    nAllocCount++;
+    return __libc_realloc(pPtr, nSize);
+}
+}
+#define HAVE_ALLOC_COUNT
+#endif
+
+static void Report( const char* pszExpr, const char* pszMode,
+                    int nCount, double dfDuration, GUIntBig nAllocs,
+                    int nMatches )
+{
+    printf("%-40s %-12s: %.2f Mfeatures/s", pszExpr, pszMode,
+           nCount / dfDuration / 1e6);
+#ifdef HAVE_ALLOC_COUNT
+    printf(", %.2f allocations/feature",
+           static_cast<double>(nAllocs) / std::max(1, nCount));
+#else
+    CPL_IGNORE_RET_VAL(nAllocs);
+#endif
+    printf(", %d matches\n", nMatches);
+}
+
+static bool Run( OGRFeatureDefn* poDefn,
+                 const std::vector<OGRFeature*>& apoFeatures,
+                 const OGRFeatureBatch& oBatch,
+                 const char* pszExpr, bool bCompiled )
+{
+    CPLSetConfigOption("OGR_SQL_COMPILE_EXPRESSIONS",
+                       bCompiled ? "YES" : "NO");
+    OGRFeatureQuery oQuery;
+    const OGRErr eErr = oQuery.Compile(poDefn, pszExpr);
+    CPLSetConfigOption("OGR_SQL_COMPILE_EXPRESSIONS", nullptr);
+    if( eErr != OGRERR_NONE )
+        return false;
+
+    const int nCount = static_cast<int>(apoFeatures.size());
+    int nMatches = 0;
+    GUIntBig nAllocCountBefore = nAllocCount;
+    auto oStart = std::chrono::steady_clock::now();
+    for( OGRFeature* poFeature : apoFeatures )
+        nMatches += oQuery.Evaluate(poFeature);
+    double dfDuration = std::chrono::duration<double>(
+        std::chrono::steady_clock::now() - oStart).count();
+    Report(pszExpr, bCompiled ? "compiled" : "interpreted", nCount,
+           dfDuration, nAllocCount - nAllocCountBefore, nMatches);
+
+    if( !bCompiled )
+        return true;
+
+    // The batch evaluation needs no OGRFeature at all
+    std::vector<GByte> abyMatches(oBatch.GetRowCount());
+    nAllocCountBefore = nAllocCount;
+    oStart = std::chrono::steady_clock::now();
+    const int nBatchMatches = oQuery.EvaluateBatch(&oBatch, &abyMatches[0]);
+    dfDuration = std::chrono::duration<double>(
+        std::chrono::steady_clock::now() - oStart).count();
+    Report(pszExpr, "batch", nCount, dfDuration,
+           nAllocCount - nAllocCountBefore, nBatchMatches);
+    return nBatchMatches == nMatches;
+}
+
+int main( int argc, char* argv[] )
+{
+    int nCount = 1000 * 1000;
+    for( int i = 1; i < argc; i++ )
+    {
+        if( EQUAL(argv[i], "-count") && i + 1 < argc )
+            nCount = std::max(1, atoi(argv[++i]));
+        else
+        {
+            printf("Usage: testperfogrfilter [-count N]\n");
+            return 1;
+        }
+    }
+
+    OGRFeatureDefn* poDefn = new OGRFeatureDefn("test");
+    poDefn->Reference();
+    OGRFieldDefn oFieldInt("id", OFTInteger);
+    poDefn->AddFieldDefn(&oFieldInt);
+    OGRFieldDefn oFieldStr("name", OFTString);
+    poDefn->AddFieldDefn(&oFieldStr);
+    OGRFieldDefn oFieldReal("value", OFTReal);
+    poDefn->AddFieldDefn(&oFieldReal);
+
+    std::vector<OGRFeature*> apoFeatures;
+    OGRFeatureBatch oBatch(poDefn);
+    for( int i = 0; i < nCount; i++ )
+    {
+        OGRFeature* poFeature = new OGRFeature(poDefn);
+        poFeature->SetFID(i);
+        poFeature->SetField(0, i);
+        if( (i % 10) != 0 )
+            poFeature->SetField(1, CPLSPrintf("feature %d", i % 1000));
+        poFeature->SetField(2, i * 0.25);
+        oBatch.AddFeature(poFeature);
+        apoFeatures.push_back(poFeature);
+    }
+
+    const char* const apszExpr[] = {
+        "id > 500",
+        "value BETWEEN 10 AND 1000",
+        "id % 3 = 0 AND value < 5000.5",
+        "name = 'feature 42'",
+        "name LIKE 'feature 1%'",
+        "id IN (1, 10, 100, 1000, 10000)",
+        "name IS NULL OR id * 2 > 1000",
+    };
+
+    int nRet = 0;
+    for( const char* pszExpr : apszExpr )
+    {
+        if( !Run(poDefn, apoFeatures, oBatch, pszExpr, false) ||
+            !Run(poDefn, apoFeatures, oBatch, pszExpr, true) )
+        {
+            printf("%-40s: failed\n", pszExpr);
+            nRet = 1;
+        }
+    }
+
+    for( OGRFeature* poFeature : apoFeatures )
+        delete poFeature;
+    poDefn->Release();
+    return nRet;
+}
@@ -0,0 +1,237 @@
+/******************************************************************************
+ * $Id$
+ *
+ * Project:  GDAL Core
+ * Purpose:  Test performance and heap allocations of sequential vector reads,
+ *           with OGRLayer::GetNextFeature() and OGRLayer::FillNextFeature()
+ *
+ ******************************************************************************
+ * Copyright (c) 2018, GDAL contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ ****************************************************************************/
+
+#include "cpl_conv.h"
+#include "cpl_string.h"
+#include "gdal_priv.h"
+#include "ogrsf_frmts.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+
+// Count the heap allocations by interposing the allocator of the C library.
+static GUIntBig nAllocCount = 0;
+
+#ifdef __GLIBC__
+extern "C"
+{
+void* __libc_malloc(size_t);
+void* __libc_calloc(size_t, size_t);
+void* __libc_realloc(void*, size_t);
+
+void* malloc(size_t nSize)
+{
+    nAllocCount++;
+    return __libc_malloc(nSize);
+}
+
+void* calloc(size_t nCount, size_t nSize)
+{
+    nAllocCount++;
+    return __libc_calloc(nCount, nSize);
+}
+
+void* realloc(void* pPtr, size_t nSize)
+{
+    nAllocCount++;
+    return __libc_realloc(pPtr, nSize);
+}
+}
+#define HAVE_ALLOC_COUNT
+#endif
+
+struct Case
+{
+    const char* pszName;
+    const char* pszDriver;
+    const char* pszFilename;
+    OGRwkbGeometryType eGType;
+};
+
+static bool Create( const Case& oCase, int nCount )
+{
+    GDALDriver* poDriver =
+        GetGDALDriverManager()->GetDriverByName(oCase.pszDriver);
+    if( poDriver == nullptr )
+        return false;
+    GDALDataset* poDS = poDriver->Create(oCase.pszFilename, 0, 0, 0,
+                                         GDT_Unknown, nullptr);
+    if( poDS == nullptr )
+        return false;
+    OGRLayer* poLayer = poDS->CreateLayer("test", nullptr, oCase.eGType);
+    if( poLayer == nullptr )
+    {
+        GDALClose(poDS);
+        return false;
+    }
+    OGRFieldDefn oFieldInt("id", OFTInteger);
+    poLayer->CreateField(&oFieldInt);
+    OGRFieldDefn oFieldStr("name", OFTString);
+    oFieldStr.SetWidth(16);
+    poLayer->CreateField(&oFieldStr);
+    OGRFieldDefn oFieldReal("value", OFTReal);
+    poLayer->CreateField(&oFieldReal);
+
+    CPL_IGNORE_RET_VAL(poLayer->StartTransaction());
+    OGRFeature oFeature(poLayer->GetLayerDefn());
+    OGRPoint oPoint;
+    OGRLineString oLine;
+    bool bRet = true;
+    for( int i = 0; bRet && i < nCount; i++ )
+    {
+        oFeature.SetFID(OGRNullFID);
+        oFeature.SetField(0, i);
+        oFeature.SetField(1, CPLSPrintf("feature %d", i));
+        oFeature.SetField(2, i * 0.25);
+        const double dfX = (i % 1000) * 10.0;
+        const double dfY = (i / 1000) * 10.0;
+        if( oCase.eGType == wkbPoint )
+        {
+            oPoint.setX(dfX);
+            oPoint.setY(dfY);
+            oFeature.SetGeometry(&oPoint);
+        }
+        else
+        {
+            oLine.setNumPoints(2 + i % 8, FALSE);
+            for( int j = 0; j < oLine.getNumPoints(); j++ )
+                oLine.setPoint(j, dfX + j, dfY + (j % 2));
+            oFeature.SetGeometry(&oLine);
+        }
+        bRet = poLayer->CreateFeature(&oFeature) == OGRERR_NONE;
+    }
+    CPL_IGNORE_RET_VAL(poLayer->CommitTransaction());
+    GDALClose(poDS);
+    return bRet;
+}
+
+static bool Read( const Case& oCase, bool bFill, int nCount )
+{
+    GDALDataset* poDS = reinterpret_cast<GDALDataset*>(
+        GDALOpenEx(oCase.pszFilename, GDAL_OF_VECTOR, nullptr,
+                   nullptr, nullptr));
+    if( poDS == nullptr )
+        return false;
+    OGRLayer* poLayer = poDS->GetLayer(0);
+    OGRFeature* poFeature = new OGRFeature(poLayer->GetLayerDefn());
+
+    double dfSum = 0;
+    int nRead = 0;
+    const GUIntBig nAllocCountBefore = nAllocCount;
+    const auto oStart = std::chrono::steady_clock::now();
+    if( bFill )
+    {
+        while( poLayer->FillNextFeature(poFeature) )
+        {
+            dfSum += poFeature->GetFieldAsDouble(2);
+            nRead++;
+        }
+    }
+    else
+    {
+        OGRFeature* poNextFeature = nullptr;
+        while( (poNextFeature = poLayer->GetNextFeature()) != nullptr )
+        {
+            dfSum += poNextFeature->GetFieldAsDouble(2);
+            nRead++;
+            delete poNextFeature;
+        }
+    }
+    const double dfDuration = std::chrono::duration<double>(
+        std::chrono::steady_clock::now() - oStart).count();
+    const GUIntBig nAllocs = nAllocCount - nAllocCountBefore;
+
+    delete poFeature;
+    GDALClose(poDS);
+    if( nRead != nCount )
+        return false;
+
+    printf("%-24s %-16s: %.2f Mfeatures/s",
+           oCase.pszName, bFill ? "FillNextFeature" : "GetNextFeature",
+           nRead / dfDuration / 1e6);
+#ifdef HAVE_ALLOC_COUNT
+    printf(", %.2f allocations/feature",
+           static_cast<double>(nAllocs) / std::max(1, nRead));
+#else
+    CPL_IGNORE_RET_VAL(nAllocs);
+#endif
+    printf(", sum %.1f\n", dfSum);
+    return true;
+}
+
+int main( int argc, char* argv[] )
+{
+    int nCount = 1000 * 1000;
+    for( int i = 1; i < argc; i++ )
+    {
+        if( EQUAL(argv[i], "-count") && i + 1 < argc )
+            nCount = std::max(1, atoi(argv[++i]));
+        else
+        {
+            printf("Usage: testperfogrread [-count N]\n");
+            return 1;
+        }
+    }
+
+    GDALAllRegister();
+
+    const Case aoCases[] = {
+        { "Shapefile points", "ESRI Shapefile",
+          "/vsimem/testperfogrread_point.shp", wkbPoint },
+        { "Shapefile lines", "ESRI Shapefile",
+          "/vsimem/testperfogrread_line.shp", wkbLineString },
+        { "GeoPackage points", "GPKG",
+          "/vsimem/testperfogrread_point.gpkg", wkbPoint },
+        { "GeoPackage lines", "GPKG",
+          "/vsimem/testperfogrread_line.gpkg", wkbLineString },
+    };
+
+    int nRet = 0;
+    for( const auto& oCase : aoCases )
+    {
+        if( !Create(oCase, nCount) )
+        {
+            printf("%-24s: unavailable\n", oCase.pszName);
+            continue;
+        }
+        if( !Read(oCase, false, nCount) || !Read(oCase, true, nCount) )
+        {
+            printf("%-24s: failed\n", oCase.pszName);
+            nRet = 1;
+        }
+        GDALDriver* poDriver =
+            GetGDALDriverManager()->GetDriverByName(oCase.pszDriver);
+        poDriver->Delete(oCase.pszFilename);
+    }
+
+    GDALDestroyDriverManager();
+    return nRet;
+}
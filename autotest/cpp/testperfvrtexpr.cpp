@@ -0,0 +1,210 @@
+/******************************************************************************
+ * $Id$
+ *
+ * Project:  GDAL Core
+ * Purpose:  Test performance of VRT derived bands: expressions, C and Python
+ *           pixel functions
+ *
+ ******************************************************************************
+ * Copyright (c) 2018, GDAL contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ ****************************************************************************/
+
+#include "cpl_conv.h"
+#include "cpl_string.h"
+#include "gdal.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+static const char* const pszSrcFilename = "/vsimem/testperfvrtexpr.tif";
+
+// Time reading the whole derived band, nIterations times, and store the
+// result of the last iteration in adfResult.
+static double Run( const char* pszLanguage, const char* pszFuncType,
+                   const char* pszCode, int nSize, int nIterations,
+                   std::vector<double>& adfResult )
+{
+    CPLString osSources;
+    for( int iBand = 1; iBand <= 2; iBand++ )
+    {
+        osSources += CPLSPrintf(
+            "<SimpleSource>"
+            "<SourceFilename>%s</SourceFilename>"
+            "<SourceBand>%d</SourceBand>"
+            "</SimpleSource>", pszSrcFilename, iBand);
+    }
+    CPLString osVRT;
+    osVRT.Printf(
+        "<VRTDataset rasterXSize=\"%d\" rasterYSize=\"%d\">"
+        "<VRTRasterBand dataType=\"Float64\" band=\"1\" "
+        "subClass=\"VRTDerivedRasterBand\">"
+        "<PixelFunctionLanguage>%s</PixelFunctionLanguage>"
+        "%s%s%s"
+        "</VRTRasterBand></VRTDataset>",
+        nSize, nSize, pszLanguage,
+        pszFuncType ? CPLSPrintf("<PixelFunctionType>%s</PixelFunctionType>",
+                                 pszFuncType) : "",
+        pszCode ? CPLSPrintf("<PixelFunctionCode><![CDATA[%s]]>"
+                             "</PixelFunctionCode>", pszCode) : "",
+        osSources.c_str());
+
+    GDALDatasetH hDS = GDALOpen(osVRT, GA_ReadOnly);
+    if( hDS == nullptr )
+        return -1.0;
+    adfResult.resize(static_cast<size_t>(nSize) * nSize);
+    GDALRasterBandH hBand = GDALGetRasterBand(hDS, 1);
+    const auto oStart = std::chrono::steady_clock::now();
+    CPLErr eErr = CE_None;
+    for( int i = 0; i < nIterations && eErr == CE_None; i++ )
+    {
+        eErr = GDALRasterIO(hBand, GF_Read, 0, 0, nSize, nSize,
+                            &adfResult[0], nSize, nSize, GDT_Float64, 0, 0);
+    }
+    const double dfElapsed = std::chrono::duration<double>(
+        std::chrono::steady_clock::now() - oStart).count();
+    GDALClose(hDS);
+    return eErr == CE_None ? dfElapsed : -1.0;
+}
+
+static void Report( const char* pszName, double dfElapsed, int nSize,
+                    int nIterations )
+{
+    if( dfElapsed < 0 )
+        printf("%-36s: unavailable\n", pszName);
+    else
+        printf("%-36s: %.3f s, %.1f Mpixels/s\n", pszName, dfElapsed,
+               static_cast<double>(nSize) * nSize * nIterations / 1e6 /
+                                                                dfElapsed);
+}
+
+static double MaxDiff( const std::vector<double>& adfA,
+                       const std::vector<double>& adfB )
+{
+    double dfMaxDiff = 0.0;
+    for( size_t i = 0; i < adfA.size(); i++ )
+        dfMaxDiff = std::max(dfMaxDiff, fabs(adfA[i] - adfB[i]));
+    return dfMaxDiff;
+}
+
+int main( int argc, char* argv[] )
+{
+    int nSize = 2048;
+    int nIterations = 5;
+    bool bPython = true;
+    for( int i = 1; i < argc; i++ )
+    {
+        if( EQUAL(argv[i], "-size") && i + 1 < argc )
+            nSize = std::max(1, atoi(argv[++i]));
+        else if( EQUAL(argv[i], "-iterations") && i + 1 < argc )
+            nIterations = std::max(1, atoi(argv[++i]));
+        else if( EQUAL(argv[i], "-nopython") )
+            bPython = false;
+        else
+        {
+            printf("Usage: testperfvrtexpr [-size N] [-iterations N] "
+                   "[-nopython]\n");
+            return 1;
+        }
+    }
+
+    GDALAllRegister();
+
+    // Two bands of pseudo-random values
+    GDALDatasetH hSrcDS = GDALCreate(GDALGetDriverByName("GTiff"),
+                                     pszSrcFilename, nSize, nSize, 2,
+                                     GDT_Float32, nullptr);
+    if( hSrcDS == nullptr )
+        return 1;
+    std::vector<float> afLine(nSize);
+    unsigned int nSeed = 1;
+    for( int iBand = 1; iBand <= 2; iBand++ )
+    {
+        GDALRasterBandH hBand = GDALGetRasterBand(hSrcDS, iBand);
+        for( int iY = 0; iY < nSize; iY++ )
+        {
+            for( int iX = 0; iX < nSize; iX++ )
+            {
+                nSeed = nSeed * 1103515245U + 12345U;
+                afLine[iX] = static_cast<float>(1 + ((nSeed >> 16) % 1000));
+            }
+            if( GDALRasterIO(hBand, GF_Write, 0, iY, nSize, 1, &afLine[0],
+                             nSize, 1, GDT_Float32, 0, 0) != CE_None )
+                return 1;
+        }
+    }
+    GDALClose(hSrcDS);
+    // Make the source reads as cheap as possible
+    GDALSetCacheMax64(static_cast<GIntBig>(nSize) * nSize * 4 * 4);
+
+    std::vector<double> adfRef;
+    std::vector<double> adfResult;
+    int nRet = 0;
+
+    // Sum: built-in C pixel function vs expression
+    Report("sum (C pixel function)",
+           Run("C", "sum", nullptr, nSize, nIterations, adfRef),
+           nSize, nIterations);
+    Report("sum (expression)",
+           Run("Expression", nullptr, "B1 + B2", nSize, nIterations,
+               adfResult), nSize, nIterations);
+    if( MaxDiff(adfRef, adfResult) != 0.0 )
+    {
+        printf("Results differ!\n");
+        nRet = 1;
+    }
+
+    // Normalized difference: expression vs Python
+    const char* pszExpr = "B1 == B2 ? 0 : (B2 - B1) / (B2 + B1)";
+    Report("normalized difference (expression)",
+           Run("Expression", nullptr, pszExpr, nSize, nIterations, adfRef),
+           nSize, nIterations);
+    if( bPython )
+    {
+        CPLSetConfigOption("GDAL_VRT_ENABLE_PYTHON", "YES");
+        const double dfElapsed = Run(
+            "Python", "ndiff",
+            "import numpy\n"
+            "def ndiff(in_ar, out_ar, xoff, yoff, xsize, ysize, "
+            "raster_xsize, raster_ysize, buf_radius, gt, **kwargs):\n"
+            "    b1 = in_ar[0].astype(numpy.float64)\n"
+            "    b2 = in_ar[1].astype(numpy.float64)\n"
+            "    s = b2 + b1\n"
+            "    s[b1 == b2] = 1\n"
+            "    out_ar[:] = numpy.where(b1 == b2, 0, (b2 - b1) / s)\n",
+            nSize, nIterations, adfResult);
+        CPLSetConfigOption("GDAL_VRT_ENABLE_PYTHON", nullptr);
+        Report("normalized difference (Python)", dfElapsed, nSize,
+               nIterations);
+        if( dfElapsed >= 0 && MaxDiff(adfRef, adfResult) > 1e-12 )
+        {
+            printf("Results differ!\n");
+            nRet = 1;
+        }
+    }
+
+    VSIUnlink(pszSrcFilename);
+    GDALDestroyDriverManager();
+    return nRet;
+}
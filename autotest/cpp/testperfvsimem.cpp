@@ -0,0 +1,180 @@
+/******************************************************************************
+ * $Id$
+ *
+ * Project:  CPL - Common Portability Library
+ * Purpose:  Test performance of concurrent accesses to /vsimem/
+ *
+ ******************************************************************************
+ * Copyright (c) 2018, GDAL contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ ****************************************************************************/
+
+#include "cpl_atomic_ops.h"
+#include "cpl_conv.h"
+#include "cpl_multiproc.h"
+#include "cpl_string.h"
+#include "cpl_vsi.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+static int nIterations = 20000;
+static volatile int nErrors = 0;
+
+// Each thread creates, writes, stats, reads back and unlinks its own small
+// files: this exercises the file table of /vsimem/.
+static void CreateReadDeleteFunc( void* pData )
+{
+    const int nThread = *static_cast<int*>(pData);
+    GByte abyBuffer[1024];
+    for( int i = 0; i < nIterations; i++ )
+    {
+        const char* pszFilename =
+            CPLSPrintf("/vsimem/testperfvsimem/thread%d_%d.bin", nThread, i);
+        memset(abyBuffer, i & 0xFF, sizeof(abyBuffer));
+        VSILFILE* fp = VSIFOpenL(pszFilename, "wb");
+        if( fp == nullptr ||
+            VSIFWriteL(abyBuffer, 1, sizeof(abyBuffer), fp) !=
+                                                        sizeof(abyBuffer) )
+        {
+            CPLAtomicInc(&nErrors);
+        }
+        if( fp )
+            VSIFCloseL(fp);
+
+        VSIStatBufL sStat;
+        if( VSIStatL(pszFilename, &sStat) != 0 ||
+            sStat.st_size != static_cast<int>(sizeof(abyBuffer)) )
+        {
+            CPLAtomicInc(&nErrors);
+        }
+
+        fp = VSIFOpenL(pszFilename, "rb");
+        if( fp == nullptr ||
+            VSIFReadL(abyBuffer, 1, sizeof(abyBuffer), fp) !=
+                                                        sizeof(abyBuffer) ||
+            abyBuffer[sizeof(abyBuffer)-1] != static_cast<GByte>(i & 0xFF) )
+        {
+            CPLAtomicInc(&nErrors);
+        }
+        if( fp )
+            VSIFCloseL(fp);
+
+        if( VSIUnlink(pszFilename) != 0 )
+            CPLAtomicInc(&nErrors);
+    }
+}
+
+// Each thread opens and reads the same shared file.
+static void ReadSharedFunc( void* /* pData */ )
+{
+    GByte abyBuffer[4096];
+    for( int i = 0; i < nIterations; i++ )
+    {
+        VSILFILE* fp = VSIFOpenL("/vsimem/testperfvsimem/shared.bin", "rb");
+        if( fp == nullptr )
+        {
+            CPLAtomicInc(&nErrors);
+            continue;
+        }
+        for( int j = 0; j < 16; j++ )
+        {
+            if( VSIFReadL(abyBuffer, 1, sizeof(abyBuffer), fp) !=
+                                                        sizeof(abyBuffer) ||
+                abyBuffer[0] != static_cast<GByte>(j) )
+            {
+                CPLAtomicInc(&nErrors);
+            }
+        }
+        VSIFCloseL(fp);
+    }
+}
+
+static double RunThreads( CPLThreadFunc pfnFunc, int nThreads )
+{
+    std::vector<int> anThreadIds(nThreads);
+    std::vector<CPLJoinableThread*> ahThreads;
+    const auto oStart = std::chrono::steady_clock::now();
+    for( int i = 0; i < nThreads; i++ )
+    {
+        anThreadIds[i] = i;
+        ahThreads.push_back(CPLCreateJoinableThread(pfnFunc, &anThreadIds[i]));
+    }
+    for( auto hThread : ahThreads )
+        CPLJoinThread(hThread);
+    return std::chrono::duration<double>(
+        std::chrono::steady_clock::now() - oStart).count();
+}
+
+int main( int argc, char* argv[] )
+{
+    int nMaxThreads = CPLGetNumCPUs();
+    for( int i = 1; i < argc; i++ )
+    {
+        if( EQUAL(argv[i], "-threads") && i + 1 < argc )
+            nMaxThreads = std::max(1, atoi(argv[++i]));
+        else if( EQUAL(argv[i], "-iterations") && i + 1 < argc )
+            nIterations = std::max(1, atoi(argv[++i]));
+        else
+        {
+            printf("Usage: testperfvsimem [-threads N] [-iterations N]\n");
+            return 1;
+        }
+    }
+
+    VSIMkdir("/vsimem/testperfvsimem", 0755);
+
+    GByte abyShared[16 * 4096];
+    for( int j = 0; j < 16; j++ )
+        memset(abyShared + j * 4096, j, 4096);
+    VSILFILE* fp = VSIFOpenL("/vsimem/testperfvsimem/shared.bin", "wb");
+    if( fp == nullptr ||
+        VSIFWriteL(abyShared, 1, sizeof(abyShared), fp) != sizeof(abyShared) )
+    {
+        printf("Cannot create shared file\n");
+        return 1;
+    }
+    VSIFCloseL(fp);
+
+    for( int nThreads = 1; nThreads <= nMaxThreads; nThreads *= 2 )
+    {
+        const double dfCreate = RunThreads(CreateReadDeleteFunc, nThreads);
+        const double dfShared = RunThreads(ReadSharedFunc, nThreads);
+        printf("%d thread(s): create/stat/read/unlink: %.0f files/s, "
+               "shared file open/read/close: %.0f opens/s\n",
+               nThreads,
+               nThreads * static_cast<double>(nIterations) / dfCreate,
+               nThreads * static_cast<double>(nIterations) / dfShared);
+    }
+
+    VSIUnlink("/vsimem/testperfvsimem/shared.bin");
+    VSIRmdir("/vsimem/testperfvsimem");
+
+    if( nErrors != 0 )
+    {
+        printf("%d errors\n", nErrors);
+        return 1;
+    }
+    return 0;
+}
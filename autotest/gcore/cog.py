@@ -0,0 +1,334 @@
+#!/usr/bin/env python
+# -*- coding: utf-8 -*-
+###############################################################################
+# $Id$
+#
+# Project:  GDAL/OGR Test Suite
+# Purpose:  COG driver testing
+#
+###############################################################################
+# Copyright (c) 2018, GDAL contributors
+#
+# Permission is hereby granted, free of charge, to any person obtaining a
+# copy of this software and associated documentation files (the "Software"),
+# to deal in the Software without restriction, including without limitation
+# the rights to use, copy, modify, merge, publish, distribute, sublicense,
+# and/or sell copies of the Software, and to permit persons to whom the
+# Software is furnished to do so, subject to the following conditions:
+#
+# The above copyright notice and this permission notice shall be included
+# in all copies or substantial portions of the Software.
+#
+# THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+# OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+# FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+# THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+# LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+# FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+# DEALINGS IN THE SOFTWARE.
+###############################################################################
+
+import sys
+
+sys.path.append('../pymod')
+
+from osgeo import gdal
+import gdaltest
+
+###############################################################################
+# Create a 1024x1024 source dataset
+
+
+def cog_create_src(filename, bands=1):
+    return gdal.Translate(filename, '../gcore/data/byte.tif',
+                          bandList=[1] * bands, width=1024, height=1024,
+                          resampleAlg=gdal.GRIORA_Bilinear)
+
+###############################################################################
+# Check that the IFDs are at the beginning of the file, and that the imagery
+# of the overviews is before the one of the full resolution image, from the
+# smallest overview to the largest one.
+
+
+def cog_check_layout(ds):
+    band = ds.GetRasterBand(1)
+    ifd_offsets = [int(band.GetMetadataItem('IFD_OFFSET', 'TIFF'))]
+    data_offsets = [int(band.GetMetadataItem('BLOCK_OFFSET_0_0', 'TIFF'))]
+    for i in range(band.GetOverviewCount()):
+        ovr_band = band.GetOverview(i)
+        ifd_offsets.append(int(ovr_band.GetMetadataItem('IFD_OFFSET', 'TIFF')))
+        data_offsets.append(
+            int(ovr_band.GetMetadataItem('BLOCK_OFFSET_0_0', 'TIFF')))
+
+    if ifd_offsets[0] != 8 or ifd_offsets != sorted(ifd_offsets) or \
+       max(ifd_offsets) > min(data_offsets):
+        gdaltest.post_reason('IFDs are not at the beginning of the file')
+        print(ifd_offsets, data_offsets)
+        return False
+    if data_offsets != sorted(data_offsets, reverse=True):
+        gdaltest.post_reason('imagery is not in the expected order')
+        print(data_offsets)
+        return False
+    return True
+
+###############################################################################
+# Test a raster that fits in one tile
+
+
+def cog_1():
+
+    if gdal.GetDriverByName('COG') is None:
+        return 'skip'
+
+    src_ds = gdal.Open('data/byte.tif')
+    ds = gdal.GetDriverByName('COG').CreateCopy('/vsimem/cog_1.tif', src_ds)
+    if ds is None:
+        gdaltest.post_reason('fail')
+        return 'fail'
+    ds = None
+
+    ds = gdal.Open('/vsimem/cog_1.tif')
+    if ds.GetDriver().ShortName != 'GTiff':
+        gdaltest.post_reason('fail')
+        return 'fail'
+    if ds.GetRasterBand(1).Checksum() != 4672:
+        gdaltest.post_reason('fail')
+        print(ds.GetRasterBand(1).Checksum())
+        return 'fail'
+    if ds.GetRasterBand(1).GetBlockSize() != [512, 512]:
+        gdaltest.post_reason('fail')
+        print(ds.GetRasterBand(1).GetBlockSize())
+        return 'fail'
+    if ds.GetRasterBand(1).GetOverviewCount() != 0:
+        gdaltest.post_reason('fail')
+        return 'fail'
+    if ds.GetMetadataItem('COMPRESSION', 'IMAGE_STRUCTURE') != 'LZW':
+        gdaltest.post_reason('fail')
+        return 'fail'
+    if ds.GetGeoTransform() != src_ds.GetGeoTransform() or \
+       ds.GetProjectionRef() != src_ds.GetProjectionRef():
+        gdaltest.post_reason('fail')
+        return 'fail'
+    ds = None
+
+    gdal.Unlink('/vsimem/cog_1.tif')
+
+    return 'success'
+
+###############################################################################
+# Test computing overviews, and compare them with the ones computed by
+# BuildOverviews()
+
+
+def cog_2():
+
+    if gdal.GetDriverByName('COG') is None:
+        return 'skip'
+
+    src_ds = cog_create_src('/vsimem/cog_2_src.tif', bands=3)
+
+    ref_ds = gdal.Translate('/vsimem/cog_2_ref.tif', src_ds,
+                            creationOptions=['TILED=YES', 'COMPRESS=DEFLATE'])
+    ref_ds.BuildOverviews('AVERAGE', [2, 4])
+
+    for options in [['BLOCKSIZE=256'],
+                    ['BLOCKSIZE=256', 'NUM_THREADS=2'],
+                    ['BLOCKSIZE=256', 'COMPRESS=DEFLATE', 'NUM_THREADS=2']]:
+        gdal.GetDriverByName('COG').CreateCopy('/vsimem/cog_2.tif', src_ds,
+                                               options=options)
+        ds = gdal.Open('/vsimem/cog_2.tif')
+        if not cog_check_layout(ds):
+            print(options)
+            return 'fail'
+        for i in range(3):
+            band = ds.GetRasterBand(i + 1)
+            ref_band = ref_ds.GetRasterBand(i + 1)
+            if band.GetBlockSize() != [256, 256] or \
+               band.Checksum() != ref_band.Checksum():
+                gdaltest.post_reason('fail')
+                print(options)
+                return 'fail'
+            if band.GetOverviewCount() != 2:
+                gdaltest.post_reason('fail')
+                print(options)
+                return 'fail'
+            for j in range(2):
+                ovr_band = band.GetOverview(j)
+                if ovr_band.GetBlockSize() != [256, 256] or \
+                   ovr_band.Checksum() != ref_band.GetOverview(j).Checksum():
+                    gdaltest.post_reason('fail')
+                    print(options, i, j)
+                    return 'fail'
+        ds = None
+        gdal.Unlink('/vsimem/cog_2.tif')
+
+    src_ds = None
+    ref_ds = None
+    gdal.Unlink('/vsimem/cog_2_src.tif')
+    gdal.Unlink('/vsimem/cog_2_ref.tif')
+
+    return 'success'
+
+###############################################################################
+# Test computing overviews in a temporary file rather than in memory
+
+
+def cog_3():
+
+    if gdal.GetDriverByName('COG') is None:
+        return 'skip'
+
+    src_ds = cog_create_src('/vsimem/cog_3_src.tif')
+
+    gdal.GetDriverByName('COG').CreateCopy('/vsimem/cog_3_ref.tif', src_ds)
+    # The overviews do not fit in the block cache
+    old_cache_max = gdal.GetCacheMax()
+    gdal.SetCacheMax(100000)
+    gdal.GetDriverByName('COG').CreateCopy('/vsimem/cog_3.tif', src_ds,
+                                           options=['BLOCKSIZE=512'])
+    gdal.SetCacheMax(old_cache_max)
+
+    ds = gdal.Open('/vsimem/cog_3.tif')
+    ref_ds = gdal.Open('/vsimem/cog_3_ref.tif')
+    if not cog_check_layout(ds):
+        return 'fail'
+    if ds.GetRasterBand(1).GetOverviewCount() != 1 or \
+       ds.GetRasterBand(1).GetOverview(0).Checksum() != \
+       ref_ds.GetRasterBand(1).GetOverview(0).Checksum():
+        gdaltest.post_reason('fail')
+        return 'fail'
+    ds = None
+    ref_ds = None
+
+    src_ds = None
+    gdal.Unlink('/vsimem/cog_3_src.tif')
+    gdal.Unlink('/vsimem/cog_3_ref.tif')
+    gdal.Unlink('/vsimem/cog_3.tif')
+
+    return 'success'
+
+###############################################################################
+# Test OVERVIEWS option
+
+
+def cog_4():
+
+    if gdal.GetDriverByName('COG') is None:
+        return 'skip'
+
+    src_ds = cog_create_src('/vsimem/cog_4_src.tif')
+    src_ds.BuildOverviews('NEAREST', [2, 4, 8])
+    src_ds = None
+    src_ds = gdal.Open('/vsimem/cog_4_src.tif')
+
+    for (overviews, expected_count) in [('AUTO', 3),
+                                        ('IGNORE_EXISTING', 1),
+                                        ('NONE', 0)]:
+        gdal.GetDriverByName('COG').CreateCopy(
+            '/vsimem/cog_4.tif', src_ds, options=['OVERVIEWS=' + overviews])
+        ds = gdal.Open('/vsimem/cog_4.tif')
+        band = ds.GetRasterBand(1)
+        if band.GetOverviewCount() != expected_count:
+            gdaltest.post_reason('fail')
+            print(overviews, band.GetOverviewCount())
+            return 'fail'
+        if overviews == 'AUTO' and \
+           band.GetOverview(2).Checksum() != \
+           src_ds.GetRasterBand(1).GetOverview(2).Checksum():
+            gdaltest.post_reason('fail')
+            return 'fail'
+        if expected_count and not cog_check_layout(ds):
+            print(overviews)
+            return 'fail'
+        ds = None
+        gdal.Unlink('/vsimem/cog_4.tif')
+
+    src_ds = None
+    gdal.Unlink('/vsimem/cog_4_src.tif')
+
+    return 'success'
+
+###############################################################################
+# Test a source with a per-dataset mask
+
+
+def cog_5():
+
+    if gdal.GetDriverByName('COG') is None:
+        return 'skip'
+
+    src_ds = cog_create_src('/vsimem/cog_5_src.tif')
+    with gdaltest.config_option('GDAL_TIFF_INTERNAL_MASK', 'YES'):
+        src_ds.CreateMaskBand(gdal.GMF_PER_DATASET)
+    src_ds.GetRasterBand(1).GetMaskBand().WriteRaster(
+        0, 0, 512, 1024, b'\xff' * (512 * 1024))
+    src_ds = None
+    src_ds = gdal.Open('/vsimem/cog_5_src.tif')
+
+    gdal.GetDriverByName('COG').CreateCopy('/vsimem/cog_5.tif', src_ds,
+                                           options=['BLOCKSIZE=256'])
+    if gdal.VSIStatL('/vsimem/cog_5.tif.msk') is not None:
+        gdaltest.post_reason('mask should be internal')
+        return 'fail'
+
+    ds = gdal.Open('/vsimem/cog_5.tif')
+    mask_band = ds.GetRasterBand(1).GetMaskBand()
+    if ds.GetRasterBand(1).GetMaskFlags() != gdal.GMF_PER_DATASET or \
+       mask_band.Checksum() != \
+       src_ds.GetRasterBand(1).GetMaskBand().Checksum():
+        gdaltest.post_reason('fail')
+        return 'fail'
+    if mask_band.GetOverviewCount() != 2:
+        gdaltest.post_reason('fail')
+        return 'fail'
+    # Left half is valid, right half is invalid
+    ovr_mask_band = mask_band.GetOverview(1)
+    if ovr_mask_band.ReadRaster(0, 0, 1, 1) == b'\x00' or \
+       ovr_mask_band.ReadRaster(255, 255, 1, 1) != b'\x00':
+        gdaltest.post_reason('fail')
+        return 'fail'
+    ds = None
+
+    src_ds = None
+    gdal.Unlink('/vsimem/cog_5_src.tif')
+    gdal.Unlink('/vsimem/cog_5.tif')
+
+    return 'success'
+
+###############################################################################
+# Test invalid options
+
+
+def cog_6():
+
+    if gdal.GetDriverByName('COG') is None:
+        return 'skip'
+
+    src_ds = gdal.Open('data/byte.tif')
+    with gdaltest.error_handler():
+        ds = gdal.GetDriverByName('COG').CreateCopy(
+            '/vsimem/cog_6.tif', src_ds, options=['BLOCKSIZE=100'])
+    if ds is not None:
+        gdaltest.post_reason('fail')
+        return 'fail'
+    gdal.Unlink('/vsimem/cog_6.tif')
+
+    return 'success'
+
+
+gdaltest_list = [
+    cog_1,
+    cog_2,
+    cog_3,
+    cog_4,
+    cog_5,
+    cog_6,
+]
+
+if __name__ == '__main__':
+
+    gdaltest.setup_run('cog')
+
+    gdaltest.run_tests(gdaltest_list)
+
+    sys.exit(gdaltest.summarize())
@@ -32,6 +32,7 @@
 import sys
 from sys import version_info
 from osgeo import gdal
+from osgeo import ogr
 
 sys.path.append('../pymod')
 
@@ -376,10 +377,172 @@ def testnonboundtoswig_VRTDerivedBands():
 
     return 'success'
 
+###############################################################################
+# Test the column buffers filled by OGR_L_GetNextFeatureBatch() with the
+# native implementation of the OpenFileGDB driver
+
+
+def testnonboundtoswig_OGR_L_GetNextFeatureBatch_OpenFileGDB():
+
+    if gdal_handle is None:
+        return 'skip'
+
+    if ogr.GetDriverByName('OpenFileGDB') is None:
+        return 'skip'
+
+    h = gdal_handle_stdcall
+    h.GDALOpenEx.argtypes = [ctypes.c_char_p, ctypes.c_uint, ctypes.c_void_p,
+                             ctypes.c_void_p, ctypes.c_void_p]
+    h.GDALOpenEx.restype = ctypes.c_void_p
+    h.GDALClose.argtypes = [ctypes.c_void_p]
+    h.GDALClose.restype = None
+    h.GDALDatasetGetLayerByName.argtypes = [ctypes.c_void_p, ctypes.c_char_p]
+    h.GDALDatasetGetLayerByName.restype = ctypes.c_void_p
+    h.OGR_L_GetLayerDefn.argtypes = [ctypes.c_void_p]
+    h.OGR_L_GetLayerDefn.restype = ctypes.c_void_p
+    h.OGR_L_GetNextFeatureBatch.argtypes = [ctypes.c_void_p, ctypes.c_void_p,
+                                            ctypes.c_int]
+    h.OGR_L_GetNextFeatureBatch.restype = ctypes.c_int
+    h.OGR_FB_Create.argtypes = [ctypes.c_void_p]
+    h.OGR_FB_Create.restype = ctypes.c_void_p
+    h.OGR_FB_Destroy.argtypes = [ctypes.c_void_p]
+    h.OGR_FB_Destroy.restype = None
+    h.OGR_FB_GetFIDs.argtypes = [ctypes.c_void_p]
+    h.OGR_FB_GetFIDs.restype = ctypes.POINTER(ctypes.c_int64)
+    for name in ['OGR_FB_GetFieldValidity', 'OGR_FB_GetFieldData',
+                 'OGR_FB_GetGeomFieldValidity', 'OGR_FB_GetGeomFieldData']:
+        getattr(h, name).argtypes = [ctypes.c_void_p, ctypes.c_int]
+        getattr(h, name).restype = ctypes.POINTER(ctypes.c_ubyte)
+    for name in ['OGR_FB_GetFieldOffsets', 'OGR_FB_GetGeomFieldOffsets']:
+        getattr(h, name).argtypes = [ctypes.c_void_p, ctypes.c_int]
+        getattr(h, name).restype = ctypes.POINTER(ctypes.c_size_t)
+    h.OGR_FB_GetFieldValues.argtypes = [ctypes.c_void_p, ctypes.c_int]
+    h.OGR_FB_GetFieldValues.restype = ctypes.c_void_p
+
+    def get_bytes(data, offsets, row):
+        return ctypes.string_at(
+            ctypes.addressof(data.contents) + offsets[row],
+            offsets[row + 1] - offsets[row])
+
+    filename = '/vsizip/../ogr/data/testopenfilegdb.gdb.zip/testopenfilegdb.gdb'
+    ds = ogr.Open(filename)
+    if ds is None:
+        gdaltest.post_reason('fail')
+        return 'fail'
+
+    if version_info >= (3, 0, 0):
+        filename = bytes(filename, 'utf-8')
+    native_ds = h.GDALOpenEx(filename, gdal.OF_VECTOR, None, None, None)
+    if native_ds is None:
+        gdaltest.post_reason('fail')
+        return 'fail'
+
+    ret = 'success'
+    for lyr in ds:
+        lyr_name = lyr.GetName()
+        expected = [f for f in lyr]
+        if version_info >= (3, 0, 0):
+            lyr_name = bytes(lyr_name, 'utf-8')
+        native_lyr = h.GDALDatasetGetLayerByName(native_ds, lyr_name)
+        batch = h.OGR_FB_Create(h.OGR_L_GetLayerDefn(native_lyr))
+        lyr_defn = lyr.GetLayerDefn()
+
+        got_count = 0
+        max_rows = 7
+        nrows = max_rows
+        while nrows == max_rows and ret == 'success':
+            nrows = h.OGR_L_GetNextFeatureBatch(native_lyr, batch, max_rows)
+            fids = h.OGR_FB_GetFIDs(batch)
+            for row in range(nrows):
+                if got_count >= len(expected):
+                    gdaltest.post_reason('too many rows')
+                    ret = 'fail'
+                    break
+                f = expected[got_count]
+                got_count += 1
+                if fids[row] != f.GetFID():
+                    gdaltest.post_reason('wrong FID')
+                    print(lyr.GetName(), fids[row], f.GetFID())
+                    ret = 'fail'
+                    break
+
+                for i in range(lyr_defn.GetFieldCount()):
+                    field_type = lyr_defn.GetFieldDefn(i).GetType()
+                    validity = h.OGR_FB_GetFieldValidity(batch, i)
+                    is_set = ((validity[row // 8] >> (row % 8)) & 1) != 0
+                    if is_set != f.IsFieldSetAndNotNull(i):
+                        gdaltest.post_reason('wrong validity')
+                        print(lyr.GetName(), f.GetFID(), i)
+                        ret = 'fail'
+                        break
+                    if not is_set:
+                        continue
+                    values = h.OGR_FB_GetFieldValues(batch, i)
+                    if field_type == ogr.OFTInteger:
+                        got = ctypes.cast(values,
+                                          ctypes.POINTER(ctypes.c_int))[row]
+                        ok = got == f.GetFieldAsInteger(i)
+                    elif field_type == ogr.OFTReal:
+                        got = ctypes.cast(values,
+                                          ctypes.POINTER(ctypes.c_double))[row]
+                        ok = got == f.GetFieldAsDouble(i)
+                    elif field_type == ogr.OFTString:
+                        got = get_bytes(h.OGR_FB_GetFieldData(batch, i),
+                                        h.OGR_FB_GetFieldOffsets(batch, i),
+                                        row)
+                        if version_info >= (3, 0, 0):
+                            got = got.decode('utf-8')
+                        ok = got == f.GetFieldAsString(i)
+                    else:
+                        continue
+                    if not ok:
+                        gdaltest.post_reason('wrong value')
+                        print(lyr.GetName(), f.GetFID(), i, got)
+                        ret = 'fail'
+                        break
+                if ret != 'success':
+                    break
+
+                for i in range(lyr_defn.GetGeomFieldCount()):
+                    geom = f.GetGeomFieldRef(i)
+                    validity = h.OGR_FB_GetGeomFieldValidity(batch, i)
+                    is_set = ((validity[row // 8] >> (row % 8)) & 1) != 0
+                    if is_set != (geom is not None):
+                        gdaltest.post_reason('wrong geometry validity')
+                        print(lyr.GetName(), f.GetFID())
+                        ret = 'fail'
+                        break
+                    if geom is None:
+                        continue
+                    got = get_bytes(h.OGR_FB_GetGeomFieldData(batch, i),
+                                    h.OGR_FB_GetGeomFieldOffsets(batch, i),
+                                    row)
+                    if got != geom.ExportToIsoWkb(ogr.wkbNDR):
+                        gdaltest.post_reason('wrong geometry')
+                        print(lyr.GetName(), f.GetFID())
+                        ret = 'fail'
+                        break
+                if ret != 'success':
+                    break
+
+        h.OGR_FB_Destroy(batch)
+        if ret != 'success':
+            break
+        if got_count != len(expected):
+            gdaltest.post_reason('wrong row count')
+            print(lyr.GetName(), got_count, len(expected))
+            ret = 'fail'
+            break
+
+    h.GDALClose(native_ds)
+
+    return ret
+
 
 gdaltest_list = [testnonboundtoswig_init,
                  testnonboundtoswig_GDALSimpleImageWarp,
-                 testnonboundtoswig_VRTDerivedBands]
+                 testnonboundtoswig_VRTDerivedBands,
+                 testnonboundtoswig_OGR_L_GetNextFeatureBatch_OpenFileGDB]
 
 if __name__ == '__main__':
 
@@ -30,6 +30,7 @@
 import os
 import sys
 import shutil
+import struct
 
 sys.path.append('../pymod')
 
@@ -3845,6 +3846,102 @@ def tiff_read_overview_of_external_mask():
     return 'success'
 
 ###############################################################################
+# Test opening a tiled JPEG YCbCr file without YCbCrSubsampling tag, in
+# which case libtiff inspects the first tile. Only the first entry of the
+# TileOffsets/TileByteCounts arrays must be fetched for that.
+
+
+def tiff_read_jpeg_ycbcr_no_subsampling_tag():
+
+    md = gdal.GetDriverByName('GTiff').GetMetadata()
+    if md['DMD_CREATIONOPTIONLIST'].find('JPEG') == -1:
+        return 'skip'
+
+    filename = '/vsimem/tiff_read_jpeg_ycbcr_no_subsampling_tag.tif'
+    ds = gdal.Translate(filename, 'data/rgbsmall.tif',
+                        options='-co TILED=YES -co BLOCKXSIZE=16 '
+                                '-co BLOCKYSIZE=16 -co COMPRESS=JPEG '
+                                '-co PHOTOMETRIC=YCBCR')
+    ref_cs = [ds.GetRasterBand(i + 1).Checksum() for i in range(3)]
+    ds = None
+
+    # Rename the YCbCrSubsampling tag to an unknown tag
+    f = gdal.VSIFOpenL(filename, 'rb+')
+    data = gdal.VSIFReadL(1, 8, f)
+    ifd_offset = struct.unpack('<I', data[4:8])[0]
+    gdal.VSIFSeekL(f, ifd_offset, 0)
+    count = struct.unpack('<H', gdal.VSIFReadL(1, 2, f))[0]
+    found = False
+    for i in range(count):
+        gdal.VSIFSeekL(f, ifd_offset + 2 + 12 * i, 0)
+        tag = struct.unpack('<H', gdal.VSIFReadL(1, 2, f))[0]
+        if tag == 530:
+            gdal.VSIFSeekL(f, ifd_offset + 2 + 12 * i, 0)
+            gdal.VSIFWriteL(struct.pack('<H', 500), 1, 2, f)
+            found = True
+    gdal.VSIFCloseL(f)
+    if not found:
+        gdaltest.post_reason('fail')
+        return 'fail'
+
+    gdal.ErrorReset()
+    ds = gdal.Open(filename)
+    cs = [ds.GetRasterBand(i + 1).Checksum() for i in range(3)]
+    offset = ds.GetRasterBand(1).GetMetadataItem('BLOCK_OFFSET_3_3', 'TIFF')
+    ds = None
+    gdal.Unlink(filename)
+
+    if gdal.GetLastErrorMsg() != '':
+        gdaltest.post_reason('fail')
+        return 'fail'
+    if cs != ref_cs:
+        gdaltest.post_reason('fail')
+        print(cs, ref_cs)
+        return 'fail'
+    if offset is None:
+        gdaltest.post_reason('fail')
+        return 'fail'
+
+    return 'success'
+
+###############################################################################
+# Test the default GTIFF_VIRTUAL_MEM_IO=AUTO mode on files of the local
+# file system
+
+
+def tiff_read_virtual_mem_io_auto():
+
+    src_ds = gdal.Open('data/stefan_full_rgba.tif')
+    for options in [[], ['INTERLEAVE=BAND'],
+                    ['TILED=YES', 'BLOCKXSIZE=32', 'BLOCKYSIZE=16'],
+                    ['TILED=YES', 'BLOCKXSIZE=32', 'BLOCKYSIZE=16',
+                     'INTERLEAVE=BAND', 'ENDIANNESS=INVERTED']]:
+        filename = 'tmp/tiff_read_virtual_mem_io_auto.tif'
+        gdal.Translate(filename, src_ds, outputType=gdal.GDT_Int16,
+                       creationOptions=options)
+
+        res = []
+        for option in ['NO', 'AUTO']:
+            with gdaltest.config_option('GTIFF_VIRTUAL_MEM_IO', option):
+                ds = gdal.Open(filename)
+                res.append([
+                    ds.ReadRaster(),
+                    ds.ReadRaster(5, 7, 40, 30, band_list=[3, 1]),
+                    ds.ReadRaster(5, 7, 40, 30, buf_type=gdal.GDT_Byte),
+                    ds.GetRasterBand(2).ReadRaster(3, 4, 30, 20),
+                    ds.GetRasterBand(2).ReadRaster(3, 4, 30, 20, 15, 10),
+                    ds.GetRasterBand(4).Checksum()])
+                ds = None
+        gdal.GetDriverByName('GTiff').Delete(filename)
+
+        if res[0] != res[1]:
+            gdaltest.post_reason('fail')
+            print(options)
+            return 'fail'
+
+    return 'success'
+
+###############################################################################
 
 
 for item in init_list:
@@ -3975,6 +4072,8 @@ gdaltest_list.append((tiff_read_zstd_corrupted2))
 gdaltest_list.append((tiff_read_1bit_2bands))
 gdaltest_list.append((tiff_read_lerc))
 gdaltest_list.append((tiff_read_overview_of_external_mask))
+gdaltest_list.append((tiff_read_jpeg_ycbcr_no_subsampling_tag))
+gdaltest_list.append((tiff_read_virtual_mem_io_auto))
 
 gdaltest_list.append((tiff_read_online_1))
 gdaltest_list.append((tiff_read_online_2))
@@ -8420,6 +8420,86 @@ def tiff_write_182_xmp_delete():
 
     return 'success'
 
+###############################################################################
+# Test that multi-threaded JPEG compression gives the same result as
+# single-threaded compression, including with a tiny memory budget for
+# the compression jobs and for the JPEG to JPEG-in-TIFF copy path.
+
+
+def tiff_write_183_jpeg_num_threads():
+
+    md = gdaltest.tiff_drv.GetMetadata()
+    if md['DMD_CREATIONOPTIONLIST'].find('JPEG') == -1:
+        return 'skip'
+
+    src_ds = gdal.Open('data/rgbsmall.tif')
+    for options in [['TILED=YES', 'BLOCKXSIZE=16', 'BLOCKYSIZE=16',
+                     'PHOTOMETRIC=YCBCR'],
+                    ['BLOCKYSIZE=8', 'JPEG_QUALITY=90'],
+                    ['TILED=YES', 'BLOCKXSIZE=16', 'BLOCKYSIZE=16',
+                     'JPEGTABLESMODE=0']]:
+        gdaltest.tiff_drv.CreateCopy('/vsimem/tiff_write_183_ref.tif',
+                                     src_ds,
+                                     options=['COMPRESS=JPEG'] + options)
+        for max_mem in [None, '1']:
+            with gdaltest.config_option('GTIFF_COMPRESSION_JOBS_MAX_MEMORY',
+                                        max_mem):
+                gdaltest.tiff_drv.CreateCopy(
+                    '/vsimem/tiff_write_183.tif', src_ds,
+                    options=['COMPRESS=JPEG', 'NUM_THREADS=4'] + options)
+
+            f = gdal.VSIFOpenL('/vsimem/tiff_write_183_ref.tif', 'rb')
+            ref_data = gdal.VSIFReadL(1, 1000000, f)
+            gdal.VSIFCloseL(f)
+            f = gdal.VSIFOpenL('/vsimem/tiff_write_183.tif', 'rb')
+            data = gdal.VSIFReadL(1, 1000000, f)
+            gdal.VSIFCloseL(f)
+            if data != ref_data:
+                gdaltest.post_reason('fail')
+                print(options, max_mem)
+                return 'fail'
+    src_ds = None
+
+    # Lossless copy of a JPEG file
+    if gdal.GetDriverByName('JPEG') is not None:
+        src_ds = gdal.Open('../gdrivers/data/rgbsmall_rgb.jpg')
+        if src_ds is not None:
+            for options in [['TILED=YES', 'BLOCKXSIZE=16', 'BLOCKYSIZE=16'],
+                            ['BLOCKYSIZE=8']]:
+                gdaltest.tiff_drv.CreateCopy(
+                    '/vsimem/tiff_write_183_ref.tif', src_ds,
+                    options=['COMPRESS=JPEG'] + options)
+                gdaltest.tiff_drv.CreateCopy(
+                    '/vsimem/tiff_write_183.tif', src_ds,
+                    options=['COMPRESS=JPEG', 'NUM_THREADS=4'] + options)
+                ref_cs = gdal.Open('/vsimem/tiff_write_183_ref.tif'). \
+                    GetRasterBand(1).Checksum()
+                cs = gdal.Open('/vsimem/tiff_write_183.tif'). \
+                    GetRasterBand(1).Checksum()
+                if cs != ref_cs:
+                    gdaltest.post_reason('fail')
+                    print(options, cs, ref_cs)
+                    return 'fail'
+
+    gdaltest.tiff_drv.Delete('/vsimem/tiff_write_183_ref.tif')
+    gdaltest.tiff_drv.Delete('/vsimem/tiff_write_183.tif')
+
+    return 'success'
+
+###############################################################################
+# Test that MAX_Z_ERROR is honoured when writing through Create()
+
+
+def tiff_write_184_lerc_max_z_error_create():
+
+    md = gdaltest.tiff_drv.GetMetadata()
+    if md['DMD_CREATIONOPTIONLIST'].find('LERC') == -1:
+        return 'skip'
+
+    ut = gdaltest.GDALTest('GTiff', 'byte.tif', 1, 4529,
+                           options=['COMPRESS=LERC', 'MAX_Z_ERROR=1'])
+    return ut.testCreate(check_minmax=0)
+
 ###############################################################################
 # Ask to run again tests with GDAL_API_PROXY=YES
 
@@ -8640,6 +8720,8 @@ gdaltest_list = [
     tiff_write_180_lerc_separate,
     tiff_write_181_xmp,
     tiff_write_182_xmp_delete,
+    tiff_write_183_jpeg_num_threads,
+    tiff_write_184_lerc_max_z_error_create,
     # tiff_write_api_proxy,
     tiff_write_webp,
     tiff_write_tiled_webp,
@@ -1384,6 +1384,122 @@ dy           1
 
     return 'success'
 
+###############################################################################
+# Test a mosaic with many sources, that uses a spatial index of the sources
+
+
+def vrt_read_32():
+
+    # 12x12 tiles of 5x5 pixels, plus a last tile overlapping 4 other tiles
+    src_ds = gdal.GetDriverByName('MEM').Create('', 60, 60)
+    tile_filenames = []
+    for j in range(12):
+        for i in range(12):
+            filename = '/vsimem/vrt_read_32_%d_%d.tif' % (i, j)
+            tile_ds = gdal.GetDriverByName('GTiff').Create(filename, 5, 5)
+            tile_ds.SetGeoTransform([i * 5, 1, 0, -j * 5, 0, -1])
+            tile_ds.GetRasterBand(1).Fill(1 + i + j * 12)
+            src_ds.GetRasterBand(1).WriteRaster(
+                i * 5, j * 5, 5, 5, tile_ds.GetRasterBand(1).ReadRaster())
+            tile_ds = None
+            tile_filenames.append(filename)
+    filename = '/vsimem/vrt_read_32_overlap.tif'
+    tile_ds = gdal.GetDriverByName('GTiff').Create(filename, 4, 4)
+    tile_ds.SetGeoTransform([23, 1, 0, -23, 0, -1])
+    tile_ds.GetRasterBand(1).Fill(255)
+    src_ds.GetRasterBand(1).WriteRaster(
+        23, 23, 4, 4, tile_ds.GetRasterBand(1).ReadRaster())
+    tile_ds = None
+    tile_filenames.append(filename)
+
+    vrt_ds = gdal.BuildVRT('', tile_filenames)
+    if vrt_ds.RasterXSize != 60 or vrt_ds.RasterYSize != 60:
+        gdaltest.post_reason('fail')
+        return 'fail'
+
+    ret = 'success'
+    for (xoff, yoff, xsize, ysize) in [(0, 0, 60, 60), (22, 22, 6, 6),
+                                       (5, 5, 5, 5), (7, 31, 13, 1),
+                                       (59, 0, 1, 60)]:
+        got = vrt_ds.GetRasterBand(1).ReadRaster(xoff, yoff, xsize, ysize)
+        expected = src_ds.GetRasterBand(1).ReadRaster(xoff, yoff,
+                                                      xsize, ysize)
+        if got != expected:
+            gdaltest.post_reason('fail')
+            print(xoff, yoff, xsize, ysize)
+            ret = 'fail'
+        got = vrt_ds.ReadRaster(xoff, yoff, xsize, ysize)
+        if got != expected:
+            gdaltest.post_reason('fail')
+            print(xoff, yoff, xsize, ysize)
+            ret = 'fail'
+
+    # Subsampled request
+    got = vrt_ds.GetRasterBand(1).ReadRaster(0, 0, 60, 60, 30, 30)
+    expected = src_ds.GetRasterBand(1).ReadRaster(0, 0, 60, 60, 30, 30)
+    if got != expected:
+        gdaltest.post_reason('fail')
+        ret = 'fail'
+
+    (flags, pct) = vrt_ds.GetRasterBand(1).GetDataCoverageStatus(20, 20, 10, 10)
+    if flags != gdal.GDAL_DATA_COVERAGE_STATUS_DATA or pct != 100.0:
+        gdaltest.post_reason('fail')
+        print(flags, pct)
+        ret = 'fail'
+
+    vrt_ds = None
+    for filename in tile_filenames:
+        gdal.Unlink(filename)
+
+    return ret
+
+###############################################################################
+# Test multi-threaded compositing of the sources
+
+
+def vrt_read_33():
+
+    # 4x4 tiles, plus tiles overlapping others, that must be applied last
+    src_ds = gdal.GetDriverByName('MEM').Create('', 40, 40)
+    tile_filenames = []
+    tiles = [(i * 10, j * 10, 10, 10, 1 + i + j * 4)
+             for j in range(4) for i in range(4)]
+    tiles += [(5, 5, 10, 10, 100), (8, 8, 4, 4, 200), (30, 0, 10, 40, 250)]
+    for (idx, (xoff, yoff, xsize, ysize, val)) in enumerate(tiles):
+        filename = '/vsimem/vrt_read_33_%d.tif' % idx
+        tile_ds = gdal.GetDriverByName('GTiff').Create(filename, xsize, ysize)
+        tile_ds.SetGeoTransform([xoff, 1, 0, -yoff, 0, -1])
+        tile_ds.GetRasterBand(1).Fill(val)
+        src_ds.GetRasterBand(1).WriteRaster(
+            xoff, yoff, xsize, ysize, tile_ds.GetRasterBand(1).ReadRaster())
+        tile_ds = None
+        tile_filenames.append(filename)
+
+    vrt_ds = gdal.BuildVRT('', tile_filenames)
+
+    ret = 'success'
+    for num_threads in ['1', '4', 'ALL_CPUS']:
+        with gdaltest.config_option('VRT_NUM_THREADS', num_threads):
+            got = vrt_ds.GetRasterBand(1).ReadRaster()
+            got_subsampled = vrt_ds.GetRasterBand(1).ReadRaster(
+                0, 0, 40, 40, 13, 13, resample_alg=gdal.GRIORA_Bilinear)
+        if got != src_ds.GetRasterBand(1).ReadRaster():
+            gdaltest.post_reason('fail')
+            print(num_threads)
+            ret = 'fail'
+        if num_threads == '1':
+            ref_subsampled = got_subsampled
+        elif got_subsampled != ref_subsampled:
+            gdaltest.post_reason('fail')
+            print(num_threads)
+            ret = 'fail'
+
+    vrt_ds = None
+    for filename in tile_filenames:
+        gdal.Unlink(filename)
+
+    return ret
+
 
 for item in init_list:
     ut = gdaltest.GDALTest('VRT', item[0], item[1], item[2])
@@ -1423,6 +1539,8 @@ gdaltest_list.append(vrt_read_28)
 gdaltest_list.append(vrt_read_29)
 gdaltest_list.append(vrt_read_30)
 gdaltest_list.append(vrt_read_31)
+gdaltest_list.append(vrt_read_32)
+gdaltest_list.append(vrt_read_33)
 
 if __name__ == '__main__':
 
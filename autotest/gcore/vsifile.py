@@ -29,6 +29,7 @@
 # DEALINGS IN THE SOFTWARE.
 ###############################################################################
 
+import os
 import sys
 import time
 from osgeo import gdal
@@ -885,6 +886,119 @@ def vsitar_bug_675():
         return 'fail'
     return 'success'
 
+###############################################################################
+# Test persisting the listing of a tar archive, and ignoring it once the
+# archive has changed
+
+
+def vsitar_persisted_index():
+
+    import hashlib
+
+    index_dir = '/vsimem/vsitar_persisted_index_dir'
+
+    def index_filename(archive):
+        key = '/vsitar/' + archive
+        return index_dir + '/' + \
+            hashlib.sha256(key.encode('utf-8')).hexdigest().upper() + '.idx'
+
+    def read_file(filename):
+        f = gdal.VSIFOpenL(filename, 'rb')
+        if f is None:
+            return None
+        data = gdal.VSIFReadL(1, 100000, f)
+        gdal.VSIFCloseL(f)
+        return data
+
+    def write_file(filename, data):
+        f = gdal.VSIFOpenL(filename, 'wb')
+        gdal.VSIFWriteL(data, 1, len(data), f)
+        gdal.VSIFCloseL(f)
+
+    tar_content = open('data/byte.tar', 'rb').read()
+    archives = ['/vsimem/vsitar_persisted_index_%d.tar' % i
+                for i in range(4)]
+    for archive in archives:
+        gdal.FileFromMemBuffer(archive, tar_content)
+
+    ret = 'success'
+    with gdaltest.config_option('CPL_VSIL_ARCHIVE_INDEX_DIR', index_dir):
+        gdal.Mkdir(index_dir, 0o755)
+
+        # The listing is saved on first access
+        content = gdal.ReadDir('/vsitar/' + archives[0])
+        index = read_file(index_filename(archives[0]))
+        if content != ['byte.tif'] or index is None:
+            gdaltest.post_reason('fail')
+            print(content)
+            print(gdal.ReadDir(index_dir))
+            ret = 'fail'
+        index = index.decode('ascii') if index is not None else ''
+        if not index.startswith('GDAL_VSI_ARCHIVE_INDEX 1\n') or \
+           'byte.tif\t0\t736\t' not in index:
+            gdaltest.post_reason('fail')
+            print(index)
+            ret = 'fail'
+
+        def forged_index(archive, size_delta=0, mtime_delta=0):
+            stat = gdal.VSIStatL(archive)
+            lines = index.split('\n')
+            lines[1] = 'archive=' + archive.replace('/', '%2F')
+            lines[2] = 'size=%d' % (stat.size + size_delta)
+            lines[3] = 'mtime=%d' % (stat.mtime + mtime_delta)
+            return '\n'.join(lines).replace('byte.tif\t', 'persisted.tif\t')
+
+        # A saved listing matching the archive is used instead of
+        # scanning it
+        write_file(index_filename(archives[1]), forged_index(archives[1]))
+        content = gdal.ReadDir('/vsitar/' + archives[1])
+        if content != ['persisted.tif']:
+            gdaltest.post_reason('persisted index not used')
+            print(content)
+            ret = 'fail'
+        data = read_file('/vsitar/' + archives[1] + '/persisted.tif')
+        if data is None or len(data) != 736:
+            gdaltest.post_reason('fail')
+            ret = 'fail'
+
+        # but not when the modification time or the size of the archive
+        # have changed since it was saved, in which case it is rewritten
+        write_file(index_filename(archives[2]),
+                   forged_index(archives[2], mtime_delta=-10))
+        write_file(index_filename(archives[3]),
+                   forged_index(archives[3], size_delta=512))
+        for archive in archives[2:]:
+            content = gdal.ReadDir('/vsitar/' + archive)
+            if content != ['byte.tif']:
+                gdaltest.post_reason('stale index used')
+                print(archive)
+                print(content)
+                ret = 'fail'
+            new_index = read_file(index_filename(archive))
+            if new_index is None or \
+               b'byte.tif\t0\t736\t' not in new_index:
+                gdaltest.post_reason('stale index not rewritten')
+                print(new_index)
+                ret = 'fail'
+
+        # The listing of an archive opened with a relative path is keyed on
+        # its absolute path
+        gdal.ReadDir('/vsitar/./data/byte.tar')
+        abs_archive = os.path.join(os.getcwd(), 'data/byte.tar')
+        if read_file(index_filename(abs_archive)) is None or \
+           read_file(index_filename('data/byte.tar')) is not None:
+            gdaltest.post_reason('relative archive path not made absolute')
+            print(gdal.ReadDir(index_dir))
+            ret = 'fail'
+
+    for filename in gdal.ReadDir(index_dir) or []:
+        gdal.Unlink(index_dir + '/' + filename)
+    gdal.Rmdir(index_dir)
+    for archive in archives:
+        gdal.Unlink(archive)
+
+    return ret
+
 ###############################################################################
 # Test multithreaded compression
 
@@ -916,6 +1030,234 @@ def vsigzip_multi_thread():
 
     return 'success'
 
+###############################################################################
+# Helpers for the tests of multithreaded decompression
+
+
+def vsigzip_incompressible_data(size):
+
+    import hashlib
+
+    return b''.join([hashlib.md5(str(i).encode('ascii')).digest()
+                     for i in range((size + 15) // 16)])[0:size]
+
+
+def vsigzip_read_with_threads(filename, ops):
+
+    debug_msgs = []
+
+    def handler(err_type, err_no, err_msg):
+        if err_type == gdal.CE_Debug:
+            debug_msgs.append(err_msg)
+
+    gdal.PushErrorHandler(handler)
+    with gdaltest.config_options({'GDAL_NUM_THREADS': '4',
+                                  'CPL_DEBUG': 'ON'}):
+        f = gdal.VSIFOpenL('/vsigzip/' + filename, 'rb')
+        ret = ops(f)
+        gdal.VSIFCloseL(f)
+    gdal.PopErrorHandler()
+    return ret, debug_msgs
+
+
+def vsigzip_bgzf_member(payload):
+
+    import struct
+    import zlib
+
+    compressor = zlib.compressobj(6, zlib.DEFLATED, -15)
+    deflated = compressor.compress(payload) + compressor.flush()
+    header = struct.pack('<BBBBIBBHBBHH', 0x1f, 0x8b, 8, 4, 0, 0, 0xff,
+                         6, ord('B'), ord('C'), 2,
+                         len(deflated) + 25)
+    trailer = struct.pack('<II', zlib.crc32(payload) & 0xffffffff,
+                          len(payload))
+    return header + deflated + trailer
+
+###############################################################################
+# Test multithreaded decompression of a file with independent blocks
+
+
+def vsigzip_multi_thread_read_independent_blocks():
+
+    expected = vsigzip_incompressible_data(1500000)
+    with gdaltest.config_options({'GDAL_NUM_THREADS': 'ALL_CPUS',
+                                  'CPL_VSIL_DEFLATE_CHUNK_SIZE': '32K'}):
+        f = gdal.VSIFOpenL('/vsigzip//vsimem/vsigzip_multi_thread_read.gz', 'wb')
+        gdal.VSIFWriteL(expected, 1, len(expected), f)
+        gdal.VSIFCloseL(f)
+
+    def ops(f):
+        data = gdal.VSIFReadL(1, len(expected), f)
+        # Backward and forward seeks
+        gdal.VSIFSeekL(f, 12345, 0)
+        data_seek = gdal.VSIFReadL(1, 100000, f)
+        gdal.VSIFSeekL(f, 0, 2)
+        size = gdal.VSIFTellL(f)
+        return data, data_seek, size
+
+    (data, data_seek, size), debug_msgs = vsigzip_read_with_threads(
+        '/vsimem/vsigzip_multi_thread_read.gz', ops)
+
+    gdal.Unlink('/vsimem/vsigzip_multi_thread_read.gz')
+
+    if 'Using multi-threaded decompression (independent blocks)' not in debug_msgs:
+        gdaltest.post_reason('fail')
+        print(debug_msgs)
+        return 'fail'
+    if data != expected:
+        gdaltest.post_reason('fail')
+        return 'fail'
+    if data_seek != expected[12345:12345 + 100000]:
+        gdaltest.post_reason('fail')
+        return 'fail'
+    if size != len(expected):
+        gdaltest.post_reason('fail')
+        print(size)
+        return 'fail'
+
+    return 'success'
+
+###############################################################################
+# Test multithreaded decompression of a BGZF file
+
+
+def vsigzip_multi_thread_read_bgzf():
+
+    expected = b''
+    content = b''
+    for i in range(50):
+        payload = vsigzip_incompressible_data(20000 + i * 500)[i:]
+        expected += payload
+        content += vsigzip_bgzf_member(payload)
+    # Empty end-of-file member
+    content += vsigzip_bgzf_member(b'')
+
+    gdal.FileFromMemBuffer('/vsimem/vsigzip_multi_thread_read.gz', content)
+
+    def ops(f):
+        data = gdal.VSIFReadL(1, len(expected) + 1, f)
+        gdal.VSIFSeekL(f, 123456, 0)
+        data_seek = gdal.VSIFReadL(1, 100, f)
+        gdal.VSIFSeekL(f, 0, 2)
+        size = gdal.VSIFTellL(f)
+        return data, data_seek, size
+
+    (data, data_seek, size), debug_msgs = vsigzip_read_with_threads(
+        '/vsimem/vsigzip_multi_thread_read.gz', ops)
+
+    # Corrupt the CRC of the last non empty member
+    content = content[0:-36] + b'\0\0\0\0' + content[-32:]
+    gdal.FileFromMemBuffer('/vsimem/vsigzip_multi_thread_read.gz', content)
+    with gdaltest.error_handler():
+        data_corrupted, _ = vsigzip_read_with_threads(
+            '/vsimem/vsigzip_multi_thread_read.gz',
+            lambda f: gdal.VSIFReadL(1, len(expected), f))
+
+    gdal.Unlink('/vsimem/vsigzip_multi_thread_read.gz')
+
+    if 'Using multi-threaded decompression (BGZF)' not in debug_msgs:
+        gdaltest.post_reason('fail')
+        print(debug_msgs)
+        return 'fail'
+    if data != expected:
+        gdaltest.post_reason('fail')
+        return 'fail'
+    if data_seek != expected[123456:123456 + 100]:
+        gdaltest.post_reason('fail')
+        return 'fail'
+    if size != len(expected):
+        gdaltest.post_reason('fail')
+        print(size)
+        return 'fail'
+    if len(data_corrupted) == len(expected):
+        gdaltest.post_reason('fail')
+        return 'fail'
+
+    return 'success'
+
+###############################################################################
+# Test that concatenations of gzip members that do not all have the
+# structure needed for multithreaded decompression are read sequentially
+
+
+def vsigzip_multi_thread_read_multi_member():
+
+    import gzip
+    import io
+
+    def gzip_member(payload):
+        out = io.BytesIO()
+        g = gzip.GzipFile(fileobj=out, mode='wb')
+        g.write(payload)
+        g.close()
+        return out.getvalue()
+
+    part1 = vsigzip_incompressible_data(1200000)
+    part2 = vsigzip_incompressible_data(1000)[500:]
+    expected = part1 + part2
+
+    # Independent blocks, followed by a regular member: detected when
+    # uncompressing the end of the first member.
+    with gdaltest.config_options({'GDAL_NUM_THREADS': 'ALL_CPUS',
+                                  'CPL_VSIL_DEFLATE_CHUNK_SIZE': '32K'}):
+        f = gdal.VSIFOpenL('/vsigzip//vsimem/vsigzip_multi_member.gz', 'wb')
+        gdal.VSIFWriteL(part1, 1, len(part1), f)
+        gdal.VSIFCloseL(f)
+    f = gdal.VSIFOpenL('/vsimem/vsigzip_multi_member.gz', 'ab')
+    member = gzip_member(part2)
+    gdal.VSIFWriteL(member, 1, len(member), f)
+    gdal.VSIFCloseL(f)
+
+    def ops(f):
+        data = gdal.VSIFReadL(1, len(expected) + 1, f)
+        gdal.VSIFSeekL(f, 0, 2)
+        size = gdal.VSIFTellL(f)
+        return data, size
+
+    gdal.ErrorReset()
+    (data, size), debug_msgs = vsigzip_read_with_threads(
+        '/vsimem/vsigzip_multi_member.gz', ops)
+    if gdal.GetLastErrorMsg() != '':
+        gdaltest.post_reason('fail')
+        return 'fail'
+    if data != expected or size != len(expected):
+        gdaltest.post_reason('fail')
+        print(len(data), size)
+        return 'fail'
+    found = False
+    for msg in debug_msgs:
+        if msg.startswith('Falling back to sequential decompression'):
+            found = True
+    if not found:
+        gdaltest.post_reason('fail')
+        print(debug_msgs)
+        return 'fail'
+
+    # BGZF member, followed by a regular member: detected when probing
+    content = vsigzip_bgzf_member(part1[0:60000])
+    content += gzip_member(part1[60000:] + part2)
+    gdal.FileFromMemBuffer('/vsimem/vsigzip_multi_member.gz', content)
+    gdal.ErrorReset()
+    (data, size), debug_msgs = vsigzip_read_with_threads(
+        '/vsimem/vsigzip_multi_member.gz', ops)
+    if gdal.GetLastErrorMsg() != '':
+        gdaltest.post_reason('fail')
+        return 'fail'
+    if data != expected or size != len(expected):
+        gdaltest.post_reason('fail')
+        print(len(data), size)
+        return 'fail'
+    for msg in debug_msgs:
+        if msg.startswith('Using multi-threaded decompression'):
+            gdaltest.post_reason('fail')
+            print(debug_msgs)
+            return 'fail'
+
+    gdal.Unlink('/vsimem/vsigzip_multi_member.gz')
+
+    return 'success'
+
 gdaltest_list = [vsifile_1,
                  vsifile_2,
                  vsifile_3,
@@ -939,7 +1281,11 @@ gdaltest_list = [vsifile_1,
                  vsifile_21,
                  vsifile_22,
                  vsitar_bug_675,
-                 vsigzip_multi_thread]
+                 vsitar_persisted_index,
+                 vsigzip_multi_thread,
+                 vsigzip_multi_thread_read_independent_blocks,
+                 vsigzip_multi_thread_read_bgzf,
+                 vsigzip_multi_thread_read_multi_member]
 
 if __name__ == '__main__':
 
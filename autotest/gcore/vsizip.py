@@ -796,6 +796,53 @@ def vsizip_byte_zip64_local_header_zeroed():
 
     return 'success'
 
+###############################################################################
+# Test persisting the listing of an archive
+
+
+def vsizip_persisted_index():
+
+    fmain = gdal.VSIFOpenL('/vsizip//vsimem/vsizip_persisted_index.zip/subdir/foo.txt', 'wb')
+    gdal.VSIFWriteL('foo', 1, 3, fmain)
+    gdal.VSIFCloseL(fmain)
+
+    with gdaltest.config_option('CPL_VSIL_ARCHIVE_INDEX_DIR', '/vsimem/vsizip_persisted_index_dir'):
+        gdal.Mkdir('/vsimem/vsizip_persisted_index_dir', 0o755)
+        content = gdal.ReadDir('/vsizip//vsimem/vsizip_persisted_index.zip/subdir')
+        index_files = gdal.ReadDir('/vsimem/vsizip_persisted_index_dir')
+
+        f = gdal.VSIFOpenL('/vsizip//vsimem/vsizip_persisted_index.zip/subdir/foo.txt', 'rb')
+        data = gdal.VSIFReadL(1, 3, f)
+        gdal.VSIFCloseL(f)
+
+    index_content = None
+    if index_files is not None and len(index_files) == 1:
+        f = gdal.VSIFOpenL('/vsimem/vsizip_persisted_index_dir/' + index_files[0], 'rb')
+        index_content = gdal.VSIFReadL(1, 10000, f).decode('ascii')
+        gdal.VSIFCloseL(f)
+
+    gdal.Unlink('/vsimem/vsizip_persisted_index.zip')
+    for filename in index_files or []:
+        gdal.Unlink('/vsimem/vsizip_persisted_index_dir/' + filename)
+    gdal.Rmdir('/vsimem/vsizip_persisted_index_dir')
+
+    if content != ['foo.txt']:
+        gdaltest.post_reason('fail')
+        print(content)
+        return 'fail'
+    if data.decode('ascii') != 'foo':
+        gdaltest.post_reason('fail')
+        return 'fail'
+    if index_content is None or \
+       not index_content.startswith('GDAL_VSI_ARCHIVE_INDEX 1\n') or \
+       'subdir%2Ffoo.txt\t0\t3\t' not in index_content:
+        gdaltest.post_reason('fail')
+        print(index_files)
+        print(index_content)
+        return 'fail'
+
+    return 'success'
+
 gdaltest_list = [vsizip_1,
                  vsizip_2,
                  vsizip_3,
@@ -814,6 +861,7 @@ gdaltest_list = [vsizip_1,
                  vsizip_create_zip64,
                  vsizip_create_zip64_stream_larger_than_4G,
                  vsizip_byte_zip64_local_header_zeroed,
+                 vsizip_persisted_index,
                  ]
 
 
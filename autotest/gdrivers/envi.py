@@ -391,6 +391,48 @@ def envi_truncated():
     return 'success'
 
 
+###############################################################################
+# Test that reading from the memory mapping of the file gives the same result
+# as going through the block cache
+
+
+def envi_virtual_mem_io():
+
+    for interleave in ['BSQ', 'BIP', 'BIL']:
+        for byte_order in ['0', '1']:
+            filename = 'tmp/envi_virtual_mem_io.dat'
+            gdal.Translate(filename, 'data/rgbsmall.tif', format='ENVI',
+                           outputType=gdal.GDT_Int16,
+                           creationOptions=['INTERLEAVE=' + interleave])
+            gdal.Unlink(filename + '.aux.xml')
+            if byte_order == '1':
+                f = open('tmp/envi_virtual_mem_io.hdr', 'rt')
+                hdr = f.read()
+                f.close()
+                f = open('tmp/envi_virtual_mem_io.hdr', 'wt')
+                f.write(hdr.replace('byte order = 0', 'byte order = 1'))
+                f.close()
+
+            res = []
+            for option in ['NO', 'YES']:
+                with gdaltest.config_option('GDAL_RAW_VIRTUAL_MEM_IO', option):
+                    ds = gdal.Open(filename)
+                    res.append([
+                        ds.ReadRaster(),
+                        ds.ReadRaster(5, 7, 20, 10, band_list=[3, 1]),
+                        ds.GetRasterBand(2).ReadRaster(3, 4, 30, 20),
+                        ds.GetRasterBand(3).Checksum()])
+                    ds = None
+            gdal.GetDriverByName('ENVI').Delete(filename)
+
+            if res[0] != res[1]:
+                gdaltest.post_reason('fail')
+                print(interleave, byte_order)
+                return 'fail'
+
+    return 'success'
+
+
 gdaltest_list = [
     envi_1,
     envi_2,
@@ -408,6 +450,7 @@ gdaltest_list = [
     envi_14,
     envi_15,
     envi_truncated,
+    envi_virtual_mem_io,
 ]
 
 
@@ -695,6 +695,56 @@ def mrf_versioned():
     return 'success'
 
 
+def mrf_num_threads():
+
+    src_ds = gdal.Open('../gcore/data/rgbsmall.tif')
+    ext = {'PNG': 'ppg', 'JPEG': 'pjg', 'LERC': 'lrc'}
+    for comp in ['PNG', 'JPEG', 'LERC']:
+        if comp == 'LERC' and gdal.GetDriverByName('MRF').GetMetadataItem('DMD_CREATIONOPTIONLIST').find('LERC') < 0:
+            continue
+        for interleave in ['PIXEL', 'BAND']:
+            co = ['COMPRESS=' + comp, 'INTERLEAVE=' + interleave, 'BLOCKSIZE=16']
+            gdal.Translate('/vsimem/ref.mrf', src_ds, format='MRF', creationOptions=co)
+            gdal.Translate('/vsimem/out.mrf', src_ds, format='MRF',
+                           creationOptions=co + ['NUM_THREADS=4'])
+
+            # Pages are written in the same order
+            for e in ['idx', ext[comp]]:
+                f = gdal.VSIFOpenL('/vsimem/ref.' + e, 'rb')
+                ref_data = gdal.VSIFReadL(1, 1000000, f)
+                gdal.VSIFCloseL(f)
+                f = gdal.VSIFOpenL('/vsimem/out.' + e, 'rb')
+                data = gdal.VSIFReadL(1, 1000000, f)
+                gdal.VSIFCloseL(f)
+                if data != ref_data:
+                    gdaltest.post_reason('fail')
+                    print(comp, interleave, e)
+                    return 'fail'
+
+            # Batched reads, with and without worker threads
+            ref_data = [gdal.Open('/vsimem/ref.mrf').GetRasterBand(i + 1).ReadBlock(0, 0) for i in range(3)]
+            for options in [[], ['NUM_THREADS=4']]:
+                ds = gdal.OpenEx('/vsimem/out.mrf', open_options=options)
+                data = ds.ReadRaster()
+                band_data = ds.GetRasterBand(2).ReadRaster(3, 5, 40, 30)
+                block_data = [ds.GetRasterBand(i + 1).ReadBlock(0, 0) for i in range(3)]
+                ds = None
+                ds = gdal.Open('/vsimem/ref.mrf')
+                if data != ds.ReadRaster() or \
+                   band_data != ds.GetRasterBand(2).ReadRaster(3, 5, 40, 30) or \
+                   block_data != ref_data:
+                    gdaltest.post_reason('fail')
+                    print(comp, interleave, options)
+                    return 'fail'
+                ds = None
+
+            for name in ['ref', 'out']:
+                for e in ['mrf', 'mrf.aux.xml', 'idx', ext[comp]]:
+                    gdal.Unlink('/vsimem/' + name + '.' + e)
+
+    return 'success'
+
+
 def mrf_cleanup():
 
     files = [
@@ -791,6 +841,7 @@ gdaltest_list += [mrf_lerc_with_huffman]
 gdaltest_list += [mrf_cached_source]
 gdaltest_list += [mrf_versioned]
 gdaltest_list += [mrf_zen_test]
+gdaltest_list += [mrf_num_threads]
 gdaltest_list += [mrf_cleanup]
 
 if __name__ == '__main__':
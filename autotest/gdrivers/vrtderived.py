@@ -31,6 +31,7 @@
 
 import os
 import shutil
+import struct
 import sys
 import threading
 from osgeo import gdal
@@ -969,6 +970,183 @@ def vrtderived_15():
     return ret
 
 
+###############################################################################
+# Test PixelFunctionLanguage=Expression
+
+
+def vrtderived_16_eval(expr, values_b1, values_b2, nodata=None):
+
+    src_ds = gdal.GetDriverByName('GTiff').Create(
+        '/vsimem/vrtderived_16.tif', len(values_b1), 1, 2, gdal.GDT_Float64)
+    src_ds.GetRasterBand(1).WriteRaster(
+        0, 0, len(values_b1), 1, struct.pack('d' * len(values_b1), *values_b1))
+    src_ds.GetRasterBand(2).WriteRaster(
+        0, 0, len(values_b2), 1, struct.pack('d' * len(values_b2), *values_b2))
+    src_ds = None
+
+    nodata_elt = ''
+    if nodata is not None:
+        nodata_elt = '<NoDataValue>%s</NoDataValue>' % str(nodata)
+    sources = ''
+    for band in (1, 2):
+        sources += """<SimpleSource>
+      <SourceFilename>/vsimem/vrtderived_16.tif</SourceFilename>
+      <SourceBand>%d</SourceBand>
+    </SimpleSource>""" % band
+    ds = gdal.Open("""<VRTDataset rasterXSize="%d" rasterYSize="1">
+  <VRTRasterBand dataType="Float64" band="1" subClass="VRTDerivedRasterBand">
+    %s
+    <PixelFunctionLanguage>Expression</PixelFunctionLanguage>
+    <PixelFunctionCode><![CDATA[%s]]></PixelFunctionCode>
+    %s
+  </VRTRasterBand>
+</VRTDataset>""" % (len(values_b1), nodata_elt, expr, sources))
+    if ds is None:
+        gdal.Unlink('/vsimem/vrtderived_16.tif')
+        return None
+    ret = struct.unpack('d' * len(values_b1), ds.ReadRaster())
+    ds = None
+    gdal.Unlink('/vsimem/vrtderived_16.tif')
+    return ret
+
+
+def vrtderived_16():
+
+    b1 = [1, 2, 3, 4]
+    b2 = [4, 3, 2, 0]
+    tests = [
+        ('B1', [1, 2, 3, 4]),
+        ('b2', [4, 3, 2, 0]),
+        ('B1 + B2 * 2', [9, 8, 7, 4]),
+        ('(B1 + B2) * 2', [10, 10, 10, 8]),
+        ('-B1^2', [-1, -4, -9, -16]),
+        ('2^-1 + B1 % 2', [1.5, 0.5, 1.5, 0.5]),
+        ('B1 > B2', [0, 0, 1, 1]),
+        ('B1 >= 2 && B1 <= 3', [0, 1, 1, 0]),
+        ('B1 == 1 || !(B2 != 0)', [1, 0, 0, 1]),
+        ('B1 < B2 ? B1 : B2 * 10', [1, 2, 20, 0]),
+        ('if(B1 == 2, 100, B1)', [1, 100, 3, 4]),
+        ('min(B1, B2)', [1, 2, 2, 0]),
+        ('max(B1, B2, 3.5)', [4, 3.5, 3.5, 4]),
+        ('abs(B2 - B1)', [3, 1, 1, 4]),
+        ('sqrt(B1 * B1) + floor(0.5) + ceil(0.5) + round(1.4)', [3, 4, 5, 6]),
+        ('pow(B1, 2) + atan2(0, 1) + fmod(B1, 2)', [2, 4, 10, 16]),
+        ('log10(100) * exp(0) + log(1) + sin(0) + cos(0)', [3, 3, 3, 3]),
+        ('2 * 3 + 1', [7, 7, 7, 7]),
+        ('1e1 + .5', [10.5, 10.5, 10.5, 10.5]),
+    ]
+    for (expr, expected) in tests:
+        got = vrtderived_16_eval(expr, b1, b2)
+        if got is None or [abs(got[i] - expected[i]) < 1e-12 for i in range(4)] != [True] * 4:
+            gdaltest.post_reason('fail')
+            print(expr, got, expected)
+            return 'fail'
+
+    # Nodata semantics
+    nodata = -1
+    b1 = [1, -1, 0, -1, 5]
+    b2 = [2, 0, 0, 1, 0]
+    tests = [
+        # any arithmetic on nodata is nodata, as well as 0/0
+        ('B1 / B2', [0.5, -1, -1, -1, float('inf')]),
+        ('isnodata(B1)', [0, 1, 0, 1, 0]),
+        ('isnodata(B1) ? B2 : B1', [1, 0, 0, 1, 5]),
+        # comparisons with nodata are nodata, but "false && nodata" is false
+        # and "true || nodata" is true
+        ('B1 > 0', [1, -1, 0, -1, 1]),
+        ('B2 > 0 && B1 > 0', [1, 0, 0, -1, 0]),
+        ('B2 != 0 || B1 > 0', [1, -1, 0, 1, 1]),
+        ('B1 > 0 ? 10 : 20', [10, -1, 20, -1, 10]),
+        ('B2 > 1 ? nodata : B2', [-1, 0, 0, 1, 0]),
+        ('max(B1, B2)', [2, -1, 0, -1, 5]),
+    ]
+    for (expr, expected) in tests:
+        got = vrtderived_16_eval(expr, b1, b2, nodata)
+        if got is None or list(got) != expected:
+            gdaltest.post_reason('fail')
+            print(expr, got, expected)
+            return 'fail'
+
+    return 'success'
+
+###############################################################################
+# Test PixelFunctionLanguage=Expression errors and serialization
+
+
+def vrtderived_17():
+
+    for expr in ['', 'B1 +', '(B1', 'B1 B2', 'foo', 'foo(B1)', 'min(B1)',
+                 'pow(B1)', 'B0', 'B1 ? 1', '(' * 1000 + 'B1' + ')' * 1000]:
+        with gdaltest.error_handler():
+            ds = gdal.Open("""<VRTDataset rasterXSize="10" rasterYSize="10">
+  <VRTRasterBand dataType="Byte" band="1" subClass="VRTDerivedRasterBand">
+    <PixelFunctionLanguage>Expression</PixelFunctionLanguage>
+    <PixelFunctionCode><![CDATA[%s]]></PixelFunctionCode>
+  </VRTRasterBand>
+</VRTDataset>""" % expr)
+        if ds is not None:
+            gdaltest.post_reason('fail')
+            print(expr)
+            return 'fail'
+
+    # Reference to a missing source
+    ds = gdal.Open("""<VRTDataset rasterXSize="20" rasterYSize="20">
+  <VRTRasterBand dataType="Byte" band="1" subClass="VRTDerivedRasterBand">
+    <PixelFunctionLanguage>Expression</PixelFunctionLanguage>
+    <PixelFunctionCode>B1 + B2</PixelFunctionCode>
+    <SimpleSource>
+      <SourceFilename relativeToVRT="0">data/byte.tif</SourceFilename>
+      <SourceBand>1</SourceBand>
+    </SimpleSource>
+  </VRTRasterBand>
+</VRTDataset>""")
+    with gdaltest.error_handler():
+        cs = ds.GetRasterBand(1).Checksum()
+    if cs != 0 or gdal.GetLastErrorMsg().find('B2') < 0:
+        gdaltest.post_reason('fail')
+        print(cs, gdal.GetLastErrorMsg())
+        return 'fail'
+
+    # Creation through the API, and serialization
+    ds = gdal.GetDriverByName('VRT').Create('/vsimem/vrtderived_17.vrt',
+                                            20, 20, 0)
+    ds.AddBand(gdal.GDT_Byte, ['subclass=VRTDerivedRasterBand',
+                               'PixelFunctionLanguage=Expression',
+                               'PixelFunctionCode=B1 < 128 ? B1 : 255 - B1'])
+    ds.GetRasterBand(1).SetMetadataItem('source_0', """<SimpleSource>
+      <SourceFilename relativeToVRT="0">data/byte.tif</SourceFilename>
+      <SourceBand>1</SourceBand>
+    </SimpleSource>""", 'new_vrt_sources')
+    cs = ds.GetRasterBand(1).Checksum()
+    ds = None
+
+    ds = gdal.Open('/vsimem/vrtderived_17.vrt')
+    cs2 = ds.GetRasterBand(1).Checksum()
+    ds = None
+    content = gdal.VSIFOpenL('/vsimem/vrtderived_17.vrt', 'rb')
+    data = gdal.VSIFReadL(1, 10000, content).decode('ascii')
+    gdal.VSIFCloseL(content)
+    gdal.Unlink('/vsimem/vrtderived_17.vrt')
+
+    if data.find('<![CDATA[B1 < 128 ? B1 : 255 - B1]]>') < 0 or \
+       data.find('PixelFunctionType') >= 0:
+        gdaltest.post_reason('fail')
+        print(data)
+        return 'fail'
+
+    src_values = struct.unpack('B' * 400,
+                               gdal.Open('data/byte.tif').ReadRaster())
+    ref_ds = gdal.GetDriverByName('MEM').Create('', 20, 20)
+    ref_ds.WriteRaster(0, 0, 20, 20, struct.pack('B' * 400, *[
+        v if v < 128 else 255 - v for v in src_values]))
+    expected_cs = ref_ds.GetRasterBand(1).Checksum()
+    if cs != expected_cs or cs2 != expected_cs:
+        gdaltest.post_reason('fail')
+        print(cs, cs2, expected_cs)
+        return 'fail'
+
+    return 'success'
+
 ###############################################################################
 # Cleanup.
 
@@ -996,6 +1174,8 @@ gdaltest_list = [
     vrtderived_13,
     vrtderived_14,
     vrtderived_15,
+    vrtderived_16,
+    vrtderived_17,
     vrtderived_cleanup,
 ]
 
@@ -28,6 +28,7 @@
 ###############################################################################
 
 import os
+import struct
 import sys
 
 sys.path.append('../pymod')
@@ -2710,6 +2711,159 @@ def ogr_csv_iter_and_set_feature():
 
     return 'success'
 
+###############################################################################
+# Test CREATE SPATIAL INDEX / DROP SPATIAL INDEX and use of the .sidx file
+
+
+def ogr_csv_sidecar_spatial_index():
+
+    filename = '/vsimem/ogr_csv_sidecar_spatial_index.csv'
+    content = 'id,WKT\n'
+    for i in range(1000):
+        x = i % 40
+        y = i // 40
+        if i == 10:
+            content += '%d,\n' % i
+        else:
+            content += '%d,"POINT (%d %d)"\n' % (i, x, y)
+    gdal.FileFromMemBuffer(filename, content)
+
+    def get_ids(lyr):
+        lyr.SetSpatialFilterRect(9.5, 2.5, 12.5, 4.5)
+        ret = [int(f.GetField('id')) for f in lyr]
+        lyr.SetAttributeFilter("id > '100'")
+        lyr.ResetReading()
+        ret += [int(f.GetField('id')) for f in lyr]
+        lyr.SetAttributeFilter(None)
+        lyr.SetSpatialFilter(None)
+        return ret
+
+    ds = ogr.Open(filename)
+    lyr = ds.GetLayer(0)
+    if lyr.TestCapability(ogr.OLCFastSpatialFilter):
+        gdaltest.post_reason('fail')
+        return 'fail'
+    expected_ids = get_ids(lyr)
+    if expected_ids != [130, 131, 132, 170, 171, 172,
+                        130, 131, 132, 170, 171, 172]:
+        gdaltest.post_reason('fail')
+        print(expected_ids)
+        return 'fail'
+    ds.ExecuteSQL('CREATE SPATIAL INDEX ON ogr_csv_sidecar_spatial_index')
+    ds = None
+
+    if gdal.VSIStatL(filename + '.sidx') is None:
+        gdaltest.post_reason('fail')
+        return 'fail'
+
+    ds = ogr.Open(filename)
+    lyr = ds.GetLayer(0)
+    if not lyr.TestCapability(ogr.OLCFastSpatialFilter):
+        gdaltest.post_reason('fail')
+        return 'fail'
+    if get_ids(lyr) != expected_ids:
+        gdaltest.post_reason('fail')
+        print(get_ids(lyr))
+        return 'fail'
+    if lyr.GetFeatureCount() != 1000:
+        gdaltest.post_reason('fail')
+        return 'fail'
+    ds = None
+
+    # Disabled index
+    with gdaltest.config_option('OGR_SIDECAR_SPATIAL_INDEX', 'NO'):
+        ds = ogr.Open(filename)
+        lyr = ds.GetLayer(0)
+        if lyr.TestCapability(ogr.OLCFastSpatialFilter):
+            gdaltest.post_reason('fail')
+            return 'fail'
+        ds = None
+
+    ds = ogr.Open(filename)
+    ds.ExecuteSQL('DROP SPATIAL INDEX ON ogr_csv_sidecar_spatial_index')
+    with gdaltest.error_handler():
+        ds.ExecuteSQL('DROP SPATIAL INDEX ON ogr_csv_sidecar_spatial_index')
+    if gdal.GetLastErrorMsg() == '':
+        gdaltest.post_reason('fail')
+        return 'fail'
+    ds = None
+
+    if gdal.VSIStatL(filename + '.sidx') is not None:
+        gdaltest.post_reason('fail')
+        return 'fail'
+
+    # Creation of the index on first use
+    with gdaltest.config_option('OGR_SIDECAR_SPATIAL_INDEX', 'BUILD'):
+        ds = ogr.Open(filename)
+        lyr = ds.GetLayer(0)
+        if get_ids(lyr) != expected_ids:
+            gdaltest.post_reason('fail')
+            return 'fail'
+        ds = None
+    if gdal.VSIStatL(filename + '.sidx') is None:
+        gdaltest.post_reason('fail')
+        return 'fail'
+
+    # Index with corrupted child references
+    f = gdal.VSIFOpenL(filename + '.sidx', 'rb')
+    sidx = gdal.VSIFReadL(1, 1000000, f)
+    gdal.VSIFCloseL(f)
+    item_count = struct.unpack('<Q', sidx[32:40])[0]
+    root_ref_pos = len(sidx) - item_count * 8 - 8
+    corrupted = sidx[0:root_ref_pos] + struct.pack('<Q', 1 << 40) + \
+        sidx[root_ref_pos + 8:]
+    gdal.FileFromMemBuffer(filename + '.sidx', corrupted)
+    ds = ogr.Open(filename)
+    lyr = ds.GetLayer(0)
+    if lyr.TestCapability(ogr.OLCFastSpatialFilter):
+        gdaltest.post_reason('corrupted index should be ignored')
+        return 'fail'
+    if get_ids(lyr) != expected_ids:
+        gdaltest.post_reason('fail')
+        return 'fail'
+    ds = None
+    gdal.FileFromMemBuffer(filename + '.sidx', sidx)
+
+    # Index made stale by a modification of the data file
+    content += '1000,"POINT (11 3)"\n'
+    gdal.FileFromMemBuffer(filename, content)
+    expected_ids = [130, 131, 132, 170, 171, 172, 1000,
+                    130, 131, 132, 170, 171, 172, 1000]
+    ds = ogr.Open(filename)
+    lyr = ds.GetLayer(0)
+    if lyr.TestCapability(ogr.OLCFastSpatialFilter):
+        gdaltest.post_reason('stale index should be ignored')
+        return 'fail'
+    if get_ids(lyr) != expected_ids:
+        gdaltest.post_reason('fail')
+        print(get_ids(lyr))
+        return 'fail'
+    ds = None
+
+    # and rebuilt on first use
+    with gdaltest.config_option('OGR_SIDECAR_SPATIAL_INDEX', 'BUILD'):
+        ds = ogr.Open(filename)
+        lyr = ds.GetLayer(0)
+        if get_ids(lyr) != expected_ids:
+            gdaltest.post_reason('fail')
+            return 'fail'
+        ds = None
+    ds = ogr.Open(filename)
+    lyr = ds.GetLayer(0)
+    if not lyr.TestCapability(ogr.OLCFastSpatialFilter):
+        gdaltest.post_reason('index should have been rebuilt')
+        return 'fail'
+    if get_ids(lyr) != expected_ids:
+        gdaltest.post_reason('fail')
+        print(get_ids(lyr))
+        return 'fail'
+    ds = None
+
+    gdal.Unlink(filename + '.sidx')
+    gdal.Unlink(filename)
+
+    return 'success'
+
 ###############################################################################
 #
 
@@ -2798,6 +2952,7 @@ gdaltest_list = [
     ogr_csv_string_quoting_if_ambiguous,
     ogr_csv_string_quoting_if_needed,
     ogr_csv_iter_and_set_feature,
+    ogr_csv_sidecar_spatial_index,
     ogr_csv_cleanup]
 
 if __name__ == '__main__':
@@ -27,11 +27,13 @@
 ###############################################################################
 
 import os
+import shutil
 import sys
 
 sys.path.append('../pymod')
 
 import gdaltest
+from osgeo import gdal
 from osgeo import ogr
 import ogrtest
 
@@ -177,7 +179,7 @@ def ogr_index_6():
 
 
 ###############################################################################
-# Check that range query that isn't currently implemented using index works.
+# Check that range query works.
 
 
 def ogr_index_7():
@@ -229,54 +231,47 @@ def ogr_index_9():
 
     gdaltest.s_ds.Release()
 
-    # After dataset closing, check that the index files do not exist after
+    # After dataset closing, check that the index file does not exist after
     # dropping the index
-    for filename in ['join_t.idm', 'join_t.ind']:
-        try:
-            os.stat(filename)
-            gdaltest.post_reason("%s should not exist" % filename)
-            return 'fail'
-        except OSError:
-            pass
+    try:
+        os.stat('join_t.oai')
+        gdaltest.post_reason("join_t.oai should not exist")
+        return 'fail'
+    except OSError:
+        pass
 
     # Re-create an index
     gdaltest.s_ds = ogr.OpenShared('join_t.dbf', update=1)
     gdaltest.s_ds.ExecuteSQL('CREATE INDEX ON join_t USING value')
     gdaltest.s_ds.Release()
 
-    for filename in ['join_t.idm', 'join_t.ind']:
-        try:
-            os.stat(filename)
-        except OSError:
-            gdaltest.post_reason("%s should exist" % filename)
-            return 'fail'
+    try:
+        os.stat('join_t.oai')
+    except OSError:
+        gdaltest.post_reason("join_t.oai should exist")
+        return 'fail'
 
-    f = open('join_t.idm', 'rt')
-    xml = f.read()
+    f = open('join_t.oai', 'rb')
+    data = f.read()
     f.close()
-    if xml.find('VALUE') == -1:
+    if data.find(b'VALUE') == -1:
         gdaltest.post_reason('VALUE column is not indexed (1)')
-        print(xml)
         return 'fail'
 
     # Close the dataset and re-open
     gdaltest.s_ds = ogr.OpenShared('join_t.dbf', update=1)
-    # At this point the .ind was opened in read-only. Now it
-    # will be re-opened in read-write mode
     gdaltest.s_ds.ExecuteSQL('CREATE INDEX ON join_t USING skey')
 
     gdaltest.s_ds.Release()
 
-    f = open('join_t.idm', 'rt')
-    xml = f.read()
+    f = open('join_t.oai', 'rb')
+    data = f.read()
     f.close()
-    if xml.find('VALUE') == -1:
+    if data.find(b'VALUE') == -1:
         gdaltest.post_reason('VALUE column is not indexed (2)')
-        print(xml)
         return 'fail'
-    if xml.find('SKEY') == -1:
+    if data.find(b'SKEY') == -1:
         gdaltest.post_reason('SKEY column is not indexed (2)')
-        print(xml)
         return 'fail'
 
     return 'success'
@@ -489,6 +484,153 @@ def ogr_index_11():
     return 'success'
 
 ###############################################################################
+# Test range, BETWEEN, LIKE prefix and compound index lookups, checked
+# against the results without index.
+
+
+def ogr_index_12():
+
+    ds = ogr.GetDriverByName('ESRI Shapefile').CreateDataSource('tmp/ogr_index_12.dbf')
+    lyr = ds.CreateLayer('ogr_index_12', geom_type=ogr.wkbNone)
+    lyr.CreateField(ogr.FieldDefn('intfield', ogr.OFTInteger))
+    lyr.CreateField(ogr.FieldDefn('realfield', ogr.OFTReal))
+    lyr.CreateField(ogr.FieldDefn('strfield', ogr.OFTString))
+    lyr.CreateField(ogr.FieldDefn('catfield', ogr.OFTString))
+
+    names = ['Alpha', 'alpine', 'Beta', 'bet', 'gam_ma', 'Gamma']
+    for i in range(1000):
+        feat = ogr.Feature(lyr.GetLayerDefn())
+        feat.SetField(0, (i * 37) % 101 - 50)
+        if i % 13 != 0:
+            feat.SetField(1, ((i * 17) % 1000) / 10.0 - 50)
+        feat.SetField(2, '%s%d' % (names[i % len(names)], i % 7))
+        feat.SetField(3, 'ABCD'[i % 4])
+        lyr.CreateFeature(feat)
+    ds = None
+
+    filters = ["intfield > 45",
+               "intfield >= 45.5",
+               "-48 >= intfield",
+               "intfield BETWEEN -3 AND 2",
+               "intfield BETWEEN 1.5 AND 1.7",
+               "intfield = 2.5",
+               "intfield IN (1, 2, 1000)",
+               "realfield < -45",
+               "realfield BETWEEN 0 AND 1",
+               "strfield LIKE 'alp%'",
+               "strfield LIKE 'GAM_M%'",
+               "strfield LIKE 'gam#_m%' ESCAPE '#'",
+               "strfield >= 'beta' AND strfield < 'beta3'",
+               "catfield = 'B' AND intfield = 7",
+               "catfield = 'C' AND intfield > 40",
+               "catfield = 'A' AND intfield BETWEEN 0 AND 10 AND strfield LIKE 'Al%'",
+               "catfield = 'D' OR intfield < -45",
+               "intfield = 7 AND realfield IS NULL"]
+
+    ds = ogr.Open('tmp/ogr_index_12.dbf', update=1)
+    lyr = ds.GetLayer(0)
+    expected = []
+    for f in filters:
+        lyr.SetAttributeFilter(f)
+        expected.append([feat.GetFID() for feat in lyr])
+
+    ds.ExecuteSQL('CREATE INDEX ON ogr_index_12 USING intfield')
+    ds.ExecuteSQL('CREATE INDEX ON ogr_index_12 USING realfield')
+    ds.ExecuteSQL('CREATE INDEX ON ogr_index_12 USING strfield')
+    ds.ExecuteSQL('CREATE INDEX ON ogr_index_12 USING catfield, intfield')
+    ds = None
+
+    for i in range(2):
+        ds = ogr.Open('tmp/ogr_index_12.dbf', update=1)
+        lyr = ds.GetLayer(0)
+        if i == 1:
+            ds.ExecuteSQL('DROP INDEX ON ogr_index_12 USING intfield')
+        for f, expected_fids in zip(filters, expected):
+            lyr.SetAttributeFilter(f)
+            got_fids = [feat.GetFID() for feat in lyr]
+            if got_fids != expected_fids:
+                gdaltest.post_reason('failed')
+                print(f, got_fids, expected_fids)
+                return 'fail'
+
+        ds = None
+
+    ds = ogr.Open('tmp/ogr_index_12.dbf', update=1)
+    with gdaltest.error_handler():
+        ds.ExecuteSQL('CREATE INDEX ON ogr_index_12 USING catfield, intfield')
+    if gdal.GetLastErrorMsg() == '':
+        gdaltest.post_reason('expected error on duplicated index')
+        return 'fail'
+    with gdaltest.error_handler():
+        ds.ExecuteSQL('CREATE INDEX ON ogr_index_12 USING missing')
+    if gdal.GetLastErrorMsg() == '':
+        gdaltest.post_reason('expected error on missing field')
+        return 'fail'
+    ds.ExecuteSQL('DROP INDEX ON ogr_index_12')
+    ds = None
+
+    try:
+        os.stat('tmp/ogr_index_12.oai')
+        gdaltest.post_reason("tmp/ogr_index_12.oai should not exist")
+        return 'fail'
+    except OSError:
+        pass
+
+    return 'success'
+
+###############################################################################
+# Test that an index in the legacy MapInfo format (.idm/.ind pair) is still
+# used when there is no .oai index.
+
+
+def ogr_index_13():
+
+    for ext in ('shp', 'shx', 'dbf', 'idm', 'ind'):
+        shutil.copy('data/testpoly.' + ext, 'tmp/testpoly.' + ext)
+
+    debug_msgs = []
+
+    def handler(err_type, err_no, err_msg):
+        if err_type == gdal.CE_Debug:
+            debug_msgs.append(err_msg)
+
+    ds = ogr.Open('tmp/testpoly.shp')
+    lyr = ds.GetLayer(0)
+    gdal.PushErrorHandler(handler)
+    gdal.SetConfigOption('CPL_DEBUG', 'ON')
+    lyr.SetAttributeFilter('FID = 5')
+    got_fids = [f.GetFID() for f in lyr]
+    gdal.SetConfigOption('CPL_DEBUG', None)
+    gdal.PopErrorHandler()
+    ds = None
+
+    ret = 'success'
+    if got_fids != [5]:
+        gdaltest.post_reason('failed')
+        print(got_fids)
+        ret = 'fail'
+
+    found = False
+    for msg in debug_msgs:
+        if msg.startswith('Restored 1 field indexes for layer testpoly') and \
+           msg.endswith('testpoly.ind.'):
+            found = True
+    if not found:
+        gdaltest.post_reason('legacy index not used')
+        print(debug_msgs)
+        ret = 'fail'
+
+    if os.path.exists('tmp/testpoly.oai'):
+        gdaltest.post_reason('tmp/testpoly.oai should not exist')
+        ret = 'fail'
+
+    ogr.GetDriverByName('ESRI Shapefile').DeleteDataSource('tmp/testpoly.shp')
+    for ext in ('idm', 'ind'):
+        gdal.Unlink('tmp/testpoly.' + ext)
+
+    return ret
+
+###############################################################################
 
 
 def ogr_index_cleanup():
@@ -506,18 +648,19 @@ def ogr_index_cleanup():
     ogr.GetDriverByName('MapInfo File').DeleteDataSource('index_p.mif')
     ogr.GetDriverByName('ESRI Shapefile').DeleteDataSource('join_t.dbf')
 
-    for filename in ['join_t.idm', 'join_t.ind']:
-        try:
-            os.stat(filename)
-            gdaltest.post_reason("%s should not exist" % filename)
-            return 'fail'
-        except OSError:
-            pass
+    try:
+        os.stat('join_t.oai')
+        gdaltest.post_reason("join_t.oai should not exist")
+        return 'fail'
+    except OSError:
+        pass
 
     ogr.GetDriverByName('ESRI Shapefile').DeleteDataSource(
         'tmp/ogr_index_10.shp')
     ogr.GetDriverByName('ESRI Shapefile').DeleteDataSource(
         'tmp/ogr_index_11.dbf')
+    ogr.GetDriverByName('ESRI Shapefile').DeleteDataSource(
+        'tmp/ogr_index_12.dbf')
 
     return 'success'
 
@@ -534,6 +677,8 @@ gdaltest_list = [
     ogr_index_9,
     ogr_index_10,
     ogr_index_11,
+    ogr_index_12,
+    ogr_index_13,
     ogr_index_cleanup]
 
 if __name__ == '__main__':
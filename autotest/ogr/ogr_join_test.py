@@ -531,6 +531,208 @@ def ogr_join_23():
     return 'success'
 
 ###############################################################################
+# Test hash join, compared to per-feature evaluation of the join, with
+# compound, case insensitive, duplicated and NULL keys, and spilling to disk
+
+
+def ogr_join_24():
+
+    ds = ogr.GetDriverByName('Memory').CreateDataSource('')
+    lyr = ds.CreateLayer('first')
+    lyr.CreateField(ogr.FieldDefn('id', ogr.OFTInteger))
+    lyr.CreateField(ogr.FieldDefn('k1', ogr.OFTString))
+    lyr.CreateField(ogr.FieldDefn('k2', ogr.OFTInteger))
+    for i in range(200):
+        f = ogr.Feature(lyr.GetLayerDefn())
+        f['id'] = i
+        if i % 17 != 0:
+            f['k1'] = ('A%d' if i % 2 else 'a%d') % (i % 40)
+        f['k2'] = i % 3
+        lyr.CreateFeature(f)
+
+    lyr = ds.CreateLayer('second')
+    lyr.CreateField(ogr.FieldDefn('k1', ogr.OFTString))
+    lyr.CreateField(ogr.FieldDefn('k2', ogr.OFTInteger64))
+    lyr.CreateField(ogr.FieldDefn('val', ogr.OFTString))
+    for i in range(30):
+        for j in range(3):
+            for dup in range(2):
+                f = ogr.Feature(lyr.GetLayerDefn())
+                f['k1'] = 'A%d' % i
+                f['k2'] = j
+                f['val'] = '%d_%d_%d' % (i, j, dup)
+                lyr.CreateFeature(f)
+    f = ogr.Feature(lyr.GetLayerDefn())
+    f['k2'] = 0
+    f['val'] = 'null_key'
+    lyr.CreateFeature(f)
+
+    sql = ("SELECT first.id, second.val FROM first LEFT JOIN second "
+           "ON first.k1 = second.k1 AND second.k2 = first.k2 "
+           "AND second.val NOT LIKE '%_0_0'")
+
+    results = []
+    for (hash_join, max_memory) in [('NO', None), ('YES', None),
+                                    ('YES', '0.0001')]:
+        with gdaltest.config_options({'OGR_SQL_HASH_JOIN': hash_join,
+                                      'OGR_SQL_MAX_MEMORY': max_memory}):
+            sql_lyr = ds.ExecuteSQL(sql)
+            results.append([(f['id'], f['val']) for f in sql_lyr])
+            ds.ReleaseResultSet(sql_lyr)
+
+    ds = None
+
+    expected = results[0]
+    if len(expected) != 200 or \
+       len([x for x in expected if x[1] is not None]) != 141 or \
+       (0, None) not in expected or (41, '1_2_0') not in expected or \
+       (120, '0_0_1') not in expected:
+        gdaltest.post_reason('fail')
+        print(expected)
+        return 'fail'
+    for res in results[1:]:
+        if res != expected:
+            gdaltest.post_reason('fail')
+            print(res)
+            return 'fail'
+
+    return 'success'
+
+###############################################################################
+# Test that the hash join gives the same results as the per-feature evaluation
+# for timestamp-like string keys, and that it sees the modifications of the
+# secondary layer after ResetReading()
+
+
+def ogr_join_25():
+
+    ds = ogr.GetDriverByName('Memory').CreateDataSource('')
+    lyr = ds.CreateLayer('first')
+    lyr.CreateField(ogr.FieldDefn('id', ogr.OFTInteger))
+    lyr.CreateField(ogr.FieldDefn('k', ogr.OFTString))
+    for i, k in enumerate(['2018/01/01 10:00:00', '2018/01/01 11:00:00+00',
+                           'foo', 'bar']):
+        f = ogr.Feature(lyr.GetLayerDefn())
+        f['id'] = i
+        f['k'] = k
+        lyr.CreateFeature(f)
+
+    second_lyr = ds.CreateLayer('second')
+    second_lyr.CreateField(ogr.FieldDefn('k', ogr.OFTString))
+    second_lyr.CreateField(ogr.FieldDefn('val', ogr.OFTString))
+    for k, val in [('2018/01/01 10:00:00+00', 'ten'),
+                   ('2018/01/01 11:00:00', 'eleven'),
+                   ('FOO', 'foo')]:
+        f = ogr.Feature(second_lyr.GetLayerDefn())
+        f['k'] = k
+        f['val'] = val
+        second_lyr.CreateFeature(f)
+
+    sql = ("SELECT first.id, second.val FROM first LEFT JOIN second "
+           "ON first.k = second.k")
+
+    results = []
+    for hash_join in ['NO', 'YES']:
+        with gdaltest.config_option('OGR_SQL_HASH_JOIN', hash_join):
+            sql_lyr = ds.ExecuteSQL(sql)
+            results.append([(f['id'], f['val']) for f in sql_lyr])
+            ds.ReleaseResultSet(sql_lyr)
+    expected = [(0, 'ten'), (1, 'eleven'), (2, 'foo'), (3, None)]
+    if results != [expected, expected]:
+        gdaltest.post_reason('fail')
+        print(results)
+        return 'fail'
+
+    # Without timestamp-like keys, so that the hash join is used
+    third_lyr = ds.CreateLayer('third')
+    third_lyr.CreateField(ogr.FieldDefn('k', ogr.OFTString))
+    third_lyr.CreateField(ogr.FieldDefn('val', ogr.OFTString))
+    f = ogr.Feature(third_lyr.GetLayerDefn())
+    f['k'] = 'FOO'
+    f['val'] = 'foo'
+    third_lyr.CreateFeature(f)
+
+    sql = ("SELECT first.id, third.val FROM first LEFT JOIN third "
+           "ON first.k = third.k WHERE first.id >= 2")
+    sql_lyr = ds.ExecuteSQL(sql)
+    res = [(f['id'], f['val']) for f in sql_lyr]
+    if res != [(2, 'foo'), (3, None)]:
+        gdaltest.post_reason('fail')
+        print(res)
+        ds.ReleaseResultSet(sql_lyr)
+        return 'fail'
+
+    f = ogr.Feature(third_lyr.GetLayerDefn())
+    f['k'] = 'bar'
+    f['val'] = 'bar'
+    third_lyr.CreateFeature(f)
+
+    sql_lyr.ResetReading()
+    res = [(f['id'], f['val']) for f in sql_lyr]
+    ds.ReleaseResultSet(sql_lyr)
+    if res != [(2, 'foo'), (3, 'bar')]:
+        gdaltest.post_reason('fail')
+        print(res)
+        return 'fail'
+
+    ds = None
+
+    return 'success'
+
+###############################################################################
+# Test that string keys are not hashed when the secondary layer evaluates its
+# attribute filter natively, with a case sensitive equality
+
+
+def ogr_join_26():
+
+    drv = ogr.GetDriverByName('GPKG')
+    if drv is None:
+        return 'skip'
+
+    filename = '/vsimem/ogr_join_26.gpkg'
+    ds = drv.CreateDataSource(filename)
+    lyr = ds.CreateLayer('first', geom_type=ogr.wkbNone)
+    lyr.CreateField(ogr.FieldDefn('id', ogr.OFTInteger))
+    lyr.CreateField(ogr.FieldDefn('k', ogr.OFTString))
+    for i, k in enumerate(['abc', 'ABC', 'Abc2', '2018/01/01 10:00:00']):
+        f = ogr.Feature(lyr.GetLayerDefn())
+        f['id'] = i
+        f['k'] = k
+        lyr.CreateFeature(f)
+
+    lyr = ds.CreateLayer('second', geom_type=ogr.wkbNone)
+    lyr.CreateField(ogr.FieldDefn('k', ogr.OFTString))
+    lyr.CreateField(ogr.FieldDefn('val', ogr.OFTString))
+    for k, val in [('abc', 'lower'), ('ABC2', 'upper'),
+                   ('2018/01/01 10:00:00', 'ten')]:
+        f = ogr.Feature(lyr.GetLayerDefn())
+        f['k'] = k
+        f['val'] = val
+        lyr.CreateFeature(f)
+
+    sql = ("SELECT first.id, second.val FROM first LEFT JOIN second "
+           "ON first.k = second.k")
+
+    results = []
+    for hash_join in ['NO', 'YES']:
+        with gdaltest.config_option('OGR_SQL_HASH_JOIN', hash_join):
+            sql_lyr = ds.ExecuteSQL(sql, dialect='OGRSQL')
+            results.append([(f['id'], f['val']) for f in sql_lyr])
+            ds.ReleaseResultSet(sql_lyr)
+
+    ds = None
+    gdal.Unlink(filename)
+
+    expected = [(0, 'lower'), (1, None), (2, None), (3, 'ten')]
+    if results != [expected, expected]:
+        gdaltest.post_reason('fail')
+        print(results)
+        return 'fail'
+
+    return 'success'
+
+###############################################################################
 
 
 def ogr_join_cleanup():
@@ -564,6 +766,9 @@ gdaltest_list = [
     ogr_join_21,
     ogr_join_22,
     ogr_join_23,
+    ogr_join_24,
+    ogr_join_25,
+    ogr_join_26,
     ogr_join_cleanup]
 
 if __name__ == '__main__':
@@ -684,6 +684,67 @@ def algebra_erase():
     return 'success'
 
 
+###############################################################################
+# Test that running the overlay methods with several threads, with and without
+# a spatial filter on the method layer, gives the same result as with one thread.
+
+def algebra_num_threads():
+    if not ogrtest.have_geos():
+        return 'skip'
+
+    wrk_ds = ogr.GetDriverByName('Memory').CreateDataSource('wrk')
+
+    lyr_input = wrk_ds.CreateLayer('input')
+    lyr_input.CreateField(ogr.FieldDefn('A', ogr.OFTInteger))
+    lyr_method = wrk_ds.CreateLayer('method')
+    lyr_method.CreateField(ogr.FieldDefn('B', ogr.OFTInteger))
+    for i in range(20):
+        for j in range(20):
+            feat = ogr.Feature(lyr_input.GetLayerDefn())
+            feat.SetField('A', i * 20 + j)
+            feat.SetGeometryDirectly(ogr.Geometry(wkt='POLYGON((%d %d,%d %d,%d %d,%d %d,%d %d))' % (
+                i, j, i, j + 1.5, i + 1.5, j + 1.5, i + 1.5, j, i, j)))
+            lyr_input.CreateFeature(feat)
+            feat = ogr.Feature(lyr_method.GetLayerDefn())
+            feat.SetField('B', i * 20 + j)
+            feat.SetGeometryDirectly(ogr.CreateGeometryFromWkt('POINT(%f %f)' % (i + 0.3, j + 0.7)).Buffer(0.8, 4))
+            lyr_method.CreateFeature(feat)
+
+    def dump(lyr):
+        ret = []
+        for f in lyr:
+            ret.append((f.GetFieldCount(), [f.GetField(i) for i in range(f.GetFieldCount())],
+                        f.GetGeometryRef().ExportToWkt()))
+        return ret
+
+    for spatial_filter in [None, 'POLYGON ((3 3,3 12,15 12,15 3,3 3))']:
+        if spatial_filter:
+            lyr_method.SetSpatialFilter(ogr.CreateGeometryFromWkt(spatial_filter))
+        for method in ['Intersection', 'Union', 'SymDifference', 'Identity',
+                       'Update', 'Clip', 'Erase']:
+            results = []
+            for num_threads in ['1', '4']:
+                lyr_result = wrk_ds.CreateLayer('result')
+                err = getattr(lyr_input, method)(lyr_method, lyr_result,
+                                                 options=['NUM_THREADS=' + num_threads])
+                if err != 0:
+                    gdaltest.post_reason('got non-zero result code ' + str(err) + ' from Layer.' + method)
+                    return 'fail'
+                results.append(dump(lyr_result))
+                wrk_ds.DeleteLayer('result')
+            if not results[0] or results[0] != results[1]:
+                gdaltest.post_reason('fail')
+                print(method, spatial_filter, len(results[0]), len(results[1]))
+                return 'fail'
+        if spatial_filter:
+            if lyr_method.GetSpatialFilter().ExportToWkt() != spatial_filter:
+                gdaltest.post_reason('spatial filter of method layer not preserved')
+                return 'fail'
+            lyr_method.SetSpatialFilter(None)
+
+    return 'success'
+
+
 def algebra_cleanup():
     if not ogrtest.have_geos():
         return 'skip'
@@ -712,6 +773,7 @@ gdaltest_list = [
     algebra_update,
     algebra_clip,
     algebra_erase,
+    algebra_num_threads,
     algebra_cleanup,
 ]
 
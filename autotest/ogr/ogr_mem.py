@@ -838,6 +838,45 @@ def ogr_mem_17():
     return 'success'
 
 
+###############################################################################
+# Test a polygonal spatial filter on point geometries, which does not need
+# GEOS.
+
+
+def ogr_mem_18():
+
+    ds = gdal.GetDriverByName('Memory').Create('', 0, 0, 0, gdal.GDT_Unknown)
+    lyr = ds.CreateLayer('ogr_mem_18')
+    for wkt in ['POINT (1 1)',  # inside
+                'POINT (5 5)',  # in the hole
+                'POINT (0 5)',  # on the exterior ring
+                'POINT (2 2)',  # on a vertex of the hole
+                'POINT (11 5)',  # outside, but in the filter envelope
+                'MULTIPOINT (5 5,11 5)',
+                'MULTIPOINT (5 5,9 9)',
+                'POINT (15 15)']:
+        f = ogr.Feature(lyr.GetLayerDefn())
+        f.SetGeometry(ogr.CreateGeometryFromWkt(wkt))
+        lyr.CreateFeature(f)
+
+    lyr.SetSpatialFilter(ogr.CreateGeometryFromWkt(
+        'MULTIPOLYGON (((0 0,10 0,10 10,0 10,0 0),(2 2,2 8,8 8,8 2,2 2)),'
+        '((11 0,12 0,12 1,11 0)))'))
+    fids = [f.GetFID() for f in lyr]
+    if fids != [0, 2, 3, 6]:
+        gdaltest.post_reason('fail')
+        print(fids)
+        return 'fail'
+    if lyr.GetFeatureCount() != 4:
+        gdaltest.post_reason('fail')
+        print(lyr.GetFeatureCount())
+        return 'fail'
+
+    return 'success'
+
+###############################################################################
+
+
 def ogr_mem_cleanup():
 
     if gdaltest.mem_ds is None:
@@ -867,6 +906,7 @@ gdaltest_list = [
     ogr_mem_15,
     ogr_mem_16,
     ogr_mem_17,
+    ogr_mem_18,
     ogr_mem_cleanup]
 
 if __name__ == '__main__':
@@ -2483,6 +2483,48 @@ def ogr_mitab_47():
 
     return 'success'
 
+###############################################################################
+# Test that the .ind index of a .tab file is used to evaluate attribute filters
+
+
+def ogr_mitab_47_index_used():
+
+    debug_msgs = []
+
+    def handler(err_type, err_no, err_msg):
+        if err_type == gdal.CE_Debug:
+            debug_msgs.append(err_msg)
+
+    ds = ogr.Open('data/poly_indexed.tab')
+    lyr = ds.GetLayer(0)
+    expected_fids = [f.GetFID() for f in lyr
+                     if f.GetField('PRFEDEA') == '35043413']
+
+    gdal.PushErrorHandler(handler)
+    gdal.SetConfigOption('CPL_DEBUG', 'ON')
+    lyr.SetAttributeFilter("PRFEDEA = '35043413'")
+    got_fids = [f.GetFID() for f in lyr]
+    gdal.SetConfigOption('CPL_DEBUG', None)
+    gdal.PopErrorHandler()
+    ds = None
+
+    if got_fids != expected_fids or len(got_fids) != 1:
+        gdaltest.post_reason('fail')
+        print(got_fids, expected_fids)
+        return 'fail'
+
+    found = False
+    for msg in debug_msgs:
+        if msg.startswith('Restored 1 field indexes for layer poly_indexed') and \
+           msg.endswith('poly_indexed.ind.'):
+            found = True
+    if not found:
+        gdaltest.post_reason('.ind index not used')
+        print(debug_msgs)
+        return 'fail'
+
+    return 'success'
+
 ###############################################################################
 # Test writing and reading LCC_1SP
 
@@ -2785,6 +2827,7 @@ gdaltest_list = [
     ogr_mitab_45,
     ogr_mitab_46,
     ogr_mitab_47,
+    ogr_mitab_47_index_used,
     ogr_mitab_48,
     ogr_mitab_49_aspatial,
     ogr_mitab_tab_field_index_creation,
@@ -1519,6 +1519,126 @@ def ogr_sql_48():
 
     return 'success'
 
+###############################################################################
+# Test ORDER BY with the sorted rows spilled to disk
+
+
+def ogr_sql_49():
+
+    ds = ogr.GetDriverByName('Memory').CreateDataSource('')
+    lyr = ds.CreateLayer('test')
+    lyr.CreateField(ogr.FieldDefn('int_field', ogr.OFTInteger))
+    lyr.CreateField(ogr.FieldDefn('str_field', ogr.OFTString))
+    for i in range(5000):
+        f = ogr.Feature(lyr.GetLayerDefn())
+        if (i % 100) != 0:
+            f.SetField(0, (i * 7919) % 1000)
+        f.SetField(1, 'value %d' % i)
+        f.SetGeometry(ogr.CreateGeometryFromWkt('POINT (%d %d)' % (i, -i)))
+        lyr.CreateFeature(f)
+
+    gdal.SetConfigOption('OGR_SQL_MAX_MEMORY', '0.01')
+    sql_lyr = ds.ExecuteSQL('SELECT * FROM test ORDER BY int_field DESC, str_field')
+    gdal.SetConfigOption('OGR_SQL_MAX_MEMORY', None)
+
+    for iteration in range(2):
+        count = 0
+        prev = None
+        for f in sql_lyr:
+            i = f.GetFID()
+            if f['str_field'] != 'value %d' % i or \
+               f.GetGeometryRef().ExportToWkt() != 'POINT (%d %d)' % (i, -i):
+                gdaltest.post_reason('fail')
+                f.DumpReadable()
+                return 'fail'
+            if f.IsFieldSetAndNotNull('int_field'):
+                key = (-f['int_field'], f['str_field'])
+            else:
+                key = (1, f['str_field'])
+            if prev is not None and key < prev:
+                gdaltest.post_reason('fail')
+                print(iteration, prev, key)
+                return 'fail'
+            prev = key
+            count += 1
+        if count != 5000:
+            gdaltest.post_reason('fail')
+            print(iteration, count)
+            return 'fail'
+        sql_lyr.ResetReading()
+
+    f = sql_lyr.GetFeature(4999)
+    if f is None or f.IsFieldSetAndNotNull('int_field'):
+        gdaltest.post_reason('fail')
+        return 'fail'
+    ds.ReleaseResultSet(sql_lyr)
+
+    gdal.SetConfigOption('OGR_SQL_MAX_MEMORY', '0.01')
+    sql_lyr = ds.ExecuteSQL('SELECT * FROM test ORDER BY int_field LIMIT 3 OFFSET 100')
+    gdal.SetConfigOption('OGR_SQL_MAX_MEMORY', None)
+    values = [f['int_field'] for f in sql_lyr]
+    ds.ReleaseResultSet(sql_lyr)
+    if values != [11, 11, 11]:
+        gdaltest.post_reason('fail')
+        print(values)
+        return 'fail'
+
+    return 'success'
+
+###############################################################################
+# Test DISTINCT with the values spilled to disk
+
+
+def ogr_sql_50():
+
+    ds = ogr.GetDriverByName('Memory').CreateDataSource('')
+    lyr = ds.CreateLayer('test', geom_type=ogr.wkbNone)
+    lyr.CreateField(ogr.FieldDefn('int_field', ogr.OFTInteger))
+    for i in range(5000):
+        f = ogr.Feature(lyr.GetLayerDefn())
+        if (i % 1000) != 999:
+            f.SetField(0, (i * 7919) % 1000)
+        lyr.CreateFeature(f)
+
+    expected_unsorted = []
+    for i in range(1000):
+        expected_unsorted.append((i * 7919) % 1000 if i != 999 else None)
+
+    for option in [None, '0.001']:
+        gdal.SetConfigOption('OGR_SQL_MAX_MEMORY', option)
+        sql_lyr = ds.ExecuteSQL('SELECT DISTINCT int_field FROM test')
+        gdal.SetConfigOption('OGR_SQL_MAX_MEMORY', None)
+        values = [f['int_field'] if f.IsFieldSetAndNotNull(0) else None for f in sql_lyr]
+        count = sql_lyr.GetFeatureCount()
+        ds.ReleaseResultSet(sql_lyr)
+        if values != expected_unsorted or count != 1000:
+            gdaltest.post_reason('fail')
+            print(option, count, values[0:10])
+            return 'fail'
+
+        gdal.SetConfigOption('OGR_SQL_MAX_MEMORY', option)
+        sql_lyr = ds.ExecuteSQL('SELECT DISTINCT int_field FROM test ORDER BY int_field DESC')
+        gdal.SetConfigOption('OGR_SQL_MAX_MEMORY', None)
+        values = [f['int_field'] if f.IsFieldSetAndNotNull(0) else None for f in sql_lyr]
+        ds.ReleaseResultSet(sql_lyr)
+        if values != [i for i in range(999, -1, -1) if i != 81] + [None]:
+            gdaltest.post_reason('fail')
+            print(option, values[0:10], values[-10:])
+            return 'fail'
+
+        gdal.SetConfigOption('OGR_SQL_MAX_MEMORY', option)
+        sql_lyr = ds.ExecuteSQL('SELECT COUNT(DISTINCT int_field) FROM test')
+        gdal.SetConfigOption('OGR_SQL_MAX_MEMORY', None)
+        f = sql_lyr.GetNextFeature()
+        val = f.GetField(0)
+        ds.ReleaseResultSet(sql_lyr)
+        if val != 999:
+            gdaltest.post_reason('fail')
+            print(option, val)
+            return 'fail'
+
+    return 'success'
+
 
 def ogr_sql_cleanup():
     gdaltest.lyr = None
@@ -1577,6 +1697,8 @@ gdaltest_list = [
     ogr_sql_46,
     ogr_sql_47,
     ogr_sql_48,
+    ogr_sql_49,
+    ogr_sql_50,
     ogr_sql_cleanup]
 
 if __name__ == '__main__':
@@ -231,6 +231,13 @@ def get_gdalsrsinfo_path():
 #
 
 
+def get_gdal_bandmath_path():
+    return get_cli_utility_path('gdal_bandmath')
+
+###############################################################################
+#
+
+
 def get_gnmmanage_path():
     return get_cli_utility_path('gnmmanage')
 
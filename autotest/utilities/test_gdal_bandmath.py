@@ -0,0 +1,213 @@
+#!/usr/bin/env python
+# -*- coding: utf-8 -*-
+###############################################################################
+# $Id$
+#
+# Project:  GDAL/OGR Test Suite
+# Purpose:  gdal_bandmath testing
+#
+###############################################################################
+# Copyright (c) 2018, GDAL contributors
+#
+# Permission is hereby granted, free of charge, to any person obtaining a
+# copy of this software and associated documentation files (the "Software"),
+# to deal in the Software without restriction, including without limitation
+# the rights to use, copy, modify, merge, publish, distribute, sublicense,
+# and/or sell copies of the Software, and to permit persons to whom the
+# Software is furnished to do so, subject to the following conditions:
+#
+# The above copyright notice and this permission notice shall be included
+# in all copies or substantial portions of the Software.
+#
+# THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+# OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+# FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+# THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+# LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+# FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+# DEALINGS IN THE SOFTWARE.
+###############################################################################
+
+import os
+import struct
+import sys
+
+sys.path.append('../pymod')
+
+from osgeo import gdal
+import gdaltest
+import test_cli_utilities
+
+###############################################################################
+# Test a simple expression on a single input
+
+
+def test_gdal_bandmath_1():
+    if test_cli_utilities.get_gdal_bandmath_path() is None:
+        return 'skip'
+
+    (_, err) = gdaltest.runexternal_out_and_err(
+        test_cli_utilities.get_gdal_bandmath_path() +
+        ' -q -calc "B1 * 2 + 1" -i ../gcore/data/byte.tif -ot UInt16 '
+        'tmp/test_gdal_bandmath_1.tif')
+    if not (err is None or err == ''):
+        gdaltest.post_reason('got error/warning')
+        print(err)
+        return 'fail'
+
+    src_ds = gdal.Open('../gcore/data/byte.tif')
+    ds = gdal.Open('tmp/test_gdal_bandmath_1.tif')
+    if ds.GetRasterBand(1).DataType != gdal.GDT_UInt16:
+        gdaltest.post_reason('fail')
+        return 'fail'
+    if ds.GetGeoTransform() != src_ds.GetGeoTransform():
+        gdaltest.post_reason('fail')
+        return 'fail'
+    src_values = struct.unpack('B' * 400, src_ds.ReadRaster())
+    values = struct.unpack('H' * 400, ds.ReadRaster())
+    ds = None
+    gdal.GetDriverByName('GTiff').Delete('tmp/test_gdal_bandmath_1.tif')
+
+    if values != tuple([v * 2 + 1 for v in src_values]):
+        gdaltest.post_reason('fail')
+        print(values)
+        return 'fail'
+
+    return 'success'
+
+###############################################################################
+# Test several inputs, band selection and nodata handling
+
+
+def test_gdal_bandmath_2():
+    if test_cli_utilities.get_gdal_bandmath_path() is None:
+        return 'skip'
+
+    src_ds = gdal.GetDriverByName('GTiff').Create(
+        'tmp/test_gdal_bandmath_2_src.tif', 4, 1, 2)
+    src_ds.GetRasterBand(1).SetNoDataValue(255)
+    src_ds.GetRasterBand(1).WriteRaster(0, 0, 4, 1,
+                                        struct.pack('B' * 4, 10, 20, 255, 0))
+    src_ds.GetRasterBand(2).WriteRaster(0, 0, 4, 1,
+                                        struct.pack('B' * 4, 30, 20, 1, 0))
+    src_ds = None
+
+    gdaltest.runexternal(
+        test_cli_utilities.get_gdal_bandmath_path() +
+        ' -q -calc "(B2-B1)/(B2+B1)" -i tmp/test_gdal_bandmath_2_src.tif '
+        '-i tmp/test_gdal_bandmath_2_src.tif -b 2 -a_nodata -9999 '
+        'tmp/test_gdal_bandmath_2.tif')
+
+    ds = gdal.Open('tmp/test_gdal_bandmath_2.tif')
+    nodata = ds.GetRasterBand(1).GetNoDataValue()
+    values = struct.unpack('f' * 4, ds.ReadRaster())
+    ds = None
+    gdal.GetDriverByName('GTiff').Delete('tmp/test_gdal_bandmath_2.tif')
+    gdal.GetDriverByName('GTiff').Delete('tmp/test_gdal_bandmath_2_src.tif')
+
+    # 0/0 is nodata, as well as any operation on a nodata input
+    if nodata != -9999 or values != (0.5, 0.0, -9999, -9999):
+        gdaltest.post_reason('fail')
+        print(nodata, values)
+        return 'fail'
+
+    return 'success'
+
+###############################################################################
+# Test -vrt
+
+
+def test_gdal_bandmath_3():
+    if test_cli_utilities.get_gdal_bandmath_path() is None:
+        return 'skip'
+
+    gdaltest.runexternal(
+        test_cli_utilities.get_gdal_bandmath_path() +
+        ' -calc "B1 > 100 ? 1 : 0" -ot Byte -i ../gcore/data/byte.tif '
+        '-vrt tmp/test_gdal_bandmath_3.vrt')
+
+    content = open('tmp/test_gdal_bandmath_3.vrt', 'rt').read()
+    if content.find('<PixelFunctionLanguage>Expression</PixelFunctionLanguage>') < 0 or \
+       content.find('B1 > 100 ? 1 : 0') < 0:
+        gdaltest.post_reason('fail')
+        print(content)
+        return 'fail'
+
+    ds = gdal.Open('tmp/test_gdal_bandmath_3.vrt')
+    values = struct.unpack('B' * 400, ds.ReadRaster())
+    ds = None
+    os.unlink('tmp/test_gdal_bandmath_3.vrt')
+
+    src_values = struct.unpack('B' * 400,
+                               gdal.Open('../gcore/data/byte.tif').ReadRaster())
+    if values != tuple([1 if v > 100 else 0 for v in src_values]):
+        gdaltest.post_reason('fail')
+        print(values)
+        return 'fail'
+
+    return 'success'
+
+###############################################################################
+# Test errors
+
+
+def test_gdal_bandmath_4():
+    if test_cli_utilities.get_gdal_bandmath_path() is None:
+        return 'skip'
+
+    (_, err) = gdaltest.runexternal_out_and_err(
+        test_cli_utilities.get_gdal_bandmath_path() +
+        ' -q -calc "B1 +" -i ../gcore/data/byte.tif '
+        'tmp/test_gdal_bandmath_4.tif')
+    if err.find('Invalid expression') < 0:
+        gdaltest.post_reason('fail')
+        print(err)
+        return 'fail'
+
+    (_, err) = gdaltest.runexternal_out_and_err(
+        test_cli_utilities.get_gdal_bandmath_path() +
+        ' -q -calc "B1 + B2" -i ../gcore/data/byte.tif '
+        'tmp/test_gdal_bandmath_4.tif')
+    if err.find('refers to B2') < 0:
+        gdaltest.post_reason('fail')
+        print(err)
+        return 'fail'
+
+    (_, err) = gdaltest.runexternal_out_and_err(
+        test_cli_utilities.get_gdal_bandmath_path() +
+        ' -q -calc "B1 + B2" -i ../gcore/data/byte.tif '
+        '-i ../gcore/data/int16.tif tmp/test_gdal_bandmath_4.tif')
+    if err.find('same dimensions') >= 0:
+        gdaltest.post_reason('fail')
+        print(err)
+        return 'fail'
+
+    (_, err) = gdaltest.runexternal_out_and_err(
+        test_cli_utilities.get_gdal_bandmath_path() +
+        ' -q -calc "B1 + B2" -i ../gcore/data/byte.tif '
+        '-i ../gcore/data/rgbsmall.tif tmp/test_gdal_bandmath_4.tif')
+    if err.find('same dimensions') < 0:
+        gdaltest.post_reason('fail')
+        print(err)
+        return 'fail'
+
+    gdal.Unlink('tmp/test_gdal_bandmath_4.tif')
+
+    return 'success'
+
+
+gdaltest_list = [
+    test_gdal_bandmath_1,
+    test_gdal_bandmath_2,
+    test_gdal_bandmath_3,
+    test_gdal_bandmath_4,
+]
+
+
+if __name__ == '__main__':
+
+    gdaltest.setup_run('test_gdal_bandmath')
+
+    gdaltest.run_tests(gdaltest_list)
+
+    sys.exit(gdaltest.summarize())
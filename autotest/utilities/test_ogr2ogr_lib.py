@@ -556,6 +556,50 @@ def test_ogr2ogr_clipsrc_no_dst_geom():
 
     return 'success'
 
+###############################################################################
+# Test -num_threads: features must be the same, and in the same order, as
+# with a single thread
+
+
+def test_ogr2ogr_lib_num_threads():
+
+    src_ds = gdal.GetDriverByName('Memory').Create('', 0, 0, 0)
+    lyr = src_ds.CreateLayer('layer')
+    lyr.CreateField(ogr.FieldDefn('id', ogr.OFTInteger))
+    for i in range(2000):
+        f = ogr.Feature(lyr.GetLayerDefn())
+        f['id'] = i
+        x = i % 100
+        y = i // 100
+        if i % 2 == 0:
+            wkt = 'MULTILINESTRING ((%d %d,%d %d),(%d %d,%d %d))' % \
+                (x, y, x + 3, y + 4, x, y, x - 6, y + 8)
+        else:
+            wkt = 'POLYGON ((%d %d,%d %d,%d %d,%d %d))' % \
+                (x, y, x + 3, y, x + 3, y + 3, x, y)
+        f.SetGeometry(ogr.CreateGeometryFromWkt(wkt))
+        lyr.CreateFeature(f)
+
+    for options in ['-segmentize 0.5', '-explodecollections -dim XYZ']:
+        out = []
+        for num_threads in [1, 4]:
+            ds = gdal.VectorTranslate('', src_ds, format='Memory',
+                                      options=options + ' -num_threads %d' % num_threads)
+            out.append([(f['id'], f.GetGeometryRef().ExportToWkt())
+                        for f in ds.GetLayer(0)])
+            ds = None
+        if out[0] != out[1]:
+            gdaltest.post_reason('fail')
+            print(options)
+            return 'fail'
+        if len(out[0]) != (3000 if '-explodecollections' in options else 2000):
+            gdaltest.post_reason('fail')
+            print(options)
+            print(len(out[0]))
+            return 'fail'
+
+    return 'success'
+
 gdaltest_list = [
     test_ogr2ogr_lib_1,
     test_ogr2ogr_lib_2,
@@ -579,6 +623,7 @@ gdaltest_list = [
     test_ogr2ogr_lib_20,
     test_ogr2ogr_lib_21,
     test_ogr2ogr_clipsrc_no_dst_geom,
+    test_ogr2ogr_lib_num_threads,
 ]
 
 if __name__ == '__main__':
@@ -111,6 +111,14 @@ std::vector<CPLString> GetOutputDriversFor(const char* pszDestFilename,
         aoDriverList.push_back("GMT");
     }
 
+    // COG only makes sense when explicitly asked for: keep GTiff as the
+    // only choice for .tif.
+    if( aoDriverList.size() == 2 &&
+        EQUAL(aoDriverList[0], "GTiff") && EQUAL(aoDriverList[1], "COG") )
+    {
+        aoDriverList.resize(1);
+    }
+
     return aoDriverList;
 }
 
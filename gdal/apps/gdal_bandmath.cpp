@@ -0,0 +1,406 @@
+/******************************************************************************
+ * $Id$
+ *
+ * Project:  GDAL Utilities
+ * Purpose:  Command line raster calculator based on VRT expressions
+ *
+ ******************************************************************************
+ * Copyright (c) 2018, GDAL contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ ****************************************************************************/
+
+#include "cpl_string.h"
+#include "gdal_version.h"
+#include "gdal.h"
+#include "gdal_utils.h"
+#include "gdal_vrt.h"
+#include "commonutils.h"
+
+#include <utility>
+#include <vector>
+
+CPL_CVSID("$Id$")
+
+/******************************************************************************/
+/*! \page gdal_bandmath gdal_bandmath
+
+raster calculator
+
+\section gdal_bandmath_synopsis SYNOPSIS
+
+\htmlonly
+Usage:
+\endhtmlonly
+
+\verbatim
+Usage: gdal_bandmath [--help-general] -calc expression
+                     -i src_filename [-b band] [-i src_filename [-b band]]*
+                     [-of format] [-ot type] [-co "NAME=VALUE"]*
+                     [-a_nodata value] [-vrt] [-q] dst_filename
+\endverbatim
+
+\section gdal_bandmath_description DESCRIPTION
+
+<p>
+The gdal_bandmath utility computes a raster from one or several input
+rasters of the same dimensions, with a band math expression evaluated
+natively by the VRT driver (PixelFunctionLanguage="Expression"), without
+requiring Python.
+
+<p>
+<dl>
+<dt> <b>-calc</b> <em>expression</em>:</dt>
+<dd>Expression to evaluate. Inputs are designated by B1, B2, ... in the
+order of the -i switches. The expression syntax supports the + - * / %
+^ operators, comparisons (== != < <= > >=), logical operators (&& || !),
+the conditional operator (cond ? a : b), the abs, sqrt, exp, log, log10,
+sin, cos, tan, asin, acos, atan, floor, ceil, round, isnodata, pow, atan2,
+fmod, min, max and if functions, and the pi, e and nodata constants.</dd>
+
+<dt> <b>-i</b> <em>src_filename</em>:</dt>
+<dd>Input raster. Can be repeated.</dd>
+
+<dt> <b>-b</b> <em>band</em>:</dt>
+<dd>Band of the preceding input to use. Defaults to 1.</dd>
+
+<dt> <b>-of</b> <em>format</em>:</dt>
+<dd>Output format. Defaults to GTiff.</dd>
+
+<dt> <b>-ot</b> <em>type</em>:</dt>
+<dd>Output data type. Defaults to Float32.</dd>
+
+<dt> <b>-co</b> <em>"NAME=VALUE"</em>:</dt>
+<dd>Creation option passed to the output driver.</dd>
+
+<dt> <b>-a_nodata</b> <em>value</em>:</dt>
+<dd>Nodata value of the output. Input pixels at their own nodata value, or
+at this value, are nodata for the expression, and expressions evaluating
+to nodata are written with this value. Defaults to the nodata value of the
+first input that has one.</dd>
+
+<dt> <b>-vrt</b>:</dt>
+<dd>Write the VRT file with the expression instead of computing the
+result.</dd>
+
+<dt> <b>-q</b>:</dt>
+<dd>Suppress progress monitor and other non-error output.</dd>
+
+<dt> <em>dst_filename</em>:</dt>
+<dd>Output file.</dd>
+</dl>
+
+Any arithmetic involving a nodata pixel evaluates to nodata. Comparisons
+with nodata are nodata, as is the result of a conditional whose condition
+is nodata. Undefined operations, such as 0/0 or the logarithm of a negative
+value, evaluate to nodata.
+
+\section gdal_bandmath_example EXAMPLE
+
+NDVI from the red and near infrared bands of a multispectral image:
+
+\verbatim
+gdal_bandmath -calc "(B2-B1)/(B2+B1)" -i in.tif -b 3 -i in.tif -b 4 \
+              -a_nodata -9999 ndvi.tif
+\endverbatim
+
+Thresholding:
+
+\verbatim
+gdal_bandmath -calc "B1 > 100 ? 1 : 0" -i in.tif -ot Byte mask.tif
+\endverbatim
+
+\if man
+\section gdal_bandmath_author AUTHORS
+GDAL contributors
+\endif
+*/
+
+/************************************************************************/
+/*                               Usage()                                */
+/************************************************************************/
+
+static void Usage( const char* pszErrorMsg = nullptr )
+
+{
+    printf( "Usage: gdal_bandmath [--help-general] -calc expression\n"
+            "                     -i src_filename [-b band] "
+            "[-i src_filename [-b band]]*\n"
+            "                     [-of format] [-ot type] "
+            "[-co \"NAME=VALUE\"]*\n"
+            "                     [-a_nodata value] [-vrt] [-q] "
+            "dst_filename\n" );
+
+    if( pszErrorMsg != nullptr )
+        fprintf(stderr, "\nFAILURE: %s\n", pszErrorMsg);
+
+    exit( 1 );
+}
+
+/************************************************************************/
+/*                                main()                                */
+/************************************************************************/
+
+MAIN_START(argc, argv)
+
+{
+    const char *pszExpression = nullptr;
+    const char *pszDstFilename = nullptr;
+    const char *pszFormat = "GTiff";
+    const char *pszNoData = nullptr;
+    GDALDataType eOutputType = GDT_Float32;
+    char      **papszCreateOptions = nullptr;
+    bool        bQuiet = false;
+    bool        bWriteVRT = false;
+    std::vector<std::pair<CPLString, int>> aoInputs;
+
+    GDALAllRegister();
+    argc = GDALGeneralCmdLineProcessor( argc, &argv, 0 );
+    if( argc < 1 )
+        exit( -argc );
+
+/* -------------------------------------------------------------------- */
+/*      Parse arguments.                                                */
+/* -------------------------------------------------------------------- */
+    for( int i = 1; i < argc; i++ )
+    {
+        if( EQUAL(argv[i], "--utility_version") )
+        {
+            printf("%s was compiled against GDAL %s and is running against GDAL %s\n",
+                   argv[0], GDAL_RELEASE_NAME, GDALVersionInfo("RELEASE_NAME"));
+            GDALDestroyDriverManager();
+            CSLDestroy(argv);
+            return 0;
+        }
+        else if( EQUAL(argv[i], "--help") )
+        {
+            Usage();
+        }
+        else if( i < argc-1 && EQUAL(argv[i], "-calc") )
+        {
+            pszExpression = argv[++i];
+        }
+        else if( i < argc-1 && EQUAL(argv[i], "-i") )
+        {
+            aoInputs.push_back(std::pair<CPLString, int>(argv[++i], 1));
+        }
+        else if( i < argc-1 && EQUAL(argv[i], "-b") )
+        {
+            if( aoInputs.empty() )
+                Usage("-b must follow -i");
+            aoInputs.back().second = atoi(argv[++i]);
+        }
+        else if( i < argc-1 && (EQUAL(argv[i], "-of") ||
+                                EQUAL(argv[i], "-f")) )
+        {
+            pszFormat = argv[++i];
+        }
+        else if( i < argc-1 && EQUAL(argv[i], "-ot") )
+        {
+            eOutputType = GDALGetDataTypeByName(argv[++i]);
+            if( eOutputType == GDT_Unknown )
+                Usage(CPLSPrintf("Unknown output pixel type: %s", argv[i]));
+        }
+        else if( i < argc-1 && EQUAL(argv[i], "-co") )
+        {
+            papszCreateOptions = CSLAddString(papszCreateOptions, argv[++i]);
+        }
+        else if( i < argc-1 && EQUAL(argv[i], "-a_nodata") )
+        {
+            pszNoData = argv[++i];
+        }
+        else if( EQUAL(argv[i], "-vrt") )
+        {
+            bWriteVRT = true;
+        }
+        else if( EQUAL(argv[i], "-q") || EQUAL(argv[i], "-quiet") )
+        {
+            bQuiet = true;
+        }
+        else if( argv[i][0] == '-' )
+        {
+            Usage(CPLSPrintf("Unknown option name '%s'", argv[i]));
+        }
+        else if( pszDstFilename == nullptr )
+        {
+            pszDstFilename = argv[i];
+        }
+        else
+        {
+            Usage("Too many command options.");
+        }
+    }
+
+    if( pszExpression == nullptr )
+        Usage("No expression specified.");
+    if( aoInputs.empty() )
+        Usage("No input file specified.");
+    if( pszDstFilename == nullptr )
+        Usage("No output file specified.");
+
+/* -------------------------------------------------------------------- */
+/*      Build a VRT with a derived band evaluating the expression.      */
+/* -------------------------------------------------------------------- */
+    GDALDatasetH hVRTDS = nullptr;
+    VRTSourcedRasterBandH hVRTBand = nullptr;
+    bool bHasNoData = pszNoData != nullptr;
+    double dfNoData = pszNoData ? CPLAtof(pszNoData) : 0.0;
+    int nRet = 0;
+
+    for( size_t iInput = 0; iInput < aoInputs.size(); iInput++ )
+    {
+        const char* pszSrcFilename = aoInputs[iInput].first.c_str();
+        GDALDatasetH hSrcDS = GDALOpenEx( pszSrcFilename,
+                                          GDAL_OF_RASTER | GDAL_OF_VERBOSE_ERROR,
+                                          nullptr, nullptr, nullptr );
+        if( hSrcDS == nullptr )
+        {
+            nRet = 1;
+            break;
+        }
+        GDALRasterBandH hSrcBand =
+            GDALGetRasterBand(hSrcDS, aoInputs[iInput].second);
+        if( hSrcBand == nullptr )
+        {
+            GDALClose(hSrcDS);
+            nRet = 1;
+            break;
+        }
+        const int nXSize = GDALGetRasterXSize(hSrcDS);
+        const int nYSize = GDALGetRasterYSize(hSrcDS);
+
+        if( hVRTDS == nullptr )
+        {
+            hVRTDS = GDALCreate( GDALGetDriverByName("VRT"),
+                                 bWriteVRT ? pszDstFilename : "",
+                                 nXSize, nYSize, 0, eOutputType, nullptr );
+            if( hVRTDS == nullptr )
+            {
+                GDALClose(hSrcDS);
+                nRet = 1;
+                break;
+            }
+            double adfGeoTransform[6];
+            if( GDALGetGeoTransform(hSrcDS, adfGeoTransform) == CE_None )
+                GDALSetGeoTransform(hVRTDS, adfGeoTransform);
+            const char* pszWKT = GDALGetProjectionRef(hSrcDS);
+            if( pszWKT != nullptr && pszWKT[0] != '\0' )
+                GDALSetProjection(hVRTDS, pszWKT);
+
+            char** papszOptions = nullptr;
+            papszOptions = CSLSetNameValue(papszOptions, "subclass",
+                                           "VRTDerivedRasterBand");
+            papszOptions = CSLSetNameValue(papszOptions,
+                                           "PixelFunctionLanguage",
+                                           "Expression");
+            papszOptions = CSLSetNameValue(papszOptions, "PixelFunctionCode",
+                                           pszExpression);
+            GDALAddBand(hVRTDS, eOutputType, papszOptions);
+            CSLDestroy(papszOptions);
+            hVRTBand = static_cast<VRTSourcedRasterBandH>(
+                                            GDALGetRasterBand(hVRTDS, 1));
+        }
+        else if( nXSize != GDALGetRasterXSize(hVRTDS) ||
+                 nYSize != GDALGetRasterYSize(hVRTDS) )
+        {
+            fprintf(stderr, "%s has not the same dimensions as %s.\n",
+                    pszSrcFilename, aoInputs[0].first.c_str());
+            GDALClose(hSrcDS);
+            nRet = 1;
+            break;
+        }
+
+        int bSrcHasNoData = FALSE;
+        const double dfSrcNoData =
+            GDALGetRasterNoDataValue(hSrcBand, &bSrcHasNoData);
+        if( bSrcHasNoData && !bHasNoData )
+        {
+            bHasNoData = true;
+            dfNoData = dfSrcNoData;
+        }
+
+        // Source pixels at the source nodata value are left to the
+        // nodata value of the derived band, which the expression sees
+        // as nodata.
+        if( bSrcHasNoData )
+        {
+            VRTAddComplexSource( hVRTBand, hSrcBand,
+                                 0, 0, nXSize, nYSize,
+                                 0, 0, nXSize, nYSize,
+                                 0.0, 1.0, dfSrcNoData );
+        }
+        else
+        {
+            VRTAddSimpleSource( hVRTBand, hSrcBand,
+                                0, 0, nXSize, nYSize,
+                                0, 0, nXSize, nYSize,
+                                "near", VRT_NODATA_UNSET );
+        }
+
+        // The VRT holds a reference on the source dataset.
+        GDALReleaseDataset(hSrcDS);
+    }
+
+    if( nRet == 0 && bHasNoData )
+        GDALSetRasterNoDataValue(hVRTBand, dfNoData);
+
+/* -------------------------------------------------------------------- */
+/*      Compute the result.                                             */
+/* -------------------------------------------------------------------- */
+    if( nRet == 0 && !bWriteVRT )
+    {
+        char** papszTranslateArgs = nullptr;
+        papszTranslateArgs = CSLAddString(papszTranslateArgs, "-of");
+        papszTranslateArgs = CSLAddString(papszTranslateArgs, pszFormat);
+        for( char** papszIter = papszCreateOptions;
+             papszIter && *papszIter; ++papszIter )
+        {
+            papszTranslateArgs = CSLAddString(papszTranslateArgs, "-co");
+            papszTranslateArgs = CSLAddString(papszTranslateArgs, *papszIter);
+        }
+        if( bQuiet )
+            papszTranslateArgs = CSLAddString(papszTranslateArgs, "-q");
+
+        GDALTranslateOptions* psOptions =
+            GDALTranslateOptionsNew(papszTranslateArgs, nullptr);
+        CSLDestroy(papszTranslateArgs);
+        if( !bQuiet )
+            GDALTranslateOptionsSetProgress(psOptions, GDALTermProgress,
+                                            nullptr);
+
+        int bUsageError = FALSE;
+        GDALDatasetH hOutDS = GDALTranslate(pszDstFilename, hVRTDS,
+                                            psOptions, &bUsageError);
+        GDALTranslateOptionsFree(psOptions);
+        if( hOutDS == nullptr )
+            nRet = 1;
+        else
+            GDALClose(hOutDS);
+    }
+
+    if( hVRTDS != nullptr )
+        GDALClose(hVRTDS);
+
+    CSLDestroy(papszCreateOptions);
+    CSLDestroy(argv);
+    GDALDestroyDriverManager();
+
+    return nRet;
+}
+MAIN_END
@@ -40,6 +40,7 @@
 
 #include <algorithm>
 #include <map>
+#include <memory>
 #include <set>
 #include <unordered_set>
 #include <string>
@@ -52,6 +53,7 @@
 #include "cpl_progress.h"
 #include "cpl_string.h"
 #include "cpl_vsi.h"
+#include "cpl_worker_thread_pool.h"
 #include "gdal.h"
 #include "gdal_alg.h"
 #include "gdal_priv.h"
@@ -82,6 +84,13 @@ typedef enum
     GTC_CONVERT_TO_CURVE,
 } GeomTypeConversion;
 
+typedef enum
+{
+    TRANSLATE_GEOM_OK,
+    TRANSLATE_GEOM_CLIPPED_OUT,
+    TRANSLATE_GEOM_FAILED,
+} TranslateGeomStatus;
+
 #define GEOMTYPE_UNCHANGED  -2
 
 #define COORD_DIM_UNCHANGED -1
@@ -343,6 +352,13 @@ struct GDALVectorTranslateOptions
 
     /*! Maximum number of features, or -1 if no limit. */
     GIntBig nLimit;
+
+    /*! Number of threads used to process the geometries of the features
+        (reprojection, clipping, simplification, ...). Features are still
+        read and written by the calling thread, in the source order.
+        Defaults to the value of the GDAL_NUM_THREADS configuration option,
+        or 1. */
+    int nNumThreads;
 };
 
 typedef struct
@@ -426,6 +442,7 @@ public:
     bool                          m_bExplodeCollections;
     bool                          m_bNativeData;
     GIntBig                       m_nLimit;
+    int                           m_nNumThreads;
 
     int                 Translate(OGRFeature* poFeatureIn,
                                   TargetLayerInfo* psInfo,
@@ -435,6 +452,38 @@ public:
                                   GDALProgressFunc pfnProgress,
                                   void *pProgressArg,
                                   GDALVectorTranslateOptions *psOptions);
+
+    TranslateGeomStatus TranslateGeometries(OGRFeature* poFeature,
+                                            OGRFeature* poDstFeature,
+                                            TargetLayerInfo* psInfo,
+                                            OGRCoordinateTransformation** papoCT,
+                                            OGRSpatialReference* poOutputSRS,
+                                            int nParts,
+                                            int iPart,
+                                            bool bSkipFailures,
+                                            bool& bReprojectionFailed);
+
+private:
+    bool                CanTranslateMultiThreaded(OGRFeature* poFeatureIn,
+                                                  TargetLayerInfo* psInfo,
+                                                  GDALVectorTranslateOptions *psOptions);
+    int                 TranslateMultiThreaded(TargetLayerInfo* psInfo,
+                                               OGRSpatialReference* poOutputSRS,
+                                               GIntBig nCountLayerFeatures,
+                                               GIntBig* pnReadFeatureCount,
+                                               GIntBig& nTotalEventsDone,
+                                               GDALProgressFunc pfnProgress,
+                                               void *pProgressArg,
+                                               GDALVectorTranslateOptions *psOptions);
+    bool                AdvanceTransaction(TargetLayerInfo* psInfo,
+                                           int& nFeaturesInTransaction,
+                                           GIntBig& nTotalEventsDone,
+                                           GDALVectorTranslateOptions *psOptions);
+    bool                WriteFeature(OGRFeature* poFeature,
+                                     OGRFeature* poDstFeature,
+                                     TargetLayerInfo* psInfo,
+                                     GIntBig& nFeaturesWritten,
+                                     GDALVectorTranslateOptions *psOptions);
 };
 
 static OGRLayer* GetLayerAndOverwriteIfNecessary(GDALDataset *poDstDS,
@@ -1265,6 +1314,9 @@ public:
         virtual ~GDALVectorTranslateWrappedLayer();
         virtual OGRFeatureDefn* GetLayerDefn() override { return m_poFDefn; }
         virtual OGRFeature* GetNextFeature() override;
+        virtual int         GetNextFeatureBatch( OGRFeatureBatch* poBatch,
+                                                 int nMaxRows ) override;
+        virtual int         FillNextFeature( OGRFeature* poFeature ) override;
         virtual OGRFeature* GetFeature(GIntBig nFID) override;
 
         static GDALVectorTranslateWrappedLayer* New(
@@ -1361,6 +1413,19 @@ OGRFeature* GDALVectorTranslateWrappedLayer::GetNextFeature()
     return TranslateFeature(OGRLayerDecorator::GetNextFeature());
 }
 
+int GDALVectorTranslateWrappedLayer::GetNextFeatureBatch(
+    OGRFeatureBatch* poBatch, int nMaxRows )
+{
+    // Features must be translated: go through GetNextFeature().
+    return OGRLayer::GetNextFeatureBatch(poBatch, nMaxRows);
+}
+
+int GDALVectorTranslateWrappedLayer::FillNextFeature( OGRFeature* poFeature )
+{
+    // Features must be translated: go through GetNextFeature().
+    return OGRLayer::FillNextFeature(poFeature);
+}
+
 OGRFeature* GDALVectorTranslateWrappedLayer::GetFeature(GIntBig nFID)
 {
     return TranslateFeature(OGRLayerDecorator::GetFeature(nFID));
@@ -2482,6 +2547,7 @@ GDALDatasetH GDALVectorTranslate( const char *pszDest, GDALDatasetH hDstDS, int
     oTranslator.m_bExplodeCollections = psOptions->bExplodeCollections;
     oTranslator.m_bNativeData = psOptions->bNativeData;
     oTranslator.m_nLimit = psOptions->nLimit;
+    oTranslator.m_nNumThreads = psOptions->nNumThreads;
 
     if( psOptions->nGroupTransactions )
     {
@@ -4335,6 +4401,746 @@ static bool SetupCT( TargetLayerInfo* psInfo,
     return true;
 }
 
+/************************************************************************/
+/*                LayerTranslator::TranslateGeometries()                */
+/*                                                                      */
+/*      Apply the geometry operations to the geometries of              */
+/*      poDstFeature (the iPart(th) part of the source geometry with    */
+/*      -explodecollections): Z from field, coordinate dimension,       */
+/*      segmentization or simplification, clipping, reprojection and    */
+/*      type conversion. Only poDstFeature is modified, so that this    */
+/*      can run in worker threads, each one with its own coordinate     */
+/*      transformations.                                                */
+/************************************************************************/
+
+TranslateGeomStatus LayerTranslator::TranslateGeometries(
+                                    OGRFeature* poFeature,
+                                    OGRFeature* poDstFeature,
+                                    TargetLayerInfo* psInfo,
+                                    OGRCoordinateTransformation** papoCT,
+                                    OGRSpatialReference* poOutputSRS,
+                                    int nParts,
+                                    int iPart,
+                                    bool bSkipFailures,
+                                    bool& bReprojectionFailed )
+{
+    const int eGType = m_eGType;
+    const int iSrcZField = psInfo->iSrcZField;
+    OGRFeatureDefn* poDstFDefn = poDstFeature->GetDefnRef();
+    const int nDstGeomFieldCount = poDstFDefn->GetGeomFieldCount();
+
+    for( int iGeom = 0; iGeom < nDstGeomFieldCount; iGeom ++ )
+    {
+        OGRGeometry* poDstGeometry = poDstFeature->StealGeometry(iGeom);
+        if (poDstGeometry == nullptr)
+            continue;
+
+        if (nParts > 0)
+        {
+            /* For -explodecollections, extract the iPart(th) of the geometry */
+            OGRGeometry* poPart = poDstGeometry->toGeometryCollection()->getGeometryRef(iPart);
+            poDstGeometry->toGeometryCollection()->removeGeometry(iPart, FALSE);
+            delete poDstGeometry;
+            poDstGeometry = poPart;
+            assert(poDstGeometry);
+        }
+
+        if (iSrcZField != -1)
+        {
+            SetZ(poDstGeometry, poFeature->GetFieldAsDouble(iSrcZField));
+            /* This will correct the coordinate dimension to 3 */
+            OGRGeometry* poDupGeometry = poDstGeometry->clone();
+            delete poDstGeometry;
+            poDstGeometry = poDupGeometry;
+        }
+
+        if (m_nCoordDim == 2 || m_nCoordDim == 3)
+        {
+            poDstGeometry->setCoordinateDimension( m_nCoordDim );
+        }
+        else if (m_nCoordDim == 4)
+        {
+            poDstGeometry->set3D( TRUE );
+            poDstGeometry->setMeasured( TRUE );
+        }
+        else if (m_nCoordDim == COORD_DIM_XYM)
+        {
+            poDstGeometry->set3D( FALSE );
+            poDstGeometry->setMeasured( TRUE );
+        }
+        else if ( m_nCoordDim == COORD_DIM_LAYER_DIM )
+        {
+            const OGRwkbGeometryType eDstLayerGeomType =
+              poDstFDefn->GetGeomFieldDefn(iGeom)->GetType();
+            poDstGeometry->set3D( wkbHasZ(eDstLayerGeomType) );
+            poDstGeometry->setMeasured( wkbHasM(eDstLayerGeomType) );
+        }
+
+        if (m_eGeomOp == GEOMOP_SEGMENTIZE)
+        {
+            if (m_dfGeomOpParam > 0)
+                poDstGeometry->segmentize(m_dfGeomOpParam);
+        }
+        else if (m_eGeomOp == GEOMOP_SIMPLIFY_PRESERVE_TOPOLOGY)
+        {
+            if (m_dfGeomOpParam > 0)
+            {
+                OGRGeometry* poNewGeom = poDstGeometry->SimplifyPreserveTopology(m_dfGeomOpParam);
+                if (poNewGeom)
+                {
+                    delete poDstGeometry;
+                    poDstGeometry = poNewGeom;
+                }
+            }
+        }
+
+        if (m_poClipSrc)
+        {
+            OGRGeometry* poClipped = poDstGeometry->Intersection(m_poClipSrc);
+            delete poDstGeometry;
+            if (poClipped == nullptr || poClipped->IsEmpty())
+            {
+                delete poClipped;
+                return TRANSLATE_GEOM_CLIPPED_OUT;
+            }
+            poDstGeometry = poClipped;
+        }
+
+        OGRCoordinateTransformation* poCT = papoCT[iGeom];
+        if( !m_bTransform )
+            poCT = m_poGCPCoordTrans;
+        char** papszTransformOptions = psInfo->papapszTransformOptions[iGeom];
+
+        if( poCT != nullptr || papszTransformOptions != nullptr)
+        {
+            OGRGeometry* poReprojectedGeom =
+                OGRGeometryFactory::transformWithOptions(poDstGeometry, poCT, papszTransformOptions);
+            if( poReprojectedGeom == nullptr )
+            {
+                bReprojectionFailed = true;
+                CPLError( CE_Failure, CPLE_AppDefined, "Failed to reproject feature " CPL_FRMT_GIB " (geometry probably out of source or destination SRS).",
+                          poFeature->GetFID() );
+                if( !bSkipFailures )
+                {
+                    delete poDstGeometry;
+                    return TRANSLATE_GEOM_FAILED;
+                }
+            }
+
+            delete poDstGeometry;
+            poDstGeometry = poReprojectedGeom;
+        }
+        else if (poOutputSRS != nullptr)
+        {
+            poDstGeometry->assignSpatialReference(poOutputSRS);
+        }
+
+        if (m_poClipDst)
+        {
+            if( poDstGeometry == nullptr )
+                return TRANSLATE_GEOM_CLIPPED_OUT;
+
+            OGRGeometry* poClipped = poDstGeometry->Intersection(m_poClipDst);
+            delete poDstGeometry;
+            if (poClipped == nullptr || poClipped->IsEmpty())
+            {
+                delete poClipped;
+                return TRANSLATE_GEOM_CLIPPED_OUT;
+            }
+
+            poDstGeometry = poClipped;
+        }
+
+        if( eGType != GEOMTYPE_UNCHANGED )
+        {
+            poDstGeometry = OGRGeometryFactory::forceTo(
+                    poDstGeometry, static_cast<OGRwkbGeometryType>(eGType));
+        }
+        else if( m_eGeomTypeConversion == GTC_PROMOTE_TO_MULTI ||
+                 m_eGeomTypeConversion == GTC_CONVERT_TO_LINEAR ||
+                 m_eGeomTypeConversion == GTC_CONVERT_TO_CURVE )
+        {
+            if( poDstGeometry != nullptr )
+            {
+                OGRwkbGeometryType eTargetType = poDstGeometry->getGeometryType();
+                eTargetType = ConvertType(m_eGeomTypeConversion, eTargetType);
+                poDstGeometry = OGRGeometryFactory::forceTo(poDstGeometry, eTargetType);
+            }
+        }
+
+        poDstFeature->SetGeomFieldDirectly(iGeom, poDstGeometry);
+    }
+
+    return TRANSLATE_GEOM_OK;
+}
+
+/************************************************************************/
+/*                 LayerTranslator::AdvanceTransaction()                */
+/*                                                                      */
+/*      Commit the current transaction and start a new one every        */
+/*      nGroupTransactions features.                                    */
+/************************************************************************/
+
+bool LayerTranslator::AdvanceTransaction( TargetLayerInfo* psInfo,
+                                          int& nFeaturesInTransaction,
+                                          GIntBig& nTotalEventsDone,
+                                          GDALVectorTranslateOptions *psOptions )
+{
+    OGRLayer *poDstLayer = psInfo->poDstLayer;
+
+    if( psOptions->nLayerTransaction &&
+        ++nFeaturesInTransaction == psOptions->nGroupTransactions )
+    {
+        if( poDstLayer->CommitTransaction() == OGRERR_FAILURE ||
+            poDstLayer->StartTransaction() == OGRERR_FAILURE )
+        {
+            return false;
+        }
+        nFeaturesInTransaction = 0;
+    }
+    else if( !psOptions->nLayerTransaction &&
+             psOptions->nGroupTransactions >= 0 &&
+             ++nTotalEventsDone >= psOptions->nGroupTransactions )
+    {
+        if( m_poODS->CommitTransaction() == OGRERR_FAILURE ||
+                m_poODS->StartTransaction(psOptions->bForceTransaction) == OGRERR_FAILURE )
+        {
+            return false;
+        }
+        nTotalEventsDone = 0;
+    }
+
+    return true;
+}
+
+/************************************************************************/
+/*                    LayerTranslator::WriteFeature()                   */
+/************************************************************************/
+
+bool LayerTranslator::WriteFeature( OGRFeature* poFeature,
+                                    OGRFeature* poDstFeature,
+                                    TargetLayerInfo* psInfo,
+                                    GIntBig& nFeaturesWritten,
+                                    GDALVectorTranslateOptions *psOptions )
+{
+    OGRLayer *poSrcLayer = psInfo->poSrcLayer;
+    OGRLayer *poDstLayer = psInfo->poDstLayer;
+    const bool bPreserveFID = psInfo->bPreserveFID;
+
+    CPLErrorReset();
+    if( poDstLayer->CreateFeature( poDstFeature ) == OGRERR_NONE )
+    {
+        nFeaturesWritten ++;
+        if( (bPreserveFID && poDstFeature->GetFID() != poFeature->GetFID()) ||
+            (!bPreserveFID && psInfo->iSrcFIDField >= 0 && poFeature->IsFieldSetAndNotNull(psInfo->iSrcFIDField) &&
+             poDstFeature->GetFID() != poFeature->GetFieldAsInteger64(psInfo->iSrcFIDField)) )
+        {
+            CPLError( CE_Warning, CPLE_AppDefined,
+                      "Feature id not preserved");
+        }
+    }
+    else if( !psOptions->bSkipFailures )
+    {
+        if( psOptions->nGroupTransactions )
+        {
+            if( psOptions->nLayerTransaction )
+                poDstLayer->RollbackTransaction();
+        }
+
+        CPLError( CE_Failure, CPLE_AppDefined,
+                "Unable to write feature " CPL_FRMT_GIB " from layer %s.",
+                poFeature->GetFID(), poSrcLayer->GetName() );
+
+        return false;
+    }
+    else
+    {
+        CPLDebug( "GDALVectorTranslate", "Unable to write feature " CPL_FRMT_GIB " into layer %s.",
+                   poFeature->GetFID(), poSrcLayer->GetName() );
+        if( psOptions->nGroupTransactions )
+        {
+            if( psOptions->nLayerTransaction )
+            {
+                poDstLayer->RollbackTransaction();
+                CPL_IGNORE_RET_VAL(poDstLayer->StartTransaction());
+            }
+            else
+            {
+                m_poODS->RollbackTransaction();
+                m_poODS->StartTransaction(psOptions->bForceTransaction);
+            }
+        }
+    }
+
+    return true;
+}
+
+/************************************************************************/
+/*                    Multi-threaded feature translation                */
+/*                                                                      */
+/*      The calling thread reads the source features, builds the        */
+/*      target features from them and writes them, while worker         */
+/*      threads run TranslateGeometries() on them. Features go by       */
+/*      batches: the calling thread reads the next batch while the      */
+/*      workers process the current one, and then writes the current    */
+/*      one, in the order of the source features, while the workers     */
+/*      process the next one. The output is thus the same as with a     */
+/*      single thread.                                                  */
+/************************************************************************/
+
+namespace {
+struct TranslateError
+{
+    CPLErr      eErr = CE_None;
+    CPLErrorNum nErrorNum = CPLE_None;
+    CPLString   osMsg{};
+};
+
+// A target feature, i.e. a source feature or one of its parts with
+// -explodecollections.
+struct TranslateItem
+{
+    size_t                      iSrcFeature = 0;
+    int                         nParts = 0;
+    int                         iPart = 0;
+    OGRFeatureUniquePtr         poDstFeature{};
+    bool                        bSetFromFailed = false;
+    TranslateGeomStatus         eStatus = TRANSLATE_GEOM_OK;
+    bool                        bReprojectionFailed = false;
+    std::vector<TranslateError> aoErrors{};
+};
+
+struct TranslateBatch
+{
+    std::vector<OGRFeatureUniquePtr> apoSrcFeatures{};
+    std::vector<TranslateItem>       aoItems{};
+};
+
+// Job iJob processes the items iJob, iJob + nJobs, ... of a batch, with
+// its own coordinate transformations.
+struct TranslateJob
+{
+    LayerTranslator                *poTranslator = nullptr;
+    TargetLayerInfo                *psInfo = nullptr;
+    TranslateBatch                 *psBatch = nullptr;
+    size_t                          iStart = 0;
+    size_t                          nStep = 1;
+    OGRCoordinateTransformation   **papoCT = nullptr;
+    OGRSpatialReference            *poOutputSRS = nullptr;
+    bool                            bSkipFailures = false;
+};
+} // namespace
+
+static void CPL_STDCALL TranslateErrorHandler( CPLErr eErr,
+                                               CPLErrorNum nErrorNum,
+                                               const char *pszMsg )
+{
+    if( eErr == CE_Debug )
+        return;
+    std::vector<TranslateError> *paoErrors =
+        static_cast<std::vector<TranslateError> *>(
+                                        CPLGetErrorHandlerUserData());
+    TranslateError oError;
+    oError.eErr = eErr;
+    oError.nErrorNum = nErrorNum;
+    oError.osMsg = pszMsg;
+    paoErrors->push_back(oError);
+}
+
+static void TranslateJobFunc( void *pData )
+{
+    TranslateJob *psJob = static_cast<TranslateJob *>(pData);
+    TranslateBatch *psBatch = psJob->psBatch;
+    for( size_t i = psJob->iStart; i < psBatch->aoItems.size();
+         i += psJob->nStep )
+    {
+        TranslateItem &oItem = psBatch->aoItems[i];
+        if( oItem.bSetFromFailed )
+            continue;
+        // Errors are emitted again by the calling thread, when writing
+        // the feature.
+        CPLPushErrorHandlerEx(TranslateErrorHandler, &oItem.aoErrors);
+        oItem.eStatus = psJob->poTranslator->TranslateGeometries(
+            psBatch->apoSrcFeatures[oItem.iSrcFeature].get(),
+            oItem.poDstFeature.get(), psJob->psInfo, psJob->papoCT,
+            psJob->poOutputSRS, oItem.nParts, oItem.iPart,
+            psJob->bSkipFailures, oItem.bReprojectionFailed);
+        CPLPopErrorHandler();
+    }
+}
+
+/************************************************************************/
+/*              LayerTranslator::CanTranslateMultiThreaded()            */
+/************************************************************************/
+
+bool LayerTranslator::CanTranslateMultiThreaded(
+                                    OGRFeature* poFeatureIn,
+                                    TargetLayerInfo* psInfo,
+                                    GDALVectorTranslateOptions *psOptions )
+{
+    if( m_nNumThreads <= 1 || poFeatureIn != nullptr ||
+        psOptions->nFIDToFetch != OGRNullFID )
+        return false;
+
+    // Nothing for the worker threads to do.
+    OGRLayer *poSrcLayer = psInfo->poSrcLayer;
+    OGRLayer *poDstLayer = psInfo->poDstLayer;
+    if( poDstLayer->GetLayerDefn()->GetGeomFieldCount() == 0 )
+        return false;
+
+    // GCP transformations cannot be duplicated for each worker thread.
+    if( m_poGCPCoordTrans != nullptr )
+        return false;
+
+    // Without a source SRS, the coordinate transformation is set up from
+    // the SRS of each feature geometry.
+    if( (m_bTransform || m_bWrapDateline) && m_poUserSourceSRS == nullptr )
+    {
+        if( poSrcLayer->GetSpatialRef() == nullptr )
+            return false;
+        OGRFeatureDefn* poSrcFDefn = poSrcLayer->GetLayerDefn();
+        for( int iGeom = 0; iGeom < poSrcFDefn->GetGeomFieldCount(); iGeom++ )
+        {
+            if( poSrcFDefn->GetGeomFieldDefn(iGeom)->GetSpatialRef() == nullptr )
+                return false;
+        }
+    }
+
+    return true;
+}
+
+/************************************************************************/
+/*               LayerTranslator::TranslateMultiThreaded()              */
+/************************************************************************/
+
+int LayerTranslator::TranslateMultiThreaded( TargetLayerInfo* psInfo,
+                                             OGRSpatialReference* poOutputSRS,
+                                             GIntBig nCountLayerFeatures,
+                                             GIntBig* pnReadFeatureCount,
+                                             GIntBig& nTotalEventsDone,
+                                             GDALProgressFunc pfnProgress,
+                                             void *pProgressArg,
+                                             GDALVectorTranslateOptions *psOptions )
+{
+    OGRLayer *poSrcLayer = psInfo->poSrcLayer;
+    OGRLayer *poDstLayer = psInfo->poDstLayer;
+    int* const panMap = psInfo->panMap;
+    const bool bPreserveFID = psInfo->bPreserveFID;
+    const int nSrcGeomFieldCount = poSrcLayer->GetLayerDefn()->GetGeomFieldCount();
+    const int nDstGeomFieldCount = poDstLayer->GetLayerDefn()->GetGeomFieldCount();
+    const bool bExplodeCollections = m_bExplodeCollections && nDstGeomFieldCount <= 1;
+    const int nJobs = m_nNumThreads;
+    const size_t nBatchSize = static_cast<size_t>(nJobs) * 256;
+
+    // Declared before the thread pool, whose destructor waits for the
+    // running jobs.
+    TranslateBatch aoBatches[2];
+    std::vector<TranslateJob> asJobs(nJobs);
+    std::vector<std::vector<OGRCoordinateTransformation*>> aapoJobCT(nJobs);
+    std::vector<std::unique_ptr<OGRCoordinateTransformation>> apoOwnedCT;
+
+    CPLWorkerThreadPool oThreadPool;
+    if( !oThreadPool.Setup(nJobs, nullptr, nullptr) )
+    {
+        CPLError( CE_Failure, CPLE_AppDefined,
+                  "Cannot start %d worker threads.", nJobs );
+        return false;
+    }
+
+/* -------------------------------------------------------------------- */
+/*      Transfer features.                                              */
+/* -------------------------------------------------------------------- */
+    if( psOptions->nGroupTransactions )
+    {
+        if( psOptions->nLayerTransaction )
+        {
+            if( poDstLayer->StartTransaction() == OGRERR_FAILURE )
+                return false;
+        }
+    }
+
+    int         nFeaturesInTransaction = 0;
+    GIntBig     nCount = 0; /* written + failed */
+    GIntBig     nFeaturesWritten = 0;
+
+    bool bRet = true;
+    bool bEOF = false;
+    bool bPending = false;
+    int iBatch = 0;
+    while( true )
+    {
+/* -------------------------------------------------------------------- */
+/*      Read a batch of source features and build the target features  */
+/*      from them.                                                      */
+/* -------------------------------------------------------------------- */
+        TranslateBatch& oBatch = aoBatches[iBatch];
+        while( !bEOF && oBatch.aoItems.size() < nBatchSize )
+        {
+            if( m_nLimit >= 0 && psInfo->nFeaturesRead >= m_nLimit )
+            {
+                bEOF = true;
+                break;
+            }
+
+            CPLErrorReset();
+            OGRFeature *poFeature = poSrcLayer->GetNextFeature();
+            if( poFeature == nullptr )
+            {
+                if( CPLGetLastErrorType() == CE_Failure )
+                {
+                    bRet = false;
+                }
+                bEOF = true;
+                break;
+            }
+
+            if( psInfo->nFeaturesRead == 0 )
+            {
+                if( !SetupCT( psInfo, poSrcLayer, m_bTransform, m_bWrapDateline,
+                              m_osDateLineOffset, m_poUserSourceSRS,
+                              poFeature, poOutputSRS, m_poGCPCoordTrans) )
+                {
+                    OGRFeature::DestroyFeature( poFeature );
+                    return false;
+                }
+
+                // The first job uses the coordinate transformations of
+                // psInfo, and the other ones copies of them.
+                for( int iJob = 0; iJob < nJobs; iJob++ )
+                {
+                    for( int iGeom = 0; iGeom < nDstGeomFieldCount; iGeom++ )
+                    {
+                        OGRCoordinateTransformation* poCT = psInfo->papoCT[iGeom];
+                        if( poCT != nullptr && iJob > 0 )
+                        {
+                            poCT = OGRCreateCoordinateTransformation(
+                                poCT->GetSourceCS(), poCT->GetTargetCS() );
+                            if( poCT == nullptr )
+                            {
+                                OGRFeature::DestroyFeature( poFeature );
+                                return false;
+                            }
+                            apoOwnedCT.emplace_back(poCT);
+                        }
+                        aapoJobCT[iJob].push_back(poCT);
+                    }
+                }
+            }
+
+            psInfo->nFeaturesRead ++;
+
+            int nParts = 0;
+            int nIters = 1;
+            if (bExplodeCollections)
+            {
+                OGRGeometry* poSrcGeometry;
+                if( psInfo->iRequestedSrcGeomField >= 0 )
+                    poSrcGeometry = poFeature->GetGeomFieldRef(
+                                            psInfo->iRequestedSrcGeomField);
+                else
+                    poSrcGeometry = poFeature->GetGeometryRef();
+                if (poSrcGeometry &&
+                    OGR_GT_IsSubClassOf(poSrcGeometry->getGeometryType(), wkbGeometryCollection) )
+                {
+                    nParts = poSrcGeometry->toGeometryCollection()->getNumGeometries();
+                    nIters = nParts;
+                    if (nIters == 0)
+                        nIters = 1;
+                }
+            }
+
+            const size_t iSrcFeature = oBatch.apoSrcFeatures.size();
+            oBatch.apoSrcFeatures.emplace_back(poFeature);
+            for(int iPart = 0; iPart < nIters; iPart++)
+            {
+                TranslateItem oItem;
+                oItem.iSrcFeature = iSrcFeature;
+                oItem.nParts = nParts;
+                oItem.iPart = iPart;
+                oItem.poDstFeature.reset(
+                    OGRFeature::CreateFeature( poDstLayer->GetLayerDefn() ));
+                OGRFeature* poDstFeature = oItem.poDstFeature.get();
+
+                /* Optimization to avoid duplicating the source geometry in the */
+                /* target feature : we steal it from the source feature for now... */
+                OGRGeometry* poStolenGeometry = nullptr;
+                if( !bExplodeCollections && nSrcGeomFieldCount == 1 &&
+                    nDstGeomFieldCount == 1 )
+                {
+                    poStolenGeometry = poFeature->StealGeometry();
+                }
+                else if( !bExplodeCollections &&
+                         psInfo->iRequestedSrcGeomField >= 0 )
+                {
+                    poStolenGeometry = poFeature->StealGeometry(
+                        psInfo->iRequestedSrcGeomField);
+                }
+
+                if( poDstFeature->SetFrom( poFeature, panMap, TRUE ) != OGRERR_NONE )
+                {
+                    // Reported when writing, after the previous features.
+                    OGRGeometryFactory::destroyGeometry( poStolenGeometry );
+                    oItem.bSetFromFailed = true;
+                    oBatch.aoItems.push_back(std::move(oItem));
+                    bEOF = true;
+                    break;
+                }
+
+                /* ... and now we can attach the stolen geometry */
+                if( poStolenGeometry )
+                {
+                    poDstFeature->SetGeometryDirectly(poStolenGeometry);
+                }
+
+                if( bPreserveFID )
+                    poDstFeature->SetFID( poFeature->GetFID() );
+                else if( psInfo->iSrcFIDField >= 0 &&
+                         poFeature->IsFieldSetAndNotNull(psInfo->iSrcFIDField))
+                    poDstFeature->SetFID( poFeature->GetFieldAsInteger64(psInfo->iSrcFIDField) );
+
+                /* Erase native data if asked explicitly */
+                if( !m_bNativeData )
+                {
+                    poDstFeature->SetNativeData(nullptr);
+                    poDstFeature->SetNativeMediaType(nullptr);
+                }
+
+                oBatch.aoItems.push_back(std::move(oItem));
+            }
+        }
+
+/* -------------------------------------------------------------------- */
+/*      Wait for the previous batch, and hand this one to the workers.  */
+/* -------------------------------------------------------------------- */
+        oThreadPool.WaitCompletion();
+
+        if( !oBatch.aoItems.empty() )
+        {
+            std::vector<void*> apJobs;
+            for( int iJob = 0; iJob < nJobs; iJob++ )
+            {
+                TranslateJob& sJob = asJobs[iJob];
+                sJob.poTranslator = this;
+                sJob.psInfo = psInfo;
+                sJob.psBatch = &oBatch;
+                sJob.iStart = iJob;
+                sJob.nStep = nJobs;
+                sJob.papoCT = aapoJobCT[iJob].data();
+                sJob.poOutputSRS = poOutputSRS;
+                sJob.bSkipFailures = psOptions->bSkipFailures;
+                if( sJob.iStart < oBatch.aoItems.size() )
+                    apJobs.push_back(&sJob);
+            }
+            oThreadPool.SubmitJobs(TranslateJobFunc, apJobs);
+        }
+
+/* -------------------------------------------------------------------- */
+/*      Write the previous batch.                                       */
+/* -------------------------------------------------------------------- */
+        TranslateBatch& oPrevBatch = aoBatches[1 - iBatch];
+        bool bStop = false;
+        for( size_t i = 0; bPending && i < oPrevBatch.aoItems.size(); i++ )
+        {
+            TranslateItem& oItem = oPrevBatch.aoItems[i];
+            OGRFeature *poFeature =
+                oPrevBatch.apoSrcFeatures[oItem.iSrcFeature].get();
+
+            if( !AdvanceTransaction( psInfo, nFeaturesInTransaction,
+                                     nTotalEventsDone, psOptions ) )
+            {
+                return false;
+            }
+
+            if( oItem.bSetFromFailed )
+            {
+                if( psOptions->nGroupTransactions )
+                {
+                    if( psOptions->nLayerTransaction )
+                    {
+                        if( poDstLayer->CommitTransaction() != OGRERR_NONE )
+                            return false;
+                    }
+                }
+
+                CPLError( CE_Failure, CPLE_AppDefined,
+                        "Unable to translate feature " CPL_FRMT_GIB " from layer %s.",
+                        poFeature->GetFID(), poSrcLayer->GetName() );
+                return false;
+            }
+
+            for( const auto& oError: oItem.aoErrors )
+                CPLError( oError.eErr, oError.nErrorNum, "%s",
+                          oError.osMsg.c_str() );
+            if( oItem.bReprojectionFailed &&
+                psOptions->nGroupTransactions &&
+                psOptions->nLayerTransaction )
+            {
+                CPL_IGNORE_RET_VAL(poDstLayer->CommitTransaction());
+            }
+            if( oItem.eStatus == TRANSLATE_GEOM_FAILED )
+                return false;
+
+            if( oItem.eStatus == TRANSLATE_GEOM_OK &&
+                !WriteFeature( poFeature, oItem.poDstFeature.get(), psInfo,
+                               nFeaturesWritten, psOptions ) )
+            {
+                return false;
+            }
+            oItem.poDstFeature.reset();
+
+            // Wait for the last part of the source feature.
+            if( i + 1 < oPrevBatch.aoItems.size() &&
+                oPrevBatch.aoItems[i + 1].iSrcFeature == oItem.iSrcFeature )
+            {
+                continue;
+            }
+            oPrevBatch.apoSrcFeatures[oItem.iSrcFeature].reset();
+
+            /* Report progress */
+            nCount ++;
+            bool bGoOn = true;
+            if (pfnProgress)
+            {
+                bGoOn = pfnProgress(nCountLayerFeatures ? nCount * 1.0 / nCountLayerFeatures: 1.0, "", pProgressArg) != FALSE;
+            }
+            if( !bGoOn )
+            {
+                bRet = false;
+                bStop = true;
+                break;
+            }
+
+            if (pnReadFeatureCount)
+                *pnReadFeatureCount = nCount;
+        }
+        if( bStop )
+            break;
+        oPrevBatch.aoItems.clear();
+        oPrevBatch.apoSrcFeatures.clear();
+
+        // An empty batch means that the end of the layer was reached.
+        bPending = !oBatch.aoItems.empty();
+        if( !bPending )
+            break;
+        iBatch = 1 - iBatch;
+    }
+
+    if( psOptions->nGroupTransactions )
+    {
+        if( psOptions->nLayerTransaction )
+        {
+            if( poDstLayer->CommitTransaction() != OGRERR_NONE )
+                bRet = false;
+        }
+    }
+
+    CPLDebug("GDALVectorTranslate",
+             CPL_FRMT_GIB " features written in layer '%s' with %d threads",
+             nFeaturesWritten, poDstLayer->GetName(), nJobs);
+
+    return bRet;
+}
+
 /************************************************************************/
 /*                     LayerTranslator::Translate()                     */
 /************************************************************************/
@@ -4348,13 +5154,11 @@ int LayerTranslator::Translate( OGRFeature* poFeatureIn,
                                 void *pProgressArg,
                                 GDALVectorTranslateOptions *psOptions )
 {
-    const int eGType = m_eGType;
     OGRSpatialReference* poOutputSRS = m_poOutputSRS;
 
     OGRLayer *poSrcLayer = psInfo->poSrcLayer;
     OGRLayer *poDstLayer = psInfo->poDstLayer;
     int* const panMap = psInfo->panMap;
-    const int iSrcZField = psInfo->iSrcZField;
     const bool bPreserveFID = psInfo->bPreserveFID;
     const int nSrcGeomFieldCount = poSrcLayer->GetLayerDefn()->GetGeomFieldCount();
     const int nDstGeomFieldCount = poDstLayer->GetLayerDefn()->GetGeomFieldCount();
@@ -4373,6 +5177,14 @@ int LayerTranslator::Translate( OGRFeature* poFeatureIn,
         }
     }
 
+    if( CanTranslateMultiThreaded( poFeatureIn, psInfo, psOptions ) )
+    {
+        return TranslateMultiThreaded( psInfo, poOutputSRS,
+                                       nCountLayerFeatures,
+                                       pnReadFeatureCount, nTotalEventsDone,
+                                       pfnProgress, pProgressArg, psOptions );
+    }
+
 /* -------------------------------------------------------------------- */
 /*      Transfer features.                                              */
 /* -------------------------------------------------------------------- */
@@ -4451,28 +5263,11 @@ int LayerTranslator::Translate( OGRFeature* poFeatureIn,
         OGRFeature *poDstFeature = nullptr;
         for(int iPart = 0; iPart < nIters; iPart++)
         {
-            if( psOptions->nLayerTransaction &&
-                ++nFeaturesInTransaction == psOptions->nGroupTransactions )
-            {
-                if( poDstLayer->CommitTransaction() == OGRERR_FAILURE ||
-                    poDstLayer->StartTransaction() == OGRERR_FAILURE )
-                {
-                    OGRFeature::DestroyFeature( poFeature );
-                    return false;
-                }
-                nFeaturesInTransaction = 0;
-            }
-            else if( !psOptions->nLayerTransaction &&
-                     psOptions->nGroupTransactions >= 0 &&
-                     ++nTotalEventsDone >= psOptions->nGroupTransactions )
+            if( !AdvanceTransaction( psInfo, nFeaturesInTransaction,
+                                     nTotalEventsDone, psOptions ) )
             {
-                if( m_poODS->CommitTransaction() == OGRERR_FAILURE ||
-                        m_poODS->StartTransaction(psOptions->bForceTransaction) == OGRERR_FAILURE )
-                {
-                    OGRFeature::DestroyFeature( poFeature );
-                    return false;
-                }
-                nTotalEventsDone = 0;
+                OGRFeature::DestroyFeature( poFeature );
+                return false;
             }
 
             CPLErrorReset();
@@ -4552,210 +5347,38 @@ int LayerTranslator::Translate( OGRFeature* poFeatureIn,
                 poDstFeature->SetNativeMediaType(nullptr);
             }
 
-            for( int iGeom = 0; iGeom < nDstGeomFieldCount; iGeom ++ )
             {
-                OGRGeometry* poDstGeometry = poDstFeature->StealGeometry(iGeom);
-                if (poDstGeometry == nullptr)
-                    continue;
-
-                if (nParts > 0)
-                {
-                    /* For -explodecollections, extract the iPart(th) of the geometry */
-                    OGRGeometry* poPart = poDstGeometry->toGeometryCollection()->getGeometryRef(iPart);
-                    poDstGeometry->toGeometryCollection()->removeGeometry(iPart, FALSE);
-                    delete poDstGeometry;
-                    poDstGeometry = poPart;
-                    assert(poDstGeometry);
-                }
-
-                if (iSrcZField != -1)
+                bool bReprojectionFailed = false;
+                const TranslateGeomStatus eStatus =
+                    TranslateGeometries( poFeature, poDstFeature, psInfo,
+                                         psInfo->papoCT, poOutputSRS,
+                                         nParts, iPart,
+                                         psOptions->bSkipFailures,
+                                         bReprojectionFailed );
+                if( bReprojectionFailed &&
+                    psOptions->nGroupTransactions &&
+                    psOptions->nLayerTransaction )
                 {
-                    SetZ(poDstGeometry, poFeature->GetFieldAsDouble(iSrcZField));
-                    /* This will correct the coordinate dimension to 3 */
-                    OGRGeometry* poDupGeometry = poDstGeometry->clone();
-                    delete poDstGeometry;
-                    poDstGeometry = poDupGeometry;
+                    CPL_IGNORE_RET_VAL(poDstLayer->CommitTransaction());
                 }
-
-                if (m_nCoordDim == 2 || m_nCoordDim == 3)
+                if( eStatus == TRANSLATE_GEOM_FAILED )
                 {
-                    poDstGeometry->setCoordinateDimension( m_nCoordDim );
-                }
-                else if (m_nCoordDim == 4)
-                {
-                    poDstGeometry->set3D( TRUE );
-                    poDstGeometry->setMeasured( TRUE );
-                }
-                else if (m_nCoordDim == COORD_DIM_XYM)
-                {
-                    poDstGeometry->set3D( FALSE );
-                    poDstGeometry->setMeasured( TRUE );
-                }
-                else if ( m_nCoordDim == COORD_DIM_LAYER_DIM )
-                {
-                    const OGRwkbGeometryType eDstLayerGeomType =
-                      poDstLayer->GetLayerDefn()->GetGeomFieldDefn(iGeom)->GetType();
-                    poDstGeometry->set3D( wkbHasZ(eDstLayerGeomType) );
-                    poDstGeometry->setMeasured( wkbHasM(eDstLayerGeomType) );
-                }
-
-                if (m_eGeomOp == GEOMOP_SEGMENTIZE)
-                {
-                    if (m_dfGeomOpParam > 0)
-                        poDstGeometry->segmentize(m_dfGeomOpParam);
-                }
-                else if (m_eGeomOp == GEOMOP_SIMPLIFY_PRESERVE_TOPOLOGY)
-                {
-                    if (m_dfGeomOpParam > 0)
-                    {
-                        OGRGeometry* poNewGeom = poDstGeometry->SimplifyPreserveTopology(m_dfGeomOpParam);
-                        if (poNewGeom)
-                        {
-                            delete poDstGeometry;
-                            poDstGeometry = poNewGeom;
-                        }
-                    }
-                }
-
-                if (m_poClipSrc)
-                {
-                    OGRGeometry* poClipped = poDstGeometry->Intersection(m_poClipSrc);
-                    delete poDstGeometry;
-                    if (poClipped == nullptr || poClipped->IsEmpty())
-                    {
-                        delete poClipped;
-                        goto end_loop;
-                    }
-                    poDstGeometry = poClipped;
-                }
-
-                OGRCoordinateTransformation* poCT = psInfo->papoCT[iGeom];
-                if( !m_bTransform )
-                    poCT = m_poGCPCoordTrans;
-                char** papszTransformOptions = psInfo->papapszTransformOptions[iGeom];
-
-                if( poCT != nullptr || papszTransformOptions != nullptr)
-                {
-                    OGRGeometry* poReprojectedGeom =
-                        OGRGeometryFactory::transformWithOptions(poDstGeometry, poCT, papszTransformOptions);
-                    if( poReprojectedGeom == nullptr )
-                    {
-                        if( psOptions->nGroupTransactions )
-                        {
-                            if( psOptions->nLayerTransaction )
-                            {
-                                if( poDstLayer->CommitTransaction() != OGRERR_NONE &&
-                                    !psOptions->bSkipFailures )
-                                {
-                                    OGRFeature::DestroyFeature( poFeature );
-                                    OGRFeature::DestroyFeature( poDstFeature );
-                                    delete poDstGeometry;
-                                    return false;
-                                }
-                            }
-                        }
-
-                        CPLError( CE_Failure, CPLE_AppDefined, "Failed to reproject feature " CPL_FRMT_GIB " (geometry probably out of source or destination SRS).",
-                                  poFeature->GetFID() );
-                        if( !psOptions->bSkipFailures )
-                        {
-                            OGRFeature::DestroyFeature( poFeature );
-                            OGRFeature::DestroyFeature( poDstFeature );
-                            delete poDstGeometry;
-                            return false;
-                        }
-                    }
-
-                    delete poDstGeometry;
-                    poDstGeometry = poReprojectedGeom;
-                }
-                else if (poOutputSRS != nullptr)
-                {
-                    poDstGeometry->assignSpatialReference(poOutputSRS);
-                }
-
-                if (m_poClipDst)
-                {
-                    if( poDstGeometry == nullptr )
-                        goto end_loop;
-
-                    OGRGeometry* poClipped = poDstGeometry->Intersection(m_poClipDst);
-                    delete poDstGeometry;
-                    if (poClipped == nullptr || poClipped->IsEmpty())
-                    {
-                        delete poClipped;
-                        goto end_loop;
-                    }
-
-                    poDstGeometry = poClipped;
-                }
-
-                if( eGType != GEOMTYPE_UNCHANGED )
-                {
-                    poDstGeometry = OGRGeometryFactory::forceTo(
-                            poDstGeometry, static_cast<OGRwkbGeometryType>(eGType));
-                }
-                else if( m_eGeomTypeConversion == GTC_PROMOTE_TO_MULTI ||
-                         m_eGeomTypeConversion == GTC_CONVERT_TO_LINEAR ||
-                         m_eGeomTypeConversion == GTC_CONVERT_TO_CURVE )
-                {
-                    if( poDstGeometry != nullptr )
-                    {
-                        OGRwkbGeometryType eTargetType = poDstGeometry->getGeometryType();
-                        eTargetType = ConvertType(m_eGeomTypeConversion, eTargetType);
-                        poDstGeometry = OGRGeometryFactory::forceTo(poDstGeometry, eTargetType);
-                    }
-                }
-
-                poDstFeature->SetGeomFieldDirectly(iGeom, poDstGeometry);
-            }
-
-            CPLErrorReset();
-            if( poDstLayer->CreateFeature( poDstFeature ) == OGRERR_NONE )
-            {
-                nFeaturesWritten ++;
-                if( (bPreserveFID && poDstFeature->GetFID() != poFeature->GetFID()) ||
-                    (!bPreserveFID && psInfo->iSrcFIDField >= 0 && poFeature->IsFieldSetAndNotNull(psInfo->iSrcFIDField) &&
-                     poDstFeature->GetFID() != poFeature->GetFieldAsInteger64(psInfo->iSrcFIDField)) )
-                {
-                    CPLError( CE_Warning, CPLE_AppDefined,
-                              "Feature id not preserved");
+                    OGRFeature::DestroyFeature( poFeature );
+                    OGRFeature::DestroyFeature( poDstFeature );
+                    return false;
                 }
+                if( eStatus == TRANSLATE_GEOM_CLIPPED_OUT )
+                    goto end_loop;
             }
-            else if( !psOptions->bSkipFailures )
-            {
-                if( psOptions->nGroupTransactions )
-                {
-                    if( psOptions->nLayerTransaction )
-                        poDstLayer->RollbackTransaction();
-                }
 
-                CPLError( CE_Failure, CPLE_AppDefined,
-                        "Unable to write feature " CPL_FRMT_GIB " from layer %s.",
-                        poFeature->GetFID(), poSrcLayer->GetName() );
 
+            if( !WriteFeature( poFeature, poDstFeature, psInfo,
+                               nFeaturesWritten, psOptions ) )
+            {
                 OGRFeature::DestroyFeature( poFeature );
                 OGRFeature::DestroyFeature( poDstFeature );
                 return false;
             }
-            else
-            {
-                CPLDebug( "GDALVectorTranslate", "Unable to write feature " CPL_FRMT_GIB " into layer %s.",
-                           poFeature->GetFID(), poSrcLayer->GetName() );
-                if( psOptions->nGroupTransactions )
-                {
-                    if( psOptions->nLayerTransaction )
-                    {
-                        poDstLayer->RollbackTransaction();
-                        CPL_IGNORE_RET_VAL(poDstLayer->StartTransaction());
-                    }
-                    else
-                    {
-                        m_poODS->RollbackTransaction();
-                        m_poODS->StartTransaction(psOptions->bForceTransaction);
-                    }
-                }
-            }
 
 end_loop:
             OGRFeature::DestroyFeature( poDstFeature );
@@ -4833,6 +5456,17 @@ static void RemoveSQLComments(char*& pszSQL)
     pszSQL = CPLStrdup(osSQL);
 }
 
+/************************************************************************/
+/*                            GetNumThreads()                           */
+/************************************************************************/
+
+static int GetNumThreads(const char* pszValue)
+{
+    const int nThreads = EQUAL(pszValue, "ALL_CPUS") ? CPLGetNumCPUs()
+                                                     : atoi(pszValue);
+    return std::max(1, std::min(128, nThreads));
+}
+
 /************************************************************************/
 /*                       GDALVectorTranslateOptionsNew()                */
 /************************************************************************/
@@ -4921,6 +5555,10 @@ GDALVectorTranslateOptions *GDALVectorTranslateOptionsNew(char** papszArgv,
     psOptions->hSpatialFilter = nullptr;
     psOptions->bNativeData = true;
     psOptions->nLimit = -1;
+    psOptions->nNumThreads = 1;
+    const char* pszNumThreads = CPLGetConfigOption("GDAL_NUM_THREADS", nullptr);
+    if( pszNumThreads )
+        psOptions->nNumThreads = GetNumThreads(pszNumThreads);
 
     int nArgc = CSLCount(papszArgv);
     for( int i = 0; papszArgv != nullptr && i < nArgc; i++ )
@@ -5507,6 +6145,10 @@ GDALVectorTranslateOptions *GDALVectorTranslateOptionsNew(char** papszArgv,
         {
             psOptions->nLimit = CPLAtoGIntBig( papszArgv[++i] );
         }
+        else if( i+1 < nArgc && EQUAL(papszArgv[i],"-num_threads") )
+        {
+            psOptions->nNumThreads = GetNumThreads( papszArgv[++i] );
+        }
         else if( papszArgv[i][0] == '-' )
         {
             CPLError(CE_Failure, CPLE_NotSupported,
@@ -0,0 +1,511 @@
+/******************************************************************************
+ *
+ * Project:  COG Driver
+ * Purpose:  Cloud optimized GeoTIFF write support.
+ *
+ ******************************************************************************
+ * Copyright (c) 2018, GDAL contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ ****************************************************************************/
+
+#include "cpl_port.h"
+#include "gtiff.h"
+
+#include <vector>
+
+#include "cpl_conv.h"
+#include "cpl_string.h"
+#include "cpl_vsi.h"
+#include "gdal.h"
+#include "gdal_frmts.h"
+#include "gdal_priv.h"
+#include "tiffio.h"
+
+CPL_CVSID("$Id$")
+
+/************************************************************************/
+/*                          COGNeedsLocalCopy()                         */
+/*                                                                      */
+/*      The GTiff driver needs to seek back in the file to update the   */
+/*      IFDs and tile indexes, which the network file systems do not    */
+/*      support: they only accept sequential writing.                   */
+/************************************************************************/
+
+static bool COGNeedsLocalCopy( const char* pszFilename )
+{
+    return STARTS_WITH(pszFilename, "/vsis3/") ||
+           STARTS_WITH(pszFilename, "/vsigs/") ||
+           STARTS_WITH(pszFilename, "/vsiaz/") ||
+           STARTS_WITH(pszFilename, "/vsioss/") ||
+           STARTS_WITH(pszFilename, "/vsiswift/");
+}
+
+/************************************************************************/
+/*                           COGUploadFile()                            */
+/************************************************************************/
+
+static bool COGUploadFile( const char* pszSrcFilename,
+                           const char* pszDstFilename,
+                           GDALProgressFunc pfnProgress, void* pProgressData )
+{
+    VSILFILE* fpIn = VSIFOpenL(pszSrcFilename, "rb");
+    if( fpIn == nullptr )
+    {
+        CPLError(CE_Failure, CPLE_OpenFailed, "Cannot open %s",
+                 pszSrcFilename);
+        return false;
+    }
+    VSILFILE* fpOut = VSIFOpenL(pszDstFilename, "wb");
+    if( fpOut == nullptr )
+    {
+        CPLError(CE_Failure, CPLE_OpenFailed, "Cannot create %s",
+                 pszDstFilename);
+        CPL_IGNORE_RET_VAL(VSIFCloseL(fpIn));
+        return false;
+    }
+
+    CPL_IGNORE_RET_VAL(VSIFSeekL(fpIn, 0, SEEK_END));
+    const vsi_l_offset nFileSize = VSIFTellL(fpIn);
+    CPL_IGNORE_RET_VAL(VSIFSeekL(fpIn, 0, SEEK_SET));
+
+    constexpr size_t nBufferSize = 1024 * 1024;
+    std::vector<GByte> abyBuffer(nBufferSize);
+    vsi_l_offset nCopied = 0;
+    bool bRet = true;
+    while( bRet )
+    {
+        const size_t nRead = VSIFReadL(&abyBuffer[0], 1, nBufferSize, fpIn);
+        if( nRead == 0 )
+            break;
+        if( VSIFWriteL(&abyBuffer[0], 1, nRead, fpOut) != nRead )
+        {
+            CPLError(CE_Failure, CPLE_FileIO, "Write error in %s",
+                     pszDstFilename);
+            bRet = false;
+            break;
+        }
+        nCopied += nRead;
+        if( nFileSize != 0 &&
+            !pfnProgress(static_cast<double>(nCopied) / nFileSize, nullptr,
+                         pProgressData) )
+        {
+            CPLError(CE_Failure, CPLE_UserInterrupt, "User terminated");
+            bRet = false;
+        }
+    }
+    CPL_IGNORE_RET_VAL(VSIFCloseL(fpIn));
+    // Closing terminates the upload on network file systems.
+    if( VSIFCloseL(fpOut) != 0 && bRet )
+    {
+        CPLError(CE_Failure, CPLE_FileIO, "Write error in %s",
+                 pszDstFilename);
+        bRet = false;
+    }
+    if( bRet && nCopied != nFileSize )
+    {
+        CPLError(CE_Failure, CPLE_FileIO, "Read error in %s", pszSrcFilename);
+        bRet = false;
+    }
+    return bRet;
+}
+
+/************************************************************************/
+/*                         COGGetTmpFilename()                          */
+/************************************************************************/
+
+static CPLString COGGetTmpFilename( const char* pszStem, bool bInMemory )
+{
+    CPLString osTmpFilename(CPLGenerateTempFilename(pszStem));
+    if( bInMemory )
+        osTmpFilename = CPLString("/vsimem/") + CPLGetFilename(osTmpFilename);
+    return osTmpFilename + ".tif";
+}
+
+/************************************************************************/
+/*                       COGBuildTmpOverviews()                         */
+/*                                                                      */
+/*      Compute the overview levels of the bands in a temporary TIFF    */
+/*      file, whose main image is the first level. Each level is       */
+/*      computed from the previous one, so the source is only read     */
+/*      once.                                                           */
+/************************************************************************/
+
+static bool COGBuildTmpOverviews( const char* pszTmpFilename,
+                                  int nBands, GDALRasterBand** papoBands,
+                                  const std::vector<int>& anOverviewFactors,
+                                  const char* pszResampling, int nBlockSize,
+                                  GDALProgressFunc pfnProgress,
+                                  void* pProgressData )
+{
+    // The overviews are generated block by block for all the bands only
+    // if they are compressed.
+    CPLConfigOptionSetter oCompress("COMPRESS_OVERVIEW", "LZW", false);
+    CPLConfigOptionSetter oPredictor("PREDICTOR_OVERVIEW", nullptr, false);
+    CPLConfigOptionSetter oInterleave("INTERLEAVE_OVERVIEW", "PIXEL", false);
+    CPLConfigOptionSetter oPhotometric("PHOTOMETRIC_OVERVIEW", nullptr, false);
+    CPLConfigOptionSetter oBigTIFF("BIGTIFF_OVERVIEW", "IF_SAFER", false);
+    CPLConfigOptionSetter oBlockSize("GDAL_TIFF_OVR_BLOCKSIZE",
+                                     CPLSPrintf("%d", nBlockSize), false);
+
+    std::vector<int> anFactors(anOverviewFactors);
+    return GTIFFBuildOverviews( pszTmpFilename, nBands, papoBands,
+                                static_cast<int>(anFactors.size()),
+                                &anFactors[0], pszResampling,
+                                pfnProgress, pProgressData ) == CE_None;
+}
+
+/************************************************************************/
+/*                            COGCreateCopy()                           */
+/************************************************************************/
+
+static GDALDataset* COGCreateCopy( const char * pszFilename,
+                                   GDALDataset *poSrcDS,
+                                   int /* bStrict */, char ** papszOptions,
+                                   GDALProgressFunc pfnProgress,
+                                   void * pProgressData )
+{
+    if( pfnProgress == nullptr )
+        pfnProgress = GDALDummyProgress;
+
+    const int nBands = poSrcDS->GetRasterCount();
+    if( nBands == 0 )
+    {
+        CPLError( CE_Failure, CPLE_NotSupported,
+                  "COG driver does not support source datasets with "
+                  "zero bands." );
+        return nullptr;
+    }
+
+    const char* pszBlockSize =
+        CSLFetchNameValueDef(papszOptions, "BLOCKSIZE", "512");
+    const int nBlockSize = atoi(pszBlockSize);
+    // Overviews have the same block size as the full resolution image,
+    // which is limited by GTIFFGetOverviewBlockSize().
+    if( nBlockSize < 64 || nBlockSize > 4096 ||
+        !CPLIsPowerOfTwo(nBlockSize) )
+    {
+        CPLError( CE_Failure, CPLE_IllegalArg,
+                  "BLOCKSIZE=%s is invalid: should be a power of two "
+                  "between 64 and 4096.", pszBlockSize );
+        return nullptr;
+    }
+
+/* -------------------------------------------------------------------- */
+/*      Which overviews to write?                                       */
+/* -------------------------------------------------------------------- */
+    const int nXSize = poSrcDS->GetRasterXSize();
+    const int nYSize = poSrcDS->GetRasterYSize();
+    GDALRasterBand* poFirstBand = poSrcDS->GetRasterBand(1);
+    const char* pszOverviews =
+        CSLFetchNameValueDef(papszOptions, "OVERVIEWS", "AUTO");
+    const bool bCopySrcOverviews =
+        EQUAL(pszOverviews, "AUTO") && poFirstBand->GetOverviewCount() > 0;
+
+    std::vector<int> anOverviewFactors;
+    if( !EQUAL(pszOverviews, "NONE") && !bCopySrcOverviews )
+    {
+        // Halve the dimensions until the smallest level fits in one tile.
+        int nOvrFactor = 1;
+        while( DIV_ROUND_UP(nXSize, nOvrFactor) > nBlockSize ||
+               DIV_ROUND_UP(nYSize, nOvrFactor) > nBlockSize )
+        {
+            nOvrFactor *= 2;
+            anOverviewFactors.push_back(nOvrFactor);
+        }
+    }
+
+    const char* pszResampling = CSLFetchNameValueDef(
+        papszOptions, "RESAMPLING",
+        poFirstBand->GetColorTable() != nullptr ? "NEAREST" : "AVERAGE");
+
+    const bool bPerDatasetMask =
+        poFirstBand->GetMaskFlags() == GMF_PER_DATASET;
+
+/* -------------------------------------------------------------------- */
+/*      Share progress between computing the overviews, writing the     */
+/*      file and uploading it.                                          */
+/* -------------------------------------------------------------------- */
+    const bool bLocalCopy = COGNeedsLocalCopy(pszFilename);
+    const double dfWriteEnd = bLocalCopy ? 0.9 : 1.0;
+    // Computing the overviews reads the source once, and writing the
+    // file reads it again plus the overviews, that is about 1/3 more.
+    const double dfOverviewsEnd =
+        anOverviewFactors.empty() ? 0.0 : dfWriteEnd * 3.0 / 7.0;
+
+/* -------------------------------------------------------------------- */
+/*      Compute the overviews in a temporary file, in memory if it      */
+/*      fits in the block cache.                                        */
+/* -------------------------------------------------------------------- */
+    CPLString osOvrTmpFilename;
+    CPLString osMaskOvrTmpFilename;
+    bool bOK = true;
+    if( !anOverviewFactors.empty() )
+    {
+        double dfOverviewsSize = 0.0;
+        for( const int nOvrFactor : anOverviewFactors )
+        {
+            dfOverviewsSize +=
+                static_cast<double>(DIV_ROUND_UP(nXSize, nOvrFactor)) *
+                DIV_ROUND_UP(nYSize, nOvrFactor);
+        }
+        dfOverviewsSize *= nBands *
+            GDALGetDataTypeSizeBytes(poFirstBand->GetRasterDataType());
+        const bool bInMemory =
+            dfOverviewsSize <= static_cast<double>(GDALGetCacheMax64());
+        CPLDebug("COG", "Computing %d overview levels %s",
+                 static_cast<int>(anOverviewFactors.size()),
+                 bInMemory ? "in memory" : "in a temporary file");
+
+        std::vector<GDALRasterBand*> apoBands;
+        for( int i = 1; i <= nBands; ++i )
+            apoBands.push_back(poSrcDS->GetRasterBand(i));
+
+        const double dfMaskEnd = bPerDatasetMask ?
+            dfOverviewsEnd / (nBands + 1) : 0.0;
+        if( bPerDatasetMask )
+        {
+            osMaskOvrTmpFilename = COGGetTmpFilename("cog_msk", bInMemory);
+            GDALRasterBand* poMaskBand = poFirstBand->GetMaskBand();
+            void* pScaledProgress = GDALCreateScaledProgress(
+                0.0, dfMaskEnd, pfnProgress, pProgressData);
+            bOK = COGBuildTmpOverviews(osMaskOvrTmpFilename, 1, &poMaskBand,
+                                       anOverviewFactors, pszResampling,
+                                       nBlockSize, GDALScaledProgress,
+                                       pScaledProgress);
+            GDALDestroyScaledProgress(pScaledProgress);
+        }
+
+        osOvrTmpFilename = COGGetTmpFilename("cog_ovr", bInMemory);
+        if( bOK )
+        {
+            void* pScaledProgress = GDALCreateScaledProgress(
+                dfMaskEnd, dfOverviewsEnd, pfnProgress, pProgressData);
+            bOK = COGBuildTmpOverviews(osOvrTmpFilename, nBands, &apoBands[0],
+                                       anOverviewFactors, pszResampling,
+                                       nBlockSize, GDALScaledProgress,
+                                       pScaledProgress);
+            GDALDestroyScaledProgress(pScaledProgress);
+        }
+    }
+
+/* -------------------------------------------------------------------- */
+/*      Write the file with the GTiff driver. COPY_SRC_OVERVIEWS        */
+/*      writes all the IFDs first, then the imagery from the smallest   */
+/*      overview to the full resolution image.                          */
+/* -------------------------------------------------------------------- */
+    CPLStringList aosOptions;
+    aosOptions.SetNameValue("TILED", "YES");
+    aosOptions.SetNameValue("BLOCKXSIZE", pszBlockSize);
+    aosOptions.SetNameValue("BLOCKYSIZE", pszBlockSize);
+    const char* pszCompress =
+        CSLFetchNameValueDef(papszOptions, "COMPRESS", "LZW");
+    aosOptions.SetNameValue("COMPRESS", pszCompress);
+    if( EQUAL(pszCompress, "JPEG") && nBands == 3 &&
+        poFirstBand->GetRasterDataType() == GDT_Byte &&
+        poFirstBand->GetColorTable() == nullptr )
+    {
+        aosOptions.SetNameValue("PHOTOMETRIC", "YCBCR");
+    }
+    static const char* const apszForwardedOptions[] = {
+        "NUM_THREADS", "PREDICTOR", "ZLEVEL", "ZSTD_LEVEL", "JPEG_QUALITY",
+        "WEBP_LEVEL", "WEBP_LOSSLESS", "MAX_Z_ERROR", "BIGTIFF", nullptr };
+    for( int i = 0; apszForwardedOptions[i] != nullptr; ++i )
+    {
+        const char* pszValue =
+            CSLFetchNameValue(papszOptions, apszForwardedOptions[i]);
+        if( pszValue )
+            aosOptions.SetNameValue(apszForwardedOptions[i], pszValue);
+    }
+    if( bCopySrcOverviews || !anOverviewFactors.empty() )
+        aosOptions.SetNameValue("COPY_SRC_OVERVIEWS", "YES");
+    if( !osOvrTmpFilename.empty() )
+        aosOptions.SetNameValue("@OVERVIEW_DATASET", osOvrTmpFilename);
+    if( !osMaskOvrTmpFilename.empty() )
+        aosOptions.SetNameValue("@MASK_OVERVIEW_DATASET",
+                                osMaskOvrTmpFilename);
+
+    const CPLString osTargetFilename = bLocalCopy ?
+        COGGetTmpFilename(CPLGetBasename(pszFilename), false) :
+        CPLString(pszFilename);
+
+    GDALDataset* poDS = nullptr;
+    GDALDriver* poGTiffDriver =
+        GetGDALDriverManager()->GetDriverByName("GTiff");
+    if( bOK && poGTiffDriver == nullptr )
+    {
+        CPLError(CE_Failure, CPLE_AppDefined, "GTiff driver not available");
+        bOK = false;
+    }
+    if( bOK )
+    {
+        // The overviews must have the same block size as the main image,
+        // and the mask must be in the file.
+        CPLConfigOptionSetter oBlockSize("GDAL_TIFF_OVR_BLOCKSIZE",
+                                         pszBlockSize, false);
+        CPLConfigOptionSetter oInternalMask("GDAL_TIFF_INTERNAL_MASK", "YES",
+                                            false);
+
+        void* pScaledProgress = GDALCreateScaledProgress(
+            dfOverviewsEnd, dfWriteEnd, pfnProgress, pProgressData);
+        poDS = poGTiffDriver->CreateCopy(osTargetFilename, poSrcDS, FALSE,
+                                         aosOptions.List(),
+                                         GDALScaledProgress, pScaledProgress);
+        GDALDestroyScaledProgress(pScaledProgress);
+    }
+
+    if( !osOvrTmpFilename.empty() )
+        VSIUnlink(osOvrTmpFilename);
+    if( !osMaskOvrTmpFilename.empty() )
+        VSIUnlink(osMaskOvrTmpFilename);
+
+    if( poDS == nullptr || !bLocalCopy )
+        return poDS;
+
+/* -------------------------------------------------------------------- */
+/*      Upload the local file sequentially.                             */
+/* -------------------------------------------------------------------- */
+    GDALClose(poDS);
+    poDS = nullptr;
+
+    void* pScaledProgress = GDALCreateScaledProgress(
+        dfWriteEnd, 1.0, pfnProgress, pProgressData);
+    bOK = COGUploadFile(osTargetFilename, pszFilename,
+                        GDALScaledProgress, pScaledProgress);
+    GDALDestroyScaledProgress(pScaledProgress);
+    VSIUnlink(osTargetFilename);
+    if( !bOK )
+        return nullptr;
+
+    return GDALDataset::Open(pszFilename,
+                             GDAL_OF_RASTER | GDAL_OF_VERBOSE_ERROR);
+}
+
+/************************************************************************/
+/*                          GDALRegister_COG()                          */
+/************************************************************************/
+
+void GDALRegister_COG()
+
+{
+    if( GDALGetDriverByName( "COG" ) != nullptr )
+        return;
+
+/* -------------------------------------------------------------------- */
+/*      Advertise the compression methods which are available, and      */
+/*      which make sense for a cloud optimized GeoTIFF.                 */
+/* -------------------------------------------------------------------- */
+    CPLString osCompressValues("       <Value>NONE</Value>");
+    bool bHasJPEG = false;
+    bool bHasDEFLATE = false;
+    bool bHasZSTD = false;
+    bool bHasWebP = false;
+    TIFFCodec *codecs = TIFFGetConfiguredCODECs();
+    for( TIFFCodec *c = codecs; c->name; ++c )
+    {
+        if( c->scheme == COMPRESSION_JPEG )
+        {
+            bHasJPEG = true;
+            osCompressValues += "       <Value>JPEG</Value>";
+        }
+        else if( c->scheme == COMPRESSION_LZW )
+        {
+            osCompressValues += "       <Value>LZW</Value>";
+        }
+        else if( c->scheme == COMPRESSION_ADOBE_DEFLATE )
+        {
+            bHasDEFLATE = true;
+            osCompressValues += "       <Value>DEFLATE</Value>";
+        }
+        else if( c->scheme == COMPRESSION_LZMA )
+        {
+            osCompressValues += "       <Value>LZMA</Value>";
+        }
+        else if( c->scheme == COMPRESSION_ZSTD )
+        {
+            bHasZSTD = true;
+            osCompressValues += "       <Value>ZSTD</Value>";
+        }
+        else if( c->scheme == COMPRESSION_WEBP )
+        {
+            bHasWebP = true;
+            osCompressValues += "       <Value>WEBP</Value>";
+        }
+    }
+    _TIFFfree( codecs );
+
+    CPLString osOptions;
+    osOptions =
+"<CreationOptionList>"
+"   <Option name='COMPRESS' type='string-select' default='LZW'>";
+    osOptions += osCompressValues;
+    osOptions +=
+"   </Option>";
+    if( bHasDEFLATE )
+        osOptions +=
+"   <Option name='ZLEVEL' type='int' description='DEFLATE compression level 1-9' default='6'/>";
+    if( bHasZSTD )
+        osOptions +=
+"   <Option name='ZSTD_LEVEL' type='int' description='ZSTD compression level 1(fast)-22(slow)' default='9'/>";
+    if( bHasJPEG )
+        osOptions +=
+"   <Option name='JPEG_QUALITY' type='int' description='JPEG quality 1-100' default='75'/>";
+    if( bHasWebP )
+        osOptions +=
+"   <Option name='WEBP_LEVEL' type='int' description='WEBP quality level. Low values result in higher compression ratios' default='75'/>"
+"   <Option name='WEBP_LOSSLESS' type='boolean' description='Whether lossless compression should be used' default='FALSE'/>";
+    osOptions +=
+"   <Option name='PREDICTOR' type='int' description='Predictor Type (1=default, 2=horizontal differencing, 3=floating point prediction)'/>"
+"   <Option name='NUM_THREADS' type='string' description='Number of worker threads for compression. Can be set to ALL_CPUS' default='1'/>"
+"   <Option name='BLOCKSIZE' type='int' description='Tile width and height in pixels, as a power of two between 64 and 4096' default='512'/>"
+"   <Option name='OVERVIEWS' type='string-select' default='AUTO'>"
+"       <Value>AUTO</Value>"
+"       <Value>IGNORE_EXISTING</Value>"
+"       <Value>NONE</Value>"
+"   </Option>"
+"   <Option name='RESAMPLING' type='string' description='Resampling method for overviews (NEAREST by default for paletted rasters, AVERAGE otherwise)'/>"
+#ifdef BIGTIFF_SUPPORT
+"   <Option name='BIGTIFF' type='string-select' description='Force creation of BigTIFF file'>"
+"     <Value>YES</Value>"
+"     <Value>NO</Value>"
+"     <Value>IF_NEEDED</Value>"
+"     <Value>IF_SAFER</Value>"
+"   </Option>"
+#endif
+"</CreationOptionList>";
+
+    GDALDriver *poDriver = new GDALDriver();
+
+    poDriver->SetDescription( "COG" );
+    poDriver->SetMetadataItem( GDAL_DCAP_RASTER, "YES" );
+    poDriver->SetMetadataItem( GDAL_DMD_LONGNAME,
+                               "Cloud optimized GeoTIFF generator" );
+    poDriver->SetMetadataItem( GDAL_DMD_HELPTOPIC, "frmt_cog.html" );
+    poDriver->SetMetadataItem( GDAL_DMD_EXTENSION, "tif" );
+    poDriver->SetMetadataItem( GDAL_DMD_EXTENSIONS, "tif tiff" );
+    poDriver->SetMetadataItem( GDAL_DMD_CREATIONDATATYPES,
+                               "Byte UInt16 Int16 UInt32 Int32 Float32 "
+                               "Float64 CInt16 CInt32 CFloat32 CFloat64" );
+    poDriver->SetMetadataItem( GDAL_DMD_CREATIONOPTIONLIST, osOptions );
+    poDriver->SetMetadataItem( GDAL_DCAP_VIRTUALIO, "YES" );
+
+    poDriver->pfnCreateCopy = COGCreateCopy;
+
+    GetGDALDriverManager()->RegisterDriver( poDriver );
+}
@@ -57,8 +57,10 @@
 #include <algorithm>
 #include <memory>
 #include <mutex>
+#include <queue>
 #include <set>
 #include <string>
+#include <typeinfo>
 #include <vector>
 
 #include "cpl_config.h"
@@ -220,7 +222,8 @@ typedef enum
 {
     VIRTUAL_MEM_IO_NO,
     VIRTUAL_MEM_IO_YES,
-    VIRTUAL_MEM_IO_IF_ENOUGH_RAM
+    VIRTUAL_MEM_IO_IF_ENOUGH_RAM,
+    VIRTUAL_MEM_IO_AUTO
 } VirtualMemIOEnum;
 
 #if !defined(__MINGW32__)
@@ -233,12 +236,16 @@ typedef struct
     char         *pszTmpFilename;
     int           nHeight;
     uint16        nPredictor;
+    uint16        anYCbCrSubsampling[2];
+    int           nJPEGColorMode;
     GByte        *pabyBuffer;
     int           nBufferSize;
     int           nStripOrTile;
 
     GByte        *pabyCompressedBuffer;  // Owned by pszTmpFilename.
     int           nCompressedBufferSize;
+    GByte        *pabyJPEGTables;
+    int           nJPEGTablesSize;
     bool          bReady;
 } GTiffCompressionJob;
 #if !defined(__MINGW32__)
@@ -440,7 +447,8 @@ class GTiffDataset final : public GDALPamDataset
     bool          bDebugDontWriteBlocks;
 
     CPLErr        RegisterNewOverviewDataset( toff_t nOverviewOffset, int l_nJpegQuality );
-    CPLErr        CreateOverviewsFromSrcOverviews( GDALDataset* poSrcDS );
+    CPLErr        CreateOverviewsFromSrcOverviews( GDALDataset* poSrcDS,
+                                                   GDALDataset* poOvrDS );
     CPLErr        CreateInternalMaskOverviews( int nOvrBlockXSize,
                                                int nOvrBlockYSize );
 
@@ -469,11 +477,18 @@ class GTiffDataset final : public GDALPamDataset
 
     CPLWorkerThreadPool *poCompressThreadPool;
     std::vector<GTiffCompressionJob> asCompressionJobs{};
+    // Indices in asCompressionJobs of the submitted jobs, in submission
+    // order, so that blocks are written in a deterministic order.
+    std::queue<int> anQueuedCompressionJobs{};
     CPLMutex      *hCompressThreadPoolMutex;
+    bool           bJPEGTablesCheckedForCompressionJobs;
     void           InitCompressionThreads( char** papszOptions );
+    void           InitCompressionJobs( int nThreads );
+    void           FreeCompressionJobs();
     void           InitCreationOrOpenOptions( char** papszOptions );
     static void    ThreadCompressionFunc( void* pData );
     void           WaitCompletionForBlock( int nBlockId );
+    void           FlushOldestCompressionJob();
     void           WriteRawStripOrTile( int nStripOrTile,
                                         GByte* pabyCompressedBuffer,
                                         int nCompressedBufferSize );
@@ -2291,10 +2306,38 @@ int GTiffDataset::VirtualMemIO( GDALRWFlag eRWFlag,
         return -1;
     }
 
+    const GDALDataType eDataType = GetRasterBand(1)->GetRasterDataType();
+
+    // In the default mode, only take the requests that can be served
+    // without any conversion, and leave the others, as well as those that
+    // want progress reporting, to the block cache.
+    if( eVirtualMemIOUsage == VIRTUAL_MEM_IO_AUTO &&
+        (eBufType != eDataType ||
+         nXSize != nBufXSize || nYSize != nBufYSize ||
+         (psExtraArg != nullptr && psExtraArg->pfnProgress != nullptr &&
+          psExtraArg->pfnProgress != GDALDummyProgress)) )
+    {
+        return -1;
+    }
+
+    // Nor the bands of the specialized subclasses (split, RGBA, odd bits),
+    // whose IReadBlock() this path would bypass.
+    if( eVirtualMemIOUsage == VIRTUAL_MEM_IO_AUTO )
+    {
+        for( int iBand = 0; iBand < nBandCount; ++iBand )
+        {
+            GDALRasterBand* poBand = GetRasterBand(panBandMap[iBand]);
+            if( poBand == nullptr ||
+                typeid(*poBand) != typeid(GTiffRasterBand) )
+            {
+                return -1;
+            }
+        }
+    }
+
     if( !SetDirectory() )
         return CE_Failure;
 
-    const GDALDataType eDataType = GetRasterBand(1)->GetRasterDataType();
     const int nDTSizeBits = GDALGetDataTypeSizeBits(eDataType);
     if( !(nCompression == COMPRESSION_NONE &&
         (nPhotometric == PHOTOMETRIC_MINISBLACK ||
@@ -2306,6 +2349,23 @@ int GTiffDataset::VirtualMemIO( GDALRWFlag eRWFlag,
         return -1;
     }
 
+    if( eVirtualMemIOUsage == VIRTUAL_MEM_IO_AUTO &&
+        psVirtualMemIOMapping == nullptr )
+    {
+        // Only map local files on 64 bit builds, and do not defeat the
+        // lazy loading of the strip/tile offsets of images with many
+        // blocks (see IsBlockAvailable()).
+        const int nPlanes =
+            nPlanarConfig == PLANARCONFIG_SEPARATE ? nBands : 1;
+        if( SIZEOF_VOIDP < 8 || bIgnoreReadErrors ||
+            STARTS_WITH(osFilename, "/vsimem/") ||
+            static_cast<GIntBig>(nBlocksPerBand) * nPlanes >= 64 * 1024 )
+        {
+            eVirtualMemIOUsage = VIRTUAL_MEM_IO_NO;
+            return -1;
+        }
+    }
+
     size_t nMappingSize = 0;
     GByte* pabySrcData = nullptr;
     if( STARTS_WITH(osFilename, "/vsimem/") )
@@ -2355,7 +2415,8 @@ int GTiffDataset::VirtualMemIO( GDALRWFlag eRWFlag,
             eVirtualMemIOUsage = VIRTUAL_MEM_IO_NO;
             return -1;
         }
-        eVirtualMemIOUsage = VIRTUAL_MEM_IO_YES;
+        if( eVirtualMemIOUsage == VIRTUAL_MEM_IO_IF_ENOUGH_RAM )
+            eVirtualMemIOUsage = VIRTUAL_MEM_IO_YES;
     }
 
     if( psVirtualMemIOMapping )
@@ -7404,6 +7465,7 @@ GTiffDataset::GTiffDataset() :
     bHasDiscardedLsb(false),
     poCompressThreadPool(nullptr),
     hCompressThreadPoolMutex(nullptr),
+    bJPEGTablesCheckedForCompressionJobs(false),
     m_pTempBufferForCommonDirectIO(nullptr),
     m_nTempBufferForCommonDirectIOSize(0),
     m_bReadGeoTransform(false),
@@ -7433,7 +7495,9 @@ GTiffDataset::GTiffDataset() :
 
     const char* pszVirtualMemIO =
         CPLGetConfigOption("GTIFF_VIRTUAL_MEM_IO", "NO");
-    if( EQUAL(pszVirtualMemIO, "IF_ENOUGH_RAM") )
+    if( EQUAL(pszVirtualMemIO, "AUTO") )
+        eVirtualMemIOUsage = VIRTUAL_MEM_IO_AUTO;
+    else if( EQUAL(pszVirtualMemIO, "IF_ENOUGH_RAM") )
         eVirtualMemIOUsage = VIRTUAL_MEM_IO_IF_ENOUGH_RAM;
     else if( CPLTestBool(pszVirtualMemIO) )
         eVirtualMemIOUsage = VIRTUAL_MEM_IO_YES;
@@ -7507,8 +7571,21 @@ int GTiffDataset::Finalize()
     FlushCacheInternal( true );
 
     // Destroy compression pool.
-    if( poCompressThreadPool )
+    if( poCompressThreadPool && poBaseDS == nullptr )
     {
+        // Overviews borrow our thread pool: flush their pending jobs
+        // before it goes away.
+        for( int i = 0; bBase && i < nOverviewCount; ++i )
+        {
+            GTiffDataset* poODS = papoOverviewDS[i];
+            if( poODS->poCompressThreadPool == poCompressThreadPool )
+            {
+                poODS->FlushCacheInternal( true );
+                poODS->poCompressThreadPool = nullptr;
+                poODS->FreeCompressionJobs();
+            }
+        }
+
         poCompressThreadPool->WaitCompletion();
 
         // Save thread pool for later reuse.
@@ -7519,16 +7596,7 @@ int GTiffDataset::Finalize()
             poCompressThreadPool = nullptr;
         }
 
-        for( int i = 0; i < static_cast<int>(asCompressionJobs.size()); ++i )
-        {
-            CPLFree(asCompressionJobs[i].pabyBuffer);
-            if( asCompressionJobs[i].pszTmpFilename )
-            {
-                VSIUnlink(asCompressionJobs[i].pszTmpFilename);
-                CPLFree(asCompressionJobs[i].pszTmpFilename);
-            }
-        }
-        CPLDestroyMutex(hCompressThreadPoolMutex);
+        FreeCompressionJobs();
     }
 
 /* -------------------------------------------------------------------- */
@@ -8506,11 +8574,10 @@ void GTiffDataset::InitCompressionThreads( char** papszOptions )
             EQUAL(pszValue, "ALL_CPUS") ? CPLGetNumCPUs() : atoi(pszValue);
         if( nThreads > 1 )
         {
-            if( nCompression == COMPRESSION_NONE ||
-                nCompression == COMPRESSION_JPEG )
+            if( nCompression == COMPRESSION_NONE )
             {
                 CPLDebug( "GTiff",
-                          "NUM_THREADS ignored with uncompressed or JPEG" );
+                          "NUM_THREADS ignored with uncompressed" );
             }
             else
             {
@@ -8541,35 +8608,7 @@ void GTiffDataset::InitCompressionThreads( char** papszOptions )
                     }
                 }
                 if( poCompressThreadPool != nullptr )
-                {
-                    // Add a margin of an extra job w.r.t thread number
-                    // so as to optimize compression time (enables the main
-                    // thread to do boring I/O while all CPUs are working).
-                    asCompressionJobs.resize(nThreads + 1);
-                    memset(&asCompressionJobs[0], 0,
-                           asCompressionJobs.size() *
-                           sizeof(GTiffCompressionJob));
-                    for( int i = 0;
-                         i < static_cast<int>(asCompressionJobs.size());
-                         ++i )
-                    {
-                        asCompressionJobs[i].pszTmpFilename =
-                            CPLStrdup(CPLSPrintf("/vsimem/gtiff/thread/job/%p",
-                                                 &asCompressionJobs[i]));
-                        asCompressionJobs[i].nStripOrTile = -1;
-                    }
-                    hCompressThreadPoolMutex = CPLCreateMutex();
-                    CPLReleaseMutex(hCompressThreadPoolMutex);
-
-                    // This is kind of a hack, but basically using
-                    // TIFFWriteRawStrip/Tile and then TIFFReadEncodedStrip/Tile
-                    // does not work on a newly created file, because
-                    // TIFF_MYBUFFER is not set in tif_flags
-                    // (if using TIFFWriteEncodedStrip/Tile first,
-                    // TIFFWriteBufferSetup() is automatically called).
-                    // This should likely rather fixed in libtiff itself.
-                    TIFFWriteBufferSetup(hTIFF, nullptr, -1);
-                }
+                    InitCompressionJobs(nThreads);
             }
         }
         else if( nThreads < 0 ||
@@ -8583,6 +8622,72 @@ void GTiffDataset::InitCompressionThreads( char** papszOptions )
     }
 }
 
+/************************************************************************/
+/*                         InitCompressionJobs()                        */
+/************************************************************************/
+
+void GTiffDataset::InitCompressionJobs( int nThreads )
+{
+    // Allow up to two jobs per thread, so that the main thread can keep
+    // all CPUs busy while it waits for the oldest job to be written, but
+    // bound the memory used by in-flight blocks (uncompressed copy and
+    // compressed result) to GTIFF_COMPRESSION_JOBS_MAX_MEMORY megabytes.
+    const GIntBig nBlockBytes =
+        static_cast<GIntBig>(nBlockXSize) * nBlockYSize *
+        (nPlanarConfig == PLANARCONFIG_CONTIG ? nBands : 1) *
+        DIV_ROUND_UP(nBitsPerSample, 8);
+    const GIntBig nMaxMemory = static_cast<GIntBig>(
+        std::max(1, atoi(CPLGetConfigOption(
+            "GTIFF_COMPRESSION_JOBS_MAX_MEMORY", "256")))) * 1024 * 1024;
+    const int nJobs = static_cast<int>(std::max(static_cast<GIntBig>(2),
+        std::min(static_cast<GIntBig>(2) * nThreads,
+                 nMaxMemory / std::max(static_cast<GIntBig>(1),
+                                       2 * nBlockBytes))));
+    asCompressionJobs.resize(nJobs);
+    memset(&asCompressionJobs[0], 0,
+           asCompressionJobs.size() * sizeof(GTiffCompressionJob));
+    for( int i = 0; i < static_cast<int>(asCompressionJobs.size()); ++i )
+    {
+        asCompressionJobs[i].pszTmpFilename =
+            CPLStrdup(CPLSPrintf("/vsimem/gtiff/thread/job/%p",
+                                 &asCompressionJobs[i]));
+        asCompressionJobs[i].nStripOrTile = -1;
+    }
+    hCompressThreadPoolMutex = CPLCreateMutex();
+    CPLReleaseMutex(hCompressThreadPoolMutex);
+
+    // This is kind of a hack, but basically using
+    // TIFFWriteRawStrip/Tile and then TIFFReadEncodedStrip/Tile
+    // does not work on a newly created file, because
+    // TIFF_MYBUFFER is not set in tif_flags
+    // (if using TIFFWriteEncodedStrip/Tile first,
+    // TIFFWriteBufferSetup() is automatically called).
+    // This should likely rather fixed in libtiff itself.
+    TIFFWriteBufferSetup(hTIFF, nullptr, -1);
+}
+
+/************************************************************************/
+/*                         FreeCompressionJobs()                        */
+/************************************************************************/
+
+void GTiffDataset::FreeCompressionJobs()
+{
+    for( int i = 0; i < static_cast<int>(asCompressionJobs.size()); ++i )
+    {
+        CPLFree(asCompressionJobs[i].pabyBuffer);
+        CPLFree(asCompressionJobs[i].pabyJPEGTables);
+        if( asCompressionJobs[i].pszTmpFilename )
+        {
+            VSIUnlink(asCompressionJobs[i].pszTmpFilename);
+            CPLFree(asCompressionJobs[i].pszTmpFilename);
+        }
+    }
+    asCompressionJobs.clear();
+    anQueuedCompressionJobs = std::queue<int>();
+    CPLDestroyMutex(hCompressThreadPoolMutex);
+    hCompressThreadPoolMutex = nullptr;
+}
+
 /************************************************************************/
 /*                       GetGTIFFKeysFlavor()                           */
 /************************************************************************/
@@ -8651,6 +8756,23 @@ void GTiffDataset::ThreadCompressionFunc( void* pData )
     TIFFSetField(hTIFFTmp, TIFFTAG_SAMPLESPERPIXEL, poDS->nSamplesPerPixel);
     TIFFSetField(hTIFFTmp, TIFFTAG_ROWSPERSTRIP, poDS->nBlockYSize);
     TIFFSetField(hTIFFTmp, TIFFTAG_PLANARCONFIG, poDS->nPlanarConfig);
+    if( poDS->nCompression == COMPRESSION_JPEG )
+    {
+        // Same settings as the main file, so that the quantization (and
+        // Huffman) tables are the ones of its JPEGTables tag.
+        if( poDS->nPhotometric == PHOTOMETRIC_YCBCR )
+        {
+            TIFFSetField(hTIFFTmp, TIFFTAG_YCBCRSUBSAMPLING,
+                         psJob->anYCbCrSubsampling[0],
+                         psJob->anYCbCrSubsampling[1]);
+        }
+        if( poDS->nJpegQuality > 0 )
+            TIFFSetField(hTIFFTmp, TIFFTAG_JPEGQUALITY, poDS->nJpegQuality);
+        if( poDS->nJpegTablesMode >= 0 )
+            TIFFSetField(hTIFFTmp, TIFFTAG_JPEGTABLESMODE,
+                         poDS->nJpegTablesMode);
+        TIFFSetField(hTIFFTmp, TIFFTAG_JPEGCOLORMODE, psJob->nJPEGColorMode);
+    }
 
     bool bOK =
         TIFFWriteEncodedStrip(hTIFFTmp, 0, psJob->pabyBuffer,
@@ -8666,6 +8788,18 @@ void GTiffDataset::ThreadCompressionFunc( void* pData )
 
         nOffset = static_cast<int>( panOffsets[0]);
         psJob->nCompressedBufferSize = static_cast<int>( panByteCounts[0] );
+
+        uint32 nJPEGTablesSize = 0;
+        void* pJPEGTables = nullptr;
+        if( poDS->nCompression == COMPRESSION_JPEG &&
+            TIFFGetField(hTIFFTmp, TIFFTAG_JPEGTABLES, &nJPEGTablesSize,
+                         &pJPEGTables) )
+        {
+            psJob->pabyJPEGTables = static_cast<GByte*>(
+                CPLRealloc(psJob->pabyJPEGTables, nJPEGTablesSize));
+            memcpy(psJob->pabyJPEGTables, pJPEGTables, nJPEGTablesSize);
+            psJob->nJPEGTablesSize = static_cast<int>(nJPEGTablesSize);
+        }
     }
     else
     {
@@ -8754,31 +8888,76 @@ void GTiffDataset::WaitCompletionForBlock(int nBlockId)
                          "Waiting for worker job to finish handling block %d",
                          nBlockId);
 
-                CPLAcquireMutex(hCompressThreadPoolMutex, 1000.0);
-                const bool bReady = asCompressionJobs[i].bReady;
-                CPLReleaseMutex(hCompressThreadPoolMutex);
-                if( !bReady )
+                // Write the jobs submitted before this one first, to keep
+                // the order of blocks in the file.
+                while( !anQueuedCompressionJobs.empty() )
                 {
-                    poCompressThreadPool->WaitCompletion(0);
-                    CPLAssert( asCompressionJobs[i].bReady );
-                }
-
-                if( asCompressionJobs[i].nCompressedBufferSize )
-                {
-                    WriteRawStripOrTile(asCompressionJobs[i].nStripOrTile,
-                                  asCompressionJobs[i].pabyCompressedBuffer,
-                                  asCompressionJobs[i].nCompressedBufferSize);
+                    const int iJob = anQueuedCompressionJobs.front();
+                    FlushOldestCompressionJob();
+                    if( iJob == i )
+                        break;
                 }
-                asCompressionJobs[i].pabyCompressedBuffer = nullptr;
-                asCompressionJobs[i].nBufferSize = 0;
-                asCompressionJobs[i].bReady = false;
-                asCompressionJobs[i].nStripOrTile = -1;
                 return;
             }
         }
     }
 }
 
+/************************************************************************/
+/*                     FlushOldestCompressionJob()                      */
+/*                                                                      */
+/*      Wait for the oldest submitted job to be finished, and write     */
+/*      its result.                                                     */
+/************************************************************************/
+
+void GTiffDataset::FlushOldestCompressionJob()
+{
+    CPLAssert( !anQueuedCompressionJobs.empty() );
+    GTiffCompressionJob* psJob =
+        &asCompressionJobs[anQueuedCompressionJobs.front()];
+    anQueuedCompressionJobs.pop();
+
+    while( true )
+    {
+        CPLAcquireMutex(hCompressThreadPoolMutex, 1000.0);
+        const bool bReady = psJob->bReady;
+        CPLReleaseMutex(hCompressThreadPoolMutex);
+        if( bReady )
+            break;
+        poCompressThreadPool->WaitEvent();
+    }
+
+    if( nCompression == COMPRESSION_JPEG && psJob->nJPEGTablesSize &&
+        !bJPEGTablesCheckedForCompressionJobs )
+    {
+        // The JPEGTables tag is normally written at creation time with
+        // the same settings, but make sure the abbreviated JPEG streams of
+        // the jobs can be decoded with it.
+        bJPEGTablesCheckedForCompressionJobs = true;
+        uint32 nJPEGTablesSize = 0;
+        void* pJPEGTables = nullptr;
+        if( !TIFFGetField(hTIFF, TIFFTAG_JPEGTABLES, &nJPEGTablesSize,
+                          &pJPEGTables) ||
+            static_cast<int>(nJPEGTablesSize) != psJob->nJPEGTablesSize ||
+            memcmp(pJPEGTables, psJob->pabyJPEGTables, nJPEGTablesSize) != 0 )
+        {
+            TIFFSetField(hTIFF, TIFFTAG_JPEGTABLES, psJob->nJPEGTablesSize,
+                         psJob->pabyJPEGTables);
+        }
+    }
+
+    if( psJob->nCompressedBufferSize )
+    {
+        WriteRawStripOrTile( psJob->nStripOrTile,
+                             psJob->pabyCompressedBuffer,
+                             psJob->nCompressedBufferSize );
+    }
+    psJob->pabyCompressedBuffer = nullptr;
+    psJob->nBufferSize = 0;
+    psJob->bReady = false;
+    psJob->nStripOrTile = -1;
+}
+
 /************************************************************************/
 /*                      SubmitCompressionJob()                          */
 /************************************************************************/
@@ -8796,35 +8975,22 @@ bool GTiffDataset::SubmitCompressionJob( int nStripOrTile, GByte* pabyData,
             nCompression == COMPRESSION_LZMA ||
             nCompression == COMPRESSION_ZSTD ||
             nCompression == COMPRESSION_LERC ||
-            nCompression == COMPRESSION_WEBP) ) )
+            nCompression == COMPRESSION_WEBP ||
+            nCompression == COMPRESSION_JPEG) ) )
         return false;
 
+    // Bound the number of blocks in flight: wait for the oldest job to be
+    // finished and write it.
+    if( anQueuedCompressionJobs.size() == asCompressionJobs.size() )
+        FlushOldestCompressionJob();
+
     int nNextCompressionJobAvail = -1;
-    // Wait that at least one job is finished.
-    poCompressThreadPool->WaitCompletion(
-        static_cast<int>(asCompressionJobs.size() - 1) );
     for( int i = 0; i < static_cast<int>(asCompressionJobs.size()); ++i )
     {
-        CPLAcquireMutex(hCompressThreadPoolMutex, 1000.0);
-        const bool bReady = asCompressionJobs[i].bReady;
-        CPLReleaseMutex(hCompressThreadPoolMutex);
-        if( bReady )
-        {
-            if( asCompressionJobs[i].nCompressedBufferSize )
-            {
-                WriteRawStripOrTile( asCompressionJobs[i].nStripOrTile,
-                                asCompressionJobs[i].pabyCompressedBuffer,
-                                asCompressionJobs[i].nCompressedBufferSize );
-            }
-            asCompressionJobs[i].pabyCompressedBuffer = nullptr;
-            asCompressionJobs[i].nBufferSize = 0;
-            asCompressionJobs[i].bReady = false;
-            asCompressionJobs[i].nStripOrTile = -1;
-        }
         if( asCompressionJobs[i].nBufferSize == 0 )
         {
-            if( nNextCompressionJobAvail < 0 )
-                nNextCompressionJobAvail = i;
+            nNextCompressionJobAvail = i;
+            break;
         }
     }
     CPLAssert(nNextCompressionJobAvail >= 0);
@@ -8845,7 +9011,16 @@ bool GTiffDataset::SubmitCompressionJob( int nStripOrTile, GByte* pabyData,
     {
         TIFFGetField( hTIFF, TIFFTAG_PREDICTOR, &psJob->nPredictor );
     }
+    if( nCompression == COMPRESSION_JPEG )
+    {
+        TIFFGetFieldDefaulted( hTIFF, TIFFTAG_YCBCRSUBSAMPLING,
+                               &psJob->anYCbCrSubsampling[0],
+                               &psJob->anYCbCrSubsampling[1] );
+        psJob->nJPEGColorMode = JPEGCOLORMODE_RAW;
+        TIFFGetField( hTIFF, TIFFTAG_JPEGCOLORMODE, &psJob->nJPEGColorMode );
+    }
 
+    anQueuedCompressionJobs.push(nNextCompressionJobAvail);
     poCompressThreadPool->SubmitJob(ThreadCompressionFunc, psJob);
     return true;
 }
@@ -9302,6 +9477,10 @@ void GTiffDataset::Crystalize()
         TIFFSetField(hTIFF, TIFFTAG_JPEGCOLORMODE, nColorMode);
     if( nJpegTablesModeIn >= 0 )
         TIFFSetField(hTIFF, TIFFTAG_JPEGTABLESMODE, nJpegTablesModeIn);
+#if HAVE_LERC
+    if( nCompression == COMPRESSION_LERC )
+        TIFFSetField(hTIFF, TIFFTAG_LERC_MAXZERROR, dfMaxZError);
+#endif
 
     nDirOffset = TIFFCurrentDirOffset( hTIFF );
 }
@@ -9630,17 +9809,20 @@ bool GTiffDataset::IsBlockAvailable( int nBlockId,
                 }
             }
 
+            // Only allocate the arrays up to (twice) the requested block, so
+            // that the first access to an image with millions of blocks
+            // does not cost a huge allocation.
             uint32 nStripArrayAllocBefore = nStripArrayAlloc;
             uint32 nStripArrayAllocNew;
             if( nStripArrayAlloc == 0 &&
-                hTIFF->tif_dir.td_nstrips < 1024 * 1024 )
+                hTIFF->tif_dir.td_nstrips < 64 * 1024 )
             {
                 nStripArrayAllocNew = hTIFF->tif_dir.td_nstrips;
             }
             else
             {
                 nStripArrayAllocNew = std::max(
-                    static_cast<uint32>(nBlockId) + 1, 1024U * 512U );
+                    static_cast<uint32>(nBlockId) + 1, 1024U * 32U );
                 if( nStripArrayAllocNew < UINT_MAX / 2  )
                     nStripArrayAllocNew *= 2;
                 nStripArrayAllocNew = std::min(
@@ -9824,23 +10006,14 @@ void GTiffDataset::FlushCacheInternal( bool bFlushDirectory )
     {
         poCompressThreadPool->WaitCompletion();
 
-        // Flush remaining data
-        for( int i = 0; i < static_cast<int>(asCompressionJobs.size()); ++i )
-        {
-            if( asCompressionJobs[i].bReady )
-            {
-                if( asCompressionJobs[i].nCompressedBufferSize )
-                {
-                    WriteRawStripOrTile( asCompressionJobs[i].nStripOrTile,
-                                   asCompressionJobs[i].pabyCompressedBuffer,
-                                   asCompressionJobs[i].nCompressedBufferSize );
-                }
-                asCompressionJobs[i].pabyCompressedBuffer = nullptr;
-                asCompressionJobs[i].nBufferSize = 0;
-                asCompressionJobs[i].bReady = false;
-                asCompressionJobs[i].nStripOrTile = -1;
-            }
-        }
+        // The current directory may be the one of another overview level
+        // sharing the thread pool.
+        if( poBaseDS != nullptr )
+            SetDirectory();
+
+        // Flush remaining data, in submission order
+        while( !anQueuedCompressionJobs.empty() )
+            FlushOldestCompressionJob();
     }
 
     if( bFlushDirectory && GetAccess() == GA_Update )
@@ -10077,6 +10250,15 @@ CPLErr GTiffDataset::RegisterNewOverviewDataset(toff_t nOverviewOffset,
     papoOverviewDS[nOverviewCount-1] = poODS;
     poODS->poBaseDS = this;
     poODS->bIsOverview_ = true;
+
+    // Overviews being written share the compression thread pool of the
+    // main image.
+    if( poCompressThreadPool != nullptr &&
+        poODS->nCompression != COMPRESSION_NONE )
+    {
+        poODS->poCompressThreadPool = poCompressThreadPool;
+        poODS->InitCompressionJobs( poCompressThreadPool->GetThreadCount() );
+    }
     return CE_None;
 }
 
@@ -10131,11 +10313,47 @@ static void CreateTIFFColorTable(GDALColorTable* poColorTable,
     panBlue = &(anTBlue[0]);
 }
 
+/************************************************************************/
+/*                     GTiffGetSrcOverviewCount()                       */
+/*                                                                      */
+/*      Overviews to copy with COPY_SRC_OVERVIEWS come either from the  */
+/*      source dataset, or from a dataset, such as the one written by   */
+/*      GTIFFBuildOverviews(), whose main image is the first overview   */
+/*      level and whose overviews are the next ones.                    */
+/************************************************************************/
+
+static int GTiffGetSrcOverviewCount( GDALDataset* poSrcDS,
+                                     GDALDataset* poOvrDS )
+{
+    if( poOvrDS != nullptr )
+        return 1 + poOvrDS->GetRasterBand(1)->GetOverviewCount();
+    return poSrcDS->GetRasterBand(1)->GetOverviewCount();
+}
+
+/************************************************************************/
+/*                      GTiffGetSrcOverviewBand()                       */
+/************************************************************************/
+
+static GDALRasterBand* GTiffGetSrcOverviewBand( GDALDataset* poSrcDS,
+                                                GDALDataset* poOvrDS,
+                                                int nBand, int iOvr )
+{
+    if( poOvrDS != nullptr )
+    {
+        GDALRasterBand* poBand = poOvrDS->GetRasterBand(nBand);
+        if( poBand == nullptr || iOvr == 0 )
+            return poBand;
+        return poBand->GetOverview(iOvr - 1);
+    }
+    return poSrcDS->GetRasterBand(nBand)->GetOverview(iOvr);
+}
+
 /************************************************************************/
 /*                  CreateOverviewsFromSrcOverviews()                   */
 /************************************************************************/
 
-CPLErr GTiffDataset::CreateOverviewsFromSrcOverviews(GDALDataset* poSrcDS)
+CPLErr GTiffDataset::CreateOverviewsFromSrcOverviews(GDALDataset* poSrcDS,
+                                                     GDALDataset* poOvrDS)
 {
     CPLAssert(poSrcDS->GetRasterCount() != 0);
     CPLAssert(nOverviewCount == 0);
@@ -10209,12 +10427,13 @@ CPLErr GTiffDataset::CreateOverviewsFromSrcOverviews(GDALDataset* poSrcDS)
     int nOvrBlockYSize = 0;
     GTIFFGetOverviewBlockSize(&nOvrBlockXSize, &nOvrBlockYSize);
 
-    int nSrcOverviews = poSrcDS->GetRasterBand(1)->GetOverviewCount();
+    const int nSrcOverviews = GTiffGetSrcOverviewCount(poSrcDS, poOvrDS);
     CPLErr eErr = CE_None;
 
     for( int i = 0; i < nSrcOverviews && eErr == CE_None; ++i )
     {
-        GDALRasterBand* poOvrBand = poSrcDS->GetRasterBand(1)->GetOverview(i);
+        GDALRasterBand* poOvrBand =
+            GTiffGetSrcOverviewBand(poSrcDS, poOvrDS, 1, i);
 
         int nOXSize = poOvrBand->GetXSize();
         int nOYSize = poOvrBand->GetYSize();
@@ -16777,16 +16996,59 @@ GTiffDataset::CreateCopy( const char * pszFilename, GDALDataset *poSrcDS,
         }
     }
 
+/* -------------------------------------------------------------------- */
+/*      The overviews to copy may have been computed in a separate      */
+/*      file (used by the COG driver).                                  */
+/* -------------------------------------------------------------------- */
+    const bool bCopySrcOverviews =
+        CPLFetchBool(papszOptions, "COPY_SRC_OVERVIEWS", false);
+    std::unique_ptr<GDALDataset> poOvrDS;
+    std::unique_ptr<GDALDataset> poMaskOvrDS;
+    const char* pszOverviewDS =
+        CSLFetchNameValue(papszOptions, "@OVERVIEW_DATASET");
+    const char* pszMaskOverviewDS =
+        CSLFetchNameValue(papszOptions, "@MASK_OVERVIEW_DATASET");
+    if( bCopySrcOverviews && pszOverviewDS != nullptr )
+    {
+        poOvrDS.reset( GDALDataset::Open(
+            pszOverviewDS, GDAL_OF_RASTER | GDAL_OF_VERBOSE_ERROR) );
+        if( pszMaskOverviewDS != nullptr )
+        {
+            poMaskOvrDS.reset( GDALDataset::Open(
+                pszMaskOverviewDS, GDAL_OF_RASTER | GDAL_OF_VERBOSE_ERROR) );
+        }
+        if( poOvrDS == nullptr ||
+            (pszMaskOverviewDS != nullptr && poMaskOvrDS == nullptr) )
+        {
+            CSLDestroy(papszCreateOptions);
+            return nullptr;
+        }
+        if( poOvrDS->GetRasterCount() != l_nBands ||
+            (poMaskOvrDS != nullptr &&
+             GTiffGetSrcOverviewCount(nullptr, poMaskOvrDS.get()) !=
+                GTiffGetSrcOverviewCount(nullptr, poOvrDS.get())) )
+        {
+            CPLError( CE_Failure, CPLE_AppDefined,
+                      "%s is not compatible with the source dataset",
+                      pszOverviewDS );
+            CSLDestroy(papszCreateOptions);
+            return nullptr;
+        }
+    }
+
     double dfExtraSpaceForOverviews = 0;
-    if( CPLFetchBool(papszOptions, "COPY_SRC_OVERVIEWS", false) )
+    if( bCopySrcOverviews )
     {
-        const int nSrcOverviews = poSrcDS->GetRasterBand(1)->GetOverviewCount();
+        const int nSrcOverviews =
+            GTiffGetSrcOverviewCount(poSrcDS, poOvrDS.get());
         if( nSrcOverviews )
         {
             for( int j = 1; j <= l_nBands; ++j )
             {
-                if( poSrcDS->GetRasterBand(j)->GetOverviewCount() !=
-                                                        nSrcOverviews )
+                const int nOtherBandOverviewCount = poOvrDS ?
+                    1 + poOvrDS->GetRasterBand(j)->GetOverviewCount() :
+                    poSrcDS->GetRasterBand(j)->GetOverviewCount();
+                if( nOtherBandOverviewCount != nSrcOverviews )
                 {
                     CPLError(
                         CE_Failure, CPLE_NotSupported,
@@ -16798,7 +17060,7 @@ GTiffDataset::CreateCopy( const char * pszFilename, GDALDataset *poSrcDS,
                 for( int i = 0; i < nSrcOverviews; ++i )
                 {
                     GDALRasterBand* poOvrBand =
-                        poSrcDS->GetRasterBand(j)->GetOverview(i);
+                        GTiffGetSrcOverviewBand(poSrcDS, poOvrDS.get(), j, i);
                     if( poOvrBand == nullptr )
                     {
                         CPLError(
@@ -16809,7 +17071,7 @@ GTiffDataset::CreateCopy( const char * pszFilename, GDALDataset *poSrcDS,
                         return nullptr;
                     }
                     GDALRasterBand* poOvrFirstBand =
-                        poSrcDS->GetRasterBand(1)->GetOverview(i);
+                        GTiffGetSrcOverviewBand(poSrcDS, poOvrDS.get(), 1, i);
                     if( poOvrBand->GetXSize() != poOvrFirstBand->GetXSize() ||
                         poOvrBand->GetYSize() != poOvrFirstBand->GetYSize() )
                     {
@@ -16826,10 +17088,11 @@ GTiffDataset::CreateCopy( const char * pszFilename, GDALDataset *poSrcDS,
 
             for( int i = 0; i < nSrcOverviews; ++i )
             {
+                GDALRasterBand* poOvrBand =
+                    GTiffGetSrcOverviewBand(poSrcDS, poOvrDS.get(), 1, i);
                 dfExtraSpaceForOverviews +=
-                    static_cast<double>(
-                      poSrcDS->GetRasterBand(1)->GetOverview(i)->GetXSize() ) *
-                      poSrcDS->GetRasterBand(1)->GetOverview(i)->GetYSize();
+                    static_cast<double>(poOvrBand->GetXSize()) *
+                                        poOvrBand->GetYSize();
             }
             dfExtraSpaceForOverviews *=
                                 l_nBands * GDALGetDataTypeSizeBytes(eType);
@@ -17658,13 +17921,14 @@ GTiffDataset::CreateCopy( const char * pszFilename, GDALDataset *poSrcDS,
         static_cast<double>(nXSize) * nYSize * nBandsWidthMask;
     double dfCurPixels = 0;
 
-    if( eErr == CE_None &&
-        CPLFetchBool(papszOptions, "COPY_SRC_OVERVIEWS", false) )
+    if( eErr == CE_None && bCopySrcOverviews )
     {
-        const int nSrcOverviews = poSrcDS->GetRasterBand(1)->GetOverviewCount();
+        const int nSrcOverviews =
+            GTiffGetSrcOverviewCount(poSrcDS, poOvrDS.get());
         if( nSrcOverviews )
         {
-            eErr = poDS->CreateOverviewsFromSrcOverviews(poSrcDS);
+            eErr = poDS->CreateOverviewsFromSrcOverviews(poSrcDS,
+                                                         poOvrDS.get());
 
             if( poDS->nOverviewCount != nSrcOverviews )
             {
@@ -17678,7 +17942,7 @@ GTiffDataset::CreateCopy( const char * pszFilename, GDALDataset *poSrcDS,
             for( int i = 0; i < nSrcOverviews; ++i )
             {
                 GDALRasterBand* poOvrBand =
-                    poSrcDS->GetRasterBand(1)->GetOverview(i);
+                    GTiffGetSrcOverviewBand(poSrcDS, poOvrDS.get(), 1, i);
                 dfTotalPixels += static_cast<double>(poOvrBand->GetXSize()) *
                                 poOvrBand->GetYSize() * nBandsWidthMask;
             }
@@ -17696,10 +17960,15 @@ GTiffDataset::CreateCopy( const char * pszFilename, GDALDataset *poSrcDS,
                 // Create a fake dataset with the source overview level so that
                 // GDALDatasetCopyWholeRaster can cope with it.
                 GDALDataset* poSrcOvrDS =
-                    GDALCreateOverviewDataset(poSrcDS, iOvrLevel, TRUE);
+                    poOvrDS == nullptr ?
+                        GDALCreateOverviewDataset(poSrcDS, iOvrLevel, TRUE) :
+                    iOvrLevel == 0 ? poOvrDS.get() :
+                        GDALCreateOverviewDataset(poOvrDS.get(), iOvrLevel - 1,
+                                                  TRUE);
 
                 GDALRasterBand* poOvrBand =
-                        poSrcDS->GetRasterBand(1)->GetOverview(iOvrLevel);
+                    GTiffGetSrcOverviewBand(poSrcDS, poOvrDS.get(), 1,
+                                            iOvrLevel);
                 double dfNextCurPixels =
                     dfCurPixels +
                     static_cast<double>(poOvrBand->GetXSize()) *
@@ -17720,13 +17989,18 @@ GTiffDataset::CreateCopy( const char * pszFilename, GDALDataset *poSrcDS,
                 dfCurPixels = dfNextCurPixels;
                 GDALDestroyScaledProgress(pScaledData);
 
-                delete poSrcOvrDS;
+                if( poSrcOvrDS != poOvrDS.get() )
+                    delete poSrcOvrDS;
                 poSrcOvrDS = nullptr;
                 poDS->papoOverviewDS[iOvrLevel]->FlushCache();
 
                 // Copy mask of the overview.
                 if( eErr == CE_None && poDS->poMaskDS != nullptr )
                 {
+                    GDALRasterBand* poOvrMaskBand = poMaskOvrDS ?
+                        GTiffGetSrcOverviewBand(nullptr, poMaskOvrDS.get(), 1,
+                                                iOvrLevel) :
+                        poOvrBand->GetMaskBand();
                     dfNextCurPixels +=
                         static_cast<double>(poOvrBand->GetXSize()) *
                                             poOvrBand->GetYSize();
@@ -17736,7 +18010,7 @@ GTiffDataset::CreateCopy( const char * pszFilename, GDALDataset *poSrcDS,
                                             pfnProgress, pProgressData );
                     eErr =
                         GDALRasterBandCopyWholeRaster(
-                            poOvrBand->GetMaskBand(),
+                            poOvrMaskBand,
                             poDS->papoOverviewDS[iOvrLevel]->
                             poMaskDS->GetRasterBand(1),
                             papszCopyWholeRasterOptions,
@@ -17768,7 +18042,7 @@ GTiffDataset::CreateCopy( const char * pszFilename, GDALDataset *poSrcDS,
     {
         eErr = GTIFF_CopyFromJPEG( poDS, poSrcDS,
                                    pfnProgress, pProgressData,
-                                   bTryCopy );
+                                   bTryCopy, poDS->poCompressThreadPool );
 
         // In case of failure in the decompression step, try normal copy.
         if( bTryCopy )
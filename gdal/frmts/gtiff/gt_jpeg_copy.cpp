@@ -30,6 +30,7 @@
 #include "gt_jpeg_copy.h"
 
 #include "cpl_vsi.h"
+#include "cpl_worker_thread_pool.h"
 
 #if defined(JPEG_DIRECT_COPY) || defined(HAVE_LIBJPEG)
 #  include "vrt/vrtdataset.h"
@@ -40,6 +41,7 @@
 #endif
 
 #include <algorithm>
+#include <vector>
 
 // Note: JPEG_DIRECT_COPY is not defined by default, because it is mainly
 // useful for debugging purposes.
@@ -562,10 +564,29 @@ typedef struct
     jvirt_barray_ptr *pSrcCoeffs;
 } GTIFF_CopyBlockFromJPEGArgs;
 
-static CPLErr GTIFF_CopyBlockFromJPEG( GTIFF_CopyBlockFromJPEGArgs* psArgs )
+// State of the compression of one block. The coefficients are copied from
+// the source in the main thread (GTIFF_CopyBlockFromJPEGPrepare()), the
+// entropy coding, which is the costly part, can be done in a worker thread
+// (GTIFF_CopyBlockFromJPEGFinish()), and the result is written in the main
+// thread in block order (GTIFF_CopyBlockFromJPEGWrite()).
+typedef struct
+{
+    struct jpeg_compress_struct sCInfo;
+    struct jpeg_error_mgr sJErr;
+    char szTmpFilename[64];
+    VSILFILE* fpMEM;
+    bool bIsTiled;
+    int nBlockId;
+    bool bOK;
+} GTIFF_CopyBlockFromJPEGJob;
+
+static bool GTIFF_CopyBlockFromJPEGPrepare( GTIFF_CopyBlockFromJPEGArgs* psArgs,
+                                            GTIFF_CopyBlockFromJPEGJob* psJob )
 {
-    CPLString osTmpFilename(CPLSPrintf("/vsimem/%p", psArgs->psDInfo));
-    VSILFILE* fpMEM = VSIFOpenL(osTmpFilename, "wb+");
+    snprintf(psJob->szTmpFilename, sizeof(psJob->szTmpFilename),
+             "/vsimem/gtiff_jpeg_copy_%p", psJob);
+    psJob->fpMEM = VSIFOpenL(psJob->szTmpFilename, "wb+");
+    psJob->bOK = false;
 
 /* -------------------------------------------------------------------- */
 /*      Initialization of the compressor                                */
@@ -573,9 +594,10 @@ static CPLErr GTIFF_CopyBlockFromJPEG( GTIFF_CopyBlockFromJPEGArgs* psArgs )
     jmp_buf setjmp_buffer;
     if( setjmp(setjmp_buffer) )
     {
-        CPL_IGNORE_RET_VAL(VSIFCloseL(fpMEM));
-        VSIUnlink(osTmpFilename);
-        return CE_Failure;
+        jpeg_destroy_compress(&psJob->sCInfo);
+        CPL_IGNORE_RET_VAL(VSIFCloseL(psJob->fpMEM));
+        VSIUnlink(psJob->szTmpFilename);
+        return false;
     }
 
     TIFF* hTIFF = psArgs->hTIFF;
@@ -591,10 +613,9 @@ static CPLErr GTIFF_CopyBlockFromJPEG( GTIFF_CopyBlockFromJPEGArgs* psArgs )
     const int iMCU_sample_height = psArgs->iMCU_sample_height;
     jvirt_barray_ptr *pSrcCoeffs = psArgs->pSrcCoeffs;
 
-    struct jpeg_error_mgr sJErr;
-    struct jpeg_compress_struct sCInfo;
-    sCInfo.err = jpeg_std_error( &sJErr );
-    sJErr.error_exit = GTIFF_ErrorExitJPEG;
+    struct jpeg_compress_struct& sCInfo = psJob->sCInfo;
+    sCInfo.err = jpeg_std_error( &psJob->sJErr );
+    psJob->sJErr.error_exit = GTIFF_ErrorExitJPEG;
     sCInfo.client_data = &setjmp_buffer;
 
     // Initialize destination compression parameters from source values.
@@ -609,6 +630,8 @@ static CPLErr GTIFF_CopyBlockFromJPEG( GTIFF_CopyBlockFromJPEGArgs* psArgs )
 /*      Allocated destination coefficient array                         */
 /* -------------------------------------------------------------------- */
     const bool bIsTiled = CPL_TO_BOOL(TIFFIsTiled(hTIFF));
+    psJob->bIsTiled = bIsTiled;
+    psJob->nBlockId = iX + iY * nXBlocks;
 
     int nJPEGWidth = nBlockXSize;
     int nJPEGHeight = nBlockYSize;
@@ -663,7 +686,7 @@ static CPLErr GTIFF_CopyBlockFromJPEG( GTIFF_CopyBlockFromJPEGArgs* psArgs )
             static_cast<JDIMENSION>(v_samp_factor) );
     }
 
-    jpeg_vsiio_dest( &sCInfo, fpMEM );
+    jpeg_vsiio_dest( &sCInfo, psJob->fpMEM );
 
     // Start compressor (note no image data is actually written here).
     jpeg_write_coefficients(&sCInfo, pDstCoeffs);
@@ -752,24 +775,58 @@ static CPLErr GTIFF_CopyBlockFromJPEG( GTIFF_CopyBlockFromJPEGArgs* psArgs )
         }
     }
 
-    jpeg_finish_compress(&sCInfo);
-    jpeg_destroy_compress(&sCInfo);
+    return true;
+}
+
+/************************************************************************/
+/*                    GTIFF_CopyBlockFromJPEGFinish()                   */
+/************************************************************************/
+
+static void GTIFF_CopyBlockFromJPEGFinish( void* pData )
+{
+    GTIFF_CopyBlockFromJPEGJob* psJob =
+        static_cast<GTIFF_CopyBlockFromJPEGJob*>(pData);
 
-    CPL_IGNORE_RET_VAL( VSIFCloseL(fpMEM) );
+    jmp_buf setjmp_buffer;
+    psJob->sCInfo.client_data = &setjmp_buffer;
+    if( setjmp(setjmp_buffer) )
+    {
+        jpeg_destroy_compress(&psJob->sCInfo);
+        CPL_IGNORE_RET_VAL(VSIFCloseL(psJob->fpMEM));
+        psJob->bOK = false;
+        return;
+    }
+
+    jpeg_finish_compress(&psJob->sCInfo);
+    jpeg_destroy_compress(&psJob->sCInfo);
+
+    psJob->bOK = VSIFCloseL(psJob->fpMEM) == 0;
+}
+
+/************************************************************************/
+/*                    GTIFF_CopyBlockFromJPEGWrite()                    */
+/************************************************************************/
+
+static CPLErr GTIFF_CopyBlockFromJPEGWrite( TIFF* hTIFF,
+                                            GTIFF_CopyBlockFromJPEGJob* psJob )
+{
+    if( !psJob->bOK )
+        return CE_Failure;
 
 /* -------------------------------------------------------------------- */
 /*      Write the JPEG content with libtiff raw API                     */
 /* -------------------------------------------------------------------- */
     vsi_l_offset nSize = 0;
-    GByte* pabyJPEGData = VSIGetMemFileBuffer(osTmpFilename, &nSize, FALSE);
+    GByte* pabyJPEGData =
+        VSIGetMemFileBuffer(psJob->szTmpFilename, &nSize, FALSE);
 
     CPLErr eErr = CE_None;
 
-    if( bIsTiled )
+    if( psJob->bIsTiled )
     {
         if( static_cast<vsi_l_offset>(
                TIFFWriteRawTile(
-                   hTIFF, iX + iY * nXBlocks,
+                   hTIFF, psJob->nBlockId,
                    pabyJPEGData,
                    static_cast<tmsize_t>(nSize) ) ) != nSize )
             eErr = CE_Failure;
@@ -778,13 +835,11 @@ static CPLErr GTIFF_CopyBlockFromJPEG( GTIFF_CopyBlockFromJPEGArgs* psArgs )
     {
         if( static_cast<vsi_l_offset>(
                TIFFWriteRawStrip(
-                   hTIFF, iX + iY * nXBlocks,
+                   hTIFF, psJob->nBlockId,
                    pabyJPEGData, static_cast<tmsize_t>(nSize) ) ) != nSize )
             eErr = CE_Failure;
     }
 
-    VSIUnlink(osTmpFilename);
-
     return eErr;
 }
 
@@ -794,7 +849,8 @@ static CPLErr GTIFF_CopyBlockFromJPEG( GTIFF_CopyBlockFromJPEGArgs* psArgs )
 
 CPLErr GTIFF_CopyFromJPEG(GDALDataset* poDS, GDALDataset* poSrcDS,
                           GDALProgressFunc pfnProgress, void * pProgressData,
-                          bool& bShouldFallbackToNormalCopyIfFail)
+                          bool& bShouldFallbackToNormalCopyIfFail,
+                          CPLWorkerThreadPool* poThreadPool)
 {
     bShouldFallbackToNormalCopyIfFail = true;
 
@@ -904,15 +960,25 @@ CPLErr GTIFF_CopyFromJPEG(GDALDataset* poDS, GDALDataset* poSrcDS,
 
     bShouldFallbackToNormalCopyIfFail = false;
 
-    for( int iY = 0; iY < nYBlocks && eErr == CE_None; iY++ )
+    // Blocks are processed by batches of two jobs per thread, which bounds
+    // the memory used, and are written in order once a batch is done.
+    const int nJobs = poThreadPool ? 2 * poThreadPool->GetThreadCount() : 1;
+    std::vector<GTIFF_CopyBlockFromJPEGJob> asJobs(nJobs);
+    const int nBlocks = nXBlocks * nYBlocks;
+
+    for( int iBlockStart = 0; iBlockStart < nBlocks && eErr == CE_None;
+         iBlockStart += nJobs )
     {
-        for( int iX = 0; iX < nXBlocks && eErr == CE_None; iX++ )
+        const int nBatchSize = std::min(nJobs, nBlocks - iBlockStart);
+        int nPrepared = 0;
+        for( ; nPrepared < nBatchSize; nPrepared++ )
         {
+            const int iBlock = iBlockStart + nPrepared;
             GTIFF_CopyBlockFromJPEGArgs sArgs;
             sArgs.hTIFF = hTIFF;
             sArgs.psDInfo = &sDInfo;
-            sArgs.iX = iX;
-            sArgs.iY = iY;
+            sArgs.iX = iBlock % nXBlocks;
+            sArgs.iY = iBlock / nXBlocks;
             sArgs.nXBlocks = nXBlocks;
             sArgs.nXSize = nXSize;
             sArgs.nYSize = nYSize;
@@ -922,12 +988,31 @@ CPLErr GTIFF_CopyFromJPEG(GDALDataset* poDS, GDALDataset* poSrcDS,
             sArgs.iMCU_sample_height = iMCU_sample_height;
             sArgs.pSrcCoeffs = pSrcCoeffs;
 
-            eErr = GTIFF_CopyBlockFromJPEG( &sArgs );
-
-            if( !pfnProgress((iY * nXBlocks + iX + 1) * 1.0 /
-                                (nXBlocks * nYBlocks),
-                             nullptr, pProgressData ) )
+            GTIFF_CopyBlockFromJPEGJob* psJob = &asJobs[nPrepared];
+            if( !GTIFF_CopyBlockFromJPEGPrepare( &sArgs, psJob ) )
+            {
                 eErr = CE_Failure;
+                break;
+            }
+            if( poThreadPool )
+                poThreadPool->SubmitJob(GTIFF_CopyBlockFromJPEGFinish, psJob);
+            else
+                GTIFF_CopyBlockFromJPEGFinish(psJob);
+        }
+        if( poThreadPool )
+            poThreadPool->WaitCompletion();
+
+        for( int i = 0; i < nPrepared; i++ )
+        {
+            if( eErr == CE_None )
+            {
+                eErr = GTIFF_CopyBlockFromJPEGWrite( hTIFF, &asJobs[i] );
+                if( eErr == CE_None &&
+                    !pfnProgress((iBlockStart + i + 1) * 1.0 / nBlocks,
+                                 nullptr, pProgressData ) )
+                    eErr = CE_Failure;
+            }
+            VSIUnlink(asJobs[i].szTmpFilename);
         }
     }
 
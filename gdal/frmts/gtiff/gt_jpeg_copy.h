@@ -55,9 +55,12 @@ int GTIFF_CanCopyFromJPEG( GDALDataset* poSrcDS, char** &papszCreateOptions );
 CPLErr GTIFF_CopyFromJPEG_WriteAdditionalTags( TIFF* hTIFF,
                                                GDALDataset* poSrcDS );
 
+class CPLWorkerThreadPool;
+
 CPLErr GTIFF_CopyFromJPEG( GDALDataset* poDS, GDALDataset* poSrcDS,
                            GDALProgressFunc pfnProgress, void * pProgressData,
-                           bool& bShouldFallbackToNormalCopyIfFail );
+                           bool& bShouldFallbackToNormalCopyIfFail,
+                           CPLWorkerThreadPool* poThreadPool );
 
 #endif // HAVE_LIBJPEG
 
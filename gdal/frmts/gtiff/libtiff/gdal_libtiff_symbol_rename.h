@@ -357,6 +357,7 @@
 #define TIFFFileno gdal_TIFFFileno
 #define _TIFFFillStriles gdal__TIFFFillStriles
 #define _TIFFFillStrilesInternal gdal__TIFFFillStrilesInternal
+#define _TIFFGetFirstStrile gdal__TIFFGetFirstStrile
 #define TIFFFillStrip gdal_TIFFFillStrip
 #define TIFFFillStripPartial gdal_TIFFFillStripPartial
 #define TIFFFillTile gdal_TIFFFillTile
@@ -257,6 +257,7 @@ extern void _TIFFSetupFields(TIFF* tif, const TIFFFieldArray* infoarray);
 extern void _TIFFPrintFieldInfo(TIFF*, FILE*);
 
 extern int _TIFFFillStriles(TIFF*);        
+extern int _TIFFGetFirstStrile(TIFF*, uint64*, uint64*);
 
 typedef enum {
 	tfiatImage,
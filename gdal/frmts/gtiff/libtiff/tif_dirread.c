@@ -5863,6 +5863,113 @@ static int _TIFFFillStrilesInternal( TIFF *tif, int loadStripByteCount )
 #endif 
 }
 
+#if defined(DEFER_STRILE_LOAD)
+/*
+ * Read the value of the first strile from a deferred StripOffsets or
+ * StripByteCounts entry, without loading the whole array.
+ */
+static int
+_TIFFFetchFirstStrileValue( TIFF *tif, TIFFDirEntry *dir, uint64 *pvalue )
+{
+        uint8 data[8];
+        tmsize_t typesize;
+
+        switch( dir->tdir_type )
+        {
+            case TIFF_SHORT: typesize = 2; break;
+            case TIFF_LONG: typesize = 4; break;
+            case TIFF_LONG8: typesize = 8; break;
+            default: return 0;
+        }
+        if( dir->tdir_count == 0 )
+                return 0;
+        if( dir->tdir_count <= (uint64)((tif->tif_flags&TIFF_BIGTIFF) ? 8 : 4) / typesize )
+        {
+                _TIFFmemcpy(data, &dir->tdir_offset, typesize);
+        }
+        else
+        {
+                uint64 offset;
+                if( tif->tif_flags&TIFF_BIGTIFF )
+                {
+                        offset = dir->tdir_offset.toff_long8;
+                        if( tif->tif_flags&TIFF_SWAB )
+                                TIFFSwabLong8(&offset);
+                }
+                else
+                {
+                        uint32 offset32 = dir->tdir_offset.toff_long;
+                        if( tif->tif_flags&TIFF_SWAB )
+                                TIFFSwabLong(&offset32);
+                        offset = offset32;
+                }
+                if( TIFFReadDirEntryData(tif, offset, typesize, data) !=
+                                                        TIFFReadDirEntryErrOk )
+                        return 0;
+        }
+        if( typesize == 2 )
+        {
+                uint16 v;
+                _TIFFmemcpy(&v, data, 2);
+                if( tif->tif_flags&TIFF_SWAB )
+                        TIFFSwabShort(&v);
+                *pvalue = v;
+        }
+        else if( typesize == 4 )
+        {
+                uint32 v;
+                _TIFFmemcpy(&v, data, 4);
+                if( tif->tif_flags&TIFF_SWAB )
+                        TIFFSwabLong(&v);
+                *pvalue = v;
+        }
+        else
+        {
+                uint64 v;
+                _TIFFmemcpy(&v, data, 8);
+                if( tif->tif_flags&TIFF_SWAB )
+                        TIFFSwabLong8(&v);
+                *pvalue = v;
+        }
+        return 1;
+}
+#endif
+
+/*
+ * Return the offset and byte count of the first strip/tile. When strile
+ * loading is deferred and the arrays have not been loaded yet, only the first
+ * entry of each array is read, so that inspecting the first strile (as done
+ * by the JPEG codec to check the YCbCr subsampling) does not force loading
+ * arrays that can be huge for large tiled images.
+ */
+int _TIFFGetFirstStrile( TIFF *tif, uint64 *poffset, uint64 *pbytecount )
+{
+#if defined(DEFER_STRILE_LOAD)
+        TIFFDirectory *td = &tif->tif_dir;
+        if( td->td_stripoffset == NULL &&
+            td->td_stripoffset_entry.tdir_count != 0 &&
+            td->td_stripbytecount_entry.tdir_count != 0 )
+        {
+                if( _TIFFFetchFirstStrileValue(tif, &(td->td_stripoffset_entry),
+                                               poffset) &&
+                    _TIFFFetchFirstStrileValue(tif, &(td->td_stripbytecount_entry),
+                                               pbytecount) )
+                {
+                        return 1;
+                }
+        }
+#endif
+        if( !_TIFFFillStriles( tif ) ||
+            tif->tif_dir.td_stripoffset == NULL ||
+            tif->tif_dir.td_stripbytecount == NULL )
+        {
+                return 0;
+        }
+        *poffset = tif->tif_dir.td_stripoffset[0];
+        *pbytecount = tif->tif_dir.td_stripbytecount[0];
+        return 1;
+}
+
 
 /* vim: set ts=8 sts=8 sw=8 noet: */
 /*
@@ -336,7 +336,6 @@ CPLErr PNG_Band::Compress(buf_mgr &dst, buf_mgr &src)
         ResetPalette(poCT, codec);
     }
 
-    codec.deflate_flags = deflate_flags;
     return codec.CompressPNG(dst, src);
 }
 
@@ -362,6 +361,7 @@ PNG_Band::PNG_Band( GDALMRFDataset *pDS, const ILImage &image,
                  "MRF PNG can only handle up to 4 bands per page");
         return;
     }
+    codec.deflate_flags = deflate_flags;
     // PNGs can be larger than the source, especially for small page size
     poDS->SetPBufferSize( image.pageSizeBytes + 100);
 }
@@ -202,9 +202,29 @@ bool BitStufferV1::read(Byte** ppByte, size_t& nRemainingBytes, vector<unsigned
     srcPtr = arr;
     unsigned int* dstPtr = &dataVec[0];
     int bitPos = 0;
+    unsigned int i = 0;
+
+    // as long as the next uint is there too, extract each value from the
+    // 64 bits starting at its uint, without branching on the values that
+    // cross a uint boundary
+    size_t bitPos64 = 0;
+    const size_t nFastBits = static_cast<size_t>(numUInts - 1) * 32;
+    for (; i < numElements && bitPos64 + numBits <= nFastBits; i++)
+    {
+      const unsigned int* p = arr + (bitPos64 >> 5);
+      unsigned int hi, lo;
+      memcpy(&hi, p, sizeof(unsigned int));
+      memcpy(&lo, p + 1, sizeof(unsigned int));
+      const GUIntBig val = (static_cast<GUIntBig>(hi) << 32) | lo;
+      *dstPtr++ = static_cast<unsigned int>(
+          (val << (bitPos64 & 31)) >> (64 - numBits));
+      bitPos64 += numBits;
+    }
+    srcPtr = arr + (bitPos64 >> 5);
+    bitPos = static_cast<int>(bitPos64 & 31);
 
-    size_t nRemainingBytesTmp = nRemainingBytes;
-    for (unsigned int i = 0; i < numElements; i++)
+    size_t nRemainingBytesTmp = nRemainingBytes - (bitPos64 >> 5) * sizeof(unsigned);
+    for (; i < numElements; i++)
     {
       if (32 - bitPos >= numBits)
       {
@@ -52,6 +52,7 @@
 #include <gdal_pam.h>
 #include <ogr_srs_api.h>
 #include <ogr_spatialref.h>
+#include "cpl_worker_thread_pool.h"
 
 // For printing values
 #include <ostream>
@@ -292,6 +293,20 @@ typedef struct {
 // Offset of index, pos is in pages
 GIntBig IdxOffset(const ILSize &pos, const ILImage &img);
 
+class GDALMRFRasterBand;
+
+// A page encoded or decoded by a worker thread
+typedef struct {
+    GDALMRFRasterBand *band;
+    ILSize pos;         // Page position, in pages
+    GUIntBig infooffset; // Index record position
+    char *buffer;       // Raw page to encode, with room for the output, or page to decode
+    size_t size;        // Size of the data in buffer, then size of the encoded page
+    void *usebuff;      // Encoded page inside buffer, or decoded page
+    int interleaved;    // Page built from all the bands
+    CPLErr ret;
+} MRFPageJob;
+
 enum { SAMPLING_ERR, SAMPLING_Avg, SAMPLING_Near };
 
 GDALMRFRasterBand *newMRFRasterBand(GDALMRFDataset *, const ILImage &, int, int level = 0);
@@ -360,6 +375,12 @@ public:
         return pbsize;
     }
 
+    virtual void FlushCache() override;
+
+    // Reads and decodes the missing blocks of a window in the block cache, level is the overview level
+    CPLErr PrefetchBlocks(int lvl, int nXOff, int nYOff, int nXSize, int nYSize,
+        int nBandCount, const int *panBandMap);
+
 protected:
     CPLErr LevelInit(const int l);
 
@@ -422,6 +443,13 @@ protected:
     // Read the index record itself
     CPLErr ReadTileIdx(ILIdx &tinfo, const ILSize &pos, const ILImage &img, const GIntBig bias = 0);
 
+    // Worker threads for page encoding and decoding, nullptr if NUM_THREADS is not set
+    CPLWorkerThreadPool *GetThreadPool();
+    // Queue an encoded page write, pages are written in the order they are queued
+    CPLErr QueueWriteJob(MRFPageJob *job);
+    // Wait for the queued pages to be encoded and write them
+    CPLErr FlushWriteJobs();
+
     VSILFILE *IdxFP();
     VSILFILE *DataFP();
     GDALRWFlag IdxMode() {
@@ -503,6 +531,10 @@ protected:
     VF dfp;  // Data file handle
     VF ifp;  // Index file handle
 
+    int nThreads; // NUM_THREADS, for page encoding and decoding
+    CPLWorkerThreadPool *poThreadPool;
+    std::vector<MRFPageJob *> writeJobs; // Pages being encoded, in write order
+
     // statistical values
     std::vector<double> vNoData, vMin, vMax;
 };
@@ -531,6 +563,12 @@ public:
     virtual double  GetMinimum(int *) override;
     virtual double  GetMaximum(int *) override;
 
+#if GDAL_VERSION_MAJOR >= 2
+    virtual CPLErr IRasterIO(GDALRWFlag, int, int, int, int,
+        void *, int, int, GDALDataType,
+        GSpacing, GSpacing, GDALRasterIOExtraArg*) override;
+#endif
+
     // MRF specific, fetch is from a remote source
     CPLErr FetchBlock(int xblk, int yblk, void *buffer = nullptr);
     // Fetch a block from a cloned MRF
@@ -545,6 +583,16 @@ public:
     // de-interlace a buffer in pixel blocks
     CPLErr ReadInterleavedBlock(int xblk, int yblk, void *buffer);
 
+    // Encode or decode a MRFPageJob, called from the worker threads
+    static void EncodePageJob(void *);
+    static void DecodePageJob(void *);
+
+    // Can the codec run in parallel on different pages of the same band
+    virtual bool IsThreadSafe() const { return true; }
+    CPLWorkerThreadPool *GetWriteThreadPool();
+    MRFPageJob *NewWriteJob(GUIntBig infooffset, int interleaved);
+    CPLErr WriteEmptyPage(GUIntBig infooffset);
+
     const char *GetOptionValue(const char *opt, const char *def) const;
     void SetAccess(GDALAccess eA) { eAccess = eA; }
     void SetDeflate(int v) { deflatep = (v != 0); }
@@ -632,6 +680,8 @@ public:
 protected:
     virtual CPLErr Decompress(buf_mgr &dst, buf_mgr &src) override;
     virtual CPLErr Compress(buf_mgr &dst, buf_mgr &src) override;
+    // The PPNG palette is set on first write
+    virtual bool IsThreadSafe() const override { return img.comp != IL_PPNG; }
 
     PNG_Codec codec;
 };
@@ -711,6 +761,8 @@ public:
 protected:
     virtual CPLErr Decompress(buf_mgr &dst, buf_mgr &src) override;
     virtual CPLErr Compress(buf_mgr &dst, buf_mgr &src) override;
+    // Uses /vsimem/ files with a shared counter
+    virtual bool IsThreadSafe() const override { return false; }
 
     // Create options for TIF pages
     char **papszOptions;
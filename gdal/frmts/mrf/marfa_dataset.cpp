@@ -69,6 +69,13 @@ NAMESPACE_MRF_START
 #define BOOLTEST CSLTestBoolean
 #endif
 
+// Number of worker threads from a NUM_THREADS value, ALL_CPUS or a count
+static int ThreadCount(const char *pszValue)
+{
+    int n = EQUAL(pszValue, "ALL_CPUS") ? CPLGetNumCPUs() : atoi(pszValue);
+    return std::max(1, std::min(n, 1024));
+}
+
 // Initialize as invalid
 GDALMRFDataset::GDALMRFDataset() :
     zslice(0),
@@ -93,7 +100,9 @@ GDALMRFDataset::GDALMRFDataset() :
     bdirty(0),
     bGeoTransformValid(TRUE),
     poColorTable(nullptr),
-    Quality(0)
+    Quality(0),
+    nThreads(ThreadCount(CPLGetConfigOption("GDAL_NUM_THREADS", "1"))),
+    poThreadPool(nullptr)
 {
     //                X0   Xx   Xy  Y0    Yx   Yy
     double gt[6] = { 0.0, 1.0, 0.0, 0.0, 0.0, 1.0 };
@@ -158,6 +167,7 @@ GDALMRFDataset::~GDALMRFDataset()
     if (dfp.FP)
         VSIFCloseL(dfp.FP);
 
+    delete poThreadPool;
     delete poColorTable;
 
     // CPLFree ignores being called with NULL
@@ -207,6 +217,55 @@ CPLErr GDALMRFDataset::IRasterIO(GDALRWFlag eRWFlag, int nXOff, int nYOff, int n
         static_cast<int>(nPixelSpace), static_cast<int>(nLineSpace),
         static_cast<int>(nBandSpace));
 
+#if GDAL_VERSION_MAJOR >= 2
+    //
+    // Reading at full resolution, go in swaths of block rows that fit in a quarter of the
+    // block cache.  The missing blocks of each swath are fetched and decoded at once
+    //
+    if (eRWFlag == GF_Read && nBufXSize == nXSize && nBufYSize == nYSize) {
+        const ILSize &psz = current.pagesize;
+        const GIntBig nColumns = (nXOff + nXSize - 1) / psz.x - nXOff / psz.x + 1;
+        // Interleaved pages fill the blocks of all the bands
+        const GIntBig nRowBytes = nColumns * (current.pageSizeBytes / psz.c) *
+            ((psz.c > 1) ? nBands : nBandCount);
+        const GIntBig nSwathRows = GDALGetCacheMax64() / 4 / nRowBytes;
+
+        if (nSwathRows > 0) {
+            const int nLastY = nYOff + nYSize;
+            if (std::min(GIntBig(nLastY), (nYOff / psz.y + nSwathRows) * psz.y) == nLastY) {
+                // Single swath
+                PrefetchBlocks(0, nXOff, nYOff, nXSize, nYSize, nBandCount, panBandMap);
+            }
+            else {
+                CPLErr eErr = CE_None;
+                for (int y = nYOff; y < nLastY && eErr == CE_None; ) {
+                    const int nEndY = static_cast<int>(std::min(GIntBig(nLastY),
+                        (y / psz.y + nSwathRows) * psz.y));
+
+                    GDALRasterIOExtraArg sExtraArg;
+                    INIT_RASTERIO_EXTRA_ARG(sExtraArg);
+                    sExtraArg.eResampleAlg = psExtraArgs->eResampleAlg;
+                    if (psExtraArgs->pfnProgress) {
+                        sExtraArg.pfnProgress = GDALScaledProgress;
+                        sExtraArg.pProgressData = GDALCreateScaledProgress(
+                            double(y - nYOff) / nYSize, double(nEndY - nYOff) / nYSize,
+                            psExtraArgs->pfnProgress, psExtraArgs->pProgressData);
+                    }
+
+                    PrefetchBlocks(0, nXOff, y, nXSize, nEndY - y, nBandCount, panBandMap);
+                    eErr = GDALPamDataset::IRasterIO(eRWFlag, nXOff, y, nXSize, nEndY - y,
+                        static_cast<GByte *>(pData) + (y - nYOff) * nLineSpace, nXSize, nEndY - y,
+                        eBufType, nBandCount, panBandMap, nPixelSpace, nLineSpace, nBandSpace,
+                        &sExtraArg);
+                    GDALDestroyScaledProgress(sExtraArg.pProgressData);
+                    y = nEndY;
+                }
+                return eErr;
+            }
+        }
+    }
+#endif
+
     //
     // Call the parent implementation, which splits it into bands and calls their IRasterIO
     //
@@ -218,6 +277,73 @@ CPLErr GDALMRFDataset::IRasterIO(GDALRWFlag eRWFlag, int nXOff, int nYOff, int n
         );
 }
 
+/*
+ *\brief Writes the dirty blocks, then the pages still being encoded
+ */
+void GDALMRFDataset::FlushCache()
+{
+    GDALPamDataset::FlushCache();
+    FlushWriteJobs();
+}
+
+/*
+ *\brief The worker threads, created on first use
+ */
+CPLWorkerThreadPool *GDALMRFDataset::GetThreadPool()
+{
+    if (poThreadPool == nullptr && nThreads > 1) {
+        poThreadPool = new CPLWorkerThreadPool();
+        if (!poThreadPool->Setup(nThreads, nullptr, nullptr)) {
+            delete poThreadPool;
+            poThreadPool = nullptr;
+            nThreads = 1;
+        }
+        else
+            CPLDebug("MRF", "Using %d threads", nThreads);
+    }
+    return poThreadPool;
+}
+
+/*
+ *\brief Queues a page write, the page is encoded by a worker thread
+ *
+ * Pages are written in the order they are queued, once the queue is full.
+ * A job without a buffer writes an empty page.  The dataset owns the job.
+ */
+CPLErr GDALMRFDataset::QueueWriteJob(MRFPageJob *job)
+{
+    writeJobs.push_back(job);
+    if (job->buffer)
+        GetThreadPool()->SubmitJob(GDALMRFRasterBand::EncodePageJob, job);
+    if (writeJobs.size() >= static_cast<size_t>(2 * nThreads))
+        return FlushWriteJobs();
+    return CE_None;
+}
+
+CPLErr GDALMRFDataset::FlushWriteJobs()
+{
+    if (writeJobs.empty())
+        return CE_None;
+
+    poThreadPool->WaitCompletion();
+    CPLErr ret = CE_None;
+    for (size_t i = 0; i < writeJobs.size(); i++) {
+        MRFPageJob *job = writeJobs[i];
+        if (job->ret != CE_None) {
+            // Deflate failed, write it as an empty tile
+            CPLError(CE_Failure, CPLE_AppDefined, "MRF: Deflate error");
+            WriteTile(nullptr, job->infooffset, 0);
+            ret = CE_Failure;
+        }
+        else if (CE_None != WriteTile(job->usebuff, job->infooffset, job->size))
+            ret = CE_Failure;
+        CPLFree(job->buffer);
+        delete job;
+    }
+    writeJobs.clear();
+    return ret;
+}
+
 /**
 *\brief Build some overviews
 *
@@ -1855,6 +1981,9 @@ void GDALMRFDataset::ProcessOpenOptions(char **papszOptions)
     const char *val = opt.FetchNameValue("ZSLICE");
     if (val)
         zslice = atoi(val);
+    val = opt.FetchNameValue("NUM_THREADS");
+    if (val)
+        nThreads = ThreadCount(val);
 }
 
 // Apply create options to the current dataset, only valid during creation
@@ -1910,6 +2039,9 @@ void GDALMRFDataset::ProcessCreateOptions(char **papszOptions)
     val = opt.FetchNameValue("SPACING");
     if (val) spacing = atoi(val);
 
+    val = opt.FetchNameValue("NUM_THREADS");
+    if (val) nThreads = ThreadCount(val);
+
     optlist.Assign(CSLTokenizeString2(opt.FetchNameValue("OPTIONS"),
         " \t\n\r", CSLT_STRIPLEADSPACES | CSLT_STRIPENDSPACES));
 
@@ -47,6 +47,7 @@
 #include <ogr_srs_api.h>
 #include <ogr_spatialref.h>
 
+#include <algorithm>
 #include <vector>
 #include <assert.h>
 #include "../zlib/zlib.h"
@@ -685,6 +686,9 @@ CPLErr GDALMRFRasterBand::IReadBlock(int xblk, int yblk, void *buffer)
     if (poDS->bypass_cache && !poDS->source.empty())
         return FetchBlock(xblk, yblk, buffer);
 
+    // Pages still being encoded
+    poDS->FlushWriteJobs();
+
     tinfo.size = 0; // Just in case it is missing
     if (CE_None != poDS->ReadTileIdx(tinfo, req, img)) {
         if (poDS->no_errors) {
@@ -843,6 +847,277 @@ CPLErr GDALMRFRasterBand::IReadBlock(int xblk, int yblk, void *buffer)
     return ReadInterleavedBlock(xblk, yblk, buffer);
 }
 
+#if GDAL_VERSION_MAJOR >= 2
+/**
+*\brief Read at full resolution fetches the missing blocks at once
+*
+*/
+
+CPLErr GDALMRFRasterBand::IRasterIO(GDALRWFlag eRWFlag, int nXOff, int nYOff, int nXSize, int nYSize,
+    void *pData, int nBufXSize, int nBufYSize, GDALDataType eBufType,
+    GSpacing nPixelSpace, GSpacing nLineSpace, GDALRasterIOExtraArg* psExtraArgs)
+{
+    if (eRWFlag == GF_Read && nBufXSize == nXSize && nBufYSize == nYSize)
+        poDS->PrefetchBlocks(m_l, nXOff, nYOff, nXSize, nYSize, 1, &nBand);
+
+    return GDALPamRasterBand::IRasterIO(eRWFlag, nXOff, nYOff, nXSize, nYSize, pData,
+        nBufXSize, nBufYSize, eBufType, nPixelSpace, nLineSpace, psExtraArgs);
+}
+#endif
+
+/**
+*\brief Decode a page read by PrefetchBlocks, runs on a worker thread
+*
+* The errors are not reported, pages that fail are read again by IReadBlock
+*/
+
+void GDALMRFRasterBand::DecodePageJob(void *p)
+{
+    MRFPageJob *job = static_cast<MRFPageJob *>(p);
+    GDALMRFRasterBand *band = job->band;
+    const ILImage &img = band->img;
+
+    CPLPushErrorHandler(CPLQuietErrorHandler);
+    buf_mgr src = { job->buffer, job->size };
+    if (band->deflatep && img.pageSizeBytes <= INT_MAX - 1440) {
+        buf_mgr dst;
+        dst.size = img.pageSizeBytes + 1440;
+        dst.buffer = static_cast<char *>(VSIMalloc(dst.size));
+        if (dst.buffer && ZUnPack(src, dst, band->deflate_flags)) {
+            CPLFree(job->buffer);
+            job->buffer = src.buffer = dst.buffer;
+            job->size = src.size = dst.size;
+        }
+        else // assume the page was not gzipped
+            CPLFree(dst.buffer);
+    }
+
+    buf_mgr dst = { static_cast<char *>(job->usebuff), static_cast<size_t>(img.pageSizeBytes) };
+    job->ret = band->Decompress(dst, src);
+    dst.size = img.pageSizeBytes;
+    if (job->ret == CE_None && is_Endianess_Dependent(img.dt, img.comp) && (img.nbo != NET_ORDER))
+        swab_buff(dst, img);
+    CPLPopErrorHandler();
+}
+
+/**
+*\brief Fetch and decode the missing blocks of a window at once
+*
+* The index records and the pages are read with one multi-range read each,
+* which is much faster than one request per block on network file systems.
+* The pages are decoded by the worker threads, if there are any.  The blocks
+* go in the block cache, where IReadBlock finds them.  Blocks already in the
+* cache are left alone, anything unusual is left to IReadBlock.
+*
+*/
+
+CPLErr GDALMRFDataset::PrefetchBlocks(int lvl, int nXOff, int nYOff, int nXSize, int nYSize,
+    int nBandCount, const int *panBandMap)
+{
+    // Caching and cloned MRFs fetch the blocks one at a time
+    if (!source.empty() || missing || nBandCount < 1 || nXSize < 1 || nYSize < 1)
+        return CE_None;
+
+    // The bands at this level
+    vector<GDALMRFRasterBand *> bands;
+    for (int i = 0; i < nBands; i++) {
+        GDALMRFRasterBand *b = static_cast<GDALMRFRasterBand *>(GetRasterBand(i + 1));
+        if (lvl != 0) {
+            if (lvl > static_cast<int>(b->overviews.size()))
+                return CE_None;
+            b = b->overviews[lvl - 1];
+        }
+        bands.push_back(b);
+    }
+
+    const ILImage &img = bands[0]->img;
+    const int cstride = img.pagesize.c;
+    const size_t bsb = img.pageSizeBytes / cstride;
+    VSILFILE *l_ifp = IdxFP();
+    VSILFILE *l_dfp = DataFP();
+    if (l_ifp == nullptr || l_dfp == nullptr)
+        return CE_None;
+
+    FlushWriteJobs();
+
+    // Page slices holding the requested bands
+    vector<int> slices;
+    for (int i = 0; i < nBandCount; i++)
+        slices.push_back((panBandMap[i] - 1) / cstride);
+    std::sort(slices.begin(), slices.end());
+    slices.erase(std::unique(slices.begin(), slices.end()), slices.end());
+
+    // The pages with at least one requested block not in cache, in index order
+    vector<MRFPageJob> pages;
+    for (int y = nYOff / img.pagesize.y; y <= (nYOff + nYSize - 1) / img.pagesize.y; y++) {
+        for (int x = nXOff / img.pagesize.x; x <= (nXOff + nXSize - 1) / img.pagesize.x; x++) {
+            for (size_t s = 0; s < slices.size(); s++) {
+                bool bMissing = false;
+                for (int i = 0; i < nBandCount && !bMissing; i++) {
+                    if ((panBandMap[i] - 1) / cstride != slices[s])
+                        continue;
+                    GDALRasterBlock *poBlock = bands[panBandMap[i] - 1]->TryGetLockedBlockRef(x, y);
+                    if (poBlock)
+                        poBlock->DropLock();
+                    else
+                        bMissing = true;
+                }
+                if (!bMissing)
+                    continue;
+                MRFPageJob job = MRFPageJob();
+                job.band = bands[slices[s] * cstride];
+                job.pos = ILSize(x, y, 0, slices[s], lvl);
+                job.infooffset = IdxOffset(job.pos, img);
+                pages.push_back(job);
+            }
+        }
+    }
+
+    // A single block is just as fast in IReadBlock, too many would not stay in the cache
+    if (pages.size() < 2 || GIntBig(pages.size()) * img.pageSizeBytes > GDALGetCacheMax64() / 4)
+        return CE_None;
+
+    CPLDebug("MRF_IO", "PrefetchBlocks %d pages, level %d", static_cast<int>(pages.size()), lvl);
+
+    // Read the index records, one range for each row of pages
+    vector<vsi_l_offset> offsets;
+    vector<size_t> sizes;
+    vector<size_t> first; // First page of each range
+    for (size_t i = 0; i < pages.size(); i++) {
+        if (i == 0 || pages[i].pos.y != pages[i - 1].pos.y) {
+            first.push_back(i);
+            offsets.push_back(pages[i].infooffset);
+            sizes.push_back(0);
+        }
+        sizes.back() = static_cast<size_t>(pages[i].infooffset - offsets.back()) + sizeof(ILIdx);
+    }
+
+    vector<ILIdx> tinfo(pages.size());
+    {
+        size_t total = 0;
+        for (size_t r = 0; r < sizes.size(); r++)
+            total += sizes[r];
+        vector<char> idx(total);
+        vector<void *> ranges(sizes.size());
+        for (size_t r = 0, pos = 0; r < sizes.size(); pos += sizes[r], r++)
+            ranges[r] = &idx[pos];
+        if (0 != VSIFReadMultiRangeL(static_cast<int>(ranges.size()), &ranges[0], &offsets[0], &sizes[0], l_ifp))
+            return CE_None;
+
+        for (size_t r = 0; r < first.size(); r++) {
+            const size_t last = (r + 1 < first.size()) ? first[r + 1] : pages.size();
+            for (size_t i = first[r]; i < last; i++) {
+                memcpy(&tinfo[i], static_cast<char *>(ranges[r]) + (pages[i].infooffset - offsets[r]),
+                    sizeof(ILIdx));
+                tinfo[i].offset = net64(tinfo[i].offset);
+                tinfo[i].size = net64(tinfo[i].size);
+            }
+        }
+    }
+
+    // Read the pages that have data, in file order
+    vector<MRFPageJob *> toRead;
+    for (size_t i = 0; i < pages.size(); i++) {
+        // No stored tile should be larger than twice the raw size, IReadBlock reports those
+        if (tinfo[i].size < 0 || tinfo[i].size > pbsize * 2)
+            pages[i].ret = CE_Failure;
+        else if (tinfo[i].size > 0)
+            toRead.push_back(&pages[i]);
+    }
+
+    std::sort(toRead.begin(), toRead.end(), [&pages, &tinfo](const MRFPageJob *a, const MRFPageJob *b) {
+        return tinfo[a - &pages[0]].offset < tinfo[b - &pages[0]].offset;
+    });
+
+    CPLErr ret = CE_None;
+    if (!toRead.empty()) {
+        vector<void *> ranges;
+        offsets.clear();
+        sizes.clear();
+        for (size_t i = 0; i < toRead.size() && ret == CE_None; i++) {
+            MRFPageJob *job = toRead[i];
+            const ILIdx &t = tinfo[job - &pages[0]];
+            job->size = static_cast<size_t>(t.size);
+            job->buffer = static_cast<char *>(VSIMalloc(job->size + PADDING_BYTES));
+            job->usebuff = VSIMalloc(img.pageSizeBytes);
+            if (!job->buffer || !job->usebuff)
+                ret = CE_Failure;
+            else
+                memset(job->buffer + job->size, 0, PADDING_BYTES);
+            ranges.push_back(job->buffer);
+            offsets.push_back(t.offset);
+            sizes.push_back(job->size);
+        }
+
+        if (ret == CE_None && 0 == VSIFReadMultiRangeL(static_cast<int>(ranges.size()), &ranges[0],
+            &offsets[0], &sizes[0], l_dfp))
+        {
+            CPLWorkerThreadPool *pool = bands[0]->IsThreadSafe() ? GetThreadPool() : nullptr;
+            for (size_t i = 0; i < toRead.size(); i++) {
+                if (pool)
+                    pool->SubmitJob(GDALMRFRasterBand::DecodePageJob, toRead[i]);
+                else
+                    GDALMRFRasterBand::DecodePageJob(toRead[i]);
+            }
+            if (pool)
+                pool->WaitCompletion();
+        }
+        else { // Leave it to IReadBlock
+            ret = CE_Failure;
+        }
+    }
+
+    // Store the blocks in the cache
+    for (size_t i = 0; i < pages.size() && ret == CE_None; i++) {
+        MRFPageJob &job = pages[i];
+        bool fill = (0 == tinfo[i].size);
+        if (!fill && job.ret != CE_None) {
+            if (!no_errors)
+                continue;
+            fill = true;
+        }
+
+        for (int k = 0; k < cstride && job.pos.c * cstride + k < nBands; k++) {
+            GDALMRFRasterBand *b = bands[job.pos.c * cstride + k];
+            GDALRasterBlock *poBlock = b->TryGetLockedBlockRef(job.pos.x, job.pos.y);
+            if (poBlock) {
+                poBlock->DropLock();
+                continue;
+            }
+            poBlock = b->GetLockedBlockRef(job.pos.x, job.pos.y, TRUE);
+            if (poBlock == nullptr)
+                continue;
+
+            void *ob = poBlock->GetDataRef();
+            if (fill)
+                b->FillBlock(ob);
+            else if (1 == cstride)
+                memcpy(ob, job.usebuff, bsb);
+            else {
+// Same deinterleaving as ReadInterleavedBlock
+#define CpySI(T) cpy_stride_in<T> (ob, reinterpret_cast<T *>(job.usebuff) + k,\
+    bsb / sizeof(T), cstride)
+                switch (GDALGetDataTypeSize(img.dt) / 8)
+                {
+                case 1: CpySI(GByte); break;
+                case 2: CpySI(GInt16); break;
+                case 4: CpySI(GInt32); break;
+                case 8: CpySI(GIntBig); break;
+                }
+#undef CpySI
+            }
+            poBlock->DropLock();
+        }
+    }
+
+    for (size_t i = 0; i < pages.size(); i++) {
+        CPLFree(pages[i].buffer);
+        CPLFree(pages[i].usebuff);
+    }
+
+    return CE_None;
+}
+
 /**
 *\brief Write a block from the provided buffer
 *
@@ -874,7 +1149,16 @@ CPLErr GDALMRFRasterBand::IWriteBlock(int xblk, int yblk, void *buffer)
         double val = GetNoDataValue(&success);
         if (!success) val = 0.0;
         if (isAllVal(eDataType, buffer, img.pageSizeBytes, val))
-            return poDS->WriteTile(nullptr, infooffset, 0);
+            return WriteEmptyPage(infooffset);
+
+        // Encode a copy of the page on a worker thread
+        if (GetWriteThreadPool()) {
+            MRFPageJob *job = NewWriteJob(infooffset, FALSE);
+            if (job == nullptr)
+                return CE_Failure;
+            memcpy(job->buffer, buffer, job->size);
+            return poDS->QueueWriteJob(job);
+        }
 
         // Use the pbuffer to hold the compressed page before writing it
         poDS->tile = ILSize(); // Mark it corrupt
@@ -909,7 +1193,15 @@ CPLErr GDALMRFRasterBand::IWriteBlock(int xblk, int yblk, void *buffer)
     // Keep track of what bands are empty
     GUIntBig empties=0;
 
-    void *tbuffer = VSIMalloc(img.pageSizeBytes + poDS->pbsize);
+    // When encoding on a worker thread, the page is built in the job buffer
+    MRFPageJob *job = nullptr;
+    if (GetWriteThreadPool()) {
+        job = NewWriteJob(infooffset, TRUE);
+        if (job == nullptr)
+            return CE_Failure;
+    }
+
+    void *tbuffer = job ? job->buffer : VSIMalloc(img.pageSizeBytes + poDS->pbsize);
 
     if (!tbuffer) {
         CPLError(CE_Failure,CPLE_AppDefined, "MRF: Can't allocate write buffer");
@@ -967,6 +1259,7 @@ CPLErr GDALMRFRasterBand::IWriteBlock(int xblk, int yblk, void *buffer)
                     poBlock->DropLock();
                 }
                 CPLFree(tbuffer);
+                delete job;
                 return CE_Failure;
             }
         }
@@ -984,7 +1277,8 @@ CPLErr GDALMRFRasterBand::IWriteBlock(int xblk, int yblk, void *buffer)
 
     if (GIntBig(empties) == AllBandMask()) {
         CPLFree(tbuffer);
-        return poDS->WriteTile(nullptr, infooffset, 0);
+        delete job;
+        return WriteEmptyPage(infooffset);
     }
 
     if (poDS->bdirty != AllBandMask())
@@ -992,6 +1286,11 @@ CPLErr GDALMRFRasterBand::IWriteBlock(int xblk, int yblk, void *buffer)
         "MRF: IWrite, band dirty mask is " CPL_FRMT_GIB " instead of " CPL_FRMT_GIB,
         poDS->bdirty, AllBandMask());
 
+    if (job) {
+        poDS->bdirty = 0;
+        return poDS->QueueWriteJob(job);
+    }
+
     buf_mgr src;
     src.buffer = (char *)tbuffer;
     src.size = static_cast<size_t>(img.pageSizeBytes);
@@ -1033,6 +1332,82 @@ CPLErr GDALMRFRasterBand::IWriteBlock(int xblk, int yblk, void *buffer)
     return ret;
 }
 
+/**
+*\brief Encode a page queued by IWriteBlock, runs on a worker thread
+*
+* Same as IWriteBlock, the encoded page ends up in usebuff
+*/
+
+void GDALMRFRasterBand::EncodePageJob(void *p)
+{
+    MRFPageJob *job = static_cast<MRFPageJob *>(p);
+    GDALMRFRasterBand *band = job->band;
+    const ILImage &img = band->img;
+    const size_t capacity = img.pageSizeBytes + band->poDS->pbsize;
+
+    // Only pages from separate bands get swapped
+    buf_mgr src = { job->buffer, job->size };
+    if (!job->interleaved && is_Endianess_Dependent(img.dt, img.comp) && (img.nbo != NET_ORDER))
+        swab_buff(src, img);
+
+    buf_mgr dst = { job->buffer + job->size, capacity - job->size };
+    if (CE_None != band->Compress(dst, src)) {
+        // Compress failed, write it as an empty tile
+        job->usebuff = nullptr;
+        job->size = 0;
+        return;
+    }
+
+    job->usebuff = dst.buffer;
+    if (band->deflatep) {
+        // Move the packed part at the start of the buffer, to make more space available
+        memmove(job->buffer, dst.buffer, dst.size);
+        dst.buffer = job->buffer;
+        job->usebuff = DeflateBlock(dst, capacity - dst.size, band->deflate_flags);
+        if (!job->usebuff)
+            job->ret = CE_Failure;
+    }
+    job->size = dst.size;
+}
+
+// The worker threads, if the pages of this band can be encoded on them
+CPLWorkerThreadPool *GDALMRFRasterBand::GetWriteThreadPool()
+{
+    // Caching and cloned MRFs write the fetched pages directly
+    if (!IsThreadSafe() || !poDS->source.empty())
+        return nullptr;
+    return poDS->GetThreadPool();
+}
+
+// A write job with room for the raw page and the encoded one
+MRFPageJob *GDALMRFRasterBand::NewWriteJob(GUIntBig infooffset, int interleaved)
+{
+    char *buffer = static_cast<char *>(VSIMalloc(img.pageSizeBytes + poDS->pbsize));
+    if (!buffer) {
+        CPLError(CE_Failure, CPLE_AppDefined, "MRF: Can't allocate write buffer");
+        return nullptr;
+    }
+    MRFPageJob *job = new MRFPageJob();
+    job->band = this;
+    job->infooffset = infooffset;
+    job->buffer = buffer;
+    job->size = img.pageSizeBytes;
+    job->interleaved = interleaved;
+    job->ret = CE_None;
+    return job;
+}
+
+// Empty pages wait for the pages being encoded, to keep the write order
+CPLErr GDALMRFRasterBand::WriteEmptyPage(GUIntBig infooffset)
+{
+    if (poDS->writeJobs.empty())
+        return poDS->WriteTile(nullptr, infooffset, 0);
+    MRFPageJob *job = new MRFPageJob();
+    job->infooffset = infooffset;
+    job->ret = CE_None;
+    return poDS->QueueWriteJob(job);
+}
+
 //
 // Tests if a given block exists without reading it
 // returns false only when it is definitely not existing
@@ -1047,7 +1422,7 @@ bool GDALMRFRasterBand::TestBlock(int xblk, int yblk)
     GInt32 cstride = img.pagesize.c;
     ILSize req(xblk, yblk, 0, (nBand - 1) / cstride, m_l);
 
-    
+    poDS->FlushWriteJobs();
     if (CE_None != poDS->ReadTileIdx(tinfo, req, img))
         // Got an error reading the tile index
         return !poDS->no_errors;
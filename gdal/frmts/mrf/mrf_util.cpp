@@ -637,6 +637,8 @@ void GDALRegister_mrf()
         "       <Value>RGB</Value>"
         "       <Value>YCC</Value>"
         "   </Option>\n"
+        "   <Option name='NUM_THREADS' type='string' "
+                    "description='Number of worker threads for page encoding, or ALL_CPUS'/>\n"
         "</CreationOptionList>\n");
 
     driver->SetMetadataItem(
@@ -644,6 +646,7 @@ void GDALRegister_mrf()
       "<OpenOptionList>"
       "    <Option name='NOERRORS' type='boolean' description='Ignore decompression errors' default='FALSE'/>"
       "    <Option name='ZSLICE' type='int' description='For a third dimension MRF, pick a slice' default='0'/>"
+      "    <Option name='NUM_THREADS' type='string' description='Number of worker threads for page decoding and encoding, or ALL_CPUS'/>"
       "</OpenOptionList>"
       );
 
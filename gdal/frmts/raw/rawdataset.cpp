@@ -40,6 +40,8 @@
 #endif
 #include <algorithm>
 #include <limits>
+#include <typeinfo>
+#include <vector>
 
 #include "cpl_conv.h"
 #include "cpl_error.h"
@@ -47,6 +49,7 @@
 #include "cpl_string.h"
 #include "cpl_virtualmem.h"
 #include "cpl_vsi.h"
+#include "cpl_worker_thread_pool.h"
 #include "gdal.h"
 #include "gdal_priv.h"
 
@@ -196,6 +199,9 @@ RawRasterBand::~RawRasterBand()
 
     RawRasterBand::FlushCache();
 
+    if( psVirtualMemIOMapping )
+        CPLVirtualMemFree(psVirtualMemIOMapping);
+
     if (bOwnsFP)
     {
         if( VSIFCloseL(fpRawL) != 0 )
@@ -574,6 +580,209 @@ int RawRasterBand::CanUseDirectIO(int /* nXOff */,
     return CPLTestBool(pszGDAL_ONE_BIG_READ);
 }
 
+/************************************************************************/
+/*                         CanUseVirtualMemIO()                         */
+/*                                                                      */
+/*      Check if a read request can be served directly from a memory   */
+/*      mapping of the file, and set up that mapping on first use.     */
+/************************************************************************/
+
+int RawRasterBand::CanUseVirtualMemIO( GDALRWFlag eRWFlag,
+                                       int nXSize, int nYSize,
+                                       int nBufXSize, int nBufYSize,
+                                       GDALDataType eBufType )
+{
+    // The block cache and the line buffer may only hold something that
+    // differs from the file content in update mode.
+    if( eRWFlag != GF_Read || eAccess != GA_ReadOnly ||
+        eBufType != eDataType ||
+        nXSize != nBufXSize || nYSize != nBufYSize )
+    {
+        return FALSE;
+    }
+
+    if( bVirtualMemIOAvailable < 0 )
+    {
+        bVirtualMemIOAvailable = FALSE;
+
+        const int nDTSize = GDALGetDataTypeSizeBytes(eDataType);
+        const vsi_l_offset nSize =
+            static_cast<vsi_l_offset>(nRasterYSize - 1) * nLineOffset +
+            static_cast<vsi_l_offset>(nRasterXSize - 1) * nPixelOffset +
+            nDTSize;
+        // Mapping whole bands is only reasonable with a 64 bit address space.
+        if( SIZEOF_VOIDP < 8 ||
+            nPixelOffset < nDTSize || nLineOffset < 0 ||
+            pLineBuffer == nullptr ||
+            !CPLTestBool(CPLGetConfigOption("GDAL_RAW_VIRTUAL_MEM_IO",
+                                            "YES")) ||
+            !CPLIsVirtualMemFileMapAvailable() ||
+            VSIFGetNativeFileDescriptorL(fpRawL) == nullptr )
+        {
+            return FALSE;
+        }
+
+        // Truncated or sparse files are left to the regular code path that
+        // knows how to deal with them, and must not be mapped as accessing
+        // pages beyond the end of file would raise SIGBUS.
+        const vsi_l_offset nCurPos = VSIFTellL(fpRawL);
+        if( VSIFSeekL(fpRawL, 0, SEEK_END) != 0 )
+            return FALSE;
+        const vsi_l_offset nFileSize = VSIFTellL(fpRawL);
+        if( VSIFSeekL(fpRawL, nCurPos, SEEK_SET) != 0 ||
+            nFileSize < nImgOffset || nFileSize - nImgOffset < nSize )
+        {
+            return FALSE;
+        }
+
+        psVirtualMemIOMapping = CPLVirtualMemFileMapNew(
+            fpRawL, nImgOffset, nSize, VIRTUALMEM_READONLY, nullptr, nullptr);
+        if( psVirtualMemIOMapping == nullptr )
+            return FALSE;
+        bVirtualMemIOAvailable = TRUE;
+    }
+
+    return bVirtualMemIOAvailable;
+}
+
+/************************************************************************/
+/*                            VirtualMemIO()                            */
+/************************************************************************/
+
+namespace {
+struct RawVirtualMemIOJob
+{
+    const GByte *pabySrc;
+    GByte       *pabyDst;
+    int          nLines;
+    int          nXSize;
+    GDALDataType eDataType;
+    int          nPixelOffset;
+    int          nLineOffset;
+    GSpacing     nPixelSpace;
+    GSpacing     nLineSpace;
+    bool         bSwap;
+};
+}
+
+static void RawVirtualMemIOCopyLines( void *pData )
+{
+    const RawVirtualMemIOJob *psJob =
+        static_cast<const RawVirtualMemIOJob *>(pData);
+    const int nDTSize = GDALGetDataTypeSizeBytes(psJob->eDataType);
+    const int nPixelSpace = static_cast<int>(psJob->nPixelSpace);
+    for( int iLine = 0; iLine < psJob->nLines; iLine++ )
+    {
+        const GByte *pabySrc =
+            psJob->pabySrc + static_cast<size_t>(iLine) * psJob->nLineOffset;
+        GByte *pabyDst = psJob->pabyDst + iLine * psJob->nLineSpace;
+        if( psJob->nPixelOffset == nDTSize && nPixelSpace == nDTSize )
+        {
+            memcpy(pabyDst, pabySrc,
+                   static_cast<size_t>(psJob->nXSize) * nDTSize);
+        }
+        else
+        {
+            GDALCopyWords(pabySrc, psJob->eDataType, psJob->nPixelOffset,
+                          pabyDst, psJob->eDataType, nPixelSpace,
+                          psJob->nXSize);
+        }
+
+        if( psJob->bSwap )
+        {
+            if( GDALDataTypeIsComplex(psJob->eDataType) )
+            {
+                const int nWordSize = nDTSize / 2;
+                GDALSwapWords(pabyDst, nWordSize, psJob->nXSize,
+                              nPixelSpace);
+                GDALSwapWords(pabyDst + nWordSize, nWordSize, psJob->nXSize,
+                              nPixelSpace);
+            }
+            else
+            {
+                GDALSwapWords(pabyDst, nDTSize, psJob->nXSize, nPixelSpace);
+            }
+        }
+    }
+}
+
+CPLErr RawRasterBand::VirtualMemIO( int nXOff, int nYOff,
+                                    int nXSize, int nYSize,
+                                    void *pData, GDALDataType eBufType,
+                                    GSpacing nPixelSpace, GSpacing nLineSpace,
+                                    GDALRasterIOExtraArg* /* psExtraArg */ )
+{
+    CPLAssert(psVirtualMemIOMapping != nullptr);
+    CPLAssert(eBufType == eDataType);
+
+    const int nDTSize = GDALGetDataTypeSizeBytes(eBufType);
+
+    RawVirtualMemIOJob sJob;
+    sJob.pabySrc =
+        static_cast<const GByte *>(
+            CPLVirtualMemGetAddr(psVirtualMemIOMapping)) +
+        static_cast<size_t>(nYOff) * nLineOffset +
+        static_cast<size_t>(nXOff) * nPixelOffset;
+    sJob.pabyDst = static_cast<GByte *>(pData);
+    sJob.nLines = nYSize;
+    sJob.nXSize = nXSize;
+    sJob.eDataType = eDataType;
+    sJob.nPixelOffset = nPixelOffset;
+    sJob.nLineOffset = nLineOffset;
+    sJob.nPixelSpace = nPixelSpace;
+    sJob.nLineSpace = nLineSpace;
+    sJob.bSwap = !bNativeOrder && eDataType != GDT_Byte;
+
+    // Large requests are split in bands of lines copied in parallel, as
+    // page faults on a cold file cache then overlap.
+    int nThreads = 1;
+    const char *pszThreads = CPLGetConfigOption("GDAL_NUM_THREADS", nullptr);
+    if( pszThreads )
+    {
+        nThreads = EQUAL(pszThreads, "ALL_CPUS") ? CPLGetNumCPUs()
+                                                 : atoi(pszThreads);
+    }
+    const GIntBig nBytes = static_cast<GIntBig>(nXSize) * nYSize * nDTSize;
+    const GIntBig nMinBytesPerThread = 8 * 1024 * 1024;
+    nThreads = static_cast<int>(std::min(
+        static_cast<GIntBig>(std::min(nThreads, nYSize)),
+        nBytes / nMinBytesPerThread));
+
+    // The pool belongs to the dataset, that RawRasterBand objects of other
+    // drivers (VRT raw bands for instance) do not have.
+    RawDataset *poRawDS = dynamic_cast<RawDataset *>(poDS);
+    CPLWorkerThreadPool *poPool =
+        nThreads > 1 && poRawDS != nullptr ?
+            poRawDS->GetVirtualMemIOThreadPool(nThreads) : nullptr;
+    if( poPool != nullptr )
+    {
+        CPLDebug("RAW", "Using VirtualMemIO with %d threads", nThreads);
+        std::vector<RawVirtualMemIOJob> asJobs(nThreads, sJob);
+        std::vector<void *> apJobs;
+        for( int i = 0; i < nThreads; i++ )
+        {
+            const int nStartLine =
+                static_cast<int>(static_cast<GIntBig>(nYSize) * i / nThreads);
+            const int nEndLine = static_cast<int>(
+                static_cast<GIntBig>(nYSize) * (i + 1) / nThreads);
+            asJobs[i].pabySrc +=
+                static_cast<size_t>(nStartLine) * nLineOffset;
+            asJobs[i].pabyDst += nStartLine * nLineSpace;
+            asJobs[i].nLines = nEndLine - nStartLine;
+            apJobs.push_back(&asJobs[i]);
+        }
+        poPool->SubmitJobs(RawVirtualMemIOCopyLines, apJobs);
+        poPool->WaitCompletion();
+    }
+    else
+    {
+        CPLDebug("RAW", "Using VirtualMemIO");
+        RawVirtualMemIOCopyLines(&sJob);
+    }
+
+    return CE_None;
+}
+
 /************************************************************************/
 /*                             IRasterIO()                              */
 /************************************************************************/
@@ -595,6 +804,15 @@ CPLErr RawRasterBand::IRasterIO( GDALRWFlag eRWFlag,
 #endif
     const int nBufDataSize = GDALGetDataTypeSizeBytes(eBufType);
 
+    if( (psExtraArg->pfnProgress == nullptr ||
+         psExtraArg->pfnProgress == GDALDummyProgress) &&
+        CanUseVirtualMemIO(eRWFlag, nXSize, nYSize, nBufXSize, nBufYSize,
+                           eBufType) )
+    {
+        return VirtualMemIO(nXOff, nYOff, nXSize, nYSize, pData, eBufType,
+                            nPixelSpace, nLineSpace, psExtraArg);
+    }
+
     if( !CanUseDirectIO(nXOff, nYOff, nXSize, nYSize, eBufType) )
     {
         return GDALRasterBand::IRasterIO(eRWFlag, nXOff, nYOff,
@@ -1089,8 +1307,37 @@ RawDataset::RawDataset() {}
 /*                           ~RawDataset()                              */
 /************************************************************************/
 
-// It's pure virtual function but must be defined, even if empty.
-RawDataset::~RawDataset() {}
+// It's pure virtual function but must be defined.
+RawDataset::~RawDataset()
+{
+    delete m_poVirtualMemIOThreadPool;
+}
+
+/************************************************************************/
+/*                     GetVirtualMemIOThreadPool()                      */
+/************************************************************************/
+
+// Created on first use, and kept for the next requests, so that worker
+// threads are not started for each of them.
+CPLWorkerThreadPool *RawDataset::GetVirtualMemIOThreadPool( int nThreads )
+{
+    if( m_poVirtualMemIOThreadPool != nullptr &&
+        m_poVirtualMemIOThreadPool->GetThreadCount() != nThreads )
+    {
+        delete m_poVirtualMemIOThreadPool;
+        m_poVirtualMemIOThreadPool = nullptr;
+    }
+    if( m_poVirtualMemIOThreadPool == nullptr )
+    {
+        m_poVirtualMemIOThreadPool = new CPLWorkerThreadPool();
+        if( !m_poVirtualMemIOThreadPool->Setup(nThreads, nullptr, nullptr) )
+        {
+            delete m_poVirtualMemIOThreadPool;
+            m_poVirtualMemIOThreadPool = nullptr;
+        }
+    }
+    return m_poVirtualMemIOThreadPool;
+}
 
 /************************************************************************/
 /*                             IRasterIO()                              */
@@ -1110,6 +1357,49 @@ CPLErr RawDataset::IRasterIO( GDALRWFlag eRWFlag,
 {
     const char* pszInterleave = nullptr;
 
+    // Read all bands straight from the memory mapping of the file if
+    // possible, instead of going through the block cache.  Only done for
+    // plain RawRasterBand objects: driver specific subclasses may override
+    // IRasterIO() / IReadBlock() (e.g. to apply a scaling or a no-data
+    // remapping), and this path would silently bypass them.
+    if( nBandCount > 1 &&
+        (psExtraArg->pfnProgress == nullptr ||
+         psExtraArg->pfnProgress == GDALDummyProgress) )
+    {
+        int iBandIndex = 0;
+        for( ; iBandIndex < nBandCount; iBandIndex++ )
+        {
+            GDALRasterBand *poGDALBand = GetRasterBand(panBandMap[iBandIndex]);
+            if( poGDALBand == nullptr ||
+                typeid(*poGDALBand) != typeid(RawRasterBand) )
+            {
+                break;
+            }
+            RawRasterBand *poBand =
+                cpl::down_cast<RawRasterBand *>(poGDALBand);
+            if( !poBand->CanUseVirtualMemIO(eRWFlag, nXSize, nYSize,
+                                            nBufXSize, nBufYSize, eBufType) )
+            {
+                break;
+            }
+        }
+        if( iBandIndex == nBandCount )
+        {
+            for( iBandIndex = 0; iBandIndex < nBandCount; iBandIndex++ )
+            {
+                RawRasterBand *poBand = cpl::down_cast<RawRasterBand *>(
+                    GetRasterBand(panBandMap[iBandIndex]));
+                const CPLErr eErr = poBand->VirtualMemIO(
+                    nXOff, nYOff, nXSize, nYSize,
+                    static_cast<GByte *>(pData) + iBandIndex * nBandSpace,
+                    eBufType, nPixelSpace, nLineSpace, psExtraArg);
+                if( eErr != CE_None )
+                    return eErr;
+            }
+            return CE_None;
+        }
+    }
+
     // The default GDALDataset::IRasterIO() implementation would go to
     // BlockBasedRasterIO if the dataset is interleaved. However if the
     // access pattern is compatible with DirectIO() we don't want to go
@@ -40,6 +40,7 @@
 /* ==================================================================== */
 /************************************************************************/
 
+class CPLWorkerThreadPool;
 class RawRasterBand;
 
 /**
@@ -61,6 +62,11 @@ class CPL_DLL RawDataset : public GDALPamDataset
          virtual ~RawDataset() = 0;
 
   private:
+    // Worker threads copying the lines of RawRasterBand::VirtualMemIO()
+    CPLWorkerThreadPool *m_poVirtualMemIOThreadPool = nullptr;
+
+    CPLWorkerThreadPool *GetVirtualMemIOThreadPool( int nThreads );
+
     CPL_DISALLOW_COPY_ASSIGN(RawDataset)
 };
 
@@ -100,6 +106,9 @@ protected:
 
     int         bOwnsFP{};
 
+    CPLVirtualMem *psVirtualMemIOMapping{};
+    int         bVirtualMemIOAvailable = -1;
+
     int         Seek( vsi_l_offset, int );
     size_t      Read( void *, size_t, size_t );
     size_t      Write( void *, size_t, size_t );
@@ -117,6 +126,15 @@ protected:
     int         CanUseDirectIO(int nXOff, int nYOff, int nXSize, int nYSize,
                                GDALDataType eBufType);
 
+    int         CanUseVirtualMemIO(GDALRWFlag eRWFlag,
+                                   int nXSize, int nYSize,
+                                   int nBufXSize, int nBufYSize,
+                                   GDALDataType eBufType);
+    CPLErr      VirtualMemIO(int nXOff, int nYOff, int nXSize, int nYSize,
+                             void *pData, GDALDataType eBufType,
+                             GSpacing nPixelSpace, GSpacing nLineSpace,
+                             GDALRasterIOExtraArg* psExtraArg);
+
 public:
 
     enum class OwnFP
@@ -1046,6 +1046,11 @@ CPLErr VRTDataset::AddBand( GDALDataType eType, char **papszOptions )
             if( pszLanguage != nullptr )
                 poDerivedBand->SetPixelFunctionLanguage(pszLanguage);
 
+            const char* pszCode =
+                CSLFetchNameValue(papszOptions, "PixelFunctionCode");
+            if( pszCode != nullptr )
+                poDerivedBand->SetPixelFunctionCode(pszCode);
+
             const char* pszTransferTypeName =
                 CSLFetchNameValue(papszOptions, "SourceTransferType");
             if( pszTransferTypeName != nullptr )
@@ -1623,15 +1628,18 @@ CPLErr VRTDataset::IRasterIO( GDALRWFlag eRWFlag,
         // they don't necessary instantiate all underlying rasterbands.
         VRTSourcedRasterBand* poBand = reinterpret_cast<VRTSourcedRasterBand *>(
             papoBands[nBands - 1] );
-        for( int iSource = 0;
-             eErr == CE_None && iSource < poBand->nSources;
-             iSource++ )
+        std::vector<int> anSources;
+        poBand->GetIntersectingSources(nXOff, nYOff, nXSize, nYSize,
+                                       anSources);
+        const int nIntersectingSources = static_cast<int>(anSources.size());
+        for( int i = 0; eErr == CE_None && i < nIntersectingSources; i++ )
         {
+            const int iSource = anSources[i];
             psExtraArg->pfnProgress = GDALScaledProgress;
             psExtraArg->pProgressData =
                 GDALCreateScaledProgress(
-                    1.0 * iSource / poBand->nSources,
-                    1.0 * (iSource + 1) / poBand->nSources,
+                    1.0 * i / nIntersectingSources,
+                    1.0 * (i + 1) / nIntersectingSources,
                     pfnProgressGlobal,
                     pProgressDataGlobal );
 
@@ -34,6 +34,7 @@
 #ifndef DOXYGEN_SKIP
 
 #include "cpl_hash_set.h"
+#include "cpl_quad_tree.h"
 #include "gdal_pam.h"
 #include "gdal_priv.h"
 #include "gdal_rat.h"
@@ -47,6 +48,7 @@
 int VRTApplyMetadata( CPLXMLNode *, GDALMajorObject * );
 CPLXMLNode *VRTSerializeMetadata( GDALMajorObject * );
 CPLErr GDALRegisterDefaultPixelFunc();
+void VRTDestroySourceThreadPools();
 
 #if 0
 int VRTWarpedOverviewTransform( void *pTransformArg, int bDstToSrc,
@@ -535,8 +537,24 @@ class CPL_DLL VRTSourcedRasterBand : public VRTRasterBand
     CPLString      m_osLastLocationInfo;
     char         **m_papszSourceList;
 
+    // Spatial index of the destination windows of the sources, built on
+    // first use when there are many sources.
+    CPLQuadTree   *m_hSourceIndex = nullptr;
+    int            m_nIndexedSources = 0;
+    std::vector<int> m_anSourceIdx{};
+    std::vector<int> m_anSourcesNotIndexed{};
+
     bool           CanUseSourcesMinMaxImplementations();
     void           CheckSource( VRTSimpleSource *poSS );
+    void           BuildSourceIndex();
+    void           InvalidateSourceIndex();
+    CPLErr         CompositeSourcesMultiThreaded(
+                            int nThreads, const std::vector<int>& anSources,
+                            int nXOff, int nYOff, int nXSize, int nYSize,
+                            void *pData, int nBufXSize, int nBufYSize,
+                            GDALDataType eBufType,
+                            GSpacing nPixelSpace, GSpacing nLineSpace,
+                            GDALRasterIOExtraArg* psExtraArg );
 
     CPL_DISALLOW_COPY_ASSIGN(VRTSourcedRasterBand)
 
@@ -590,6 +608,10 @@ class CPL_DLL VRTSourcedRasterBand : public VRTRasterBand
                                   GDALProgressFunc pfnProgress,
                                   void *pProgressData ) override;
 
+    void           GetIntersectingSources( int nXOff, int nYOff,
+                                           int nXSize, int nYSize,
+                                           std::vector<int>& anSources );
+
     CPLErr         AddSource( VRTSource * );
     CPLErr         AddSimpleSource( GDALRasterBand *poSrcBand,
                                     double dfSrcXOff=-1, double dfSrcYOff=-1,
@@ -704,6 +726,7 @@ class CPL_DLL VRTDerivedRasterBand : public VRTSourcedRasterBand
 {
     VRTDerivedRasterBandPrivateData* m_poPrivate;
     bool InitializePython();
+    bool InitializeExpression();
 
     CPL_DISALLOW_COPY_ASSIGN(VRTDerivedRasterBand)
 
@@ -733,6 +756,7 @@ class CPL_DLL VRTDerivedRasterBand : public VRTSourcedRasterBand
     void SetPixelFunctionName( const char *pszFuncName );
     void SetSourceTransferType( GDALDataType eDataType );
     void SetPixelFunctionLanguage( const char* pszLanguage );
+    void SetPixelFunctionCode( const char* pszCode );
 
     virtual CPLErr         XMLInit( CPLXMLNode *, const char *, void* ) override;
     virtual CPLXMLNode *   SerializeToXML( const char *pszVRTPath ) override;
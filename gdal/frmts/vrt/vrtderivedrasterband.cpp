@@ -31,6 +31,7 @@
 #include "cpl_minixml.h"
 #include "cpl_string.h"
 #include "vrtdataset.h"
+#include "vrtexpression.h"
 #include "cpl_multiproc.h"
 #include "cpl_spawn.h"
 
@@ -43,7 +44,9 @@
 #endif
 
 #include <algorithm>
+#include <limits>
 #include <map>
+#include <memory>
 #include <vector>
 #include <utility>
 
@@ -858,6 +861,7 @@ class VRTDerivedRasterBandPrivateData
         bool      m_bExclusiveLock;
         bool      m_bFirstTime;
         std::vector< std::pair<CPLString,CPLString> > m_oFunctionArgs;
+        std::unique_ptr<VRTExpression> m_poExpression;
 
         VRTDerivedRasterBandPrivateData():
             m_osLanguage("C"),
@@ -1106,13 +1110,32 @@ void VRTDerivedRasterBand::SetPixelFunctionName( const char *pszFuncNameIn )
 /**
  * Set the language of the pixel function.
  *
- * @param pszLanguage Language of the pixel function (only "C" and "Python"
- * are supported currently)
+ * @param pszLanguage Language of the pixel function ("C", "Python" or
+ * "Expression")
  * @since GDAL 2.3
  */
 void VRTDerivedRasterBand::SetPixelFunctionLanguage( const char* pszLanguage )
 {
     m_poPrivate->m_osLanguage = pszLanguage;
+    m_poPrivate->m_poExpression.reset();
+}
+
+/************************************************************************/
+/*                         SetPixelFunctionCode()                       */
+/************************************************************************/
+
+/**
+ * Set the code of the pixel function: the source of the Python module
+ * for the "Python" language, or the band math expression, such as
+ * "(B2-B1)/(B2+B1)", for the "Expression" language.
+ *
+ * @param pszCode Code of the pixel function.
+ * @since GDAL 2.4
+ */
+void VRTDerivedRasterBand::SetPixelFunctionCode( const char* pszCode )
+{
+    m_poPrivate->m_osCode = pszCode ? pszCode : "";
+    m_poPrivate->m_poExpression.reset();
 }
 
 /************************************************************************/
@@ -1479,6 +1502,26 @@ bool VRTDerivedRasterBand::InitializePython()
     return true;
 }
 
+/************************************************************************/
+/*                        InitializeExpression()                        */
+/************************************************************************/
+
+bool VRTDerivedRasterBand::InitializeExpression()
+{
+    if( m_poPrivate->m_poExpression == nullptr )
+    {
+        if( m_poPrivate->m_osCode.empty() )
+        {
+            CPLError(CE_Failure, CPLE_AppDefined,
+                     "PixelFunctionCode missing for Expression language");
+            return false;
+        }
+        m_poPrivate->m_poExpression =
+            VRTExpression::Compile(m_poPrivate->m_osCode);
+    }
+    return m_poPrivate->m_poExpression != nullptr;
+}
+
 /************************************************************************/
 /*                             IRasterIO()                              */
 /************************************************************************/
@@ -1551,11 +1594,16 @@ CPLErr VRTDerivedRasterBand::IRasterIO( GDALRWFlag eRWFlag,
         return CE_Failure;
     }
 
+    const bool bExpression =
+                        EQUAL(m_poPrivate->m_osLanguage, "Expression");
     const int nBufTypeSize = GDALGetDataTypeSizeBytes(eBufType);
     GDALDataType eSrcType = eSourceTransferType;
     if( eSrcType == GDT_Unknown || eSrcType >= GDT_TypeCount ) {
         eSrcType = eBufType;
     }
+    // Expressions are always evaluated on Float64 values
+    if( bExpression )
+        eSrcType = GDT_Float64;
     const int nSrcTypeSize = GDALGetDataTypeSizeBytes(eSrcType);
 
 /* -------------------------------------------------------------------- */
@@ -1613,6 +1661,21 @@ CPLErr VRTDerivedRasterBand::IRasterIO( GDALRWFlag eRWFlag,
             return CE_Failure;
         }
     }
+    else if( bExpression )
+    {
+        if( !InitializeExpression() )
+            return CE_Failure;
+        if( m_poPrivate->m_poExpression->GetVariableCount() > nSources )
+        {
+            CPLError( CE_Failure, CPLE_AppDefined,
+                      "Expression '%s' refers to B%d, but there are only "
+                      "%d source(s)",
+                      m_poPrivate->m_osCode.c_str(),
+                      m_poPrivate->m_poExpression->GetVariableCount(),
+                      nSources );
+            return CE_Failure;
+        }
+    }
 
     /* TODO: It would be nice to use a MallocBlock function for each
        individual buffer that would recycle blocks of memory from a
@@ -1941,6 +2004,56 @@ CPLErr VRTDerivedRasterBand::IRasterIO( GDALRWFlag eRWFlag,
             VSIFree(pabyTmpBuffer);
         }
     }
+    else if( eErr == CE_None && bExpression )
+    {
+        // Pixels at the nodata value, either read as such or left
+        // untouched by the sources, are nodata for the expression.
+        const size_t nValues = static_cast<size_t>(nBufXSize) * nBufYSize;
+        const double dfNaN = std::numeric_limits<double>::quiet_NaN();
+        std::vector<const double*> apdfInputs(nSources);
+        for( int iSource = 0; iSource < nSources; iSource++ )
+        {
+            double* padfBuffer = static_cast<double*>(pBuffers[iSource]);
+            if( m_bNoDataValueSet && !CPLIsNan(m_dfNoDataValue) )
+            {
+                for( size_t i = 0; i < nValues; i++ )
+                {
+                    if( padfBuffer[i] == m_dfNoDataValue )
+                        padfBuffer[i] = dfNaN;
+                }
+            }
+            apdfInputs[iSource] = padfBuffer;
+        }
+
+        double* padfResult = static_cast<double*>(
+            VSI_MALLOC2_VERBOSE(nValues, sizeof(double)));
+        if( padfResult == nullptr )
+        {
+            eErr = CE_Failure;
+        }
+        else
+        {
+            m_poPrivate->m_poExpression->Evaluate(apdfInputs.data(), nValues,
+                                                  padfResult);
+            if( m_bNoDataValueSet && !CPLIsNan(m_dfNoDataValue) )
+            {
+                for( size_t i = 0; i < nValues; i++ )
+                {
+                    if( CPLIsNan(padfResult[i]) )
+                        padfResult[i] = m_dfNoDataValue;
+                }
+            }
+            for( int iY = 0; iY < nBufYSize; iY++ )
+            {
+                GDALCopyWords(padfResult + static_cast<size_t>(iY) * nBufXSize,
+                              GDT_Float64, sizeof(double),
+                              static_cast<GByte*>(pData) + iY * nLineSpace,
+                              eBufType, static_cast<int>(nPixelSpace),
+                              nBufXSize);
+            }
+            VSIFree(padfResult);
+        }
+    }
     else if( eErr == CE_None && pfnPixelFunc != nullptr ) {
         eErr = pfnPixelFunc( reinterpret_cast<void **>( pBuffers ), nSources,
                              pData, nBufXSize, nBufYSize,
@@ -1987,34 +2100,42 @@ CPLErr VRTDerivedRasterBand::XMLInit( CPLXMLNode *psTree,
     if( eErr != CE_None )
         return eErr;
 
-    // Read derived pixel function type.
-    SetPixelFunctionName( CPLGetXMLValue( psTree, "PixelFunctionType", nullptr ) );
-    if( pszFuncName == nullptr || EQUAL(pszFuncName, "") )
-    {
-        CPLError(CE_Failure, CPLE_AppDefined,
-                 "PixelFunctionType missing");
-        return CE_Failure;
-    }
-
     m_poPrivate->m_osLanguage = CPLGetXMLValue( psTree,
                                                 "PixelFunctionLanguage", "C" );
     if( !EQUAL(m_poPrivate->m_osLanguage, "C") &&
-        !EQUAL(m_poPrivate->m_osLanguage, "Python") )
+        !EQUAL(m_poPrivate->m_osLanguage, "Python") &&
+        !EQUAL(m_poPrivate->m_osLanguage, "Expression") )
     {
         CPLError(CE_Failure, CPLE_NotSupported,
                  "Unsupported PixelFunctionLanguage");
         return CE_Failure;
     }
+    const bool bExpression =
+                        EQUAL(m_poPrivate->m_osLanguage, "Expression");
+
+    // Read derived pixel function type. Not needed for expressions.
+    SetPixelFunctionName( CPLGetXMLValue( psTree, "PixelFunctionType", nullptr ) );
+    if( (pszFuncName == nullptr || EQUAL(pszFuncName, "")) && !bExpression )
+    {
+        CPLError(CE_Failure, CPLE_AppDefined,
+                 "PixelFunctionType missing");
+        return CE_Failure;
+    }
 
     m_poPrivate->m_osCode =
                         CPLGetXMLValue( psTree, "PixelFunctionCode", "" );
+    m_poPrivate->m_poExpression.reset();
     if( !m_poPrivate->m_osCode.empty() &&
-        !EQUAL(m_poPrivate->m_osLanguage, "Python") )
+        !EQUAL(m_poPrivate->m_osLanguage, "Python") && !bExpression )
     {
         CPLError(CE_Failure, CPLE_NotSupported,
-                 "PixelFunctionCode can only be used with Python");
+                 "PixelFunctionCode can only be used with Python or "
+                 "Expression");
         return CE_Failure;
     }
+    // Report syntax errors when opening the dataset
+    if( bExpression && !InitializeExpression() )
+        return CE_Failure;
 
     m_poPrivate->m_nBufferRadius =
                         atoi(CPLGetXMLValue( psTree, "BufferRadius", "0" ));
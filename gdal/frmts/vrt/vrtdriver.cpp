@@ -363,6 +363,15 @@ VRTCreateCopy( const char * pszFilename,
     return poVRTDS;
 }
 
+/************************************************************************/
+/*                          VRTDriverUnload()                           */
+/************************************************************************/
+
+static void VRTDriverUnload( GDALDriver* )
+{
+    VRTDestroySourceThreadPools();
+}
+
 /************************************************************************/
 /*                          GDALRegister_VRT()                          */
 /************************************************************************/
@@ -392,6 +401,7 @@ void GDALRegister_VRT()
     poDriver->pfnCreate = VRTDataset::Create;
     poDriver->pfnIdentify = VRTDataset::Identify;
     poDriver->pfnDelete = VRTDataset::Delete;
+    poDriver->pfnUnloadDriver = VRTDriverUnload;
 
     poDriver->SetMetadataItem( GDAL_DMD_OPENOPTIONLIST,
 "<OptionList>"
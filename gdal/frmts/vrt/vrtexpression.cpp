@@ -0,0 +1,789 @@
+/******************************************************************************
+ *
+ * Project:  Virtual GDAL Datasets
+ * Purpose:  Band math expressions for VRTDerivedRasterBand
+ *
+ ******************************************************************************
+ * Copyright (c) 2018, GDAL contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ ****************************************************************************/
+
+#include "vrtexpression.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+#include "cpl_conv.h"
+#include "cpl_error.h"
+#include "cpl_string.h"
+
+CPL_CVSID("$Id$")
+
+/*! @cond Doxygen_Suppress */
+
+// Number of values processed by each instruction at a time. Small enough
+// for the intermediate results of a whole program to stay in the L1/L2 cache,
+// large enough to amortize the dispatch on the opcode.
+constexpr size_t VRT_EXPR_CHUNK_SIZE = 256;
+
+// Protects against stack overflows on pathological expressions.
+constexpr int VRT_EXPR_MAX_RECURSION = 128;
+
+/************************************************************************/
+/*                              GetArity()                              */
+/************************************************************************/
+
+static int GetArity( VRTExpression::Op eOp )
+{
+    typedef VRTExpression::Op Op;
+    switch( eOp )
+    {
+        case Op::CONSTANT:
+        case Op::VARIABLE:
+            return 0;
+        case Op::NEG: case Op::NOT: case Op::ISNODATA:
+        case Op::ABS: case Op::SQRT: case Op::EXP: case Op::LOG:
+        case Op::LOG10: case Op::SIN: case Op::COS: case Op::TAN:
+        case Op::ASIN: case Op::ACOS: case Op::ATAN:
+        case Op::FLOOR: case Op::CEIL: case Op::ROUND:
+            return 1;
+        case Op::COND:
+            return 3;
+        default:
+            break;
+    }
+    return 2;
+}
+
+/************************************************************************/
+/* ==================================================================== */
+/*                          VRTExpressionParser                         */
+/* ==================================================================== */
+/************************************************************************/
+
+// Recursive descent parser emitting the program in postfix order.
+// Grammar, from lowest to highest precedence:
+//   cond     := or [ '?' cond ':' cond ]
+//   or       := and { '||' and }
+//   and      := equality { '&&' equality }
+//   equality := relation { ('=='|'!=') relation }
+//   relation := additive { ('<'|'<='|'>'|'>=') additive }
+//   additive := term { ('+'|'-') term }
+//   term     := unary { ('*'|'/'|'%') unary }
+//   unary    := ('-'|'+'|'!') unary | power
+//   power    := primary [ '^' unary ]
+//   primary  := number | Bn | constant | function '(' args ')' | '(' cond ')'
+
+class VRTExpressionParser
+{
+    const char*    m_pszExpression;
+    const char*    m_pszCur;
+    VRTExpression* m_poExpr;
+    int            m_nStackDepth = 0;
+    int            m_nRecursion = 0;
+
+    void SkipSpaces();
+    bool Accept( const char* pszToken );
+    bool Error( const char* pszMsg );
+
+    void EmitConstant( double dfValue );
+    void EmitVariable( int nIndex );
+    void Emit( VRTExpression::Op eOp );
+
+    bool ParseConditional();
+    bool ParseOr();
+    bool ParseAnd();
+    bool ParseEquality();
+    bool ParseRelation();
+    bool ParseAdditive();
+    bool ParseTerm();
+    bool ParseUnary();
+    bool ParsePower();
+    bool ParsePrimary();
+    bool ParseFunction( const CPLString& osName );
+
+    CPL_DISALLOW_COPY_ASSIGN(VRTExpressionParser)
+
+  public:
+    VRTExpressionParser( const char* pszExpression, VRTExpression* poExpr ) :
+        m_pszExpression(pszExpression), m_pszCur(pszExpression),
+        m_poExpr(poExpr) {}
+
+    bool Parse();
+};
+
+/************************************************************************/
+/*                             SkipSpaces()                             */
+/************************************************************************/
+
+void VRTExpressionParser::SkipSpaces()
+{
+    while( isspace(static_cast<unsigned char>(*m_pszCur)) )
+        m_pszCur++;
+}
+
+/************************************************************************/
+/*                               Accept()                               */
+/************************************************************************/
+
+bool VRTExpressionParser::Accept( const char* pszToken )
+{
+    SkipSpaces();
+    const size_t nLen = strlen(pszToken);
+    if( strncmp(m_pszCur, pszToken, nLen) != 0 )
+        return false;
+    m_pszCur += nLen;
+    return true;
+}
+
+/************************************************************************/
+/*                               Error()                                */
+/************************************************************************/
+
+bool VRTExpressionParser::Error( const char* pszMsg )
+{
+    CPLError(CE_Failure, CPLE_AppDefined,
+             "Invalid expression '%s' at offset %d: %s",
+             m_pszExpression,
+             static_cast<int>(m_pszCur - m_pszExpression), pszMsg);
+    return false;
+}
+
+/************************************************************************/
+/*                            EmitConstant()                            */
+/************************************************************************/
+
+void VRTExpressionParser::EmitConstant( double dfValue )
+{
+    VRTExpression::Instruction sInstr;
+    sInstr.eOp = VRTExpression::Op::CONSTANT;
+    sInstr.dfValue = dfValue;
+    sInstr.nIndex = 0;
+    m_poExpr->m_aoProgram.push_back(sInstr);
+    m_nStackDepth++;
+    m_poExpr->m_nMaxStackDepth =
+        std::max(m_poExpr->m_nMaxStackDepth, m_nStackDepth);
+}
+
+/************************************************************************/
+/*                            EmitVariable()                            */
+/************************************************************************/
+
+void VRTExpressionParser::EmitVariable( int nIndex )
+{
+    VRTExpression::Instruction sInstr;
+    sInstr.eOp = VRTExpression::Op::VARIABLE;
+    sInstr.dfValue = 0.0;
+    sInstr.nIndex = nIndex;
+    m_poExpr->m_aoProgram.push_back(sInstr);
+    m_poExpr->m_nVariableCount =
+        std::max(m_poExpr->m_nVariableCount, nIndex + 1);
+    m_nStackDepth++;
+    m_poExpr->m_nMaxStackDepth =
+        std::max(m_poExpr->m_nMaxStackDepth, m_nStackDepth);
+}
+
+/************************************************************************/
+/*                                Emit()                                */
+/*                                                                      */
+/*      Emit an operator, or fold it when all its operands are          */
+/*      constants. By induction a constant operand is always a          */
+/*      single CONSTANT instruction, so it is enough to look at the     */
+/*      last instructions of the program.                               */
+/************************************************************************/
+
+void VRTExpressionParser::Emit( VRTExpression::Op eOp )
+{
+    auto& aoProgram = m_poExpr->m_aoProgram;
+    const int nArity = GetArity(eOp);
+    const size_t nFirst = aoProgram.size() - nArity;
+    bool bAllConstant = true;
+    for( size_t i = nFirst; i < aoProgram.size(); i++ )
+    {
+        if( aoProgram[i].eOp != VRTExpression::Op::CONSTANT )
+            bAllConstant = false;
+    }
+
+    VRTExpression::Instruction sInstr;
+    sInstr.eOp = eOp;
+    sInstr.dfValue = 0.0;
+    sInstr.nIndex = 0;
+    if( bAllConstant )
+    {
+        double adfArgs[3] = { 0.0, 0.0, 0.0 };
+        const double* apdfArgs[3] = { &adfArgs[0], &adfArgs[1], &adfArgs[2] };
+        for( int i = 0; i < nArity; i++ )
+            adfArgs[i] = aoProgram[nFirst + i].dfValue;
+        double dfResult = 0.0;
+        VRTExpression::RunInstruction(sInstr, apdfArgs, 1, &dfResult);
+        aoProgram.resize(nFirst);
+        sInstr.eOp = VRTExpression::Op::CONSTANT;
+        sInstr.dfValue = dfResult;
+    }
+    aoProgram.push_back(sInstr);
+    m_nStackDepth -= nArity - 1;
+}
+
+/************************************************************************/
+/*                               Parse()                                */
+/************************************************************************/
+
+bool VRTExpressionParser::Parse()
+{
+    if( !ParseConditional() )
+        return false;
+    SkipSpaces();
+    if( *m_pszCur != '\0' )
+        return Error("unexpected character");
+    return true;
+}
+
+/************************************************************************/
+/*                          ParseConditional()                          */
+/************************************************************************/
+
+bool VRTExpressionParser::ParseConditional()
+{
+    if( ++m_nRecursion > VRT_EXPR_MAX_RECURSION )
+        return Error("expression too deeply nested");
+
+    bool bRet = ParseOr();
+    if( bRet && Accept("?") )
+    {
+        bRet = ParseConditional();
+        if( bRet && !Accept(":") )
+            bRet = Error("':' expected");
+        if( bRet )
+            bRet = ParseConditional();
+        if( bRet )
+            Emit(VRTExpression::Op::COND);
+    }
+    m_nRecursion--;
+    return bRet;
+}
+
+/************************************************************************/
+/*                              ParseOr()                               */
+/************************************************************************/
+
+bool VRTExpressionParser::ParseOr()
+{
+    if( !ParseAnd() )
+        return false;
+    while( Accept("||") )
+    {
+        if( !ParseAnd() )
+            return false;
+        Emit(VRTExpression::Op::OR);
+    }
+    return true;
+}
+
+/************************************************************************/
+/*                              ParseAnd()                              */
+/************************************************************************/
+
+bool VRTExpressionParser::ParseAnd()
+{
+    if( !ParseEquality() )
+        return false;
+    while( Accept("&&") )
+    {
+        if( !ParseEquality() )
+            return false;
+        Emit(VRTExpression::Op::AND);
+    }
+    return true;
+}
+
+/************************************************************************/
+/*                           ParseEquality()                            */
+/************************************************************************/
+
+bool VRTExpressionParser::ParseEquality()
+{
+    if( !ParseRelation() )
+        return false;
+    while( true )
+    {
+        VRTExpression::Op eOp;
+        if( Accept("==") )
+            eOp = VRTExpression::Op::EQ;
+        else if( Accept("!=") )
+            eOp = VRTExpression::Op::NE;
+        else
+            return true;
+        if( !ParseRelation() )
+            return false;
+        Emit(eOp);
+    }
+}
+
+/************************************************************************/
+/*                           ParseRelation()                            */
+/************************************************************************/
+
+bool VRTExpressionParser::ParseRelation()
+{
+    if( !ParseAdditive() )
+        return false;
+    while( true )
+    {
+        VRTExpression::Op eOp;
+        if( Accept("<=") )
+            eOp = VRTExpression::Op::LE;
+        else if( Accept(">=") )
+            eOp = VRTExpression::Op::GE;
+        else if( Accept("<") )
+            eOp = VRTExpression::Op::LT;
+        else if( Accept(">") )
+            eOp = VRTExpression::Op::GT;
+        else
+            return true;
+        if( !ParseAdditive() )
+            return false;
+        Emit(eOp);
+    }
+}
+
+/************************************************************************/
+/*                           ParseAdditive()                            */
+/************************************************************************/
+
+bool VRTExpressionParser::ParseAdditive()
+{
+    if( !ParseTerm() )
+        return false;
+    while( true )
+    {
+        VRTExpression::Op eOp;
+        if( Accept("+") )
+            eOp = VRTExpression::Op::ADD;
+        else if( Accept("-") )
+            eOp = VRTExpression::Op::SUB;
+        else
+            return true;
+        if( !ParseTerm() )
+            return false;
+        Emit(eOp);
+    }
+}
+
+/************************************************************************/
+/*                             ParseTerm()                              */
+/************************************************************************/
+
+bool VRTExpressionParser::ParseTerm()
+{
+    if( !ParseUnary() )
+        return false;
+    while( true )
+    {
+        VRTExpression::Op eOp;
+        if( Accept("*") )
+            eOp = VRTExpression::Op::MUL;
+        else if( Accept("/") )
+            eOp = VRTExpression::Op::DIV;
+        else if( Accept("%") )
+            eOp = VRTExpression::Op::MOD;
+        else
+            return true;
+        if( !ParseUnary() )
+            return false;
+        Emit(eOp);
+    }
+}
+
+/************************************************************************/
+/*                             ParseUnary()                             */
+/************************************************************************/
+
+bool VRTExpressionParser::ParseUnary()
+{
+    if( ++m_nRecursion > VRT_EXPR_MAX_RECURSION )
+        return Error("expression too deeply nested");
+
+    bool bRet;
+    if( Accept("-") )
+    {
+        bRet = ParseUnary();
+        if( bRet )
+            Emit(VRTExpression::Op::NEG);
+    }
+    else if( Accept("+") )
+    {
+        bRet = ParseUnary();
+    }
+    else if( Accept("!") )
+    {
+        bRet = ParseUnary();
+        if( bRet )
+            Emit(VRTExpression::Op::NOT);
+    }
+    else
+    {
+        bRet = ParsePower();
+    }
+    m_nRecursion--;
+    return bRet;
+}
+
+/************************************************************************/
+/*                             ParsePower()                             */
+/************************************************************************/
+
+bool VRTExpressionParser::ParsePower()
+{
+    if( !ParsePrimary() )
+        return false;
+    if( Accept("^") )
+    {
+        // Right associative, and binds tighter than a unary minus on its
+        // left: -2^2 = -4, 2^-1 = 0.5
+        if( !ParseUnary() )
+            return false;
+        Emit(VRTExpression::Op::POW);
+    }
+    return true;
+}
+
+/************************************************************************/
+/*                            ParsePrimary()                            */
+/************************************************************************/
+
+bool VRTExpressionParser::ParsePrimary()
+{
+    SkipSpaces();
+
+    if( Accept("(") )
+    {
+        if( !ParseConditional() )
+            return false;
+        if( !Accept(")") )
+            return Error("')' expected");
+        return true;
+    }
+
+    if( isdigit(static_cast<unsigned char>(*m_pszCur)) || *m_pszCur == '.' )
+    {
+        char* pszEnd = nullptr;
+        const double dfValue = CPLStrtod(m_pszCur, &pszEnd);
+        if( pszEnd == m_pszCur )
+            return Error("invalid number");
+        m_pszCur = pszEnd;
+        EmitConstant(dfValue);
+        return true;
+    }
+
+    if( !isalpha(static_cast<unsigned char>(*m_pszCur)) && *m_pszCur != '_' )
+        return Error(*m_pszCur == '\0' ? "unexpected end of expression" :
+                                         "unexpected character");
+
+    const char* pszStart = m_pszCur;
+    while( isalnum(static_cast<unsigned char>(*m_pszCur)) || *m_pszCur == '_' )
+        m_pszCur++;
+    const CPLString osName(pszStart, m_pszCur - pszStart);
+
+    if( Accept("(") )
+        return ParseFunction(osName);
+
+    if( (osName[0] == 'B' || osName[0] == 'b') && osName.size() > 1 &&
+        osName.size() <= 6 &&
+        strspn(osName.c_str() + 1, "0123456789") == osName.size() - 1 )
+    {
+        const int nBand = atoi(osName.c_str() + 1);
+        if( nBand < 1 )
+            return Error("source numbering starts at B1");
+        EmitVariable(nBand - 1);
+        return true;
+    }
+    if( EQUAL(osName, "pi") )
+    {
+        EmitConstant(M_PI);
+        return true;
+    }
+    if( EQUAL(osName, "e") )
+    {
+        EmitConstant(exp(1.0));
+        return true;
+    }
+    if( EQUAL(osName, "nodata") )
+    {
+        EmitConstant(std::numeric_limits<double>::quiet_NaN());
+        return true;
+    }
+
+    m_pszCur = pszStart;
+    return Error(CPLSPrintf("unknown identifier '%s'", osName.c_str()));
+}
+
+/************************************************************************/
+/*                           ParseFunction()                            */
+/************************************************************************/
+
+bool VRTExpressionParser::ParseFunction( const CPLString& osName )
+{
+    typedef VRTExpression::Op Op;
+    static const struct
+    {
+        const char* pszName;
+        Op          eOp;
+        int         nMinArgs; // -1 for variadic
+    } asFunctions[] = {
+        { "abs", Op::ABS, 1 },
+        { "sqrt", Op::SQRT, 1 },
+        { "exp", Op::EXP, 1 },
+        { "log", Op::LOG, 1 },
+        { "log10", Op::LOG10, 1 },
+        { "sin", Op::SIN, 1 },
+        { "cos", Op::COS, 1 },
+        { "tan", Op::TAN, 1 },
+        { "asin", Op::ASIN, 1 },
+        { "acos", Op::ACOS, 1 },
+        { "atan", Op::ATAN, 1 },
+        { "floor", Op::FLOOR, 1 },
+        { "ceil", Op::CEIL, 1 },
+        { "round", Op::ROUND, 1 },
+        { "isnodata", Op::ISNODATA, 1 },
+        { "pow", Op::POW, 2 },
+        { "atan2", Op::ATAN2, 2 },
+        { "fmod", Op::MOD, 2 },
+        { "min", Op::MIN, -1 },
+        { "max", Op::MAX, -1 },
+        { "if", Op::COND, 3 },
+    };
+
+    for( const auto& sFunction: asFunctions )
+    {
+        if( !EQUAL(osName, sFunction.pszName) )
+            continue;
+
+        int nArgs = 0;
+        if( !Accept(")") )
+        {
+            do
+            {
+                if( !ParseConditional() )
+                    return false;
+                nArgs++;
+                // min(a,b,c) is evaluated as min(min(a,b),c)
+                if( sFunction.nMinArgs < 0 && nArgs > 2 )
+                    Emit(sFunction.eOp);
+            } while( Accept(",") );
+            if( !Accept(")") )
+                return Error("')' expected");
+        }
+
+        if( sFunction.nMinArgs < 0 )
+        {
+            if( nArgs < 2 )
+                return Error(CPLSPrintf("%s() expects at least 2 arguments",
+                                        sFunction.pszName));
+        }
+        else if( nArgs != sFunction.nMinArgs )
+        {
+            return Error(CPLSPrintf("%s() expects %d argument(s)",
+                                    sFunction.pszName, sFunction.nMinArgs));
+        }
+        Emit(sFunction.eOp);
+        return true;
+    }
+
+    return Error(CPLSPrintf("unknown function '%s'", osName.c_str()));
+}
+
+/************************************************************************/
+/* ==================================================================== */
+/*                             VRTExpression                            */
+/* ==================================================================== */
+/************************************************************************/
+
+/************************************************************************/
+/*                              Compile()                               */
+/************************************************************************/
+
+/* Returns nullptr, and emits a CPLError(), if the expression is invalid. */
+
+std::unique_ptr<VRTExpression> VRTExpression::Compile(
+                                                const char* pszExpression )
+{
+    std::unique_ptr<VRTExpression> poExpr(new VRTExpression());
+    VRTExpressionParser oParser(pszExpression, poExpr.get());
+    if( !oParser.Parse() )
+        return nullptr;
+    return poExpr;
+}
+
+/************************************************************************/
+/*                           RunInstruction()                           */
+/*                                                                      */
+/*      Apply an operator to nValues values of its operands. The        */
+/*      output may alias the first operand, so each iteration reads     */
+/*      its inputs before writing. Comparisons and logical operators    */
+/*      return NaN (nodata) when an operand is NaN, except when the     */
+/*      result is known regardless of it: 0 && nodata = 0 and           */
+/*      1 || nodata = 1.                                                */
+/************************************************************************/
+
+#define UNARY_LOOP(expr) \
+    for( int i = 0; i < nValues; i++ ) \
+    { const double a = pa[i]; padfOut[i] = (expr); } \
+    break
+
+#define BINARY_LOOP(expr) \
+    for( int i = 0; i < nValues; i++ ) \
+    { const double a = pa[i]; const double b = pb[i]; padfOut[i] = (expr); } \
+    break
+
+void VRTExpression::RunInstruction( const Instruction& sInstr,
+                                    const double* const* papdfArgs,
+                                    int nValues, double* padfOut )
+{
+    const double dfNaN = std::numeric_limits<double>::quiet_NaN();
+    const int nArity = GetArity(sInstr.eOp);
+    const double* pa = nArity >= 1 ? papdfArgs[0] : nullptr;
+    const double* pb = nArity >= 2 ? papdfArgs[1] : nullptr;
+
+    switch( sInstr.eOp )
+    {
+        case Op::CONSTANT:
+            for( int i = 0; i < nValues; i++ )
+                padfOut[i] = sInstr.dfValue;
+            break;
+        case Op::VARIABLE:
+            CPLAssert(false);
+            break;
+
+        case Op::NEG: UNARY_LOOP(-a);
+        case Op::NOT: UNARY_LOOP(CPLIsNan(a) ? dfNaN : a == 0.0 ? 1.0 : 0.0);
+        case Op::ISNODATA: UNARY_LOOP(CPLIsNan(a) ? 1.0 : 0.0);
+        case Op::ABS: UNARY_LOOP(fabs(a));
+        case Op::SQRT: UNARY_LOOP(sqrt(a));
+        case Op::EXP: UNARY_LOOP(exp(a));
+        case Op::LOG: UNARY_LOOP(log(a));
+        case Op::LOG10: UNARY_LOOP(log10(a));
+        case Op::SIN: UNARY_LOOP(sin(a));
+        case Op::COS: UNARY_LOOP(cos(a));
+        case Op::TAN: UNARY_LOOP(tan(a));
+        case Op::ASIN: UNARY_LOOP(asin(a));
+        case Op::ACOS: UNARY_LOOP(acos(a));
+        case Op::ATAN: UNARY_LOOP(atan(a));
+        case Op::FLOOR: UNARY_LOOP(floor(a));
+        case Op::CEIL: UNARY_LOOP(ceil(a));
+        case Op::ROUND: UNARY_LOOP(std::round(a));
+
+        case Op::ADD: BINARY_LOOP(a + b);
+        case Op::SUB: BINARY_LOOP(a - b);
+        case Op::MUL: BINARY_LOOP(a * b);
+        case Op::DIV: BINARY_LOOP(a / b);
+        case Op::MOD: BINARY_LOOP(fmod(a, b));
+        case Op::POW: BINARY_LOOP(pow(a, b));
+        case Op::ATAN2: BINARY_LOOP(atan2(a, b));
+        case Op::MIN:
+            BINARY_LOOP(CPLIsNan(a) || CPLIsNan(b) ? dfNaN : b < a ? b : a);
+        case Op::MAX:
+            BINARY_LOOP(CPLIsNan(a) || CPLIsNan(b) ? dfNaN : b > a ? b : a);
+
+        case Op::EQ:
+            BINARY_LOOP(CPLIsNan(a) || CPLIsNan(b) ? dfNaN :
+                        a == b ? 1.0 : 0.0);
+        case Op::NE:
+            BINARY_LOOP(CPLIsNan(a) || CPLIsNan(b) ? dfNaN :
+                        a != b ? 1.0 : 0.0);
+        case Op::LT:
+            BINARY_LOOP(CPLIsNan(a) || CPLIsNan(b) ? dfNaN :
+                        a < b ? 1.0 : 0.0);
+        case Op::LE:
+            BINARY_LOOP(CPLIsNan(a) || CPLIsNan(b) ? dfNaN :
+                        a <= b ? 1.0 : 0.0);
+        case Op::GT:
+            BINARY_LOOP(CPLIsNan(a) || CPLIsNan(b) ? dfNaN :
+                        a > b ? 1.0 : 0.0);
+        case Op::GE:
+            BINARY_LOOP(CPLIsNan(a) || CPLIsNan(b) ? dfNaN :
+                        a >= b ? 1.0 : 0.0);
+        case Op::AND:
+            BINARY_LOOP(a == 0.0 || b == 0.0 ? 0.0 :
+                        CPLIsNan(a) || CPLIsNan(b) ? dfNaN : 1.0);
+        case Op::OR:
+            BINARY_LOOP((a != 0.0 && !CPLIsNan(a)) ||
+                        (b != 0.0 && !CPLIsNan(b)) ? 1.0 :
+                        CPLIsNan(a) || CPLIsNan(b) ? dfNaN : 0.0);
+
+        case Op::COND:
+        {
+            const double* pc = papdfArgs[2];
+            for( int i = 0; i < nValues; i++ )
+            {
+                const double a = pa[i];
+                padfOut[i] = CPLIsNan(a) ? dfNaN : a != 0.0 ? pb[i] : pc[i];
+            }
+            break;
+        }
+    }
+}
+
+#undef UNARY_LOOP
+#undef BINARY_LOOP
+
+/************************************************************************/
+/*                              Evaluate()                              */
+/*                                                                      */
+/*      papdfInputs[i] holds the nValues values of B(i+1), and          */
+/*      padfOut receives the nValues results. It must not overlap       */
+/*      the inputs. The program is run on chunks of values: the         */
+/*      operand stack holds pointers either directly into the inputs,   */
+/*      or into one scratch array per stack slot.                       */
+/************************************************************************/
+
+void VRTExpression::Evaluate( const double* const* papdfInputs,
+                              size_t nValues, double* padfOut ) const
+{
+    std::vector<double> adfScratch(
+        static_cast<size_t>(m_nMaxStackDepth) * VRT_EXPR_CHUNK_SIZE);
+    std::vector<const double*> apdfStack(m_nMaxStackDepth);
+
+    for( size_t nOffset = 0; nOffset < nValues;
+                                            nOffset += VRT_EXPR_CHUNK_SIZE )
+    {
+        const int nChunk = static_cast<int>(
+            std::min(VRT_EXPR_CHUNK_SIZE, nValues - nOffset));
+        int nSP = 0;
+        for( const auto& sInstr: m_aoProgram )
+        {
+            if( sInstr.eOp == Op::VARIABLE )
+            {
+                apdfStack[nSP++] = papdfInputs[sInstr.nIndex] + nOffset;
+                continue;
+            }
+            nSP -= GetArity(sInstr.eOp);
+            double* padfResult = &adfScratch[nSP * VRT_EXPR_CHUNK_SIZE];
+            RunInstruction(sInstr, apdfStack.data() + nSP, nChunk,
+                           padfResult);
+            apdfStack[nSP++] = padfResult;
+        }
+        CPLAssert(nSP == 1);
+        memcpy(padfOut + nOffset, apdfStack[0], nChunk * sizeof(double));
+    }
+}
+
+/*! @endcond */
@@ -0,0 +1,92 @@
+/******************************************************************************
+ * $Id$
+ *
+ * Project:  Virtual GDAL Datasets
+ * Purpose:  Band math expressions for VRTDerivedRasterBand
+ *
+ ******************************************************************************
+ * Copyright (c) 2018, GDAL contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ ****************************************************************************/
+
+#ifndef VRTEXPRESSION_H_INCLUDED
+#define VRTEXPRESSION_H_INCLUDED
+
+#ifndef DOXYGEN_SKIP
+
+#include "cpl_port.h"
+
+#include <memory>
+#include <vector>
+
+/************************************************************************/
+/*                            VRTExpression                             */
+/************************************************************************/
+
+/* An expression such as "(B4-B3)/(B4+B3)" compiled into a program for a */
+/* stack machine, whose instructions operate on arrays of values. */
+/* Variables B1...Bn designate the sources of the band. */
+/* Nodata pixels are represented by NaN, and propagate through arithmetic. */
+
+class VRTExpression
+{
+  public:
+    enum class Op
+    {
+        CONSTANT, VARIABLE,
+        NEG, NOT, ISNODATA,
+        ABS, SQRT, EXP, LOG, LOG10, SIN, COS, TAN, ASIN, ACOS, ATAN,
+        FLOOR, CEIL, ROUND,
+        ADD, SUB, MUL, DIV, MOD, POW, ATAN2, MIN, MAX,
+        EQ, NE, LT, LE, GT, GE, AND, OR,
+        COND
+    };
+
+    struct Instruction
+    {
+        Op     eOp;
+        double dfValue; /* for CONSTANT */
+        int    nIndex;  /* 0-based source index, for VARIABLE */
+    };
+
+  private:
+    std::vector<Instruction> m_aoProgram{};
+    int                      m_nMaxStackDepth = 0;
+    int                      m_nVariableCount = 0;
+
+    friend class VRTExpressionParser;
+
+    static void RunInstruction( const Instruction& sInstr,
+                                const double* const* papdfArgs,
+                                int nValues, double* padfOut );
+
+  public:
+    static std::unique_ptr<VRTExpression> Compile( const char* pszExpression );
+
+    /** Return the number of variables needed, i.e. n for Bn the highest */
+    int  GetVariableCount() const { return m_nVariableCount; }
+
+    void Evaluate( const double* const* papdfInputs, size_t nValues,
+                   double* padfOut ) const;
+};
+
+#endif /* #ifndef DOXYGEN_SKIP */
+
+#endif /* VRTEXPRESSION_H_INCLUDED */
@@ -31,12 +31,15 @@
 #include "gdal_vrt.h"
 #include "vrtdataset.h"
 
+#include <algorithm>
 #include <cmath>
 #include <cstddef>
 #include <cstdio>
 #include <cstdlib>
 #include <cstring>
+#include <mutex>
 #include <string>
+#include <vector>
 
 #include "cpl_conv.h"
 #include "cpl_error.h"
@@ -45,6 +48,7 @@
 #include "cpl_progress.h"
 #include "cpl_string.h"
 #include "cpl_vsi.h"
+#include "cpl_worker_thread_pool.h"
 #include "gdal.h"
 #include "gdal_priv.h"
 #include "ogr_geometry.h"
@@ -124,6 +128,433 @@ VRTSourcedRasterBand::~VRTSourcedRasterBand()
 {
     VRTSourcedRasterBand::CloseDependentDatasets();
     CSLDestroy(m_papszSourceList);
+    InvalidateSourceIndex();
+}
+
+/************************************************************************/
+/*                        InvalidateSourceIndex()                       */
+/************************************************************************/
+
+void VRTSourcedRasterBand::InvalidateSourceIndex()
+{
+    if( m_hSourceIndex != nullptr )
+        CPLQuadTreeDestroy(m_hSourceIndex);
+    m_hSourceIndex = nullptr;
+    m_nIndexedSources = 0;
+    m_anSourceIdx.clear();
+    m_anSourcesNotIndexed.clear();
+}
+
+/************************************************************************/
+/*                          BuildSourceIndex()                          */
+/************************************************************************/
+
+// Below that number of sources, a linear scan is cheap enough.
+constexpr int MIN_SOURCES_FOR_INDEX = 64;
+
+void VRTSourcedRasterBand::BuildSourceIndex()
+{
+    InvalidateSourceIndex();
+    m_nIndexedSources = nSources;
+    if( nSources < MIN_SOURCES_FOR_INDEX )
+        return;
+
+    CPLRectObj sGlobalBounds;
+    sGlobalBounds.minx = 0;
+    sGlobalBounds.miny = 0;
+    sGlobalBounds.maxx = nRasterXSize;
+    sGlobalBounds.maxy = nRasterYSize;
+    m_hSourceIndex = CPLQuadTreeCreate(&sGlobalBounds, nullptr);
+    CPLQuadTreeSetMaxDepth(m_hSourceIndex,
+                           CPLQuadTreeGetAdvisedMaxDepth(nSources));
+
+    // The quad tree stores pointers to the source indices.
+    m_anSourceIdx.resize(nSources);
+    for( int i = 0; i < nSources; i++ )
+    {
+        m_anSourceIdx[i] = i;
+        // Only simple sources with an explicit destination window have
+        // known bounds. Other sources may contribute anywhere.
+        VRTSimpleSource* poSS = papoSources[i]->IsSimpleSource() ?
+            cpl::down_cast<VRTSimpleSource*>(papoSources[i]) : nullptr;
+        if( poSS == nullptr ||
+            (poSS->m_dfDstXOff == -1 && poSS->m_dfDstXSize == -1 &&
+             poSS->m_dfDstYOff == -1 && poSS->m_dfDstYSize == -1) )
+        {
+            m_anSourcesNotIndexed.push_back(i);
+            continue;
+        }
+        CPLRectObj sBounds;
+        sBounds.minx = poSS->m_dfDstXOff;
+        sBounds.miny = poSS->m_dfDstYOff;
+        sBounds.maxx = poSS->m_dfDstXOff + poSS->m_dfDstXSize;
+        sBounds.maxy = poSS->m_dfDstYOff + poSS->m_dfDstYSize;
+        CPLQuadTreeInsertWithBounds(m_hSourceIndex, &m_anSourceIdx[i],
+                                    &sBounds);
+    }
+}
+
+/************************************************************************/
+/*                       GetIntersectingSources()                       */
+/************************************************************************/
+
+/**
+ * Return the indices, in ascending order, of the sources that may
+ * contribute to the specified window of the band. This is a superset of
+ * the sources for which VRTSimpleSource::GetSrcDstWindow() succeeds.
+ */
+void VRTSourcedRasterBand::GetIntersectingSources( int nXOff, int nYOff,
+                                                   int nXSize, int nYSize,
+                                                   std::vector<int>& anSources )
+{
+    anSources.clear();
+    // VRTDataset::IRasterIO() temporarily sets nSources to 0: do not
+    // discard the index in that case.
+    if( nSources == 0 )
+        return;
+    if( m_nIndexedSources != nSources )
+        BuildSourceIndex();
+
+    if( m_hSourceIndex == nullptr )
+    {
+        anSources.resize(nSources);
+        for( int i = 0; i < nSources; i++ )
+            anSources[i] = i;
+        return;
+    }
+
+    // Sources whose window just touches the request are kept, as
+    // GetSrcDstWindow() does.
+    CPLRectObj sAOI;
+    sAOI.minx = nXOff;
+    sAOI.miny = nYOff;
+    sAOI.maxx = static_cast<double>(nXOff) + nXSize;
+    sAOI.maxy = static_cast<double>(nYOff) + nYSize;
+    int nFeatureCount = 0;
+    void** pahFeatures = CPLQuadTreeSearch(m_hSourceIndex, &sAOI,
+                                           &nFeatureCount);
+    anSources = m_anSourcesNotIndexed;
+    for( int i = 0; i < nFeatureCount; i++ )
+        anSources.push_back(*static_cast<int*>(pahFeatures[i]));
+    CPLFree(pahFeatures);
+
+    // Sources are composited in their declaration order.
+    std::sort(anSources.begin(), anSources.end());
+}
+
+/************************************************************************/
+/*                      Source compositing threads                      */
+/************************************************************************/
+
+// Pools are handed to a single IRasterIO() call at a time, so that
+// WaitCompletion() only waits for the jobs of that call.
+static std::mutex gMutexThreadPools;
+static std::vector<CPLWorkerThreadPool*> gapoThreadPools;
+
+// Set in worker threads, so that nested VRTs are composited sequentially.
+static thread_local bool gbInVRTWorkerThread = false;
+
+static int VRTGetSourceThreadCount()
+{
+    if( gbInVRTWorkerThread )
+        return 1;
+    const char* pszValue = CPLGetConfigOption("VRT_NUM_THREADS", nullptr);
+    if( pszValue == nullptr )
+        pszValue = CPLGetConfigOption("GDAL_NUM_THREADS", "1");
+    const int nThreads =
+        EQUAL(pszValue, "ALL_CPUS") ? CPLGetNumCPUs() : atoi(pszValue);
+    return std::max(1, std::min(128, nThreads));
+}
+
+static CPLWorkerThreadPool* VRTAcquireSourceThreadPool( int nThreads )
+{
+    {
+        std::lock_guard<std::mutex> oLock(gMutexThreadPools);
+        while( !gapoThreadPools.empty() )
+        {
+            CPLWorkerThreadPool* poPool = gapoThreadPools.back();
+            gapoThreadPools.pop_back();
+            if( poPool->GetThreadCount() == nThreads )
+                return poPool;
+            delete poPool;
+        }
+    }
+    CPLDebug("VRT", "Using %d threads for source compositing", nThreads);
+    CPLWorkerThreadPool* poPool = new (std::nothrow) CPLWorkerThreadPool();
+    if( poPool != nullptr && !poPool->Setup(nThreads, nullptr, nullptr) )
+    {
+        delete poPool;
+        poPool = nullptr;
+    }
+    return poPool;
+}
+
+static void VRTReleaseSourceThreadPool( CPLWorkerThreadPool* poPool )
+{
+    std::lock_guard<std::mutex> oLock(gMutexThreadPools);
+    gapoThreadPools.push_back(poPool);
+}
+
+/************************************************************************/
+/*                    VRTDestroySourceThreadPools()                     */
+/************************************************************************/
+
+void VRTDestroySourceThreadPools()
+{
+    std::lock_guard<std::mutex> oLock(gMutexThreadPools);
+    for( auto poPool : gapoThreadPools )
+        delete poPool;
+    gapoThreadPools.clear();
+}
+
+namespace {
+struct VRTSourceRasterIOError
+{
+    CPLErr      eErr = CE_None;
+    CPLErrorNum nErrorNum = CPLE_None;
+    CPLString   osMsg{};
+};
+
+struct VRTSourceRasterIOJob
+{
+    VRTSource            *poSource = nullptr;
+    GDALDataType          eBandDataType = GDT_Unknown;
+    int                   nXOff = 0;
+    int                   nYOff = 0;
+    int                   nXSize = 0;
+    int                   nYSize = 0;
+    void                 *pData = nullptr;
+    int                   nBufXSize = 0;
+    int                   nBufYSize = 0;
+    GDALDataType          eBufType = GDT_Unknown;
+    GSpacing              nPixelSpace = 0;
+    GSpacing              nLineSpace = 0;
+    GDALRasterIOExtraArg  sExtraArg;
+    CPLErr                eErr = CE_None;
+
+    // Window written in the output buffer, and identification of the
+    // dataset read. Only valid if bParallelizable.
+    bool                  bParallelizable = false;
+    int                   nOutXOff = 0;
+    int                   nOutYOff = 0;
+    int                   nOutXSize = 0;
+    int                   nOutYSize = 0;
+    CPLString             osDatasetKey{};
+
+    // Thread local configuration options of the calling thread, applied
+    // in the worker thread, and errors emitted there, to be emitted again
+    // in the calling thread.
+    const char* const    *papszThreadLocalConfigOptions = nullptr;
+    std::vector<VRTSourceRasterIOError> aoErrors{};
+};
+} // namespace
+
+static void VRTSourceRasterIOJobFunc( void* pData )
+{
+    VRTSourceRasterIOJob* psJob = static_cast<VRTSourceRasterIOJob*>(pData);
+    const bool bInWorkerThreadBackup = gbInVRTWorkerThread;
+    gbInVRTWorkerThread = true;
+    psJob->eErr = psJob->poSource->RasterIO(
+        psJob->eBandDataType,
+        psJob->nXOff, psJob->nYOff, psJob->nXSize, psJob->nYSize,
+        psJob->pData, psJob->nBufXSize, psJob->nBufYSize,
+        psJob->eBufType, psJob->nPixelSpace, psJob->nLineSpace,
+        &psJob->sExtraArg );
+    gbInVRTWorkerThread = bInWorkerThreadBackup;
+}
+
+static void CPL_STDCALL VRTSourceRasterIOErrorHandler( CPLErr eErr,
+                                                       CPLErrorNum nErrorNum,
+                                                       const char *pszMsg )
+{
+    if( eErr == CE_Debug )
+        return;
+    std::vector<VRTSourceRasterIOError> *paoErrors =
+        static_cast<std::vector<VRTSourceRasterIOError> *>(
+                                        CPLGetErrorHandlerUserData());
+    VRTSourceRasterIOError oError;
+    oError.eErr = eErr;
+    oError.nErrorNum = nErrorNum;
+    oError.osMsg = pszMsg;
+    paoErrors->push_back(oError);
+}
+
+static void VRTSourceRasterIOWorkerJobFunc( void* pData )
+{
+    VRTSourceRasterIOJob* psJob = static_cast<VRTSourceRasterIOJob*>(pData);
+    char** papszOldConfigOptions = CPLGetThreadLocalConfigOptions();
+    CPLSetThreadLocalConfigOptions(psJob->papszThreadLocalConfigOptions);
+    CPLPushErrorHandlerEx(VRTSourceRasterIOErrorHandler, &psJob->aoErrors);
+    VRTSourceRasterIOJobFunc(pData);
+    CPLPopErrorHandler();
+    CPLSetThreadLocalConfigOptions(papszOldConfigOptions);
+    CSLDestroy(papszOldConfigOptions);
+}
+
+static bool VRTSourceJobsConflict( const VRTSourceRasterIOJob& sA,
+                                   const VRTSourceRasterIOJob& sB )
+{
+    if( !sA.bParallelizable || !sB.bParallelizable )
+        return true;
+    // Two sources of the same dataset cannot be read concurrently.
+    if( sA.osDatasetKey == sB.osDatasetKey )
+        return true;
+    return sA.nOutXOff < sB.nOutXOff + sB.nOutXSize &&
+           sB.nOutXOff < sA.nOutXOff + sA.nOutXSize &&
+           sA.nOutYOff < sB.nOutYOff + sB.nOutYSize &&
+           sB.nOutYOff < sA.nOutYOff + sA.nOutYSize;
+}
+
+/************************************************************************/
+/*                    CompositeSourcesMultiThreaded()                   */
+/************************************************************************/
+
+// Sources are gathered into batches whose members write disjoint windows
+// of the output buffer and read distinct datasets. The members of a batch
+// are read concurrently. A source that conflicts with a member of the
+// current batch starts a new batch, so that overlapping sources are still
+// applied in their priority order. Batches are also bounded in size, so that
+// the conflict detection does not get quadratic in the number of sources.
+
+CPLErr VRTSourcedRasterBand::CompositeSourcesMultiThreaded(
+                            int nThreads, const std::vector<int>& anSources,
+                            int nXOff, int nYOff, int nXSize, int nYSize,
+                            void *pData, int nBufXSize, int nBufYSize,
+                            GDALDataType eBufType,
+                            GSpacing nPixelSpace, GSpacing nLineSpace,
+                            GDALRasterIOExtraArg* psExtraArg )
+{
+    std::vector<VRTSourceRasterIOJob> asJobs;
+    asJobs.reserve(anSources.size());
+    for( const int iSource : anSources )
+    {
+        VRTSourceRasterIOJob sJob;
+        sJob.poSource = papoSources[iSource];
+        sJob.eBandDataType = eDataType;
+        sJob.nXOff = nXOff;
+        sJob.nYOff = nYOff;
+        sJob.nXSize = nXSize;
+        sJob.nYSize = nYSize;
+        sJob.pData = pData;
+        sJob.nBufXSize = nBufXSize;
+        sJob.nBufYSize = nBufYSize;
+        sJob.eBufType = eBufType;
+        sJob.nPixelSpace = nPixelSpace;
+        sJob.nLineSpace = nLineSpace;
+        sJob.sExtraArg = *psExtraArg;
+        sJob.sExtraArg.pfnProgress = nullptr;
+        sJob.sExtraArg.pProgressData = nullptr;
+
+        if( papoSources[iSource]->IsSimpleSource() )
+        {
+            VRTSimpleSource* poSS =
+                cpl::down_cast<VRTSimpleSource*>(papoSources[iSource]);
+            double dfReqXOff = 0.0;
+            double dfReqYOff = 0.0;
+            double dfReqXSize = 0.0;
+            double dfReqYSize = 0.0;
+            int nReqXOff = 0;
+            int nReqYOff = 0;
+            int nReqXSize = 0;
+            int nReqYSize = 0;
+            if( !poSS->GetSrcDstWindow( nXOff, nYOff, nXSize, nYSize,
+                                  nBufXSize, nBufYSize,
+                                  &dfReqXOff, &dfReqYOff,
+                                  &dfReqXSize, &dfReqYSize,
+                                  &nReqXOff, &nReqYOff,
+                                  &nReqXSize, &nReqYSize,
+                                  &sJob.nOutXOff, &sJob.nOutYOff,
+                                  &sJob.nOutXSize, &sJob.nOutYSize ) )
+            {
+                // The source would not write anything.
+                continue;
+            }
+            GDALRasterBand* poSrcBand = poSS->m_poMaskBandMainBand ?
+                poSS->m_poMaskBandMainBand : poSS->GetBand();
+            GDALDataset* poSrcDS =
+                poSrcBand ? poSrcBand->GetDataset() : nullptr;
+            if( poSrcDS != nullptr )
+            {
+                sJob.bParallelizable = true;
+                if( poSrcDS->GetDescription()[0] != '\0' )
+                    sJob.osDatasetKey = poSrcDS->GetDescription();
+                else
+                    sJob.osDatasetKey.Printf("%p", poSrcDS);
+            }
+        }
+        asJobs.push_back(sJob);
+    }
+
+    CPLWorkerThreadPool* poPool = nullptr;
+    if( asJobs.size() > 1 )
+        poPool = VRTAcquireSourceThreadPool(nThreads);
+
+    char** papszThreadLocalConfigOptions = CPLGetThreadLocalConfigOptions();
+    const size_t nMaxBatchSize = static_cast<size_t>(nThreads) * 16;
+
+    GDALProgressFunc const pfnProgress = psExtraArg->pfnProgress;
+    void * const pProgressData = psExtraArg->pProgressData;
+
+    CPLErr eErr = CE_None;
+    size_t iStart = 0;
+    while( eErr == CE_None && iStart < asJobs.size() )
+    {
+        size_t iEnd = iStart + 1;
+        if( poPool != nullptr )
+        {
+            for( ; iEnd < asJobs.size() &&
+                   iEnd - iStart < nMaxBatchSize; iEnd++ )
+            {
+                bool bConflict = false;
+                for( size_t j = iStart; !bConflict && j < iEnd; j++ )
+                    bConflict = VRTSourceJobsConflict(asJobs[j], asJobs[iEnd]);
+                if( bConflict )
+                    break;
+            }
+        }
+
+        if( iEnd - iStart == 1 )
+        {
+            VRTSourceRasterIOJobFunc(&asJobs[iStart]);
+        }
+        else
+        {
+            std::vector<void*> apData;
+            for( size_t i = iStart; i < iEnd; i++ )
+            {
+                asJobs[i].papszThreadLocalConfigOptions =
+                    papszThreadLocalConfigOptions;
+                apData.push_back(&asJobs[i]);
+            }
+            poPool->SubmitJobs(VRTSourceRasterIOWorkerJobFunc, apData);
+            poPool->WaitCompletion();
+        }
+
+        for( size_t i = iStart; i < iEnd; i++ )
+        {
+            for( const auto& oError : asJobs[i].aoErrors )
+            {
+                CPLError(oError.eErr, oError.nErrorNum,
+                         "%s", oError.osMsg.c_str());
+            }
+            if( asJobs[i].eErr != CE_None )
+                eErr = asJobs[i].eErr;
+        }
+        iStart = iEnd;
+
+        if( eErr == CE_None && pfnProgress != nullptr &&
+            !pfnProgress(1.0 * iStart / asJobs.size(), "", pProgressData) )
+        {
+            CPLError(CE_Failure, CPLE_UserInterrupt, "User terminated");
+            eErr = CE_Failure;
+        }
+    }
+
+    if( poPool != nullptr )
+        VRTReleaseSourceThreadPool(poPool);
+    CSLDestroy(papszThreadLocalConfigOptions);
+
+    return eErr;
 }
 
 /************************************************************************/
@@ -183,7 +614,9 @@ CPLErr VRTSourcedRasterBand::IRasterIO( GDALRWFlag eRWFlag,
         psExtraArg->eResampleAlg != GRIORA_NearestNeighbour &&
         m_bNoDataValueSet )
     {
-        for( int i = 0; i < nSources; i++ )
+        std::vector<int> anSources;
+        GetIntersectingSources(nXOff, nYOff, nXSize, nYSize, anSources);
+        for( const int i : anSources )
         {
             bool bFallbackToBase = false;
             if( !papoSources[i]->IsSimpleSource() )
@@ -286,26 +719,45 @@ CPLErr VRTSourcedRasterBand::IRasterIO( GDALRWFlag eRWFlag,
 /* -------------------------------------------------------------------- */
 /*      Overlay each source in turn over top this.                      */
 /* -------------------------------------------------------------------- */
+    std::vector<int> anSources;
+    GetIntersectingSources(nXOff, nYOff, nXSize, nYSize, anSources);
+    const int nIntersectingSources = static_cast<int>(anSources.size());
+
     CPLErr eErr = CE_None;
-    for( int iSource = 0; eErr == CE_None && iSource < nSources; iSource++ )
+    const int nThreads =
+        nIntersectingSources > 1 ? VRTGetSourceThreadCount() : 1;
+    if( nThreads > 1 )
+    {
+        eErr = CompositeSourcesMultiThreaded( nThreads, anSources,
+                                              nXOff, nYOff, nXSize, nYSize,
+                                              pData, nBufXSize, nBufYSize,
+                                              eBufType,
+                                              nPixelSpace, nLineSpace,
+                                              psExtraArg );
+    }
+    else
     {
-        psExtraArg->pfnProgress = GDALScaledProgress;
-        psExtraArg->pProgressData =
-            GDALCreateScaledProgress( 1.0 * iSource / nSources,
-                                      1.0 * (iSource + 1) / nSources,
-                                      pfnProgressGlobal,
-                                      pProgressDataGlobal );
-        if( psExtraArg->pProgressData == nullptr )
-            psExtraArg->pfnProgress = nullptr;
-
-        eErr =
-            papoSources[iSource]->RasterIO( eDataType,
-                                            nXOff, nYOff, nXSize, nYSize,
-                                            pData, nBufXSize, nBufYSize,
-                                            eBufType, nPixelSpace, nLineSpace,
-                                            psExtraArg);
-
-        GDALDestroyScaledProgress( psExtraArg->pProgressData );
+        for( int i = 0; eErr == CE_None && i < nIntersectingSources; i++ )
+        {
+            const int iSource = anSources[i];
+            psExtraArg->pfnProgress = GDALScaledProgress;
+            psExtraArg->pProgressData =
+                GDALCreateScaledProgress( 1.0 * i / nIntersectingSources,
+                                          1.0 * (i + 1) / nIntersectingSources,
+                                          pfnProgressGlobal,
+                                          pProgressDataGlobal );
+            if( psExtraArg->pProgressData == nullptr )
+                psExtraArg->pfnProgress = nullptr;
+
+            eErr =
+                papoSources[iSource]->RasterIO( eDataType,
+                                                nXOff, nYOff, nXSize, nYSize,
+                                                pData, nBufXSize, nBufYSize,
+                                                eBufType, nPixelSpace, nLineSpace,
+                                                psExtraArg);
+
+            GDALDestroyScaledProgress( psExtraArg->pProgressData );
+        }
     }
 
     psExtraArg->pfnProgress = pfnProgressGlobal;
@@ -354,7 +806,9 @@ int  VRTSourcedRasterBand::IGetDataCoverageStatus( int nXOff,
     poLR->addPoint( nXOff, nYOff );
     poPolyNonCoveredBySources->addRingDirectly(poLR);
 
-    for( int iSource = 0; iSource < nSources; iSource++ )
+    std::vector<int> anSources;
+    GetIntersectingSources(nXOff, nYOff, nXSize, nYSize, anSources);
+    for( const int iSource : anSources )
     {
         if( !papoSources[iSource]->IsSimpleSource() )
         {
@@ -907,6 +1361,7 @@ CPLErr VRTSourcedRasterBand::AddSource( VRTSource *poNewSource )
     papoSources = static_cast<VRTSource **>(
         CPLRealloc( papoSources, sizeof(void*) * nSources ) );
     papoSources[nSources-1] = poNewSource;
+    InvalidateSourceIndex();
 
     reinterpret_cast<VRTDataset *>( poDS )->SetNeedsFlush();
 
@@ -1604,6 +2059,7 @@ CPLErr VRTSourcedRasterBand::SetMetadataItem( const char *pszName,
         {
             delete papoSources[iSource];
             papoSources[iSource] = poSource;
+            InvalidateSourceIndex();
             reinterpret_cast<VRTDataset *>( poDS )->SetNeedsFlush();
             return CE_None;
         }
@@ -1635,6 +2091,7 @@ CPLErr VRTSourcedRasterBand::SetMetadata( char **papszNewMD, const char *pszDoma
             CPLFree( papoSources );
             papoSources = nullptr;
             nSources = 0;
+            InvalidateSourceIndex();
         }
 
         for( int i = 0; i < CSLCount(papszNewMD); i++ )
@@ -1696,6 +2153,7 @@ int VRTSourcedRasterBand::CloseDependentDatasets()
     CPLFree( papoSources );
     papoSources = nullptr;
     nSources = 0;
+    InvalidateSourceIndex();
 
     return TRUE;
 }
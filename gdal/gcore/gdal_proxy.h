@@ -220,7 +220,6 @@ class CPL_DLL GDALProxyPoolDataset : public GDALProxyDataset
         CPLHashSet      *metadataSet = nullptr;
         CPLHashSet      *metadataItemSet = nullptr;
 
-        GDALProxyPoolCacheEntry* cacheEntry = nullptr;
         char            *m_pszOwner = nullptr;
 
         GDALDataset *RefUnderlyingDataset(bool bForceOpen);
@@ -409,6 +408,10 @@ void CPL_DLL GDALProxyPoolDatasetAddSrcBandDescription( GDALProxyPoolDatasetH hP
                                                         GDALDataType eDataType,
                                                         int nBlockXSize, int nBlockYSize);
 
+void CPL_DLL GDALProxyPoolGetStatistics( GIntBig* pnHits, GIntBig* pnMisses,
+                                         GIntBig* pnEvictions,
+                                         int* pnOpenDatasets );
+
 CPL_C_END
 
 #endif /* #ifndef DOXYGEN_SKIP */
@@ -42,6 +42,7 @@
 #include <set>
 #include <string>
 #include <utility>
+#include <vector>
 
 #include "cpl_conv.h"
 #include "cpl_error.h"
@@ -4665,13 +4666,59 @@ OGRLayer *GDALDataset::GetLayerByName( const char *pszName )
 }
 
 //! @cond Doxygen_Suppress
+/************************************************************************/
+/*                        GetSQLIndexFields()                           */
+/*                                                                      */
+/*      Resolve the comma separated list of field names following       */
+/*      USING in CREATE INDEX and DROP INDEX commands.                  */
+/************************************************************************/
+
+static bool GetSQLIndexFields( OGRLayer *poLayer, char **papszTokens,
+                               const char *pszSQLCommand,
+                               std::vector<int> &anFields )
+{
+    CPLString osFields;
+    for( int i = 0; papszTokens[i] != nullptr; i++ )
+    {
+        if( i > 0 )
+            osFields += " ";
+        osFields += papszTokens[i];
+    }
+
+    char **papszFields = CSLTokenizeString2(
+        osFields, ",", CSLT_STRIPLEADSPACES | CSLT_STRIPENDSPACES );
+    for( int i = 0; papszFields != nullptr && papszFields[i] != nullptr; i++ )
+    {
+        const int iField =
+            poLayer->GetLayerDefn()->GetFieldIndex(papszFields[i]);
+        if( iField < 0 )
+        {
+            CPLError(CE_Failure, CPLE_AppDefined,
+                     "`%s' failed, field %s not found.",
+                     pszSQLCommand, papszFields[i]);
+            CSLDestroy(papszFields);
+            return false;
+        }
+        anFields.push_back(iField);
+    }
+    CSLDestroy(papszFields);
+
+    if( anFields.empty() )
+    {
+        CPLError(CE_Failure, CPLE_AppDefined,
+                 "`%s' failed, field not found.", pszSQLCommand);
+        return false;
+    }
+    return true;
+}
+
 /************************************************************************/
 /*                       ProcessSQLCreateIndex()                        */
 /*                                                                      */
 /*      The correct syntax for creating an index in our dialect of      */
 /*      SQL is:                                                         */
 /*                                                                      */
-/*        CREATE INDEX ON <layername> USING <columnname>                */
+/*        CREATE INDEX ON <layername> USING <columnname>[,...]          */
 /************************************************************************/
 
 OGRErr GDALDataset::ProcessSQLCreateIndex( const char *pszSQLCommand )
@@ -4682,7 +4729,7 @@ OGRErr GDALDataset::ProcessSQLCreateIndex( const char *pszSQLCommand )
 /* -------------------------------------------------------------------- */
 /*      Do some general syntax checking.                                */
 /* -------------------------------------------------------------------- */
-    if( CSLCount(papszTokens) != 6
+    if( CSLCount(papszTokens) < 6
         || !EQUAL(papszTokens[0], "CREATE")
         || !EQUAL(papszTokens[1], "INDEX")
         || !EQUAL(papszTokens[2], "ON")
@@ -4692,7 +4739,8 @@ OGRErr GDALDataset::ProcessSQLCreateIndex( const char *pszSQLCommand )
         CPLError(CE_Failure, CPLE_AppDefined,
                  "Syntax error in CREATE INDEX command.\n"
                  "Was '%s'\n"
-                 "Should be of form 'CREATE INDEX ON <table> USING <field>'",
+                 "Should be of form 'CREATE INDEX ON <table> USING "
+                 "<field>[,<field>]*'",
                  pszSQLCommand);
         return OGRERR_FAILURE;
     }
@@ -4722,27 +4770,25 @@ OGRErr GDALDataset::ProcessSQLCreateIndex( const char *pszSQLCommand )
     }
 
 /* -------------------------------------------------------------------- */
-/*      Find the named field.                                           */
+/*      Find the named fields.                                          */
 /* -------------------------------------------------------------------- */
-    int i = poLayer->GetLayerDefn()->GetFieldIndex(papszTokens[5]);
+    std::vector<int> anFields;
+    const bool bFieldsFound =
+        GetSQLIndexFields(poLayer, papszTokens + 5, pszSQLCommand, anFields);
 
     CSLDestroy(papszTokens);
 
-    if( i >= poLayer->GetLayerDefn()->GetFieldCount() )
-    {
-        CPLError(CE_Failure, CPLE_AppDefined,
-                 "`%s' failed, field not found.",
-                 pszSQLCommand);
+    if( !bFieldsFound )
         return OGRERR_FAILURE;
-    }
 
 /* -------------------------------------------------------------------- */
 /*      Attempt to create the index.                                    */
 /* -------------------------------------------------------------------- */
-    OGRErr eErr = poLayer->GetIndex()->CreateIndex(i);
+    OGRErr eErr = poLayer->GetIndex()->CreateCompoundIndex(
+        static_cast<int>(anFields.size()), anFields.data());
     if( eErr == OGRERR_NONE )
     {
-        eErr = poLayer->GetIndex()->IndexAllFeatures(i);
+        eErr = poLayer->GetIndex()->IndexAllFeatures(anFields[0]);
     }
     else
     {
@@ -4759,7 +4805,7 @@ OGRErr GDALDataset::ProcessSQLCreateIndex( const char *pszSQLCommand )
 /*      The correct syntax for dropping one or more indexes in          */
 /*      the OGR SQL dialect is:                                         */
 /*                                                                      */
-/*          DROP INDEX ON <layername> [USING <columnname>]              */
+/*          DROP INDEX ON <layername> [USING <columnname>[,...]]        */
 /************************************************************************/
 
 OGRErr GDALDataset::ProcessSQLDropIndex( const char *pszSQLCommand )
@@ -4770,17 +4816,18 @@ OGRErr GDALDataset::ProcessSQLDropIndex( const char *pszSQLCommand )
 /* -------------------------------------------------------------------- */
 /*      Do some general syntax checking.                                */
 /* -------------------------------------------------------------------- */
-    if( (CSLCount(papszTokens) != 4 && CSLCount(papszTokens) != 6)
+    if( (CSLCount(papszTokens) != 4 && CSLCount(papszTokens) < 6)
         || !EQUAL(papszTokens[0], "DROP")
         || !EQUAL(papszTokens[1], "INDEX")
         || !EQUAL(papszTokens[2], "ON")
-        || (CSLCount(papszTokens) == 6 && !EQUAL(papszTokens[4], "USING")) )
+        || (CSLCount(papszTokens) >= 6 && !EQUAL(papszTokens[4], "USING")) )
     {
         CSLDestroy(papszTokens);
         CPLError(CE_Failure, CPLE_AppDefined,
                  "Syntax error in DROP INDEX command.\n"
                  "Was '%s'\n"
-                 "Should be of form 'DROP INDEX ON <table> [USING <field>]'",
+                 "Should be of form 'DROP INDEX ON <table> "
+                 "[USING <field>[,<field>]*]'",
                  pszSQLCommand);
         return OGRERR_FAILURE;
     }
@@ -4830,27 +4877,42 @@ OGRErr GDALDataset::ProcessSQLDropIndex( const char *pszSQLCommand )
             }
         }
 
+        // Then the indexes on several fields.
         CSLDestroy(papszTokens);
+        OGRLayerAttrIndex *poLIndex = poLayer->GetIndex();
+        while( poLIndex->GetAttrIndexCount() > 0 )
+        {
+            OGRAttrIndex *poAttrIndex = poLIndex->GetAttrIndex(0);
+            if( poAttrIndex == nullptr )
+                break;
+            std::vector<int> anFields;
+            for( int i = 0; i < poAttrIndex->GetKeyFieldCount(); i++ )
+                anFields.push_back(poAttrIndex->GetKeyField(i));
+            const OGRErr eErr = poLIndex->DropCompoundIndex(
+                static_cast<int>(anFields.size()), anFields.data());
+            if( eErr != OGRERR_NONE )
+                return eErr;
+        }
+
         return OGRERR_NONE;
     }
 
 /* -------------------------------------------------------------------- */
-/*      Find the named field.                                           */
+/*      Find the named fields.                                          */
 /* -------------------------------------------------------------------- */
-    int i = poLayer->GetLayerDefn()->GetFieldIndex(papszTokens[5]);
+    std::vector<int> anFields;
+    const bool bFieldsFound =
+        GetSQLIndexFields(poLayer, papszTokens + 5, pszSQLCommand, anFields);
     CSLDestroy(papszTokens);
 
-    if( i >= poLayer->GetLayerDefn()->GetFieldCount() )
-    {
-        CPLError(CE_Failure, CPLE_AppDefined, "`%s' failed, field not found.",
-                 pszSQLCommand);
+    if( !bFieldsFound )
         return OGRERR_FAILURE;
-    }
 
 /* -------------------------------------------------------------------- */
 /*      Attempt to drop the index.                                      */
 /* -------------------------------------------------------------------- */
-    const OGRErr eErr = poLayer->GetIndex()->DropIndex(i);
+    const OGRErr eErr = poLayer->GetIndex()->DropCompoundIndex(
+        static_cast<int>(anFields.size()), anFields.data());
 
     return eErr;
 }
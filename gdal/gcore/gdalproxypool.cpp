@@ -30,10 +30,18 @@
 #include "cpl_port.h"
 #include "gdal_proxy.h"
 
+#include <algorithm>
+#include <atomic>
+#include <chrono>
 #include <cstdio>
 #include <cstdlib>
 #include <cstring>
+#include <vector>
+#if HAVE_GETRLIMIT
+#include <sys/resource.h>
+#endif
 
+#include "cpl_atomic_ops.h"
 #include "cpl_conv.h"
 #include "cpl_error.h"
 #include "cpl_hash_set.h"
@@ -46,23 +54,42 @@
 
 CPL_CVSID("$Id$")
 
-/* We *must* share the same mutex as the gdaldataset.cpp file, as we are */
-/* doing GDALOpen() calls that can indirectly call GDALOpenShared() on */
-/* an auxiliary dataset ... */
-/* Then we could get dead-locks in multi-threaded use case */
+/* The lifetime of the pool singleton is protected by the same mutex as the */
+/* one of gdaldataset.cpp. However, the datasets of the pool are opened and */
+/* closed without holding any mutex: GDALOpen() can indirectly call */
+/* GDALOpenShared() on an auxiliary dataset, or open a VRT that uses the */
+/* pool itself, and we do not want threads working on different files to */
+/* wait for each other. */
 
 /* ******************************************************************** */
 /*                         GDALDatasetPool                              */
 /* ******************************************************************** */
 
 /* This class is a singleton that maintains a pool of opened datasets */
-/* The cache uses a LRU strategy */
+/* The cache uses a LRU strategy, tempered by the cost of reopening the */
+/* datasets: among the least recently used datasets that are not in use, */
+/* the one that was the fastest to open is closed first. */
+/* Entries are spread over shards according to a hash of their filename. */
+/* Each shard has its own mutex. */
+/* An entry in use by a thread is never handed to another thread: another */
+/* handle on the same file is opened instead. */
 
 class GDALDatasetPool;
 static GDALDatasetPool* singleton = nullptr;
 
 void GDALNullifyProxyPoolSingleton() { singleton = nullptr; }
 
+/* This variable prevents a dataset that is going to be opened in */
+/* GDALDatasetPool::_RefDataset from increasing refCount if, during its */
+/* opening, it creates a GDALProxyPoolDataset. */
+/* It is incremented while the current thread opens or closes a dataset */
+/* of the pool. */
+/* The typical use case is a VRT made of simple sources that are VRT */
+/* We don't want the "inner" VRT to take a reference on the pool, otherwise */
+/* there is a high chance that this reference will not be dropped and the */
+/* pool remain ghost */
+static thread_local int nThreadDisableRefCount = 0;
+
 struct _GDALProxyPoolCacheEntry
 {
     GIntBig       responsiblePID;
@@ -73,6 +100,12 @@ struct _GDALProxyPoolCacheEntry
     /* Ref count of the cached dataset */
     int           refCount;
 
+    /* Thread that holds the references, when refCount > 0 */
+    GIntBig       nUserThreadId;
+
+    /* Time spent in opening the dataset, in seconds */
+    double        dfOpenDuration;
+
     GDALProxyPoolCacheEntry* prev;
     GDALProxyPoolCacheEntry* next;
 };
@@ -80,37 +113,57 @@ struct _GDALProxyPoolCacheEntry
 class GDALDatasetPool
 {
     private:
+        static constexpr int SHARD_COUNT = 16;
+
+        /* Number of least recently used entries considered for eviction */
+        static constexpr int EVICTION_CANDIDATES = 8;
+
+        struct Shard
+        {
+            CPLMutex* hMutex = nullptr;
+            GDALProxyPoolCacheEntry* firstEntry = nullptr;
+            GDALProxyPoolCacheEntry* lastEntry = nullptr;
+            int currentSize = 0;
+            GIntBig nHits = 0;
+            GIntBig nMisses = 0;
+            GIntBig nEvictions = 0;
+        };
+
         bool bInDestruction = false;
 
         /* Ref count of the pool singleton */
         /* Taken by "toplevel" GDALProxyPoolDataset in its constructor and released */
-        /* in its destructor. See also refCountOfDisableRefCount for the difference */
+        /* in its destructor. See also nThreadDisableRefCount for the difference */
         /* between toplevel and inner GDALProxyPoolDataset */
         int refCount = 0;
 
+        /* The pool may temporarily hold more than maxSize datasets when */
+        /* all of them are in use */
         int maxSize = 0;
-        int currentSize = 0;
-        GDALProxyPoolCacheEntry* firstEntry = nullptr;
-        GDALProxyPoolCacheEntry* lastEntry = nullptr;
-
-        /* This variable prevents a dataset that is going to be opened in GDALDatasetPool::_RefDataset */
-        /* from increasing refCount if, during its opening, it creates a GDALProxyPoolDataset */
-        /* We increment it before opening or closing a cached dataset and decrement it afterwards */
-        /* The typical use case is a VRT made of simple sources that are VRT */
-        /* We don't want the "inner" VRT to take a reference on the pool, otherwise there is */
-        /* a high chance that this reference will not be dropped and the pool remain ghost */
-        int refCountOfDisableRefCount= 0;
-
-        /* Caution : to be sure that we don't run out of entries, size must be at */
-        /* least greater or equal than the maximum number of threads */
+        volatile int currentSize = 0;
+        std::atomic<bool> bOverCapacityWarningEmitted{false};
+
+        Shard aoShards[SHARD_COUNT];
+
+        /* Set by PreventDestroy(): the pool is then only destroyed by */
+        /* ForceDestroy(), when the driver manager is destroyed */
+        bool bPreventDestroy = false;
+
         explicit GDALDatasetPool(int maxSize);
         ~GDALDatasetPool();
+        Shard& GetShard(const char* pszFileName);
+        static void MoveToFront(Shard& oShard, GDALProxyPoolCacheEntry* cur);
+        void Detach(Shard& oShard, GDALProxyPoolCacheEntry* cur);
+        GDALProxyPoolCacheEntry* DetachVictim(Shard& oShard);
+        GDALProxyPoolCacheEntry* DetachVictimFromOtherShards(Shard& oShard);
+        static void CloseAndFree(GDALProxyPoolCacheEntry* cur);
         GDALProxyPoolCacheEntry* _RefDataset(const char* pszFileName,
                                              GDALAccess eAccess,
                                              char** papszOpenOptions,
                                              int bShared,
                                              bool bForceOpen,
                                              const char* pszOwner);
+        void _UnrefDataset(GDALProxyPoolCacheEntry* cacheEntry);
         void _CloseDataset(const char* pszFileName, GDALAccess eAccess);
 
 #ifdef DEBUG_PROXY_POOL
@@ -131,7 +184,10 @@ class GDALDatasetPool
                                                    bool bForceOpen,
                                                    const char* pszOwner);
         static void UnrefDataset(GDALProxyPoolCacheEntry* cacheEntry);
+        static void UnrefDataset(const char* pszFileName, GDALDataset* poDS);
         static void CloseDataset(const char* pszFileName, GDALAccess eAccess);
+        static void GetStatistics(GIntBig* pnHits, GIntBig* pnMisses,
+                                  GIntBig* pnEvictions, int* pnOpenDatasets);
 
         static void PreventDestroy();
         static void ForceDestroy();
@@ -143,6 +199,11 @@ class GDALDatasetPool
 
 GDALDatasetPool::GDALDatasetPool(int maxSizeIn): maxSize(maxSizeIn)
 {
+    for( int i = 0; i < SHARD_COUNT; i++ )
+    {
+        aoShards[i].hMutex = CPLCreateMutex();
+        CPLReleaseMutex(aoShards[i].hMutex);
+    }
 }
 
 /************************************************************************/
@@ -152,23 +213,28 @@ GDALDatasetPool::GDALDatasetPool(int maxSizeIn): maxSize(maxSizeIn)
 GDALDatasetPool::~GDALDatasetPool()
 {
     bInDestruction = true;
-    GDALProxyPoolCacheEntry* cur = firstEntry;
-    GIntBig responsiblePID = GDALGetResponsiblePIDForCurrentThread();
-    while(cur)
+    GIntBig nHits = 0;
+    GIntBig nMisses = 0;
+    GIntBig nEvictions = 0;
+    for( int i = 0; i < SHARD_COUNT; i++ )
     {
-        GDALProxyPoolCacheEntry* next = cur->next;
-        CPLFree(cur->pszFileName);
-        CPLFree(cur->pszOwner);
-        CPLAssert(cur->refCount == 0);
-        if (cur->poDS)
+        GDALProxyPoolCacheEntry* cur = aoShards[i].firstEntry;
+        while(cur)
         {
-            GDALSetResponsiblePIDForCurrentThread(cur->responsiblePID);
-            GDALClose(cur->poDS);
+            GDALProxyPoolCacheEntry* next = cur->next;
+            CPLAssert(cur->refCount == 0);
+            CloseAndFree(cur);
+            cur = next;
         }
-        CPLFree(cur);
-        cur = next;
+        nHits += aoShards[i].nHits;
+        nMisses += aoShards[i].nMisses;
+        nEvictions += aoShards[i].nEvictions;
+        CPLDestroyMutex(aoShards[i].hMutex);
     }
-    GDALSetResponsiblePIDForCurrentThread(responsiblePID);
+    CPLDebug("GDALProxyPool",
+             "Hits: " CPL_FRMT_GIB ", misses: " CPL_FRMT_GIB
+             ", evictions: " CPL_FRMT_GIB,
+             nHits, nMisses, nEvictions);
 }
 
 #ifdef DEBUG_PROXY_POOL
@@ -178,16 +244,19 @@ GDALDatasetPool::~GDALDatasetPool()
 
 void GDALDatasetPool::ShowContent()
 {
-    GDALProxyPoolCacheEntry* cur = firstEntry;
     int i = 0;
-    while(cur)
+    for( int iShard = 0; iShard < SHARD_COUNT; iShard++ )
     {
-        printf("[%d] pszFileName=%s, owner=%s, refCount=%d, responsiblePID=%d\n",/*ok*/
-               i, cur->pszFileName,
-               cur->pszOwner ? cur->pszOwner : "(null)",
-               cur->refCount, (int)cur->responsiblePID);
-        i++;
-        cur = cur->next;
+        GDALProxyPoolCacheEntry* cur = aoShards[iShard].firstEntry;
+        while(cur)
+        {
+            printf("[%d] shard=%d, pszFileName=%s, owner=%s, refCount=%d, responsiblePID=%d\n",/*ok*/
+                   i, iShard, cur->pszFileName,
+                   cur->pszOwner ? cur->pszOwner : "(null)",
+                   cur->refCount, (int)cur->responsiblePID);
+            i++;
+            cur = cur->next;
+        }
     }
 }
 
@@ -197,20 +266,154 @@ void GDALDatasetPool::ShowContent()
 
 void GDALDatasetPool::CheckLinks()
 {
-    GDALProxyPoolCacheEntry* cur = firstEntry;
-    int i = 0;
-    while(cur)
+    int nTotal = 0;
+    for( int iShard = 0; iShard < SHARD_COUNT; iShard++ )
     {
-        CPLAssert(cur == firstEntry || cur->prev->next == cur);
-        CPLAssert(cur == lastEntry || cur->next->prev == cur);
-        ++i;
-        CPLAssert(cur->next != nullptr || cur == lastEntry);
-        cur = cur->next;
+        const Shard& oShard = aoShards[iShard];
+        GDALProxyPoolCacheEntry* cur = oShard.firstEntry;
+        int i = 0;
+        while(cur)
+        {
+            CPLAssert(cur == oShard.firstEntry || cur->prev->next == cur);
+            CPLAssert(cur == oShard.lastEntry || cur->next->prev == cur);
+            ++i;
+            CPLAssert(cur->next != nullptr || cur == oShard.lastEntry);
+            cur = cur->next;
+        }
+        CPLAssert(i == oShard.currentSize);
+        nTotal += i;
     }
-    CPLAssert(i == currentSize);
+    CPLAssert(nTotal == currentSize);
 }
 #endif
 
+/************************************************************************/
+/*                              GetShard()                              */
+/************************************************************************/
+
+GDALDatasetPool::Shard& GDALDatasetPool::GetShard(const char* pszFileName)
+{
+    return aoShards[CPLHashSetHashStr(pszFileName) % SHARD_COUNT];
+}
+
+/************************************************************************/
+/*                            MoveToFront()                             */
+/************************************************************************/
+
+/* Must be called with the mutex of the shard held */
+void GDALDatasetPool::MoveToFront(Shard& oShard, GDALProxyPoolCacheEntry* cur)
+{
+    if (cur == oShard.firstEntry)
+        return;
+    if (cur->next)
+        cur->next->prev = cur->prev;
+    else
+        oShard.lastEntry = cur->prev;
+    cur->prev->next = cur->next;
+    cur->prev = nullptr;
+    oShard.firstEntry->prev = cur;
+    cur->next = oShard.firstEntry;
+    oShard.firstEntry = cur;
+}
+
+/************************************************************************/
+/*                               Detach()                               */
+/************************************************************************/
+
+/* Must be called with the mutex of the shard held */
+void GDALDatasetPool::Detach(Shard& oShard, GDALProxyPoolCacheEntry* cur)
+{
+    if (cur->prev)
+        cur->prev->next = cur->next;
+    else
+        oShard.firstEntry = cur->next;
+    if (cur->next)
+        cur->next->prev = cur->prev;
+    else
+        oShard.lastEntry = cur->prev;
+    cur->prev = nullptr;
+    cur->next = nullptr;
+    oShard.currentSize --;
+    CPLAtomicDec(&currentSize);
+}
+
+/************************************************************************/
+/*                            DetachVictim()                            */
+/************************************************************************/
+
+/* Must be called with the mutex of the shard held. */
+/* Among the least recently used entries that are not in use, pick the */
+/* one that is the cheapest to reopen. */
+GDALProxyPoolCacheEntry* GDALDatasetPool::DetachVictim(Shard& oShard)
+{
+    GDALProxyPoolCacheEntry* victim = nullptr;
+    int nCandidates = 0;
+    for( GDALProxyPoolCacheEntry* cur = oShard.lastEntry;
+         cur != nullptr && nCandidates < EVICTION_CANDIDATES;
+         cur = cur->prev )
+    {
+        if (cur->refCount != 0)
+            continue;
+        nCandidates ++;
+        if (victim == nullptr || cur->dfOpenDuration < victim->dfOpenDuration)
+            victim = cur;
+    }
+    if (victim)
+    {
+        Detach(oShard, victim);
+        oShard.nEvictions ++;
+    }
+    return victim;
+}
+
+/************************************************************************/
+/*                    DetachVictimFromOtherShards()                     */
+/************************************************************************/
+
+/* Must be called without any mutex of the pool held. */
+/* Used when the shard of a new entry has no entry that can be evicted, */
+/* so that the pool only goes over capacity when all its entries are */
+/* in use. The shards are locked one at a time. */
+GDALProxyPoolCacheEntry*
+GDALDatasetPool::DetachVictimFromOtherShards(Shard& oShard)
+{
+    const int iShard = static_cast<int>(&oShard - aoShards);
+    for( int i = 1; i < SHARD_COUNT; i++ )
+    {
+        Shard& oOtherShard = aoShards[(iShard + i) % SHARD_COUNT];
+        CPLMutexHolder oHolder(oOtherShard.hMutex);
+        GDALProxyPoolCacheEntry* victim = DetachVictim(oOtherShard);
+        if (victim)
+            return victim;
+    }
+    return nullptr;
+}
+
+/************************************************************************/
+/*                            CloseAndFree()                            */
+/************************************************************************/
+
+/* Must be called without any mutex of the pool held */
+void GDALDatasetPool::CloseAndFree(GDALProxyPoolCacheEntry* cur)
+{
+    if (cur->poDS)
+    {
+        /* Close by pretending we are the thread that GDALOpen'ed this */
+        /* dataset */
+        GIntBig responsiblePID = GDALGetResponsiblePIDForCurrentThread();
+        GDALSetResponsiblePIDForCurrentThread(cur->responsiblePID);
+
+        nThreadDisableRefCount ++;
+        GDALClose(cur->poDS);
+        nThreadDisableRefCount --;
+
+        GDALSetResponsiblePIDForCurrentThread(responsiblePID);
+    }
+    CPLFree(cur->pszFileName);
+    CPLFree(cur->pszOwner);
+    CPLFree(cur);
+}
+
 /************************************************************************/
 /*                            _RefDataset()                             */
 /************************************************************************/
@@ -225,135 +428,122 @@ GDALProxyPoolCacheEntry* GDALDatasetPool::_RefDataset(const char* pszFileName,
     if( bInDestruction )
         return nullptr;
 
-    GDALProxyPoolCacheEntry* cur = firstEntry;
-    GIntBig responsiblePID = GDALGetResponsiblePIDForCurrentThread();
-    GDALProxyPoolCacheEntry* lastEntryWithZeroRefCount = nullptr;
+    const GIntBig responsiblePID = GDALGetResponsiblePIDForCurrentThread();
+    const GIntBig nThreadId = CPLGetPID();
+    Shard& oShard = GetShard(pszFileName);
+    GDALProxyPoolCacheEntry* cur = nullptr;
+    GDALProxyPoolCacheEntry* victim = nullptr;
+    bool bOverCapacity = false;
 
-    while(cur)
     {
-        GDALProxyPoolCacheEntry* next = cur->next;
-
-        if (strcmp(cur->pszFileName, pszFileName) == 0 &&
-            ((bShared && cur->responsiblePID == responsiblePID &&
-              ((cur->pszOwner == nullptr && pszOwner == nullptr) ||
-                (cur->pszOwner != nullptr && pszOwner != nullptr &&
-                 strcmp(cur->pszOwner, pszOwner) == 0))) ||
-             (!bShared && cur->refCount == 0)) )
+        CPLMutexHolder oHolder(oShard.hMutex);
+
+        for( cur = oShard.firstEntry; cur != nullptr; cur = cur->next )
         {
-            if (cur != firstEntry)
+            if (strcmp(cur->pszFileName, pszFileName) == 0 &&
+                (cur->refCount == 0 || cur->nUserThreadId == nThreadId) &&
+                ((bShared && cur->responsiblePID == responsiblePID &&
+                  ((cur->pszOwner == nullptr && pszOwner == nullptr) ||
+                    (cur->pszOwner != nullptr && pszOwner != nullptr &&
+                     strcmp(cur->pszOwner, pszOwner) == 0))) ||
+                 (!bShared && cur->refCount == 0)) )
             {
-                /* Move to begin */
-                if (cur->next)
-                    cur->next->prev = cur->prev;
-                else
-                    lastEntry = cur->prev;
-                cur->prev->next = cur->next;
-                cur->prev = nullptr;
-                firstEntry->prev = cur;
-                cur->next = firstEntry;
-                firstEntry = cur;
-
+                MoveToFront(oShard, cur);
 #ifdef DEBUG_PROXY_POOL
                 CheckLinks();
 #endif
+                cur->refCount ++;
+                cur->nUserThreadId = nThreadId;
+                oShard.nHits ++;
+                return cur;
             }
-
-            cur->refCount ++;
-            return cur;
         }
 
-        if (cur->refCount == 0)
-            lastEntryWithZeroRefCount = cur;
-
-        cur = next;
-    }
+        if( !bForceOpen )
+            return nullptr;
 
-    if( !bForceOpen )
-        return nullptr;
+        oShard.nMisses ++;
 
-    if (currentSize == maxSize)
-    {
-        if (lastEntryWithZeroRefCount == nullptr)
+        if (CPLAtomicInc(&currentSize) > maxSize)
         {
-            CPLError(CE_Failure, CPLE_AppDefined,
-                     "Too many threads are running for the current value of the dataset pool size (%d).\n"
-                     "or too many proxy datasets are opened in a cascaded way.\n"
-                     "Try increasing GDAL_MAX_DATASET_POOL_SIZE.", maxSize);
-            return nullptr;
+            bOverCapacity = true;
+            victim = DetachVictim(oShard);
         }
 
-        lastEntryWithZeroRefCount->pszFileName[0] = '\0';
-        if (lastEntryWithZeroRefCount->poDS)
-        {
-            /* Close by pretending we are the thread that GDALOpen'ed this */
-            /* dataset */
-            GDALSetResponsiblePIDForCurrentThread(lastEntryWithZeroRefCount->responsiblePID);
-
-            refCountOfDisableRefCount ++;
-            GDALClose(lastEntryWithZeroRefCount->poDS);
-            refCountOfDisableRefCount --;
-
-            lastEntryWithZeroRefCount->poDS = nullptr;
-            GDALSetResponsiblePIDForCurrentThread(responsiblePID);
-        }
-        CPLFree(lastEntryWithZeroRefCount->pszFileName);
-        CPLFree(lastEntryWithZeroRefCount->pszOwner);
-
-        /* Recycle this entry for the to-be-opened dataset and */
-        /* moves it to the top of the list */
-        if (lastEntryWithZeroRefCount->prev)
-            lastEntryWithZeroRefCount->prev->next = lastEntryWithZeroRefCount->next;
-        else {
-            CPLAssert(false);
-        }
-        if (lastEntryWithZeroRefCount->next)
-            lastEntryWithZeroRefCount->next->prev = lastEntryWithZeroRefCount->prev;
+        /* Prepend */
+        cur = static_cast<GDALProxyPoolCacheEntry*>(
+            CPLCalloc(1, sizeof(GDALProxyPoolCacheEntry)));
+        cur->pszFileName = CPLStrdup(pszFileName);
+        cur->pszOwner = (pszOwner) ? CPLStrdup(pszOwner) : nullptr;
+        cur->responsiblePID = responsiblePID;
+        cur->refCount = 1;
+        cur->nUserThreadId = nThreadId;
+        cur->next = oShard.firstEntry;
+        if (oShard.firstEntry)
+            oShard.firstEntry->prev = cur;
         else
-        {
-            CPLAssert(lastEntryWithZeroRefCount == lastEntry);
-            lastEntry->prev->next = nullptr;
-            lastEntry = lastEntry->prev;
-        }
-        lastEntryWithZeroRefCount->prev = nullptr;
-        lastEntryWithZeroRefCount->next = firstEntry;
-        firstEntry->prev = lastEntryWithZeroRefCount;
-        cur = firstEntry = lastEntryWithZeroRefCount;
+            oShard.lastEntry = cur;
+        oShard.firstEntry = cur;
+        oShard.currentSize ++;
 #ifdef DEBUG_PROXY_POOL
         CheckLinks();
 #endif
     }
-    else
+
+    if (bOverCapacity && victim == nullptr)
     {
-        /* Prepend */
-        cur = static_cast<GDALProxyPoolCacheEntry*>(CPLMalloc(sizeof(GDALProxyPoolCacheEntry)));
-        if (lastEntry == nullptr)
-            lastEntry = cur;
-        cur->prev = nullptr;
-        cur->next = firstEntry;
-        if (firstEntry)
-            firstEntry->prev = cur;
-        firstEntry = cur;
-        currentSize ++;
-#ifdef DEBUG_PROXY_POOL
-        CheckLinks();
-#endif
+        victim = DetachVictimFromOtherShards(oShard);
+        if (victim == nullptr && !bOverCapacityWarningEmitted.exchange(true))
+        {
+            CPLDebug("GDALProxyPool",
+                     "All datasets of the pool are in use. "
+                     "Temporarily opening more than %d datasets. "
+                     "You may want to increase GDAL_MAX_DATASET_POOL_SIZE",
+                     maxSize);
+        }
     }
 
-    cur->pszFileName = CPLStrdup(pszFileName);
-    cur->pszOwner = (pszOwner) ? CPLStrdup(pszOwner) : nullptr;
-    cur->responsiblePID = responsiblePID;
-    cur->refCount = 1;
+    /* The entry is in use by this thread, so nobody else will touch it */
+    if (victim)
+        CloseAndFree(victim);
 
-    refCountOfDisableRefCount ++;
+    const auto oStart = std::chrono::steady_clock::now();
+    nThreadDisableRefCount ++;
     int nFlag = ((eAccess == GA_Update) ? GDAL_OF_UPDATE : GDAL_OF_READONLY) | GDAL_OF_RASTER | GDAL_OF_VERBOSE_ERROR;
     CPLConfigOptionSetter oSetter("CPL_ALLOW_VSISTDIN", "NO", true);
-    cur->poDS = GDALDataset::Open( pszFileName, nFlag, nullptr,
-                                            papszOpenOptions, nullptr );
-    refCountOfDisableRefCount --;
+    GDALDataset* poDS = GDALDataset::Open( pszFileName, nFlag, nullptr,
+                                           papszOpenOptions, nullptr );
+    nThreadDisableRefCount --;
+
+    {
+        CPLMutexHolder oHolder(oShard.hMutex);
+        cur->poDS = poDS;
+        cur->dfOpenDuration = std::chrono::duration<double>(
+            std::chrono::steady_clock::now() - oStart).count();
+    }
 
     return cur;
 }
 
+/************************************************************************/
+/*                           _UnrefDataset()                            */
+/************************************************************************/
+
+void GDALDatasetPool::_UnrefDataset(GDALProxyPoolCacheEntry* cacheEntry)
+{
+    Shard& oShard = GetShard(cacheEntry->pszFileName);
+    {
+        CPLMutexHolder oHolder(oShard.hMutex);
+        cacheEntry->refCount --;
+        /* Shrink back the pool if it has been allowed to overflow */
+        if (cacheEntry->refCount != 0 || currentSize <= maxSize)
+            return;
+        Detach(oShard, cacheEntry);
+        oShard.nEvictions ++;
+    }
+    CloseAndFree(cacheEntry);
+}
+
 /************************************************************************/
 /*                       _CloseDataset()                                */
 /************************************************************************/
@@ -361,36 +551,31 @@ GDALProxyPoolCacheEntry* GDALDatasetPool::_RefDataset(const char* pszFileName,
 void GDALDatasetPool::_CloseDataset( const char* pszFileName,
                                      GDALAccess /* eAccess */ )
 {
-    GDALProxyPoolCacheEntry* cur = firstEntry;
-    GIntBig responsiblePID = GDALGetResponsiblePIDForCurrentThread();
+    /* Inner datasets closed by the destructor */
+    if( bInDestruction )
+        return;
 
-    while(cur)
+    /* Several handles may be opened on the same file: close all the */
+    /* idle ones */
+    Shard& oShard = GetShard(pszFileName);
+    std::vector<GDALProxyPoolCacheEntry*> apoToClose;
     {
-        GDALProxyPoolCacheEntry* next = cur->next;
-
-        CPLAssert(cur->pszFileName);
-        if (strcmp(cur->pszFileName, pszFileName) == 0 && cur->refCount == 0 &&
-            cur->poDS != nullptr )
+        CPLMutexHolder oHolder(oShard.hMutex);
+        GDALProxyPoolCacheEntry* cur = oShard.firstEntry;
+        while( cur != nullptr )
         {
-            /* Close by pretending we are the thread that GDALOpen'ed this */
-            /* dataset */
-            GDALSetResponsiblePIDForCurrentThread(cur->responsiblePID);
-
-            refCountOfDisableRefCount ++;
-            GDALClose(cur->poDS);
-            refCountOfDisableRefCount --;
-
-            GDALSetResponsiblePIDForCurrentThread(responsiblePID);
-
-            cur->poDS = nullptr;
-            cur->pszFileName[0] = '\0';
-            CPLFree(cur->pszOwner);
-            cur->pszOwner = nullptr;
-            break;
+            GDALProxyPoolCacheEntry* next = cur->next;
+            if (strcmp(cur->pszFileName, pszFileName) == 0 &&
+                cur->refCount == 0 && cur->poDS != nullptr )
+            {
+                Detach(oShard, cur);
+                apoToClose.push_back(cur);
+            }
+            cur = next;
         }
-
-        cur = next;
     }
+    for( GDALProxyPoolCacheEntry* cur: apoToClose )
+        CloseAndFree(cur);
 }
 
 /************************************************************************/
@@ -402,12 +587,27 @@ void GDALDatasetPool::Ref()
     CPLMutexHolderD( GDALGetphDLMutex() );
     if (singleton == nullptr)
     {
-        int l_maxSize = atoi(CPLGetConfigOption("GDAL_MAX_DATASET_POOL_SIZE", "100"));
+        // With several handles per file, 100 datasets are quickly reached
+        // by multi-threaded readers, so default to a third of the maximum
+        // number of opened files, to leave room for the rest of the process.
+        int nDefaultMaxSize = 100;
+#if HAVE_GETRLIMIT
+        struct rlimit sLimit;
+        if( getrlimit( RLIMIT_NOFILE, &sLimit ) == 0 &&
+            sLimit.rlim_cur != RLIM_INFINITY )
+        {
+            nDefaultMaxSize = static_cast<int>(std::max(
+                static_cast<rlim_t>(100),
+                std::min(static_cast<rlim_t>(1000), sLimit.rlim_cur / 3)));
+        }
+#endif
+        int l_maxSize = atoi(CPLGetConfigOption("GDAL_MAX_DATASET_POOL_SIZE",
+                                    CPLSPrintf("%d", nDefaultMaxSize)));
         if (l_maxSize < 2 || l_maxSize > 1000)
-            l_maxSize = 100;
+            l_maxSize = nDefaultMaxSize;
         singleton = new GDALDatasetPool(l_maxSize);
     }
-    if (singleton->refCountOfDisableRefCount == 0)
+    if (!singleton->bPreventDestroy && nThreadDisableRefCount == 0)
       singleton->refCount++;
 }
 
@@ -417,7 +617,7 @@ void GDALDatasetPool::PreventDestroy()
     CPLMutexHolderD( GDALGetphDLMutex() );
     if (! singleton)
         return;
-    singleton->refCountOfDisableRefCount ++;
+    singleton->bPreventDestroy = true;
 }
 
 /* keep that in sync with gdaldrivermanager.cpp */
@@ -440,7 +640,7 @@ void GDALDatasetPool::Unref()
         CPLAssert(false);
         return;
     }
-    if (singleton->refCountOfDisableRefCount == 0)
+    if (!singleton->bPreventDestroy && nThreadDisableRefCount == 0)
     {
       singleton->refCount--;
       if (singleton->refCount == 0)
@@ -457,8 +657,7 @@ void GDALDatasetPool::ForceDestroy()
     CPLMutexHolderD( GDALGetphDLMutex() );
     if (! singleton)
         return;
-    singleton->refCountOfDisableRefCount --;
-    CPLAssert(singleton->refCountOfDisableRefCount == 0);
+    CPLAssert(singleton->bPreventDestroy);
     singleton->refCount = 0;
     delete singleton;
     singleton = nullptr;
@@ -476,6 +675,8 @@ void GDALDatasetPoolForceDestroy()
 /*                           RefDataset()                               */
 /************************************************************************/
 
+/* The singleton cannot be destroyed while the calling GDALProxyPoolDataset */
+/* holds a reference on it, so no global mutex is needed */
 GDALProxyPoolCacheEntry* GDALDatasetPool::RefDataset(const char* pszFileName,
                                                      GDALAccess eAccess,
                                                      char** papszOpenOptions,
@@ -483,7 +684,6 @@ GDALProxyPoolCacheEntry* GDALDatasetPool::RefDataset(const char* pszFileName,
                                                      bool bForceOpen,
                                                      const char* pszOwner)
 {
-    CPLMutexHolderD( GDALGetphDLMutex() );
     return singleton->_RefDataset(pszFileName, eAccess, papszOpenOptions,
                                   bShared, bForceOpen, pszOwner);
 }
@@ -494,8 +694,33 @@ GDALProxyPoolCacheEntry* GDALDatasetPool::RefDataset(const char* pszFileName,
 
 void GDALDatasetPool::UnrefDataset(GDALProxyPoolCacheEntry* cacheEntry)
 {
-    CPLMutexHolderD( GDALGetphDLMutex() );
-    cacheEntry->refCount --;
+    singleton->_UnrefDataset(cacheEntry);
+}
+
+/* Release the entry of the current thread that holds poDS. The */
+/* GDALProxyPoolDataset may be used by several threads, so it does not */
+/* remember the entries it has referenced. */
+void GDALDatasetPool::UnrefDataset(const char* pszFileName, GDALDataset* poDS)
+{
+    Shard& oShard = singleton->GetShard(pszFileName);
+    const GIntBig nThreadId = CPLGetPID();
+    GDALProxyPoolCacheEntry* cacheEntry = nullptr;
+    {
+        CPLMutexHolder oHolder(oShard.hMutex);
+        for( GDALProxyPoolCacheEntry* cur = oShard.firstEntry;
+             cur != nullptr; cur = cur->next )
+        {
+            if (cur->poDS == poDS && cur->refCount > 0 &&
+                cur->nUserThreadId == nThreadId)
+            {
+                cacheEntry = cur;
+                break;
+            }
+        }
+    }
+    CPLAssert(cacheEntry != nullptr);
+    if (cacheEntry != nullptr)
+        singleton->_UnrefDataset(cacheEntry);
 }
 
 /************************************************************************/
@@ -504,10 +729,43 @@ void GDALDatasetPool::UnrefDataset(GDALProxyPoolCacheEntry* cacheEntry)
 
 void GDALDatasetPool::CloseDataset(const char* pszFileName, GDALAccess eAccess)
 {
-    CPLMutexHolderD( GDALGetphDLMutex() );
     singleton->_CloseDataset(pszFileName, eAccess);
 }
 
+/************************************************************************/
+/*                          GetStatistics()                             */
+/************************************************************************/
+
+void GDALDatasetPool::GetStatistics(GIntBig* pnHits, GIntBig* pnMisses,
+                                    GIntBig* pnEvictions, int* pnOpenDatasets)
+{
+    CPLMutexHolderD( GDALGetphDLMutex() );
+    GIntBig nHits = 0;
+    GIntBig nMisses = 0;
+    GIntBig nEvictions = 0;
+    int nOpenDatasets = 0;
+    if (singleton)
+    {
+        for( int i = 0; i < SHARD_COUNT; i++ )
+        {
+            Shard& oShard = singleton->aoShards[i];
+            CPLMutexHolder oShardHolder(oShard.hMutex);
+            nHits += oShard.nHits;
+            nMisses += oShard.nMisses;
+            nEvictions += oShard.nEvictions;
+            nOpenDatasets += oShard.currentSize;
+        }
+    }
+    if (pnHits)
+        *pnHits = nHits;
+    if (pnMisses)
+        *pnMisses = nMisses;
+    if (pnEvictions)
+        *pnEvictions = nEvictions;
+    if (pnOpenDatasets)
+        *pnOpenDatasets = nOpenDatasets;
+}
+
 struct GetMetadataElt
 {
     char* pszDomain;
@@ -638,7 +896,6 @@ GDALProxyPoolDataset::GDALProxyPoolDataset(const char* pszSourceDatasetDescripti
     pasGCPList = nullptr;
     metadataSet = nullptr;
     metadataItemSet = nullptr;
-    cacheEntry = nullptr;
 }
 
 /************************************************************************/
@@ -716,15 +973,16 @@ GDALDataset* GDALProxyPoolDataset::RefUnderlyingDataset(bool bForceOpen)
     /* a VRT of GeoTIFFs that have associated .aux files */
     GIntBig curResponsiblePID = GDALGetResponsiblePIDForCurrentThread();
     GDALSetResponsiblePIDForCurrentThread(responsiblePID);
-    cacheEntry = GDALDatasetPool::RefDataset(GetDescription(), eAccess, papszOpenOptions,
-                                             GetShared(), bForceOpen, m_pszOwner);
+    GDALProxyPoolCacheEntry* l_cacheEntry =
+        GDALDatasetPool::RefDataset(GetDescription(), eAccess, papszOpenOptions,
+                                    GetShared(), bForceOpen, m_pszOwner);
     GDALSetResponsiblePIDForCurrentThread(curResponsiblePID);
-    if (cacheEntry != nullptr)
+    if (l_cacheEntry != nullptr)
     {
-        if (cacheEntry->poDS != nullptr)
-            return cacheEntry->poDS;
+        if (l_cacheEntry->poDS != nullptr)
+            return l_cacheEntry->poDS;
         else
-            GDALDatasetPool::UnrefDataset(cacheEntry);
+            GDALDatasetPool::UnrefDataset(l_cacheEntry);
     }
     return nullptr;
 }
@@ -734,13 +992,11 @@ GDALDataset* GDALProxyPoolDataset::RefUnderlyingDataset(bool bForceOpen)
 /************************************************************************/
 
 void GDALProxyPoolDataset::UnrefUnderlyingDataset(
-    CPL_UNUSED GDALDataset* poUnderlyingDataset )
+    GDALDataset* poUnderlyingDataset )
 {
-    if (cacheEntry != nullptr)
+    if (poUnderlyingDataset != nullptr)
     {
-        CPLAssert(cacheEntry->poDS == poUnderlyingDataset);
-        if (cacheEntry->poDS != nullptr)
-            GDALDatasetPool::UnrefDataset(cacheEntry);
+        GDALDatasetPool::UnrefDataset(GetDescription(), poUnderlyingDataset);
     }
 }
 
@@ -963,6 +1219,20 @@ void GDALProxyPoolDatasetAddSrcBandDescription( GDALProxyPoolDatasetH hProxyPool
             AddSrcBandDescription(eDataType, nBlockXSize, nBlockYSize);
 }
 
+/************************************************************************/
+/*                     GDALProxyPoolGetStatistics()                     */
+/************************************************************************/
+
+/* Hits and misses are counted for requests to the underlying dataset of a */
+/* GDALProxyPoolDataset. Evictions count the datasets closed to make room */
+/* for other ones. */
+void GDALProxyPoolGetStatistics( GIntBig* pnHits, GIntBig* pnMisses,
+                                 GIntBig* pnEvictions, int* pnOpenDatasets )
+{
+    GDALDatasetPool::GetStatistics(pnHits, pnMisses, pnEvictions,
+                                   pnOpenDatasets);
+}
+
 /* ******************************************************************** */
 /*                    GDALProxyPoolRasterBand()                         */
 /* ******************************************************************** */
@@ -495,6 +495,26 @@ void   CPL_DLL OGR_F_FillUnsetWithDefault( OGRFeatureH hFeat,
                                            char** papszOptions );
 int    CPL_DLL OGR_F_Validate( OGRFeatureH, int nValidateFlags, int bEmitError );
 
+/* OGRFeatureBatch */
+
+/** Opaque type for a batch of features stored by column (OGRFeatureBatch) */
+typedef struct OGRFeatureBatchHS *OGRFeatureBatchH;
+
+OGRFeatureBatchH CPL_DLL OGR_FB_Create( OGRFeatureDefnH );
+void   CPL_DLL OGR_FB_Destroy( OGRFeatureBatchH );
+int    CPL_DLL OGR_FB_GetRowCount( OGRFeatureBatchH );
+const GIntBig CPL_DLL *OGR_FB_GetFIDs( OGRFeatureBatchH );
+const GByte CPL_DLL *OGR_FB_GetFieldValidity( OGRFeatureBatchH, int iField );
+const void CPL_DLL *OGR_FB_GetFieldValues( OGRFeatureBatchH, int iField );
+const size_t CPL_DLL *OGR_FB_GetFieldOffsets( OGRFeatureBatchH, int iField );
+const GByte CPL_DLL *OGR_FB_GetFieldData( OGRFeatureBatchH, int iField );
+const GByte CPL_DLL *OGR_FB_GetGeomFieldValidity( OGRFeatureBatchH,
+                                                  int iGeomField );
+const size_t CPL_DLL *OGR_FB_GetGeomFieldOffsets( OGRFeatureBatchH,
+                                                  int iGeomField );
+const GByte CPL_DLL *OGR_FB_GetGeomFieldData( OGRFeatureBatchH,
+                                              int iGeomField );
+
 /* -------------------------------------------------------------------- */
 /*      ogrsf_frmts.h                                                   */
 /* -------------------------------------------------------------------- */
@@ -528,6 +548,9 @@ void     CPL_DLL OGR_L_SetSpatialFilterRectEx( OGRLayerH, int iGeomField,
 OGRErr CPL_DLL OGR_L_SetAttributeFilter( OGRLayerH, const char * );
 void   CPL_DLL OGR_L_ResetReading( OGRLayerH );
 OGRFeatureH CPL_DLL OGR_L_GetNextFeature( OGRLayerH ) CPL_WARN_UNUSED_RESULT;
+int    CPL_DLL OGR_L_GetNextFeatureBatch( OGRLayerH, OGRFeatureBatchH,
+                                          int nMaxRows );
+int    CPL_DLL OGR_L_FillNextFeature( OGRLayerH, OGRFeatureH );
 
 /*! @endcond */
 
@@ -716,6 +716,7 @@ class CPL_DLL OGRFeature
     OGRErr              SetFrom( const OGRFeature *, int = TRUE );
     OGRErr              SetFrom( const OGRFeature *, const int *, int = TRUE );
     OGRErr              SetFieldsFrom( const OGRFeature *, const int *, int = TRUE );
+    void                SwapContent( OGRFeature *poOtherFeature );
 
 //! @cond Doxygen_Suppress
     OGRErr              RemapFields( OGRFeatureDefn *poNewDefn,
@@ -791,6 +792,93 @@ inline OGRFeature::ConstFieldIterator end(const OGRFeatureUniquePtr& poFeature)
 
 //! @endcond
 
+/************************************************************************/
+/*                            OGRFeatureBatch                           */
+/************************************************************************/
+
+/**
+ * A batch of features of a same layer, stored column by column.
+ *
+ * Each attribute and geometry field is stored as a validity bitmap (bit i,
+ * least significant bit first, is set when the field of row i is set and not
+ * null) and either a fixed width value array or offsets into a data buffer:
+ * <ul>
+ * <li>OFTInteger: int values.</li>
+ * <li>OFTInteger64: GIntBig values.</li>
+ * <li>OFTReal: double values.</li>
+ * <li>OFTDate, OFTTime, OFTDateTime: OGRField values, with the Date member
+ *     set.</li>
+ * <li>OFTString: GetRowCount()+1 offsets into UTF-8 data, without
+ *     nul terminators.</li>
+ * <li>OFTBinary: GetRowCount()+1 offsets into the raw bytes.</li>
+ * <li>OFTIntegerList, OFTInteger64List, OFTRealList: GetRowCount()+1 offsets
+ *     into the packed int, GIntBig or double elements.</li>
+ * <li>OFTStringList: GetRowCount()+1 offsets into the nul terminated
+ *     strings, concatenated.</li>
+ * <li>geometry fields: GetRowCount()+1 offsets into ISO WKB, little
+ *     endian.</li>
+ * </ul>
+ * Offsets are expressed in bytes. Values of invalid rows are undefined, but
+ * their offsets define an empty range.
+ *
+ * A batch is filled by OGRLayer::GetNextFeatureBatch(). The memory of the
+ * batch is kept between calls, so reusing the same batch over a whole layer
+ * performs no allocation once the largest batch has been read.
+ *
+ * @since GDAL 2.4
+ */
+class CPL_DLL OGRFeatureBatch
+{
+    struct Private;
+    std::unique_ptr<Private> m_poPrivate;
+
+    CPL_DISALLOW_COPY_ASSIGN(OGRFeatureBatch)
+
+  public:
+    explicit            OGRFeatureBatch( OGRFeatureDefn *poDefn );
+                        ~OGRFeatureBatch();
+
+    OGRFeatureDefn     *GetDefn() const;
+    void                Reset();
+
+    int                 GetRowCount() const;
+    const GIntBig      *GetFIDs() const;
+
+    const GByte        *GetFieldValidity( int iField ) const;
+    const void         *GetFieldValues( int iField ) const;
+    const size_t       *GetFieldOffsets( int iField ) const;
+    const GByte        *GetFieldData( int iField ) const;
+    bool                IsFieldSetAndNotNull( int iRow, int iField ) const;
+
+    const GByte        *GetGeomFieldValidity( int iGeomField ) const;
+    const size_t       *GetGeomFieldOffsets( int iGeomField ) const;
+    const GByte        *GetGeomFieldData( int iGeomField ) const;
+
+    OGRFeature         *GetFeature( int iRow ) const CPL_WARN_UNUSED_RESULT;
+
+    // Filling methods, used by drivers. They apply to the last added row.
+    int                 AddRow( GIntBig nFID );
+    void                SetFieldInteger( int iField, int nValue );
+    void                SetFieldInteger64( int iField, GIntBig nValue );
+    void                SetFieldDouble( int iField, double dfValue );
+    void                SetFieldString( int iField, const char *pszValue,
+                                        size_t nLen );
+    void                SetFieldString( int iField, const char *pszValue );
+    void                SetFieldBinary( int iField, const GByte *pabyData,
+                                        size_t nLen );
+    void                SetFieldFromString( int iField, const char *pszValue );
+    void                SetFieldDateTime( int iField, int nYear, int nMonth,
+                                          int nDay, int nHour = 0,
+                                          int nMinute = 0, float fSecond = 0.f,
+                                          int nTZFlag = 0 );
+    void                SetFieldRaw( int iField, const OGRField *psValue );
+    void                SetGeometry( int iGeomField,
+                                     const OGRGeometry *poGeom );
+    void                SetGeometryWkb( int iGeomField, const GByte *pabyWkb,
+                                        size_t nLen );
+    void                AddFeature( const OGRFeature *poFeature );
+};
+
 /************************************************************************/
 /*                           OGRFeatureQuery                            */
 /************************************************************************/
@@ -805,6 +893,7 @@ class CPL_DLL OGRFeatureQuery
   private:
     OGRFeatureDefn *poTargetDefn;
     void           *pSWQExpr;
+    void           *pCompiledExpr;
 
     char      **FieldCollector( void *, char ** );
 
@@ -832,6 +921,7 @@ class CPL_DLL OGRFeatureQuery
                          swq_custom_func_registrar*
                          poCustomFuncRegistrar = nullptr );
     int         Evaluate( OGRFeature * );
+    int         EvaluateBatch( const OGRFeatureBatch *, GByte *pabyMatches );
 
     GIntBig    *EvaluateAgainstIndices( OGRLayer *, OGRErr * );
 
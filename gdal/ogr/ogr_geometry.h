@@ -1038,6 +1038,7 @@ class CPL_DLL OGRSimpleCurve: public OGRCurve
     friend class OGRGeometry;
 
     int         nPointCount;
+    int         m_nPointCapacity;
     OGRRawPoint *paoPoints;
     double      *padfZ;
     double      *padfM;
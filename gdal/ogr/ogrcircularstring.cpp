@@ -543,7 +543,18 @@ void OGRCircularString::segmentize( double dfMaxLength )
     // Is there actually something to modify?
     if( nPointCount < static_cast<int>(aoRawPoint.size()) )
     {
+        const int nOldPointCount = nPointCount;
         nPointCount = static_cast<int>(aoRawPoint.size());
+        m_nPointCapacity = nPointCount;
+        // M is not interpolated, but its array must be as large as the
+        // point array.
+        if( padfM )
+        {
+            padfM = static_cast<double *>(
+                CPLRealloc(padfM, sizeof(double) * nPointCount));
+            memset(padfM + nOldPointCount, 0,
+                   sizeof(double) * (nPointCount - nOldPointCount));
+        }
         paoPoints = static_cast<OGRRawPoint *>(
                 CPLRealloc(paoPoints, sizeof(OGRRawPoint) * nPointCount));
         memcpy(paoPoints, &aoRawPoint[0], sizeof(OGRRawPoint) * nPointCount);
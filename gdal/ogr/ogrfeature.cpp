@@ -41,6 +41,7 @@
 #include <limits>
 #include <map>
 #include <new>
+#include <utility>
 #include <vector>
 
 #include "cpl_conv.h"
@@ -3879,10 +3880,25 @@ void OGRFeature::SetField( int iField, const char * pszValue )
     OGRFieldType eType = poFDefn->GetType();
     if( eType == OFTString )
     {
+        if( pszValue == nullptr )
+            pszValue = "";
         if( IsFieldSetAndNotNull(iField) )
-            CPLFree( pauFields[iField].String );
+        {
+            // Reuse the current buffer when it is large enough, which
+            // spares an allocation when a feature is refilled in place.
+            char* pszOld = pauFields[iField].String;
+            if( pszOld == pszValue )
+                return;
+            const size_t nLen = strlen(pszValue);
+            if( strlen(pszOld) >= nLen )
+            {
+                memmove( pszOld, pszValue, nLen + 1 );
+                return;
+            }
+            CPLFree( pszOld );
+        }
 
-        pauFields[iField].String = VSI_STRDUP_VERBOSE(pszValue ? pszValue : "");
+        pauFields[iField].String = VSI_STRDUP_VERBOSE(pszValue);
         if( pauFields[iField].String == nullptr )
         {
             OGR_RawField_SetUnset(&pauFields[iField]);
@@ -5706,6 +5722,37 @@ int OGR_F_Equal( OGRFeatureH hFeat, OGRFeatureH hOtherFeat )
         Equal( OGRFeature::FromHandle(hOtherFeat) );
 }
 
+/************************************************************************/
+/*                            SwapContent()                             */
+/************************************************************************/
+
+/**
+ * \brief Exchange the content of two features.
+ *
+ * The FID, field values, geometries, style string and native data of this
+ * feature and of poOtherFeature are exchanged, without any copy. Both
+ * features must share the same OGRFeatureDefn.
+ *
+ * @param poOtherFeature the feature whose content is exchanged with this one.
+ *
+ * @since GDAL 2.4
+ */
+
+void OGRFeature::SwapContent( OGRFeature *poOtherFeature )
+
+{
+    CPLAssert( poOtherFeature->poDefn == poDefn );
+
+    std::swap( nFID, poOtherFeature->nFID );
+    std::swap( papoGeometries, poOtherFeature->papoGeometries );
+    std::swap( pauFields, poOtherFeature->pauFields );
+    std::swap( m_pszNativeData, poOtherFeature->m_pszNativeData );
+    std::swap( m_pszNativeMediaType, poOtherFeature->m_pszNativeMediaType );
+    std::swap( m_pszStyleString, poOtherFeature->m_pszStyleString );
+    std::swap( m_poStyleTable, poOtherFeature->m_poStyleTable );
+    std::swap( m_pszTmpFieldValue, poOtherFeature->m_pszTmpFieldValue );
+}
+
 /************************************************************************/
 /*                              SetFrom()                               */
 /************************************************************************/
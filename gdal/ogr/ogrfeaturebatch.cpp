@@ -0,0 +1,1044 @@
+/******************************************************************************
+ *
+ * Project:  OpenGIS Simple Features Reference Implementation
+ * Purpose:  The OGRFeatureBatch class implementation.
+ *
+ ******************************************************************************
+ * Copyright (c) 2018, GDAL contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ ****************************************************************************/
+
+#include "cpl_port.h"
+#include "ogr_api.h"
+#include "ogr_feature.h"
+
+#include <cstring>
+
+#include <string>
+#include <vector>
+
+#include "cpl_conv.h"
+#include "cpl_error.h"
+#include "cpl_string.h"
+#include "ogr_core.h"
+#include "ogr_geometry.h"
+
+CPL_CVSID("$Id$")
+
+/************************************************************************/
+/*                       OGRFeatureBatch::Private                       */
+/************************************************************************/
+
+namespace {
+
+struct OGRFeatureBatchColumn
+{
+    OGRFieldType        eType = OFTString;
+    size_t              nValueSize = 0;     // 0 for variable width columns
+    std::vector<GByte>  abyValidity{};
+    std::vector<GByte>  abyValues{};
+    std::vector<size_t> anOffsets{};
+    std::vector<GByte>  abyData{};
+
+    void Reset()
+    {
+        abyValidity.clear();
+        abyValues.clear();
+        anOffsets.clear();
+        if( nValueSize == 0 )
+            anOffsets.push_back(0);
+        abyData.clear();
+    }
+
+    void AddRow( int nRows )
+    {
+        const size_t nBytes = (static_cast<size_t>(nRows) + 7) / 8;
+        if( abyValidity.size() < nBytes )
+            abyValidity.push_back(0);
+        if( nValueSize )
+            abyValues.resize(abyValues.size() + nValueSize);
+        else
+            anOffsets.push_back(abyData.size());
+    }
+
+    void SetValid( int iRow, bool bValid )
+    {
+        if( bValid )
+            abyValidity[iRow / 8] |= static_cast<GByte>(1 << (iRow % 8));
+        else
+            abyValidity[iRow / 8] &= static_cast<GByte>(~(1 << (iRow % 8)));
+    }
+
+    // Makes room for nLen bytes of the variable width value of the last row,
+    // replacing any previous value of that row.
+    GByte* ReserveData( int iRow, size_t nLen )
+    {
+        const size_t nStart = anOffsets[iRow];
+        abyData.resize(nStart + nLen);
+        anOffsets[iRow + 1] = nStart + nLen;
+        SetValid(iRow, true);
+        return abyData.data() + nStart;
+    }
+
+    void SetData( int iRow, const void* pData, size_t nLen )
+    {
+        GByte* pabyDst = ReserveData(iRow, nLen);
+        if( nLen )
+            memcpy(pabyDst, pData, nLen);
+    }
+
+    void SetValue( int iRow, const void* pValue )
+    {
+        memcpy(abyValues.data() + static_cast<size_t>(iRow) * nValueSize,
+               pValue, nValueSize);
+        SetValid(iRow, true);
+    }
+
+    void SetInvalid( int iRow )
+    {
+        SetValid(iRow, false);
+        if( nValueSize == 0 )
+        {
+            abyData.resize(anOffsets[iRow]);
+            anOffsets[iRow + 1] = anOffsets[iRow];
+        }
+    }
+};
+
+static size_t GetValueSize( OGRFieldType eType )
+{
+    switch( eType )
+    {
+        case OFTInteger: return sizeof(int);
+        case OFTInteger64: return sizeof(GIntBig);
+        case OFTReal: return sizeof(double);
+        case OFTDate:
+        case OFTTime:
+        case OFTDateTime: return sizeof(OGRField);
+        default: break;
+    }
+    return 0;
+}
+
+} // namespace
+
+struct OGRFeatureBatch::Private
+{
+    OGRFeatureDefn                     *poDefn = nullptr;
+    int                                 nRows = 0;
+    std::vector<GIntBig>                anFIDs{};
+    std::vector<OGRFeatureBatchColumn>  aoFields{};
+    std::vector<OGRFeatureBatchColumn>  aoGeomFields{};
+
+    // Used to convert values with the exact semantics of the OGRFeature
+    // setters, when the value does not match the type of the field.
+    std::unique_ptr<OGRFeature>         poScratchFeature{};
+
+    OGRFeature* GetScratchFeature()
+    {
+        if( !poScratchFeature )
+            poScratchFeature.reset(new OGRFeature(poDefn));
+        return poScratchFeature.get();
+    }
+};
+
+/************************************************************************/
+/*                          OGRFeatureBatch()                           */
+/************************************************************************/
+
+/**
+ * \brief Constructor.
+ *
+ * The batch increments the reference count of its feature definition.
+ *
+ * This method is the same as the C function OGR_FB_Create().
+ *
+ * @param poDefn feature definition of the layer the batch will be filled
+ * from.
+ * @since GDAL 2.4
+ */
+
+OGRFeatureBatch::OGRFeatureBatch( OGRFeatureDefn *poDefn ) :
+    m_poPrivate(new Private())
+{
+    m_poPrivate->poDefn = poDefn;
+    poDefn->Reference();
+    Reset();
+}
+
+/************************************************************************/
+/*                          ~OGRFeatureBatch()                          */
+/************************************************************************/
+
+OGRFeatureBatch::~OGRFeatureBatch()
+{
+    m_poPrivate->poScratchFeature.reset();
+    m_poPrivate->poDefn->Release();
+}
+
+/************************************************************************/
+/*                              GetDefn()                               */
+/************************************************************************/
+
+/** \brief Return the feature definition of the batch.
+ * @since GDAL 2.4
+ */
+OGRFeatureDefn *OGRFeatureBatch::GetDefn() const
+{
+    return m_poPrivate->poDefn;
+}
+
+/************************************************************************/
+/*                               Reset()                                */
+/************************************************************************/
+
+/** \brief Remove all rows, but keep the allocated memory.
+ *
+ * Fields added to the feature definition since the previous call are taken
+ * into account.
+ * @since GDAL 2.4
+ */
+void OGRFeatureBatch::Reset()
+{
+    OGRFeatureDefn* poDefn = m_poPrivate->poDefn;
+    m_poPrivate->aoFields.resize(poDefn->GetFieldCount());
+    for( int i = 0; i < poDefn->GetFieldCount(); i++ )
+    {
+        OGRFeatureBatchColumn& oCol = m_poPrivate->aoFields[i];
+        oCol.eType = poDefn->GetFieldDefn(i)->GetType();
+        oCol.nValueSize = GetValueSize(oCol.eType);
+    }
+    m_poPrivate->aoGeomFields.resize(poDefn->GetGeomFieldCount());
+    if( m_poPrivate->poScratchFeature &&
+        m_poPrivate->poScratchFeature->GetFieldCount() !=
+                                                poDefn->GetFieldCount() )
+    {
+        m_poPrivate->poScratchFeature.reset();
+    }
+
+    m_poPrivate->nRows = 0;
+    m_poPrivate->anFIDs.clear();
+    for( auto& oCol : m_poPrivate->aoFields )
+        oCol.Reset();
+    for( auto& oCol : m_poPrivate->aoGeomFields )
+        oCol.Reset();
+}
+
+/************************************************************************/
+/*                            GetRowCount()                             */
+/************************************************************************/
+
+/** \brief Return the number of rows of the batch.
+ *
+ * This method is the same as the C function OGR_FB_GetRowCount().
+ * @since GDAL 2.4
+ */
+int OGRFeatureBatch::GetRowCount() const
+{
+    return m_poPrivate->nRows;
+}
+
+/************************************************************************/
+/*                              GetFIDs()                               */
+/************************************************************************/
+
+/** \brief Return the array of the GetRowCount() feature ids.
+ *
+ * This method is the same as the C function OGR_FB_GetFIDs().
+ * @since GDAL 2.4
+ */
+const GIntBig *OGRFeatureBatch::GetFIDs() const
+{
+    return m_poPrivate->anFIDs.data();
+}
+
+/************************************************************************/
+/*                          GetFieldValidity()                          */
+/************************************************************************/
+
+/** \brief Return the validity bitmap of an attribute field.
+ *
+ * This method is the same as the C function OGR_FB_GetFieldValidity().
+ *
+ * @param iField field index, between 0 and GetDefn()->GetFieldCount() - 1.
+ * @return (GetRowCount() + 7) / 8 bytes.
+ * @since GDAL 2.4
+ */
+const GByte *OGRFeatureBatch::GetFieldValidity( int iField ) const
+{
+    return m_poPrivate->aoFields[iField].abyValidity.data();
+}
+
+/************************************************************************/
+/*                           GetFieldValues()                           */
+/************************************************************************/
+
+/** \brief Return the values of a fixed width attribute field.
+ *
+ * This method is the same as the C function OGR_FB_GetFieldValues().
+ *
+ * @param iField field index, between 0 and GetDefn()->GetFieldCount() - 1.
+ * @return GetRowCount() values, or NULL for variable width fields.
+ * @since GDAL 2.4
+ */
+const void *OGRFeatureBatch::GetFieldValues( int iField ) const
+{
+    const OGRFeatureBatchColumn& oCol = m_poPrivate->aoFields[iField];
+    return oCol.nValueSize ? oCol.abyValues.data() : nullptr;
+}
+
+/************************************************************************/
+/*                          GetFieldOffsets()                           */
+/************************************************************************/
+
+/** \brief Return the offsets of a variable width attribute field.
+ *
+ * The value of row i is made of the bytes between GetFieldData(iField) +
+ * offsets[i] and GetFieldData(iField) + offsets[i+1].
+ *
+ * This method is the same as the C function OGR_FB_GetFieldOffsets().
+ *
+ * @param iField field index, between 0 and GetDefn()->GetFieldCount() - 1.
+ * @return GetRowCount() + 1 offsets, or NULL for fixed width fields.
+ * @since GDAL 2.4
+ */
+const size_t *OGRFeatureBatch::GetFieldOffsets( int iField ) const
+{
+    const OGRFeatureBatchColumn& oCol = m_poPrivate->aoFields[iField];
+    return oCol.nValueSize ? nullptr : oCol.anOffsets.data();
+}
+
+/************************************************************************/
+/*                            GetFieldData()                            */
+/************************************************************************/
+
+/** \brief Return the data buffer of a variable width attribute field.
+ *
+ * This method is the same as the C function OGR_FB_GetFieldData().
+ *
+ * @param iField field index, between 0 and GetDefn()->GetFieldCount() - 1.
+ * @since GDAL 2.4
+ */
+const GByte *OGRFeatureBatch::GetFieldData( int iField ) const
+{
+    return m_poPrivate->aoFields[iField].abyData.data();
+}
+
+/************************************************************************/
+/*                        IsFieldSetAndNotNull()                        */
+/************************************************************************/
+
+/** \brief Test the validity bit of a field of a row.
+ * @since GDAL 2.4
+ */
+bool OGRFeatureBatch::IsFieldSetAndNotNull( int iRow, int iField ) const
+{
+    return (m_poPrivate->aoFields[iField].abyValidity[iRow / 8] &
+            (1 << (iRow % 8))) != 0;
+}
+
+/************************************************************************/
+/*                        GetGeomFieldValidity()                        */
+/************************************************************************/
+
+/** \brief Return the validity bitmap of a geometry field.
+ *
+ * This method is the same as the C function OGR_FB_GetGeomFieldValidity().
+ * @since GDAL 2.4
+ */
+const GByte *OGRFeatureBatch::GetGeomFieldValidity( int iGeomField ) const
+{
+    return m_poPrivate->aoGeomFields[iGeomField].abyValidity.data();
+}
+
+/************************************************************************/
+/*                        GetGeomFieldOffsets()                         */
+/************************************************************************/
+
+/** \brief Return the GetRowCount() + 1 offsets of the WKB geometries of a
+ * geometry field.
+ *
+ * This method is the same as the C function OGR_FB_GetGeomFieldOffsets().
+ * @since GDAL 2.4
+ */
+const size_t *OGRFeatureBatch::GetGeomFieldOffsets( int iGeomField ) const
+{
+    return m_poPrivate->aoGeomFields[iGeomField].anOffsets.data();
+}
+
+/************************************************************************/
+/*                          GetGeomFieldData()                          */
+/************************************************************************/
+
+/** \brief Return the WKB buffer of a geometry field.
+ *
+ * This method is the same as the C function OGR_FB_GetGeomFieldData().
+ * @since GDAL 2.4
+ */
+const GByte *OGRFeatureBatch::GetGeomFieldData( int iGeomField ) const
+{
+    return m_poPrivate->aoGeomFields[iGeomField].abyData.data();
+}
+
+/************************************************************************/
+/*                             GetFeature()                             */
+/************************************************************************/
+
+/** \brief Build a feature from a row of the batch.
+ *
+ * Fields that are not valid in the batch are left unset in the feature.
+ *
+ * @param iRow row index, between 0 and GetRowCount() - 1.
+ * @return a new feature, to free with delete, or NULL if iRow is invalid.
+ * @since GDAL 2.4
+ */
+OGRFeature *OGRFeatureBatch::GetFeature( int iRow ) const
+{
+    if( iRow < 0 || iRow >= m_poPrivate->nRows )
+        return nullptr;
+
+    OGRFeatureDefn* poDefn = m_poPrivate->poDefn;
+    OGRFeature* poFeature = new OGRFeature(poDefn);
+    poFeature->SetFID(m_poPrivate->anFIDs[iRow]);
+
+    for( int iField = 0; iField < poDefn->GetFieldCount(); iField++ )
+    {
+        if( !IsFieldSetAndNotNull(iRow, iField) )
+            continue;
+        const OGRFeatureBatchColumn& oCol = m_poPrivate->aoFields[iField];
+        const GByte* pabyValue = oCol.nValueSize ?
+            oCol.abyValues.data() + static_cast<size_t>(iRow) * oCol.nValueSize :
+            oCol.abyData.data() + oCol.anOffsets[iRow];
+        const size_t nLen = oCol.nValueSize ? oCol.nValueSize :
+            oCol.anOffsets[iRow + 1] - oCol.anOffsets[iRow];
+
+        OGRField sField;
+        switch( oCol.eType )
+        {
+            case OFTInteger:
+                memcpy(&sField.Integer, pabyValue, sizeof(int));
+                sField.Set.nMarker2 = 0;
+                sField.Set.nMarker3 = 0;
+                break;
+            case OFTInteger64:
+                memcpy(&sField.Integer64, pabyValue, sizeof(GIntBig));
+                sField.Set.nMarker3 = 0;
+                break;
+            case OFTReal:
+                memcpy(&sField.Real, pabyValue, sizeof(double));
+                break;
+            case OFTDate:
+            case OFTTime:
+            case OFTDateTime:
+                memcpy(&sField, pabyValue, sizeof(OGRField));
+                break;
+            case OFTString:
+            {
+                std::string osValue(reinterpret_cast<const char*>(pabyValue),
+                                    nLen);
+                poFeature->SetField(iField, osValue.c_str());
+                continue;
+            }
+            case OFTBinary:
+                sField.Binary.nCount = static_cast<int>(nLen);
+                sField.Binary.paData = const_cast<GByte*>(pabyValue);
+                break;
+            case OFTIntegerList:
+                sField.IntegerList.nCount =
+                    static_cast<int>(nLen / sizeof(int));
+                sField.IntegerList.paList =
+                    reinterpret_cast<int*>(const_cast<GByte*>(pabyValue));
+                break;
+            case OFTInteger64List:
+                sField.Integer64List.nCount =
+                    static_cast<int>(nLen / sizeof(GIntBig));
+                sField.Integer64List.paList =
+                    reinterpret_cast<GIntBig*>(const_cast<GByte*>(pabyValue));
+                break;
+            case OFTRealList:
+                sField.RealList.nCount =
+                    static_cast<int>(nLen / sizeof(double));
+                sField.RealList.paList =
+                    reinterpret_cast<double*>(const_cast<GByte*>(pabyValue));
+                break;
+            case OFTStringList:
+            {
+                CPLStringList aosList;
+                size_t nPos = 0;
+                while( nPos < nLen )
+                {
+                    const char* pszItem =
+                        reinterpret_cast<const char*>(pabyValue) + nPos;
+                    aosList.AddString(pszItem);
+                    nPos += strlen(pszItem) + 1;
+                }
+                poFeature->SetField(iField, aosList.List());
+                continue;
+            }
+            default:
+                continue;
+        }
+        poFeature->SetField(iField, &sField);
+    }
+
+    for( int iGeom = 0; iGeom < poDefn->GetGeomFieldCount(); iGeom++ )
+    {
+        const OGRFeatureBatchColumn& oCol = m_poPrivate->aoGeomFields[iGeom];
+        if( (oCol.abyValidity[iRow / 8] & (1 << (iRow % 8))) == 0 )
+            continue;
+        OGRGeometry* poGeom = nullptr;
+        OGRGeometryFactory::createFromWkb(
+            oCol.abyData.data() + oCol.anOffsets[iRow],
+            poDefn->GetGeomFieldDefn(iGeom)->GetSpatialRef(), &poGeom,
+            static_cast<int>(oCol.anOffsets[iRow + 1] - oCol.anOffsets[iRow]));
+        poFeature->SetGeomFieldDirectly(iGeom, poGeom);
+    }
+
+    return poFeature;
+}
+
+/************************************************************************/
+/*                               AddRow()                               */
+/************************************************************************/
+
+/** \brief Append a row, with all its fields invalid.
+ *
+ * @param nFID feature id of the row.
+ * @return the index of the new row.
+ * @since GDAL 2.4
+ */
+int OGRFeatureBatch::AddRow( GIntBig nFID )
+{
+    const int iRow = m_poPrivate->nRows++;
+    m_poPrivate->anFIDs.push_back(nFID);
+    for( auto& oCol : m_poPrivate->aoFields )
+    {
+        oCol.AddRow(m_poPrivate->nRows);
+        oCol.SetValid(iRow, false);
+    }
+    for( auto& oCol : m_poPrivate->aoGeomFields )
+    {
+        oCol.AddRow(m_poPrivate->nRows);
+        oCol.SetValid(iRow, false);
+    }
+    return iRow;
+}
+
+/************************************************************************/
+/*                          SetFieldInteger()                           */
+/************************************************************************/
+
+/** \brief Set an integer value in the last row.
+ *
+ * As all the SetFieldXXX() methods, values that do not match the type of
+ * the field are converted as the corresponding OGRFeature::SetField() method
+ * does.
+ * @since GDAL 2.4
+ */
+void OGRFeatureBatch::SetFieldInteger( int iField, int nValue )
+{
+    OGRFeatureBatchColumn& oCol = m_poPrivate->aoFields[iField];
+    if( oCol.eType == OFTInteger &&
+        m_poPrivate->poDefn->GetFieldDefn(iField)->GetSubType() == OFSTNone )
+    {
+        oCol.SetValue(m_poPrivate->nRows - 1, &nValue);
+        return;
+    }
+    OGRFeature* poScratch = m_poPrivate->GetScratchFeature();
+    poScratch->SetField(iField, nValue);
+    SetFieldRaw(iField, poScratch->GetRawFieldRef(iField));
+    poScratch->UnsetField(iField);
+}
+
+/************************************************************************/
+/*                         SetFieldInteger64()                          */
+/************************************************************************/
+
+/** \brief Set a 64 bit integer value in the last row.
+ * @since GDAL 2.4
+ */
+void OGRFeatureBatch::SetFieldInteger64( int iField, GIntBig nValue )
+{
+    OGRFeatureBatchColumn& oCol = m_poPrivate->aoFields[iField];
+    if( oCol.eType == OFTInteger64 )
+    {
+        oCol.SetValue(m_poPrivate->nRows - 1, &nValue);
+        return;
+    }
+    OGRFeature* poScratch = m_poPrivate->GetScratchFeature();
+    poScratch->SetField(iField, nValue);
+    SetFieldRaw(iField, poScratch->GetRawFieldRef(iField));
+    poScratch->UnsetField(iField);
+}
+
+/************************************************************************/
+/*                           SetFieldDouble()                           */
+/************************************************************************/
+
+/** \brief Set a double value in the last row.
+ * @since GDAL 2.4
+ */
+void OGRFeatureBatch::SetFieldDouble( int iField, double dfValue )
+{
+    OGRFeatureBatchColumn& oCol = m_poPrivate->aoFields[iField];
+    if( oCol.eType == OFTReal )
+    {
+        oCol.SetValue(m_poPrivate->nRows - 1, &dfValue);
+        return;
+    }
+    OGRFeature* poScratch = m_poPrivate->GetScratchFeature();
+    poScratch->SetField(iField, dfValue);
+    SetFieldRaw(iField, poScratch->GetRawFieldRef(iField));
+    poScratch->UnsetField(iField);
+}
+
+/************************************************************************/
+/*                           SetFieldString()                           */
+/************************************************************************/
+
+/** \brief Set a string value of nLen bytes in the last row.
+ *
+ * For non string fields, the value is parsed as
+ * OGRFeature::SetField(int, const char*) does.
+ * @since GDAL 2.4
+ */
+void OGRFeatureBatch::SetFieldString( int iField, const char *pszValue,
+                                      size_t nLen )
+{
+    OGRFeatureBatchColumn& oCol = m_poPrivate->aoFields[iField];
+    if( oCol.eType == OFTString )
+    {
+        oCol.SetData(m_poPrivate->nRows - 1, pszValue, nLen);
+        return;
+    }
+    const std::string osValue(pszValue, nLen);
+    SetFieldFromString(iField, osValue.c_str());
+}
+
+/** \brief Set a nul terminated string value in the last row.
+ * @since GDAL 2.4
+ */
+void OGRFeatureBatch::SetFieldString( int iField, const char *pszValue )
+{
+    SetFieldFromString(iField, pszValue);
+}
+
+/************************************************************************/
+/*                         SetFieldFromString()                         */
+/************************************************************************/
+
+/** \brief Set a nul terminated string value in the last row, parsed
+ * according to the field type as OGRFeature::SetField(int, const char*)
+ * does.
+ * @since GDAL 2.4
+ */
+void OGRFeatureBatch::SetFieldFromString( int iField, const char *pszValue )
+{
+    OGRFeatureBatchColumn& oCol = m_poPrivate->aoFields[iField];
+    if( oCol.eType == OFTString )
+    {
+        oCol.SetData(m_poPrivate->nRows - 1, pszValue, strlen(pszValue));
+        return;
+    }
+    OGRFeature* poScratch = m_poPrivate->GetScratchFeature();
+    poScratch->SetField(iField, pszValue);
+    SetFieldRaw(iField, poScratch->GetRawFieldRef(iField));
+    poScratch->UnsetField(iField);
+}
+
+/************************************************************************/
+/*                          SetFieldDateTime()                          */
+/************************************************************************/
+
+/** \brief Set a date and time value in the last row.
+ * @since GDAL 2.4
+ */
+void OGRFeatureBatch::SetFieldDateTime( int iField, int nYear, int nMonth,
+                                        int nDay, int nHour, int nMinute,
+                                        float fSecond, int nTZFlag )
+{
+    OGRFeatureBatchColumn& oCol = m_poPrivate->aoFields[iField];
+    if( oCol.nValueSize == sizeof(OGRField) &&
+        static_cast<GInt16>(nYear) == nYear )
+    {
+        OGRField sField;
+        memset(&sField, 0, sizeof(sField));
+        sField.Date.Year = static_cast<GInt16>(nYear);
+        sField.Date.Month = static_cast<GByte>(nMonth);
+        sField.Date.Day = static_cast<GByte>(nDay);
+        sField.Date.Hour = static_cast<GByte>(nHour);
+        sField.Date.Minute = static_cast<GByte>(nMinute);
+        sField.Date.Second = fSecond;
+        sField.Date.TZFlag = static_cast<GByte>(nTZFlag);
+        oCol.SetValue(m_poPrivate->nRows - 1, &sField);
+        return;
+    }
+    OGRFeature* poScratch = m_poPrivate->GetScratchFeature();
+    poScratch->SetField(iField, nYear, nMonth, nDay, nHour, nMinute, fSecond,
+                        nTZFlag);
+    SetFieldRaw(iField, poScratch->GetRawFieldRef(iField));
+    poScratch->UnsetField(iField);
+}
+
+/************************************************************************/
+/*                           SetFieldBinary()                           */
+/************************************************************************/
+
+/** \brief Set a binary value in the last row.
+ * @since GDAL 2.4
+ */
+void OGRFeatureBatch::SetFieldBinary( int iField, const GByte *pabyData,
+                                      size_t nLen )
+{
+    OGRFeatureBatchColumn& oCol = m_poPrivate->aoFields[iField];
+    if( oCol.eType == OFTBinary )
+    {
+        oCol.SetData(m_poPrivate->nRows - 1, pabyData, nLen);
+        return;
+    }
+    OGRFeature* poScratch = m_poPrivate->GetScratchFeature();
+    poScratch->SetField(iField, static_cast<int>(nLen),
+                        const_cast<GByte*>(pabyData));
+    SetFieldRaw(iField, poScratch->GetRawFieldRef(iField));
+    poScratch->UnsetField(iField);
+}
+
+/************************************************************************/
+/*                            SetFieldRaw()                             */
+/************************************************************************/
+
+/** \brief Set a value in the last row from a OGRField whose active member
+ * matches the field type, as returned by OGRFeature::GetRawFieldRef().
+ *
+ * Unset and null values make the field invalid.
+ * @since GDAL 2.4
+ */
+void OGRFeatureBatch::SetFieldRaw( int iField, const OGRField *psValue )
+{
+    OGRFeatureBatchColumn& oCol = m_poPrivate->aoFields[iField];
+    const int iRow = m_poPrivate->nRows - 1;
+    if( OGR_RawField_IsUnset(psValue) || OGR_RawField_IsNull(psValue) )
+    {
+        oCol.SetInvalid(iRow);
+        return;
+    }
+    switch( oCol.eType )
+    {
+        case OFTInteger:
+            oCol.SetValue(iRow, &psValue->Integer);
+            break;
+        case OFTInteger64:
+            oCol.SetValue(iRow, &psValue->Integer64);
+            break;
+        case OFTReal:
+            oCol.SetValue(iRow, &psValue->Real);
+            break;
+        case OFTDate:
+        case OFTTime:
+        case OFTDateTime:
+            oCol.SetValue(iRow, psValue);
+            break;
+        case OFTString:
+            oCol.SetData(iRow, psValue->String, strlen(psValue->String));
+            break;
+        case OFTBinary:
+            oCol.SetData(iRow, psValue->Binary.paData,
+                         psValue->Binary.nCount);
+            break;
+        case OFTIntegerList:
+            oCol.SetData(iRow, psValue->IntegerList.paList,
+                         psValue->IntegerList.nCount * sizeof(int));
+            break;
+        case OFTInteger64List:
+            oCol.SetData(iRow, psValue->Integer64List.paList,
+                         psValue->Integer64List.nCount * sizeof(GIntBig));
+            break;
+        case OFTRealList:
+            oCol.SetData(iRow, psValue->RealList.paList,
+                         psValue->RealList.nCount * sizeof(double));
+            break;
+        case OFTStringList:
+        {
+            size_t nLen = 0;
+            for( int i = 0; i < psValue->StringList.nCount; i++ )
+                nLen += strlen(psValue->StringList.paList[i]) + 1;
+            GByte* pabyDst = oCol.ReserveData(iRow, nLen);
+            for( int i = 0; i < psValue->StringList.nCount; i++ )
+            {
+                const size_t nItemLen =
+                    strlen(psValue->StringList.paList[i]) + 1;
+                memcpy(pabyDst, psValue->StringList.paList[i], nItemLen);
+                pabyDst += nItemLen;
+            }
+            break;
+        }
+        default:
+            break;
+    }
+}
+
+/************************************************************************/
+/*                            SetGeometry()                             */
+/************************************************************************/
+
+/** \brief Set the geometry of a geometry field of the last row, converted
+ * to ISO WKB. A NULL geometry makes the field invalid.
+ * @since GDAL 2.4
+ */
+void OGRFeatureBatch::SetGeometry( int iGeomField, const OGRGeometry *poGeom )
+{
+    OGRFeatureBatchColumn& oCol = m_poPrivate->aoGeomFields[iGeomField];
+    const int iRow = m_poPrivate->nRows - 1;
+    if( poGeom == nullptr )
+    {
+        oCol.SetInvalid(iRow);
+        return;
+    }
+    GByte* pabyWkb = oCol.ReserveData(iRow, poGeom->WkbSize());
+    poGeom->exportToWkb(wkbNDR, pabyWkb, wkbVariantIso);
+}
+
+/************************************************************************/
+/*                           SetGeometryWkb()                           */
+/************************************************************************/
+
+/** \brief Set the geometry of a geometry field of the last row, from a
+ * geometry already encoded as little endian ISO WKB.
+ * @since GDAL 2.4
+ */
+void OGRFeatureBatch::SetGeometryWkb( int iGeomField, const GByte *pabyWkb,
+                                      size_t nLen )
+{
+    m_poPrivate->aoGeomFields[iGeomField].SetData(
+        m_poPrivate->nRows - 1, pabyWkb, nLen);
+}
+
+/************************************************************************/
+/*                             AddFeature()                             */
+/************************************************************************/
+
+/** \brief Append a row with the content of a feature.
+ *
+ * The feature must use the feature definition of the batch.
+ * @since GDAL 2.4
+ */
+void OGRFeatureBatch::AddFeature( const OGRFeature *poFeature )
+{
+    AddRow(poFeature->GetFID());
+    const int nFieldCount = m_poPrivate->poDefn->GetFieldCount();
+    for( int iField = 0; iField < nFieldCount; iField++ )
+    {
+        if( poFeature->IsFieldSetAndNotNull(iField) )
+            SetFieldRaw(iField, poFeature->GetRawFieldRef(iField));
+    }
+    const int nGeomFieldCount = m_poPrivate->poDefn->GetGeomFieldCount();
+    for( int iGeom = 0; iGeom < nGeomFieldCount; iGeom++ )
+    {
+        const OGRGeometry* poGeom = poFeature->GetGeomFieldRef(iGeom);
+        if( poGeom )
+            SetGeometry(iGeom, poGeom);
+    }
+}
+
+/************************************************************************/
+/*                           OGR_FB_Create()                            */
+/************************************************************************/
+
+/**
+ * \brief Create a feature batch.
+ *
+ * This function is the same as the C++ method
+ * OGRFeatureBatch::OGRFeatureBatch().
+ *
+ * @param hDefn feature definition of the layer the batch will be filled from.
+ * @return a batch to destroy with OGR_FB_Destroy().
+ * @since GDAL 2.4
+ */
+OGRFeatureBatchH OGR_FB_Create( OGRFeatureDefnH hDefn )
+{
+    VALIDATE_POINTER1( hDefn, "OGR_FB_Create", nullptr );
+    return reinterpret_cast<OGRFeatureBatchH>(
+        new OGRFeatureBatch(OGRFeatureDefn::FromHandle(hDefn)));
+}
+
+/************************************************************************/
+/*                           OGR_FB_Destroy()                           */
+/************************************************************************/
+
+/**
+ * \brief Destroy a feature batch.
+ * @since GDAL 2.4
+ */
+void OGR_FB_Destroy( OGRFeatureBatchH hBatch )
+{
+    delete reinterpret_cast<OGRFeatureBatch*>(hBatch);
+}
+
+/************************************************************************/
+/*                         OGR_FB_GetRowCount()                         */
+/************************************************************************/
+
+/**
+ * \brief Return the number of rows of a feature batch.
+ *
+ * @see OGRFeatureBatch::GetRowCount()
+ * @since GDAL 2.4
+ */
+int OGR_FB_GetRowCount( OGRFeatureBatchH hBatch )
+{
+    VALIDATE_POINTER1( hBatch, "OGR_FB_GetRowCount", 0 );
+    return reinterpret_cast<OGRFeatureBatch*>(hBatch)->GetRowCount();
+}
+
+/************************************************************************/
+/*                           OGR_FB_GetFIDs()                           */
+/************************************************************************/
+
+/**
+ * \brief Return the feature ids of a feature batch.
+ *
+ * @see OGRFeatureBatch::GetFIDs()
+ * @since GDAL 2.4
+ */
+const GIntBig *OGR_FB_GetFIDs( OGRFeatureBatchH hBatch )
+{
+    VALIDATE_POINTER1( hBatch, "OGR_FB_GetFIDs", nullptr );
+    return reinterpret_cast<OGRFeatureBatch*>(hBatch)->GetFIDs();
+}
+
+/************************************************************************/
+/*                      OGR_FB_GetFieldValidity()                       */
+/************************************************************************/
+
+/**
+ * \brief Return the validity bitmap of an attribute field.
+ *
+ * @see OGRFeatureBatch::GetFieldValidity()
+ * @since GDAL 2.4
+ */
+const GByte *OGR_FB_GetFieldValidity( OGRFeatureBatchH hBatch, int iField )
+{
+    VALIDATE_POINTER1( hBatch, "OGR_FB_GetFieldValidity", nullptr );
+    return reinterpret_cast<OGRFeatureBatch*>(hBatch)->
+                                                    GetFieldValidity(iField);
+}
+
+/************************************************************************/
+/*                       OGR_FB_GetFieldValues()                        */
+/************************************************************************/
+
+/**
+ * \brief Return the values of a fixed width attribute field.
+ *
+ * @see OGRFeatureBatch::GetFieldValues()
+ * @since GDAL 2.4
+ */
+const void *OGR_FB_GetFieldValues( OGRFeatureBatchH hBatch, int iField )
+{
+    VALIDATE_POINTER1( hBatch, "OGR_FB_GetFieldValues", nullptr );
+    return reinterpret_cast<OGRFeatureBatch*>(hBatch)->GetFieldValues(iField);
+}
+
+/************************************************************************/
+/*                       OGR_FB_GetFieldOffsets()                       */
+/************************************************************************/
+
+/**
+ * \brief Return the offsets of a variable width attribute field.
+ *
+ * @see OGRFeatureBatch::GetFieldOffsets()
+ * @since GDAL 2.4
+ */
+const size_t *OGR_FB_GetFieldOffsets( OGRFeatureBatchH hBatch, int iField )
+{
+    VALIDATE_POINTER1( hBatch, "OGR_FB_GetFieldOffsets", nullptr );
+    return reinterpret_cast<OGRFeatureBatch*>(hBatch)->
+                                                    GetFieldOffsets(iField);
+}
+
+/************************************************************************/
+/*                        OGR_FB_GetFieldData()                         */
+/************************************************************************/
+
+/**
+ * \brief Return the data buffer of a variable width attribute field.
+ *
+ * @see OGRFeatureBatch::GetFieldData()
+ * @since GDAL 2.4
+ */
+const GByte *OGR_FB_GetFieldData( OGRFeatureBatchH hBatch, int iField )
+{
+    VALIDATE_POINTER1( hBatch, "OGR_FB_GetFieldData", nullptr );
+    return reinterpret_cast<OGRFeatureBatch*>(hBatch)->GetFieldData(iField);
+}
+
+/************************************************************************/
+/*                    OGR_FB_GetGeomFieldValidity()                     */
+/************************************************************************/
+
+/**
+ * \brief Return the validity bitmap of a geometry field.
+ *
+ * @see OGRFeatureBatch::GetGeomFieldValidity()
+ * @since GDAL 2.4
+ */
+const GByte *OGR_FB_GetGeomFieldValidity( OGRFeatureBatchH hBatch,
+                                          int iGeomField )
+{
+    VALIDATE_POINTER1( hBatch, "OGR_FB_GetGeomFieldValidity", nullptr );
+    return reinterpret_cast<OGRFeatureBatch*>(hBatch)->
+                                            GetGeomFieldValidity(iGeomField);
+}
+
+/************************************************************************/
+/*                     OGR_FB_GetGeomFieldOffsets()                     */
+/************************************************************************/
+
+/**
+ * \brief Return the offsets of the WKB geometries of a geometry field.
+ *
+ * @see OGRFeatureBatch::GetGeomFieldOffsets()
+ * @since GDAL 2.4
+ */
+const size_t *OGR_FB_GetGeomFieldOffsets( OGRFeatureBatchH hBatch,
+                                          int iGeomField )
+{
+    VALIDATE_POINTER1( hBatch, "OGR_FB_GetGeomFieldOffsets", nullptr );
+    return reinterpret_cast<OGRFeatureBatch*>(hBatch)->
+                                            GetGeomFieldOffsets(iGeomField);
+}
+
+/************************************************************************/
+/*                      OGR_FB_GetGeomFieldData()                       */
+/************************************************************************/
+
+/**
+ * \brief Return the WKB buffer of a geometry field.
+ *
+ * @see OGRFeatureBatch::GetGeomFieldData()
+ * @since GDAL 2.4
+ */
+const GByte *OGR_FB_GetGeomFieldData( OGRFeatureBatchH hBatch,
+                                      int iGeomField )
+{
+    VALIDATE_POINTER1( hBatch, "OGR_FB_GetGeomFieldData", nullptr );
+    return reinterpret_cast<OGRFeatureBatch*>(hBatch)->
+                                                GetGeomFieldData(iGeomField);
+}
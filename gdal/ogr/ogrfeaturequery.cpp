@@ -32,12 +32,18 @@
 #include "ogr_feature.h"
 #include "swq.h"
 
+#include <climits>
+#include <cmath>
 #include <cstddef>
 #include <cstdlib>
+#include <cstring>
 #include <algorithm>
+#include <exception>
+#include <vector>
 
 #include "cpl_conv.h"
 #include "cpl_error.h"
+#include "cpl_safemaths.hpp"
 #include "cpl_string.h"
 #include "ogr_attrind.h"
 #include "ogr_core.h"
@@ -57,13 +63,893 @@ const char *const SpecialFieldNames[SPECIAL_FIELD_COUNT] = {
 const swq_field_type SpecialFieldTypes[SPECIAL_FIELD_COUNT] = {
     SWQ_INTEGER, SWQ_STRING, SWQ_STRING, SWQ_STRING, SWQ_FLOAT};
 
+/************************************************************************/
+/*                    OGRFeatureFetcherFixFieldIndex()                  */
+/************************************************************************/
+
+static int OGRFeatureFetcherFixFieldIndex( OGRFeatureDefn* poFDefn, int nIdx )
+{
+    /* Nastry trick: if we inserted the FID column as an extra column, it is */
+    /* after regular fields, special fields and geometry fields */
+    if( nIdx == poFDefn->GetFieldCount() + SPECIAL_FIELD_COUNT +
+                poFDefn->GetGeomFieldCount() )
+    {
+        return poFDefn->GetFieldCount() + SPF_FID;
+    }
+    return nIdx;
+}
+
+/************************************************************************/
+/* ==================================================================== */
+/*                           OGRCompiledExpr                            */
+/*                                                                      */
+/*      The swq_expr_node tree flattened once, at Compile() time,      */
+/*      into nodes specialized by operand type, so that evaluating     */
+/*      a feature neither allocates result nodes nor looks up          */
+/*      operators.  Only the expressions whose result can be           */
+/*      reproduced exactly are compiled: the others (date/time         */
+/*      comparisons, string functions, geometry and special fields,    */
+/*      custom functions, ...) are still run by                        */
+/*      swq_expr_node::Evaluate().                                      */
+/* ==================================================================== */
+/************************************************************************/
+
+namespace {
+
+typedef enum
+{
+    OCN_CONSTANT,
+    OCN_COLUMN_INTEGER,
+    OCN_COLUMN_INTEGER64,
+    OCN_COLUMN_FLOAT,
+    OCN_COLUMN_STRING,
+    OCN_COLUMN_NULL_ONLY,   // only tested with IS NULL
+    OCN_ISNULL,
+    OCN_INTEGER_OP,         // integer, integer64 or boolean operands
+    OCN_FLOAT_OP,           // at least one float operand
+    OCN_STRING_OP
+} OGRCompiledNodeType;
+
+struct OGRCompiledValue
+{
+    GIntBig     nValue = 0;
+    double      dfValue = 0.0;
+    const char *pszValue = "";
+    bool        bNull = false;
+};
+
+struct OGRCompiledNode
+{
+    OGRCompiledNodeType eNodeType = OCN_CONSTANT;
+    swq_op              eOp = SWQ_CUSTOM_FUNC;
+    // Type of the value, as swq_expr_node::Evaluate() would return it.
+    swq_field_type      eType = SWQ_OTHER;
+    int                 iField = -1;
+    OGRFieldType        eFieldType = OFTInteger;
+    int                 iFirstChild = 0;
+    int                 nChildCount = 0;
+    bool                bNullable = false;
+    bool                bMayEmitError = false;
+    bool                bConstantList = false;  // IN list of non null constants
+    OGRCompiledValue    sConstant{};
+};
+
+/************************************************************************/
+/*                      OGRFeatureQueryFeatureRecord                    */
+/************************************************************************/
+
+class OGRFeatureQueryFeatureRecord
+{
+    OGRFeature *m_poFeature;
+
+  public:
+    explicit OGRFeatureQueryFeatureRecord( OGRFeature *poFeature ) :
+        m_poFeature(poFeature) {}
+
+    bool IsNull( const OGRCompiledNode &oNode ) const
+        { return !m_poFeature->IsFieldSetAndNotNull(oNode.iField); }
+    int GetInteger( const OGRCompiledNode &oNode ) const
+        { return m_poFeature->GetFieldAsInteger(oNode.iField); }
+    GIntBig GetInteger64( const OGRCompiledNode &oNode ) const
+        { return m_poFeature->GetFieldAsInteger64(oNode.iField); }
+    double GetDouble( const OGRCompiledNode &oNode ) const
+        { return m_poFeature->GetFieldAsDouble(oNode.iField); }
+    const char *GetString( const OGRCompiledNode &oNode ) const
+        { return m_poFeature->GetFieldAsString(oNode.iField); }
+};
+
+/************************************************************************/
+/*                       OGRFeatureQueryBatchRecord                     */
+/*                                                                      */
+/*      Reads the row of a feature batch as the OGRFeature accessors   */
+/*      would.  Strings are copied in per field buffers, to be nul     */
+/*      terminated, whose capacity is reused from row to row.          */
+/************************************************************************/
+
+class OGRFeatureQueryBatchRecord
+{
+    const OGRFeatureBatch  *m_poBatch;
+    const GIntBig          *m_panFIDs;
+    const int               m_iFIDField;
+    std::vector<CPLString> &m_aosStrings;
+    int                     m_iRow = 0;
+
+    CPL_DISALLOW_COPY_ASSIGN(OGRFeatureQueryBatchRecord)
+
+  public:
+    OGRFeatureQueryBatchRecord( const OGRFeatureBatch *poBatch,
+                                std::vector<CPLString> &aosStrings ) :
+        m_poBatch(poBatch),
+        m_panFIDs(poBatch->GetFIDs()),
+        m_iFIDField(poBatch->GetDefn()->GetFieldCount() + SPF_FID),
+        m_aosStrings(aosStrings) {}
+
+    void SetRow( int iRow ) { m_iRow = iRow; }
+
+    bool IsNull( const OGRCompiledNode &oNode ) const
+    {
+        if( oNode.iField == m_iFIDField )
+            return m_panFIDs[m_iRow] == OGRNullFID;
+        return !m_poBatch->IsFieldSetAndNotNull(m_iRow, oNode.iField);
+    }
+
+    GIntBig GetInteger64( const OGRCompiledNode &oNode ) const
+    {
+        if( oNode.iField == m_iFIDField )
+            return m_panFIDs[m_iRow];
+        if( IsNull(oNode) )
+            return 0;
+        const void *pValues = m_poBatch->GetFieldValues(oNode.iField);
+        if( oNode.eFieldType == OFTInteger )
+            return static_cast<const int *>(pValues)[m_iRow];
+        return static_cast<const GIntBig *>(pValues)[m_iRow];
+    }
+
+    int GetInteger( const OGRCompiledNode &oNode ) const
+    {
+        const GIntBig nVal64 = GetInteger64(oNode);
+        const int nVal =
+            nVal64 > INT_MAX ? INT_MAX :
+            nVal64 < INT_MIN ? INT_MIN : static_cast<int>(nVal64);
+        if( static_cast<GIntBig>(nVal) != nVal64 )
+        {
+            CPLError( CE_Warning, CPLE_AppDefined,
+                      "Integer overflow occurred when trying to return 64bit "
+                      "integer. Use GetFieldAsInteger64() instead");
+        }
+        return nVal;
+    }
+
+    double GetDouble( const OGRCompiledNode &oNode ) const
+    {
+        if( IsNull(oNode) )
+            return 0.0;
+        return static_cast<const double *>(
+            m_poBatch->GetFieldValues(oNode.iField))[m_iRow];
+    }
+
+    const char *GetString( const OGRCompiledNode &oNode ) const
+    {
+        if( IsNull(oNode) )
+            return "";
+        const size_t *panOffsets = m_poBatch->GetFieldOffsets(oNode.iField);
+        CPLString &osValue = m_aosStrings[oNode.iField];
+        osValue.assign(reinterpret_cast<const char *>(
+                           m_poBatch->GetFieldData(oNode.iField)) +
+                       panOffsets[m_iRow],
+                       panOffsets[m_iRow + 1] - panOffsets[m_iRow]);
+        return osValue.c_str();
+    }
+};
+
+/************************************************************************/
+/*                           OGRCompiledExpr                            */
+/************************************************************************/
+
+class OGRCompiledExpr
+{
+    std::vector<OGRCompiledNode> m_aoNodes{};
+    std::vector<int>             m_anChildren{};
+    int                          m_iRoot = -1;
+    OGRFeatureDefn              *m_poDefn = nullptr;
+    int                          m_nFieldCount = 0;
+
+    int         CompileNode( const swq_expr_node *poNode, int nRecLevel );
+    bool        CompileOperation( const swq_expr_node *poNode, int nRecLevel,
+                                  OGRCompiledNode &oNode );
+
+    double      GetDouble( int iNode, const OGRCompiledValue &sValue ) const
+    {
+        return m_aoNodes[iNode].eType == SWQ_FLOAT ?
+            sValue.dfValue : static_cast<double>(sValue.nValue);
+    }
+
+    template<class Record> void EvaluateNode(
+        int iNode, Record &oRecord, OGRCompiledValue &sValue ) const;
+    template<class Record> void EvaluateIntegerOp(
+        const OGRCompiledNode &oNode, Record &oRecord,
+        OGRCompiledValue &sValue ) const;
+    template<class Record> void EvaluateFloatOp(
+        const OGRCompiledNode &oNode, Record &oRecord,
+        OGRCompiledValue &sValue ) const;
+    template<class Record> void EvaluateStringOp(
+        const OGRCompiledNode &oNode, Record &oRecord,
+        OGRCompiledValue &sValue ) const;
+
+  public:
+    static OGRCompiledExpr *Compile( const swq_expr_node *poExpr,
+                                     OGRFeatureDefn *poDefn );
+
+    bool        IsCompatible( const OGRFeatureDefn *poDefn ) const;
+
+    template<class Record> bool Evaluate( Record &oRecord ) const;
+};
+
+/************************************************************************/
+/*                              Compile()                               */
+/************************************************************************/
+
+OGRCompiledExpr *OGRCompiledExpr::Compile( const swq_expr_node *poExpr,
+                                           OGRFeatureDefn *poDefn )
+{
+    OGRCompiledExpr *poCompiled = new OGRCompiledExpr();
+    poCompiled->m_poDefn = poDefn;
+    poCompiled->m_nFieldCount = poDefn->GetFieldCount();
+    poCompiled->m_iRoot = poCompiled->CompileNode(poExpr, 0);
+    if( poCompiled->m_iRoot < 0 )
+    {
+        CPLDebug("OGR", "Attribute filter evaluated by the SQL interpreter");
+        delete poCompiled;
+        return nullptr;
+    }
+    return poCompiled;
+}
+
+/************************************************************************/
+/*                            CompileNode()                             */
+/*                                                                      */
+/*      Returns the index of the compiled node, or -1 if the           */
+/*      expression cannot be compiled.                                  */
+/************************************************************************/
+
+int OGRCompiledExpr::CompileNode( const swq_expr_node *poNode, int nRecLevel )
+{
+    // swq_expr_node::Evaluate() fails at that depth.
+    if( nRecLevel >= 32 )
+        return -1;
+
+    OGRCompiledNode oNode;
+    if( poNode->eNodeType == SNT_CONSTANT )
+    {
+        oNode.eNodeType = OCN_CONSTANT;
+        oNode.eType = poNode->field_type;
+        oNode.bNullable = CPL_TO_BOOL(poNode->is_null);
+        oNode.sConstant.bNull = oNode.bNullable;
+        switch( poNode->field_type )
+        {
+          case SWQ_INTEGER:
+          case SWQ_INTEGER64:
+          case SWQ_BOOLEAN:
+            oNode.sConstant.nValue = poNode->int_value;
+            break;
+
+          case SWQ_FLOAT:
+            oNode.sConstant.dfValue = poNode->float_value;
+            break;
+
+          case SWQ_STRING:
+            if( poNode->string_value == nullptr )
+                return -1;
+            // Points into the expression tree, owned by OGRFeatureQuery.
+            oNode.sConstant.pszValue = poNode->string_value;
+            break;
+
+          default:
+            return -1;
+        }
+    }
+    else if( poNode->eNodeType == SNT_COLUMN )
+    {
+        if( poNode->table_index != 0 )
+            return -1;
+        const int iField =
+            OGRFeatureFetcherFixFieldIndex(m_poDefn, poNode->field_index);
+        // Among special fields, only the FID is cheap and safe to fetch.
+        if( iField < 0 || (iField >= m_nFieldCount &&
+                           iField != m_nFieldCount + SPF_FID) )
+            return -1;
+
+        oNode.iField = iField;
+        oNode.eFieldType = iField < m_nFieldCount ?
+            m_poDefn->GetFieldDefn(iField)->GetType() : OFTInteger64;
+        oNode.bNullable = true;
+        const bool bIntegerField = oNode.eFieldType == OFTInteger ||
+                                   oNode.eFieldType == OFTInteger64;
+        switch( poNode->field_type )
+        {
+          case SWQ_INTEGER:
+          case SWQ_BOOLEAN:
+            if( !bIntegerField )
+                return -1;
+            oNode.eNodeType = OCN_COLUMN_INTEGER;
+            oNode.eType = SWQ_INTEGER;
+            // GetFieldAsInteger() warns when truncating 64 bit values.
+            oNode.bMayEmitError = oNode.eFieldType == OFTInteger64;
+            break;
+
+          case SWQ_INTEGER64:
+            if( !bIntegerField )
+                return -1;
+            oNode.eNodeType = OCN_COLUMN_INTEGER64;
+            oNode.eType = SWQ_INTEGER64;
+            break;
+
+          case SWQ_FLOAT:
+            if( oNode.eFieldType != OFTReal )
+                return -1;
+            oNode.eNodeType = OCN_COLUMN_FLOAT;
+            oNode.eType = SWQ_FLOAT;
+            break;
+
+          case SWQ_STRING:
+            if( oNode.eFieldType != OFTString )
+                return -1;
+            oNode.eNodeType = OCN_COLUMN_STRING;
+            oNode.eType = SWQ_STRING;
+            break;
+
+          case SWQ_GEOMETRY:
+            return -1;
+
+          default:
+            oNode.eNodeType = OCN_COLUMN_NULL_ONLY;
+            oNode.eType = poNode->field_type;
+            break;
+        }
+    }
+    else if( poNode->eNodeType == SNT_OPERATION )
+    {
+        if( !CompileOperation(poNode, nRecLevel, oNode) )
+            return -1;
+    }
+    else
+    {
+        return -1;
+    }
+
+    m_aoNodes.push_back(oNode);
+    return static_cast<int>(m_aoNodes.size()) - 1;
+}
+
+/************************************************************************/
+/*                          CompileOperation()                          */
+/*                                                                      */
+/*      Mirrors the dispatching of SWQGeneralEvaluator() on the types  */
+/*      of the operands.                                                */
+/************************************************************************/
+
+static bool IsComparison( swq_op eOp, int nChildCount )
+{
+    switch( eOp )
+    {
+      case SWQ_EQ:
+      case SWQ_NE:
+      case SWQ_GT:
+      case SWQ_LT:
+      case SWQ_GE:
+      case SWQ_LE:
+        return nChildCount == 2;
+      case SWQ_IN:
+        return nChildCount >= 2;
+      case SWQ_BETWEEN:
+        return nChildCount == 3;
+      default:
+        return false;
+    }
+}
+
+static bool IsArithmetic( swq_op eOp, int nChildCount )
+{
+    return (eOp == SWQ_ADD || eOp == SWQ_SUBTRACT || eOp == SWQ_MULTIPLY ||
+            eOp == SWQ_DIVIDE || eOp == SWQ_MODULUS) && nChildCount == 2;
+}
+
+bool OGRCompiledExpr::CompileOperation( const swq_expr_node *poNode,
+                                        int nRecLevel,
+                                        OGRCompiledNode &oNode )
+{
+    const swq_op eOp = static_cast<swq_op>(poNode->nOperation);
+    const swq_operation *poOp = swq_op_registrar::GetOperator(eOp);
+    if( poOp == nullptr || poOp->pfnEvaluator != SWQGeneralEvaluator )
+        return false;
+
+    const int nChildCount = poNode->nSubExprCount;
+    if( nChildCount < 1 )
+        return false;
+    std::vector<int> anChildren;
+    for( int i = 0; i < nChildCount; i++ )
+    {
+        const int iChild =
+            CompileNode(poNode->papoSubExpr[i], nRecLevel + 1);
+        if( iChild < 0 )
+            return false;
+        anChildren.push_back(iChild);
+    }
+
+    oNode.eOp = eOp;
+    oNode.eType = poNode->field_type;
+    oNode.nChildCount = nChildCount;
+    oNode.iFirstChild = static_cast<int>(m_anChildren.size());
+    oNode.bConstantList = eOp == SWQ_IN;
+    bool bAnyNullable = false;
+    bool bAnyNullOnly = false;
+    for( int i = 0; i < nChildCount; i++ )
+    {
+        const OGRCompiledNode &oChild = m_aoNodes[anChildren[i]];
+        bAnyNullable |= oChild.bNullable;
+        bAnyNullOnly |= oChild.eNodeType == OCN_COLUMN_NULL_ONLY;
+        oNode.bMayEmitError |= oChild.bMayEmitError;
+        if( i > 0 && (oChild.eNodeType != OCN_CONSTANT || oChild.bNullable) )
+            oNode.bConstantList = false;
+    }
+
+    const bool bBoolean = poNode->field_type == SWQ_BOOLEAN;
+    const swq_field_type eType0 = m_aoNodes[anChildren[0]].eType;
+    const swq_field_type eType1 =
+        nChildCount > 1 ? m_aoNodes[anChildren[1]].eType : SWQ_OTHER;
+    bool bOK = false;
+    if( eOp == SWQ_ISNULL )
+    {
+        oNode.eNodeType = OCN_ISNULL;
+        bOK = nChildCount == 1;
+    }
+    else if( bAnyNullOnly )
+    {
+        bOK = false;
+    }
+    else if( eType0 == SWQ_FLOAT || eType1 == SWQ_FLOAT )
+    {
+        // Only the first two operands are converted from integers.
+        oNode.eNodeType = OCN_FLOAT_OP;
+        bOK = true;
+        for( int i = 0; i < nChildCount; i++ )
+        {
+            const swq_field_type eType = m_aoNodes[anChildren[i]].eType;
+            if( !(eType == SWQ_FLOAT || (i < 2 && SWQ_IS_INTEGER(eType))) )
+                bOK = false;
+        }
+        if( IsArithmetic(eOp, nChildCount) )
+        {
+            bOK &= poNode->field_type == SWQ_FLOAT;
+            oNode.bNullable = bAnyNullable;
+        }
+        else
+        {
+            bOK &= bBoolean && IsComparison(eOp, nChildCount);
+        }
+    }
+    else if( SWQ_IS_INTEGER(eType0) || eType0 == SWQ_BOOLEAN )
+    {
+        oNode.eNodeType = OCN_INTEGER_OP;
+        bOK = true;
+        for( int i = 0; i < nChildCount; i++ )
+        {
+            const swq_field_type eType = m_aoNodes[anChildren[i]].eType;
+            if( !(SWQ_IS_INTEGER(eType) || eType == SWQ_BOOLEAN) )
+                bOK = false;
+        }
+        if( IsArithmetic(eOp, nChildCount) )
+        {
+            bOK &= CPL_TO_BOOL(SWQ_IS_INTEGER(poNode->field_type));
+            // Overflows are reported, and evaluate to NULL.
+            oNode.bNullable = true;
+            oNode.bMayEmitError |= eOp != SWQ_MODULUS;
+        }
+        else
+        {
+            bOK &= bBoolean &&
+                   (IsComparison(eOp, nChildCount) ||
+                    ((eOp == SWQ_AND || eOp == SWQ_OR) && nChildCount == 2) ||
+                    (eOp == SWQ_NOT && nChildCount == 1));
+        }
+    }
+    else if( eType0 == SWQ_STRING )
+    {
+        oNode.eNodeType = OCN_STRING_OP;
+        bOK = bBoolean &&
+              (IsComparison(eOp, nChildCount) ||
+               (eOp == SWQ_LIKE && (nChildCount == 2 || nChildCount == 3)));
+        for( int i = 0; i < nChildCount; i++ )
+        {
+            if( m_aoNodes[anChildren[i]].eType != SWQ_STRING )
+                bOK = false;
+        }
+    }
+
+    if( bOK )
+        m_anChildren.insert(m_anChildren.end(),
+                            anChildren.begin(), anChildren.end());
+    return bOK;
+}
+
+/************************************************************************/
+/*                            IsCompatible()                            */
+/*                                                                      */
+/*      Whether the field types of a feature batch are the ones the    */
+/*      expression was compiled against.                                */
+/************************************************************************/
+
+bool OGRCompiledExpr::IsCompatible( const OGRFeatureDefn *poDefn ) const
+{
+    if( poDefn->GetFieldCount() != m_nFieldCount )
+        return false;
+    for( const auto &oNode : m_aoNodes )
+    {
+        if( oNode.iField >= 0 && oNode.iField < m_nFieldCount &&
+            poDefn->GetFieldDefn(oNode.iField)->GetType() != oNode.eFieldType )
+            return false;
+    }
+    return true;
+}
+
+/************************************************************************/
+/*                              Evaluate()                              */
+/************************************************************************/
+
+template<class Record>
+bool OGRCompiledExpr::Evaluate( Record &oRecord ) const
+{
+    OGRCompiledValue sValue;
+    EvaluateNode(m_iRoot, oRecord, sValue);
+
+    // Same as OGRFeatureQuery::Evaluate() on the interpreted result.
+    const swq_field_type eType = m_aoNodes[m_iRoot].eType;
+    return (SWQ_IS_INTEGER(eType) || eType == SWQ_BOOLEAN) &&
+           static_cast<int>(sValue.nValue) != 0;
+}
+
+/************************************************************************/
+/*                            EvaluateNode()                            */
+/************************************************************************/
+
+template<class Record>
+void OGRCompiledExpr::EvaluateNode( int iNode, Record &oRecord,
+                                    OGRCompiledValue &sValue ) const
+{
+    const OGRCompiledNode &oNode = m_aoNodes[iNode];
+    switch( oNode.eNodeType )
+    {
+      case OCN_CONSTANT:
+        sValue = oNode.sConstant;
+        break;
+
+      case OCN_COLUMN_INTEGER:
+        sValue.nValue = oRecord.GetInteger(oNode);
+        sValue.bNull = oRecord.IsNull(oNode);
+        break;
+
+      case OCN_COLUMN_INTEGER64:
+        sValue.nValue = oRecord.GetInteger64(oNode);
+        sValue.bNull = oRecord.IsNull(oNode);
+        break;
+
+      case OCN_COLUMN_FLOAT:
+        sValue.dfValue = oRecord.GetDouble(oNode);
+        sValue.bNull = oRecord.IsNull(oNode);
+        break;
+
+      case OCN_COLUMN_STRING:
+        sValue.pszValue = oRecord.GetString(oNode);
+        sValue.bNull = oRecord.IsNull(oNode);
+        break;
+
+      case OCN_COLUMN_NULL_ONLY:
+        sValue.bNull = oRecord.IsNull(oNode);
+        break;
+
+      case OCN_ISNULL:
+      {
+        OGRCompiledValue sChild;
+        EvaluateNode(m_anChildren[oNode.iFirstChild], oRecord, sChild);
+        sValue.nValue = sChild.bNull ? 1 : 0;
+        sValue.bNull = false;
+        break;
+      }
+
+      case OCN_INTEGER_OP:
+        EvaluateIntegerOp(oNode, oRecord, sValue);
+        break;
+
+      case OCN_FLOAT_OP:
+        EvaluateFloatOp(oNode, oRecord, sValue);
+        break;
+
+      case OCN_STRING_OP:
+        EvaluateStringOp(oNode, oRecord, sValue);
+        break;
+    }
+}
+
+/************************************************************************/
+/*                         EvaluateIntegerOp()                          */
+/************************************************************************/
+
+template<class Record>
+void OGRCompiledExpr::EvaluateIntegerOp( const OGRCompiledNode &oNode,
+                                         Record &oRecord,
+                                         OGRCompiledValue &sValue ) const
+{
+    const int *panChildren = &m_anChildren[oNode.iFirstChild];
+    sValue.nValue = 0;
+    sValue.bNull = false;
+
+    OGRCompiledValue asArgs[3];
+    if( oNode.eOp == SWQ_AND || oNode.eOp == SWQ_OR )
+    {
+        EvaluateNode(panChildren[0], oRecord, asArgs[0]);
+
+        // A NULL operand makes the result FALSE, so the right operand can
+        // only be skipped when it cannot be NULL for OR.  It is always
+        // evaluated when it may report errors.
+        const OGRCompiledNode &oRight = m_aoNodes[panChildren[1]];
+        if( !oRight.bMayEmitError )
+        {
+            if( asArgs[0].bNull ||
+                (oNode.eOp == SWQ_AND && asArgs[0].nValue == 0) )
+                return;
+            if( oNode.eOp == SWQ_OR && asArgs[0].nValue != 0 &&
+                !oRight.bNullable )
+            {
+                sValue.nValue = 1;
+                return;
+            }
+        }
+
+        EvaluateNode(panChildren[1], oRecord, asArgs[1]);
+        if( asArgs[0].bNull || asArgs[1].bNull )
+            return;
+        if( oNode.eOp == SWQ_AND )
+            sValue.nValue = asArgs[0].nValue && asArgs[1].nValue;
+        else
+            sValue.nValue = asArgs[0].nValue || asArgs[1].nValue;
+        return;
+    }
+
+    if( oNode.eOp == SWQ_IN )
+    {
+        EvaluateNode(panChildren[0], oRecord, asArgs[0]);
+        bool bNull = asArgs[0].bNull;
+        bool bFound = false;
+        for( int i = 1; i < oNode.nChildCount && !(bFound && oNode.bConstantList);
+             i++ )
+        {
+            const OGRCompiledValue *psItem = &(m_aoNodes[panChildren[i]].sConstant);
+            if( !oNode.bConstantList )
+            {
+                EvaluateNode(panChildren[i], oRecord, asArgs[1]);
+                psItem = &asArgs[1];
+            }
+            if( psItem->bNull )
+                bNull = true;
+            else if( psItem->nValue == asArgs[0].nValue )
+                bFound = true;
+        }
+        sValue.nValue = !bNull && bFound;
+        return;
+    }
+
+    for( int i = 0; i < oNode.nChildCount; i++ )
+        EvaluateNode(panChildren[i], oRecord, asArgs[i]);
+    for( int i = 0; i < oNode.nChildCount; i++ )
+    {
+        if( asArgs[i].bNull )
+        {
+            sValue.bNull = oNode.eType != SWQ_BOOLEAN;
+            return;
+        }
+    }
+
+    const GIntBig nA = asArgs[0].nValue;
+    const GIntBig nB = asArgs[1].nValue;
+    try
+    {
+        switch( oNode.eOp )
+        {
+          case SWQ_NOT: sValue.nValue = !nA; break;
+          case SWQ_EQ: sValue.nValue = nA == nB; break;
+          case SWQ_NE: sValue.nValue = nA != nB; break;
+          case SWQ_GT: sValue.nValue = nA > nB; break;
+          case SWQ_LT: sValue.nValue = nA < nB; break;
+          case SWQ_GE: sValue.nValue = nA >= nB; break;
+          case SWQ_LE: sValue.nValue = nA <= nB; break;
+          case SWQ_BETWEEN:
+            sValue.nValue = nA >= nB && nA <= asArgs[2].nValue;
+            break;
+          case SWQ_ADD: sValue.nValue = (CPLSM(nA) + CPLSM(nB)).v(); break;
+          case SWQ_SUBTRACT:
+            sValue.nValue = (CPLSM(nA) - CPLSM(nB)).v();
+            break;
+          case SWQ_MULTIPLY:
+            sValue.nValue = (CPLSM(nA) * CPLSM(nB)).v();
+            break;
+          case SWQ_DIVIDE:
+            sValue.nValue = nB == 0 ? INT_MAX : (CPLSM(nA) / CPLSM(nB)).v();
+            break;
+          case SWQ_MODULUS:
+            sValue.nValue = nB == 0 ? INT_MAX : nA % nB;
+            break;
+          default:
+            CPLAssert(false);
+            break;
+        }
+    }
+    catch( const std::exception& )
+    {
+        CPLError(CE_Failure, CPLE_AppDefined, "Int overflow");
+        sValue.nValue = 0;
+        sValue.bNull = true;
+    }
+}
+
+/************************************************************************/
+/*                          EvaluateFloatOp()                           */
+/************************************************************************/
+
+template<class Record>
+void OGRCompiledExpr::EvaluateFloatOp( const OGRCompiledNode &oNode,
+                                       Record &oRecord,
+                                       OGRCompiledValue &sValue ) const
+{
+    const int *panChildren = &m_anChildren[oNode.iFirstChild];
+    sValue.nValue = 0;
+    sValue.dfValue = 0.0;
+    sValue.bNull = false;
+
+    OGRCompiledValue asArgs[3];
+    if( oNode.eOp == SWQ_IN )
+    {
+        EvaluateNode(panChildren[0], oRecord, asArgs[0]);
+        const double dfA = GetDouble(panChildren[0], asArgs[0]);
+        bool bNull = asArgs[0].bNull;
+        bool bFound = false;
+        for( int i = 1; i < oNode.nChildCount && !(bFound && oNode.bConstantList);
+             i++ )
+        {
+            const OGRCompiledValue *psItem = &(m_aoNodes[panChildren[i]].sConstant);
+            if( !oNode.bConstantList )
+            {
+                EvaluateNode(panChildren[i], oRecord, asArgs[1]);
+                psItem = &asArgs[1];
+            }
+            if( psItem->bNull )
+                bNull = true;
+            else if( GetDouble(panChildren[i], *psItem) == dfA )
+                bFound = true;
+        }
+        sValue.nValue = !bNull && bFound;
+        return;
+    }
+
+    for( int i = 0; i < oNode.nChildCount; i++ )
+        EvaluateNode(panChildren[i], oRecord, asArgs[i]);
+    for( int i = 0; i < oNode.nChildCount; i++ )
+    {
+        if( asArgs[i].bNull )
+        {
+            sValue.bNull = oNode.eType != SWQ_BOOLEAN;
+            return;
+        }
+    }
+
+    const double dfA = GetDouble(panChildren[0], asArgs[0]);
+    const double dfB = GetDouble(panChildren[1], asArgs[1]);
+    switch( oNode.eOp )
+    {
+      case SWQ_EQ: sValue.nValue = dfA == dfB; break;
+      case SWQ_NE: sValue.nValue = dfA != dfB; break;
+      case SWQ_GT: sValue.nValue = dfA > dfB; break;
+      case SWQ_LT: sValue.nValue = dfA < dfB; break;
+      case SWQ_GE: sValue.nValue = dfA >= dfB; break;
+      case SWQ_LE: sValue.nValue = dfA <= dfB; break;
+      case SWQ_BETWEEN:
+        sValue.nValue = dfA >= dfB && dfA <= asArgs[2].dfValue;
+        break;
+      case SWQ_ADD: sValue.dfValue = dfA + dfB; break;
+      case SWQ_SUBTRACT: sValue.dfValue = dfA - dfB; break;
+      case SWQ_MULTIPLY: sValue.dfValue = dfA * dfB; break;
+      case SWQ_DIVIDE:
+        sValue.dfValue = dfB == 0 ? INT_MAX : dfA / dfB;
+        break;
+      case SWQ_MODULUS:
+        sValue.dfValue = dfB == 0 ? INT_MAX : fmod(dfA, dfB);
+        break;
+      default:
+        CPLAssert(false);
+        break;
+    }
+}
+
+/************************************************************************/
+/*                          EvaluateStringOp()                          */
+/************************************************************************/
+
+template<class Record>
+void OGRCompiledExpr::EvaluateStringOp( const OGRCompiledNode &oNode,
+                                        Record &oRecord,
+                                        OGRCompiledValue &sValue ) const
+{
+    const int *panChildren = &m_anChildren[oNode.iFirstChild];
+    sValue.nValue = 0;
+    sValue.bNull = false;
+
+    OGRCompiledValue asArgs[3];
+    if( oNode.eOp == SWQ_IN )
+    {
+        EvaluateNode(panChildren[0], oRecord, asArgs[0]);
+        bool bNull = asArgs[0].bNull;
+        bool bFound = false;
+        for( int i = 1; i < oNode.nChildCount && !(bFound && oNode.bConstantList);
+             i++ )
+        {
+            const OGRCompiledValue *psItem = &(m_aoNodes[panChildren[i]].sConstant);
+            if( !oNode.bConstantList )
+            {
+                EvaluateNode(panChildren[i], oRecord, asArgs[1]);
+                psItem = &asArgs[1];
+            }
+            if( psItem->bNull )
+                bNull = true;
+            else if( !bFound &&
+                     strcasecmp(asArgs[0].pszValue, psItem->pszValue) == 0 )
+                bFound = true;
+        }
+        sValue.nValue = !bNull && bFound;
+        return;
+    }
+
+    for( int i = 0; i < oNode.nChildCount; i++ )
+        EvaluateNode(panChildren[i], oRecord, asArgs[i]);
+    for( int i = 0; i < oNode.nChildCount; i++ )
+    {
+        if( asArgs[i].bNull )
+            return;
+    }
+
+    const char *pszA = asArgs[0].pszValue;
+    const char *pszB = asArgs[1].pszValue;
+    switch( oNode.eOp )
+    {
+      case SWQ_EQ: sValue.nValue = swq_test_string_equal(pszA, pszB); break;
+      case SWQ_NE: sValue.nValue = strcasecmp(pszA, pszB) != 0; break;
+      case SWQ_GT: sValue.nValue = strcasecmp(pszA, pszB) > 0; break;
+      case SWQ_LT: sValue.nValue = strcasecmp(pszA, pszB) < 0; break;
+      case SWQ_GE: sValue.nValue = strcasecmp(pszA, pszB) >= 0; break;
+      case SWQ_LE: sValue.nValue = strcasecmp(pszA, pszB) <= 0; break;
+      case SWQ_BETWEEN:
+        sValue.nValue = strcasecmp(pszA, pszB) >= 0 &&
+                        strcasecmp(pszA, asArgs[2].pszValue) <= 0;
+        break;
+      case SWQ_LIKE:
+        sValue.nValue = swq_test_like(
+            pszA, pszB,
+            oNode.nChildCount == 3 ? asArgs[2].pszValue[0] : '\0');
+        break;
+      default:
+        CPLAssert(false);
+        break;
+    }
+}
+
+} // namespace
+
 /************************************************************************/
 /*                          OGRFeatureQuery()                           */
 /************************************************************************/
 
 OGRFeatureQuery::OGRFeatureQuery() :
     poTargetDefn(nullptr),
-    pSWQExpr(nullptr)
+    pSWQExpr(nullptr),
+    pCompiledExpr(nullptr)
 {}
 
 /************************************************************************/
@@ -73,6 +959,7 @@ OGRFeatureQuery::OGRFeatureQuery() :
 OGRFeatureQuery::~OGRFeatureQuery()
 
 {
+    delete static_cast<OGRCompiledExpr *>(pCompiledExpr);
     delete static_cast<swq_expr_node *>(pSWQExpr);
 }
 
@@ -117,6 +1004,8 @@ OGRFeatureQuery::Compile( OGRLayer *poLayer,
                           swq_custom_func_registrar *poCustomFuncRegistrar )
 {
     // Clear any existing expression.
+    delete static_cast<OGRCompiledExpr *>(pCompiledExpr);
+    pCompiledExpr = nullptr;
     if( pSWQExpr != nullptr )
     {
         delete static_cast<swq_expr_node *>(pSWQExpr);
@@ -242,6 +1131,12 @@ OGRFeatureQuery::Compile( OGRLayer *poLayer,
         eErr = OGRERR_CORRUPT_DATA;
         pSWQExpr = nullptr;
     }
+    else if( CPLTestBool(
+                 CPLGetConfigOption("OGR_SQL_COMPILE_EXPRESSIONS", "YES")) )
+    {
+        pCompiledExpr = OGRCompiledExpr::Compile(
+            static_cast<swq_expr_node *>(pSWQExpr), poDefn);
+    }
 
     CPLFree(papszFieldNames);
     CPLFree(paeFieldTypes);
@@ -249,22 +1144,6 @@ OGRFeatureQuery::Compile( OGRLayer *poLayer,
     return eErr;
 }
 
-/************************************************************************/
-/*                    OGRFeatureFetcherFixFieldIndex()                  */
-/************************************************************************/
-
-static int OGRFeatureFetcherFixFieldIndex( OGRFeatureDefn* poFDefn, int nIdx )
-{
-    /* Nastry trick: if we inserted the FID column as an extra column, it is */
-    /* after regular fields, special fields and geometry fields */
-    if( nIdx == poFDefn->GetFieldCount() + SPECIAL_FIELD_COUNT +
-                poFDefn->GetGeomFieldCount() )
-    {
-        return poFDefn->GetFieldCount() + SPF_FID;
-    }
-    return nIdx;
-}
-
 /************************************************************************/
 /*                         OGRFeatureFetcher()                          */
 /************************************************************************/
@@ -333,6 +1212,13 @@ int OGRFeatureQuery::Evaluate( OGRFeature *poFeature )
     if( pSWQExpr == nullptr )
         return FALSE;
 
+    if( pCompiledExpr != nullptr )
+    {
+        OGRFeatureQueryFeatureRecord oRecord(poFeature);
+        return static_cast<const OGRCompiledExpr *>(pCompiledExpr)->
+            Evaluate(oRecord);
+    }
+
     swq_expr_node *poResult =
         static_cast<swq_expr_node *>(pSWQExpr)->
             Evaluate(OGRFeatureFetcher, poFeature);
@@ -351,6 +1237,449 @@ int OGRFeatureQuery::Evaluate( OGRFeature *poFeature )
     return bLogicalResult;
 }
 
+/************************************************************************/
+/*                           EvaluateBatch()                            */
+/*                                                                      */
+/*      Evaluate the rows of a feature batch, setting pabyMatches[i]   */
+/*      to TRUE or FALSE.  Returns the number of matching rows.        */
+/************************************************************************/
+
+int OGRFeatureQuery::EvaluateBatch( const OGRFeatureBatch *poBatch,
+                                    GByte *pabyMatches )
+
+{
+    const int nRowCount = poBatch->GetRowCount();
+    int nMatches = 0;
+
+    const OGRCompiledExpr *poCompiled =
+        static_cast<const OGRCompiledExpr *>(pCompiledExpr);
+    if( poCompiled != nullptr && poCompiled->IsCompatible(poBatch->GetDefn()) )
+    {
+        std::vector<CPLString> aosStrings(poBatch->GetDefn()->GetFieldCount());
+        OGRFeatureQueryBatchRecord oRecord(poBatch, aosStrings);
+        for( int iRow = 0; iRow < nRowCount; iRow++ )
+        {
+            oRecord.SetRow(iRow);
+            const bool bMatch = poCompiled->Evaluate(oRecord);
+            pabyMatches[iRow] = bMatch ? TRUE : FALSE;
+            nMatches += bMatch ? 1 : 0;
+        }
+        return nMatches;
+    }
+
+    for( int iRow = 0; iRow < nRowCount; iRow++ )
+    {
+        OGRFeature *poFeature =
+            pSWQExpr != nullptr ? poBatch->GetFeature(iRow) : nullptr;
+        const bool bMatch = poFeature != nullptr && Evaluate(poFeature);
+        delete poFeature;
+        pabyMatches[iRow] = bMatch ? TRUE : FALSE;
+        nMatches += bMatch ? 1 : 0;
+    }
+    return nMatches;
+}
+
+/************************************************************************/
+/*                         OGRIndexedCondition                          */
+/*                                                                      */
+/*      Condition on a single field that an attribute index can         */
+/*      answer : equality with one of asValues, or a range and/or a     */
+/*      string prefix.                                                  */
+/************************************************************************/
+
+struct OGRIndexedCondition
+{
+    int                     iField = -1;
+    bool                    bEmpty = false;  // Matched by no feature.
+    std::vector<OGRField>   asValues{};
+    bool                    bHasMin = false;
+    OGRField                sMin{};
+    bool                    bMinIncluded = true;
+    bool                    bHasMax = false;
+    OGRField                sMax{};
+    bool                    bMaxIncluded = true;
+    CPLString               osPrefix{};
+
+    bool        HasRange() const
+        { return bHasMin || bHasMax || !osPrefix.empty(); }
+};
+
+typedef enum
+{
+    OGR_INDEX_VALUE_OK,
+    OGR_INDEX_VALUE_EMPTY,       // No value of the field can match.
+    OGR_INDEX_VALUE_NO_BOUND,    // Any value of the field matches the bound.
+    OGR_INDEX_VALUE_UNSUPPORTED
+} OGRIndexValueStatus;
+
+/************************************************************************/
+/*                          OGRGetIndexValue()                          */
+/*                                                                      */
+/*      Convert a constant to the type of the indexed field.  nBound    */
+/*      is 0 for an equality test, -1 for a lower bound and 1 for an    */
+/*      upper bound, which are rounded to the integer values matching   */
+/*      the same features for integer fields.                           */
+/************************************************************************/
+
+static OGRIndexValueStatus OGRGetIndexValue( const swq_expr_node *poValue,
+                                             OGRFieldType eType, int nBound,
+                                             OGRField &sValue,
+                                             bool &bIncluded )
+{
+    if( poValue->eNodeType != SNT_CONSTANT || poValue->is_null )
+        return OGR_INDEX_VALUE_UNSUPPORTED;
+
+    const bool bIntegerConstant = poValue->field_type == SWQ_INTEGER ||
+                                  poValue->field_type == SWQ_INTEGER64;
+
+    if( eType == OFTString )
+    {
+        if( poValue->field_type != SWQ_STRING )
+            return OGR_INDEX_VALUE_UNSUPPORTED;
+        sValue.String = poValue->string_value;
+        return OGR_INDEX_VALUE_OK;
+    }
+
+    if( eType == OFTReal )
+    {
+        if( poValue->field_type == SWQ_FLOAT )
+            sValue.Real = poValue->float_value;
+        else if( bIntegerConstant )
+            sValue.Real = static_cast<double>(poValue->int_value);
+        else
+            return OGR_INDEX_VALUE_UNSUPPORTED;
+        return CPLIsNan(sValue.Real) ? OGR_INDEX_VALUE_EMPTY :
+                                       OGR_INDEX_VALUE_OK;
+    }
+
+    if( eType != OFTInteger && eType != OFTInteger64 )
+        return OGR_INDEX_VALUE_UNSUPPORTED;
+
+    GIntBig nVal = 0;
+    if( bIntegerConstant )
+    {
+        nVal = poValue->int_value;
+    }
+    else if( poValue->field_type == SWQ_FLOAT )
+    {
+        double dfVal = poValue->float_value;
+        if( CPLIsNan(dfVal) )
+            return OGR_INDEX_VALUE_EMPTY;
+        if( dfVal != std::floor(dfVal) )
+        {
+            if( nBound == 0 )
+                return OGR_INDEX_VALUE_EMPTY;
+            dfVal = nBound < 0 ? std::ceil(dfVal) : std::floor(dfVal);
+            bIncluded = true;
+        }
+        if( dfVal >= 9223372036854775808.0 )
+            return nBound > 0 ? OGR_INDEX_VALUE_NO_BOUND :
+                                OGR_INDEX_VALUE_EMPTY;
+        if( dfVal < -9223372036854775808.0 )
+            return nBound < 0 ? OGR_INDEX_VALUE_NO_BOUND :
+                                OGR_INDEX_VALUE_EMPTY;
+        nVal = static_cast<GIntBig>(dfVal);
+    }
+    else
+    {
+        return OGR_INDEX_VALUE_UNSUPPORTED;
+    }
+
+    if( eType == OFTInteger64 )
+    {
+        sValue.Integer64 = nVal;
+        return OGR_INDEX_VALUE_OK;
+    }
+    if( nVal > INT_MAX )
+        return nBound > 0 ? OGR_INDEX_VALUE_NO_BOUND : OGR_INDEX_VALUE_EMPTY;
+    if( nVal < INT_MIN )
+        return nBound < 0 ? OGR_INDEX_VALUE_NO_BOUND : OGR_INDEX_VALUE_EMPTY;
+    sValue.Integer = static_cast<int>(nVal);
+    return OGR_INDEX_VALUE_OK;
+}
+
+/************************************************************************/
+/*                      OGRParseIndexedCondition()                      */
+/*                                                                      */
+/*      Recognize the field = value, field IN (...), field < value,     */
+/*      field BETWEEN a AND b and field LIKE 'prefix%' expressions.     */
+/************************************************************************/
+
+static bool OGRParseIndexedCondition( const swq_expr_node *psExpr,
+                                      OGRLayer *poLayer,
+                                      OGRIndexedCondition &sCond )
+{
+    if( psExpr == nullptr || psExpr->eNodeType != SNT_OPERATION ||
+        psExpr->nSubExprCount < 2 )
+        return false;
+
+    int nOperation = psExpr->nOperation;
+    const swq_expr_node *poColumn = psExpr->papoSubExpr[0];
+    const swq_expr_node *poValue = psExpr->papoSubExpr[1];
+
+    // value < field is field > value.
+    if( poColumn->eNodeType != SNT_COLUMN && psExpr->nSubExprCount == 2 &&
+        (nOperation == SWQ_EQ || nOperation == SWQ_LT ||
+         nOperation == SWQ_LE || nOperation == SWQ_GT ||
+         nOperation == SWQ_GE) )
+    {
+        std::swap(poColumn, poValue);
+        if( nOperation == SWQ_LT )
+            nOperation = SWQ_GT;
+        else if( nOperation == SWQ_LE )
+            nOperation = SWQ_GE;
+        else if( nOperation == SWQ_GT )
+            nOperation = SWQ_LT;
+        else if( nOperation == SWQ_GE )
+            nOperation = SWQ_LE;
+    }
+
+    if( poColumn->eNodeType != SNT_COLUMN )
+        return false;
+
+    OGRFeatureDefn *poDefn = poLayer->GetLayerDefn();
+    sCond.iField =
+        OGRFeatureFetcherFixFieldIndex(poDefn, poColumn->field_index);
+    if( sCond.iField < 0 || sCond.iField >= poDefn->GetFieldCount() )
+        return false;
+    const OGRFieldType eType = poDefn->GetFieldDefn(sCond.iField)->GetType();
+
+    OGRIndexValueStatus eStatus = OGR_INDEX_VALUE_OK;
+    switch( nOperation )
+    {
+      case SWQ_EQ:
+      case SWQ_IN:
+      {
+        if( nOperation == SWQ_EQ && psExpr->nSubExprCount != 2 )
+            return false;
+        for( int i = 1; i < psExpr->nSubExprCount; i++ )
+        {
+            OGRField sValue;
+            bool bIncluded = true;
+            const swq_expr_node *poItem =
+                i == 1 ? poValue : psExpr->papoSubExpr[i];
+            eStatus = OGRGetIndexValue(poItem, eType, 0, sValue, bIncluded);
+            if( eStatus == OGR_INDEX_VALUE_UNSUPPORTED )
+                return false;
+            if( eStatus == OGR_INDEX_VALUE_OK )
+                sCond.asValues.push_back(sValue);
+        }
+        sCond.bEmpty = sCond.asValues.empty();
+        return true;
+      }
+
+      case SWQ_LT:
+      case SWQ_LE:
+        if( psExpr->nSubExprCount != 2 )
+            return false;
+        sCond.bMaxIncluded = nOperation == SWQ_LE;
+        eStatus = OGRGetIndexValue(poValue, eType, 1, sCond.sMax,
+                                   sCond.bMaxIncluded);
+        sCond.bHasMax = eStatus == OGR_INDEX_VALUE_OK;
+        break;
+
+      case SWQ_GT:
+      case SWQ_GE:
+        if( psExpr->nSubExprCount != 2 )
+            return false;
+        sCond.bMinIncluded = nOperation == SWQ_GE;
+        eStatus = OGRGetIndexValue(poValue, eType, -1, sCond.sMin,
+                                   sCond.bMinIncluded);
+        sCond.bHasMin = eStatus == OGR_INDEX_VALUE_OK;
+        break;
+
+      case SWQ_BETWEEN:
+      {
+        if( psExpr->nSubExprCount != 3 )
+            return false;
+        eStatus = OGRGetIndexValue(poValue, eType, -1, sCond.sMin,
+                                   sCond.bMinIncluded);
+        sCond.bHasMin = eStatus == OGR_INDEX_VALUE_OK;
+        if( eStatus == OGR_INDEX_VALUE_UNSUPPORTED ||
+            eStatus == OGR_INDEX_VALUE_EMPTY )
+            break;
+        eStatus = OGRGetIndexValue(psExpr->papoSubExpr[2], eType, 1,
+                                   sCond.sMax, sCond.bMaxIncluded);
+        sCond.bHasMax = eStatus == OGR_INDEX_VALUE_OK;
+        break;
+      }
+
+      case SWQ_LIKE:
+      {
+        if( eType != OFTString || poValue->eNodeType != SNT_CONSTANT ||
+            poValue->field_type != SWQ_STRING || poValue->is_null )
+            return false;
+        char chEscape = '\0';
+        if( psExpr->nSubExprCount == 3 )
+        {
+            const swq_expr_node *poEscape = psExpr->papoSubExpr[2];
+            if( poEscape->eNodeType != SNT_CONSTANT ||
+                poEscape->field_type != SWQ_STRING )
+                return false;
+            chEscape = poEscape->string_value[0];
+        }
+        // The literal characters before the first wildcard.
+        for( const char *pszIter = poValue->string_value;
+             *pszIter != '\0'; pszIter++ )
+        {
+            if( *pszIter == chEscape )
+            {
+                pszIter++;
+                if( *pszIter == '\0' )
+                    break;
+            }
+            else if( *pszIter == '%' || *pszIter == '_' )
+                break;
+            sCond.osPrefix += *pszIter;
+        }
+        break;
+      }
+
+      default:
+        return false;
+    }
+
+    if( eStatus == OGR_INDEX_VALUE_UNSUPPORTED )
+        return false;
+    sCond.bEmpty = eStatus == OGR_INDEX_VALUE_EMPTY;
+    return sCond.bEmpty || sCond.HasRange();
+}
+
+/************************************************************************/
+/*                         OGRGetIndexOnField()                         */
+/*                                                                      */
+/*      Return the index on the field, or else an index whose first     */
+/*      key is the field.                                               */
+/************************************************************************/
+
+static OGRAttrIndex *OGRGetIndexOnField( OGRLayer *poLayer, int iField )
+{
+    OGRLayerAttrIndex *poLIndex = poLayer->GetIndex();
+    OGRAttrIndex *poIndex = poLIndex->GetFieldIndex(iField);
+    for( int i = 0; poIndex == nullptr &&
+                    i < poLIndex->GetAttrIndexCount(); i++ )
+    {
+        OGRAttrIndex *poCandidate = poLIndex->GetAttrIndex(i);
+        if( poCandidate != nullptr && poCandidate->GetKeyField(0) == iField )
+            poIndex = poCandidate;
+    }
+    return poIndex;
+}
+
+/************************************************************************/
+/*                           OGRQueryIndex()                            */
+/************************************************************************/
+
+static GIntBig *OGRQueryIndex( OGRAttrIndex *poIndex, int nEqualCount,
+                               const OGRField *pasEqual,
+                               const OGRIndexedCondition *psRange,
+                               GIntBig &nFIDCount )
+{
+    OGRAttrIndexRange sRange;
+    sRange.nEqualCount = nEqualCount;
+    sRange.pasEqual = pasEqual;
+    if( psRange != nullptr )
+    {
+        if( psRange->bHasMin )
+        {
+            sRange.psMin = &psRange->sMin;
+            sRange.bMinIncluded = psRange->bMinIncluded;
+        }
+        if( psRange->bHasMax )
+        {
+            sRange.psMax = &psRange->sMax;
+            sRange.bMaxIncluded = psRange->bMaxIncluded;
+        }
+        if( !psRange->osPrefix.empty() )
+            sRange.pszPrefix = psRange->osPrefix.c_str();
+    }
+
+    nFIDCount = 0;
+    GIntBig *panFIDs = poIndex->GetRangeMatches(sRange, &nFIDCount);
+    if( panFIDs != nullptr || psRange != nullptr || nEqualCount != 1 )
+        return panFIDs;
+
+    // Indexes only answering equality tests.
+    int nLength = 0;
+    int nFIDCount32 = 0;
+    panFIDs = poIndex->GetAllMatches(const_cast<OGRField *>(pasEqual),
+                                     nullptr, &nFIDCount32, &nLength);
+    nFIDCount = nFIDCount32;
+    // The returned FIDs are expected to be sorted.
+    std::sort(panFIDs, panFIDs + nFIDCount);
+    return panFIDs;
+}
+
+/************************************************************************/
+/*                    OGREvaluateIndexedCondition()                     */
+/************************************************************************/
+
+static GIntBig *OGREvaluateIndexedCondition( OGRLayer *poLayer,
+                                             const OGRIndexedCondition &sCond,
+                                             GIntBig &nFIDCount )
+{
+    nFIDCount = 0;
+    if( sCond.bEmpty )
+    {
+        GIntBig *panFIDs = static_cast<GIntBig *>(CPLMalloc(sizeof(GIntBig)));
+        panFIDs[0] = OGRNullFID;
+        return panFIDs;
+    }
+
+    OGRAttrIndex *poIndex = OGRGetIndexOnField(poLayer, sCond.iField);
+    if( poIndex == nullptr )
+        return nullptr;
+
+    if( sCond.asValues.empty() )
+        return OGRQueryIndex(poIndex, 0, nullptr, &sCond, nFIDCount);
+
+    // Handle the values of an IN operation.
+    std::vector<GIntBig> anFIDs;
+    for( const OGRField &sValue: sCond.asValues )
+    {
+        GIntBig nValueFIDCount = 0;
+        GIntBig *panValueFIDs =
+            OGRQueryIndex(poIndex, 1, &sValue, nullptr, nValueFIDCount);
+        if( panValueFIDs == nullptr )
+            return nullptr;
+        anFIDs.insert(anFIDs.end(), panValueFIDs,
+                      panValueFIDs + nValueFIDCount);
+        CPLFree(panValueFIDs);
+    }
+    if( sCond.asValues.size() > 1 )
+    {
+        std::sort(anFIDs.begin(), anFIDs.end());
+        anFIDs.erase(std::unique(anFIDs.begin(), anFIDs.end()), anFIDs.end());
+    }
+
+    GIntBig *panFIDs = static_cast<GIntBig *>(
+        CPLMalloc((anFIDs.size() + 1) * sizeof(GIntBig)));
+    if( !anFIDs.empty() )
+        memcpy(panFIDs, anFIDs.data(), anFIDs.size() * sizeof(GIntBig));
+    panFIDs[anFIDs.size()] = OGRNullFID;
+    nFIDCount = static_cast<GIntBig>(anFIDs.size());
+    return panFIDs;
+}
+
+/************************************************************************/
+/*                        OGRCollectConjuncts()                         */
+/************************************************************************/
+
+static void OGRCollectConjuncts( swq_expr_node *psExpr,
+                                 std::vector<swq_expr_node *> &apoConjuncts )
+{
+    if( psExpr->eNodeType == SNT_OPERATION &&
+        psExpr->nOperation == SWQ_AND && psExpr->nSubExprCount == 2 )
+    {
+        OGRCollectConjuncts(psExpr->papoSubExpr[0], apoConjuncts);
+        OGRCollectConjuncts(psExpr->papoSubExpr[1], apoConjuncts);
+    }
+    else
+    {
+        apoConjuncts.push_back(psExpr);
+    }
+}
+
 /************************************************************************/
 /*                            CanUseIndex()                             */
 /************************************************************************/
@@ -373,33 +1702,26 @@ int OGRFeatureQuery::CanUseIndex( swq_expr_node *psExpr,
     if( psExpr == nullptr || psExpr->eNodeType != SNT_OPERATION )
         return FALSE;
 
-    if( (psExpr->nOperation == SWQ_OR || psExpr->nOperation == SWQ_AND) &&
-         psExpr->nSubExprCount == 2 )
+    if( psExpr->nOperation == SWQ_OR && psExpr->nSubExprCount == 2 )
     {
         return CanUseIndex(psExpr->papoSubExpr[0], poLayer) &&
                CanUseIndex(psExpr->papoSubExpr[1], poLayer);
     }
 
-    if( !(psExpr->nOperation == SWQ_EQ || psExpr->nOperation == SWQ_IN)
-        || psExpr->nSubExprCount < 2 )
-        return FALSE;
-
-    swq_expr_node *poColumn = psExpr->papoSubExpr[0];
-    swq_expr_node *poValue = psExpr->papoSubExpr[1];
-
-    if( poColumn->eNodeType != SNT_COLUMN
-        || poValue->eNodeType != SNT_CONSTANT )
-        return FALSE;
+    // A conjunction can be answered, possibly partially, from any of its
+    // terms.
+    if( psExpr->nOperation == SWQ_AND && psExpr->nSubExprCount == 2 )
+    {
+        return CanUseIndex(psExpr->papoSubExpr[0], poLayer) ||
+               CanUseIndex(psExpr->papoSubExpr[1], poLayer);
+    }
 
-    OGRAttrIndex *poIndex =
-        poLayer->GetIndex()->GetFieldIndex(
-            OGRFeatureFetcherFixFieldIndex(poLayer->GetLayerDefn(),
-                                           poColumn->field_index));
-    if( poIndex == nullptr )
+    OGRIndexedCondition sCond;
+    if( !OGRParseIndexedCondition(psExpr, poLayer, sCond) )
         return FALSE;
 
-    // Have an index.
-    return TRUE;
+    return sCond.bEmpty ||
+           OGRGetIndexOnField(poLayer, sCond.iField) != nullptr;
 }
 
 /************************************************************************/
@@ -411,23 +1733,14 @@ int OGRFeatureQuery::CanUseIndex( swq_expr_node *psExpr,
 /*      available indices, or an "OGRNullFID" terminated list of        */
 /*      FIDs if it can.                                                 */
 /*                                                                      */
-/*      For now we only support equality tests on a single indexed      */
-/*      attribute field.  Eventually we should make this support        */
-/*      multi-part queries with ranges.                                 */
+/*      Equality, IN, range, BETWEEN and LIKE 'prefix%' tests are       */
+/*      supported, and conjunctions of them can use indexes on          */
+/*      several fields.  The terms of a conjunction that cannot use     */
+/*      an index are ignored, so the list may contain FIDs of           */
+/*      features not matching the query : callers must evaluate it     */
+/*      on the returned features.                                       */
 /************************************************************************/
 
-static int CompareGIntBig( const void *pa, const void *pb )
-{
-    const GIntBig a = *(reinterpret_cast<const GIntBig *>(pa));
-    const GIntBig b = *(reinterpret_cast<const GIntBig *>(pb));
-    if( a < b )
-        return -1;
-    else if( a > b )
-        return 1;
-    else
-        return 0;
-}
-
 GIntBig *OGRFeatureQuery::EvaluateAgainstIndices( OGRLayer *poLayer,
                                                   OGRErr *peErr )
 
@@ -579,8 +1892,7 @@ GIntBig *OGRFeatureQuery::EvaluateAgainstIndices( swq_expr_node *psExpr,
         psExpr->eNodeType != SNT_OPERATION )
         return nullptr;
 
-    if( (psExpr->nOperation == SWQ_OR || psExpr->nOperation == SWQ_AND) &&
-         psExpr->nSubExprCount == 2 )
+    if( psExpr->nOperation == SWQ_OR && psExpr->nSubExprCount == 2 )
     {
         GIntBig nFIDCount1 = 0;
         GIntBig nFIDCount2 = 0;
@@ -592,141 +1904,203 @@ GIntBig *OGRFeatureQuery::EvaluateAgainstIndices( swq_expr_node *psExpr,
         GIntBig* panFIDList = nullptr;
         if( panFIDList1 != nullptr && panFIDList2 != nullptr )
         {
-            if( psExpr->nOperation == SWQ_OR )
-                panFIDList = OGRORGIntBigArray(panFIDList1, nFIDCount1,
-                                            panFIDList2, nFIDCount2, nFIDCount);
-            else if( psExpr->nOperation == SWQ_AND )
-                panFIDList = OGRANDGIntBigArray(panFIDList1, nFIDCount1,
-                                            panFIDList2, nFIDCount2, nFIDCount);
+            panFIDList = OGRORGIntBigArray(panFIDList1, nFIDCount1,
+                                           panFIDList2, nFIDCount2, nFIDCount);
         }
         CPLFree(panFIDList1);
         CPLFree(panFIDList2);
         return panFIDList;
     }
 
-    if( !(psExpr->nOperation == SWQ_EQ || psExpr->nOperation == SWQ_IN)
-        || psExpr->nSubExprCount < 2 )
-        return nullptr;
-
-    swq_expr_node *poColumn = psExpr->papoSubExpr[0];
-    swq_expr_node *poValue = psExpr->papoSubExpr[1];
-
-    if( poColumn->eNodeType != SNT_COLUMN
-        || poValue->eNodeType != SNT_CONSTANT )
-        return nullptr;
+    if( psExpr->nOperation != SWQ_AND )
+    {
+        OGRIndexedCondition sCond;
+        if( !OGRParseIndexedCondition(psExpr, poLayer, sCond) )
+            return nullptr;
+        return OGREvaluateIndexedCondition(poLayer, sCond, nFIDCount);
+    }
 
-    const int nIdx = OGRFeatureFetcherFixFieldIndex(
-        poLayer->GetLayerDefn(), poColumn->field_index);
+/* -------------------------------------------------------------------- */
+/*      Split the conjunction in its terms.  Terms that are not field   */
+/*      conditions, such as disjunctions, are evaluated on their own.   */
+/* -------------------------------------------------------------------- */
+    GIntBig *panFIDList = nullptr;
+    nFIDCount = 0;
+    const auto Intersect = [&panFIDList, &nFIDCount](GIntBig *panOther,
+                                                     GIntBig nOtherCount)
+    {
+        if( panFIDList == nullptr )
+        {
+            panFIDList = panOther;
+            nFIDCount = nOtherCount;
+            return;
+        }
+        GIntBig *panResult = OGRANDGIntBigArray(panFIDList, nFIDCount,
+                                                panOther, nOtherCount,
+                                                nFIDCount);
+        CPLFree(panFIDList);
+        CPLFree(panOther);
+        panFIDList = panResult;
+    };
+
+    std::vector<swq_expr_node *> apoConjuncts;
+    OGRCollectConjuncts(psExpr, apoConjuncts);
+    std::vector<OGRIndexedCondition> asConds;
+    for( swq_expr_node *poConjunct: apoConjuncts )
+    {
+        OGRIndexedCondition sCond;
+        if( OGRParseIndexedCondition(poConjunct, poLayer, sCond) )
+        {
+            if( sCond.bEmpty )
+            {
+                CPLFree(panFIDList);
+                return OGREvaluateIndexedCondition(poLayer, sCond,
+                                                   nFIDCount);
+            }
+            asConds.push_back(sCond);
+            continue;
+        }
 
-    OGRAttrIndex *poIndex =
-        poLayer->GetIndex()->GetFieldIndex(nIdx);
-    if( poIndex == nullptr )
-        return nullptr;
+        GIntBig nOtherCount = 0;
+        GIntBig *panOther =
+            EvaluateAgainstIndices(poConjunct, poLayer, nOtherCount);
+        if( panOther != nullptr )
+            Intersect(panOther, nOtherCount);
+    }
 
-    // Have an index, now we need to query it.
-    OGRField sValue;
-    OGRFieldDefn *poFieldDefn =
-        poLayer->GetLayerDefn()->GetFieldDefn(nIdx);
+/* -------------------------------------------------------------------- */
+/*      Repeatedly pick the index answering the most conditions :       */
+/*      equality on its leading key fields, and a range on the next     */
+/*      one.                                                            */
+/* -------------------------------------------------------------------- */
+    OGRLayerAttrIndex *poLIndex = poLayer->GetIndex();
+    std::vector<OGRAttrIndex *> apoIndexes;
+    for( int i = 0; i < poLIndex->GetAttrIndexCount(); i++ )
+    {
+        if( poLIndex->GetAttrIndex(i) != nullptr )
+            apoIndexes.push_back(poLIndex->GetAttrIndex(i));
+    }
+    for( const OGRIndexedCondition &sCond: asConds )
+    {
+        OGRAttrIndex *poIndex = poLIndex->GetFieldIndex(sCond.iField);
+        if( poIndex != nullptr &&
+            std::find(apoIndexes.begin(), apoIndexes.end(), poIndex) ==
+                                                        apoIndexes.end() )
+            apoIndexes.push_back(poIndex);
+    }
 
-    // Handle the case of an IN operation.
-    if( psExpr->nOperation == SWQ_IN )
+    std::vector<bool> abUsed(asConds.size(), false);
+    while( !apoIndexes.empty() && (panFIDList == nullptr || nFIDCount > 0) )
     {
-        int nLength = 0;
-        GIntBig *panFIDs = nullptr;
-        nFIDCount = 0;
+        size_t iBestIndex = 0;
+        int nBestScore = 0;
+        std::vector<size_t> anBestConds;
+        std::vector<OGRField> asBestEqual;
+        OGRIndexedCondition sBestRange;
 
-        for( int iIN = 1; iIN < psExpr->nSubExprCount; iIN++ )
+        for( size_t iIndex = 0; iIndex < apoIndexes.size(); iIndex++ )
         {
-            switch( poFieldDefn->GetType() )
+            OGRAttrIndex *poIndex = apoIndexes[iIndex];
+            std::vector<size_t> anConds;
+            std::vector<OGRField> asEqual;
+            OGRIndexedCondition sRange;
+            for( int iKey = 0; iKey < poIndex->GetKeyFieldCount(); iKey++ )
             {
-              case OFTInteger:
-                if( psExpr->papoSubExpr[iIN]->field_type == SWQ_FLOAT )
-                    sValue.Integer =
-                        static_cast<int>(psExpr->papoSubExpr[iIN]->float_value);
-                else
-                    sValue.Integer =
-                        static_cast<int>(psExpr->papoSubExpr[iIN]->int_value);
-                break;
-
-              case OFTInteger64:
-                if( psExpr->papoSubExpr[iIN]->field_type == SWQ_FLOAT )
-                    sValue.Integer64 = static_cast<GIntBig>(
-                        psExpr->papoSubExpr[iIN]->float_value);
-                else
-                    sValue.Integer64 = psExpr->papoSubExpr[iIN]->int_value;
-                break;
-
-              case OFTReal:
-                sValue.Real = psExpr->papoSubExpr[iIN]->float_value;
-                break;
+                const int iField = poIndex->GetKeyField(iKey);
+                size_t i = 0;
+                for( ; i < asConds.size(); i++ )
+                {
+                    if( !abUsed[i] && asConds[i].iField == iField &&
+                        asConds[i].asValues.size() == 1 )
+                        break;
+                }
+                if( i < asConds.size() )
+                {
+                    anConds.push_back(i);
+                    asEqual.push_back(asConds[i].asValues[0]);
+                    continue;
+                }
 
-              case OFTString:
-                sValue.String = psExpr->papoSubExpr[iIN]->string_value;
+                // Combine the bounds and prefix of the conditions on the
+                // field.
+                for( i = 0; i < asConds.size(); i++ )
+                {
+                    const OGRIndexedCondition &sCond = asConds[i];
+                    if( abUsed[i] || sCond.iField != iField ||
+                        !sCond.asValues.empty() )
+                        continue;
+                    bool bUseCond = false;
+                    if( sCond.bHasMin && !sRange.bHasMin )
+                    {
+                        sRange.bHasMin = true;
+                        sRange.sMin = sCond.sMin;
+                        sRange.bMinIncluded = sCond.bMinIncluded;
+                        bUseCond = true;
+                    }
+                    if( sCond.bHasMax && !sRange.bHasMax )
+                    {
+                        sRange.bHasMax = true;
+                        sRange.sMax = sCond.sMax;
+                        sRange.bMaxIncluded = sCond.bMaxIncluded;
+                        bUseCond = true;
+                    }
+                    if( !sCond.osPrefix.empty() && sRange.osPrefix.empty() )
+                    {
+                        sRange.osPrefix = sCond.osPrefix;
+                        bUseCond = true;
+                    }
+                    if( bUseCond )
+                        anConds.push_back(i);
+                }
                 break;
-
-              default:
-                CPLAssert(false);
-                return nullptr;
             }
 
-            int nFIDCount32 = static_cast<int>(nFIDCount);
-            panFIDs = poIndex->GetAllMatches(&sValue, panFIDs,
-                                             &nFIDCount32, &nLength);
-            nFIDCount = nFIDCount32;
+            const int nScore = 2 * static_cast<int>(asEqual.size()) +
+                               (sRange.HasRange() ? 1 : 0);
+            if( nScore > nBestScore )
+            {
+                nBestScore = nScore;
+                iBestIndex = iIndex;
+                anBestConds = anConds;
+                asBestEqual = asEqual;
+                sBestRange = sRange;
+            }
         }
+        if( nBestScore == 0 )
+            break;
 
-        if( nFIDCount > 1 )
+        GIntBig nOtherCount = 0;
+        GIntBig *panOther = OGRQueryIndex(
+            apoIndexes[iBestIndex], static_cast<int>(asBestEqual.size()),
+            asBestEqual.data(),
+            sBestRange.HasRange() ? &sBestRange : nullptr, nOtherCount);
+        if( panOther != nullptr )
         {
-            // The returned FIDs are expected to be in sorted order.
-            qsort(panFIDs, static_cast<size_t>(nFIDCount),
-                  sizeof(GIntBig), CompareGIntBig);
+            for( size_t i: anBestConds )
+                abUsed[i] = true;
+            Intersect(panOther, nOtherCount);
         }
-        return panFIDs;
-    }
-
-    // Handle equality test.
-    switch( poFieldDefn->GetType() )
-    {
-      case OFTInteger:
-        if( poValue->field_type == SWQ_FLOAT )
-            sValue.Integer = static_cast<int>(poValue->float_value);
-        else
-            sValue.Integer = static_cast<int>(poValue->int_value);
-        break;
-
-      case OFTInteger64:
-        if( poValue->field_type == SWQ_FLOAT )
-            sValue.Integer64 = static_cast<GIntBig>(poValue->float_value);
         else
-            sValue.Integer64 = poValue->int_value;
-        break;
-
-      case OFTReal:
-        sValue.Real = poValue->float_value;
-        break;
-
-      case OFTString:
-        sValue.String = poValue->string_value;
-        break;
-
-      default:
-        CPLAssert(false);
-        return nullptr;
+        {
+            // This index cannot answer range queries.
+            apoIndexes.erase(apoIndexes.begin() + iBestIndex);
+        }
     }
 
-    int nLength = 0;
-    int nFIDCount32 = 0;
-    GIntBig* panFIDs =
-        poIndex->GetAllMatches(&sValue, nullptr, &nFIDCount32, &nLength);
-    nFIDCount = nFIDCount32;
-    if( nFIDCount > 1 )
+    // Remaining IN conditions.
+    for( size_t i = 0; i < asConds.size(); i++ )
     {
-        // The returned FIDs are expected to be sorted.
-        // TODO(schwehr): Use std::sort.
-        qsort(panFIDs, static_cast<size_t>(nFIDCount),
-              sizeof(GIntBig), CompareGIntBig);
+        if( abUsed[i] || asConds[i].asValues.size() < 2 ||
+            (panFIDList != nullptr && nFIDCount == 0) )
+            continue;
+        GIntBig nOtherCount = 0;
+        GIntBig *panOther =
+            OGREvaluateIndexedCondition(poLayer, asConds[i], nOtherCount);
+        if( panOther != nullptr )
+            Intersect(panOther, nOtherCount);
     }
-    return panFIDs;
+
+    return panFIDList;
 }
 
 /************************************************************************/
@@ -57,6 +57,7 @@ int DoubleToIntClamp(double dfValue) {
 /** Constructor */
 OGRSimpleCurve::OGRSimpleCurve() :
     nPointCount(0),
+    m_nPointCapacity(0),
     paoPoints(nullptr),
     padfZ(nullptr),
     padfM(nullptr)
@@ -78,6 +79,7 @@ OGRSimpleCurve::OGRSimpleCurve() :
 OGRSimpleCurve::OGRSimpleCurve( const OGRSimpleCurve& other ) :
     OGRCurve(other),
     nPointCount(0),
+    m_nPointCapacity(0),
     paoPoints(nullptr),
     padfZ(nullptr),
     padfM(nullptr)
@@ -236,12 +238,11 @@ void OGRSimpleCurve::Make3D()
 {
     if( padfZ == nullptr )
     {
-        if( nPointCount == 0 )
-            padfZ =
-                static_cast<double *>(VSI_CALLOC_VERBOSE(sizeof(double), 1));
-        else
-            padfZ = static_cast<double *>(VSI_CALLOC_VERBOSE(
-                sizeof(double), nPointCount));
+        // Allocate as many values as there is room for points, so that the
+        // point array can grow up to its capacity without reallocating Z.
+        const int nAlloc = std::max(1, std::max(nPointCount, m_nPointCapacity));
+        padfZ = static_cast<double *>(
+            VSI_CALLOC_VERBOSE(sizeof(double), nAlloc));
         if( padfZ == nullptr )
         {
             flags &= ~OGR_G_3D;
@@ -277,12 +278,10 @@ void OGRSimpleCurve::AddM()
 {
     if( padfM == nullptr )
     {
-        if( nPointCount == 0 )
-            padfM =
-                static_cast<double *>(VSI_CALLOC_VERBOSE(sizeof(double), 1));
-        else
-            padfM = static_cast<double *>(
-                VSI_CALLOC_VERBOSE(sizeof(double), nPointCount));
+        // See Make3D().
+        const int nAlloc = std::max(1, std::max(nPointCount, m_nPointCapacity));
+        padfM = static_cast<double *>(
+            VSI_CALLOC_VERBOSE(sizeof(double), nAlloc));
         if( padfM == nullptr )
         {
             flags &= ~OGR_G_MEASURED;
@@ -448,10 +447,13 @@ void OGRSimpleCurve::setNumPoints( int nNewPointCount, int bZeroizeNewContent )
         padfM = nullptr;
 
         nPointCount = 0;
+        m_nPointCapacity = 0;
         return;
     }
 
-    if( nNewPointCount > nPointCount )
+    // Shrinking keeps the arrays, so that refilling a curve that is reused
+    // for a series of features does not reallocate them.
+    if( nNewPointCount > m_nPointCapacity )
     {
         OGRRawPoint* paoNewPoints = static_cast<OGRRawPoint *>(
             VSI_REALLOC_VERBOSE(paoPoints,
@@ -462,19 +464,9 @@ void OGRSimpleCurve::setNumPoints( int nNewPointCount, int bZeroizeNewContent )
         }
         paoPoints = paoNewPoints;
 
-        if( bZeroizeNewContent )
-        {
-            // gcc 8.0 (dev) complains about -Wclass-memaccess since
-            // OGRRawPoint() has a constructor. So use a void* pointer.  Doing
-            // the memset() here is correct since the constructor sets to 0.  We
-            // could instead use a std::fill(), but at every other place, we
-            // treat this class as a regular POD (see above use of realloc())
-            void* dest = static_cast<void*>(paoPoints + nPointCount);
-            memset( dest,
-                    0, sizeof(OGRRawPoint) * (nNewPointCount - nPointCount) );
-        }
-
-        if( flags & OGR_G_3D )
+        // Allocated Z and M arrays always have m_nPointCapacity values,
+        // even when the flags were cleared without freeing them.
+        if( (flags & OGR_G_3D) || padfZ != nullptr )
         {
             double* padfNewZ = static_cast<double *>(
                 VSI_REALLOC_VERBOSE(padfZ, sizeof(double) * nNewPointCount));
@@ -483,12 +475,9 @@ void OGRSimpleCurve::setNumPoints( int nNewPointCount, int bZeroizeNewContent )
                 return;
             }
             padfZ = padfNewZ;
-            if( bZeroizeNewContent )
-                memset( padfZ + nPointCount, 0,
-                    sizeof(double) * (nNewPointCount - nPointCount) );
         }
 
-        if( flags & OGR_G_MEASURED )
+        if( (flags & OGR_G_MEASURED) || padfM != nullptr )
         {
             double* padfNewM = static_cast<double *>(
                 VSI_REALLOC_VERBOSE(padfM, sizeof(double) * nNewPointCount));
@@ -497,10 +486,46 @@ void OGRSimpleCurve::setNumPoints( int nNewPointCount, int bZeroizeNewContent )
                 return;
             }
             padfM = padfNewM;
-            if( bZeroizeNewContent )
-                memset( padfM + nPointCount, 0,
-                    sizeof(double) * (nNewPointCount - nPointCount) );
         }
+
+        m_nPointCapacity = nNewPointCount;
+    }
+    else
+    {
+        // The dimension flags may have been set directly, e.g. by
+        // importFromWkb(), since the arrays were allocated.
+        if( (flags & OGR_G_3D) && padfZ == nullptr )
+        {
+            padfZ = static_cast<double *>(
+                VSI_CALLOC_VERBOSE(sizeof(double), m_nPointCapacity));
+            if( padfZ == nullptr )
+                return;
+        }
+        if( (flags & OGR_G_MEASURED) && padfM == nullptr )
+        {
+            padfM = static_cast<double *>(
+                VSI_CALLOC_VERBOSE(sizeof(double), m_nPointCapacity));
+            if( padfM == nullptr )
+                return;
+        }
+    }
+
+    if( nNewPointCount > nPointCount && bZeroizeNewContent )
+    {
+        // gcc 8.0 (dev) complains about -Wclass-memaccess since
+        // OGRRawPoint() has a constructor. So use a void* pointer.  Doing
+        // the memset() here is correct since the constructor sets to 0.  We
+        // could instead use a std::fill(), but at every other place, we
+        // treat this class as a regular POD (see above use of realloc())
+        void* dest = static_cast<void*>(paoPoints + nPointCount);
+        memset( dest,
+                0, sizeof(OGRRawPoint) * (nNewPointCount - nPointCount) );
+        if( padfZ )
+            memset( padfZ + nPointCount, 0,
+                sizeof(double) * (nNewPointCount - nPointCount) );
+        if( padfM )
+            memset( padfM + nPointCount, 0,
+                sizeof(double) * (nNewPointCount - nPointCount) );
     }
 
     nPointCount = nNewPointCount;
@@ -1746,8 +1771,14 @@ OGRErr OGRSimpleCurve::importFromWkt( const char ** ppszInput )
     pszInput = OGRWktReadPointsM( pszInput, &paoPoints, &padfZ, &padfM,
                                   &flagsFromInput,
                                   &nMaxPoints, &nPointCount );
+    // OGRWktReadPointsM() reallocated the arrays to nMaxPoints if it read
+    // any point. Otherwise they keep at least this size.
+    m_nPointCapacity = nMaxPoints;
     if( pszInput == nullptr )
+    {
+        nPointCount = 0;
         return OGRERR_CORRUPT_DATA;
+    }
 
     if( (flagsFromInput & OGR_G_3D) && !(flags & OGR_G_3D) )
     {
@@ -2524,6 +2555,7 @@ void OGRSimpleCurve::segmentize( double dfMaxLength )
 
     OGRRawPoint* paoNewPoints = nullptr;
     double* padfNewZ = nullptr;
+    double* padfNewM = nullptr;
     int nNewPointCount = 0;
     const double dfSquareMaxLength = dfMaxLength * dfMaxLength;
     const int nCoordinateDimension = getCoordinateDimension();
@@ -2541,6 +2573,12 @@ void OGRSimpleCurve::segmentize( double dfMaxLength )
                 CPLRealloc(padfNewZ, sizeof(double) * (nNewPointCount + 1)));
             padfNewZ[nNewPointCount] = padfZ[i];
         }
+        if( padfM != nullptr )
+        {
+            padfNewM = static_cast<double *>(
+                CPLRealloc(padfNewM, sizeof(double) * (nNewPointCount + 1)));
+            padfNewM[nNewPointCount] = padfM[i];
+        }
 
         nNewPointCount++;
 
@@ -2569,6 +2607,7 @@ void OGRSimpleCurve::segmentize( double dfMaxLength )
                          nNewPointCount, nIntermediatePoints);
                 CPLFree(paoNewPoints);
                 CPLFree(padfNewZ);
+                CPLFree(padfNewM);
                 return;
             }
 
@@ -2583,6 +2622,13 @@ void OGRSimpleCurve::segmentize( double dfMaxLength )
                                sizeof(double) * (nNewPointCount +
                                                  nIntermediatePoints)));
             }
+            if( padfM != nullptr )
+            {
+                padfNewM = static_cast<double *>(
+                    CPLRealloc(padfNewM,
+                               sizeof(double) * (nNewPointCount +
+                                                 nIntermediatePoints)));
+            }
 
             for( int j = 1; j <= nIntermediatePoints; j++ )
             {
@@ -2595,6 +2641,11 @@ void OGRSimpleCurve::segmentize( double dfMaxLength )
                     // No interpolation.
                     padfNewZ[nNewPointCount + j - 1] = padfZ[i];
                 }
+                if( padfM != nullptr )
+                {
+                    // No interpolation.
+                    padfNewM[nNewPointCount + j - 1] = padfM[i];
+                }
             }
 
             nNewPointCount += nIntermediatePoints;
@@ -2604,12 +2655,24 @@ void OGRSimpleCurve::segmentize( double dfMaxLength )
     CPLFree(paoPoints);
     paoPoints = paoNewPoints;
     nPointCount = nNewPointCount;
+    m_nPointCapacity = nNewPointCount;
 
     if( nCoordinateDimension == 3 )
     {
         CPLFree(padfZ);
         padfZ = padfNewZ;
     }
+    else if( padfZ != nullptr )
+    {
+        // Z is not used, but must stay as large as the point array.
+        CPLFree(padfZ);
+        padfZ = nullptr;
+    }
+    if( padfM != nullptr )
+    {
+        CPLFree(padfM);
+        padfM = padfNewM;
+    }
 }
 
 /************************************************************************/
@@ -2820,10 +2883,12 @@ OGRLineString* OGRLineString::TransferMembersAndDestroy(
         poDst->flags |= OGR_G_MEASURED;
     poDst->assignSpatialReference(poSrc->getSpatialReference());
     poDst->nPointCount = poSrc->nPointCount;
+    poDst->m_nPointCapacity = poSrc->m_nPointCapacity;
     poDst->paoPoints = poSrc->paoPoints;
     poDst->padfZ = poSrc->padfZ;
     poDst->padfM = poSrc->padfM;
     poSrc->nPointCount = 0;
+    poSrc->m_nPointCapacity = 0;
     poSrc->paoPoints = nullptr;
     poSrc->padfZ = nullptr;
     poSrc->padfM = nullptr;
@@ -32,8 +32,11 @@
 #define OGR_CSV_H_INCLUDED
 
 #include "ogrsf_frmts.h"
+#include "ogrsidecarspatialindex.h"
 
+#include <memory>
 #include <set>
+#include <vector>
 
 #if defined(_MSC_VER) && _MSC_VER <= 1600 // MSVC <= 2010
 # define GDAL_OVERRIDE
@@ -94,6 +97,10 @@ class OGRCSVLayer : public OGRLayer
     bool                bHasFieldNames;
 
     OGRFeature         *GetNextUnfilteredFeature();
+    bool                CheckNumericToken( OGRFieldDefn* poFieldDefn,
+                                           char* pszToken );
+    void                CheckStringWidth( OGRFieldDefn* poFieldDefn,
+                                          const char* pszToken );
 
     bool                bNew;
     bool                bInWriteMode;
@@ -144,6 +151,17 @@ class OGRCSVLayer : public OGRLayer
 
     char              **GetNextLineTokens();
 
+    std::unique_ptr<OGRSidecarSpatialIndex> m_poSpatialIndex{};
+    bool                m_bSpatialIndexChecked = false;
+    int                 m_iSpatialIndexGeomField = -1;
+    bool                m_bSpatialIndexCandidatesReady = false;
+    bool                m_bUseSpatialIndexCandidates = false;
+    std::vector<OGRSidecarSpatialIndex::Item> m_asSpatialIndexCandidates{};
+    size_t              m_iNextSpatialIndexCandidate = 0;
+
+    bool                CheckSpatialIndex( int iGeomField, bool bAllowBuild );
+    void                PrepareSpatialIndexCandidates();
+
     static bool         Matches( const char *pszFieldName,
                                  char **papszPossibleNames );
 
@@ -172,6 +190,8 @@ class OGRCSVLayer : public OGRLayer
 
     void                ResetReading() override;
     OGRFeature         *GetNextFeature() override;
+    virtual int         GetNextFeatureBatch( OGRFeatureBatch* poBatch,
+                                             int nMaxRows ) override;
     virtual OGRFeature *GetFeature( GIntBig nFID ) override;
 
     OGRFeatureDefn     *GetLayerDefn() override { return poFeatureDefn; }
@@ -205,6 +225,9 @@ class OGRCSVLayer : public OGRLayer
     virtual OGRErr      SyncToDisk() override;
 
     OGRErr              WriteHeader();
+
+    OGRErr              CreateSpatialIndex( int iGeomField );
+    OGRErr              DropSpatialIndex();
 };
 
 /************************************************************************/
@@ -251,6 +274,10 @@ class OGRCSVDataSource : public OGRDataSource
 
     int                 TestCapability( const char * ) override;
 
+    virtual OGRLayer   *ExecuteSQL( const char *pszStatement,
+                                    OGRGeometry *poSpatialFilter,
+                                    const char *pszDialect ) override;
+
     void                CreateForSingleFile( const char *pszDirname,
                                              const char *pszFilename );
 
@@ -446,6 +446,53 @@ int OGRCSVDataSource::TestCapability( const char * pszCap )
         return FALSE;
 }
 
+/************************************************************************/
+/*                             ExecuteSQL()                             */
+/*                                                                      */
+/*      We override this to provide special handling of spatial         */
+/*      index commands.  Support forms are:                             */
+/*                                                                      */
+/*        CREATE SPATIAL INDEX ON layer_name                            */
+/*        DROP SPATIAL INDEX ON layer_name                              */
+/************************************************************************/
+
+OGRLayer *OGRCSVDataSource::ExecuteSQL( const char *pszStatement,
+                                        OGRGeometry *poSpatialFilter,
+                                        const char *pszDialect )
+
+{
+    const bool bCreate = STARTS_WITH_CI(pszStatement, "CREATE SPATIAL INDEX ON ");
+    const bool bDrop = STARTS_WITH_CI(pszStatement, "DROP SPATIAL INDEX ON ");
+    if( !bCreate && !bDrop )
+        return OGRDataSource::ExecuteSQL( pszStatement, poSpatialFilter,
+                                          pszDialect );
+
+    const char *pszLayerName = pszStatement + (bCreate ? 24 : 22);
+    OGRLayer *poLayer = GetLayerByName(pszLayerName);
+    OGRCSVLayer *poCSVLayer = dynamic_cast<OGRCSVLayer *>(poLayer);
+    if( poCSVLayer == nullptr && poLayer != nullptr )
+    {
+        OGRCSVEditableLayer *poEditableLayer =
+            dynamic_cast<OGRCSVEditableLayer *>(poLayer);
+        if( poEditableLayer != nullptr )
+            poCSVLayer =
+                dynamic_cast<OGRCSVLayer *>(poEditableLayer->GetBaseLayer());
+    }
+    if( poCSVLayer == nullptr )
+    {
+        CPLError( CE_Failure, CPLE_AppDefined,
+                  "No such layer as '%s' in %s SPATIAL INDEX.",
+                  pszLayerName, bCreate ? "CREATE" : "DROP" );
+        return nullptr;
+    }
+
+    if( bCreate )
+        poCSVLayer->CreateSpatialIndex(0);
+    else
+        poCSVLayer->DropSpatialIndex();
+    return nullptr;
+}
+
 /************************************************************************/
 /*                              GetLayer()                              */
 /************************************************************************/
@@ -1391,6 +1391,11 @@ void OGRCSVLayer::ResetReading()
     bNeedRewindBeforeRead = false;
 
     nNextFID = 1;
+
+    m_bSpatialIndexCandidatesReady = false;
+    m_bUseSpatialIndexCandidates = false;
+    m_asSpatialIndexCandidates.clear();
+    m_iNextSpatialIndexCandidate = 0;
 }
 
 /************************************************************************/
@@ -1436,6 +1441,105 @@ OGRFeature *OGRCSVLayer::GetFeature(GIntBig nFID)
     return GetNextUnfilteredFeature();
 }
 
+/************************************************************************/
+/*                         CheckNumericToken()                          */
+/*                                                                      */
+/*      Check that a token is a valid value for a numeric field,        */
+/*      emitting the one-time warning otherwise. Might replace the      */
+/*      decimal comma of semicolon separated files in place.            */
+/************************************************************************/
+
+bool OGRCSVLayer::CheckNumericToken( OGRFieldDefn* poFieldDefn,
+                                     char* pszToken )
+{
+    const OGRFieldType eFieldType = poFieldDefn->GetType();
+    if( chDelimiter == ';' && eFieldType == OFTReal )
+    {
+        char *chComma = strchr(pszToken, ',');
+        if( chComma )
+            *chComma = '.';
+    }
+    const CPLValueType eType = CPLGetValueType(pszToken);
+    if( eType == CPL_VALUE_INTEGER || eType == CPL_VALUE_REAL )
+    {
+        if( !bWarningBadTypeOrWidth &&
+            (eFieldType == OFTInteger ||
+             eFieldType == OFTInteger64) &&
+            eType == CPL_VALUE_REAL )
+        {
+            bWarningBadTypeOrWidth = true;
+            CPLError(CE_Warning, CPLE_AppDefined,
+                     "Invalid value type found in record %d for "
+                     "field %s. "
+                     "This warning will no longer be emitted",
+                     nNextFID, poFieldDefn->GetNameRef());
+        }
+        else if( !bWarningBadTypeOrWidth &&
+                 poFieldDefn->GetWidth() > 0 &&
+                 static_cast<int>(strlen(pszToken)) >
+                     poFieldDefn->GetWidth() )
+        {
+            bWarningBadTypeOrWidth = true;
+            CPLError(CE_Warning, CPLE_AppDefined,
+                     "Value with a width greater than field width "
+                     "found in record %d for field %s. "
+                     "This warning will no longer be emitted",
+                     nNextFID, poFieldDefn->GetNameRef());
+        }
+        else if( !bWarningBadTypeOrWidth &&
+                 eType == CPL_VALUE_REAL &&
+                 poFieldDefn->GetWidth() > 0)
+        {
+            const char *pszDot = strchr(pszToken, '.');
+            const int nPrecision =
+                pszDot != nullptr
+                    ? static_cast<int>(strlen(pszDot + 1))
+                    : 0;
+            if( nPrecision > poFieldDefn->GetPrecision() )
+            {
+                bWarningBadTypeOrWidth = true;
+                CPLError(CE_Warning, CPLE_AppDefined,
+                         "Value with a precision greater than "
+                         "field precision found in record %d for "
+                         "field %s. "
+                         "This warning will no longer be emitted",
+                         nNextFID, poFieldDefn->GetNameRef());
+            }
+        }
+        return true;
+    }
+
+    if( !bWarningBadTypeOrWidth )
+    {
+        bWarningBadTypeOrWidth = true;
+        CPLError(
+            CE_Warning, CPLE_AppDefined,
+            "Invalid value type found in record %d for field "
+            "%s. This warning will no longer be emitted.",
+            nNextFID, poFieldDefn->GetNameRef());
+    }
+    return false;
+}
+
+/************************************************************************/
+/*                          CheckStringWidth()                          */
+/************************************************************************/
+
+void OGRCSVLayer::CheckStringWidth( OGRFieldDefn* poFieldDefn,
+                                    const char* pszToken )
+{
+    if( !bWarningBadTypeOrWidth && poFieldDefn->GetWidth() > 0 &&
+        static_cast<int>(strlen(pszToken)) > poFieldDefn->GetWidth() )
+    {
+        bWarningBadTypeOrWidth = true;
+        CPLError(CE_Warning, CPLE_AppDefined,
+                 "Value with a width greater than field width "
+                 "found in record %d for field %s. "
+                 "This warning will no longer be emitted",
+                 nNextFID, poFieldDefn->GetNameRef());
+    }
+}
+
 /************************************************************************/
 /*                      GetNextUnfilteredFeature()                      */
 /************************************************************************/
@@ -1458,7 +1562,6 @@ OGRFeature *OGRCSVLayer::GetNextUnfilteredFeature()
     int iOGRField = 0;
     const int nAttrCount = std::min(
         CSLCount(papszTokens), nCSVFieldCount + (bHiddenWKTColumn ? 1 : 0));
-    CPLValueType eType;
 
     for( int iAttr = 0; !bIsEurostatTSV && iAttr < nAttrCount; iAttr++ )
     {
@@ -1550,73 +1653,8 @@ OGRFeature *OGRCSVLayer::GetNextUnfilteredFeature()
         {
             if( papszTokens[iAttr][0] != '\0' && !poFieldDefn->IsIgnored() )
             {
-                if( chDelimiter == ';' && eFieldType == OFTReal )
-                {
-                    char *chComma = strchr(papszTokens[iAttr], ',');
-                    if( chComma )
-                        *chComma = '.';
-                }
-                eType = CPLGetValueType(papszTokens[iAttr]);
-                if( eType == CPL_VALUE_INTEGER || eType == CPL_VALUE_REAL )
-                {
+                if( CheckNumericToken(poFieldDefn, papszTokens[iAttr]) )
                     poFeature->SetField(iOGRField, papszTokens[iAttr]);
-                    if( !bWarningBadTypeOrWidth &&
-                        (eFieldType == OFTInteger ||
-                         eFieldType == OFTInteger64) &&
-                        eType == CPL_VALUE_REAL )
-                    {
-                        bWarningBadTypeOrWidth = true;
-                        CPLError(CE_Warning, CPLE_AppDefined,
-                                 "Invalid value type found in record %d for "
-                                 "field %s. "
-                                 "This warning will no longer be emitted",
-                                 nNextFID, poFieldDefn->GetNameRef());
-                    }
-                    else if( !bWarningBadTypeOrWidth &&
-                             poFieldDefn->GetWidth() > 0 &&
-                             static_cast<int>(strlen(papszTokens[iAttr])) >
-                                 poFieldDefn->GetWidth() )
-                    {
-                        bWarningBadTypeOrWidth = true;
-                        CPLError(CE_Warning, CPLE_AppDefined,
-                                 "Value with a width greater than field width "
-                                 "found in record %d for field %s. "
-                                 "This warning will no longer be emitted",
-                                 nNextFID, poFieldDefn->GetNameRef());
-                    }
-                    else if( !bWarningBadTypeOrWidth &&
-                             eType == CPL_VALUE_REAL &&
-                             poFieldDefn->GetWidth() > 0)
-                    {
-                        const char *pszDot = strchr(papszTokens[iAttr], '.');
-                        const int nPrecision =
-                            pszDot != nullptr
-                                ? static_cast<int>(strlen(pszDot + 1))
-                                : 0;
-                        if( nPrecision > poFieldDefn->GetPrecision() )
-                        {
-                            bWarningBadTypeOrWidth = true;
-                            CPLError(CE_Warning, CPLE_AppDefined,
-                                     "Value with a precision greater than "
-                                     "field precision found in record %d for "
-                                     "field %s. "
-                                     "This warning will no longer be emitted",
-                                     nNextFID, poFieldDefn->GetNameRef());
-                        }
-                    }
-                }
-                else
-                {
-                    if( !bWarningBadTypeOrWidth )
-                    {
-                        bWarningBadTypeOrWidth = true;
-                        CPLError(
-                            CE_Warning, CPLE_AppDefined,
-                            "Invalid value type found in record %d for field "
-                            "%s. This warning will no longer be emitted.",
-                            nNextFID, poFieldDefn->GetNameRef());
-                    }
-                }
             }
         }
         else if( eFieldType != OFTString )
@@ -1645,17 +1683,7 @@ OGRFeature *OGRCSVLayer::GetNextUnfilteredFeature()
             else
             {
                 poFeature->SetField(iOGRField, papszTokens[iAttr]);
-                if( !bWarningBadTypeOrWidth && poFieldDefn->GetWidth() > 0 &&
-                    static_cast<int>(strlen(papszTokens[iAttr])) >
-                        poFieldDefn->GetWidth() )
-                {
-                    bWarningBadTypeOrWidth = true;
-                    CPLError(CE_Warning, CPLE_AppDefined,
-                             "Value with a width greater than field width "
-                             "found in record %d for field %s. "
-                             "This warning will no longer be emitted",
-                             nNextFID, poFieldDefn->GetNameRef());
-                }
+                CheckStringWidth(poFieldDefn, papszTokens[iAttr]);
             }
         }
 
@@ -1694,7 +1722,7 @@ OGRFeature *OGRCSVLayer::GetNextUnfilteredFeature()
         else
         {
             char **papszVals = CSLTokenizeString2(papszTokens[iAttr], " ", 0);
-            eType = CPLGetValueType(papszVals[0]);
+            const CPLValueType eType = CPLGetValueType(papszVals[0]);
             if( (papszVals[0] && papszVals[0][0] != '\0') &&
                 (eType == CPL_VALUE_INTEGER || eType == CPL_VALUE_REAL) )
             {
@@ -1783,10 +1811,26 @@ OGRFeature *OGRCSVLayer::GetNextFeature()
     if( bNeedRewindBeforeRead )
         ResetReading();
 
+    if( m_poFilterGeom != nullptr && !m_bSpatialIndexCandidatesReady )
+        PrepareSpatialIndexCandidates();
+
     // Read features till we find one that satisfies our current
     // spatial criteria.
     while( true )
     {
+        if( m_bUseSpatialIndexCandidates )
+        {
+            // Jump to the next record whose envelope intersects the filter.
+            if( m_iNextSpatialIndexCandidate >=
+                    m_asSpatialIndexCandidates.size() )
+                return nullptr;
+            const OGRSidecarSpatialIndex::Item &sItem =
+                m_asSpatialIndexCandidates[m_iNextSpatialIndexCandidate++];
+            if( VSIFSeekL(fpCSV, sItem.nOffset, SEEK_SET) != 0 )
+                return nullptr;
+            nNextFID = static_cast<int>(sItem.nFID);
+        }
+
         OGRFeature *poFeature = GetNextUnfilteredFeature();
         if( poFeature == nullptr )
             return nullptr;
@@ -1800,6 +1844,78 @@ OGRFeature *OGRCSVLayer::GetNextFeature()
     }
 }
 
+/************************************************************************/
+/*                        GetNextFeatureBatch()                         */
+/************************************************************************/
+
+int OGRCSVLayer::GetNextFeatureBatch( OGRFeatureBatch* poBatch, int nMaxRows )
+
+{
+    // The native path only handles plain attribute tables, without filter.
+    bool bNative = !bIsEurostatTSV && !bKeepSourceColumns &&
+                   poFeatureDefn->GetGeomFieldCount() == 0 &&
+                   m_poFilterGeom == nullptr && m_poAttrQuery == nullptr &&
+                   poBatch->GetDefn() == poFeatureDefn;
+    const int nFieldCount = poFeatureDefn->GetFieldCount();
+    for( int iField = 0; bNative && iField < nFieldCount; iField++ )
+    {
+        OGRFieldDefn *poFieldDefn = poFeatureDefn->GetFieldDefn(iField);
+        const OGRFieldType eFieldType = poFieldDefn->GetType();
+        if( !(eFieldType == OFTString || eFieldType == OFTReal ||
+              eFieldType == OFTInteger64 ||
+              (eFieldType == OFTInteger &&
+               poFieldDefn->GetSubType() != OFSTBoolean)) )
+        {
+            bNative = false;
+        }
+    }
+    if( !bNative )
+        return OGRLayer::GetNextFeatureBatch(poBatch, nMaxRows);
+
+    if( bNeedRewindBeforeRead )
+        ResetReading();
+
+    poBatch->Reset();
+    if( fpCSV == nullptr )
+        return 0;
+
+    while( poBatch->GetRowCount() < nMaxRows )
+    {
+        char **papszTokens = GetNextLineTokens();
+        if( papszTokens == nullptr )
+            break;
+
+        poBatch->AddRow(nNextFID);
+        const int nAttrCount = std::min(CSLCount(papszTokens), nFieldCount);
+        for( int iField = 0; iField < nAttrCount; iField++ )
+        {
+            OGRFieldDefn *poFieldDefn = poFeatureDefn->GetFieldDefn(iField);
+            if( poFieldDefn->IsIgnored() )
+                continue;
+            char* pszToken = papszTokens[iField];
+            if( poFieldDefn->GetType() != OFTString )
+            {
+                if( pszToken[0] != '\0' &&
+                    CheckNumericToken(poFieldDefn, pszToken) )
+                {
+                    poBatch->SetFieldFromString(iField, pszToken);
+                }
+            }
+            else if( !(bEmptyStringNull && pszToken[0] == '\0') )
+            {
+                poBatch->SetFieldString(iField, pszToken);
+                CheckStringWidth(poFieldDefn, pszToken);
+            }
+        }
+        CSLDestroy(papszTokens);
+
+        nNextFID++;
+        m_nFeaturesRead++;
+    }
+
+    return poBatch->GetRowCount();
+}
+
 /************************************************************************/
 /*                           TestCapability()                           */
 /************************************************************************/
@@ -1820,6 +1936,8 @@ int OGRCSVLayer::TestCapability( const char *pszCap )
         return TRUE;
     else if( EQUAL(pszCap, OLCMeasuredGeometries) )
         return TRUE;
+    else if( EQUAL(pszCap, OLCFastSpatialFilter) )
+        return CheckSpatialIndex(m_iGeomFieldFilter, false);
     else
         return FALSE;
 }
@@ -2603,3 +2721,180 @@ OGRErr OGRCSVLayer::SyncToDisk()
     }
     return OGRERR_NONE;
 }
+
+/************************************************************************/
+/*                         CheckSpatialIndex()                          */
+/*                                                                      */
+/*      Opens the sidecar spatial index of a geometry field if there     */
+/*      is an up to date one, or builds it when allowed and requested   */
+/*      with OGR_SIDECAR_SPATIAL_INDEX=BUILD.                           */
+/************************************************************************/
+
+bool OGRCSVLayer::CheckSpatialIndex( int iGeomField, bool bAllowBuild )
+{
+    // Features appended during the session are not indexed.
+    if( bNew || !bFirstFeatureAppendedDuringSession || fpCSV == nullptr )
+        return false;
+
+    if( m_bSpatialIndexChecked && m_iSpatialIndexGeomField == iGeomField )
+        return m_poSpatialIndex != nullptr;
+
+    m_bSpatialIndexChecked = true;
+    m_iSpatialIndexGeomField = iGeomField;
+    m_poSpatialIndex.reset();
+
+    if( iGeomField < 0 || iGeomField >= poFeatureDefn->GetGeomFieldCount() )
+        return false;
+
+    const char *pszMode =
+        CPLGetConfigOption("OGR_SIDECAR_SPATIAL_INDEX", "YES");
+    if( !CPLTestBool(pszMode) )
+        return false;
+
+    const char *pszGeomFieldName =
+        poFeatureDefn->GetGeomFieldDefn(iGeomField)->GetNameRef();
+    m_poSpatialIndex.reset(
+        OGRSidecarSpatialIndex::Open(pszFilename, pszGeomFieldName));
+    if( m_poSpatialIndex == nullptr && bAllowBuild && EQUAL(pszMode, "BUILD") )
+    {
+        // Failing to build, for example in a read-only directory, only
+        // means that the layer is scanned.
+        CPLPushErrorHandler(CPLQuietErrorHandler);
+        const OGRErr eErr = CreateSpatialIndex(iGeomField);
+        CPLPopErrorHandler();
+        if( eErr == OGRERR_NONE )
+        {
+            m_poSpatialIndex.reset(
+                OGRSidecarSpatialIndex::Open(pszFilename, pszGeomFieldName));
+        }
+        else
+        {
+            CPLDebug("CSV", "Cannot build spatial index of %s: %s",
+                     pszFilename, CPLGetLastErrorMsg());
+        }
+        m_bSpatialIndexChecked = true;
+        m_iSpatialIndexGeomField = iGeomField;
+    }
+    return m_poSpatialIndex != nullptr;
+}
+
+/************************************************************************/
+/*                   PrepareSpatialIndexCandidates()                    */
+/************************************************************************/
+
+void OGRCSVLayer::PrepareSpatialIndexCandidates()
+{
+    const bool bHasIndex = CheckSpatialIndex(m_iGeomFieldFilter, true);
+
+    m_bSpatialIndexCandidatesReady = true;
+    m_bUseSpatialIndexCandidates = false;
+    m_asSpatialIndexCandidates.clear();
+    m_iNextSpatialIndexCandidate = 0;
+
+    if( !bHasIndex ||
+        !m_poSpatialIndex->Search(m_sFilterEnvelope,
+                                  m_asSpatialIndexCandidates) )
+        return;
+
+    m_bUseSpatialIndexCandidates = true;
+    CPLDebug("CSV", "Spatial index of %s: %d candidates out of " CPL_FRMT_GUIB,
+             pszFilename,
+             static_cast<int>(m_asSpatialIndexCandidates.size()),
+             m_poSpatialIndex->GetItemCount());
+}
+
+/************************************************************************/
+/*                         CreateSpatialIndex()                         */
+/*                                                                      */
+/*      Writes a <filename>.sidx spatial index of the envelopes and     */
+/*      record offsets of a geometry field.                             */
+/************************************************************************/
+
+OGRErr OGRCSVLayer::CreateSpatialIndex( int iGeomField )
+{
+    if( bNew || !bFirstFeatureAppendedDuringSession || fpCSV == nullptr )
+    {
+        CPLError(CE_Failure, CPLE_NotSupported,
+                 "Cannot create a spatial index on a layer being written");
+        return OGRERR_FAILURE;
+    }
+    if( iGeomField < 0 || iGeomField >= poFeatureDefn->GetGeomFieldCount() )
+    {
+        CPLError(CE_Failure, CPLE_AppDefined,
+                 "Layer %s has no geometry field to index",
+                 poFeatureDefn->GetName());
+        return OGRERR_FAILURE;
+    }
+
+    // Only parse the indexed geometry.
+    std::vector<int> abFieldIgnored;
+    for( int i = 0; i < poFeatureDefn->GetFieldCount(); i++ )
+    {
+        OGRFieldDefn *poFieldDefn = poFeatureDefn->GetFieldDefn(i);
+        abFieldIgnored.push_back(poFieldDefn->IsIgnored());
+        poFieldDefn->SetIgnored(TRUE);
+    }
+    std::vector<int> abGeomFieldIgnored;
+    for( int i = 0; i < poFeatureDefn->GetGeomFieldCount(); i++ )
+    {
+        OGRGeomFieldDefn *poGeomFieldDefn = poFeatureDefn->GetGeomFieldDefn(i);
+        abGeomFieldIgnored.push_back(poGeomFieldDefn->IsIgnored());
+        poGeomFieldDefn->SetIgnored(i != iGeomField);
+    }
+
+    std::vector<OGRSidecarSpatialIndex::Item> asItems;
+    ResetReading();
+    while( true )
+    {
+        const vsi_l_offset nOffset = VSIFTellL(fpCSV);
+        OGRFeature *poFeature = GetNextUnfilteredFeature();
+        if( poFeature == nullptr )
+            break;
+        OGRGeometry *poGeom = poFeature->GetGeomFieldRef(iGeomField);
+        if( poGeom != nullptr && !poGeom->IsEmpty() )
+        {
+            OGRSidecarSpatialIndex::Item sItem;
+            poGeom->getEnvelope(&sItem.sEnvelope);
+            sItem.nFID = poFeature->GetFID();
+            sItem.nOffset = nOffset;
+            asItems.push_back(sItem);
+        }
+        delete poFeature;
+    }
+
+    for( int i = 0; i < poFeatureDefn->GetFieldCount(); i++ )
+        poFeatureDefn->GetFieldDefn(i)->SetIgnored(abFieldIgnored[i]);
+    for( int i = 0; i < poFeatureDefn->GetGeomFieldCount(); i++ )
+        poFeatureDefn->GetGeomFieldDefn(i)->SetIgnored(abGeomFieldIgnored[i]);
+    ResetReading();
+
+    m_bSpatialIndexChecked = false;
+    m_poSpatialIndex.reset();
+
+    if( !OGRSidecarSpatialIndex::Build(
+            pszFilename,
+            poFeatureDefn->GetGeomFieldDefn(iGeomField)->GetNameRef(),
+            asItems) )
+        return OGRERR_FAILURE;
+    return OGRERR_NONE;
+}
+
+/************************************************************************/
+/*                          DropSpatialIndex()                          */
+/************************************************************************/
+
+OGRErr OGRCSVLayer::DropSpatialIndex()
+{
+    m_bSpatialIndexChecked = false;
+    m_poSpatialIndex.reset();
+    ResetReading();
+
+    if( !OGRSidecarSpatialIndex::Drop(pszFilename) )
+    {
+        CPLError(CE_Failure, CPLE_AppDefined,
+                 "Layer %s has no spatial index, DROP SPATIAL INDEX failed.",
+                 poFeatureDefn->GetName());
+        return OGRERR_FAILURE;
+    }
+    return OGRERR_NONE;
+}
@@ -59,6 +59,41 @@ OGRLayerAttrIndex::~OGRLayerAttrIndex()
     pszIndexPath = nullptr;
 }
 
+/************************************************************************/
+/*                        CreateCompoundIndex()                         */
+/*                                                                      */
+/*      Create an index whose key is made of several fields.  Only      */
+/*      single field indexes are supported by default.                  */
+/************************************************************************/
+
+OGRErr OGRLayerAttrIndex::CreateCompoundIndex( int nFieldCount,
+                                               const int *panFields )
+
+{
+    if( nFieldCount == 1 )
+        return CreateIndex( panFields[0] );
+
+    CPLError( CE_Failure, CPLE_NotSupported,
+              "Indexes on several fields are not supported." );
+    return OGRERR_UNSUPPORTED_OPERATION;
+}
+
+/************************************************************************/
+/*                         DropCompoundIndex()                          */
+/************************************************************************/
+
+OGRErr OGRLayerAttrIndex::DropCompoundIndex( int nFieldCount,
+                                             const int *panFields )
+
+{
+    if( nFieldCount == 1 )
+        return DropIndex( panFields[0] );
+
+    CPLError( CE_Failure, CPLE_NotSupported,
+              "Indexes on several fields are not supported." );
+    return OGRERR_UNSUPPORTED_OPERATION;
+}
+
 /************************************************************************/
 /* ==================================================================== */
 /*                             OGRAttrIndex                             */
@@ -77,4 +112,30 @@ OGRAttrIndex::OGRAttrIndex() {}
 
 OGRAttrIndex::~OGRAttrIndex() {}
 
+/************************************************************************/
+/*                            GetKeyField()                             */
+/************************************************************************/
+
+int OGRAttrIndex::GetKeyField( int /* iKey */ )
+
+{
+    return -1;
+}
+
+/************************************************************************/
+/*                          GetRangeMatches()                           */
+/*                                                                      */
+/*      Return the sorted, OGRNullFID terminated, list of the FIDs      */
+/*      whose key matches the passed constraint, or NULL if the         */
+/*      index cannot answer it, in which case callers fall back to      */
+/*      GetAllMatches() for equality tests.                             */
+/************************************************************************/
+
+GIntBig *OGRAttrIndex::GetRangeMatches( const OGRAttrIndexRange& /* sRange */,
+                                        GIntBig * /* pnFIDCount */ )
+
+{
+    return nullptr;
+}
+
 //! @endcond
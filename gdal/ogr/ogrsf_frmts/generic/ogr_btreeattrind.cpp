@@ -0,0 +1,1717 @@
+/******************************************************************************
+ *
+ * Project:  OpenGIS Simple Features Reference Implementation
+ * Purpose:  Generic attribute indexes stored as B+trees in a .oai file.
+ *
+ ******************************************************************************
+ * Copyright (c) 2018, GDAL contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ ****************************************************************************/
+
+#include "ogr_attrind.h"
+#include "cpl_conv.h"
+#include "cpl_vsi.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <vector>
+
+CPL_CVSID("$Id$")
+
+/*
+ * All the indexes of a layer are stored in a single <basename>.oai file,
+ * made of pages of BTREE_PAGE_SIZE bytes.  All integers are little endian.
+ *
+ * Page 0 is the header:
+ *   "OGRBTIDX", version (uint32), page size (uint32), index count (uint32),
+ *   reserved (uint32), and for each index:
+ *     key field count (uint32), and for each key field: field index (int32),
+ *     field type (uint32), name length (uint16), name ;
+ *     root page (uint64), height (uint32), entry count (uint64).
+ *
+ * Other pages are tree nodes:
+ *   type (uint8, 1=leaf, 2=internal), 3 padding bytes, entry count (uint32),
+ *   next leaf page for leaves or first child page for internal nodes
+ *   (uint64), then the entries: key length (uint16), key, FID (int64),
+ *   and for internal nodes the child page (uint64) whose first entry is
+ *   the (key, FID) of the entry.
+ *
+ * Keys are the concatenation of the encoding of the key fields, so that
+ * they can be compared with memcmp() : integers and reals as 8 byte order
+ * preserving big endian values, strings lower cased (OGR SQL comparisons
+ * are case insensitive), truncated to BTREE_MAX_STRING_KEY bytes and
+ * terminated by a nul byte.  Features with a null key field are not
+ * indexed.
+ */
+
+constexpr int BTREE_PAGE_SIZE = 4096;
+constexpr int BTREE_PAGE_HEADER_SIZE = 16;
+constexpr int BTREE_MAX_KEY_FIELDS = 4;
+constexpr size_t BTREE_MAX_STRING_KEY = 254;
+constexpr GByte BTREE_LEAF_PAGE = 1;
+constexpr GByte BTREE_INTERNAL_PAGE = 2;
+constexpr GUInt32 BTREE_VERSION = 1;
+static const char BTREE_MAGIC[] = "OGRBTIDX";
+
+/************************************************************************/
+/*                        Little endian helpers.                        */
+/************************************************************************/
+
+static void OGRBTreeSetUInt16( GByte *pabyDst, GUInt16 nVal )
+{
+    CPL_LSBPTR16(&nVal);
+    memcpy(pabyDst, &nVal, sizeof(nVal));
+}
+
+static void OGRBTreeSetUInt32( GByte *pabyDst, GUInt32 nVal )
+{
+    CPL_LSBPTR32(&nVal);
+    memcpy(pabyDst, &nVal, sizeof(nVal));
+}
+
+static void OGRBTreeSetUInt64( GByte *pabyDst, GUIntBig nVal )
+{
+    CPL_LSBPTR64(&nVal);
+    memcpy(pabyDst, &nVal, sizeof(nVal));
+}
+
+static GUInt16 OGRBTreeGetUInt16( const GByte *pabySrc )
+{
+    GUInt16 nVal = 0;
+    memcpy(&nVal, pabySrc, sizeof(nVal));
+    CPL_LSBPTR16(&nVal);
+    return nVal;
+}
+
+static GUInt32 OGRBTreeGetUInt32( const GByte *pabySrc )
+{
+    GUInt32 nVal = 0;
+    memcpy(&nVal, pabySrc, sizeof(nVal));
+    CPL_LSBPTR32(&nVal);
+    return nVal;
+}
+
+static GUIntBig OGRBTreeGetUInt64( const GByte *pabySrc )
+{
+    GUIntBig nVal = 0;
+    memcpy(&nVal, pabySrc, sizeof(nVal));
+    CPL_LSBPTR64(&nVal);
+    return nVal;
+}
+
+/************************************************************************/
+/*                          OGRBTreeCompare()                           */
+/************************************************************************/
+
+static int OGRBTreeCompare( const GByte *pabyA, size_t nLenA,
+                            const GByte *pabyB, size_t nLenB )
+{
+    const size_t nMin = std::min(nLenA, nLenB);
+    const int nRet = nMin ? memcmp(pabyA, pabyB, nMin) : 0;
+    if( nRet != 0 )
+        return nRet;
+    return nLenA < nLenB ? -1 : nLenA > nLenB ? 1 : 0;
+}
+
+static int OGRBTreeCompare( const GByte *pabyA, size_t nLenA,
+                            const std::string &osB )
+{
+    return OGRBTreeCompare(pabyA, nLenA,
+                           reinterpret_cast<const GByte *>(osB.data()),
+                           osB.size());
+}
+
+/************************************************************************/
+/*                        Key encoding helpers.                         */
+/************************************************************************/
+
+static bool OGRBTreeIsSupportedType( OGRFieldType eType )
+{
+    return eType == OFTInteger || eType == OFTInteger64 ||
+           eType == OFTReal || eType == OFTString;
+}
+
+static void OGRBTreeAppendBigEndian( std::string &osKey, GUIntBig nBits )
+{
+    for( int i = 7; i >= 0; i-- )
+        osKey += static_cast<char>((nBits >> (8 * i)) & 0xff);
+}
+
+static void OGRBTreeAppendString( std::string &osKey, const char *pszVal,
+                                  size_t nMaxLen = BTREE_MAX_STRING_KEY )
+{
+    for( size_t i = 0; i < nMaxLen && pszVal[i] != '\0'; i++ )
+    {
+        osKey += static_cast<char>(
+            tolower(static_cast<unsigned char>(pszVal[i])));
+    }
+}
+
+/* Returns false if the value cannot be indexed (NaN). */
+static bool OGRBTreeAppendKey( std::string &osKey, OGRFieldType eType,
+                               const OGRField *psField )
+{
+    switch( eType )
+    {
+      case OFTInteger:
+      case OFTInteger64:
+      {
+        const GIntBig nVal = eType == OFTInteger ? psField->Integer :
+                                                   psField->Integer64;
+        OGRBTreeAppendBigEndian(osKey, static_cast<GUIntBig>(nVal) ^
+                                        (static_cast<GUIntBig>(1) << 63));
+        return true;
+      }
+
+      case OFTReal:
+      {
+        double dfVal = psField->Real;
+        if( CPLIsNan(dfVal) )
+            return false;
+        if( dfVal == 0.0 )
+            dfVal = 0.0; // -0 and +0 must have the same key.
+        GUIntBig nBits = 0;
+        memcpy(&nBits, &dfVal, sizeof(nBits));
+        if( nBits >> 63 )
+            nBits = ~nBits;
+        else
+            nBits |= static_cast<GUIntBig>(1) << 63;
+        OGRBTreeAppendBigEndian(osKey, nBits);
+        return true;
+      }
+
+      case OFTString:
+        OGRBTreeAppendString(osKey, psField->String);
+        osKey += '\0';
+        return true;
+
+      default:
+        return false;
+    }
+}
+
+/* Returns the size of the key component at the start of pabyKey, or 0 if */
+/* it is corrupted. */
+static size_t OGRBTreeComponentSize( const GByte *pabyKey, size_t nLen,
+                                     OGRFieldType eType )
+{
+    if( eType == OFTString )
+    {
+        const GByte *pabyEnd =
+            static_cast<const GByte *>(memchr(pabyKey, 0, nLen));
+        return pabyEnd ? static_cast<size_t>(pabyEnd - pabyKey) + 1 : 0;
+    }
+    return nLen >= 8 ? 8 : 0;
+}
+
+/************************************************************************/
+/*                            OGRBTreeEntry                             */
+/************************************************************************/
+
+struct OGRBTreeEntry
+{
+    std::string osKey{};
+    GIntBig     nFID = 0;
+
+    bool operator< ( const OGRBTreeEntry &oOther ) const
+    {
+        const int nRet = OGRBTreeCompare(
+            reinterpret_cast<const GByte *>(osKey.data()), osKey.size(),
+            oOther.osKey);
+        if( nRet != 0 )
+            return nRet < 0;
+        return nFID < oOther.nFID;
+    }
+
+    bool operator== ( const OGRBTreeEntry &oOther ) const
+    {
+        return nFID == oOther.nFID && osKey == oOther.osKey;
+    }
+};
+
+/************************************************************************/
+/*                            OGRBTreeWriter                            */
+/*                                                                      */
+/*      Bulk loads a tree from entries fed in sorted order.  Leaves     */
+/*      are written first, in sequence, then each upper level.          */
+/************************************************************************/
+
+class OGRBTreeWriter
+{
+    struct Separator
+    {
+        std::string osKey{};
+        GIntBig     nFID = 0;
+        GUIntBig    nPage = 0;
+    };
+
+    VSILFILE           *m_fp = nullptr;
+    GUIntBig            m_nNextPage = 0;
+    std::vector<GByte>  m_abyPage{};
+    GUIntBig            m_nCurPage = 0;
+    GUInt32             m_nPageEntries = 0;
+    size_t              m_nPageOffset = 0;
+    GUIntBig            m_nEntryCount = 0;
+    bool                m_bError = false;
+    std::vector<Separator> m_asLevel{};
+
+    CPL_DISALLOW_COPY_ASSIGN(OGRBTreeWriter)
+
+    void        StartPage( GByte nType, GUIntBig nFirst );
+    void        WritePage( GUIntBig nNextOrFirst );
+
+  public:
+    OGRBTreeWriter( VSILFILE *fp, GUIntBig nFirstPage ) :
+        m_fp(fp), m_nNextPage(nFirstPage), m_abyPage(BTREE_PAGE_SIZE) {}
+
+    bool        AddEntry( const GByte *pabyKey, size_t nKeyLen,
+                          GIntBig nFID );
+    bool        Finish( GUIntBig &nRootPage, int &nHeight,
+                        GUIntBig &nEntryCount );
+    GUIntBig    GetNextPage() const { return m_nNextPage; }
+};
+
+void OGRBTreeWriter::StartPage( GByte nType, GUIntBig nFirst )
+{
+    std::fill(m_abyPage.begin(), m_abyPage.end(), 0);
+    m_abyPage[0] = nType;
+    OGRBTreeSetUInt64(&m_abyPage[8], nFirst);
+    m_nCurPage = m_nNextPage++;
+    m_nPageEntries = 0;
+    m_nPageOffset = BTREE_PAGE_HEADER_SIZE;
+}
+
+void OGRBTreeWriter::WritePage( GUIntBig nNextOrFirst )
+{
+    OGRBTreeSetUInt32(&m_abyPage[4], m_nPageEntries);
+    OGRBTreeSetUInt64(&m_abyPage[8], nNextOrFirst);
+    if( VSIFSeekL(m_fp, m_nCurPage * BTREE_PAGE_SIZE, SEEK_SET) != 0 ||
+        VSIFWriteL(m_abyPage.data(), BTREE_PAGE_SIZE, 1, m_fp) != 1 )
+    {
+        m_bError = true;
+    }
+}
+
+bool OGRBTreeWriter::AddEntry( const GByte *pabyKey, size_t nKeyLen,
+                               GIntBig nFID )
+{
+    const size_t nEntrySize = 2 + nKeyLen + 8;
+    if( m_nPageEntries == 0 && m_asLevel.empty() )
+    {
+        StartPage(BTREE_LEAF_PAGE, 0);
+    }
+    else if( m_nPageOffset + nEntrySize > BTREE_PAGE_SIZE )
+    {
+        // Leaves are written contiguously, so the next leaf is the next
+        // page to be allocated.
+        WritePage(m_nNextPage);
+        StartPage(BTREE_LEAF_PAGE, 0);
+    }
+
+    if( m_nPageEntries == 0 )
+    {
+        Separator sSep;
+        sSep.osKey.assign(reinterpret_cast<const char *>(pabyKey), nKeyLen);
+        sSep.nFID = nFID;
+        sSep.nPage = m_nCurPage;
+        m_asLevel.push_back(sSep);
+    }
+
+    GByte *pabyDst = &m_abyPage[m_nPageOffset];
+    OGRBTreeSetUInt16(pabyDst, static_cast<GUInt16>(nKeyLen));
+    memcpy(pabyDst + 2, pabyKey, nKeyLen);
+    OGRBTreeSetUInt64(pabyDst + 2 + nKeyLen, static_cast<GUIntBig>(nFID));
+    m_nPageOffset += nEntrySize;
+    m_nPageEntries++;
+    m_nEntryCount++;
+
+    return !m_bError;
+}
+
+bool OGRBTreeWriter::Finish( GUIntBig &nRootPage, int &nHeight,
+                             GUIntBig &nEntryCount )
+{
+    nEntryCount = m_nEntryCount;
+    if( m_asLevel.empty() )
+    {
+        nRootPage = 0;
+        nHeight = 0;
+        return !m_bError;
+    }
+    WritePage(0);
+    nHeight = 1;
+
+/* -------------------------------------------------------------------- */
+/*      Build the internal levels until there is a single root.         */
+/* -------------------------------------------------------------------- */
+    while( m_asLevel.size() > 1 && !m_bError )
+    {
+        std::vector<Separator> asUpperLevel;
+        for( size_t i = 0; i < m_asLevel.size(); i++ )
+        {
+            const Separator &sSep = m_asLevel[i];
+            const size_t nEntrySize = 2 + sSep.osKey.size() + 8 + 8;
+            if( i == 0 || m_nPageOffset + nEntrySize > BTREE_PAGE_SIZE )
+            {
+                if( i != 0 )
+                    WritePage(OGRBTreeGetUInt64(&m_abyPage[8]));
+                StartPage(BTREE_INTERNAL_PAGE, sSep.nPage);
+                Separator sUpper(sSep);
+                sUpper.nPage = m_nCurPage;
+                asUpperLevel.push_back(sUpper);
+                continue;
+            }
+
+            GByte *pabyDst = &m_abyPage[m_nPageOffset];
+            OGRBTreeSetUInt16(pabyDst, static_cast<GUInt16>(sSep.osKey.size()));
+            memcpy(pabyDst + 2, sSep.osKey.data(), sSep.osKey.size());
+            OGRBTreeSetUInt64(pabyDst + 2 + sSep.osKey.size(),
+                              static_cast<GUIntBig>(sSep.nFID));
+            OGRBTreeSetUInt64(pabyDst + 2 + sSep.osKey.size() + 8,
+                              sSep.nPage);
+            m_nPageOffset += nEntrySize;
+            m_nPageEntries++;
+        }
+        WritePage(OGRBTreeGetUInt64(&m_abyPage[8]));
+        m_asLevel = std::move(asUpperLevel);
+        nHeight++;
+    }
+
+    nRootPage = m_asLevel[0].nPage;
+    return !m_bError;
+}
+
+/************************************************************************/
+/*                            OGRBTreeCursor                            */
+/************************************************************************/
+
+struct OGRBTreeCursor
+{
+    std::vector<GByte>  abyPage = std::vector<GByte>(BTREE_PAGE_SIZE);
+    GUInt32             nCount = 0;
+    GUInt32             iEntry = 0;
+    size_t              nOffset = 0;
+    GUIntBig            nPagesRead = 0;
+};
+
+class OGRBTreeLayerAttrIndex;
+
+/************************************************************************/
+/*                          OGRBTreeAttrIndex                           */
+/*                                                                      */
+/*      One index, on one or several fields.                            */
+/************************************************************************/
+
+class OGRBTreeAttrIndex final: public OGRAttrIndex
+{
+    friend class OGRBTreeLayerAttrIndex;
+
+    OGRBTreeLayerAttrIndex   *m_poLIndex = nullptr;
+    std::vector<int>          m_anFields{};
+    std::vector<OGRFieldType> m_aeTypes{};
+
+    GUIntBig                  m_nRootPage = 0;
+    int                       m_nHeight = 0;
+    GUIntBig                  m_nEntryCount = 0;
+
+    // Location of the tree in the file being written by Save().
+    GUIntBig                  m_nNewRootPage = 0;
+    int                       m_nNewHeight = 0;
+    GUIntBig                  m_nNewEntryCount = 0;
+
+    // Content replacing the current tree on the next save, once sorted.
+    bool                      m_bReplace = false;
+    std::vector<OGRBTreeEntry> m_asEntries{};
+
+    // Modifications not yet saved.
+    std::vector<OGRBTreeEntry> m_asAdded{};
+    std::vector<OGRBTreeEntry> m_asRemoved{};
+
+    CPL_DISALLOW_COPY_ASSIGN(OGRBTreeAttrIndex)
+
+    bool        BuildKey( OGRFeature *poFeature, std::string &osKey ) const;
+    bool        HasField( int iField ) const;
+    bool        Seek( const std::string &osKey, OGRBTreeCursor &oCursor );
+    bool        Next( OGRBTreeCursor &oCursor, const GByte *&pabyKey,
+                      size_t &nKeyLen, GIntBig &nFID );
+    bool        Scan( const OGRAttrIndexRange &sRange,
+                      std::vector<GIntBig> &anFIDs );
+
+  public:
+    OGRBTreeAttrIndex( OGRBTreeLayerAttrIndex *poLIndex,
+                       const std::vector<int> &anFields,
+                       const std::vector<OGRFieldType> &aeTypes ) :
+        m_poLIndex(poLIndex), m_anFields(anFields), m_aeTypes(aeTypes) {}
+
+    GIntBig     GetFirstMatch( OGRField *psKey ) override;
+    GIntBig    *GetAllMatches( OGRField *psKey ) override;
+    GIntBig    *GetAllMatches( OGRField *psKey, GIntBig* panFIDList,
+                               int* nFIDCount, int* nLength ) override;
+
+    int         GetKeyFieldCount() override
+        { return static_cast<int>(m_anFields.size()); }
+    int         GetKeyField( int iKey ) override
+        { return (iKey >= 0 && iKey < GetKeyFieldCount()) ?
+                                            m_anFields[iKey] : -1; }
+
+    GIntBig    *GetRangeMatches( const OGRAttrIndexRange& sRange,
+                                 GIntBig *pnFIDCount ) override;
+
+    OGRErr      AddEntry( OGRField *psKey, GIntBig nFID ) override;
+    OGRErr      RemoveEntry( OGRField *psKey, GIntBig nFID ) override;
+
+    OGRErr      Clear() override;
+};
+
+/************************************************************************/
+/*                        OGRBTreeLayerAttrIndex                        */
+/************************************************************************/
+
+class OGRBTreeLayerAttrIndex final: public OGRLayerAttrIndex
+{
+    friend class OGRBTreeAttrIndex;
+
+    CPLString   m_osFilename{};
+    VSILFILE   *m_fp = nullptr;
+    GUIntBig    m_nPageCount = 0;
+    bool        m_bDirty = false;
+
+    std::vector<std::unique_ptr<OGRBTreeAttrIndex>> m_apoIndexes{};
+    // Created, but not yet populated by IndexAllFeatures().
+    std::vector<std::unique_ptr<OGRBTreeAttrIndex>> m_apoNewIndexes{};
+
+    CPL_DISALLOW_COPY_ASSIGN(OGRBTreeLayerAttrIndex)
+
+    OGRErr      Load();
+    OGRErr      Save();
+    OGRErr      SaveIfDirty() { return m_bDirty ? Save() : OGRERR_NONE; }
+    bool        ReadPage( GUIntBig nPage, std::vector<GByte> &abyPage,
+                          GByte nExpectedType );
+    bool        WriteTree( VSILFILE *fpOut, OGRBTreeAttrIndex *poIndex,
+                           GUIntBig &nNextPage );
+    int         FindIndex( int nFieldCount, const int *panFields,
+                           bool &bNew ) const;
+    CPLString   GetFieldNames( int nFieldCount, const int *panFields ) const;
+
+  public:
+                OGRBTreeLayerAttrIndex() = default;
+    virtual     ~OGRBTreeLayerAttrIndex();
+
+    OGRErr      Initialize( const char *pszIndexPath, OGRLayer * ) override;
+    OGRErr      CreateIndex( int iField ) override;
+    OGRErr      DropIndex( int iField ) override;
+    OGRErr      IndexAllFeatures( int iField = -1 ) override;
+
+    OGRErr      CreateCompoundIndex( int nFieldCount,
+                                     const int *panFields ) override;
+    OGRErr      DropCompoundIndex( int nFieldCount,
+                                   const int *panFields ) override;
+
+    OGRErr      AddToIndex( OGRFeature *poFeature, int iField = -1 ) override;
+    OGRErr      RemoveFromIndex( OGRFeature *poFeature ) override;
+
+    OGRAttrIndex *GetFieldIndex( int iField ) override;
+
+    int         GetAttrIndexCount() override
+        { return static_cast<int>(m_apoIndexes.size()); }
+    OGRAttrIndex *GetAttrIndex( int i ) override
+        { return (i >= 0 && i < GetAttrIndexCount()) ?
+                                        m_apoIndexes[i].get() : nullptr; }
+};
+
+/************************************************************************/
+/*                      ~OGRBTreeLayerAttrIndex()                       */
+/************************************************************************/
+
+OGRBTreeLayerAttrIndex::~OGRBTreeLayerAttrIndex()
+
+{
+    SaveIfDirty();
+    if( m_fp != nullptr )
+        VSIFCloseL(m_fp);
+}
+
+/************************************************************************/
+/*                             Initialize()                             */
+/************************************************************************/
+
+OGRErr OGRBTreeLayerAttrIndex::Initialize( const char *pszIndexPathIn,
+                                           OGRLayer *poLayerIn )
+
+{
+    if( poLayerIn == poLayer )
+        return OGRERR_NONE;
+
+    poLayer = poLayerIn;
+    pszIndexPath = CPLStrdup( pszIndexPathIn );
+    m_osFilename = CPLResetExtension( pszIndexPathIn, "oai" );
+
+    VSIStatBufL sStat;
+    if( VSIStatL( m_osFilename, &sStat ) == 0 )
+        return Load();
+
+    return OGRERR_NONE;
+}
+
+/************************************************************************/
+/*                                Load()                                */
+/************************************************************************/
+
+OGRErr OGRBTreeLayerAttrIndex::Load()
+
+{
+    m_fp = VSIFOpenL( m_osFilename, "rb" );
+    if( m_fp == nullptr )
+    {
+        CPLError( CE_Failure, CPLE_OpenFailed,
+                  "Failed to open index file %s.", m_osFilename.c_str() );
+        return OGRERR_FAILURE;
+    }
+
+    std::vector<GByte> abyHeader(BTREE_PAGE_SIZE);
+    if( VSIFReadL( abyHeader.data(), BTREE_PAGE_SIZE, 1, m_fp ) != 1 ||
+        memcmp( abyHeader.data(), BTREE_MAGIC, 8 ) != 0 ||
+        OGRBTreeGetUInt32(&abyHeader[8]) != BTREE_VERSION ||
+        OGRBTreeGetUInt32(&abyHeader[12]) != BTREE_PAGE_SIZE )
+    {
+        CPLError( CE_Failure, CPLE_AppDefined,
+                  "%s is not a valid attribute index file.",
+                  m_osFilename.c_str() );
+        VSIFCloseL(m_fp);
+        m_fp = nullptr;
+        return OGRERR_FAILURE;
+    }
+
+    VSIFSeekL( m_fp, 0, SEEK_END );
+    m_nPageCount = VSIFTellL( m_fp ) / BTREE_PAGE_SIZE;
+
+/* -------------------------------------------------------------------- */
+/*      Process each index of the directory.                            */
+/* -------------------------------------------------------------------- */
+    OGRFeatureDefn *poDefn = poLayer->GetLayerDefn();
+    const GUInt32 nIndexCount = OGRBTreeGetUInt32(&abyHeader[16]);
+    size_t nOffset = 24;
+    bool bCorrupted = false;
+    for( GUInt32 iIndex = 0; iIndex < nIndexCount && !bCorrupted; iIndex++ )
+    {
+        if( nOffset + 4 > BTREE_PAGE_SIZE )
+        {
+            bCorrupted = true;
+            break;
+        }
+        const GUInt32 nFieldCount = OGRBTreeGetUInt32(&abyHeader[nOffset]);
+        nOffset += 4;
+        if( nFieldCount == 0 || nFieldCount > BTREE_MAX_KEY_FIELDS )
+        {
+            bCorrupted = true;
+            break;
+        }
+
+        std::vector<int> anFields;
+        std::vector<OGRFieldType> aeTypes;
+        bool bValid = true;
+        for( GUInt32 i = 0; i < nFieldCount; i++ )
+        {
+            if( nOffset + 10 > BTREE_PAGE_SIZE )
+            {
+                bCorrupted = true;
+                break;
+            }
+            int iField = static_cast<int>(
+                OGRBTreeGetUInt32(&abyHeader[nOffset]));
+            const OGRFieldType eType = static_cast<OGRFieldType>(
+                OGRBTreeGetUInt32(&abyHeader[nOffset + 4]));
+            const size_t nNameLen = OGRBTreeGetUInt16(&abyHeader[nOffset + 8]);
+            nOffset += 10;
+            if( nOffset + nNameLen > BTREE_PAGE_SIZE )
+            {
+                bCorrupted = true;
+                break;
+            }
+            const CPLString osName(
+                reinterpret_cast<const char *>(&abyHeader[nOffset]), nNameLen);
+            nOffset += nNameLen;
+
+            // The field may have moved since the index was created.
+            if( iField < 0 || iField >= poDefn->GetFieldCount() ||
+                !EQUAL(poDefn->GetFieldDefn(iField)->GetNameRef(), osName) )
+            {
+                iField = poDefn->GetFieldIndex(osName);
+            }
+            if( iField < 0 ||
+                poDefn->GetFieldDefn(iField)->GetType() != eType ||
+                !OGRBTreeIsSupportedType(eType) )
+            {
+                CPLDebug( "OGR", "Ignoring index of %s on field %s, "
+                          "which does no longer match the layer.",
+                          m_osFilename.c_str(), osName.c_str() );
+                bValid = false;
+            }
+            anFields.push_back(iField);
+            aeTypes.push_back(eType);
+        }
+        if( bCorrupted || nOffset + 20 > BTREE_PAGE_SIZE )
+        {
+            bCorrupted = true;
+            break;
+        }
+
+        std::unique_ptr<OGRBTreeAttrIndex> poIndex(
+            new OGRBTreeAttrIndex(this, anFields, aeTypes));
+        poIndex->m_nRootPage = OGRBTreeGetUInt64(&abyHeader[nOffset]);
+        poIndex->m_nHeight =
+            static_cast<int>(OGRBTreeGetUInt32(&abyHeader[nOffset + 8]));
+        poIndex->m_nEntryCount = OGRBTreeGetUInt64(&abyHeader[nOffset + 12]);
+        nOffset += 20;
+
+        if( poIndex->m_nRootPage >= m_nPageCount ||
+            poIndex->m_nHeight < 0 || poIndex->m_nHeight > 64 ||
+            (poIndex->m_nHeight == 0) != (poIndex->m_nEntryCount == 0) )
+        {
+            bCorrupted = true;
+            break;
+        }
+        if( bValid )
+            m_apoIndexes.push_back(std::move(poIndex));
+    }
+
+    if( bCorrupted )
+    {
+        CPLError( CE_Failure, CPLE_AppDefined,
+                  "Corrupted attribute index file %s.",
+                  m_osFilename.c_str() );
+        m_apoIndexes.clear();
+        VSIFCloseL(m_fp);
+        m_fp = nullptr;
+        return OGRERR_FAILURE;
+    }
+
+    CPLDebug( "OGR", "Restored %d field indexes for layer %s from %s.",
+              static_cast<int>(m_apoIndexes.size()),
+              poDefn->GetName(), m_osFilename.c_str() );
+
+    return OGRERR_NONE;
+}
+
+/************************************************************************/
+/*                              ReadPage()                              */
+/************************************************************************/
+
+bool OGRBTreeLayerAttrIndex::ReadPage( GUIntBig nPage,
+                                       std::vector<GByte> &abyPage,
+                                       GByte nExpectedType )
+
+{
+    if( m_fp == nullptr || nPage == 0 || nPage >= m_nPageCount ||
+        VSIFSeekL( m_fp, nPage * BTREE_PAGE_SIZE, SEEK_SET ) != 0 ||
+        VSIFReadL( abyPage.data(), BTREE_PAGE_SIZE, 1, m_fp ) != 1 ||
+        abyPage[0] != nExpectedType ||
+        OGRBTreeGetUInt32(&abyPage[4]) >
+                (BTREE_PAGE_SIZE - BTREE_PAGE_HEADER_SIZE) / (2 + 8) )
+    {
+        CPLError( CE_Failure, CPLE_FileIO,
+                  "Cannot read page " CPL_FRMT_GUIB " of %s.",
+                  nPage, m_osFilename.c_str() );
+        return false;
+    }
+    return true;
+}
+
+/************************************************************************/
+/*                                Seek()                                */
+/*                                                                      */
+/*      Position the cursor on the first entry whose key is greater     */
+/*      or equal to osKey.                                              */
+/************************************************************************/
+
+bool OGRBTreeAttrIndex::Seek( const std::string &osKey,
+                              OGRBTreeCursor &oCursor )
+
+{
+    oCursor.nCount = 0;
+    oCursor.iEntry = 0;
+    if( m_nHeight == 0 )
+        return true;
+
+    GUIntBig nPage = m_nRootPage;
+    for( int iLevel = m_nHeight; iLevel > 1; iLevel-- )
+    {
+        if( !m_poLIndex->ReadPage(nPage, oCursor.abyPage,
+                                  BTREE_INTERNAL_PAGE) )
+            return false;
+
+        // Descend in the last child whose first entry is lower than the
+        // key, as entries equal to the key may start in the previous one.
+        const GByte *pabyPage = oCursor.abyPage.data();
+        const GUInt32 nCount = OGRBTreeGetUInt32(pabyPage + 4);
+        GUIntBig nChild = OGRBTreeGetUInt64(pabyPage + 8);
+        size_t nOffset = BTREE_PAGE_HEADER_SIZE;
+        for( GUInt32 i = 0; i < nCount; i++ )
+        {
+            if( nOffset + 2 > BTREE_PAGE_SIZE )
+                return false;
+            const size_t nKeyLen = OGRBTreeGetUInt16(pabyPage + nOffset);
+            if( nOffset + 2 + nKeyLen + 16 > BTREE_PAGE_SIZE )
+                return false;
+            if( OGRBTreeCompare(pabyPage + nOffset + 2, nKeyLen, osKey) >= 0 )
+                break;
+            nChild = OGRBTreeGetUInt64(pabyPage + nOffset + 2 + nKeyLen + 8);
+            nOffset += 2 + nKeyLen + 16;
+        }
+        nPage = nChild;
+    }
+
+    if( !m_poLIndex->ReadPage(nPage, oCursor.abyPage, BTREE_LEAF_PAGE) )
+        return false;
+    oCursor.nCount = OGRBTreeGetUInt32(&oCursor.abyPage[4]);
+    oCursor.nOffset = BTREE_PAGE_HEADER_SIZE;
+    oCursor.nPagesRead = 1;
+
+    // Skip the entries of the leaf lower than the key.
+    while( true )
+    {
+        const size_t nSavedOffset = oCursor.nOffset;
+        const GUInt32 iSavedEntry = oCursor.iEntry;
+        const GUInt32 nSavedCount = oCursor.nCount;
+        const GUIntBig nSavedPagesRead = oCursor.nPagesRead;
+        const GByte *pabyKey = nullptr;
+        size_t nKeyLen = 0;
+        GIntBig nFID = 0;
+        if( !Next(oCursor, pabyKey, nKeyLen, nFID) )
+            return false;
+        if( pabyKey == nullptr )
+            return true;
+        if( OGRBTreeCompare(pabyKey, nKeyLen, osKey) >= 0 )
+        {
+            // Next() may have moved to the next leaf.
+            if( oCursor.nPagesRead == nSavedPagesRead )
+            {
+                oCursor.nOffset = nSavedOffset;
+                oCursor.iEntry = iSavedEntry;
+                oCursor.nCount = nSavedCount;
+            }
+            else
+            {
+                oCursor.nOffset = BTREE_PAGE_HEADER_SIZE;
+                oCursor.iEntry = 0;
+            }
+            return true;
+        }
+    }
+}
+
+/************************************************************************/
+/*                                Next()                                */
+/*                                                                      */
+/*      Fetch the entry at the cursor position, and advance it.         */
+/*      pabyKey is set to NULL at the end of the index.                 */
+/************************************************************************/
+
+bool OGRBTreeAttrIndex::Next( OGRBTreeCursor &oCursor,
+                              const GByte *&pabyKey, size_t &nKeyLen,
+                              GIntBig &nFID )
+
+{
+    pabyKey = nullptr;
+    while( oCursor.iEntry >= oCursor.nCount )
+    {
+        if( oCursor.nCount == 0 && oCursor.nPagesRead == 0 )
+            return true;
+        const GUIntBig nNext = OGRBTreeGetUInt64(&oCursor.abyPage[8]);
+        if( nNext == 0 )
+        {
+            oCursor.nCount = 0;
+            oCursor.iEntry = 0;
+            oCursor.nPagesRead = 0;
+            return true;
+        }
+        // Protection against cycles in corrupted files.
+        if( oCursor.nPagesRead > m_poLIndex->m_nPageCount ||
+            !m_poLIndex->ReadPage(nNext, oCursor.abyPage, BTREE_LEAF_PAGE) )
+            return false;
+        oCursor.nPagesRead++;
+        oCursor.nCount = OGRBTreeGetUInt32(&oCursor.abyPage[4]);
+        oCursor.iEntry = 0;
+        oCursor.nOffset = BTREE_PAGE_HEADER_SIZE;
+    }
+
+    const GByte *pabyPage = oCursor.abyPage.data();
+    if( oCursor.nOffset + 2 > BTREE_PAGE_SIZE )
+        return false;
+    nKeyLen = OGRBTreeGetUInt16(pabyPage + oCursor.nOffset);
+    if( oCursor.nOffset + 2 + nKeyLen + 8 > BTREE_PAGE_SIZE )
+        return false;
+    pabyKey = pabyPage + oCursor.nOffset + 2;
+    nFID = static_cast<GIntBig>(
+        OGRBTreeGetUInt64(pabyPage + oCursor.nOffset + 2 + nKeyLen));
+    oCursor.nOffset += 2 + nKeyLen + 8;
+    oCursor.iEntry++;
+    return true;
+}
+
+/************************************************************************/
+/*                                Scan()                                */
+/************************************************************************/
+
+bool OGRBTreeAttrIndex::Scan( const OGRAttrIndexRange &sRange,
+                              std::vector<GIntBig> &anFIDs )
+
+{
+    const int nKeyFields = GetKeyFieldCount();
+    if( sRange.nEqualCount < 0 || sRange.nEqualCount > nKeyFields )
+        return false;
+    const bool bHasRange = sRange.psMin != nullptr ||
+                           sRange.psMax != nullptr ||
+                           sRange.pszPrefix != nullptr;
+    if( bHasRange && sRange.nEqualCount == nKeyFields )
+        return false;
+    const int iRange = bHasRange ? sRange.nEqualCount : -1;
+    if( sRange.pszPrefix != nullptr && m_aeTypes[iRange] != OFTString )
+        return false;
+
+    if( m_poLIndex->SaveIfDirty() != OGRERR_NONE )
+        return false;
+
+/* -------------------------------------------------------------------- */
+/*      Encode the equality prefix and the bounds.                      */
+/* -------------------------------------------------------------------- */
+    std::string osPrefix;
+    for( int i = 0; i < sRange.nEqualCount; i++ )
+    {
+        if( !OGRBTreeAppendKey(osPrefix, m_aeTypes[i], &sRange.pasEqual[i]) )
+            return true; // NaN: no match.
+    }
+
+    std::string osMin;
+    std::string osMax;
+    std::string osLike;
+    if( sRange.psMin != nullptr &&
+        !OGRBTreeAppendKey(osMin, m_aeTypes[iRange], sRange.psMin) )
+        return true;
+    if( sRange.psMax != nullptr &&
+        !OGRBTreeAppendKey(osMax, m_aeTypes[iRange], sRange.psMax) )
+        return true;
+    if( sRange.pszPrefix != nullptr )
+        OGRBTreeAppendString(osLike, sRange.pszPrefix);
+
+    std::string osSeek(osPrefix);
+    if( sRange.psMin != nullptr )
+        osSeek += osMin;
+    else if( sRange.pszPrefix != nullptr )
+        osSeek += osLike;
+
+    OGRBTreeCursor oCursor;
+    if( !Seek(osSeek, oCursor) )
+        return false;
+
+/* -------------------------------------------------------------------- */
+/*      Collect the FIDs till the end of the range.                     */
+/* -------------------------------------------------------------------- */
+    while( true )
+    {
+        const GByte *pabyKey = nullptr;
+        size_t nKeyLen = 0;
+        GIntBig nFID = 0;
+        if( !Next(oCursor, pabyKey, nKeyLen, nFID) )
+            return false;
+        if( pabyKey == nullptr )
+            break;
+
+        if( nKeyLen < osPrefix.size() ||
+            (!osPrefix.empty() &&
+             memcmp(pabyKey, osPrefix.data(), osPrefix.size()) != 0) )
+            break;
+
+        if( iRange >= 0 )
+        {
+            const GByte *pabyComp = pabyKey + osPrefix.size();
+            const size_t nCompLen = OGRBTreeComponentSize(
+                pabyComp, nKeyLen - osPrefix.size(), m_aeTypes[iRange]);
+            if( nCompLen == 0 )
+                return false;
+            // Strings are truncated in keys: the entries equal to a bound
+            // may be beyond it.
+            const bool bTruncated = m_aeTypes[iRange] == OFTString &&
+                                    nCompLen - 1 == BTREE_MAX_STRING_KEY;
+
+            if( sRange.pszPrefix != nullptr &&
+                (nCompLen - 1 < osLike.size() ||
+                 memcmp(pabyComp, osLike.data(), osLike.size()) != 0) )
+                break;
+
+            if( sRange.psMin != nullptr )
+            {
+                const int nCmp = OGRBTreeCompare(pabyComp, nCompLen, osMin);
+                if( nCmp < 0 ||
+                    (nCmp == 0 && !sRange.bMinIncluded && !bTruncated) )
+                    continue;
+            }
+            if( sRange.psMax != nullptr )
+            {
+                const int nCmp = OGRBTreeCompare(pabyComp, nCompLen, osMax);
+                if( nCmp > 0 )
+                    break;
+                if( nCmp == 0 && !sRange.bMaxIncluded && !bTruncated )
+                    continue;
+            }
+        }
+
+        anFIDs.push_back(nFID);
+    }
+
+    return true;
+}
+
+/************************************************************************/
+/*                          GetRangeMatches()                           */
+/************************************************************************/
+
+GIntBig *OGRBTreeAttrIndex::GetRangeMatches( const OGRAttrIndexRange& sRange,
+                                             GIntBig *pnFIDCount )
+
+{
+    std::vector<GIntBig> anFIDs;
+    if( !Scan(sRange, anFIDs) )
+        return nullptr;
+
+    std::sort(anFIDs.begin(), anFIDs.end());
+    anFIDs.erase(std::unique(anFIDs.begin(), anFIDs.end()), anFIDs.end());
+
+    GIntBig *panFIDs = static_cast<GIntBig *>(
+        VSI_MALLOC2_VERBOSE(anFIDs.size() + 1, sizeof(GIntBig)));
+    if( panFIDs == nullptr )
+        return nullptr;
+    if( !anFIDs.empty() )
+        memcpy(panFIDs, anFIDs.data(), anFIDs.size() * sizeof(GIntBig));
+    panFIDs[anFIDs.size()] = OGRNullFID;
+    if( pnFIDCount != nullptr )
+        *pnFIDCount = static_cast<GIntBig>(anFIDs.size());
+    return panFIDs;
+}
+
+/************************************************************************/
+/*                           GetAllMatches()                            */
+/************************************************************************/
+
+GIntBig *OGRBTreeAttrIndex::GetAllMatches( OGRField *psKey,
+                                           GIntBig* panFIDList,
+                                           int* nFIDCount, int* nLength )
+{
+    if( panFIDList == nullptr )
+    {
+        panFIDList = static_cast<GIntBig *>(CPLMalloc(sizeof(GIntBig) * 2));
+        *nFIDCount = 0;
+        *nLength = 2;
+    }
+
+    OGRAttrIndexRange sRange;
+    sRange.nEqualCount = 1;
+    sRange.pasEqual = psKey;
+    std::vector<GIntBig> anFIDs;
+    Scan(sRange, anFIDs);
+
+    for( const GIntBig nFID: anFIDs )
+    {
+        if( *nFIDCount >= *nLength-1 )
+        {
+            *nLength = (*nLength) * 2 + 10;
+            panFIDList = static_cast<GIntBig *>(
+                CPLRealloc(panFIDList, sizeof(GIntBig)* (*nLength)));
+        }
+        panFIDList[(*nFIDCount)++] = nFID;
+    }
+
+    panFIDList[*nFIDCount] = OGRNullFID;
+
+    return panFIDList;
+}
+
+GIntBig *OGRBTreeAttrIndex::GetAllMatches( OGRField *psKey )
+{
+    int nFIDCount, nLength;
+    return GetAllMatches( psKey, nullptr, &nFIDCount, &nLength );
+}
+
+/************************************************************************/
+/*                           GetFirstMatch()                            */
+/************************************************************************/
+
+GIntBig OGRBTreeAttrIndex::GetFirstMatch( OGRField *psKey )
+
+{
+    OGRAttrIndexRange sRange;
+    sRange.nEqualCount = 1;
+    sRange.pasEqual = psKey;
+    std::vector<GIntBig> anFIDs;
+    if( !Scan(sRange, anFIDs) || anFIDs.empty() )
+        return OGRNullFID;
+    return *std::min_element(anFIDs.begin(), anFIDs.end());
+}
+
+/************************************************************************/
+/*                              BuildKey()                              */
+/************************************************************************/
+
+bool OGRBTreeAttrIndex::BuildKey( OGRFeature *poFeature,
+                                  std::string &osKey ) const
+
+{
+    osKey.clear();
+    for( size_t i = 0; i < m_anFields.size(); i++ )
+    {
+        if( !poFeature->IsFieldSetAndNotNull( m_anFields[i] ) ||
+            !OGRBTreeAppendKey( osKey, m_aeTypes[i],
+                                poFeature->GetRawFieldRef(m_anFields[i]) ) )
+            return false;
+    }
+    return true;
+}
+
+bool OGRBTreeAttrIndex::HasField( int iField ) const
+{
+    return std::find(m_anFields.begin(), m_anFields.end(), iField) !=
+                                                            m_anFields.end();
+}
+
+/************************************************************************/
+/*                       AddEntry() / RemoveEntry()                     */
+/*                                                                      */
+/*      Modifications are applied when the index file is next saved.    */
+/************************************************************************/
+
+OGRErr OGRBTreeAttrIndex::AddEntry( OGRField *psKey, GIntBig nFID )
+
+{
+    OGRBTreeEntry sEntry;
+    if( psKey == nullptr || m_anFields.size() != 1 ||
+        !OGRBTreeAppendKey(sEntry.osKey, m_aeTypes[0], psKey) )
+        return OGRERR_FAILURE;
+    sEntry.nFID = nFID;
+    m_asAdded.push_back(sEntry);
+    m_poLIndex->m_bDirty = true;
+    return OGRERR_NONE;
+}
+
+OGRErr OGRBTreeAttrIndex::RemoveEntry( OGRField *psKey, GIntBig nFID )
+
+{
+    OGRBTreeEntry sEntry;
+    if( psKey == nullptr || m_anFields.size() != 1 ||
+        !OGRBTreeAppendKey(sEntry.osKey, m_aeTypes[0], psKey) )
+        return OGRERR_FAILURE;
+    sEntry.nFID = nFID;
+    m_asRemoved.push_back(sEntry);
+    m_poLIndex->m_bDirty = true;
+    return OGRERR_NONE;
+}
+
+/************************************************************************/
+/*                               Clear()                                */
+/************************************************************************/
+
+OGRErr OGRBTreeAttrIndex::Clear()
+
+{
+    m_bReplace = true;
+    m_asEntries.clear();
+    m_asAdded.clear();
+    m_asRemoved.clear();
+    m_poLIndex->m_bDirty = true;
+    return m_poLIndex->Save();
+}
+
+/************************************************************************/
+/*                             WriteTree()                              */
+/*                                                                      */
+/*      Write the content of an index, merging the current tree with    */
+/*      the pending modifications, or replacing it.                     */
+/************************************************************************/
+
+bool OGRBTreeLayerAttrIndex::WriteTree( VSILFILE *fpOut,
+                                        OGRBTreeAttrIndex *poIndex,
+                                        GUIntBig &nNextPage )
+
+{
+    OGRBTreeWriter oWriter(fpOut, nNextPage);
+
+    std::vector<OGRBTreeEntry> &asAdded =
+        poIndex->m_bReplace ? poIndex->m_asEntries : poIndex->m_asAdded;
+    std::sort(asAdded.begin(), asAdded.end());
+    std::vector<OGRBTreeEntry> &asRemoved = poIndex->m_asRemoved;
+    std::sort(asRemoved.begin(), asRemoved.end());
+
+    OGRBTreeCursor oCursor;
+    const GByte *pabyKey = nullptr;
+    size_t nKeyLen = 0;
+    GIntBig nFID = 0;
+    bool bOK = true;
+    if( !poIndex->m_bReplace )
+    {
+        bOK = poIndex->Seek(std::string(), oCursor) &&
+              poIndex->Next(oCursor, pabyKey, nKeyLen, nFID);
+    }
+
+    size_t iAdded = 0;
+    OGRBTreeEntry sCurrent;
+    while( bOK )
+    {
+        const bool bHasOld = pabyKey != nullptr;
+        const bool bHasAdded = iAdded < asAdded.size();
+        if( !bHasOld && !bHasAdded )
+            break;
+
+        bool bTakeOld = bHasOld;
+        if( bHasOld && bHasAdded )
+        {
+            const int nCmp = OGRBTreeCompare(pabyKey, nKeyLen,
+                                             asAdded[iAdded].osKey);
+            bTakeOld = nCmp < 0 ||
+                       (nCmp == 0 && nFID <= asAdded[iAdded].nFID);
+        }
+
+        if( bTakeOld )
+        {
+            sCurrent.osKey.assign(reinterpret_cast<const char *>(pabyKey),
+                                  nKeyLen);
+            sCurrent.nFID = nFID;
+            bOK = poIndex->Next(oCursor, pabyKey, nKeyLen, nFID);
+            // Skip an added entry identical to an existing one.
+            if( bHasAdded && asAdded[iAdded] == sCurrent )
+                iAdded++;
+        }
+        else
+        {
+            sCurrent = asAdded[iAdded++];
+        }
+
+        if( std::binary_search(asRemoved.begin(), asRemoved.end(), sCurrent) )
+            continue;
+
+        bOK = bOK && oWriter.AddEntry(
+            reinterpret_cast<const GByte *>(sCurrent.osKey.data()),
+            sCurrent.osKey.size(), sCurrent.nFID );
+    }
+
+    if( !bOK )
+        return false;
+
+    if( !oWriter.Finish(poIndex->m_nNewRootPage, poIndex->m_nNewHeight,
+                        poIndex->m_nNewEntryCount) )
+        return false;
+    nNextPage = oWriter.GetNextPage();
+    return true;
+}
+
+/************************************************************************/
+/*                                Save()                                */
+/*                                                                      */
+/*      Rewrite the index file with all the indexes of the layer.       */
+/************************************************************************/
+
+OGRErr OGRBTreeLayerAttrIndex::Save()
+
+{
+    m_bDirty = false;
+
+    if( m_apoIndexes.empty() )
+    {
+        if( m_fp != nullptr )
+        {
+            VSIFCloseL(m_fp);
+            m_fp = nullptr;
+        }
+        m_nPageCount = 0;
+        VSIStatBufL sStat;
+        if( VSIStatL( m_osFilename, &sStat ) == 0 )
+            VSIUnlink( m_osFilename );
+        return OGRERR_NONE;
+    }
+
+/* -------------------------------------------------------------------- */
+/*      Build the directory.                                            */
+/* -------------------------------------------------------------------- */
+    OGRFeatureDefn *poDefn = poLayer->GetLayerDefn();
+    std::vector<GByte> abyHeader(BTREE_PAGE_SIZE);
+    memcpy(abyHeader.data(), BTREE_MAGIC, 8);
+    OGRBTreeSetUInt32(&abyHeader[8], BTREE_VERSION);
+    OGRBTreeSetUInt32(&abyHeader[12], BTREE_PAGE_SIZE);
+    OGRBTreeSetUInt32(&abyHeader[16],
+                      static_cast<GUInt32>(m_apoIndexes.size()));
+    size_t nOffset = 24;
+    std::vector<size_t> anTreeOffsets;
+    for( const auto &poIndex: m_apoIndexes )
+    {
+        size_t nSize = 4 + 20;
+        for( int iField: poIndex->m_anFields )
+            nSize += 10 + strlen(poDefn->GetFieldDefn(iField)->GetNameRef());
+        if( nOffset + nSize > BTREE_PAGE_SIZE )
+        {
+            CPLError( CE_Failure, CPLE_NotSupported,
+                      "Too many attribute indexes on layer %s.",
+                      poDefn->GetName() );
+            return OGRERR_FAILURE;
+        }
+
+        OGRBTreeSetUInt32(&abyHeader[nOffset],
+                          static_cast<GUInt32>(poIndex->m_anFields.size()));
+        nOffset += 4;
+        for( size_t i = 0; i < poIndex->m_anFields.size(); i++ )
+        {
+            const char *pszName =
+                poDefn->GetFieldDefn(poIndex->m_anFields[i])->GetNameRef();
+            OGRBTreeSetUInt32(&abyHeader[nOffset],
+                              static_cast<GUInt32>(poIndex->m_anFields[i]));
+            OGRBTreeSetUInt32(&abyHeader[nOffset + 4],
+                              static_cast<GUInt32>(poIndex->m_aeTypes[i]));
+            OGRBTreeSetUInt16(&abyHeader[nOffset + 8],
+                              static_cast<GUInt16>(strlen(pszName)));
+            memcpy(&abyHeader[nOffset + 10], pszName, strlen(pszName));
+            nOffset += 10 + strlen(pszName);
+        }
+        anTreeOffsets.push_back(nOffset);
+        nOffset += 20;
+    }
+
+/* -------------------------------------------------------------------- */
+/*      Write the trees in a new file.                                  */
+/* -------------------------------------------------------------------- */
+    const CPLString osTmpFilename = m_osFilename + ".tmp";
+    VSILFILE *fpOut = VSIFOpenL( osTmpFilename, "wb+" );
+    if( fpOut == nullptr )
+    {
+        CPLError( CE_Failure, CPLE_OpenFailed,
+                  "Failed to create %s.", osTmpFilename.c_str() );
+        return OGRERR_FAILURE;
+    }
+
+    bool bOK = VSIFWriteL( abyHeader.data(), BTREE_PAGE_SIZE, 1, fpOut ) == 1;
+    GUIntBig nNextPage = 1;
+    for( const auto &poIndex: m_apoIndexes )
+    {
+        if( !bOK )
+            break;
+        bOK = WriteTree( fpOut, poIndex.get(), nNextPage );
+    }
+
+    for( size_t i = 0; bOK && i < m_apoIndexes.size(); i++ )
+    {
+        const OGRBTreeAttrIndex *poIndex = m_apoIndexes[i].get();
+        GByte *pabyDst = &abyHeader[anTreeOffsets[i]];
+        OGRBTreeSetUInt64(pabyDst, poIndex->m_nNewRootPage);
+        OGRBTreeSetUInt32(pabyDst + 8,
+                          static_cast<GUInt32>(poIndex->m_nNewHeight));
+        OGRBTreeSetUInt64(pabyDst + 12, poIndex->m_nNewEntryCount);
+    }
+    bOK = bOK &&
+          VSIFSeekL( fpOut, 0, SEEK_SET ) == 0 &&
+          VSIFWriteL( abyHeader.data(), BTREE_PAGE_SIZE, 1, fpOut ) == 1;
+    if( VSIFCloseL( fpOut ) != 0 )
+        bOK = false;
+
+    if( !bOK )
+    {
+        CPLError( CE_Failure, CPLE_FileIO,
+                  "Failed to write %s.", osTmpFilename.c_str() );
+        VSIUnlink( osTmpFilename );
+        for( const auto &poIndex: m_apoIndexes )
+        {
+            poIndex->m_bReplace = false;
+            poIndex->m_asEntries.clear();
+            poIndex->m_asAdded.clear();
+            poIndex->m_asRemoved.clear();
+        }
+        return OGRERR_FAILURE;
+    }
+
+/* -------------------------------------------------------------------- */
+/*      Replace the current file, and refresh the tree locations.       */
+/* -------------------------------------------------------------------- */
+    if( m_fp != nullptr )
+    {
+        VSIFCloseL(m_fp);
+        m_fp = nullptr;
+    }
+    VSIStatBufL sStat;
+    if( VSIStatL( m_osFilename, &sStat ) == 0 )
+        VSIUnlink( m_osFilename );
+    if( VSIRename( osTmpFilename, m_osFilename ) != 0 )
+    {
+        CPLError( CE_Failure, CPLE_FileIO,
+                  "Failed to rename %s to %s.",
+                  osTmpFilename.c_str(), m_osFilename.c_str() );
+        m_apoIndexes.clear();
+        return OGRERR_FAILURE;
+    }
+
+    for( const auto &poIndex: m_apoIndexes )
+    {
+        poIndex->m_nRootPage = poIndex->m_nNewRootPage;
+        poIndex->m_nHeight = poIndex->m_nNewHeight;
+        poIndex->m_nEntryCount = poIndex->m_nNewEntryCount;
+        poIndex->m_bReplace = false;
+        poIndex->m_asEntries.clear();
+        poIndex->m_asAdded.clear();
+        poIndex->m_asRemoved.clear();
+    }
+
+    m_fp = VSIFOpenL( m_osFilename, "rb" );
+    m_nPageCount = nNextPage;
+    if( m_fp == nullptr )
+    {
+        CPLError( CE_Failure, CPLE_OpenFailed,
+                  "Failed to open index file %s.", m_osFilename.c_str() );
+        m_apoIndexes.clear();
+        return OGRERR_FAILURE;
+    }
+
+    return OGRERR_NONE;
+}
+
+/************************************************************************/
+/*                             FindIndex()                              */
+/************************************************************************/
+
+int OGRBTreeLayerAttrIndex::FindIndex( int nFieldCount,
+                                       const int *panFields,
+                                       bool &bNew ) const
+
+{
+    const std::vector<int> anFields(panFields, panFields + nFieldCount);
+    for( size_t i = 0; i < m_apoIndexes.size(); i++ )
+    {
+        if( m_apoIndexes[i]->m_anFields == anFields )
+        {
+            bNew = false;
+            return static_cast<int>(i);
+        }
+    }
+    for( size_t i = 0; i < m_apoNewIndexes.size(); i++ )
+    {
+        if( m_apoNewIndexes[i]->m_anFields == anFields )
+        {
+            bNew = true;
+            return static_cast<int>(i);
+        }
+    }
+    return -1;
+}
+
+CPLString OGRBTreeLayerAttrIndex::GetFieldNames( int nFieldCount,
+                                                 const int *panFields ) const
+{
+    CPLString osNames;
+    for( int i = 0; i < nFieldCount; i++ )
+    {
+        if( i > 0 )
+            osNames += ",";
+        osNames +=
+            poLayer->GetLayerDefn()->GetFieldDefn(panFields[i])->GetNameRef();
+    }
+    return osNames;
+}
+
+/************************************************************************/
+/*                        CreateCompoundIndex()                         */
+/*                                                                      */
+/*      Create an index on the indicated fields, but do not populate    */
+/*      it.  Use IndexAllFeatures() for that.                           */
+/************************************************************************/
+
+OGRErr OGRBTreeLayerAttrIndex::CreateCompoundIndex( int nFieldCount,
+                                                    const int *panFields )
+
+{
+    OGRFeatureDefn *poDefn = poLayer->GetLayerDefn();
+    if( nFieldCount < 1 || nFieldCount > BTREE_MAX_KEY_FIELDS )
+    {
+        CPLError( CE_Failure, CPLE_NotSupported,
+                  "Indexes can be created on 1 to %d fields.",
+                  BTREE_MAX_KEY_FIELDS );
+        return OGRERR_FAILURE;
+    }
+
+    std::vector<OGRFieldType> aeTypes;
+    for( int i = 0; i < nFieldCount; i++ )
+    {
+        if( panFields[i] < 0 || panFields[i] >= poDefn->GetFieldCount() )
+        {
+            CPLError( CE_Failure, CPLE_AppDefined,
+                      "Invalid field index %d.", panFields[i] );
+            return OGRERR_FAILURE;
+        }
+        for( int j = 0; j < i; j++ )
+        {
+            if( panFields[j] == panFields[i] )
+            {
+                CPLError( CE_Failure, CPLE_AppDefined,
+                          "Field %s is repeated in index.",
+                          poDefn->GetFieldDefn(panFields[i])->GetNameRef() );
+                return OGRERR_FAILURE;
+            }
+        }
+        OGRFieldDefn *poFldDefn = poDefn->GetFieldDefn(panFields[i]);
+        if( !OGRBTreeIsSupportedType(poFldDefn->GetType()) )
+        {
+            CPLError( CE_Failure, CPLE_AppDefined,
+                      "Indexing not supported for the field type of "
+                      "field %s.",
+                      poFldDefn->GetNameRef() );
+            return OGRERR_FAILURE;
+        }
+        aeTypes.push_back(poFldDefn->GetType());
+    }
+
+    bool bNew = false;
+    if( FindIndex(nFieldCount, panFields, bNew) >= 0 )
+    {
+        CPLError( CE_Failure, CPLE_AppDefined,
+                  "It seems we already have an index for field(s) %s\n"
+                  "of layer %s.",
+                  GetFieldNames(nFieldCount, panFields).c_str(),
+                  poDefn->GetName() );
+        return OGRERR_FAILURE;
+    }
+
+    m_apoNewIndexes.emplace_back(new OGRBTreeAttrIndex(
+        this, std::vector<int>(panFields, panFields + nFieldCount), aeTypes));
+    return OGRERR_NONE;
+}
+
+OGRErr OGRBTreeLayerAttrIndex::CreateIndex( int iField )
+
+{
+    return CreateCompoundIndex( 1, &iField );
+}
+
+/************************************************************************/
+/*                         DropCompoundIndex()                          */
+/************************************************************************/
+
+OGRErr OGRBTreeLayerAttrIndex::DropCompoundIndex( int nFieldCount,
+                                                  const int *panFields )
+
+{
+    bool bNew = false;
+    const int iIndex = nFieldCount > 0 ?
+                            FindIndex(nFieldCount, panFields, bNew) : -1;
+    if( iIndex < 0 )
+    {
+        CPLError( CE_Failure, CPLE_AppDefined,
+                  "DROP INDEX on field (%s) that doesn't have an index.",
+                  nFieldCount > 0 ?
+                      GetFieldNames(nFieldCount, panFields).c_str() : "" );
+        return OGRERR_FAILURE;
+    }
+
+    if( bNew )
+    {
+        m_apoNewIndexes.erase(m_apoNewIndexes.begin() + iIndex);
+        return OGRERR_NONE;
+    }
+
+    m_apoIndexes.erase(m_apoIndexes.begin() + iIndex);
+    return Save();
+}
+
+OGRErr OGRBTreeLayerAttrIndex::DropIndex( int iField )
+
+{
+    return DropCompoundIndex( 1, &iField );
+}
+
+/************************************************************************/
+/*                          IndexAllFeatures()                          */
+/*                                                                      */
+/*      Populate the indexes created on the field (on any field if      */
+/*      iField is -1) since the last call, or rebuild the existing      */
+/*      ones if there is no such new index.                             */
+/************************************************************************/
+
+OGRErr OGRBTreeLayerAttrIndex::IndexAllFeatures( int iField )
+
+{
+    std::vector<OGRBTreeAttrIndex *> apoTargets;
+    for( const auto &poIndex: m_apoNewIndexes )
+    {
+        if( iField < 0 || poIndex->HasField(iField) )
+            apoTargets.push_back(poIndex.get());
+    }
+    const bool bNewIndexes = !apoTargets.empty();
+    if( !bNewIndexes )
+    {
+        for( const auto &poIndex: m_apoIndexes )
+        {
+            if( iField < 0 || poIndex->HasField(iField) )
+                apoTargets.push_back(poIndex.get());
+        }
+    }
+    if( apoTargets.empty() )
+        return OGRERR_NONE;
+
+/* -------------------------------------------------------------------- */
+/*      Collect the keys of all features.                               */
+/* -------------------------------------------------------------------- */
+    for( auto poIndex: apoTargets )
+    {
+        poIndex->m_bReplace = true;
+        poIndex->m_asEntries.clear();
+    }
+
+    OGRFeatureDefn *poDefn = poLayer->GetLayerDefn();
+    const bool bSaveGeometryIgnored = CPL_TO_BOOL(poDefn->IsGeometryIgnored());
+    poDefn->SetGeometryIgnored(TRUE);
+
+    OGRErr eErr = OGRERR_NONE;
+    poLayer->ResetReading();
+    OGRFeature *poFeature = nullptr;
+    OGRBTreeEntry sEntry;
+    while( eErr == OGRERR_NONE &&
+           (poFeature = poLayer->GetNextFeature()) != nullptr )
+    {
+        sEntry.nFID = poFeature->GetFID();
+        if( sEntry.nFID == OGRNullFID )
+        {
+            CPLError( CE_Failure, CPLE_AppDefined,
+                      "Attempt to index feature with no FID." );
+            eErr = OGRERR_FAILURE;
+        }
+        for( auto poIndex: apoTargets )
+        {
+            if( eErr == OGRERR_NONE &&
+                poIndex->BuildKey(poFeature, sEntry.osKey) )
+                poIndex->m_asEntries.push_back(sEntry);
+        }
+        delete poFeature;
+    }
+    poLayer->ResetReading();
+    poDefn->SetGeometryIgnored(bSaveGeometryIgnored);
+
+    if( eErr != OGRERR_NONE )
+    {
+        for( auto poIndex: apoTargets )
+        {
+            poIndex->m_bReplace = false;
+            poIndex->m_asEntries.clear();
+        }
+        return eErr;
+    }
+
+/* -------------------------------------------------------------------- */
+/*      Write them.                                                     */
+/* -------------------------------------------------------------------- */
+    if( bNewIndexes )
+    {
+        for( size_t i = 0; i < m_apoNewIndexes.size(); )
+        {
+            if( m_apoNewIndexes[i]->m_bReplace )
+            {
+                m_apoIndexes.push_back(std::move(m_apoNewIndexes[i]));
+                m_apoNewIndexes.erase(m_apoNewIndexes.begin() + i);
+            }
+            else
+                i++;
+        }
+    }
+
+    return Save();
+}
+
+/************************************************************************/
+/*                         GetFieldAttrIndex()                          */
+/************************************************************************/
+
+OGRAttrIndex *OGRBTreeLayerAttrIndex::GetFieldIndex( int iField )
+
+{
+    for( const auto &poIndex: m_apoIndexes )
+    {
+        if( poIndex->m_anFields.size() == 1 &&
+            poIndex->m_anFields[0] == iField )
+            return poIndex.get();
+    }
+
+    return nullptr;
+}
+
+/************************************************************************/
+/*                             AddToIndex()                             */
+/************************************************************************/
+
+OGRErr OGRBTreeLayerAttrIndex::AddToIndex( OGRFeature *poFeature,
+                                           int iTargetField )
+
+{
+    if( poFeature->GetFID() == OGRNullFID )
+    {
+        CPLError( CE_Failure, CPLE_AppDefined,
+                  "Attempt to index feature with no FID." );
+        return OGRERR_FAILURE;
+    }
+
+    OGRBTreeEntry sEntry;
+    sEntry.nFID = poFeature->GetFID();
+    for( const auto &poIndex: m_apoIndexes )
+    {
+        if( iTargetField != -1 && !poIndex->HasField(iTargetField) )
+            continue;
+        if( poIndex->BuildKey(poFeature, sEntry.osKey) )
+        {
+            poIndex->m_asAdded.push_back(sEntry);
+            m_bDirty = true;
+        }
+    }
+
+    return OGRERR_NONE;
+}
+
+/************************************************************************/
+/*                          RemoveFromIndex()                           */
+/************************************************************************/
+
+OGRErr OGRBTreeLayerAttrIndex::RemoveFromIndex( OGRFeature *poFeature )
+
+{
+    OGRBTreeEntry sEntry;
+    sEntry.nFID = poFeature->GetFID();
+    for( const auto &poIndex: m_apoIndexes )
+    {
+        if( poIndex->BuildKey(poFeature, sEntry.osKey) )
+        {
+            poIndex->m_asRemoved.push_back(sEntry);
+            m_bDirty = true;
+        }
+    }
+
+    return OGRERR_NONE;
+}
+
+/************************************************************************/
+/*                     OGRCreateDefaultLayerIndex()                     */
+/************************************************************************/
+
+OGRLayerAttrIndex *OGRCreateDefaultLayerIndex()
+
+{
+    return new OGRBTreeLayerAttrIndex();
+}
@@ -34,6 +34,10 @@
 #include "ogr_api.h"
 #include "cpl_time.h"
 #include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstring>
+#include <utility>
 #include <vector>
 
 //! @cond Doxygen_Suppress
@@ -97,8 +101,6 @@ OGRGenSQLResultsLayer::OGRGenSQLResultsLayer( GDALDataset *poSrcDSIn,
     papoTableLayers(nullptr),
     poDefn(nullptr),
     panGeomFieldToSrcGeomField(nullptr),
-    nIndexSize(0),
-    panFIDIndex(nullptr),
     bOrderByValid(FALSE),
     nNextIndexFID(0),
     poSummaryFeature(nullptr),
@@ -106,7 +108,8 @@ OGRGenSQLResultsLayer::OGRGenSQLResultsLayer( GDALDataset *poSrcDSIn,
     nExtraDSCount(0),
     papoExtraDS(nullptr),
     nIteratedFeatures(-1),
-    m_oDistinctList{}
+    m_oDistinctList{},
+    m_nMaxMemory(OGRGenSQLGetMaxMemory())
 {
     swq_select *psSelectInfo = static_cast<swq_select*>(pSelectInfoIn);
 
@@ -514,7 +517,6 @@ OGRGenSQLResultsLayer::~OGRGenSQLResultsLayer()
     CPLFree( papoTableLayers );
     papoTableLayers = nullptr;
 
-    CPLFree( panFIDIndex );
     CPLFree( panGeomFieldToSrcGeomField );
 
     delete poSummaryFeature;
@@ -638,6 +640,10 @@ void OGRGenSQLResultsLayer::ResetReading()
 
     nNextIndexFID = psSelectInfo->offset;
     nIteratedFeatures = -1;
+
+    // The secondary layers may have been modified since the hash tables
+    // were built: build them again on the next join.
+    m_aoHashJoins.clear();
 }
 
 /************************************************************************/
@@ -661,7 +667,7 @@ OGRErr OGRGenSQLResultsLayer::SetNextByIndex( GIntBig nIndex )
 
     if( psSelectInfo->query_mode == SWQM_SUMMARY_RECORD
         || psSelectInfo->query_mode == SWQM_DISTINCT_LIST
-        || panFIDIndex != nullptr )
+        || m_poOrderBySorter != nullptr )
     {
         nNextIndexFID = nIndex + psSelectInfo->offset;
         return OGRERR_NONE;
@@ -760,7 +766,8 @@ int OGRGenSQLResultsLayer::TestCapability( const char *pszCap )
     {
         if( psSelectInfo->query_mode == SWQM_SUMMARY_RECORD
             || psSelectInfo->query_mode == SWQM_DISTINCT_LIST
-            || panFIDIndex != nullptr )
+            || (m_poOrderBySorter != nullptr &&
+                m_poOrderBySorter->IsInMemory()) )
             return TRUE;
         else
             return poSrcLayer->TestCapability( pszCap );
@@ -914,37 +921,43 @@ int OGRGenSQLResultsLayer::PrepareSummary()
         for( int iField = 0; iField < psSelectInfo->result_columns; iField++ )
         {
             swq_col_def *psColDef = psSelectInfo->column_defs + iField;
+            const GIntBig nCountBefore =
+                psSelectInfo->column_summary.empty() ? 0 :
+                                psSelectInfo->column_summary[iField].count;
+            const char* pszVal = nullptr;
+            bool bSummarized = true;
 
             if (psColDef->col_func == SWQCF_COUNT)
             {
                 /* psColDef->field_index can be -1 in the case of a COUNT(*) */
                 if (psColDef->field_index < 0)
-                    pszError = swq_select_summarize( psSelectInfo, iField, "" );
+                    pszVal = "";
                 else if (IS_GEOM_FIELD_INDEX(poSrcLayer->GetLayerDefn(), psColDef->field_index) )
                 {
                     int iSrcGeomField = ALL_FIELD_INDEX_TO_GEOM_FIELD_INDEX(
                             poSrcLayer->GetLayerDefn(), psColDef->field_index);
                     OGRGeometry* poGeom = poSrcFeature->GetGeomFieldRef(iSrcGeomField);
                     if( poGeom != nullptr )
-                        pszError = swq_select_summarize( psSelectInfo, iField, "" );
+                        pszVal = "";
                     else
-                        pszError = nullptr;
+                        bSummarized = false;
                 }
                 else if (poSrcFeature->IsFieldSetAndNotNull(psColDef->field_index))
-                    pszError = swq_select_summarize( psSelectInfo, iField, poSrcFeature->GetFieldAsString(
-                                                psColDef->field_index ) );
+                    pszVal = poSrcFeature->GetFieldAsString(
+                                                psColDef->field_index );
                 else
-                    pszError = nullptr;
+                    bSummarized = false;
             }
             else
             {
-                const char* pszVal = nullptr;
                 if (poSrcFeature->IsFieldSetAndNotNull(psColDef->field_index))
                     pszVal = poSrcFeature->GetFieldAsString(
                                                 psColDef->field_index );
-                pszError = swq_select_summarize( psSelectInfo, iField, pszVal );
             }
 
+            pszError = bSummarized ?
+                swq_select_summarize( psSelectInfo, iField, pszVal ) : nullptr;
+
             if( pszError != nullptr )
             {
                 delete poSrcFeature;
@@ -956,13 +969,45 @@ int OGRGenSQLResultsLayer::PrepareSummary()
                 CPLError( CE_Failure, CPLE_AppDefined, "%s", pszError );
                 return FALSE;
             }
+
+            if( bSummarized && psColDef->distinct_flag )
+                AccountDistinctValue( iField, nCountBefore, pszVal );
         }
 
         delete poSrcFeature;
+
+/* -------------------------------------------------------------------- */
+/*      Spill the DISTINCT values to disk once they exceed the          */
+/*      memory budget.                                                  */
+/* -------------------------------------------------------------------- */
+        if( m_nDistinctMemory > m_nMaxMemory / 2 )
+        {
+            for( int iField = 0; iField < psSelectInfo->result_columns;
+                 iField++ )
+            {
+                if( psSelectInfo->column_defs[iField].distinct_flag &&
+                    !SpillDistinctValues( iField ) )
+                {
+                    delete poSummaryFeature;
+                    poSummaryFeature = nullptr;
+                    poSrcLayer->GetLayerDefn()->SetGeometryIgnored(
+                                                        bSaveIsGeomIgnored);
+                    return FALSE;
+                }
+            }
+            m_nDistinctMemory = 0;
+        }
     }
 
     poSrcLayer->GetLayerDefn()->SetGeometryIgnored(bSaveIsGeomIgnored);
 
+    if( !FinishDistinctValues() )
+    {
+        delete poSummaryFeature;
+        poSummaryFeature = nullptr;
+        return FALSE;
+    }
+
 /* -------------------------------------------------------------------- */
 /*      If we have run out of features on the source layer, clear       */
 /*      away the filters we have installed till a next run through      */
@@ -1061,6 +1106,237 @@ int OGRGenSQLResultsLayer::PrepareSummary()
     return TRUE;
 }
 
+/************************************************************************/
+/*                   OGRGenSQLCompareDistinctValues()                   */
+/*                                                                      */
+/*      Three-way version of swq_summary::Comparator.                   */
+/************************************************************************/
+
+static int OGRGenSQLCompareDistinctValues(
+    const swq_summary::Comparator *poComparator,
+    const char *pszVal1, const char *pszVal2 )
+{
+    const bool bNull1 = strcmp( pszVal1, SZ_OGR_NULL ) == 0;
+    const bool bNull2 = strcmp( pszVal2, SZ_OGR_NULL ) == 0;
+    int nResult = 0;
+    if( bNull1 || bNull2 )
+        nResult = bNull2 ? (bNull1 ? 0 : 1) : -1;
+    else if( poComparator->eType == SWQ_INTEGER64 )
+    {
+        const GIntBig nVal1 = CPLAtoGIntBig( pszVal1 );
+        const GIntBig nVal2 = CPLAtoGIntBig( pszVal2 );
+        nResult = nVal1 < nVal2 ? -1 : nVal1 > nVal2 ? 1 : 0;
+    }
+    else if( poComparator->eType == SWQ_FLOAT )
+    {
+        const double dfVal1 = CPLAtof( pszVal1 );
+        const double dfVal2 = CPLAtof( pszVal2 );
+        nResult = dfVal1 < dfVal2 ? -1 : dfVal1 > dfVal2 ? 1 : 0;
+    }
+    else
+        nResult = strcmp( pszVal1, pszVal2 );
+
+    return poComparator->bSortAsc ? nResult : -nResult;
+}
+
+/************************************************************************/
+/*              DISTINCT rows: sequence number, then value.             */
+/************************************************************************/
+
+static int OGRGenSQLCompareDistinctRows( const GByte *pabyRow1,
+                                         const GByte *pabyRow2,
+                                         void *pUserData )
+{
+    return OGRGenSQLCompareDistinctValues(
+        static_cast<const swq_summary::Comparator *>(pUserData),
+        reinterpret_cast<const char *>(pabyRow1 + sizeof(GUIntBig)),
+        reinterpret_cast<const char *>(pabyRow2 + sizeof(GUIntBig)) );
+}
+
+static int OGRGenSQLCompareDistinctSeq( const GByte *pabyRow1,
+                                        const GByte *pabyRow2,
+                                        void * /* pUserData */ )
+{
+    GUIntBig nSeq1 = 0;
+    GUIntBig nSeq2 = 0;
+    memcpy( &nSeq1, pabyRow1, sizeof(GUIntBig) );
+    memcpy( &nSeq2, pabyRow2, sizeof(GUIntBig) );
+    return nSeq1 < nSeq2 ? -1 : nSeq1 > nSeq2 ? 1 : 0;
+}
+
+/************************************************************************/
+/*                        AccountDistinctValue()                        */
+/*                                                                      */
+/*      Estimates the memory taken by the DISTINCT values collected     */
+/*      in memory by swq_select_summarize().                            */
+/************************************************************************/
+
+void OGRGenSQLResultsLayer::AccountDistinctValue( int iField,
+                                                  GIntBig nCountBefore,
+                                                  const char *pszValue )
+{
+    swq_select *psSelectInfo = static_cast<swq_select*>(pSelectInfo);
+
+    if( psSelectInfo->column_summary.empty() ||
+        psSelectInfo->column_summary[iField].count == nCountBefore )
+        return;
+
+    const size_t nLen =
+        strlen( pszValue != nullptr ? pszValue : SZ_OGR_NULL ) + 1;
+    // std::set node.
+    m_nDistinctMemory += nLen + 64;
+    // Copy in insertion order.
+    if( psSelectInfo->order_specs == 0 )
+        m_nDistinctMemory += nLen + sizeof(CPLString);
+}
+
+/************************************************************************/
+/*                        SpillDistinctValues()                         */
+/*                                                                      */
+/*      Moves the DISTINCT values collected in memory for a column to   */
+/*      a row sorter, which spills them to disk when needed. Each row   */
+/*      holds the rank of the value in the order of first occurrence,   */
+/*      so that the original order can be restored.                     */
+/************************************************************************/
+
+bool OGRGenSQLResultsLayer::SpillDistinctValues( int iField )
+{
+    swq_select *psSelectInfo = static_cast<swq_select*>(pSelectInfo);
+    if( psSelectInfo->column_summary.empty() )
+        return true;
+    swq_summary& oSummary = psSelectInfo->column_summary[iField];
+
+    if( m_apoDistinctSorters.empty() )
+    {
+        // Sized once, as the sorters point to the comparators.
+        m_aoDistinctComparators.resize( psSelectInfo->result_columns );
+        m_apoDistinctSorters.resize( psSelectInfo->result_columns );
+        m_anDistinctSpilledCount.resize( psSelectInfo->result_columns, 0 );
+    }
+    if( m_apoDistinctSorters[iField] == nullptr )
+    {
+        m_aoDistinctComparators[iField] =
+                                    oSummary.oSetDistinctValues.key_comp();
+        m_apoDistinctSorters[iField].reset(
+            new OGRGenSQLRowSorter( OGRGenSQLCompareDistinctRows,
+                                    &m_aoDistinctComparators[iField],
+                                    m_nMaxMemory / 2 ) );
+    }
+
+    OGRGenSQLRowSorter *poSorter = m_apoDistinctSorters[iField].get();
+    std::vector<GByte> abyRow;
+    const auto AddValue = [&]( const CPLString &osValue )
+    {
+        const GUIntBig nSeq = m_anDistinctSpilledCount[iField]++;
+        abyRow.resize( sizeof(GUIntBig) );
+        memcpy( &abyRow[0], &nSeq, sizeof(GUIntBig) );
+        abyRow.insert( abyRow.end(), osValue.c_str(),
+                       osValue.c_str() + osValue.size() + 1 );
+        return poSorter->AddRow( abyRow.data(), abyRow.size() );
+    };
+
+    if( psSelectInfo->order_specs == 0 )
+    {
+        for( const CPLString &osValue : oSummary.oVectorDistinctValues )
+        {
+            if( !AddValue( osValue ) )
+                return false;
+        }
+    }
+    else
+    {
+        for( const CPLString &osValue : oSummary.oSetDistinctValues )
+        {
+            if( !AddValue( osValue ) )
+                return false;
+        }
+    }
+
+    oSummary.oSetDistinctValues.clear();
+    std::vector<CPLString>().swap( oSummary.oVectorDistinctValues );
+    oSummary.count = 0;
+    return true;
+}
+
+/************************************************************************/
+/*                        FinishDistinctValues()                        */
+/*                                                                      */
+/*      Merges the DISTINCT values of the columns that were spilled,    */
+/*      removing the duplicates: the first row of a run of equal        */
+/*      values is the first occurrence. For a DISTINCT list, the        */
+/*      unique values are then sorted back in their output order.       */
+/************************************************************************/
+
+bool OGRGenSQLResultsLayer::FinishDistinctValues()
+{
+    swq_select *psSelectInfo = static_cast<swq_select*>(pSelectInfo);
+
+    for( size_t iField = 0; iField < m_apoDistinctSorters.size(); iField++ )
+    {
+        if( m_apoDistinctSorters[iField] == nullptr )
+            continue;
+
+        const int nField = static_cast<int>(iField);
+        if( !SpillDistinctValues( nField ) )
+            return false;
+
+        OGRGenSQLRowSorter *poSorter = m_apoDistinctSorters[iField].get();
+        if( !poSorter->Finish() )
+            return false;
+
+        const bool bList = psSelectInfo->query_mode == SWQM_DISTINCT_LIST;
+        if( bList )
+        {
+            m_poDistinctListSorter.reset(
+                new OGRGenSQLRowSorter( OGRGenSQLCompareDistinctSeq, nullptr,
+                                        m_nMaxMemory / 2 ) );
+        }
+
+        CPLString osPrevValue;
+        GUIntBig nUniqueCount = 0;
+        std::vector<GByte> abyRow;
+        const GByte *pabyRow = nullptr;
+        size_t nSize = 0;
+        while( (pabyRow = poSorter->GetNextRow( &nSize )) != nullptr )
+        {
+            const char *pszValue =
+                reinterpret_cast<const char *>(pabyRow + sizeof(GUIntBig));
+            if( nUniqueCount > 0 &&
+                OGRGenSQLCompareDistinctValues(
+                    &m_aoDistinctComparators[iField],
+                    osPrevValue, pszValue ) == 0 )
+            {
+                continue;
+            }
+            osPrevValue = pszValue;
+
+            if( bList )
+            {
+                abyRow.assign( pabyRow, pabyRow + nSize );
+                if( psSelectInfo->order_specs > 0 )
+                {
+                    // Already in the requested order.
+                    memcpy( &abyRow[0], &nUniqueCount, sizeof(GUIntBig) );
+                }
+                if( !m_poDistinctListSorter->AddRow( abyRow.data(),
+                                                     abyRow.size() ) )
+                    return false;
+            }
+            nUniqueCount++;
+        }
+
+        psSelectInfo->column_summary[iField].count =
+                                        static_cast<GIntBig>(nUniqueCount);
+        m_apoDistinctSorters[iField].reset();
+    }
+
+    if( m_poDistinctListSorter != nullptr &&
+        !m_poDistinctListSorter->Finish() )
+        return false;
+
+    return true;
+}
+
 /************************************************************************/
 /*                       OGRMultiFeatureFetcher()                       */
 /************************************************************************/
@@ -1270,6 +1546,376 @@ static CPLString GetFilterForJoin(swq_expr_node* poExpr, OGRFeature* poSrcFeat,
     return "";
 }
 
+/* Encoding of the keys of the hash joins */
+enum
+{
+    HASH_KEY_INTEGER64,
+    HASH_KEY_REAL,
+    HASH_KEY_STRING
+};
+
+/************************************************************************/
+/*                    ReferencesPrimaryTableInJoin()                    */
+/************************************************************************/
+
+static bool ReferencesPrimaryTableInJoin( swq_expr_node *poExpr )
+{
+    if( poExpr->eNodeType == SNT_COLUMN )
+        return poExpr->table_index == 0;
+
+    if( poExpr->eNodeType == SNT_OPERATION )
+    {
+        for( int i = 0; i < poExpr->nSubExprCount; i++ )
+        {
+            if( ReferencesPrimaryTableInJoin(poExpr->papoSubExpr[i]) )
+                return true;
+        }
+    }
+
+    return false;
+}
+
+/************************************************************************/
+/*                       CollectHashJoinKeys()                          */
+/*                                                                      */
+/*      Decomposes a join expression into equalities between a field    */
+/*      of the primary table and a field of the secondary table, that   */
+/*      become the keys of the hash join, and into conditions on the    */
+/*      secondary table only, that become the attribute filter used     */
+/*      to build the hash table.  Returns false for any other           */
+/*      expression, that must be evaluated per primary feature.         */
+/************************************************************************/
+
+static bool CollectHashJoinKeys( swq_expr_node *poExpr,
+                                 OGRFeatureDefn *poPrimaryDefn,
+                                 OGRLayer *poJoinLayer,
+                                 int secondary_table,
+                                 std::vector<int> &anPrimaryFields,
+                                 std::vector<int> &anSecondaryFields,
+                                 std::vector<int> &anKeyTypes,
+                                 CPLString &osBuildFilter )
+{
+    if( poExpr->eNodeType != SNT_OPERATION )
+        return false;
+
+    if( poExpr->nOperation == SWQ_AND )
+    {
+        for( int i = 0; i < poExpr->nSubExprCount; i++ )
+        {
+            if( !CollectHashJoinKeys(poExpr->papoSubExpr[i], poPrimaryDefn,
+                                     poJoinLayer, secondary_table,
+                                     anPrimaryFields, anSecondaryFields,
+                                     anKeyTypes, osBuildFilter) )
+                return false;
+        }
+        return true;
+    }
+
+    if( !ReferencesPrimaryTableInJoin(poExpr) )
+    {
+        const CPLString osSubExpr =
+            GetFilterForJoin(poExpr, nullptr, poJoinLayer, secondary_table);
+        if( osSubExpr.empty() )
+            return false;
+        if( !osBuildFilter.empty() )
+            osBuildFilter += " AND ";
+        osBuildFilter += "(" + osSubExpr + ")";
+        return true;
+    }
+
+    if( poExpr->nOperation != SWQ_EQ || poExpr->nSubExprCount != 2 ||
+        poExpr->papoSubExpr[0]->eNodeType != SNT_COLUMN ||
+        poExpr->papoSubExpr[1]->eNodeType != SNT_COLUMN )
+        return false;
+
+    swq_expr_node *poPrimary = poExpr->papoSubExpr[0];
+    swq_expr_node *poSecondary = poExpr->papoSubExpr[1];
+    if( poPrimary->table_index != 0 )
+        std::swap(poPrimary, poSecondary);
+    if( poPrimary->table_index != 0 ||
+        poSecondary->table_index != secondary_table )
+        return false;
+
+    OGRFeatureDefn *poSecondaryDefn = poJoinLayer->GetLayerDefn();
+    if( poPrimary->field_index < 0 ||
+        poPrimary->field_index >= poPrimaryDefn->GetFieldCount() ||
+        poSecondary->field_index < 0 ||
+        poSecondary->field_index >= poSecondaryDefn->GetFieldCount() )
+        return false;
+
+    // Only pairs of types whose OGR SQL equality is that of their keys.
+    const OGRFieldType ePrimaryType =
+        poPrimaryDefn->GetFieldDefn(poPrimary->field_index)->GetType();
+    const OGRFieldType eSecondaryType =
+        poSecondaryDefn->GetFieldDefn(poSecondary->field_index)->GetType();
+    const bool bPrimaryIsInteger =
+        ePrimaryType == OFTInteger || ePrimaryType == OFTInteger64;
+    const bool bSecondaryIsInteger =
+        eSecondaryType == OFTInteger || eSecondaryType == OFTInteger64;
+    int nKeyType = 0;
+    if( bPrimaryIsInteger && bSecondaryIsInteger )
+        nKeyType = HASH_KEY_INTEGER64;
+    else if( (bPrimaryIsInteger || ePrimaryType == OFTReal) &&
+             (bSecondaryIsInteger || eSecondaryType == OFTReal) )
+        nKeyType = HASH_KEY_REAL;
+    else if( ePrimaryType == OFTString && eSecondaryType == OFTString )
+        nKeyType = HASH_KEY_STRING;
+    else
+        return false;
+
+    anPrimaryFields.push_back(poPrimary->field_index);
+    anSecondaryFields.push_back(poSecondary->field_index);
+    anKeyTypes.push_back(nKeyType);
+    return true;
+}
+
+/************************************************************************/
+/*                          AppendHashJoinKey()                         */
+/*                                                                      */
+/*      Returns false if the field is null, in which case the feature   */
+/*      cannot be joined.                                               */
+/************************************************************************/
+
+static bool AppendHashJoinKey( std::string &osKey, OGRFeature *poFeature,
+                               int iField, int nKeyType )
+{
+    if( !poFeature->IsFieldSetAndNotNull(iField) )
+        return false;
+
+    switch( nKeyType )
+    {
+        case HASH_KEY_INTEGER64:
+        {
+            const GIntBig nValue = poFeature->GetFieldAsInteger64(iField);
+            osKey.append(reinterpret_cast<const char *>(&nValue),
+                         sizeof(nValue));
+            break;
+        }
+
+        case HASH_KEY_REAL:
+        {
+            double dfValue = poFeature->GetFieldAsDouble(iField);
+            if( std::isnan(dfValue) )
+                return false;
+            if( dfValue == 0.0 )
+                dfValue = 0.0;  // -0.0 == 0.0
+            osKey.append(reinterpret_cast<const char *>(&dfValue),
+                         sizeof(dfValue));
+            break;
+        }
+
+        default:
+        {
+            // String equality is case insensitive.
+            for( const char *pszIter = poFeature->GetFieldAsString(iField);
+                 *pszIter != '\0'; ++pszIter )
+            {
+                osKey += static_cast<char>(
+                    tolower(static_cast<unsigned char>(*pszIter)));
+            }
+            osKey += '\0';
+            break;
+        }
+    }
+    return true;
+}
+
+/************************************************************************/
+/*                         IsHashableJoinKey()                          */
+/*                                                                      */
+/*      OGR SQL compares strings that look like timestamps with         */
+/*      swq_test_string_equal(), that ignores a trailing +00 when the   */
+/*      other member has no timezone.  That equality cannot be hashed,  */
+/*      so such keys are left to the per-row evaluation of the join,    */
+/*      that is also done with OGR SQL since string keys are only       */
+/*      hashed for secondary layers evaluating their filters with it.   */
+/************************************************************************/
+
+static bool IsHashableJoinKey( OGRFeature *poFeature, int iField,
+                               int nKeyType )
+{
+    if( nKeyType != HASH_KEY_STRING ||
+        !poFeature->IsFieldSetAndNotNull(iField) )
+        return true;
+
+    const char *pszValue = poFeature->GetFieldAsString(iField);
+    const size_t nLen = strlen(pszValue);
+    return !(nLen > 3 && (strcmp(pszValue + nLen - 3, "+00") == 0 ||
+                          pszValue[nLen - 3] == ':'));
+}
+
+/************************************************************************/
+/*                           BuildHashJoin()                            */
+/*                                                                      */
+/*      Reads the secondary layer of a join once into a hash table      */
+/*      of its features indexed by the join keys.                       */
+/************************************************************************/
+
+bool OGRGenSQLResultsLayer::BuildHashJoin( int iJoin )
+{
+    swq_select *psSelectInfo = static_cast<swq_select*>(pSelectInfo);
+    swq_join_def *psJoinInfo = psSelectInfo->join_defs + iJoin;
+    HashJoin &oJoin = m_aoHashJoins[iJoin];
+    oJoin.bTried = true;
+
+    if( !CPLTestBool(CPLGetConfigOption("OGR_SQL_HASH_JOIN", "YES")) )
+        return false;
+
+    // Reading the whole secondary layer would disturb the iteration of
+    // the primary one.
+    OGRLayer *poJoinLayer = papoTableLayers[psJoinInfo->secondary_table];
+    if( poJoinLayer == poSrcLayer )
+        return false;
+
+    CPLString osBuildFilter;
+    if( !CollectHashJoinKeys(psJoinInfo->poExpr, poSrcLayer->GetLayerDefn(),
+                             poJoinLayer, psJoinInfo->secondary_table,
+                             oJoin.anPrimaryFields, oJoin.anSecondaryFields,
+                             oJoin.anKeyTypes, osBuildFilter) ||
+        oJoin.anKeyTypes.empty() )
+    {
+        oJoin.anPrimaryFields.clear();
+        oJoin.anSecondaryFields.clear();
+        oJoin.anKeyTypes.clear();
+        return false;
+    }
+
+    // String keys are hashed with the case insensitive equality of OGR SQL.
+    // The per-feature evaluation of the join only has the same semantics
+    // if the secondary layer evaluates its attribute filter with OGR SQL,
+    // and not natively, as case sensitive SQL databases do.
+    bool bHasStringKey = false;
+    OGRFeatureDefn *poJoinDefn = poJoinLayer->GetLayerDefn();
+    for( size_t iKey = 0; iKey < oJoin.anKeyTypes.size(); iKey++ )
+    {
+        if( oJoin.anKeyTypes[iKey] != HASH_KEY_STRING )
+            continue;
+        bHasStringKey = true;
+        if( !osBuildFilter.empty() )
+            osBuildFilter += " AND ";
+        osBuildFilter += CPLSPrintf("\"%s\" IS NOT NULL",
+            poJoinDefn->GetFieldDefn(
+                oJoin.anSecondaryFields[iKey])->GetNameRef());
+    }
+
+    poJoinLayer->ResetReading();
+    if( poJoinLayer->SetAttributeFilter( osBuildFilter.c_str() )
+                                                        != OGRERR_NONE )
+    {
+        poJoinLayer->SetAttributeFilter( "" );
+        return false;
+    }
+    if( bHasStringKey && poJoinLayer->GetAttrQuery() == nullptr )
+    {
+        CPLDebug("GenSQL",
+                 "Layer %s evaluates attribute filters natively: "
+                 "no hash join on string keys", poJoinLayer->GetName());
+        poJoinLayer->SetAttributeFilter( "" );
+        return false;
+    }
+
+    std::unique_ptr<OGRGenSQLHashTable> poTable(
+        new OGRGenSQLHashTable(m_nMaxMemory));
+    std::string osKey;
+    std::vector<GByte> abyRecord;
+    bool bOK = true;
+    OGRFeature *poFeature = nullptr;
+    while( bOK && (poFeature = poJoinLayer->GetNextFeature()) != nullptr )
+    {
+        osKey.clear();
+        bool bNullKey = false;
+        for( size_t iKey = 0; bOK && iKey < oJoin.anKeyTypes.size(); iKey++ )
+        {
+            if( !IsHashableJoinKey(poFeature, oJoin.anSecondaryFields[iKey],
+                                   oJoin.anKeyTypes[iKey]) )
+            {
+                CPLDebug("GenSQL",
+                         "Timestamp-like join key in layer %s: "
+                         "no hash join", poJoinLayer->GetName());
+                bOK = false;
+            }
+            else if( !AppendHashJoinKey(osKey, poFeature,
+                                        oJoin.anSecondaryFields[iKey],
+                                        oJoin.anKeyTypes[iKey]) )
+            {
+                bNullKey = true;
+                break;
+            }
+        }
+        if( bOK && !bNullKey )
+        {
+            abyRecord.clear();
+            OGRGenSQLSerializeFeature(poFeature, abyRecord);
+            bOK = poTable->Insert(osKey, abyRecord.data(), abyRecord.size());
+        }
+        delete poFeature;
+    }
+
+    poJoinLayer->SetAttributeFilter( "" );
+    poJoinLayer->ResetReading();
+
+    if( !bOK )
+        return false;
+
+    CPLDebug("GenSQL", "Hash join on layer %s: %d keys%s",
+             poJoinLayer->GetName(),
+             static_cast<int>(poTable->GetKeyCount()),
+             poTable->IsInMemory() ? "" : ", spilled to disk");
+    oJoin.poTable = std::move(poTable);
+    return true;
+}
+
+/************************************************************************/
+/*                        FetchHashJoinFeature()                        */
+/*                                                                      */
+/*      Returns false if the join cannot be evaluated with a hash       */
+/*      table.                                                          */
+/************************************************************************/
+
+bool OGRGenSQLResultsLayer::FetchHashJoinFeature( int iJoin,
+                                                  OGRFeature *poSrcFeat,
+                                                  OGRFeature **ppoJoinFeature )
+{
+    swq_select *psSelectInfo = static_cast<swq_select*>(pSelectInfo);
+    if( m_aoHashJoins.empty() )
+        m_aoHashJoins.resize(psSelectInfo->join_count);
+
+    HashJoin &oJoin = m_aoHashJoins[iJoin];
+    if( !oJoin.bTried )
+        BuildHashJoin(iJoin);
+    if( !oJoin.poTable )
+        return false;
+
+    *ppoJoinFeature = nullptr;
+
+    for( size_t iKey = 0; iKey < oJoin.anKeyTypes.size(); iKey++ )
+    {
+        if( !IsHashableJoinKey(poSrcFeat, oJoin.anPrimaryFields[iKey],
+                               oJoin.anKeyTypes[iKey]) )
+            return false;
+    }
+
+    std::string osKey;
+    for( size_t iKey = 0; iKey < oJoin.anKeyTypes.size(); iKey++ )
+    {
+        // if source key is null, we can't do join.
+        if( !AppendHashJoinKey(osKey, poSrcFeat, oJoin.anPrimaryFields[iKey],
+                               oJoin.anKeyTypes[iKey]) )
+            return true;
+    }
+
+    size_t nSize = 0;
+    const GByte *pabyRecord = oJoin.poTable->Lookup(osKey, &nSize);
+    if( pabyRecord != nullptr )
+    {
+        swq_join_def *psJoinInfo = psSelectInfo->join_defs + iJoin;
+        OGRLayer *poJoinLayer = papoTableLayers[psJoinInfo->secondary_table];
+        *ppoJoinFeature = OGRGenSQLDeserializeFeature(
+            poJoinLayer->GetLayerDefn(), pabyRecord, nSize);
+    }
+    return true;
+}
+
 /************************************************************************/
 /*                          TranslateFeature()                          */
 /************************************************************************/
@@ -1301,6 +1947,13 @@ OGRFeature *OGRGenSQLResultsLayer::TranslateFeature( OGRFeature *poSrcFeat )
         /* we have taken care of this */
         CPLAssert(psJoinInfo->secondary_table == iJoin + 1);
 
+        OGRFeature *poJoinFeature = nullptr;
+        if( FetchHashJoinFeature(iJoin, poSrcFeat, &poJoinFeature) )
+        {
+            apoFeatures.push_back( poJoinFeature );
+            continue;
+        }
+
         OGRLayer *poJoinLayer = papoTableLayers[psJoinInfo->secondary_table];
 
         osFilter = GetFilterForJoin(psJoinInfo->poExpr, poSrcFeat, poJoinLayer,
@@ -1314,8 +1967,6 @@ OGRFeature *OGRGenSQLResultsLayer::TranslateFeature( OGRFeature *poSrcFeat )
             continue;
         }
 
-        OGRFeature *poJoinFeature = nullptr;
-
         poJoinLayer->ResetReading();
         if( poJoinLayer->SetAttributeFilter( osFilter.c_str() ) == OGRERR_NONE )
             poJoinFeature = poJoinLayer->GetNextFeature();
@@ -1560,7 +2211,7 @@ OGRFeature *OGRGenSQLResultsLayer::GetNextFeature()
         return nullptr;
 
     CreateOrderByIndex();
-    if( panFIDIndex == nullptr &&
+    if( m_poOrderBySorter == nullptr &&
         nIteratedFeatures < 0 && psSelectInfo->offset > 0 &&
         psSelectInfo->query_mode == SWQM_RECORDSET )
     {
@@ -1588,7 +2239,7 @@ OGRFeature *OGRGenSQLResultsLayer::GetNextFeature()
     {
         OGRFeature *poFeature = nullptr;
 
-        if( panFIDIndex != nullptr )
+        if( m_poOrderBySorter != nullptr )
             poFeature = GetFeature( nNextIndexFID++ );
         else
         {
@@ -1653,7 +2304,22 @@ OGRFeature *OGRGenSQLResultsLayer::GetFeature( GIntBig nFID )
             return nullptr;
 
         swq_summary& oSummary = psSelectInfo->column_summary[0];
-        if( psSelectInfo->order_specs == 0 )
+        if( m_poDistinctListSorter != nullptr )
+        {
+            size_t nSize = 0;
+            const GByte *pabyRow = nFID < 0 ? nullptr :
+                m_poDistinctListSorter->GetRow( static_cast<GUIntBig>(nFID),
+                                                &nSize );
+            if( pabyRow == nullptr )
+                return nullptr;
+            const char *pszVal =
+                reinterpret_cast<const char *>(pabyRow + sizeof(GUIntBig));
+            if( strcmp( pszVal, SZ_OGR_NULL ) != 0 )
+                poSummaryFeature->SetField( 0, pszVal );
+            else
+                poSummaryFeature->SetFieldNull( 0 );
+        }
+        else if( psSelectInfo->order_specs == 0 )
         {
             if( nFID < 0 || nFID >= static_cast<GIntBig>(
                                     oSummary.oVectorDistinctValues.size()) )
@@ -1710,15 +2376,26 @@ OGRFeature *OGRGenSQLResultsLayer::GetFeature( GIntBig nFID )
     }
 
 /* -------------------------------------------------------------------- */
-/*      Are we running in sorted mode?  If so, run the fid through      */
-/*      the index.                                                      */
+/*      Are we running in sorted mode?  If so, fetch the nFID'th        */
+/*      sorted row, skipping its sort keys.                             */
 /* -------------------------------------------------------------------- */
-    if( panFIDIndex != nullptr )
+    if( m_poOrderBySorter != nullptr )
     {
-        if( nFID < 0 || nFID >= static_cast<GIntBig>(nIndexSize) )
+        if( nFID < 0 )
             return nullptr;
-        else
-            nFID = panFIDIndex[nFID];
+
+        size_t nSize = 0;
+        const GByte *pabyRow =
+            m_poOrderBySorter->GetRow( static_cast<GUIntBig>(nFID), &nSize );
+        if( pabyRow == nullptr )
+            return nullptr;
+
+        GUInt32 nKeysSize = 0;
+        memcpy( &nKeysSize, pabyRow, sizeof(GUInt32) );
+        const size_t nFeatureOffset = sizeof(GUInt32) + nKeysSize;
+        return OGRGenSQLDeserializeFeature( poDefn,
+                                            pabyRow + nFeatureOffset,
+                                            nSize - nFeatureOffset );
     }
 
 /* -------------------------------------------------------------------- */
@@ -1775,143 +2452,209 @@ OGRFeatureDefn *OGRGenSQLResultsLayer::GetLayerDefn()
 }
 
 /************************************************************************/
-/*                         FreeIndexFields()                            */
+/*                           ComparePrimitive()                         */
+/************************************************************************/
+
+template<class T> static inline int ComparePrimitive(const T& a, const T& b)
+{
+    if( a < b )
+        return -1;
+    if( a > b )
+        return 1;
+    return 0;
+}
+
+/* Encoding of the ORDER BY keys in the sorted rows */
+enum
+{
+    SORT_KEY_INTEGER64,
+    SORT_KEY_REAL,
+    SORT_KEY_STRING,
+    SORT_KEY_DATE,
+    SORT_KEY_OTHER
+};
+
+/************************************************************************/
+/*                           AppendSortKeys()                           */
+/*                                                                      */
+/*      Appends the ORDER BY keys of a source feature to a row, as      */
+/*      the size of the keys, followed for each key by a byte telling   */
+/*      whether it is set and not null, and then its value.             */
 /************************************************************************/
 
-void OGRGenSQLResultsLayer::FreeIndexFields(OGRField *pasIndexFields,
-                                            size_t l_nIndexSize,
-                                            bool bFreeArray)
+void OGRGenSQLResultsLayer::AppendSortKeys( OGRFeature *poSrcFeat,
+                                            std::vector<GByte> &abyRow )
 {
     swq_select *psSelectInfo = static_cast<swq_select*>(pSelectInfo);
-    const int nOrderItems = psSelectInfo->order_specs;
 
-/* -------------------------------------------------------------------- */
-/*      Free the key field values.                                      */
-/* -------------------------------------------------------------------- */
-    for( int iKey = 0; iKey < nOrderItems; iKey++ )
+    const size_t nStart = abyRow.size();
+    abyRow.resize( nStart + sizeof(GUInt32) );
+
+    for( int iKey = 0; iKey < psSelectInfo->order_specs; iKey++ )
     {
-        swq_order_def *psKeyDef = psSelectInfo->order_defs + iKey;
+        const int iField = psSelectInfo->order_defs[iKey].field_index;
+        const int nKeyType = m_anSortKeyTypes[iKey];
+
+        // Special fields are always set.
+        const bool bSet = iField >= iFIDFieldIndex ||
+                          poSrcFeat->IsFieldSetAndNotNull( iField );
+        abyRow.push_back( bSet ? 1 : 0 );
+        if( !bSet )
+            continue;
 
-        if ( psKeyDef->field_index >= iFIDFieldIndex )
+        const size_t nOffset = abyRow.size();
+        switch( nKeyType )
         {
-            CPLAssert( psKeyDef->field_index <
-                                    iFIDFieldIndex + SPECIAL_FIELD_COUNT );
-            /* warning: only special fields of type string should be deallocated */
-            if (SpecialFieldTypes[psKeyDef->field_index - iFIDFieldIndex] == SWQ_STRING)
+            case SORT_KEY_INTEGER64:
             {
-                for( size_t i = 0; i < l_nIndexSize; i++ )
-                {
-                    OGRField *psField = pasIndexFields + iKey + i * nOrderItems;
-                    CPLFree( psField->String );
-                }
+                const GIntBig nVal = poSrcFeat->GetFieldAsInteger64( iField );
+                abyRow.resize( nOffset + sizeof(nVal) );
+                memcpy( &abyRow[nOffset], &nVal, sizeof(nVal) );
+                break;
             }
-            continue;
-        }
-
-        OGRFieldDefn *poFDefn =
-            poSrcLayer->GetLayerDefn()->GetFieldDefn( psKeyDef->field_index );
-
-        if( poFDefn->GetType() == OFTString )
-        {
-            for( size_t i = 0; i < l_nIndexSize; i++ )
+            case SORT_KEY_REAL:
             {
-                OGRField *psField = pasIndexFields + iKey + i * nOrderItems;
-
-                if( !OGR_RawField_IsUnset(psField) &&
-                    !OGR_RawField_IsNull(psField) )
-                    CPLFree( psField->String );
+                const double dfVal = poSrcFeat->GetFieldAsDouble( iField );
+                abyRow.resize( nOffset + sizeof(dfVal) );
+                memcpy( &abyRow[nOffset], &dfVal, sizeof(dfVal) );
+                break;
             }
+            case SORT_KEY_STRING:
+            {
+                const char *pszVal = poSrcFeat->GetFieldAsString( iField );
+                abyRow.insert( abyRow.end(), pszVal,
+                               pszVal + strlen(pszVal) + 1 );
+                break;
+            }
+            case SORT_KEY_DATE:
+            {
+                abyRow.resize( nOffset + sizeof(OGRField) );
+                memcpy( &abyRow[nOffset], poSrcFeat->GetRawFieldRef( iField ),
+                        sizeof(OGRField) );
+                break;
+            }
+            default:
+                // Keys of other types are considered as equal.
+                break;
         }
     }
 
-    if( bFreeArray )
-        VSIFree(pasIndexFields);
+    const GUInt32 nKeysSize =
+        static_cast<GUInt32>( abyRow.size() - nStart - sizeof(GUInt32) );
+    memcpy( &abyRow[nStart], &nKeysSize, sizeof(GUInt32) );
 }
 
 /************************************************************************/
-/*                         ReadIndexFields()                            */
+/*                          CompareSortKeys()                           */
+/*                                                                      */
+/*      Compares the keys of two rows built by AppendSortKeys(). Null   */
+/*      and unset values come first in ascending order.                 */
 /************************************************************************/
 
-void OGRGenSQLResultsLayer::ReadIndexFields( OGRFeature* poSrcFeat,
-                                             int nOrderItems,
-                                             OGRField *pasIndexFields )
+int OGRGenSQLResultsLayer::CompareSortKeys( const GByte *pabyRow1,
+                                            const GByte *pabyRow2 )
 {
     swq_select *psSelectInfo = static_cast<swq_select*>(pSelectInfo);
-    for( int iKey = 0; iKey < nOrderItems; iKey++ )
+
+    const GByte *pabyKey1 = pabyRow1 + sizeof(GUInt32);
+    const GByte *pabyKey2 = pabyRow2 + sizeof(GUInt32);
+
+    for( int iKey = 0; iKey < psSelectInfo->order_specs; iKey++ )
     {
-        const swq_order_def *psKeyDef = psSelectInfo->order_defs + iKey;
-        OGRField *psDstField = pasIndexFields + iKey;
+        const bool bSet1 = *(pabyKey1++) != 0;
+        const bool bSet2 = *(pabyKey2++) != 0;
+        int nResult = 0;
 
-        if ( psKeyDef->field_index >= iFIDFieldIndex)
+        if( !bSet1 || !bSet2 )
         {
-            CPLAssert( psKeyDef->field_index <
-                                iFIDFieldIndex + SPECIAL_FIELD_COUNT );
-
-            switch (SpecialFieldTypes[
-                            psKeyDef->field_index - iFIDFieldIndex])
+            nResult = bSet1 ? 1 : bSet2 ? -1 : 0;
+        }
+        else
+        {
+            switch( m_anSortKeyTypes[iKey] )
             {
-                case SWQ_INTEGER:
-                case SWQ_INTEGER64:
-                // Yes, store Integer as Integer64.
-                // This is consistent with the test in Compare()
-                psDstField->Integer64 =
-                    poSrcFeat->GetFieldAsInteger64(
-                        psKeyDef->field_index);
-                break;
-
-                case SWQ_FLOAT:
-                psDstField->Real =
-                    poSrcFeat->GetFieldAsDouble(psKeyDef->field_index);
-                break;
-
+                case SORT_KEY_INTEGER64:
+                {
+                    GIntBig nVal1 = 0;
+                    GIntBig nVal2 = 0;
+                    memcpy( &nVal1, pabyKey1, sizeof(nVal1) );
+                    memcpy( &nVal2, pabyKey2, sizeof(nVal2) );
+                    pabyKey1 += sizeof(nVal1);
+                    pabyKey2 += sizeof(nVal2);
+                    nResult = ComparePrimitive( nVal1, nVal2 );
+                    break;
+                }
+                case SORT_KEY_REAL:
+                {
+                    double dfVal1 = 0.0;
+                    double dfVal2 = 0.0;
+                    memcpy( &dfVal1, pabyKey1, sizeof(dfVal1) );
+                    memcpy( &dfVal2, pabyKey2, sizeof(dfVal2) );
+                    pabyKey1 += sizeof(dfVal1);
+                    pabyKey2 += sizeof(dfVal2);
+                    nResult = ComparePrimitive( dfVal1, dfVal2 );
+                    break;
+                }
+                case SORT_KEY_STRING:
+                {
+                    const char *pszVal1 =
+                        reinterpret_cast<const char *>(pabyKey1);
+                    const char *pszVal2 =
+                        reinterpret_cast<const char *>(pabyKey2);
+                    nResult = strcmp( pszVal1, pszVal2 );
+                    pabyKey1 += strlen(pszVal1) + 1;
+                    pabyKey2 += strlen(pszVal2) + 1;
+                    break;
+                }
+                case SORT_KEY_DATE:
+                {
+                    OGRField sField1;
+                    OGRField sField2;
+                    memcpy( &sField1, pabyKey1, sizeof(OGRField) );
+                    memcpy( &sField2, pabyKey2, sizeof(OGRField) );
+                    pabyKey1 += sizeof(OGRField);
+                    pabyKey2 += sizeof(OGRField);
+                    nResult = OGRCompareDate( &sField1, &sField2 );
+                    break;
+                }
                 default:
-                psDstField->String = CPLStrdup(
-                    poSrcFeat->GetFieldAsString(
-                        psKeyDef->field_index) );
-                break;
+                    break;
             }
-
-            continue;
         }
 
-        OGRFieldDefn *poFDefn = poSrcLayer->GetLayerDefn()->GetFieldDefn(
-            psKeyDef->field_index );
+        if( nResult != 0 )
+            return psSelectInfo->order_defs[iKey].ascending_flag ?
+                                                        nResult : -nResult;
+    }
+
+    return 0;
+}
 
-        OGRField *psSrcField =
-            poSrcFeat->GetRawFieldRef( psKeyDef->field_index );
+/************************************************************************/
+/*                          CompareSortRows()                           */
+/************************************************************************/
 
-        if( poFDefn->GetType() == OFTInteger
-            || poFDefn->GetType() == OFTInteger64
-            || poFDefn->GetType() == OFTReal
-            || poFDefn->GetType() == OFTDate
-            || poFDefn->GetType() == OFTTime
-            || poFDefn->GetType() == OFTDateTime)
-            memcpy( psDstField, psSrcField, sizeof(OGRField) );
-        else if( poFDefn->GetType() == OFTString )
-        {
-            if( poSrcFeat->IsFieldSetAndNotNull( psKeyDef->field_index ) )
-                psDstField->String = CPLStrdup( psSrcField->String );
-            else
-                memcpy( psDstField, psSrcField, sizeof(OGRField) );
-        }
-    }
+int OGRGenSQLResultsLayer::CompareSortRows( const GByte *pabyRow1,
+                                            const GByte *pabyRow2,
+                                            void *pUserData )
+{
+    return static_cast<OGRGenSQLResultsLayer *>(pUserData)->
+                                    CompareSortKeys( pabyRow1, pabyRow2 );
 }
 
 /************************************************************************/
 /*                         CreateOrderByIndex()                         */
 /*                                                                      */
-/*      This method is responsible for creating an index providing      */
-/*      ordered access to the features according to the supplied        */
-/*      ORDER BY clauses.                                               */
+/*      This method is responsible for sorting the result features      */
+/*      according to the supplied ORDER BY clauses.                     */
 /*                                                                      */
 /*      This is accomplished by making one pass through all the         */
-/*      eligible source features, and capturing the order by fields     */
-/*      of all records in memory.  A quick sort is then applied to      */
-/*      this in memory copy of the order-by fields to create the        */
-/*      required index.                                                 */
-/*                                                                      */
-/*      Keeping all the key values in memory will *not* scale up to     */
-/*      very large input datasets.                                      */
+/*      eligible source features, translating them, and handing the     */
+/*      result features, serialized after their sort keys, to a row     */
+/*      sorter. Once they exceed the OGR_SQL_MAX_MEMORY budget, the     */
+/*      sorted rows are spilled to temporary files, and merged back     */
+/*      when reading. The result features are thus streamed in order    */
+/*      without random access to the source layer.                      */
 /************************************************************************/
 
 void OGRGenSQLResultsLayer::CreateOrderByIndex()
@@ -1929,370 +2672,121 @@ void OGRGenSQLResultsLayer::CreateOrderByIndex()
         return;
 
     bOrderByValid = TRUE;
+    m_poOrderBySorter.reset();
 
     ResetReading();
 
 /* -------------------------------------------------------------------- */
-/*      Optimize (memory-wise) ORDER BY ... LIMIT 1 [OFFSET 0] case.    */
+/*      Establish how each key is encoded in the rows.                  */
 /* -------------------------------------------------------------------- */
-    if( psSelectInfo->offset == 0 && psSelectInfo->limit == 1 )
+    m_anSortKeyTypes.resize( nOrderItems );
+    for( int iKey = 0; iKey < nOrderItems; iKey++ )
     {
-        OGRFeature* poSrcFeat = poSrcLayer->GetNextFeature();
-        if( poSrcFeat == nullptr )
-        {
-            panFIDIndex = nullptr;
-            nIndexSize = 0;
-            return;
-        }
+        const swq_order_def *psKeyDef = psSelectInfo->order_defs + iKey;
 
-        OGRField *pasCurrentFields = static_cast<OGRField *>(
-                                    CPLCalloc(sizeof(OGRField), nOrderItems));
-        OGRField *pasBestFields = static_cast<OGRField *>(
-                                    CPLCalloc(sizeof(OGRField), nOrderItems));
-        GIntBig nBestFID = poSrcFeat->GetFID();
-        ReadIndexFields( poSrcFeat, nOrderItems, pasBestFields);
-        delete poSrcFeat;
-        while( (poSrcFeat = poSrcLayer->GetNextFeature()) != nullptr )
+        if( psKeyDef->field_index >= iFIDFieldIndex )
         {
-            ReadIndexFields( poSrcFeat, nOrderItems, pasCurrentFields);
-            if( Compare( pasCurrentFields, pasBestFields ) < 0 )
-            {
-                nBestFID = poSrcFeat->GetFID();
-                FreeIndexFields( pasBestFields, 1, false);
-                memcpy( pasBestFields, pasCurrentFields,
-                        sizeof(OGRField) * nOrderItems );
-            }
-            else
+            CPLAssert( psKeyDef->field_index <
+                                    iFIDFieldIndex + SPECIAL_FIELD_COUNT );
+            switch( SpecialFieldTypes[
+                            psKeyDef->field_index - iFIDFieldIndex] )
             {
-                FreeIndexFields( pasCurrentFields, 1, false);
+                case SWQ_INTEGER:
+                case SWQ_INTEGER64:
+                    m_anSortKeyTypes[iKey] = SORT_KEY_INTEGER64;
+                    break;
+                case SWQ_FLOAT:
+                    m_anSortKeyTypes[iKey] = SORT_KEY_REAL;
+                    break;
+                default:
+                    m_anSortKeyTypes[iKey] = SORT_KEY_STRING;
+                    break;
             }
-            memset( pasCurrentFields, 0, sizeof(OGRField) * nOrderItems );
-            delete poSrcFeat;
+            continue;
         }
-        VSIFree( pasCurrentFields );
-        FreeIndexFields( pasBestFields, 1 );
-        panFIDIndex = static_cast<GIntBig *>(CPLMalloc(sizeof(GIntBig)));
-        panFIDIndex[0] = nBestFID;
-        nIndexSize = 1;
-        return;
-    }
 
-/* -------------------------------------------------------------------- */
-/*      Allocate set of key values, and the output index.               */
-/* -------------------------------------------------------------------- */
-    size_t nFeaturesAlloc = 100;
+        switch( poSrcLayer->GetLayerDefn()->
+                    GetFieldDefn( psKeyDef->field_index )->GetType() )
+        {
+            case OFTInteger:
+            case OFTInteger64:
+                m_anSortKeyTypes[iKey] = SORT_KEY_INTEGER64;
+                break;
+            case OFTReal:
+                m_anSortKeyTypes[iKey] = SORT_KEY_REAL;
+                break;
+            case OFTString:
+                m_anSortKeyTypes[iKey] = SORT_KEY_STRING;
+                break;
+            case OFTDate:
+            case OFTTime:
+            case OFTDateTime:
+                m_anSortKeyTypes[iKey] = SORT_KEY_DATE;
+                break;
+            default:
+                m_anSortKeyTypes[iKey] = SORT_KEY_OTHER;
+                break;
+        }
+    }
 
-    panFIDIndex = nullptr;
-    OGRField *pasIndexFields = static_cast<OGRField *>(
-        CPLCalloc(sizeof(OGRField), nOrderItems * nFeaturesAlloc));
-    GIntBig *panFIDList = static_cast<GIntBig *>(
-        CPLMalloc(sizeof(GIntBig) * nFeaturesAlloc));
+    std::unique_ptr<OGRGenSQLRowSorter> poSorter(
+        new OGRGenSQLRowSorter( CompareSortRows, this, m_nMaxMemory ) );
+    std::vector<GByte> abyRow;
+    OGRFeature *poSrcFeat = nullptr;
 
 /* -------------------------------------------------------------------- */
-/*      Read in all the key values.                                     */
+/*      Optimize (memory-wise) ORDER BY ... LIMIT 1 [OFFSET 0] case     */
+/*      by only keeping the best row.                                   */
 /* -------------------------------------------------------------------- */
-    OGRFeature *poSrcFeat = nullptr;
-    nIndexSize = 0;
-
-    while( (poSrcFeat = poSrcLayer->GetNextFeature()) != nullptr )
+    if( psSelectInfo->offset == 0 && psSelectInfo->limit == 1 )
     {
-        if (nIndexSize == nFeaturesAlloc)
+        std::vector<GByte> abyBestRow;
+        while( (poSrcFeat = poSrcLayer->GetNextFeature()) != nullptr )
         {
-            GUIntBig nNewFeaturesAlloc = static_cast<GUIntBig>(nFeaturesAlloc)
-                                                        + nFeaturesAlloc / 3;
-            if( static_cast<size_t>(nNewFeaturesAlloc) != nNewFeaturesAlloc ||
-                static_cast<size_t>(sizeof(OGRField) * nOrderItems *
-                                    nNewFeaturesAlloc) !=
-                static_cast<GUIntBig>(sizeof(OGRField)) * nOrderItems *
-                nNewFeaturesAlloc )
+            abyRow.clear();
+            AppendSortKeys( poSrcFeat, abyRow );
+            if( abyBestRow.empty() ||
+                CompareSortKeys( abyRow.data(), abyBestRow.data() ) < 0 )
             {
-                CPLError(CE_Failure, CPLE_AppDefined,
-                         "Cannot allocate pasIndexFields");
-                FreeIndexFields( pasIndexFields, nIndexSize );
-                VSIFree(panFIDList);
-                nIndexSize = 0;
-                delete poSrcFeat;
-                return;
-            }
-            OGRField* pasNewIndexFields = static_cast<OGRField *>(
-                VSI_REALLOC_VERBOSE(pasIndexFields,
-                           sizeof(OGRField) * nOrderItems *
-                           static_cast<size_t>(nNewFeaturesAlloc)));
-            if (pasNewIndexFields == nullptr)
-            {
-                CPLError(CE_Failure, CPLE_AppDefined,
-                         "Cannot allocate pasIndexFields");
-                FreeIndexFields( pasIndexFields, nIndexSize );
-                VSIFree(panFIDList);
-                nIndexSize = 0;
-                delete poSrcFeat;
-                return;
-            }
-            pasIndexFields = pasNewIndexFields;
-
-            GIntBig* panNewFIDList = static_cast<GIntBig *>(
-                VSI_REALLOC_VERBOSE(panFIDList, sizeof(GIntBig) *
-                                    static_cast<size_t>(nNewFeaturesAlloc)));
-            if (panNewFIDList == nullptr)
-            {
-                FreeIndexFields( pasIndexFields, nIndexSize );
-                VSIFree(panFIDList);
-                nIndexSize = 0;
-                delete poSrcFeat;
-                return;
+                OGRFeature *poFeature = TranslateFeature( poSrcFeat );
+                if( poFeature != nullptr )
+                {
+                    OGRGenSQLSerializeFeature( poFeature, abyRow );
+                    delete poFeature;
+                    std::swap( abyRow, abyBestRow );
+                }
             }
-            panFIDList = panNewFIDList;
-
-            memset(pasIndexFields + nFeaturesAlloc, 0,
-                   sizeof(OGRField) * nOrderItems *
-                   static_cast<size_t>(nNewFeaturesAlloc - nFeaturesAlloc));
-
-            nFeaturesAlloc = static_cast<size_t>(nNewFeaturesAlloc);
+            delete poSrcFeat;
         }
-
-        ReadIndexFields( poSrcFeat, nOrderItems,
-                         pasIndexFields + nIndexSize * nOrderItems );
-
-        panFIDList[nIndexSize] = poSrcFeat->GetFID();
-        delete poSrcFeat;
-
-        nIndexSize++;
-    }
-
-    //CPLDebug("GenSQL", "CreateOrderByIndex() = %d features", nIndexSize);
-
-/* -------------------------------------------------------------------- */
-/*      Initialize panFIDIndex                                          */
-/* -------------------------------------------------------------------- */
-    panFIDIndex = static_cast<GIntBig *>(
-        VSI_MALLOC_VERBOSE(sizeof(GIntBig) * nIndexSize));
-    if( panFIDIndex == nullptr )
-    {
-        FreeIndexFields( pasIndexFields, nIndexSize );
-        VSIFree(panFIDList);
-        nIndexSize = 0;
-        return;
-    }
-    for( size_t i = 0; i < nIndexSize; i++ )
-        panFIDIndex[i] = static_cast<GIntBig>(i);
-
-/* -------------------------------------------------------------------- */
-/*      Quick sort the records.                                         */
-/* -------------------------------------------------------------------- */
-
-    GIntBig *panMerged = static_cast<GIntBig *>(
-        VSI_MALLOC_VERBOSE( sizeof(GIntBig) * nIndexSize ));
-    if( panMerged == nullptr )
-    {
-        FreeIndexFields( pasIndexFields, nIndexSize );
-        VSIFree(panFIDList);
-        nIndexSize = 0;
-        VSIFree(panFIDIndex);
-        panFIDIndex = nullptr;
-        return;
+        if( !abyBestRow.empty() )
+            poSorter->AddRow( abyBestRow.data(), abyBestRow.size() );
     }
 
-    SortIndexSection( pasIndexFields, panMerged, 0, nIndexSize );
-    VSIFree( panMerged );
-
 /* -------------------------------------------------------------------- */
-/*      Rework the FID map to map to real FIDs.                         */
+/*      Otherwise sort all the rows.                                    */
 /* -------------------------------------------------------------------- */
-    bool bAlreadySorted = true;
-    for( size_t i = 0; i < nIndexSize; i++ )
-    {
-        if (panFIDIndex[i] != static_cast<GIntBig>(i))
-            bAlreadySorted = false;
-        panFIDIndex[i] = panFIDList[panFIDIndex[i]];
-    }
-
-    CPLFree( panFIDList );
-    FreeIndexFields( pasIndexFields, nIndexSize );
-
-    /* If it is already sorted, then free than panFIDIndex array */
-    /* so that GetNextFeature() can call a sequential GetNextFeature() */
-    /* on the source array. Very useful for layers where random access */
-    /* is slow. */
-    /* Use case: the GML result of a WFS GetFeature with a SORTBY */
-    if (bAlreadySorted)
-    {
-        CPLFree( panFIDIndex );
-        panFIDIndex = nullptr;
-
-        nIndexSize = 0;
-    }
-
-    ResetReading();
-}
-
-/************************************************************************/
-/*                          SortIndexSection()                          */
-/*                                                                      */
-/*      Sort the records in a section of the index.                     */
-/************************************************************************/
-
-void OGRGenSQLResultsLayer::SortIndexSection( const OGRField *pasIndexFields,
-                                              GIntBig *panMerged,
-                                              size_t nStart, size_t nEntries )
-
-{
-    if( nEntries < 2 )
-        return;
-
-    swq_select *psSelectInfo = static_cast<swq_select*>(pSelectInfo);
-    const int   nOrderItems = psSelectInfo->order_specs;
-
-    size_t nFirstGroup = nEntries / 2;
-    size_t nFirstStart = nStart;
-    size_t nSecondGroup = nEntries - nFirstGroup;
-    size_t nSecondStart = nStart + nFirstGroup;
-
-    SortIndexSection( pasIndexFields, panMerged, nFirstStart,
-                      nFirstGroup );
-    SortIndexSection( pasIndexFields, panMerged, nSecondStart,
-                      nSecondGroup );
-
-    for( size_t iMerge = 0; iMerge < nEntries; ++iMerge )
+    else
     {
-        int  nResult = 0;
-
-        if( nFirstGroup == 0 )
-            nResult = 1;
-        else if( nSecondGroup == 0 )
-            nResult = -1;
-        else
-            nResult = Compare( pasIndexFields
-                               + panFIDIndex[nFirstStart] * nOrderItems,
-                               pasIndexFields
-                               + panFIDIndex[nSecondStart] * nOrderItems );
-
-        if( nResult > 0 )
-        {
-            panMerged[iMerge] = panFIDIndex[nSecondStart];
-            nSecondStart++;
-            nSecondGroup--;
-        }
-        else
+        while( (poSrcFeat = poSrcLayer->GetNextFeature()) != nullptr )
         {
-            panMerged[iMerge] = panFIDIndex[nFirstStart];
-            nFirstStart++;
-            nFirstGroup--;
-        }
-    }
-
-    /* Copy the merge list back into the main index */
-    memcpy( panFIDIndex + nStart, panMerged, sizeof(GIntBig) * nEntries );
-}
-
-/************************************************************************/
-/*                           ComparePrimitive()                         */
-/************************************************************************/
-
-template<class T> static inline int ComparePrimitive(const T& a, const T& b)
-{
-    if( a < b )
-        return -1;
-    if( a > b )
-        return 1;
-    return 0;
-}
-
-/************************************************************************/
-/*                              Compare()                               */
-/************************************************************************/
-
-int OGRGenSQLResultsLayer::Compare( const OGRField *pasFirstTuple,
-                                    const OGRField *pasSecondTuple )
-
-{
-    swq_select *psSelectInfo = static_cast<swq_select*>(pSelectInfo);
-    int  nResult = 0, iKey;
-
-    for( iKey = 0; nResult == 0 && iKey < psSelectInfo->order_specs; iKey++ )
-    {
-        swq_order_def *psKeyDef = psSelectInfo->order_defs + iKey;
-        OGRFieldDefn *poFDefn = nullptr;
-
-        if( psKeyDef->field_index >= iFIDFieldIndex )
-            poFDefn = nullptr;
-        else
-            poFDefn = poSrcLayer->GetLayerDefn()->GetFieldDefn(
-                psKeyDef->field_index );
+            abyRow.clear();
+            AppendSortKeys( poSrcFeat, abyRow );
+            OGRFeature *poFeature = TranslateFeature( poSrcFeat );
+            delete poSrcFeat;
+            if( poFeature == nullptr )
+                continue;
+            OGRGenSQLSerializeFeature( poFeature, abyRow );
+            delete poFeature;
 
-        if( OGR_RawField_IsUnset(&pasFirstTuple[iKey]) ||
-            OGR_RawField_IsNull(&pasFirstTuple[iKey]) )
-        {
-            if( OGR_RawField_IsUnset(&pasSecondTuple[iKey]) ||
-                OGR_RawField_IsNull(&pasSecondTuple[iKey]) )
-                nResult = 0;
-            else
-                nResult = -1;
-        }
-        else if ( OGR_RawField_IsUnset(&pasSecondTuple[iKey]) ||
-                  OGR_RawField_IsNull(&pasSecondTuple[iKey]) )
-        {
-            nResult = 1;
-        }
-        else if ( poFDefn == nullptr )
-        {
-            CPLAssert( psKeyDef->field_index <
-                                    iFIDFieldIndex + SPECIAL_FIELD_COUNT );
-            switch (SpecialFieldTypes[psKeyDef->field_index - iFIDFieldIndex])
-            {
-              case SWQ_INTEGER:
-                  // Yes, read Integer in Integer64.
-                  // This is consistent with what is done ReadIndexFields()
-              case SWQ_INTEGER64:
-                nResult = ComparePrimitive( pasFirstTuple[iKey].Integer64,
-                                            pasSecondTuple[iKey].Integer64 );
-                break;
-              case SWQ_FLOAT:
-                nResult = ComparePrimitive( pasFirstTuple[iKey].Real,
-                                            pasSecondTuple[iKey].Real );
-                break;
-              case SWQ_STRING:
-                nResult = strcmp(pasFirstTuple[iKey].String,
-                                 pasSecondTuple[iKey].String);
+            if( !poSorter->AddRow( abyRow.data(), abyRow.size() ) )
                 break;
-
-              default:
-                CPLAssert( false );
-                nResult = 0;
-            }
-        }
-        else if( poFDefn->GetType() == OFTInteger )
-        {
-            nResult = ComparePrimitive( pasFirstTuple[iKey].Integer,
-                                        pasSecondTuple[iKey].Integer );
-        }
-        else if( poFDefn->GetType() == OFTInteger64 )
-        {
-            nResult = ComparePrimitive( pasFirstTuple[iKey].Integer64,
-                                        pasSecondTuple[iKey].Integer64 );
-        }
-        else if( poFDefn->GetType() == OFTString )
-        {
-            nResult = strcmp(pasFirstTuple[iKey].String,
-                             pasSecondTuple[iKey].String);
         }
-        else if( poFDefn->GetType() == OFTReal )
-        {
-            nResult = ComparePrimitive( pasFirstTuple[iKey].Real,
-                                        pasSecondTuple[iKey].Real );
-        }
-        else if( poFDefn->GetType() == OFTDate ||
-                 poFDefn->GetType() == OFTTime ||
-                 poFDefn->GetType() == OFTDateTime)
-        {
-            nResult = OGRCompareDate(&pasFirstTuple[iKey],
-                                     &pasSecondTuple[iKey]);
-        }
-
-        if( !(psKeyDef->ascending_flag) )
-            nResult *= -1;
     }
 
-    return nResult;
+    if( poSorter->Finish() )
+        m_poOrderBySorter = std::move(poSorter);
+
+    ResetReading();
 }
 
 /************************************************************************/
@@ -2403,10 +2897,7 @@ void OGRGenSQLResultsLayer::FindAndSetIgnoredFields()
 
 void OGRGenSQLResultsLayer::InvalidateOrderByIndex()
 {
-    CPLFree( panFIDIndex );
-    panFIDIndex = nullptr;
-
-    nIndexSize = 0;
+    m_poOrderBySorter.reset();
     bOrderByValid = FALSE;
 }
 
@@ -35,7 +35,11 @@
 #include "swq.h"
 #include "cpl_hash_set.h"
 #include "cpl_string.h"
+#include "cpl_vsi.h"
 
+#include <memory>
+#include <string>
+#include <unordered_map>
 #include <vector>
 
 /*! @cond Doxygen_Suppress */
@@ -50,6 +54,144 @@
 #define ALL_FIELD_INDEX_TO_GEOM_FIELD_INDEX(poFDefn, idx) \
     ((idx) - ((poFDefn)->GetFieldCount() + SPECIAL_FIELD_COUNT))
 
+/************************************************************************/
+/*                 Spill-to-disk support (ogr_gensql_spill.cpp)         */
+/************************************************************************/
+
+size_t      OGRGenSQLGetMaxMemory();
+
+void        OGRGenSQLSerializeFeature( const OGRFeature *poFeature,
+                                       std::vector<GByte> &abyBuffer );
+OGRFeature *OGRGenSQLDeserializeFeature( OGRFeatureDefn *poDefn,
+                                         const GByte *pabyData,
+                                         size_t nSize );
+
+/************************************************************************/
+/*                          OGRGenSQLTempFile                           */
+/*                                                                      */
+/*      Temporary file of length prefixed records.                      */
+/************************************************************************/
+
+class OGRGenSQLTempFile
+{
+    CPLString           m_osFilename{};
+    VSILFILE           *m_fp = nullptr;
+    bool                m_bMustUnlink = false;
+    std::vector<GByte>  m_abyRecord{};
+
+    CPL_DISALLOW_COPY_ASSIGN(OGRGenSQLTempFile)
+
+  public:
+                        OGRGenSQLTempFile() = default;
+                       ~OGRGenSQLTempFile();
+
+    bool                Open();
+    bool                WriteRecord( const GByte *pabyData, size_t nSize );
+    bool                Rewind();
+    const GByte        *ReadRecord( size_t *pnSize );
+
+    vsi_l_offset        Tell();
+    const GByte        *ReadRecordAt( vsi_l_offset nOffset, size_t *pnSize );
+};
+
+/************************************************************************/
+/*                          OGRGenSQLRowSorter                          */
+/*                                                                      */
+/*      Sorts opaque rows within a memory budget. Sorted runs are       */
+/*      spilled to temporary files and merged back when streaming.      */
+/************************************************************************/
+
+typedef int (*OGRGenSQLRowCompareFunc)( const GByte *pabyRow1,
+                                        const GByte *pabyRow2,
+                                        void *pUserData );
+
+class OGRGenSQLRowSorter
+{
+    OGRGenSQLRowCompareFunc m_pfnCompare;
+    void               *m_pUserData;
+    size_t              m_nMaxMemory;
+
+    std::vector<GByte>  m_abyRows{};
+    std::vector<size_t> m_anRowOffsets{};
+    std::vector<std::unique_ptr<OGRGenSQLTempFile>> m_apoRuns{};
+    GUIntBig            m_nRowCount = 0;
+    bool                m_bFinished = false;
+    bool                m_bError = false;
+
+    struct MergeSource
+    {
+        OGRGenSQLTempFile *poRun;
+        const GByte       *pabyRow;
+        size_t             nSize;
+    };
+    std::vector<MergeSource> m_asSources{};
+    std::vector<int>    m_anHeap{};
+    size_t              m_nNextMemoryRow = 0;
+    GUIntBig            m_nNextRow = 0;
+    int                 m_iLastSource = -1;
+
+    void                SortMemoryRows();
+    bool                SpillMemoryRows();
+    bool                MergeRuns( size_t iFirst, size_t nCount,
+                                   OGRGenSQLTempFile *poOut );
+    bool                StartMerge( std::vector<MergeSource> &asSources,
+                                    std::vector<int> &anHeap );
+    bool                AdvanceSource( MergeSource &sSource );
+    void                PushSource( std::vector<MergeSource> &asSources,
+                                    std::vector<int> &anHeap, int iSource );
+    int                 PopSource( std::vector<MergeSource> &asSources,
+                                   std::vector<int> &anHeap );
+
+    CPL_DISALLOW_COPY_ASSIGN(OGRGenSQLRowSorter)
+
+  public:
+                        OGRGenSQLRowSorter( OGRGenSQLRowCompareFunc pfnCompare,
+                                            void *pUserData,
+                                            size_t nMaxMemory );
+
+    bool                AddRow( const GByte *pabyRow, size_t nSize );
+    bool                Finish();
+
+    GUIntBig            GetRowCount() const { return m_nRowCount; }
+    bool                IsInMemory() const { return m_apoRuns.empty(); }
+
+    void                Rewind();
+    const GByte        *GetNextRow( size_t *pnSize );
+    const GByte        *GetRow( GUIntBig nIndex, size_t *pnSize );
+};
+
+/************************************************************************/
+/*                          OGRGenSQLHashTable                          */
+/*                                                                      */
+/*      Maps binary keys to opaque records, keeping the first record    */
+/*      inserted for a key. Once the memory budget is exceeded, the     */
+/*      records are moved to a temporary file while the keys stay in    */
+/*      memory.                                                         */
+/************************************************************************/
+
+class OGRGenSQLHashTable
+{
+    size_t              m_nMaxMemory;
+    std::unordered_map<std::string, vsi_l_offset> m_oMap{};
+    std::vector<GByte>  m_abyRecords{};
+    std::unique_ptr<OGRGenSQLTempFile> m_poFile{};
+    size_t              m_nKeyMemory = 0;
+
+    bool                Spill();
+
+    CPL_DISALLOW_COPY_ASSIGN(OGRGenSQLHashTable)
+
+  public:
+    explicit            OGRGenSQLHashTable( size_t nMaxMemory );
+
+    bool                Insert( const std::string &osKey,
+                                const GByte *pabyRecord, size_t nSize );
+    const GByte        *Lookup( const std::string &osKey, size_t *pnSize );
+
+    size_t              GetKeyCount() const { return m_oMap.size(); }
+    bool                IsInMemory() const { return m_poFile == nullptr; }
+};
+
 /************************************************************************/
 /*                        OGRGenSQLResultsLayer                         */
 /************************************************************************/
@@ -69,8 +211,8 @@ class OGRGenSQLResultsLayer final: public OGRLayer
 
     int        *panGeomFieldToSrcGeomField;
 
-    size_t      nIndexSize;
-    GIntBig    *panFIDIndex;
+    std::unique_ptr<OGRGenSQLRowSorter> m_poOrderBySorter{};
+    std::vector<int> m_anSortKeyTypes{};
     int         bOrderByValid;
 
     GIntBig      nNextIndexFID;
@@ -84,20 +226,41 @@ class OGRGenSQLResultsLayer final: public OGRLayer
     GIntBig     nIteratedFeatures;
     std::vector<CPLString> m_oDistinctList;
 
+    std::vector<swq_summary::Comparator> m_aoDistinctComparators{};
+    std::vector<std::unique_ptr<OGRGenSQLRowSorter>> m_apoDistinctSorters{};
+    std::vector<GUIntBig> m_anDistinctSpilledCount{};
+    std::unique_ptr<OGRGenSQLRowSorter> m_poDistinctListSorter{};
+    size_t      m_nDistinctMemory = 0;
+    size_t      m_nMaxMemory = 0;
+
+    struct HashJoin
+    {
+        bool        bTried = false;
+        std::vector<int> anPrimaryFields{};
+        std::vector<int> anSecondaryFields{};
+        std::vector<int> anKeyTypes{};
+        std::unique_ptr<OGRGenSQLHashTable> poTable{};
+    };
+    std::vector<HashJoin> m_aoHashJoins{};
+
     int         PrepareSummary();
+    void        AccountDistinctValue( int iField, GIntBig nCountBefore,
+                                      const char *pszValue );
+    bool        SpillDistinctValues( int iField );
+    bool        FinishDistinctValues();
 
     OGRFeature *TranslateFeature( OGRFeature * );
+    bool        BuildHashJoin( int iJoin );
+    bool        FetchHashJoinFeature( int iJoin, OGRFeature *poSrcFeat,
+                                      OGRFeature **ppoJoinFeature );
     void        CreateOrderByIndex();
-    void        ReadIndexFields( OGRFeature* poSrcFeat,
-                                 int nOrderItems,
-                                 OGRField *pasIndexFields );
-    void        SortIndexSection( const OGRField *pasIndexFields,
-                                  GIntBig *panMerged,
-                                  size_t nStart, size_t nEntries );
-    void        FreeIndexFields(OGRField *pasIndexFields,
-                                size_t l_nIndexSize,
-                                bool bFreeArray = true);
-    int         Compare( const OGRField *pasFirst, const OGRField *pasSecond );
+    void        AppendSortKeys( OGRFeature *poSrcFeat,
+                                std::vector<GByte> &abyRow );
+    int         CompareSortKeys( const GByte *pabyRow1,
+                                 const GByte *pabyRow2 );
+    static int  CompareSortRows( const GByte *pabyRow1,
+                                 const GByte *pabyRow2,
+                                 void *pUserData );
 
     void        ClearFilters();
     void        ApplyFiltersToSource();
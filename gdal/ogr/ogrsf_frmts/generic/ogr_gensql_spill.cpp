@@ -0,0 +1,1063 @@
+/******************************************************************************
+ *
+ * Project:  OpenGIS Simple Features Reference Implementation
+ * Purpose:  Spill-to-disk support of the generic SQL executor: temporary
+ *           record files, external row sorting, hash tables and feature
+ *           serialization.
+ *
+ ******************************************************************************
+ * Copyright (c) 2018, GDAL contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ ****************************************************************************/
+
+#include "ogr_gensql.h"
+#include "cpl_conv.h"
+#include "cpl_error.h"
+
+#include <algorithm>
+#include <cstring>
+#include <limits>
+#include <new>
+
+//! @cond Doxygen_Suppress
+
+CPL_CVSID("$Id$")
+
+// Maximum number of runs merged at once.
+static const size_t MAX_MERGE_FAN_IN = 64;
+
+/************************************************************************/
+/*                       OGRGenSQLGetMaxMemory()                        */
+/*                                                                      */
+/*      Memory budget, in bytes, of the sorts and DISTINCT sets of      */
+/*      the SQL executor, above which they are spilled to disk.         */
+/************************************************************************/
+
+size_t OGRGenSQLGetMaxMemory()
+{
+    // In megabytes. Fractional values are accepted.
+    const double dfMaxMemory =
+        CPLAtof(CPLGetConfigOption("OGR_SQL_MAX_MEMORY", "100")) *
+        1024 * 1024;
+    if( !(dfMaxMemory >= 1.0) )
+        return 1;
+    if( dfMaxMemory >=
+            static_cast<double>(std::numeric_limits<size_t>::max()) )
+        return std::numeric_limits<size_t>::max();
+    return static_cast<size_t>(dfMaxMemory);
+}
+
+/************************************************************************/
+/* ==================================================================== */
+/*                          OGRGenSQLTempFile                           */
+/* ==================================================================== */
+/************************************************************************/
+
+/************************************************************************/
+/*                         ~OGRGenSQLTempFile()                         */
+/************************************************************************/
+
+OGRGenSQLTempFile::~OGRGenSQLTempFile()
+{
+    if( m_fp != nullptr )
+        VSIFCloseL(m_fp);
+    if( m_bMustUnlink )
+        VSIUnlink(m_osFilename);
+}
+
+/************************************************************************/
+/*                                Open()                                */
+/************************************************************************/
+
+bool OGRGenSQLTempFile::Open()
+{
+    m_osFilename = CPLGenerateTempFilename("ogr_gensql");
+    m_fp = VSIFOpenL(m_osFilename, "wb+");
+    if( m_fp == nullptr )
+    {
+        CPLError(CE_Failure, CPLE_FileIO,
+                 "Cannot create temporary file %s", m_osFilename.c_str());
+        return false;
+    }
+
+    // On Unix filesystems, an opened file can be removed right away.
+    CPLPushErrorHandler(CPLQuietErrorHandler);
+    m_bMustUnlink = VSIUnlink(m_osFilename) != 0;
+    CPLPopErrorHandler();
+    return true;
+}
+
+/************************************************************************/
+/*                            WriteRecord()                             */
+/************************************************************************/
+
+bool OGRGenSQLTempFile::WriteRecord( const GByte *pabyData, size_t nSize )
+{
+    if( nSize > std::numeric_limits<GUInt32>::max() )
+    {
+        CPLError(CE_Failure, CPLE_NotSupported, "Too large record");
+        return false;
+    }
+    const GUInt32 nSize32 = static_cast<GUInt32>(nSize);
+    if( VSIFWriteL(&nSize32, sizeof(nSize32), 1, m_fp) != 1 ||
+        (nSize > 0 && VSIFWriteL(pabyData, nSize, 1, m_fp) != 1) )
+    {
+        CPLError(CE_Failure, CPLE_FileIO,
+                 "Cannot write to temporary file %s", m_osFilename.c_str());
+        return false;
+    }
+    return true;
+}
+
+/************************************************************************/
+/*                               Rewind()                               */
+/************************************************************************/
+
+bool OGRGenSQLTempFile::Rewind()
+{
+    return VSIFSeekL(m_fp, 0, SEEK_SET) == 0;
+}
+
+/************************************************************************/
+/*                             ReadRecord()                             */
+/*                                                                      */
+/*      Returns the next record, valid until the next call, or          */
+/*      nullptr at the end of the file.                                 */
+/************************************************************************/
+
+const GByte *OGRGenSQLTempFile::ReadRecord( size_t *pnSize )
+{
+    GUInt32 nSize32 = 0;
+    const size_t nRead = VSIFReadL(&nSize32, 1, sizeof(nSize32), m_fp);
+    if( nRead == 0 )
+        return nullptr;
+    try
+    {
+        m_abyRecord.resize(std::max(static_cast<size_t>(nSize32),
+                                    static_cast<size_t>(1)));
+    }
+    catch( const std::bad_alloc& )
+    {
+        CPLError(CE_Failure, CPLE_OutOfMemory,
+                 "Cannot allocate %u bytes", nSize32);
+        return nullptr;
+    }
+    if( nRead != sizeof(nSize32) ||
+        (nSize32 > 0 && VSIFReadL(&m_abyRecord[0], nSize32, 1, m_fp) != 1) )
+    {
+        CPLError(CE_Failure, CPLE_FileIO,
+                 "Cannot read temporary file %s", m_osFilename.c_str());
+        return nullptr;
+    }
+    *pnSize = nSize32;
+    return &m_abyRecord[0];
+}
+
+/************************************************************************/
+/*                                Tell()                                */
+/************************************************************************/
+
+vsi_l_offset OGRGenSQLTempFile::Tell()
+{
+    return VSIFTellL(m_fp);
+}
+
+/************************************************************************/
+/*                            ReadRecordAt()                            */
+/************************************************************************/
+
+const GByte *OGRGenSQLTempFile::ReadRecordAt( vsi_l_offset nOffset,
+                                              size_t *pnSize )
+{
+    if( VSIFSeekL(m_fp, nOffset, SEEK_SET) != 0 )
+    {
+        CPLError(CE_Failure, CPLE_FileIO,
+                 "Cannot seek in temporary file %s", m_osFilename.c_str());
+        return nullptr;
+    }
+    return ReadRecord(pnSize);
+}
+
+/************************************************************************/
+/* ==================================================================== */
+/*                          OGRGenSQLRowSorter                          */
+/* ==================================================================== */
+/************************************************************************/
+
+/************************************************************************/
+/*                         OGRGenSQLRowSorter()                         */
+/************************************************************************/
+
+OGRGenSQLRowSorter::OGRGenSQLRowSorter( OGRGenSQLRowCompareFunc pfnCompare,
+                                        void *pUserData,
+                                        size_t nMaxMemory ) :
+    m_pfnCompare(pfnCompare),
+    m_pUserData(pUserData),
+    m_nMaxMemory(nMaxMemory)
+{
+}
+
+/************************************************************************/
+/*                               AddRow()                               */
+/*                                                                      */
+/*      Rows are stored in memory prefixed with their size. When the    */
+/*      memory budget is exceeded, they are sorted and written to a     */
+/*      temporary file as a run.                                        */
+/************************************************************************/
+
+bool OGRGenSQLRowSorter::AddRow( const GByte *pabyRow, size_t nSize )
+{
+    if( m_bFinished || m_bError )
+        return false;
+    if( nSize > std::numeric_limits<GUInt32>::max() )
+    {
+        CPLError(CE_Failure, CPLE_NotSupported, "Too large row");
+        m_bError = true;
+        return false;
+    }
+
+    const size_t nNeeded = sizeof(GUInt32) + nSize + sizeof(size_t);
+    if( !m_anRowOffsets.empty() &&
+        m_abyRows.size() + m_anRowOffsets.size() * sizeof(size_t) >
+                                        m_nMaxMemory - std::min(m_nMaxMemory,
+                                                                nNeeded) )
+    {
+        if( !SpillMemoryRows() )
+        {
+            m_bError = true;
+            return false;
+        }
+    }
+
+    try
+    {
+        const size_t nOffset = m_abyRows.size();
+        const GUInt32 nSize32 = static_cast<GUInt32>(nSize);
+        m_abyRows.resize(nOffset + sizeof(GUInt32) + nSize);
+        memcpy(&m_abyRows[nOffset], &nSize32, sizeof(GUInt32));
+        if( nSize > 0 )
+            memcpy(&m_abyRows[nOffset + sizeof(GUInt32)], pabyRow, nSize);
+        m_anRowOffsets.push_back(nOffset);
+    }
+    catch( const std::bad_alloc& )
+    {
+        CPLError(CE_Failure, CPLE_OutOfMemory,
+                 "Cannot allocate memory for sorting");
+        m_bError = true;
+        return false;
+    }
+    m_nRowCount++;
+    return true;
+}
+
+/************************************************************************/
+/*                           SortMemoryRows()                           */
+/************************************************************************/
+
+void OGRGenSQLRowSorter::SortMemoryRows()
+{
+    const GByte *pabyRows = m_abyRows.data();
+    OGRGenSQLRowCompareFunc pfnCompare = m_pfnCompare;
+    void *pUserData = m_pUserData;
+    // Stable, so that rows with equal keys keep their insertion order.
+    std::stable_sort(m_anRowOffsets.begin(), m_anRowOffsets.end(),
+        [pabyRows, pfnCompare, pUserData](size_t nOffset1, size_t nOffset2)
+        {
+            return pfnCompare(pabyRows + nOffset1 + sizeof(GUInt32),
+                              pabyRows + nOffset2 + sizeof(GUInt32),
+                              pUserData) < 0;
+        });
+}
+
+/************************************************************************/
+/*                          SpillMemoryRows()                           */
+/************************************************************************/
+
+bool OGRGenSQLRowSorter::SpillMemoryRows()
+{
+    SortMemoryRows();
+
+    std::unique_ptr<OGRGenSQLTempFile> poRun(new OGRGenSQLTempFile());
+    if( !poRun->Open() )
+        return false;
+    for( const size_t nOffset : m_anRowOffsets )
+    {
+        GUInt32 nSize32 = 0;
+        memcpy(&nSize32, &m_abyRows[nOffset], sizeof(GUInt32));
+        if( !poRun->WriteRecord(&m_abyRows[nOffset] + sizeof(GUInt32),
+                                nSize32) )
+            return false;
+    }
+
+    CPLDebug("GenSQL", "Spilled run %d of %d rows to disk",
+             static_cast<int>(m_apoRuns.size()) + 1,
+             static_cast<int>(m_anRowOffsets.size()));
+
+    m_apoRuns.push_back(std::move(poRun));
+    // Keep the capacity of the buffers for the next run.
+    m_abyRows.clear();
+    m_anRowOffsets.clear();
+    return true;
+}
+
+/************************************************************************/
+/*                           AdvanceSource()                            */
+/*                                                                      */
+/*      Loads the next row of a run, or of the in-memory rows if the    */
+/*      source has no run.                                              */
+/************************************************************************/
+
+bool OGRGenSQLRowSorter::AdvanceSource( MergeSource &sSource )
+{
+    if( sSource.poRun != nullptr )
+    {
+        sSource.pabyRow = sSource.poRun->ReadRecord(&sSource.nSize);
+        return sSource.pabyRow != nullptr;
+    }
+
+    if( m_nNextMemoryRow >= m_anRowOffsets.size() )
+        return false;
+    const size_t nOffset = m_anRowOffsets[m_nNextMemoryRow++];
+    GUInt32 nSize32 = 0;
+    memcpy(&nSize32, &m_abyRows[nOffset], sizeof(GUInt32));
+    sSource.pabyRow = &m_abyRows[nOffset] + sizeof(GUInt32);
+    sSource.nSize = nSize32;
+    return true;
+}
+
+
+/************************************************************************/
+/*                      PushSource() / PopSource()                      */
+/*                                                                      */
+/*      Heap of the sources of a merge, the top being the source with   */
+/*      the smallest current row. Ties are resolved in favour of the    */
+/*      earliest source, so that the merge is stable.                   */
+/************************************************************************/
+
+void OGRGenSQLRowSorter::PushSource( std::vector<MergeSource> &asSources,
+                                     std::vector<int> &anHeap, int iSource )
+{
+    anHeap.push_back(iSource);
+    std::push_heap(anHeap.begin(), anHeap.end(),
+        [this, &asSources](int i, int j)
+        {
+            const int nRes = m_pfnCompare(asSources[i].pabyRow,
+                                          asSources[j].pabyRow, m_pUserData);
+            return nRes > 0 || (nRes == 0 && i > j);
+        });
+}
+
+int OGRGenSQLRowSorter::PopSource( std::vector<MergeSource> &asSources,
+                                   std::vector<int> &anHeap )
+{
+    if( anHeap.empty() )
+        return -1;
+    std::pop_heap(anHeap.begin(), anHeap.end(),
+        [this, &asSources](int i, int j)
+        {
+            const int nRes = m_pfnCompare(asSources[i].pabyRow,
+                                          asSources[j].pabyRow, m_pUserData);
+            return nRes > 0 || (nRes == 0 && i > j);
+        });
+    const int iSource = anHeap.back();
+    anHeap.pop_back();
+    return iSource;
+}
+
+/************************************************************************/
+/*                             StartMerge()                             */
+/*                                                                      */
+/*      Rewinds the sources and loads their first row in the heap.      */
+/************************************************************************/
+
+bool OGRGenSQLRowSorter::StartMerge( std::vector<MergeSource> &asSources,
+                                     std::vector<int> &anHeap )
+{
+    anHeap.clear();
+    for( size_t i = 0; i < asSources.size(); i++ )
+    {
+        if( asSources[i].poRun == nullptr )
+            m_nNextMemoryRow = 0;
+        else if( !asSources[i].poRun->Rewind() )
+        {
+            CPLError(CE_Failure, CPLE_FileIO, "Cannot rewind temporary file");
+            return false;
+        }
+        if( AdvanceSource(asSources[i]) )
+            PushSource(asSources, anHeap, static_cast<int>(i));
+    }
+    return true;
+}
+
+/************************************************************************/
+/*                             MergeRuns()                              */
+/************************************************************************/
+
+bool OGRGenSQLRowSorter::MergeRuns( size_t iFirst, size_t nCount,
+                                    OGRGenSQLTempFile *poOut )
+{
+    std::vector<MergeSource> asSources;
+    for( size_t i = iFirst; i < iFirst + nCount; i++ )
+    {
+        MergeSource sSource = { m_apoRuns[i].get(), nullptr, 0 };
+        asSources.push_back(sSource);
+    }
+
+    std::vector<int> anHeap;
+    if( !StartMerge(asSources, anHeap) )
+        return false;
+
+    int iSource = 0;
+    while( (iSource = PopSource(asSources, anHeap)) >= 0 )
+    {
+        MergeSource &sSource = asSources[iSource];
+        if( !poOut->WriteRecord(sSource.pabyRow, sSource.nSize) )
+            return false;
+        if( AdvanceSource(sSource) )
+            PushSource(asSources, anHeap, iSource);
+    }
+    return true;
+}
+
+/************************************************************************/
+/*                               Finish()                               */
+/*                                                                      */
+/*      Sorts the rows still in memory, and merges the runs until at    */
+/*      most MAX_MERGE_FAN_IN are left to be merged when streaming.     */
+/*      The in-memory rows are the last source of that final merge.     */
+/************************************************************************/
+
+bool OGRGenSQLRowSorter::Finish()
+{
+    if( m_bError )
+        return false;
+    if( m_bFinished )
+        return true;
+
+    SortMemoryRows();
+
+    while( m_apoRuns.size() > MAX_MERGE_FAN_IN )
+    {
+        std::vector<std::unique_ptr<OGRGenSQLTempFile>> apoNewRuns;
+        for( size_t i = 0; i < m_apoRuns.size(); i += MAX_MERGE_FAN_IN )
+        {
+            const size_t nCount =
+                std::min(MAX_MERGE_FAN_IN, m_apoRuns.size() - i);
+            if( nCount == 1 )
+            {
+                apoNewRuns.push_back(std::move(m_apoRuns[i]));
+                continue;
+            }
+            std::unique_ptr<OGRGenSQLTempFile> poRun(new OGRGenSQLTempFile());
+            if( !poRun->Open() || !MergeRuns(i, nCount, poRun.get()) )
+            {
+                m_bError = true;
+                return false;
+            }
+            for( size_t j = i; j < i + nCount; j++ )
+                m_apoRuns[j].reset();
+            apoNewRuns.push_back(std::move(poRun));
+        }
+        CPLDebug("GenSQL", "Merged %d runs into %d",
+                 static_cast<int>(m_apoRuns.size()),
+                 static_cast<int>(apoNewRuns.size()));
+        m_apoRuns = std::move(apoNewRuns);
+    }
+
+    m_bFinished = true;
+    Rewind();
+    return !m_bError;
+}
+
+/************************************************************************/
+/*                               Rewind()                               */
+/************************************************************************/
+
+void OGRGenSQLRowSorter::Rewind()
+{
+    if( !m_bFinished || m_bError )
+        return;
+
+    m_nNextRow = 0;
+    m_nNextMemoryRow = 0;
+    m_iLastSource = -1;
+    if( IsInMemory() )
+        return;
+
+    m_asSources.clear();
+    for( const auto& poRun : m_apoRuns )
+    {
+        MergeSource sSource = { poRun.get(), nullptr, 0 };
+        m_asSources.push_back(sSource);
+    }
+    MergeSource sMemorySource = { nullptr, nullptr, 0 };
+    m_asSources.push_back(sMemorySource);
+
+    if( !StartMerge(m_asSources, m_anHeap) )
+        m_bError = true;
+}
+
+/************************************************************************/
+/*                             GetNextRow()                             */
+/*                                                                      */
+/*      Returns the next row in sorted order, valid until the next      */
+/*      call, or nullptr after the last one.                            */
+/************************************************************************/
+
+const GByte *OGRGenSQLRowSorter::GetNextRow( size_t *pnSize )
+{
+    if( !m_bFinished || m_bError )
+        return nullptr;
+
+    if( IsInMemory() )
+    {
+        MergeSource sSource = { nullptr, nullptr, 0 };
+        if( !AdvanceSource(sSource) )
+            return nullptr;
+        m_nNextRow++;
+        *pnSize = sSource.nSize;
+        return sSource.pabyRow;
+    }
+
+    // The row returned by the previous call is not needed anymore.
+    if( m_iLastSource >= 0 &&
+        AdvanceSource(m_asSources[m_iLastSource]) )
+    {
+        PushSource(m_asSources, m_anHeap, m_iLastSource);
+    }
+    m_iLastSource = PopSource(m_asSources, m_anHeap);
+    if( m_iLastSource < 0 )
+        return nullptr;
+    m_nNextRow++;
+    *pnSize = m_asSources[m_iLastSource].nSize;
+    return m_asSources[m_iLastSource].pabyRow;
+}
+
+/************************************************************************/
+/*                               GetRow()                               */
+/*                                                                      */
+/*      Random access to the rows in sorted order. Once spilled, the    */
+/*      rows are streamed, so that this is only efficient for           */
+/*      increasing indices.                                             */
+/************************************************************************/
+
+const GByte *OGRGenSQLRowSorter::GetRow( GUIntBig nIndex, size_t *pnSize )
+{
+    if( !m_bFinished || m_bError || nIndex >= m_nRowCount )
+        return nullptr;
+
+    if( IsInMemory() )
+    {
+        m_nNextMemoryRow = static_cast<size_t>(nIndex);
+        m_nNextRow = nIndex;
+        return GetNextRow(pnSize);
+    }
+
+    if( nIndex < m_nNextRow )
+        Rewind();
+    while( m_nNextRow < nIndex )
+    {
+        if( GetNextRow(pnSize) == nullptr )
+            return nullptr;
+    }
+    return GetNextRow(pnSize);
+}
+
+/************************************************************************/
+/* ==================================================================== */
+/*                          OGRGenSQLHashTable                          */
+/* ==================================================================== */
+/************************************************************************/
+
+// Rough per key overhead of a node of the hash table.
+static const size_t HASH_ENTRY_OVERHEAD = 64;
+
+/************************************************************************/
+/*                         OGRGenSQLHashTable()                         */
+/************************************************************************/
+
+OGRGenSQLHashTable::OGRGenSQLHashTable( size_t nMaxMemory ) :
+    m_nMaxMemory(nMaxMemory)
+{
+}
+
+/************************************************************************/
+/*                               Spill()                                */
+/*                                                                      */
+/*      Records are kept in memory with the same layout as in the       */
+/*      temporary file, so that their offsets remain valid.             */
+/************************************************************************/
+
+bool OGRGenSQLHashTable::Spill()
+{
+    m_poFile.reset(new OGRGenSQLTempFile());
+    if( !m_poFile->Open() )
+        return false;
+
+    size_t nOffset = 0;
+    while( nOffset < m_abyRecords.size() )
+    {
+        GUInt32 nSize32 = 0;
+        memcpy(&nSize32, &m_abyRecords[nOffset], sizeof(nSize32));
+        nOffset += sizeof(nSize32);
+        if( !m_poFile->WriteRecord(m_abyRecords.data() + nOffset, nSize32) )
+            return false;
+        nOffset += nSize32;
+    }
+    CPLDebug("GenSQL", "Spilled hash table of %d keys to disk",
+             static_cast<int>(m_oMap.size()));
+
+    std::vector<GByte>().swap(m_abyRecords);
+    return true;
+}
+
+/************************************************************************/
+/*                               Insert()                               */
+/*                                                                      */
+/*      Records of keys already present are ignored.                    */
+/************************************************************************/
+
+bool OGRGenSQLHashTable::Insert( const std::string &osKey,
+                                 const GByte *pabyRecord, size_t nSize )
+{
+    if( m_oMap.find(osKey) != m_oMap.end() )
+        return true;
+
+    if( nSize > std::numeric_limits<GUInt32>::max() )
+    {
+        CPLError(CE_Failure, CPLE_NotSupported, "Too large record");
+        return false;
+    }
+
+    vsi_l_offset nOffset = 0;
+    if( m_poFile )
+    {
+        nOffset = m_poFile->Tell();
+        if( !m_poFile->WriteRecord(pabyRecord, nSize) )
+            return false;
+    }
+    else
+    {
+        nOffset = m_abyRecords.size();
+        try
+        {
+            const GUInt32 nSize32 = static_cast<GUInt32>(nSize);
+            const GByte *pabySize = reinterpret_cast<const GByte *>(&nSize32);
+            m_abyRecords.insert(m_abyRecords.end(), pabySize,
+                                pabySize + sizeof(nSize32));
+            m_abyRecords.insert(m_abyRecords.end(), pabyRecord,
+                                pabyRecord + nSize);
+        }
+        catch( const std::bad_alloc& )
+        {
+            CPLError(CE_Failure, CPLE_OutOfMemory,
+                     "Cannot allocate hash table record");
+            return false;
+        }
+    }
+
+    m_oMap[osKey] = nOffset;
+    m_nKeyMemory += osKey.size() + HASH_ENTRY_OVERHEAD;
+
+    if( !m_poFile && m_abyRecords.size() + m_nKeyMemory > m_nMaxMemory )
+        return Spill();
+    return true;
+}
+
+/************************************************************************/
+/*                               Lookup()                               */
+/*                                                                      */
+/*      Returns the record of the key, valid until the next call, or    */
+/*      nullptr if the key is absent.                                   */
+/************************************************************************/
+
+const GByte *OGRGenSQLHashTable::Lookup( const std::string &osKey,
+                                         size_t *pnSize )
+{
+    const auto oIter = m_oMap.find(osKey);
+    if( oIter == m_oMap.end() )
+        return nullptr;
+
+    if( m_poFile )
+        return m_poFile->ReadRecordAt(oIter->second, pnSize);
+
+    const size_t nOffset = static_cast<size_t>(oIter->second);
+    GUInt32 nSize32 = 0;
+    memcpy(&nSize32, &m_abyRecords[nOffset], sizeof(nSize32));
+    *pnSize = nSize32;
+    return m_abyRecords.data() + nOffset + sizeof(nSize32);
+}
+
+/************************************************************************/
+/* ==================================================================== */
+/*                        Feature serialization                         */
+/* ==================================================================== */
+/************************************************************************/
+
+namespace {
+
+template<class T> void AppendValue( std::vector<GByte> &abyBuffer,
+                                    const T &value )
+{
+    const size_t nOffset = abyBuffer.size();
+    abyBuffer.resize(nOffset + sizeof(T));
+    memcpy(&abyBuffer[nOffset], &value, sizeof(T));
+}
+
+void AppendBytes( std::vector<GByte> &abyBuffer,
+                  const void *pData, size_t nSize )
+{
+    if( nSize == 0 )
+        return;
+    const GByte *pabyData = static_cast<const GByte *>(pData);
+    abyBuffer.insert(abyBuffer.end(), pabyData, pabyData + nSize);
+}
+
+// Strings are stored with their terminating nul character, so that they
+// can be used in place when deserializing. A size of 0 means nullptr.
+void AppendString( std::vector<GByte> &abyBuffer, const char *pszStr )
+{
+    if( pszStr == nullptr )
+    {
+        AppendValue(abyBuffer, static_cast<GUInt32>(0));
+        return;
+    }
+    const size_t nLen = strlen(pszStr) + 1;
+    AppendValue(abyBuffer, static_cast<GUInt32>(nLen));
+    AppendBytes(abyBuffer, pszStr, nLen);
+}
+
+class OGRGenSQLBufferReader
+{
+    const GByte *m_pabyCur;
+    const GByte *m_pabyEnd;
+    bool         m_bError = false;
+
+  public:
+    OGRGenSQLBufferReader( const GByte *pabyData, size_t nSize ) :
+        m_pabyCur(pabyData), m_pabyEnd(pabyData + nSize) {}
+
+    bool HasError() const { return m_bError; }
+
+    const GByte *ReadBytes( size_t nSize )
+    {
+        if( m_bError ||
+            nSize > static_cast<size_t>(m_pabyEnd - m_pabyCur) )
+        {
+            m_bError = true;
+            return nullptr;
+        }
+        const GByte *pabyRet = m_pabyCur;
+        m_pabyCur += nSize;
+        return pabyRet;
+    }
+
+    template<class T> T ReadValue()
+    {
+        T value = T();
+        const GByte *pabyData = ReadBytes(sizeof(T));
+        if( pabyData != nullptr )
+            memcpy(&value, pabyData, sizeof(T));
+        return value;
+    }
+
+    const char *ReadString()
+    {
+        const GUInt32 nLen = ReadValue<GUInt32>();
+        if( nLen == 0 )
+            return nullptr;
+        const char *pszStr = reinterpret_cast<const char *>(ReadBytes(nLen));
+        if( pszStr != nullptr && pszStr[nLen - 1] != '\0' )
+        {
+            m_bError = true;
+            return nullptr;
+        }
+        return pszStr;
+    }
+};
+
+enum
+{
+    FIELD_UNSET = 0,
+    FIELD_NULL = 1,
+    FIELD_SET = 2
+};
+
+} // namespace
+
+/************************************************************************/
+/*                     OGRGenSQLSerializeFeature()                      */
+/*                                                                      */
+/*      Appends the content of a feature to a buffer, in a layout only  */
+/*      meant to be read back by OGRGenSQLDeserializeFeature() with     */
+/*      the same feature definition, in the same process.               */
+/************************************************************************/
+
+void OGRGenSQLSerializeFeature( const OGRFeature *poFeature,
+                                std::vector<GByte> &abyBuffer )
+{
+    const OGRFeatureDefn *poDefn = poFeature->GetDefnRef();
+
+    AppendValue(abyBuffer, poFeature->GetFID());
+
+    const int nFieldCount = poDefn->GetFieldCount();
+    for( int iField = 0; iField < nFieldCount; iField++ )
+    {
+        if( !poFeature->IsFieldSet(iField) )
+        {
+            AppendValue(abyBuffer, static_cast<GByte>(FIELD_UNSET));
+            continue;
+        }
+        if( poFeature->IsFieldNull(iField) )
+        {
+            AppendValue(abyBuffer, static_cast<GByte>(FIELD_NULL));
+            continue;
+        }
+        AppendValue(abyBuffer, static_cast<GByte>(FIELD_SET));
+
+        const OGRField *psField = poFeature->GetRawFieldRef(iField);
+        switch( poDefn->GetFieldDefn(iField)->GetType() )
+        {
+            case OFTInteger:
+                AppendValue(abyBuffer, psField->Integer);
+                break;
+            case OFTInteger64:
+                AppendValue(abyBuffer, psField->Integer64);
+                break;
+            case OFTReal:
+                AppendValue(abyBuffer, psField->Real);
+                break;
+            case OFTDate:
+            case OFTTime:
+            case OFTDateTime:
+                AppendValue(abyBuffer, *psField);
+                break;
+            case OFTIntegerList:
+                AppendValue(abyBuffer, psField->IntegerList.nCount);
+                AppendBytes(abyBuffer, psField->IntegerList.paList,
+                            sizeof(int) * psField->IntegerList.nCount);
+                break;
+            case OFTInteger64List:
+                AppendValue(abyBuffer, psField->Integer64List.nCount);
+                AppendBytes(abyBuffer, psField->Integer64List.paList,
+                            sizeof(GIntBig) * psField->Integer64List.nCount);
+                break;
+            case OFTRealList:
+                AppendValue(abyBuffer, psField->RealList.nCount);
+                AppendBytes(abyBuffer, psField->RealList.paList,
+                            sizeof(double) * psField->RealList.nCount);
+                break;
+            case OFTStringList:
+                AppendValue(abyBuffer, psField->StringList.nCount);
+                for( int i = 0; i < psField->StringList.nCount; i++ )
+                    AppendString(abyBuffer, psField->StringList.paList[i]);
+                break;
+            case OFTBinary:
+                AppendValue(abyBuffer, psField->Binary.nCount);
+                AppendBytes(abyBuffer, psField->Binary.paData,
+                            psField->Binary.nCount);
+                break;
+            default:
+                AppendString(abyBuffer, poFeature->GetFieldAsString(iField));
+                break;
+        }
+    }
+
+    const int nGeomFieldCount = poDefn->GetGeomFieldCount();
+    for( int iGeomField = 0; iGeomField < nGeomFieldCount; iGeomField++ )
+    {
+        const OGRGeometry *poGeom = poFeature->GetGeomFieldRef(iGeomField);
+        if( poGeom == nullptr )
+        {
+            AppendValue(abyBuffer, static_cast<GUInt32>(0));
+            continue;
+        }
+        const int nWkbSize = poGeom->WkbSize();
+        AppendValue(abyBuffer, static_cast<GUInt32>(nWkbSize));
+        const size_t nOffset = abyBuffer.size();
+        abyBuffer.resize(nOffset + nWkbSize);
+        poGeom->exportToWkb(wkbNDR, &abyBuffer[nOffset], wkbVariantIso);
+    }
+
+    AppendString(abyBuffer, poFeature->GetStyleString());
+    AppendString(abyBuffer, poFeature->GetNativeData());
+    AppendString(abyBuffer, poFeature->GetNativeMediaType());
+}
+
+/************************************************************************/
+/*                    OGRGenSQLDeserializeFeature()                     */
+/************************************************************************/
+
+OGRFeature *OGRGenSQLDeserializeFeature( OGRFeatureDefn *poDefn,
+                                         const GByte *pabyData,
+                                         size_t nSize )
+{
+    OGRGenSQLBufferReader oReader(pabyData, nSize);
+    OGRFeature *poFeature = new OGRFeature(poDefn);
+
+    poFeature->SetFID(oReader.ReadValue<GIntBig>());
+
+    const int nFieldCount = poDefn->GetFieldCount();
+    for( int iField = 0; iField < nFieldCount && !oReader.HasError();
+         iField++ )
+    {
+        const GByte nState = oReader.ReadValue<GByte>();
+        if( nState == FIELD_UNSET )
+            continue;
+        if( nState == FIELD_NULL )
+        {
+            poFeature->SetFieldNull(iField);
+            continue;
+        }
+
+        switch( poDefn->GetFieldDefn(iField)->GetType() )
+        {
+            case OFTInteger:
+                poFeature->SetField(iField, oReader.ReadValue<int>());
+                break;
+            case OFTInteger64:
+                poFeature->SetField(iField, oReader.ReadValue<GIntBig>());
+                break;
+            case OFTReal:
+                poFeature->SetField(iField, oReader.ReadValue<double>());
+                break;
+            case OFTDate:
+            case OFTTime:
+            case OFTDateTime:
+            {
+                OGRField sField = oReader.ReadValue<OGRField>();
+                if( !oReader.HasError() )
+                    poFeature->SetField(iField, &sField);
+                break;
+            }
+            case OFTIntegerList:
+            {
+                const int nCount = oReader.ReadValue<int>();
+                const GByte *pabyList =
+                    oReader.ReadBytes(sizeof(int) * std::max(0, nCount));
+                if( pabyList != nullptr )
+                {
+                    std::vector<int> anList(nCount);
+                    if( nCount > 0 )
+                        memcpy(&anList[0], pabyList, sizeof(int) * nCount);
+                    poFeature->SetField(iField, nCount, anList.data());
+                }
+                break;
+            }
+            case OFTInteger64List:
+            {
+                const int nCount = oReader.ReadValue<int>();
+                const GByte *pabyList =
+                    oReader.ReadBytes(sizeof(GIntBig) * std::max(0, nCount));
+                if( pabyList != nullptr )
+                {
+                    std::vector<GIntBig> anList(nCount);
+                    if( nCount > 0 )
+                        memcpy(&anList[0], pabyList,
+                               sizeof(GIntBig) * nCount);
+                    poFeature->SetField(iField, nCount, anList.data());
+                }
+                break;
+            }
+            case OFTRealList:
+            {
+                const int nCount = oReader.ReadValue<int>();
+                const GByte *pabyList =
+                    oReader.ReadBytes(sizeof(double) * std::max(0, nCount));
+                if( pabyList != nullptr )
+                {
+                    std::vector<double> adfList(nCount);
+                    if( nCount > 0 )
+                        memcpy(&adfList[0], pabyList,
+                               sizeof(double) * nCount);
+                    poFeature->SetField(iField, nCount, adfList.data());
+                }
+                break;
+            }
+            case OFTStringList:
+            {
+                const int nCount = oReader.ReadValue<int>();
+                std::vector<const char*> apszList;
+                for( int i = 0; i < nCount && !oReader.HasError(); i++ )
+                    apszList.push_back(oReader.ReadString());
+                apszList.push_back(nullptr);
+                if( !oReader.HasError() )
+                    poFeature->SetField(iField, apszList.data());
+                break;
+            }
+            case OFTBinary:
+            {
+                const int nCount = oReader.ReadValue<int>();
+                const GByte *pabyBinary =
+                    oReader.ReadBytes(std::max(0, nCount));
+                if( pabyBinary != nullptr )
+                    poFeature->SetField(iField, nCount,
+                                        const_cast<GByte *>(pabyBinary));
+                break;
+            }
+            default:
+            {
+                const char *pszValue = oReader.ReadString();
+                if( pszValue != nullptr )
+                    poFeature->SetField(iField, pszValue);
+                break;
+            }
+        }
+    }
+
+    const int nGeomFieldCount = poDefn->GetGeomFieldCount();
+    for( int iGeomField = 0;
+         iGeomField < nGeomFieldCount && !oReader.HasError();
+         iGeomField++ )
+    {
+        const GUInt32 nWkbSize = oReader.ReadValue<GUInt32>();
+        if( nWkbSize == 0 )
+            continue;
+        const GByte *pabyWkb = oReader.ReadBytes(nWkbSize);
+        if( pabyWkb == nullptr )
+            break;
+        OGRGeometry *poGeom = nullptr;
+        if( OGRGeometryFactory::createFromWkb(
+                pabyWkb,
+                poDefn->GetGeomFieldDefn(iGeomField)->GetSpatialRef(),
+                &poGeom, static_cast<int>(nWkbSize),
+                wkbVariantIso) == OGRERR_NONE )
+        {
+            poFeature->SetGeomFieldDirectly(iGeomField, poGeom);
+        }
+    }
+
+    const char *pszStyleString = oReader.ReadString();
+    const char *pszNativeData = oReader.ReadString();
+    const char *pszNativeMediaType = oReader.ReadString();
+    if( oReader.HasError() )
+    {
+        CPLError(CE_Failure, CPLE_AppDefined, "Corrupted serialized feature");
+        delete poFeature;
+        return nullptr;
+    }
+    poFeature->SetStyleString(pszStyleString);
+    poFeature->SetNativeData(pszNativeData);
+    poFeature->SetNativeMediaType(pszNativeMediaType);
+
+    return poFeature;
+}
+
+//! @endcond
@@ -63,6 +63,8 @@ public:
     GIntBig    *GetAllMatches( OGRField *psKey ) override;
     GIntBig    *GetAllMatches( OGRField *psKey, GIntBig* panFIDList, int* nFIDCount, int* nLength ) override;
 
+    int         GetKeyField( int ) override { return iField; }
+
     OGRErr      AddEntry( OGRField *psKey, GIntBig nFID ) override;
     OGRErr      RemoveEntry( OGRField *psKey, GIntBig nFID ) override;
 
@@ -108,6 +110,10 @@ public:
 
     OGRAttrIndex *GetFieldIndex( int iField ) override;
 
+    int         GetAttrIndexCount() override { return nIndexCount; }
+    OGRAttrIndex *GetAttrIndex( int i ) override
+        { return (i >= 0 && i < nIndexCount) ? papoIndexList[i] : nullptr; }
+
     /* custom to OGRMILayerAttrIndex */
     OGRErr      SaveConfigToXML();
     OGRErr      LoadConfigFromXML();
@@ -655,10 +661,13 @@ OGRErr OGRMILayerAttrIndex::RemoveFromIndex( OGRFeature * /*poFeature*/ )
 }
 
 /************************************************************************/
-/*                     OGRCreateDefaultLayerIndex()                     */
+/*                       OGRCreateMILayerIndex()                        */
+/*                                                                      */
+/*      Indexes in this format are no longer created by default, but    */
+/*      existing ones are still used.                                   */
 /************************************************************************/
 
-OGRLayerAttrIndex *OGRCreateDefaultLayerIndex()
+OGRLayerAttrIndex *OGRCreateMILayerIndex()
 
 {
     return new OGRMILayerAttrIndex();
@@ -232,6 +232,27 @@ OGRFeature* OGREditableLayer::Translate(OGRFeatureDefn* poTargetDefn,
     return poRet;
 }
 
+/************************************************************************/
+/*                        GetNextFeatureBatch()                         */
+/************************************************************************/
+
+int OGREditableLayer::GetNextFeatureBatch( OGRFeatureBatch* poBatch,
+                                           int nMaxRows )
+{
+    // Edited features must be merged: go through GetNextFeature().
+    return OGRLayer::GetNextFeatureBatch(poBatch, nMaxRows);
+}
+
+/************************************************************************/
+/*                          FillNextFeature()                           */
+/************************************************************************/
+
+int OGREditableLayer::FillNextFeature( OGRFeature* poFeature )
+{
+    // Edited features must be merged: go through GetNextFeature().
+    return OGRLayer::FillNextFeature(poFeature);
+}
+
 /************************************************************************/
 /*                           GetNextFeature()                           */
 /************************************************************************/
@@ -94,6 +94,9 @@ class CPL_DLL OGREditableLayer : public OGRLayerDecorator
 
     virtual void        ResetReading() override;
     virtual OGRFeature *GetNextFeature() override;
+    virtual int         GetNextFeatureBatch( OGRFeatureBatch* poBatch,
+                                             int nMaxRows ) override;
+    virtual int         FillNextFeature( OGRFeature* poFeature ) override;
     virtual OGRErr      SetNextByIndex( GIntBig nIndex ) override;
     virtual OGRFeature *GetFeature( GIntBig nFID ) override;
     virtual OGRErr      ISetFeature( OGRFeature *poFeature ) override;
@@ -64,6 +64,9 @@ class OGRLayerWithTransaction final: public OGRLayerDecorator
                                      int bApproxOK = TRUE ) override;
 
     virtual OGRFeature *GetNextFeature() override;
+    virtual int         GetNextFeatureBatch( OGRFeatureBatch* poBatch,
+                                             int nMaxRows ) override;
+    virtual int         FillNextFeature( OGRFeature* poFeature ) override;
     virtual OGRFeature *GetFeature( GIntBig nFID ) override;
     virtual OGRErr      ISetFeature( OGRFeature *poFeature ) override;
     virtual OGRErr      ICreateFeature( OGRFeature *poFeature ) override;
@@ -568,6 +571,19 @@ OGRFeature * OGRLayerWithTransaction::GetNextFeature()
     return poFeature;
 }
 
+int OGRLayerWithTransaction::GetNextFeatureBatch( OGRFeatureBatch* poBatch,
+                                                  int nMaxRows )
+{
+    // Features must be translated: go through GetNextFeature().
+    return OGRLayer::GetNextFeatureBatch(poBatch, nMaxRows);
+}
+
+int OGRLayerWithTransaction::FillNextFeature( OGRFeature* poFeature )
+{
+    // Features must be translated: go through GetNextFeature().
+    return OGRLayer::FillNextFeature(poFeature);
+}
+
 OGRFeature * OGRLayerWithTransaction::GetFeature( GIntBig nFID )
 {
     if( !m_poDecoratedLayer ) return nullptr;
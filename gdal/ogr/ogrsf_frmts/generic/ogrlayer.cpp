@@ -33,12 +33,234 @@
 #include "ogr_attrind.h"
 #include "swq.h"
 #include "ograpispy.h"
+#include "cpl_worker_thread_pool.h"
+
+#include <algorithm>
+#include <climits>
+#include <cmath>
+#include <functional>
+#include <memory>
+#include <utility>
+#include <vector>
 
 CPL_CVSID("$Id$")
 
+/************************************************************************/
+/*                        OGRPointInPolygonIndex                        */
+/*                                                                      */
+/*      Edges of the rings of a polygonal filter geometry, bucketed     */
+/*      in horizontal bands, so that the test of a point against the    */
+/*      filter only looks at the few edges of one band, without         */
+/*      converting anything to GEOS.                                    */
+/************************************************************************/
+
+class OGRPointInPolygonIndex
+{
+    CPL_DISALLOW_COPY_ASSIGN(OGRPointInPolygonIndex)
+
+    struct Edge
+    {
+        double x1;
+        double y1;
+        double x2;
+        double y2;
+    };
+
+    std::vector<Edge>   m_asEdges{};
+    // Edges of band i are m_anBandEdges[m_anBandStart[i]] to
+    // m_anBandEdges[m_anBandStart[i+1]-1].
+    std::vector<int>    m_anBandStart{};
+    std::vector<int>    m_anBandEdges{};
+    double              m_dfMinY = 0;
+    double              m_dfMaxY = 0;
+    double              m_dfBandHeight = 0;
+    int                 m_nBands = 0;
+
+    int         GetBand( double y ) const;
+    void        AddRing( const OGRLinearRing *poRing );
+
+  public:
+    OGRPointInPolygonIndex() = default;
+
+    static OGRPointInPolygonIndex *Create( const OGRGeometry *poGeom );
+
+    bool        Intersects( double x, double y ) const;
+};
+
+/************************************************************************/
+/*                              GetBand()                               */
+/************************************************************************/
+
+int OGRPointInPolygonIndex::GetBand( double y ) const
+{
+    if( m_dfBandHeight <= 0 || y <= m_dfMinY )
+        return 0;
+    const double dfBand = (y - m_dfMinY) / m_dfBandHeight;
+    if( dfBand >= m_nBands - 1 )
+        return m_nBands - 1;
+    return static_cast<int>(dfBand);
+}
+
+/************************************************************************/
+/*                              AddRing()                               */
+/************************************************************************/
+
+void OGRPointInPolygonIndex::AddRing( const OGRLinearRing *poRing )
+{
+    const int nPoints = poRing->getNumPoints();
+    if( nPoints < 2 )
+        return;
+    for( int i = 0; i < nPoints; i++ )
+    {
+        // Close the ring if needed.
+        const int iNext = (i + 1 < nPoints) ? i + 1 : 0;
+        if( iNext == 0 &&
+            poRing->getX(0) == poRing->getX(nPoints - 1) &&
+            poRing->getY(0) == poRing->getY(nPoints - 1) )
+            break;
+        Edge sEdge;
+        sEdge.x1 = poRing->getX(i);
+        sEdge.y1 = poRing->getY(i);
+        sEdge.x2 = poRing->getX(iNext);
+        sEdge.y2 = poRing->getY(iNext);
+        m_asEdges.push_back(sEdge);
+    }
+}
+
+/************************************************************************/
+/*                               Create()                               */
+/*                                                                      */
+/*      Return NULL if the geometry is not a polygon or a multipolygon  */
+/*      with linear rings.                                              */
+/************************************************************************/
+
+OGRPointInPolygonIndex *OGRPointInPolygonIndex::Create(
+                                                const OGRGeometry *poGeom )
+{
+    std::vector<const OGRPolygon *> apoPolygons;
+    const OGRwkbGeometryType eType = wkbFlatten(poGeom->getGeometryType());
+    if( eType == wkbPolygon )
+    {
+        apoPolygons.push_back(poGeom->toPolygon());
+    }
+    else if( eType == wkbMultiPolygon )
+    {
+        for( const auto *poPoly: *(poGeom->toMultiPolygon()) )
+            apoPolygons.push_back(poPoly);
+    }
+    else
+    {
+        return nullptr;
+    }
+
+    std::unique_ptr<OGRPointInPolygonIndex> poIndex(
+                                            new OGRPointInPolygonIndex());
+    for( const OGRPolygon *poPoly: apoPolygons )
+    {
+        for( const OGRLinearRing *poRing: *poPoly )
+            poIndex->AddRing(poRing);
+    }
+    if( poIndex->m_asEdges.empty() ||
+        poIndex->m_asEdges.size() > static_cast<size_t>(INT_MAX) )
+        return nullptr;
+
+    OGREnvelope sEnvelope;
+    poGeom->getEnvelope(&sEnvelope);
+    const int nEdges = static_cast<int>(poIndex->m_asEdges.size());
+    poIndex->m_dfMinY = sEnvelope.MinY;
+    poIndex->m_dfMaxY = sEnvelope.MaxY;
+    // About 4 edges per band for a regularly shaped polygon.
+    poIndex->m_nBands = std::max(1, std::min(nEdges / 4, 65536));
+    poIndex->m_dfBandHeight =
+        (sEnvelope.MaxY - sEnvelope.MinY) / poIndex->m_nBands;
+
+    // Count the edges of each band, then fill them.
+    // Edges spanning many bands, as in polygons made of long edges with
+    // a dense part elsewhere, make the index quadratic in size and no
+    // faster than the prepared geometry, which is then used instead.
+    const size_t nMaxBandEntries =
+        std::min(8 * static_cast<size_t>(nEdges),
+                 static_cast<size_t>(INT_MAX));
+    poIndex->m_anBandStart.resize(poIndex->m_nBands + 1);
+    size_t nBandEntries = 0;
+    for( const Edge &sEdge: poIndex->m_asEdges )
+    {
+        const int iFirst = poIndex->GetBand(std::min(sEdge.y1, sEdge.y2));
+        const int iLast = poIndex->GetBand(std::max(sEdge.y1, sEdge.y2));
+        nBandEntries += static_cast<size_t>(iLast - iFirst + 1);
+        if( nBandEntries > nMaxBandEntries )
+            return nullptr;
+        for( int iBand = iFirst; iBand <= iLast; iBand++ )
+            poIndex->m_anBandStart[iBand + 1]++;
+    }
+    for( int iBand = 0; iBand < poIndex->m_nBands; iBand++ )
+        poIndex->m_anBandStart[iBand + 1] += poIndex->m_anBandStart[iBand];
+    poIndex->m_anBandEdges.resize(poIndex->m_anBandStart.back());
+    std::vector<int> anFill(poIndex->m_anBandStart.begin(),
+                            poIndex->m_anBandStart.end() - 1);
+    for( int iEdge = 0; iEdge < nEdges; iEdge++ )
+    {
+        const Edge &sEdge = poIndex->m_asEdges[iEdge];
+        const int iFirst = poIndex->GetBand(std::min(sEdge.y1, sEdge.y2));
+        const int iLast = poIndex->GetBand(std::max(sEdge.y1, sEdge.y2));
+        for( int iBand = iFirst; iBand <= iLast; iBand++ )
+            poIndex->m_anBandEdges[anFill[iBand]++] = iEdge;
+    }
+
+    return poIndex.release();
+}
+
+/************************************************************************/
+/*                             Intersects()                             */
+/*                                                                      */
+/*      Test if a point is in the interior or on the boundary of the    */
+/*      polygon(s), using the even-odd crossing rule.                   */
+/************************************************************************/
+
+bool OGRPointInPolygonIndex::Intersects( double x, double y ) const
+{
+    if( y < m_dfMinY || y > m_dfMaxY )
+        return false;
+
+    const int iBand = GetBand(y);
+    bool bInside = false;
+    for( int i = m_anBandStart[iBand]; i < m_anBandStart[iBand + 1]; i++ )
+    {
+        const Edge &sEdge = m_asEdges[m_anBandEdges[i]];
+
+        // Point on the boundary.
+        if( x >= std::min(sEdge.x1, sEdge.x2) &&
+            x <= std::max(sEdge.x1, sEdge.x2) &&
+            y >= std::min(sEdge.y1, sEdge.y2) &&
+            y <= std::max(sEdge.y1, sEdge.y2) &&
+            (sEdge.x2 - sEdge.x1) * (y - sEdge.y1) ==
+                (sEdge.y2 - sEdge.y1) * (x - sEdge.x1) )
+        {
+            return true;
+        }
+
+        if( (sEdge.y1 > y) != (sEdge.y2 > y) )
+        {
+            const double dfXCross = sEdge.x1 + (y - sEdge.y1) *
+                (sEdge.x2 - sEdge.x1) / (sEdge.y2 - sEdge.y1);
+            if( x < dfXCross )
+                bInside = !bInside;
+        }
+    }
+    return bInside;
+}
+
+/************************************************************************/
+/*                          OGRLayer::Private                           */
+/************************************************************************/
+
 struct OGRLayer::Private
 {
     bool         m_bInFeatureIterator = false;
+
+    // Point in polygon index of m_poFilterGeom, built on first use.
+    bool         m_bFilterPIPIndexBuilt = false;
+    std::unique_ptr<OGRPointInPolygonIndex> m_poFilterPIPIndex{};
 };
 
 /************************************************************************/
@@ -552,6 +774,83 @@ OGRFeatureH OGR_L_GetNextFeature( OGRLayerH hLayer )
                 OGRLayer::FromHandle(hLayer)->GetNextFeature());
 }
 
+/************************************************************************/
+/*                        GetNextFeatureBatch()                         */
+/************************************************************************/
+
+int OGRLayer::GetNextFeatureBatch( OGRFeatureBatch* poBatch, int nMaxRows )
+
+{
+    poBatch->Reset();
+    if( poBatch->GetDefn() != GetLayerDefn() )
+    {
+        CPLError(CE_Failure, CPLE_AppDefined,
+                 "Feature batch not created from the layer definition");
+        return 0;
+    }
+
+    while( poBatch->GetRowCount() < nMaxRows )
+    {
+        OGRFeature* poFeature = GetNextFeature();
+        if( poFeature == nullptr )
+            break;
+        poBatch->AddFeature(poFeature);
+        delete poFeature;
+    }
+    return poBatch->GetRowCount();
+}
+
+/************************************************************************/
+/*                     OGR_L_GetNextFeatureBatch()                      */
+/************************************************************************/
+
+int OGR_L_GetNextFeatureBatch( OGRLayerH hLayer, OGRFeatureBatchH hBatch,
+                               int nMaxRows )
+
+{
+    VALIDATE_POINTER1( hLayer, "OGR_L_GetNextFeatureBatch", 0 );
+    VALIDATE_POINTER1( hBatch, "OGR_L_GetNextFeatureBatch", 0 );
+
+    return OGRLayer::FromHandle(hLayer)->GetNextFeatureBatch(
+        reinterpret_cast<OGRFeatureBatch*>(hBatch), nMaxRows);
+}
+
+/************************************************************************/
+/*                          FillNextFeature()                           */
+/************************************************************************/
+
+int OGRLayer::FillNextFeature( OGRFeature* poFeature )
+
+{
+    if( poFeature->GetDefnRef() != GetLayerDefn() )
+    {
+        CPLError(CE_Failure, CPLE_AppDefined,
+                 "Feature not created from the layer definition");
+        return FALSE;
+    }
+
+    OGRFeature* poNextFeature = GetNextFeature();
+    if( poNextFeature == nullptr )
+        return FALSE;
+    poFeature->SwapContent(poNextFeature);
+    delete poNextFeature;
+    return TRUE;
+}
+
+/************************************************************************/
+/*                       OGR_L_FillNextFeature()                        */
+/************************************************************************/
+
+int OGR_L_FillNextFeature( OGRLayerH hLayer, OGRFeatureH hFeat )
+
+{
+    VALIDATE_POINTER1( hLayer, "OGR_L_FillNextFeature", FALSE );
+    VALIDATE_POINTER1( hFeat, "OGR_L_FillNextFeature", FALSE );
+
+    return OGRLayer::FromHandle(hLayer)->FillNextFeature(
+        OGRFeature::FromHandle(hFeat));
+}
+
 /************************************************************************/
 /*                       ConvertGeomsIfNecessary()                      */
 /************************************************************************/
@@ -1254,117 +1553,67 @@ void OGR_L_SetSpatialFilterRectEx( OGRLayerH hLayer,
 }
 
 /************************************************************************/
-/*                           InstallFilter()                            */
-/*                                                                      */
-/*      This method is only intended to be used from within             */
-/*      drivers, normally from the SetSpatialFilter() method.           */
-/*      It installs a filter, and also tests it to see if it is         */
-/*      rectangular.  If so, it this is kept track of alongside the     */
-/*      filter geometry itself so we can do cheaper comparisons in      */
-/*      the FilterGeometry() call.                                      */
+/*                       OGRGeometryIsRectangle()                       */
 /*                                                                      */
-/*      Returns TRUE if the newly installed filter differs in some      */
-/*      way from the current one.                                       */
+/*      Test if a geometry is a polygon that is its own envelope.       */
 /************************************************************************/
 
-//! @cond Doxygen_Suppress
-int OGRLayer::InstallFilter( OGRGeometry * poFilter )
-
+static int OGRGeometryIsRectangle( const OGRGeometry *poGeom )
 {
-    if( m_poFilterGeom == poFilter )
+    if( wkbFlatten(poGeom->getGeometryType()) != wkbPolygon )
         return FALSE;
 
-/* -------------------------------------------------------------------- */
-/*      Replace the existing filter.                                    */
-/* -------------------------------------------------------------------- */
-    if( m_poFilterGeom != nullptr )
-    {
-        delete m_poFilterGeom;
-        m_poFilterGeom = nullptr;
-    }
-
-    if( m_pPreparedFilterGeom != nullptr )
-    {
-        OGRDestroyPreparedGeometry(m_pPreparedFilterGeom);
-        m_pPreparedFilterGeom = nullptr;
-    }
-
-    if( poFilter != nullptr )
-        m_poFilterGeom = poFilter->clone();
-
-    m_bFilterIsEnvelope = FALSE;
-
-    if( m_poFilterGeom == nullptr )
-        return TRUE;
-
-    if( m_poFilterGeom != nullptr )
-        m_poFilterGeom->getEnvelope( &m_sFilterEnvelope );
-
-    /* Compile geometry filter as a prepared geometry */
-    m_pPreparedFilterGeom = OGRCreatePreparedGeometry(m_poFilterGeom);
-
-/* -------------------------------------------------------------------- */
-/*      Now try to determine if the filter is really a rectangle.       */
-/* -------------------------------------------------------------------- */
-    if( wkbFlatten(m_poFilterGeom->getGeometryType()) != wkbPolygon )
-        return TRUE;
-
-    OGRPolygon *poPoly = m_poFilterGeom->toPolygon();
+    const OGRPolygon *poPoly = poGeom->toPolygon();
 
     if( poPoly->getNumInteriorRings() != 0 )
-        return TRUE;
+        return FALSE;
 
-    OGRLinearRing *poRing = poPoly->getExteriorRing();
+    const OGRLinearRing *poRing = poPoly->getExteriorRing();
     if (poRing == nullptr)
-        return TRUE;
+        return FALSE;
 
     if( poRing->getNumPoints() > 5 || poRing->getNumPoints() < 4 )
-        return TRUE;
+        return FALSE;
 
     // If the ring has 5 points, the last should be the first.
     if( poRing->getNumPoints() == 5
         && ( poRing->getX(0) != poRing->getX(4)
              || poRing->getY(0) != poRing->getY(4) ) )
-        return TRUE;
+        return FALSE;
 
     // Polygon with first segment in "y" direction.
     if( poRing->getX(0) == poRing->getX(1)
         && poRing->getY(1) == poRing->getY(2)
         && poRing->getX(2) == poRing->getX(3)
         && poRing->getY(3) == poRing->getY(0) )
-        m_bFilterIsEnvelope = TRUE;
+        return TRUE;
 
     // Polygon with first segment in "x" direction.
     if( poRing->getY(0) == poRing->getY(1)
         && poRing->getX(1) == poRing->getX(2)
         && poRing->getY(2) == poRing->getY(3)
         && poRing->getX(3) == poRing->getX(0) )
-        m_bFilterIsEnvelope = TRUE;
+        return TRUE;
 
-    return TRUE;
+    return FALSE;
 }
-//! @endcond
 
 /************************************************************************/
-/*                           FilterGeometry()                           */
+/*                          OGRFilterGeometry()                         */
 /*                                                                      */
-/*      Compare the passed in geometry to the currently installed       */
-/*      filter.  Optimize for case where filter is just an              */
-/*      envelope.                                                       */
-/************************************************************************/
-
-//! @cond Doxygen_Suppress
-int OGRLayer::FilterGeometry( OGRGeometry *poGeometry )
-
+/*      Compare a geometry to a filter geometry.  Optimize for case     */
+/*      where filter is just an envelope, or a polygon for which a      */
+/*      point in polygon index is available.  The prepared filter       */
+/*      geometry and the point in polygon index may be NULL.            */
+/************************************************************************/
+
+static int OGRFilterGeometry( const OGRGeometry *poFilterGeom,
+                              const OGREnvelope& sFilterEnvelope,
+                              int bFilterIsEnvelope,
+                              const OGRPreparedGeometry *pPreparedFilterGeom,
+                              const OGRPointInPolygonIndex *poPIPIndex,
+                              const OGRGeometry *poGeometry )
 {
-/* -------------------------------------------------------------------- */
-/*      In trivial cases of new filter or target geometry, we accept    */
-/*      an intersection.  No geometry is taken to mean "the whole       */
-/*      world".                                                         */
-/* -------------------------------------------------------------------- */
-    if( m_poFilterGeom == nullptr )
-        return TRUE;
-
     if( poGeometry == nullptr || poGeometry->IsEmpty() )
         return FALSE;
 
@@ -1377,10 +1626,10 @@ int OGRLayer::FilterGeometry( OGRGeometry *poGeometry )
 
     poGeometry->getEnvelope( &sGeomEnv );
 
-    if( sGeomEnv.MaxX < m_sFilterEnvelope.MinX
-        || sGeomEnv.MaxY < m_sFilterEnvelope.MinY
-        || m_sFilterEnvelope.MaxX < sGeomEnv.MinX
-        || m_sFilterEnvelope.MaxY < sGeomEnv.MinY )
+    if( sGeomEnv.MaxX < sFilterEnvelope.MinX
+        || sGeomEnv.MaxY < sFilterEnvelope.MinY
+        || sFilterEnvelope.MaxX < sGeomEnv.MinX
+        || sFilterEnvelope.MaxY < sGeomEnv.MinY )
         return FALSE;
 
 /* -------------------------------------------------------------------- */
@@ -1388,11 +1637,11 @@ int OGRLayer::FilterGeometry( OGRGeometry *poGeometry )
 /*      envelope of the geometry is inside the filter geometry,         */
 /*      the geometry itself is inside the filter geometry               */
 /* -------------------------------------------------------------------- */
-    if( m_bFilterIsEnvelope &&
-        sGeomEnv.MinX >= m_sFilterEnvelope.MinX &&
-        sGeomEnv.MinY >= m_sFilterEnvelope.MinY &&
-        sGeomEnv.MaxX <= m_sFilterEnvelope.MaxX &&
-        sGeomEnv.MaxY <= m_sFilterEnvelope.MaxY)
+    if( bFilterIsEnvelope &&
+        sGeomEnv.MinX >= sFilterEnvelope.MinX &&
+        sGeomEnv.MinY >= sFilterEnvelope.MinY &&
+        sGeomEnv.MaxX <= sFilterEnvelope.MaxX &&
+        sGeomEnv.MaxY <= sFilterEnvelope.MaxY)
     {
         return TRUE;
     }
@@ -1404,16 +1653,16 @@ int OGRLayer::FilterGeometry( OGRGeometry *poGeometry )
 /*      point inside the filter geometry, the geometry itself is inside */
 /*      the filter geometry.                                            */
 /* -------------------------------------------------------------------- */
-        if( m_bFilterIsEnvelope )
+        if( bFilterIsEnvelope )
         {
-            OGRLineString* poLS = nullptr;
+            const OGRLineString* poLS = nullptr;
 
             switch( wkbFlatten(poGeometry->getGeometryType()) )
             {
                 case wkbPolygon:
                 {
-                    OGRPolygon* poPoly = poGeometry->toPolygon();
-                    OGRLinearRing* poRing = poPoly->getExteriorRing();
+                    const OGRPolygon* poPoly = poGeometry->toPolygon();
+                    const OGRLinearRing* poRing = poPoly->getExteriorRing();
                     if (poRing != nullptr && poPoly->getNumInteriorRings() == 0)
                     {
                         poLS = poRing;
@@ -1436,10 +1685,10 @@ int OGRLayer::FilterGeometry( OGRGeometry *poGeometry )
                 {
                     double x = poLS->getX(i);
                     double y = poLS->getY(i);
-                    if (x >= m_sFilterEnvelope.MinX &&
-                        y >= m_sFilterEnvelope.MinY &&
-                        x <= m_sFilterEnvelope.MaxX &&
-                        y <= m_sFilterEnvelope.MaxY)
+                    if (x >= sFilterEnvelope.MinX &&
+                        y >= sFilterEnvelope.MinY &&
+                        x <= sFilterEnvelope.MaxX &&
+                        y <= sFilterEnvelope.MaxY)
                     {
                         return TRUE;
                     }
@@ -1447,6 +1696,58 @@ int OGRLayer::FilterGeometry( OGRGeometry *poGeometry )
             }
         }
 
+/* -------------------------------------------------------------------- */
+/*      With a polygonal filter, points are tested against the point    */
+/*      in polygon index.  For lines and polygons, a vertex in the      */
+/*      filter is enough to know that they intersect it.                */
+/* -------------------------------------------------------------------- */
+        if( poPIPIndex != nullptr )
+        {
+            switch( wkbFlatten(poGeometry->getGeometryType()) )
+            {
+                case wkbPoint:
+                {
+                    const OGRPoint* poPoint = poGeometry->toPoint();
+                    return poPIPIndex->Intersects(poPoint->getX(),
+                                                  poPoint->getY());
+                }
+
+                case wkbMultiPoint:
+                {
+                    for( const auto* poPoint: *(poGeometry->toMultiPoint()) )
+                    {
+                        if( !poPoint->IsEmpty() &&
+                            poPIPIndex->Intersects(poPoint->getX(),
+                                                   poPoint->getY()) )
+                            return TRUE;
+                    }
+                    return FALSE;
+                }
+
+                case wkbLineString:
+                {
+                    const OGRLineString* poLS = poGeometry->toLineString();
+                    if( poPIPIndex->Intersects(poLS->getX(0), poLS->getY(0)) )
+                        return TRUE;
+                    break;
+                }
+
+                case wkbPolygon:
+                {
+                    const OGRLinearRing* poRing =
+                        poGeometry->toPolygon()->getExteriorRing();
+                    if( poRing != nullptr && poRing->getNumPoints() > 0 &&
+                        poPIPIndex->Intersects(poRing->getX(0),
+                                               poRing->getY(0)) )
+                        return TRUE;
+                    break;
+                }
+
+                default:
+                    break;
+            }
+        }
+
 /* -------------------------------------------------------------------- */
 /*      Fallback to full intersect test (using GEOS) if we still        */
 /*      don't know for sure.                                            */
@@ -1454,16 +1755,111 @@ int OGRLayer::FilterGeometry( OGRGeometry *poGeometry )
         if( OGRGeometryFactory::haveGEOS() )
         {
             //CPLDebug("OGRLayer", "GEOS intersection");
-            if( m_pPreparedFilterGeom != nullptr )
-                return OGRPreparedGeometryIntersects(m_pPreparedFilterGeom,
+            if( pPreparedFilterGeom != nullptr )
+                return OGRPreparedGeometryIntersects(pPreparedFilterGeom,
                                                      poGeometry);
             else
-                return m_poFilterGeom->Intersects( poGeometry );
+                return poFilterGeom->Intersects( poGeometry );
         }
         else
             return TRUE;
     }
 }
+
+/************************************************************************/
+/*                           InstallFilter()                            */
+/*                                                                      */
+/*      This method is only intended to be used from within             */
+/*      drivers, normally from the SetSpatialFilter() method.           */
+/*      It installs a filter, and also tests it to see if it is         */
+/*      rectangular.  If so, it this is kept track of alongside the     */
+/*      filter geometry itself so we can do cheaper comparisons in      */
+/*      the FilterGeometry() call.                                      */
+/*                                                                      */
+/*      Returns TRUE if the newly installed filter differs in some      */
+/*      way from the current one.                                       */
+/************************************************************************/
+
+//! @cond Doxygen_Suppress
+int OGRLayer::InstallFilter( OGRGeometry * poFilter )
+
+{
+    if( m_poFilterGeom == poFilter )
+        return FALSE;
+
+/* -------------------------------------------------------------------- */
+/*      Replace the existing filter.                                    */
+/* -------------------------------------------------------------------- */
+    if( m_poFilterGeom != nullptr )
+    {
+        delete m_poFilterGeom;
+        m_poFilterGeom = nullptr;
+    }
+
+    if( m_pPreparedFilterGeom != nullptr )
+    {
+        OGRDestroyPreparedGeometry(m_pPreparedFilterGeom);
+        m_pPreparedFilterGeom = nullptr;
+    }
+
+    m_poPrivate->m_poFilterPIPIndex.reset();
+    m_poPrivate->m_bFilterPIPIndexBuilt = false;
+
+    if( poFilter != nullptr )
+        m_poFilterGeom = poFilter->clone();
+
+    m_bFilterIsEnvelope = FALSE;
+
+    if( m_poFilterGeom == nullptr )
+        return TRUE;
+
+    if( m_poFilterGeom != nullptr )
+        m_poFilterGeom->getEnvelope( &m_sFilterEnvelope );
+
+    /* Compile geometry filter as a prepared geometry */
+    m_pPreparedFilterGeom = OGRCreatePreparedGeometry(m_poFilterGeom);
+
+/* -------------------------------------------------------------------- */
+/*      Now try to determine if the filter is really a rectangle.       */
+/* -------------------------------------------------------------------- */
+    m_bFilterIsEnvelope = OGRGeometryIsRectangle(m_poFilterGeom);
+
+    return TRUE;
+}
+//! @endcond
+
+/************************************************************************/
+/*                           FilterGeometry()                           */
+/*                                                                      */
+/*      Compare the passed in geometry to the currently installed       */
+/*      filter.  Optimize for case where filter is just an              */
+/*      envelope.                                                       */
+/************************************************************************/
+
+//! @cond Doxygen_Suppress
+int OGRLayer::FilterGeometry( OGRGeometry *poGeometry )
+
+{
+/* -------------------------------------------------------------------- */
+/*      In trivial cases of new filter or target geometry, we accept    */
+/*      an intersection.  No geometry is taken to mean "the whole       */
+/*      world".                                                         */
+/* -------------------------------------------------------------------- */
+    if( m_poFilterGeom == nullptr )
+        return TRUE;
+
+    if( !m_bFilterIsEnvelope && !m_poPrivate->m_bFilterPIPIndexBuilt )
+    {
+        m_poPrivate->m_bFilterPIPIndexBuilt = true;
+        m_poPrivate->m_poFilterPIPIndex.reset(
+            OGRPointInPolygonIndex::Create(m_poFilterGeom));
+    }
+
+    return OGRFilterGeometry( m_poFilterGeom, m_sFilterEnvelope,
+                              m_bFilterIsEnvelope, m_pPreparedFilterGeom,
+                              m_poPrivate->m_poFilterPIPIndex.get(),
+                              poGeometry );
+}
 //! @endcond
 
 /************************************************************************/
@@ -1500,7 +1896,18 @@ OGRErr OGRLayer::InitializeIndexSupport( const char *pszFilename )
     if (m_poAttrIndex != nullptr)
         return OGRERR_NONE;
 
-    m_poAttrIndex = OGRCreateDefaultLayerIndex();
+    // The MITAB driver passes the description of the native .ind indexes
+    // of a .tab file as a XML string, that only the MapInfo index handles.
+    // Otherwise keep on using the indexes in the legacy MapInfo format if
+    // there are some, and no index in the current format.
+    VSIStatBufL sStat;
+    if( STARTS_WITH_CI(pszFilename, "<OGRMILayerAttrIndex>") )
+        m_poAttrIndex = OGRCreateMILayerIndex();
+    else if( VSIStatL( CPLResetExtension( pszFilename, "idm" ), &sStat ) == 0 &&
+             VSIStatL( CPLResetExtension( pszFilename, "oai" ), &sStat ) != 0 )
+        m_poAttrIndex = OGRCreateMILayerIndex();
+    else
+        m_poAttrIndex = OGRCreateDefaultLayerIndex();
 
     eErr = m_poAttrIndex->Initialize( pszFilename, this );
     if( eErr != OGRERR_NONE )
@@ -1934,48 +2341,577 @@ OGRErr set_result_schema(OGRLayer *pLayerResult,
                     ret = OGRERR_NONE;
                 }
             }
-            if( mapInput )
-                mapInput[iField] = iField;
+            if( mapInput )
+                mapInput[iField] = iField;
+        }
+        if (!combined) return ret;
+        if (!mapMethod) return ret;
+        if (!poDefnMethod) return ret;
+        for( int iField = 0; iField < poDefnMethod->GetFieldCount(); iField++ ) {
+            OGRFieldDefn oFieldDefn(poDefnMethod->GetFieldDefn(iField));
+            if( pszMethodPrefix != nullptr )
+                oFieldDefn.SetName(CPLSPrintf("%s%s", pszMethodPrefix, oFieldDefn.GetNameRef()));
+            ret = pLayerResult->CreateField(&oFieldDefn);
+            if (ret != OGRERR_NONE) {
+                if (!bSkipFailures)
+                    return ret;
+                else {
+                    CPLErrorReset();
+                    ret = OGRERR_NONE;
+                }
+            }
+            mapMethod[iField] = nFieldsInput+iField;
+        }
+    }
+    return ret;
+}
+
+/************************************************************************/
+/*                        OGRLayerOverlayIndex                          */
+/*                                                                      */
+/*      In memory copy of the features of a layer, honouring its        */
+/*      current attribute and spatial filters, with a packed            */
+/*      sort-tile-recursive R-tree on the envelopes of their            */
+/*      geometries.  The overlay methods load the method layer once     */
+/*      into it instead of installing a new spatial filter on the       */
+/*      method layer for each input feature.                            */
+/************************************************************************/
+
+class OGRLayerOverlayIndex
+{
+    CPL_DISALLOW_COPY_ASSIGN(OGRLayerOverlayIndex)
+
+    struct Node
+    {
+        OGREnvelope sEnvelope{};
+        size_t      nFirstChild = 0;
+        size_t      nChildCount = 0;
+    };
+
+    static const size_t NODE_CAPACITY;
+
+    std::vector<OGRFeatureUniquePtr> m_apoFeatures{};
+    std::vector<OGREnvelope>         m_asEnvelopes{};
+    // Indices in m_apoFeatures of the features with a non empty geometry,
+    // in the order of the leaf nodes.
+    std::vector<size_t>              m_anItems{};
+    // m_aaoLevels[0] are the leaf nodes, whose children are in m_anItems.
+    // The children of the nodes of level i > 0 are in m_aaoLevels[i-1].
+    std::vector<std::vector<Node>>   m_aaoLevels{};
+
+    static void SortTileRecursive( std::vector<size_t>& anIndices,
+                                   const std::vector<OGREnvelope>& asEnvelopes );
+    static std::vector<Node> Pack( const std::vector<size_t>& anIndices,
+                                   const std::vector<OGREnvelope>& asEnvelopes );
+
+  public:
+    OGRLayerOverlayIndex() = default;
+
+    void         Load( OGRLayer *poLayer );
+
+    size_t       GetFeatureCount() const { return m_apoFeatures.size(); }
+    OGRFeature  *GetFeature( size_t i ) const { return m_apoFeatures[i].get(); }
+    bool         GetExtent( OGREnvelope *psExtent ) const;
+
+    void         Select( const OGRGeometry *poFilterGeom,
+                         std::vector<OGRFeature*>& apoSelected ) const;
+};
+
+const size_t OGRLayerOverlayIndex::NODE_CAPACITY = 16;
+
+/************************************************************************/
+/*                         SortTileRecursive()                          */
+/*                                                                      */
+/*      Order the entries so that consecutive runs of NODE_CAPACITY     */
+/*      of them are spatially close: sort by X of the envelope center,  */
+/*      cut in vertical slices, and sort each slice by Y.               */
+/************************************************************************/
+
+void OGRLayerOverlayIndex::SortTileRecursive(
+                            std::vector<size_t>& anIndices,
+                            const std::vector<OGREnvelope>& asEnvelopes )
+{
+    const size_t nCount = anIndices.size();
+    const size_t nNodes = (nCount + NODE_CAPACITY - 1) / NODE_CAPACITY;
+    const size_t nSlices = static_cast<size_t>(
+        std::ceil(std::sqrt(static_cast<double>(nNodes))));
+    const size_t nSliceSize = std::max(static_cast<size_t>(1), nSlices) *
+                              NODE_CAPACITY;
+
+    std::stable_sort(anIndices.begin(), anIndices.end(),
+        [&asEnvelopes](size_t a, size_t b)
+        {
+            return asEnvelopes[a].MinX + asEnvelopes[a].MaxX <
+                   asEnvelopes[b].MinX + asEnvelopes[b].MaxX;
+        });
+    for( size_t i = 0; i < nCount; i += nSliceSize )
+    {
+        std::stable_sort(anIndices.begin() + i,
+                         anIndices.begin() + std::min(nCount, i + nSliceSize),
+            [&asEnvelopes](size_t a, size_t b)
+            {
+                return asEnvelopes[a].MinY + asEnvelopes[a].MaxY <
+                       asEnvelopes[b].MinY + asEnvelopes[b].MaxY;
+            });
+    }
+}
+
+/************************************************************************/
+/*                                Pack()                                */
+/*                                                                      */
+/*      Group consecutive entries into nodes of NODE_CAPACITY.          */
+/************************************************************************/
+
+std::vector<OGRLayerOverlayIndex::Node> OGRLayerOverlayIndex::Pack(
+                            const std::vector<size_t>& anIndices,
+                            const std::vector<OGREnvelope>& asEnvelopes )
+{
+    std::vector<Node> aoNodes;
+    aoNodes.reserve((anIndices.size() + NODE_CAPACITY - 1) / NODE_CAPACITY);
+    for( size_t i = 0; i < anIndices.size(); i += NODE_CAPACITY )
+    {
+        Node oNode;
+        oNode.nFirstChild = i;
+        oNode.nChildCount = std::min(NODE_CAPACITY, anIndices.size() - i);
+        for( size_t j = i; j < i + oNode.nChildCount; j++ )
+            oNode.sEnvelope.Merge(asEnvelopes[anIndices[j]]);
+        aoNodes.push_back(oNode);
+    }
+    return aoNodes;
+}
+
+/************************************************************************/
+/*                                Load()                                */
+/************************************************************************/
+
+void OGRLayerOverlayIndex::Load( OGRLayer *poLayer )
+{
+    poLayer->ResetReading();
+    OGRFeature *poFeature = nullptr;
+    while( (poFeature = poLayer->GetNextFeature()) != nullptr )
+    {
+        OGREnvelope sEnvelope;
+        OGRGeometry *poGeom = poFeature->GetGeometryRef();
+        if( poGeom != nullptr && !poGeom->IsEmpty() )
+        {
+            poGeom->getEnvelope(&sEnvelope);
+            m_anItems.push_back(m_apoFeatures.size());
+        }
+        m_apoFeatures.emplace_back(poFeature);
+        m_asEnvelopes.push_back(sEnvelope);
+    }
+    poLayer->ResetReading();
+
+    if( m_anItems.empty() )
+        return;
+
+    SortTileRecursive(m_anItems, m_asEnvelopes);
+    m_aaoLevels.push_back(Pack(m_anItems, m_asEnvelopes));
+
+    // Build the upper levels, reordering the nodes of each level so that
+    // the children of a node are contiguous.
+    while( m_aaoLevels.back().size() > 1 )
+    {
+        std::vector<Node>& aoChildren = m_aaoLevels.back();
+        std::vector<OGREnvelope> asChildEnvelopes;
+        std::vector<size_t> anOrder;
+        for( size_t i = 0; i < aoChildren.size(); i++ )
+        {
+            asChildEnvelopes.push_back(aoChildren[i].sEnvelope);
+            anOrder.push_back(i);
+        }
+        SortTileRecursive(anOrder, asChildEnvelopes);
+
+        std::vector<Node> aoSorted;
+        std::vector<OGREnvelope> asSortedEnvelopes;
+        for( size_t i = 0; i < anOrder.size(); i++ )
+        {
+            aoSorted.push_back(aoChildren[anOrder[i]]);
+            asSortedEnvelopes.push_back(aoSorted.back().sEnvelope);
+            anOrder[i] = i;
+        }
+        aoChildren.swap(aoSorted);
+        asChildEnvelopes.swap(asSortedEnvelopes);
+
+        std::vector<Node> aoParents = Pack(anOrder, asChildEnvelopes);
+        m_aaoLevels.push_back(aoParents);
+    }
+}
+
+/************************************************************************/
+/*                             GetExtent()                              */
+/************************************************************************/
+
+bool OGRLayerOverlayIndex::GetExtent( OGREnvelope *psExtent ) const
+{
+    if( m_aaoLevels.empty() )
+        return false;
+    const OGREnvelope& sEnvelope = m_aaoLevels.back()[0].sEnvelope;
+    psExtent->MinX = sEnvelope.MinX;
+    psExtent->MinY = sEnvelope.MinY;
+    psExtent->MaxX = sEnvelope.MaxX;
+    psExtent->MaxY = sEnvelope.MaxY;
+    return true;
+}
+
+/************************************************************************/
+/*                               Select()                               */
+/*                                                                      */
+/*      Return the features that OGRLayer::FilterGeometry() would       */
+/*      accept if poFilterGeom was installed as spatial filter, in      */
+/*      the order they were read from the layer.  This method can be    */
+/*      called concurrently from several threads.                       */
+/************************************************************************/
+
+void OGRLayerOverlayIndex::Select( const OGRGeometry *poFilterGeom,
+                                   std::vector<OGRFeature*>& apoSelected ) const
+{
+    apoSelected.clear();
+    if( m_aaoLevels.empty() )
+        return;
+
+    OGREnvelope sFilterEnvelope;
+    poFilterGeom->getEnvelope(&sFilterEnvelope);
+
+    std::vector<size_t> anCandidates;
+    std::vector<std::pair<size_t, size_t>> aoStack;
+    aoStack.push_back(std::make_pair(m_aaoLevels.size() - 1,
+                                     static_cast<size_t>(0)));
+    while( !aoStack.empty() )
+    {
+        const size_t iLevel = aoStack.back().first;
+        const Node& oNode = m_aaoLevels[iLevel][aoStack.back().second];
+        aoStack.pop_back();
+        if( !oNode.sEnvelope.Intersects(sFilterEnvelope) )
+            continue;
+        for( size_t i = oNode.nFirstChild;
+             i < oNode.nFirstChild + oNode.nChildCount; i++ )
+        {
+            if( iLevel > 0 )
+            {
+                aoStack.push_back(std::make_pair(iLevel - 1, i));
+            }
+            else if( m_asEnvelopes[m_anItems[i]].Intersects(sFilterEnvelope) )
+            {
+                anCandidates.push_back(m_anItems[i]);
+            }
+        }
+    }
+    if( anCandidates.empty() )
+        return;
+    std::sort(anCandidates.begin(), anCandidates.end());
+
+    const int bFilterIsEnvelope = OGRGeometryIsRectangle(poFilterGeom);
+    OGRPreparedGeometryUniquePtr poPreparedFilterGeom;
+    std::unique_ptr<OGRPointInPolygonIndex> poPIPIndex;
+    if( !bFilterIsEnvelope )
+    {
+        poPreparedFilterGeom.reset(OGRCreatePreparedGeometry(poFilterGeom));
+        poPIPIndex.reset(OGRPointInPolygonIndex::Create(poFilterGeom));
+    }
+
+    for( size_t i = 0; i < anCandidates.size(); i++ )
+    {
+        OGRFeature *poFeature = m_apoFeatures[anCandidates[i]].get();
+        if( OGRFilterGeometry(poFilterGeom, sFilterEnvelope,
+                              bFilterIsEnvelope, poPreparedFilterGeom.get(),
+                              poPIPIndex.get(),
+                              poFeature->GetGeometryRef()) )
+        {
+            apoSelected.push_back(poFeature);
+        }
+    }
+}
+
+/************************************************************************/
+/*                            select_from()                             */
+/*                                                                      */
+/*      Select the features of the index that intersect the geometry    */
+/*      of pFeature, restricted to the existing spatial filter of the   */
+/*      layer the index was loaded from.  Returns the geometry of       */
+/*      pFeature or NULL if nothing can be selected.                    */
+/************************************************************************/
+
+static
+OGRGeometry *select_from(const OGRLayerOverlayIndex &oIndex,
+                         const OGRGeometry *pGeometryExistingFilter,
+                         OGRFeature *pFeature,
+                         std::vector<OGRFeature*> &apoSelected)
+{
+    apoSelected.clear();
+    OGRGeometry *geom = pFeature->GetGeometryRef();
+    if (!geom) return nullptr;
+    if (pGeometryExistingFilter) {
+        if (!geom->Intersects(pGeometryExistingFilter)) return nullptr;
+        OGRGeometryUniquePtr intersection(geom->Intersection(pGeometryExistingFilter));
+        if (intersection) {
+            oIndex.Select(intersection.get(), apoSelected);
+        } else
+            return nullptr;
+    } else {
+        oIndex.Select(geom, apoSelected);
+    }
+    return geom;
+}
+
+/************************************************************************/
+/*                        OGRLayerOverlayRunner                         */
+/*                                                                      */
+/*      Apply an overlay function to each feature of a layer or of an   */
+/*      index, and write the resulting features to the result layer.    */
+/*      With NUM_THREADS > 1, the overlay function is run on batches    */
+/*      of features in a pool of worker threads.  Results and error     */
+/*      messages are then written from the calling thread, in the       */
+/*      order of the source features, so the result layer is the same   */
+/*      as with a single thread.                                        */
+/************************************************************************/
+
+typedef std::function<OGRErr(OGRFeature *,
+                             std::vector<OGRFeatureUniquePtr> &)>
+                                                    OGRLayerOverlayFunc;
+
+namespace {
+struct OGRLayerOverlayError
+{
+    CPLErr      eErr = CE_None;
+    CPLErrorNum nErrorNum = CPLE_None;
+    CPLString   osMsg{};
+};
+
+struct OGRLayerOverlayJob
+{
+    const OGRLayerOverlayFunc        *pfnOverlay = nullptr;
+    OGRFeatureUniquePtr               poOwnedFeature{};
+    OGRFeature                       *poFeature = nullptr;
+    std::vector<OGRFeatureUniquePtr>  apoResults{};
+    OGRErr                            eErr = OGRERR_NONE;
+    std::vector<OGRLayerOverlayError> aoErrors{};
+};
+} // namespace
+
+static void CPL_STDCALL OGRLayerOverlayErrorHandler( CPLErr eErr,
+                                                     CPLErrorNum nErrorNum,
+                                                     const char *pszMsg )
+{
+    if( eErr == CE_Debug )
+        return;
+    std::vector<OGRLayerOverlayError> *paoErrors =
+        static_cast<std::vector<OGRLayerOverlayError> *>(
+                                        CPLGetErrorHandlerUserData());
+    OGRLayerOverlayError oError;
+    oError.eErr = eErr;
+    oError.nErrorNum = nErrorNum;
+    oError.osMsg = pszMsg;
+    paoErrors->push_back(oError);
+}
+
+static void OGRLayerOverlayJobFunc( void *pData )
+{
+    OGRLayerOverlayJob *psJob = static_cast<OGRLayerOverlayJob *>(pData);
+    CPLPushErrorHandlerEx(OGRLayerOverlayErrorHandler, &psJob->aoErrors);
+    CPLErrorReset();
+    psJob->eErr = (*psJob->pfnOverlay)(psJob->poFeature, psJob->apoResults);
+    CPLPopErrorHandler();
+}
+
+class OGRLayerOverlayRunner
+{
+    CPL_DISALLOW_COPY_ASSIGN(OGRLayerOverlayRunner)
+
+    OGRLayer           *m_pLayerResult;
+    int                 m_bSkipFailures;
+    int                 m_nThreads;
+    GDALProgressFunc    m_pfnProgress;
+    void               *m_pProgressArg;
+    double              m_dfProgressMax;
+    double              m_dfProgressCounter = 0;
+    std::unique_ptr<CPLWorkerThreadPool> m_poThreadPool{};
+
+    OGRErr  Progress();
+    OGRErr  Write( OGRLayerOverlayJob &oJob );
+    OGRErr  Run( const std::function<bool(OGRLayerOverlayJob &)> &fetch,
+                 const OGRLayerOverlayFunc &pfnOverlay );
+
+  public:
+    OGRLayerOverlayRunner( OGRLayer *pLayerResult,
+                           char **papszOptions,
+                           GDALProgressFunc pfnProgress,
+                           void *pProgressArg,
+                           double dfProgressMax );
+
+    OGRErr  Run( OGRLayer *pLayerSource,
+                 const OGRLayerOverlayFunc &pfnOverlay );
+    OGRErr  Run( const OGRLayerOverlayIndex &oIndexSource,
+                 const OGRLayerOverlayFunc &pfnOverlay );
+};
+
+OGRLayerOverlayRunner::OGRLayerOverlayRunner( OGRLayer *pLayerResult,
+                                              char **papszOptions,
+                                              GDALProgressFunc pfnProgress,
+                                              void *pProgressArg,
+                                              double dfProgressMax ) :
+    m_pLayerResult(pLayerResult),
+    m_bSkipFailures(CPLTestBool(
+        CSLFetchNameValueDef(papszOptions, "SKIP_FAILURES", "NO"))),
+    m_nThreads(1),
+    m_pfnProgress(pfnProgress),
+    m_pProgressArg(pProgressArg),
+    m_dfProgressMax(dfProgressMax)
+{
+    const char *pszThreads = CSLFetchNameValueDef(papszOptions, "NUM_THREADS",
+                        CPLGetConfigOption("GDAL_NUM_THREADS", nullptr));
+    if( pszThreads != nullptr )
+    {
+        if( EQUAL(pszThreads, "ALL_CPUS") )
+            m_nThreads = CPLGetNumCPUs();
+        else
+            m_nThreads = atoi(pszThreads);
+        m_nThreads = std::max(1, std::min(128, m_nThreads));
+    }
+    if( m_nThreads > 1 )
+    {
+        m_poThreadPool.reset(new CPLWorkerThreadPool());
+        if( !m_poThreadPool->Setup(m_nThreads, nullptr, nullptr) )
+        {
+            m_poThreadPool.reset();
+            m_nThreads = 1;
+        }
+    }
+}
+
+/************************************************************************/
+/*                              Progress()                              */
+/************************************************************************/
+
+OGRErr OGRLayerOverlayRunner::Progress()
+{
+    if (m_pfnProgress) {
+        double p = m_dfProgressCounter/m_dfProgressMax;
+        if (p > 0) {
+            if (!m_pfnProgress(p, "", m_pProgressArg)) {
+                CPLError(CE_Failure, CPLE_UserInterrupt, "User terminated");
+                return OGRERR_FAILURE;
+            }
+        }
+        m_dfProgressCounter += 1.0;
+    }
+    return OGRERR_NONE;
+}
+
+/************************************************************************/
+/*                               Write()                                */
+/************************************************************************/
+
+OGRErr OGRLayerOverlayRunner::Write( OGRLayerOverlayJob &oJob )
+{
+    for( size_t i = 0; i < oJob.aoErrors.size(); i++ )
+    {
+        CPLError(oJob.aoErrors[i].eErr, oJob.aoErrors[i].nErrorNum,
+                 "%s", oJob.aoErrors[i].osMsg.c_str());
+    }
+    if( !oJob.aoErrors.empty() && m_bSkipFailures )
+        CPLErrorReset();
+
+    for( size_t i = 0; i < oJob.apoResults.size(); i++ )
+    {
+        OGRErr ret = m_pLayerResult->CreateFeature(oJob.apoResults[i].get());
+        if (ret != OGRERR_NONE) {
+            if (!m_bSkipFailures) {
+                return ret;
+            } else {
+                CPLErrorReset();
+            }
         }
-        if (!combined) return ret;
-        if (!mapMethod) return ret;
-        if (!poDefnMethod) return ret;
-        for( int iField = 0; iField < poDefnMethod->GetFieldCount(); iField++ ) {
-            OGRFieldDefn oFieldDefn(poDefnMethod->GetFieldDefn(iField));
-            if( pszMethodPrefix != nullptr )
-                oFieldDefn.SetName(CPLSPrintf("%s%s", pszMethodPrefix, oFieldDefn.GetNameRef()));
-            ret = pLayerResult->CreateField(&oFieldDefn);
-            if (ret != OGRERR_NONE) {
-                if (!bSkipFailures)
-                    return ret;
-                else {
-                    CPLErrorReset();
-                    ret = OGRERR_NONE;
-                }
+    }
+    return oJob.eErr;
+}
+
+/************************************************************************/
+/*                                Run()                                 */
+/************************************************************************/
+
+OGRErr OGRLayerOverlayRunner::Run(
+                    const std::function<bool(OGRLayerOverlayJob &)> &fetch,
+                    const OGRLayerOverlayFunc &pfnOverlay )
+{
+    if( m_poThreadPool == nullptr )
+    {
+        while( true )
+        {
+            OGRLayerOverlayJob oJob;
+            if( !fetch(oJob) )
+                break;
+            OGRErr ret = Progress();
+            if (ret != OGRERR_NONE) return ret;
+            oJob.eErr = pfnOverlay(oJob.poFeature, oJob.apoResults);
+            ret = Write(oJob);
+            if (ret != OGRERR_NONE) return ret;
+        }
+        return OGRERR_NONE;
+    }
+
+    // Keep all the workers busy while bounding the number of features
+    // held in memory.
+    const size_t nBatchSize = static_cast<size_t>(m_nThreads) * 16;
+    bool bEOF = false;
+    while( !bEOF )
+    {
+        std::vector<OGRLayerOverlayJob> aoJobs(nBatchSize);
+        std::vector<void *> apJobs;
+        for( size_t i = 0; i < nBatchSize; i++ )
+        {
+            if( !fetch(aoJobs[i]) )
+            {
+                bEOF = true;
+                break;
             }
-            mapMethod[iField] = nFieldsInput+iField;
+            OGRErr ret = Progress();
+            if (ret != OGRERR_NONE) return ret;
+            aoJobs[i].pfnOverlay = &pfnOverlay;
+            apJobs.push_back(&aoJobs[i]);
+        }
+        if( apJobs.empty() )
+            break;
+
+        m_poThreadPool->SubmitJobs(OGRLayerOverlayJobFunc, apJobs);
+        m_poThreadPool->WaitCompletion();
+
+        for( size_t i = 0; i < apJobs.size(); i++ )
+        {
+            OGRErr ret = Write(aoJobs[i]);
+            if (ret != OGRERR_NONE) return ret;
         }
     }
-    return ret;
+    return OGRERR_NONE;
 }
 
-static
-OGRGeometry *set_filter_from(OGRLayer *pLayer, OGRGeometry *pGeometryExistingFilter, OGRFeature *pFeature)
+OGRErr OGRLayerOverlayRunner::Run( OGRLayer *pLayerSource,
+                                   const OGRLayerOverlayFunc &pfnOverlay )
 {
-    OGRGeometry *geom = pFeature->GetGeometryRef();
-    if (!geom) return nullptr;
-    if (pGeometryExistingFilter) {
-        if (!geom->Intersects(pGeometryExistingFilter)) return nullptr;
-        OGRGeometry *intersection = geom->Intersection(pGeometryExistingFilter);
-        if (intersection) {
-            pLayer->SetSpatialFilter(intersection);
-            delete intersection;
-        } else
-            return nullptr;
-    } else {
-        pLayer->SetSpatialFilter(geom);
-    }
-    return geom;
+    pLayerSource->ResetReading();
+    return Run(
+        [pLayerSource](OGRLayerOverlayJob &oJob)
+        {
+            oJob.poOwnedFeature.reset(pLayerSource->GetNextFeature());
+            oJob.poFeature = oJob.poOwnedFeature.get();
+            return oJob.poFeature != nullptr;
+        },
+        pfnOverlay);
+}
+
+OGRErr OGRLayerOverlayRunner::Run( const OGRLayerOverlayIndex &oIndexSource,
+                                   const OGRLayerOverlayFunc &pfnOverlay )
+{
+    size_t iNext = 0;
+    return Run(
+        [&oIndexSource, &iNext](OGRLayerOverlayJob &oJob)
+        {
+            if( iNext == oIndexSource.GetFeatureCount() )
+                return false;
+            oJob.poFeature = oIndexSource.GetFeature(iNext++);
+            return true;
+        },
+        pfnOverlay);
 }
 
 static OGRGeometry* promote_to_multi(OGRGeometry* poGeom)
@@ -2007,8 +2943,8 @@ static OGRGeometry* promote_to_multi(OGRGeometry* poGeom)
  * layer, then the attribute in the result feature will get the value
  * from the feature of the method layer.
  *
- * \note For best performance use the minimum amount of features in
- * the method layer and copy it into a memory layer.
+ * \note The features of the method layer are loaded in memory and
+ * spatially indexed once, so that it is read only once.
  *
  * \note This method relies on GEOS support. Do not use unless the
  * GEOS support is compiled in.
@@ -2034,6 +2970,10 @@ static OGRGeometry* promote_to_multi(OGRGeometry* poGeom)
  *     result features with lower dimension geometry that would
  *     otherwise be added to the result layer. The default is to add
  *     but only if the result layer has an unknown geometry type.
+ * <li>NUM_THREADS=number_of_threads/ALL_CPUS. (GDAL >= 2.4) Number of
+ *     threads used to compute the result features. Results are
+ *     written in the same order as with a single thread. Defaults to
+ *     the value of the GDAL_NUM_THREADS configuration option, or 1.
  * </ul>
  *
  * This method is the same as the C function OGR_L_Intersection().
@@ -2074,9 +3014,9 @@ OGRErr OGRLayer::Intersection( OGRLayer *pLayerMethod,
     int *mapMethod = nullptr;
     OGREnvelope sEnvelopeMethod;
     GBool bEnvelopeSet;
-    double progress_max = static_cast<double>(GetFeatureCount(FALSE));
-    double progress_counter = 0;
-    double progress_ticker = 0;
+    OGRLayerOverlayIndex oIndexMethod;
+    OGRLayerOverlayRunner oRunner(pLayerResult, papszOptions, pfnProgress, pProgressArg,
+                                  static_cast<double>(GetFeatureCount(FALSE)));
     int bSkipFailures = CPLTestBool(CSLFetchNameValueDef(papszOptions, "SKIP_FAILURES", "NO"));
     int bPromoteToMulti = CPLTestBool(CSLFetchNameValueDef(papszOptions, "PROMOTE_TO_MULTI", "NO"));
     int bUsePreparedGeometries = CPLTestBool(CSLFetchNameValueDef(papszOptions, "USE_PREPARED_GEOMETRIES", "YES"));
@@ -2099,7 +3039,8 @@ OGRErr OGRLayer::Intersection( OGRLayer *pLayerMethod,
     ret = set_result_schema(pLayerResult, poDefnInput, poDefnMethod, mapInput, mapMethod, true, papszOptions);
     if (ret != OGRERR_NONE) goto done;
     poDefnResult = pLayerResult->GetLayerDefn();
-    bEnvelopeSet = pLayerMethod->GetExtent(&sEnvelopeMethod, 1) == OGRERR_NONE;
+    oIndexMethod.Load(pLayerMethod);
+    bEnvelopeSet = oIndexMethod.GetExtent(&sEnvelopeMethod);
     if (bKeepLowerDimGeom) {
         // require that the result layer is of geom type unknown
         if (pLayerResult->GetGeomType() != wkbUnknown) {
@@ -2108,20 +3049,9 @@ OGRErr OGRLayer::Intersection( OGRLayer *pLayerMethod,
         }
     }
 
-    for( auto&& x: this ) {
-
-        if (pfnProgress) {
-            double p = progress_counter/progress_max;
-            if (p > progress_ticker) {
-                if (!pfnProgress(p, "", pProgressArg)) {
-                    CPLError(CE_Failure, CPLE_UserInterrupt, "User terminated");
-                    ret = OGRERR_FAILURE;
-                    goto done;
-                }
-            }
-            progress_counter += 1.0;
-        }
-
+    ret = oRunner.Run(this,
+        [&](OGRFeature *x, std::vector<OGRFeatureUniquePtr> &apoResults) -> OGRErr
+    {
         // is it worth to proceed?
         if (bEnvelopeSet) {
             OGRGeometry *x_geom = x->GetGeometryRef();
@@ -2132,45 +3062,40 @@ OGRErr OGRLayer::Intersection( OGRLayer *pLayerMethod,
                     || x_env.MaxY < sEnvelopeMethod.MinY
                     || sEnvelopeMethod.MaxX < x_env.MinX
                     || sEnvelopeMethod.MaxY < x_env.MinY) {
-                    continue;
+                    return OGRERR_NONE;
                 }
             } else {
-                continue;
+                return OGRERR_NONE;
             }
         }
 
-        // set up the filter for method layer
+        // select the features of the method layer
+        std::vector<OGRFeature*> apoMethod;
         CPLErrorReset();
-        OGRGeometry *x_geom = set_filter_from(pLayerMethod, pGeometryMethodFilter, x.get());
+        OGRGeometry *x_geom = select_from(oIndexMethod, pGeometryMethodFilter, x, apoMethod);
         if (CPLGetLastErrorType() != CE_None) {
             if (!bSkipFailures) {
-                ret = OGRERR_FAILURE;
-                goto done;
+                return OGRERR_FAILURE;
             } else {
                 CPLErrorReset();
-                ret = OGRERR_NONE;
             }
         }
         if (!x_geom) {
-            continue;
+            return OGRERR_NONE;
         }
 
         OGRPreparedGeometryUniquePtr x_prepared_geom;
         if (bUsePreparedGeometries) {
             x_prepared_geom.reset(OGRCreatePreparedGeometry(x_geom));
-            if (!x_prepared_geom) {
-                goto done;
-            }
         }
 
-        for( auto&& y: pLayerMethod ) {
+        for( OGRFeature *y: apoMethod ) {
             OGRGeometry *y_geom = y->GetGeometryRef();
             if (!y_geom) continue;
             OGRGeometryUniquePtr z_geom;
 
             if (x_prepared_geom) {
                 CPLErrorReset();
-                ret = OGRERR_NONE;
                 if (bPretestContainment && OGRPreparedGeometryContains(x_prepared_geom.get(), y_geom))
                 {
                     if (CPLGetLastErrorType() == CE_None)
@@ -2184,11 +3109,9 @@ OGRErr OGRLayer::Intersection( OGRLayer *pLayerMethod,
                 }
                 if (CPLGetLastErrorType() != CE_None) {
                     if (!bSkipFailures) {
-                        ret = OGRERR_FAILURE;
-                        goto done;
+                        return OGRERR_FAILURE;
                     } else {
                         CPLErrorReset();
-                        ret = OGRERR_NONE;
                         continue;
                     }
                 }
@@ -2198,11 +3121,9 @@ OGRErr OGRLayer::Intersection( OGRLayer *pLayerMethod,
                 z_geom.reset(x_geom->Intersection(y_geom));
                 if (CPLGetLastErrorType() != CE_None || z_geom == nullptr) {
                     if (!bSkipFailures) {
-                        ret = OGRERR_FAILURE;
-                        goto done;
+                        return OGRERR_FAILURE;
                     } else {
                         CPLErrorReset();
-                        ret = OGRERR_NONE;
                         continue;
                     }
                 }
@@ -2215,23 +3136,16 @@ OGRErr OGRLayer::Intersection( OGRLayer *pLayerMethod,
                 }
             }
             OGRFeatureUniquePtr z(new OGRFeature(poDefnResult));
-            z->SetFieldsFrom(x.get(), mapInput);
-            z->SetFieldsFrom(y.get(), mapMethod);
+            z->SetFieldsFrom(x, mapInput);
+            z->SetFieldsFrom(y, mapMethod);
             if (bPromoteToMulti)
                 z_geom.reset(promote_to_multi(z_geom.release()));
             z->SetGeometryDirectly(z_geom.release());
-            ret = pLayerResult->CreateFeature(z.get());
-
-            if (ret != OGRERR_NONE) {
-                if (!bSkipFailures) {
-                    goto done;
-                } else {
-                    CPLErrorReset();
-                    ret = OGRERR_NONE;
-                }
-            }
+            apoResults.push_back(std::move(z));
         }
-    }
+        return OGRERR_NONE;
+    });
+    if (ret != OGRERR_NONE) goto done;
     if (pfnProgress && !pfnProgress(1.0, "", pProgressArg)) {
       CPLError(CE_Failure, CPLE_UserInterrupt, "User terminated");
       ret = OGRERR_FAILURE;
@@ -2239,7 +3153,6 @@ OGRErr OGRLayer::Intersection( OGRLayer *pLayerMethod,
     }
 done:
     // release resources
-    pLayerMethod->SetSpatialFilter(pGeometryMethodFilter);
     if (pGeometryMethodFilter) delete pGeometryMethodFilter;
     if (mapInput) VSIFree(mapInput);
     if (mapMethod) VSIFree(mapMethod);
@@ -2264,8 +3177,8 @@ done:
  * layer, then the attribute in the result feature will get the value
  * from the feature of the method layer.
  *
- * \note For best performance use the minimum amount of features in
- * the method layer and copy it into a memory layer.
+ * \note The features of the method layer are loaded in memory and
+ * spatially indexed once, so that it is read only once.
  *
  * \note This method relies on GEOS support. Do not use unless the
  * GEOS support is compiled in.
@@ -2291,6 +3204,10 @@ done:
  *     result features with lower dimension geometry that would
  *     otherwise be added to the result layer. The default is to add
  *     but only if the result layer has an unknown geometry type.
+ * <li>NUM_THREADS=number_of_threads/ALL_CPUS. (GDAL >= 2.4) Number of
+ *     threads used to compute the result features. Results are
+ *     written in the same order as with a single thread. Defaults to
+ *     the value of the GDAL_NUM_THREADS configuration option, or 1.
  * </ul>
  *
  * This function is the same as the C++ method OGRLayer::Intersection().
@@ -2357,8 +3274,9 @@ OGRErr OGR_L_Intersection( OGRLayerH pLayerInput,
  * layer, then the attribute in the result feature will get the value
  * from the feature of the method layer (even if it is undefined).
  *
- * \note For best performance use the minimum amount of features in
- * the method layer and copy it into a memory layer.
+ * \note The features of this layer and of the method layer are
+ * loaded in memory and spatially indexed once, so that each layer
+ * is read only once.
  *
  * \note This method relies on GEOS support. Do not use unless the
  * GEOS support is compiled in.
@@ -2380,6 +3298,10 @@ OGRErr OGR_L_Intersection( OGRLayerH pLayerInput,
  *     result features with lower dimension geometry that would
  *     otherwise be added to the result layer. The default is to add
  *     but only if the result layer has an unknown geometry type.
+ * <li>NUM_THREADS=number_of_threads/ALL_CPUS. (GDAL >= 2.4) Number of
+ *     threads used to compute the result features. Results are
+ *     written in the same order as with a single thread. Defaults to
+ *     the value of the GDAL_NUM_THREADS configuration option, or 1.
  * </ul>
  *
  * This method is the same as the C function OGR_L_Union().
@@ -2419,9 +3341,10 @@ OGRErr OGRLayer::Union( OGRLayer *pLayerMethod,
     OGRGeometry *pGeometryInputFilter = nullptr;
     int *mapInput = nullptr;
     int *mapMethod = nullptr;
-    double progress_max = static_cast<double>(GetFeatureCount(FALSE)) + static_cast<double>(pLayerMethod->GetFeatureCount(FALSE));
-    double progress_counter = 0;
-    double progress_ticker = 0;
+    OGRLayerOverlayIndex oIndexInput;
+    OGRLayerOverlayIndex oIndexMethod;
+    OGRLayerOverlayRunner oRunner(pLayerResult, papszOptions, pfnProgress, pProgressArg,
+                                  static_cast<double>(GetFeatureCount(FALSE)) + static_cast<double>(pLayerMethod->GetFeatureCount(FALSE)));
     int bSkipFailures = CPLTestBool(CSLFetchNameValueDef(papszOptions, "SKIP_FAILURES", "NO"));
     int bPromoteToMulti = CPLTestBool(CSLFetchNameValueDef(papszOptions, "PROMOTE_TO_MULTI", "NO"));
     int bUsePreparedGeometries = CPLTestBool(CSLFetchNameValueDef(papszOptions, "USE_PREPARED_GEOMETRIES", "YES"));
@@ -2445,6 +3368,8 @@ OGRErr OGRLayer::Union( OGRLayer *pLayerMethod,
     ret = set_result_schema(pLayerResult, poDefnInput, poDefnMethod, mapInput, mapMethod, true, papszOptions);
     if (ret != OGRERR_NONE) goto done;
     poDefnResult = pLayerResult->GetLayerDefn();
+    oIndexInput.Load(this);
+    oIndexMethod.Load(pLayerMethod);
     if (bKeepLowerDimGeom) {
         // require that the result layer is of geom type unknown
         if (pLayerResult->GetGeomType() != wkbUnknown) {
@@ -2454,46 +3379,31 @@ OGRErr OGRLayer::Union( OGRLayer *pLayerMethod,
     }
 
     // add features based on input layer
-    for( auto&& x: this ) {
-
-        if (pfnProgress) {
-            double p = progress_counter/progress_max;
-            if (p > progress_ticker) {
-                if (!pfnProgress(p, "", pProgressArg)) {
-                    CPLError(CE_Failure, CPLE_UserInterrupt, "User terminated");
-                    ret = OGRERR_FAILURE;
-                    goto done;
-                }
-            }
-            progress_counter += 1.0;
-        }
-
-        // set up the filter on method layer
+    ret = oRunner.Run(oIndexInput,
+        [&](OGRFeature *x, std::vector<OGRFeatureUniquePtr> &apoResults) -> OGRErr
+    {
+        // select the features of the method layer
+        std::vector<OGRFeature*> apoMethod;
         CPLErrorReset();
-        OGRGeometry *x_geom = set_filter_from(pLayerMethod, pGeometryMethodFilter, x.get());
+        OGRGeometry *x_geom = select_from(oIndexMethod, pGeometryMethodFilter, x, apoMethod);
         if (CPLGetLastErrorType() != CE_None) {
             if (!bSkipFailures) {
-                ret = OGRERR_FAILURE;
-                goto done;
+                return OGRERR_FAILURE;
             } else {
                 CPLErrorReset();
-                ret = OGRERR_NONE;
             }
         }
         if (!x_geom) {
-            continue;
+            return OGRERR_NONE;
         }
 
         OGRPreparedGeometryUniquePtr x_prepared_geom;
         if (bUsePreparedGeometries) {
             x_prepared_geom.reset(OGRCreatePreparedGeometry(x_geom));
-            if (!x_prepared_geom) {
-                goto done;
-            }
         }
 
         OGRGeometryUniquePtr x_geom_diff(x_geom->clone()); // this will be the geometry of the result feature
-        for( auto&& y: pLayerMethod) {
+        for( OGRFeature *y: apoMethod ) {
             OGRGeometry *y_geom = y->GetGeometryRef();
             if (!y_geom) { continue;}
 
@@ -2505,11 +3415,9 @@ OGRErr OGRLayer::Union( OGRLayer *pLayerMethod,
             }
             if (CPLGetLastErrorType() != CE_None) {
                 if (!bSkipFailures) {
-                    ret = OGRERR_FAILURE;
-                    goto done;
+                    return OGRERR_FAILURE;
                 } else {
                     CPLErrorReset();
-                    ret = OGRERR_NONE;
                 }
             }
 
@@ -2517,11 +3425,9 @@ OGRErr OGRLayer::Union( OGRLayer *pLayerMethod,
             OGRGeometryUniquePtr poIntersection(x_geom->Intersection(y_geom));
             if (CPLGetLastErrorType() != CE_None || poIntersection == nullptr) {
                 if (!bSkipFailures) {
-                    ret = OGRERR_FAILURE;
-                    goto done;
+                    return OGRERR_FAILURE;
                 } else {
                     CPLErrorReset();
-                    ret = OGRERR_NONE;
                     continue;
                 }
             }
@@ -2535,8 +3441,8 @@ OGRErr OGRLayer::Union( OGRLayer *pLayerMethod,
             else
             {
                 OGRFeatureUniquePtr z(new OGRFeature(poDefnResult));
-                z->SetFieldsFrom(x.get(), mapInput);
-                z->SetFieldsFrom(y.get(), mapMethod);
+                z->SetFieldsFrom(x, mapInput);
+                z->SetFieldsFrom(y, mapMethod);
                 if( bPromoteToMulti )
                     poIntersection.reset(promote_to_multi(poIntersection.release()));
                 z->SetGeometryDirectly(poIntersection.release());
@@ -2546,8 +3452,7 @@ OGRErr OGRLayer::Union( OGRLayer *pLayerMethod,
                     OGRGeometryUniquePtr x_geom_diff_new(x_geom_diff->Difference(y_geom));
                     if (CPLGetLastErrorType() != CE_None || x_geom_diff_new == nullptr) {
                         if (!bSkipFailures) {
-                            ret = OGRERR_FAILURE;
-                            goto done;
+                            return OGRERR_FAILURE;
                         } else {
                             CPLErrorReset();
                         }
@@ -2556,15 +3461,7 @@ OGRErr OGRLayer::Union( OGRLayer *pLayerMethod,
                     }
                 }
 
-                ret = pLayerResult->CreateFeature(z.get());
-                if (ret != OGRERR_NONE) {
-                    if (!bSkipFailures) {
-                        goto done;
-                    } else {
-                        CPLErrorReset();
-                        ret = OGRERR_NONE;
-                    }
-                }
+                apoResults.push_back(std::move(z));
             }
         }
         x_prepared_geom.reset();
@@ -2576,56 +3473,37 @@ OGRErr OGRLayer::Union( OGRLayer *pLayerMethod,
         else
         {
             OGRFeatureUniquePtr z(new OGRFeature(poDefnResult));
-            z->SetFieldsFrom(x.get(), mapInput);
+            z->SetFieldsFrom(x, mapInput);
             if( bPromoteToMulti )
                 x_geom_diff.reset(promote_to_multi(x_geom_diff.release()));
             z->SetGeometryDirectly(x_geom_diff.release());
-            ret = pLayerResult->CreateFeature(z.get());
-            if (ret != OGRERR_NONE) {
-                if (!bSkipFailures) {
-                    goto done;
-                } else {
-                    CPLErrorReset();
-                    ret = OGRERR_NONE;
-                }
-            }
-        }
-    }
-
-    // restore filter on method layer and add features based on it
-    pLayerMethod->SetSpatialFilter(pGeometryMethodFilter);
-    for( auto&& x: pLayerMethod ) {
-
-        if (pfnProgress) {
-            double p = progress_counter/progress_max;
-            if (p > progress_ticker) {
-                if (!pfnProgress(p, "", pProgressArg)) {
-                    CPLError(CE_Failure, CPLE_UserInterrupt, "User terminated");
-                    ret = OGRERR_FAILURE;
-                    goto done;
-                }
-            }
-            progress_counter += 1.0;
+            apoResults.push_back(std::move(z));
         }
+        return OGRERR_NONE;
+    });
+    if (ret != OGRERR_NONE) goto done;
 
-        // set up the filter on input layer
+    // add features based on method layer
+    ret = oRunner.Run(oIndexMethod,
+        [&](OGRFeature *x, std::vector<OGRFeatureUniquePtr> &apoResults) -> OGRErr
+    {
+        // select the features of the input layer
+        std::vector<OGRFeature*> apoInput;
         CPLErrorReset();
-        OGRGeometry *x_geom = set_filter_from(this, pGeometryInputFilter, x.get());
+        OGRGeometry *x_geom = select_from(oIndexInput, pGeometryInputFilter, x, apoInput);
         if (CPLGetLastErrorType() != CE_None) {
             if (!bSkipFailures) {
-                ret = OGRERR_FAILURE;
-                goto done;
+                return OGRERR_FAILURE;
             } else {
                 CPLErrorReset();
-                ret = OGRERR_NONE;
             }
         }
         if (!x_geom) {
-            continue;
+            return OGRERR_NONE;
         }
 
         OGRGeometryUniquePtr x_geom_diff(x_geom->clone()); // this will be the geometry of the result feature
-        for( auto&& y: this ) {
+        for( OGRFeature *y: apoInput ) {
             OGRGeometry *y_geom = y->GetGeometryRef();
             if (!y_geom) { continue;}
 
@@ -2634,11 +3512,9 @@ OGRErr OGRLayer::Union( OGRLayer *pLayerMethod,
                 OGRGeometryUniquePtr x_geom_diff_new(x_geom_diff->Difference(y_geom));
                 if (CPLGetLastErrorType() != CE_None || x_geom_diff_new == nullptr) {
                     if (!bSkipFailures) {
-                        ret = OGRERR_FAILURE;
-                        goto done;
+                        return OGRERR_FAILURE;
                     } else {
                         CPLErrorReset();
-                        ret = OGRERR_NONE;
                     }
                 } else {
                     x_geom_diff.swap(x_geom_diff_new);
@@ -2653,21 +3529,15 @@ OGRErr OGRLayer::Union( OGRLayer *pLayerMethod,
         else
         {
             OGRFeatureUniquePtr z(new OGRFeature(poDefnResult));
-            z->SetFieldsFrom(x.get(), mapMethod);
+            z->SetFieldsFrom(x, mapMethod);
             if( bPromoteToMulti )
                 x_geom_diff.reset(promote_to_multi(x_geom_diff.release()));
             z->SetGeometryDirectly(x_geom_diff.release());
-            ret = pLayerResult->CreateFeature(z.get());
-            if (ret != OGRERR_NONE) {
-                if (!bSkipFailures) {
-                    goto done;
-                } else {
-                    CPLErrorReset();
-                    ret = OGRERR_NONE;
-                }
-            }
+            apoResults.push_back(std::move(z));
         }
-    }
+        return OGRERR_NONE;
+    });
+    if (ret != OGRERR_NONE) goto done;
     if (pfnProgress && !pfnProgress(1.0, "", pProgressArg)) {
       CPLError(CE_Failure, CPLE_UserInterrupt, "User terminated");
       ret = OGRERR_FAILURE;
@@ -2675,8 +3545,6 @@ OGRErr OGRLayer::Union( OGRLayer *pLayerMethod,
     }
 done:
     // release resources
-    SetSpatialFilter(pGeometryInputFilter);
-    pLayerMethod->SetSpatialFilter(pGeometryMethodFilter);
     if (pGeometryMethodFilter) delete pGeometryMethodFilter;
     if (pGeometryInputFilter) delete pGeometryInputFilter;
     if (mapInput) VSIFree(mapInput);
@@ -2705,8 +3573,9 @@ done:
  * layer, then the attribute in the result feature will get the value
  * from the feature of the method layer (even if it is undefined).
  *
- * \note For best performance use the minimum amount of features in
- * the method layer and copy it into a memory layer.
+ * \note The features of this layer and of the method layer are
+ * loaded in memory and spatially indexed once, so that each layer
+ * is read only once.
  *
  * \note This method relies on GEOS support. Do not use unless the
  * GEOS support is compiled in.
@@ -2728,6 +3597,10 @@ done:
  *     result features with lower dimension geometry that would
  *     otherwise be added to the result layer. The default is to add
  *     but only if the result layer has an unknown geometry type.
+ * <li>NUM_THREADS=number_of_threads/ALL_CPUS. (GDAL >= 2.4) Number of
+ *     threads used to compute the result features. Results are
+ *     written in the same order as with a single thread. Defaults to
+ *     the value of the GDAL_NUM_THREADS configuration option, or 1.
  * </ul>
  *
  * This function is the same as the C++ method OGRLayer::Union().
@@ -2794,8 +3667,9 @@ OGRErr OGR_L_Union( OGRLayerH pLayerInput,
  * layer, then the attribute in the result feature will get the value
  * from the feature of the method layer (even if it is undefined).
  *
- * \note For best performance use the minimum amount of features in
- * the method layer and copy it into a memory layer.
+ * \note The features of this layer and of the method layer are
+ * loaded in memory and spatially indexed once, so that each layer
+ * is read only once.
  *
  * \note This method relies on GEOS support. Do not use unless the
  * GEOS support is compiled in.
@@ -2810,6 +3684,10 @@ OGRErr OGR_L_Union( OGRLayerH pLayerInput,
  *     will be created from the fields of the input layer.
  * <li>METHOD_PREFIX=string. Set a prefix for the field names that
  *     will be created from the fields of the method layer.
+ * <li>NUM_THREADS=number_of_threads/ALL_CPUS. (GDAL >= 2.4) Number of
+ *     threads used to compute the result features. Results are
+ *     written in the same order as with a single thread. Defaults to
+ *     the value of the GDAL_NUM_THREADS configuration option, or 1.
  * </ul>
  *
  * This method is the same as the C function OGR_L_SymDifference().
@@ -2849,9 +3727,10 @@ OGRErr OGRLayer::SymDifference( OGRLayer *pLayerMethod,
     OGRGeometry *pGeometryInputFilter = nullptr;
     int *mapInput = nullptr;
     int *mapMethod = nullptr;
-    double progress_max = static_cast<double>(GetFeatureCount(FALSE)) + static_cast<double>(pLayerMethod->GetFeatureCount(FALSE));
-    double progress_counter = 0;
-    double progress_ticker = 0;
+    OGRLayerOverlayIndex oIndexInput;
+    OGRLayerOverlayIndex oIndexMethod;
+    OGRLayerOverlayRunner oRunner(pLayerResult, papszOptions, pfnProgress, pProgressArg,
+                                  static_cast<double>(GetFeatureCount(FALSE)) + static_cast<double>(pLayerMethod->GetFeatureCount(FALSE)));
     int bSkipFailures = CPLTestBool(CSLFetchNameValueDef(papszOptions, "SKIP_FAILURES", "NO"));
     int bPromoteToMulti = CPLTestBool(CSLFetchNameValueDef(papszOptions, "PROMOTE_TO_MULTI", "NO"));
 
@@ -2872,40 +3751,30 @@ OGRErr OGRLayer::SymDifference( OGRLayer *pLayerMethod,
     ret = set_result_schema(pLayerResult, poDefnInput, poDefnMethod, mapInput, mapMethod, true, papszOptions);
     if (ret != OGRERR_NONE) goto done;
     poDefnResult = pLayerResult->GetLayerDefn();
+    oIndexInput.Load(this);
+    oIndexMethod.Load(pLayerMethod);
 
     // add features based on input layer
-    for( auto&& x: this ) {
-
-        if (pfnProgress) {
-            double p = progress_counter/progress_max;
-            if (p > progress_ticker) {
-                if (!pfnProgress(p, "", pProgressArg)) {
-                    CPLError(CE_Failure, CPLE_UserInterrupt, "User terminated");
-                    ret = OGRERR_FAILURE;
-                    goto done;
-                }
-            }
-            progress_counter += 1.0;
-        }
-
-        // set up the filter on method layer
+    ret = oRunner.Run(oIndexInput,
+        [&](OGRFeature *x, std::vector<OGRFeatureUniquePtr> &apoResults) -> OGRErr
+    {
+        // select the features of the method layer
+        std::vector<OGRFeature*> apoMethod;
         CPLErrorReset();
-        OGRGeometry *x_geom = set_filter_from(pLayerMethod, pGeometryMethodFilter, x.get());
+        OGRGeometry *x_geom = select_from(oIndexMethod, pGeometryMethodFilter, x, apoMethod);
         if (CPLGetLastErrorType() != CE_None) {
             if (!bSkipFailures) {
-                ret = OGRERR_FAILURE;
-                goto done;
+                return OGRERR_FAILURE;
             } else {
                 CPLErrorReset();
-                ret = OGRERR_NONE;
             }
         }
         if (!x_geom) {
-            continue;
+            return OGRERR_NONE;
         }
 
         OGRGeometryUniquePtr geom(x_geom->clone()); // this will be the geometry of the result feature
-        for( auto&& y: pLayerMethod ) {
+        for( OGRFeature *y: apoMethod ) {
             OGRGeometry *y_geom = y->GetGeometryRef();
             if (!y_geom) {continue;}
             if (geom) {
@@ -2913,11 +3782,9 @@ OGRErr OGRLayer::SymDifference( OGRLayer *pLayerMethod,
                 OGRGeometryUniquePtr geom_new(geom->Difference(y_geom));
                 if (CPLGetLastErrorType() != CE_None || geom_new == nullptr) {
                     if (!bSkipFailures) {
-                        ret = OGRERR_FAILURE;
-                        goto done;
+                        return OGRERR_FAILURE;
                     } else {
                         CPLErrorReset();
-                        ret = OGRERR_NONE;
                     }
                 } else {
                     geom.swap(geom_new);
@@ -2928,56 +3795,37 @@ OGRErr OGRLayer::SymDifference( OGRLayer *pLayerMethod,
 
         if (geom && !geom->IsEmpty()) {
             OGRFeatureUniquePtr z(new OGRFeature(poDefnResult));
-            z->SetFieldsFrom(x.get(), mapInput);
+            z->SetFieldsFrom(x, mapInput);
             if( bPromoteToMulti )
                 geom.reset(promote_to_multi(geom.release()));
             z->SetGeometryDirectly(geom.release());
-            ret = pLayerResult->CreateFeature(z.get());
-            if (ret != OGRERR_NONE) {
-                if (!bSkipFailures) {
-                    goto done;
-                } else {
-                    CPLErrorReset();
-                    ret = OGRERR_NONE;
-                }
-            }
-        }
-    }
-
-    // restore filter on method layer and add features based on it
-    pLayerMethod->SetSpatialFilter(pGeometryMethodFilter);
-    for( auto&& x: pLayerMethod ) {
-
-        if (pfnProgress) {
-            double p = progress_counter/progress_max;
-            if (p > progress_ticker) {
-                if (!pfnProgress(p, "", pProgressArg)) {
-                    CPLError(CE_Failure, CPLE_UserInterrupt, "User terminated");
-                    ret = OGRERR_FAILURE;
-                    goto done;
-                }
-            }
-            progress_counter += 1.0;
+            apoResults.push_back(std::move(z));
         }
+        return OGRERR_NONE;
+    });
+    if (ret != OGRERR_NONE) goto done;
 
-        // set up the filter on input layer
+    // add features based on method layer
+    ret = oRunner.Run(oIndexMethod,
+        [&](OGRFeature *x, std::vector<OGRFeatureUniquePtr> &apoResults) -> OGRErr
+    {
+        // select the features of the input layer
+        std::vector<OGRFeature*> apoInput;
         CPLErrorReset();
-        OGRGeometry *x_geom = set_filter_from(this, pGeometryInputFilter, x.get());
+        OGRGeometry *x_geom = select_from(oIndexInput, pGeometryInputFilter, x, apoInput);
         if (CPLGetLastErrorType() != CE_None) {
             if (!bSkipFailures) {
-                ret = OGRERR_FAILURE;
-                goto done;
+                return OGRERR_FAILURE;
             } else {
                 CPLErrorReset();
-                ret = OGRERR_NONE;
             }
         }
         if (!x_geom) {
-            continue;
+            return OGRERR_NONE;
         }
 
         OGRGeometryUniquePtr geom(x_geom->clone()); // this will be the geometry of the result feature
-        for( auto&& y: this ) {
+        for( OGRFeature *y: apoInput ) {
             OGRGeometry *y_geom = y->GetGeometryRef();
             if (!y_geom) continue;
             if (geom) {
@@ -2985,11 +3833,9 @@ OGRErr OGRLayer::SymDifference( OGRLayer *pLayerMethod,
                 OGRGeometryUniquePtr geom_new(geom->Difference(y_geom));
                 if (CPLGetLastErrorType() != CE_None || geom_new == nullptr) {
                     if (!bSkipFailures) {
-                        ret = OGRERR_FAILURE;
-                        goto done;
+                        return OGRERR_FAILURE;
                     } else {
                         CPLErrorReset();
-                        ret = OGRERR_NONE;
                     }
                 } else {
                     geom.swap(geom_new);
@@ -3000,21 +3846,15 @@ OGRErr OGRLayer::SymDifference( OGRLayer *pLayerMethod,
 
         if (geom && !geom->IsEmpty()) {
             OGRFeatureUniquePtr z(new OGRFeature(poDefnResult));
-            z->SetFieldsFrom(x.get(), mapMethod);
+            z->SetFieldsFrom(x, mapMethod);
             if( bPromoteToMulti )
                 geom.reset(promote_to_multi(geom.release()));
             z->SetGeometryDirectly(geom.release());
-            ret = pLayerResult->CreateFeature(z.get());
-            if (ret != OGRERR_NONE) {
-                if (!bSkipFailures) {
-                    goto done;
-                } else {
-                    CPLErrorReset();
-                    ret = OGRERR_NONE;
-                }
-            }
+            apoResults.push_back(std::move(z));
         }
-    }
+        return OGRERR_NONE;
+    });
+    if (ret != OGRERR_NONE) goto done;
     if (pfnProgress && !pfnProgress(1.0, "", pProgressArg)) {
       CPLError(CE_Failure, CPLE_UserInterrupt, "User terminated");
       ret = OGRERR_FAILURE;
@@ -3022,8 +3862,6 @@ OGRErr OGRLayer::SymDifference( OGRLayer *pLayerMethod,
     }
 done:
     // release resources
-    SetSpatialFilter(pGeometryInputFilter);
-    pLayerMethod->SetSpatialFilter(pGeometryMethodFilter);
     if (pGeometryMethodFilter) delete pGeometryMethodFilter;
     if (pGeometryInputFilter) delete pGeometryInputFilter;
     if (mapInput) VSIFree(mapInput);
@@ -3052,8 +3890,9 @@ done:
  * layer, then the attribute in the result feature will get the value
  * from the feature of the method layer (even if it is undefined).
  *
- * \note For best performance use the minimum amount of features in
- * the method layer and copy it into a memory layer.
+ * \note The features of this layer and of the method layer are
+ * loaded in memory and spatially indexed once, so that each layer
+ * is read only once.
  *
  * \note This method relies on GEOS support. Do not use unless the
  * GEOS support is compiled in.
@@ -3068,6 +3907,10 @@ done:
  *     will be created from the fields of the input layer.
  * <li>METHOD_PREFIX=string. Set a prefix for the field names that
  *     will be created from the fields of the method layer.
+ * <li>NUM_THREADS=number_of_threads/ALL_CPUS. (GDAL >= 2.4) Number of
+ *     threads used to compute the result features. Results are
+ *     written in the same order as with a single thread. Defaults to
+ *     the value of the GDAL_NUM_THREADS configuration option, or 1.
  * </ul>
  *
  * This function is the same as the C++ method OGRLayer::SymDifference().
@@ -3132,8 +3975,8 @@ OGRErr OGR_L_SymDifference( OGRLayerH pLayerInput,
  * layer, then the attribute in the result feature will get the value
  * from the feature of the method layer (even if it is undefined).
  *
- * \note For best performance use the minimum amount of features in
- * the method layer and copy it into a memory layer.
+ * \note The features of the method layer are loaded in memory and
+ * spatially indexed once, so that it is read only once.
  *
  * \note This method relies on GEOS support. Do not use unless the
  * GEOS support is compiled in.
@@ -3155,6 +3998,10 @@ OGRErr OGR_L_SymDifference( OGRLayerH pLayerInput,
  *     result features with lower dimension geometry that would
  *     otherwise be added to the result layer. The default is to add
  *     but only if the result layer has an unknown geometry type.
+ * <li>NUM_THREADS=number_of_threads/ALL_CPUS. (GDAL >= 2.4) Number of
+ *     threads used to compute the result features. Results are
+ *     written in the same order as with a single thread. Defaults to
+ *     the value of the GDAL_NUM_THREADS configuration option, or 1.
  * </ul>
  *
  * This method is the same as the C function OGR_L_Identity().
@@ -3193,9 +4040,9 @@ OGRErr OGRLayer::Identity( OGRLayer *pLayerMethod,
     OGRGeometry *pGeometryMethodFilter = nullptr;
     int *mapInput = nullptr;
     int *mapMethod = nullptr;
-    double progress_max = static_cast<double>(GetFeatureCount(FALSE));
-    double progress_counter = 0;
-    double progress_ticker = 0;
+    OGRLayerOverlayIndex oIndexMethod;
+    OGRLayerOverlayRunner oRunner(pLayerResult, papszOptions, pfnProgress, pProgressArg,
+                                  static_cast<double>(GetFeatureCount(FALSE)));
     int bSkipFailures = CPLTestBool(CSLFetchNameValueDef(papszOptions, "SKIP_FAILURES", "NO"));
     int bPromoteToMulti = CPLTestBool(CSLFetchNameValueDef(papszOptions, "PROMOTE_TO_MULTI", "NO"));
     int bUsePreparedGeometries = CPLTestBool(CSLFetchNameValueDef(papszOptions, "USE_PREPARED_GEOMETRIES", "YES"));
@@ -3224,48 +4071,34 @@ OGRErr OGRLayer::Identity( OGRLayer *pLayerMethod,
     ret = set_result_schema(pLayerResult, poDefnInput, poDefnMethod, mapInput, mapMethod, true, papszOptions);
     if (ret != OGRERR_NONE) goto done;
     poDefnResult = pLayerResult->GetLayerDefn();
+    oIndexMethod.Load(pLayerMethod);
 
     // split the features in input layer to the result layer
-    for( auto&& x: this ) {
-
-        if (pfnProgress) {
-            double p = progress_counter/progress_max;
-            if (p > progress_ticker) {
-                if (!pfnProgress(p, "", pProgressArg)) {
-                    CPLError(CE_Failure, CPLE_UserInterrupt, "User terminated");
-                    ret = OGRERR_FAILURE;
-                    goto done;
-                }
-            }
-            progress_counter += 1.0;
-        }
-
-        // set up the filter on method layer
+    ret = oRunner.Run(this,
+        [&](OGRFeature *x, std::vector<OGRFeatureUniquePtr> &apoResults) -> OGRErr
+    {
+        // select the features of the method layer
+        std::vector<OGRFeature*> apoMethod;
         CPLErrorReset();
-        OGRGeometry *x_geom = set_filter_from(pLayerMethod, pGeometryMethodFilter, x.get());
+        OGRGeometry *x_geom = select_from(oIndexMethod, pGeometryMethodFilter, x, apoMethod);
         if (CPLGetLastErrorType() != CE_None) {
             if (!bSkipFailures) {
-                ret = OGRERR_FAILURE;
-                goto done;
+                return OGRERR_FAILURE;
             } else {
                 CPLErrorReset();
-                ret = OGRERR_NONE;
             }
         }
         if (!x_geom) {
-            continue;
+            return OGRERR_NONE;
         }
 
         OGRPreparedGeometryUniquePtr x_prepared_geom;
         if (bUsePreparedGeometries) {
             x_prepared_geom.reset(OGRCreatePreparedGeometry(x_geom));
-            if (!x_prepared_geom) {
-                goto done;
-            }
         }
 
         OGRGeometryUniquePtr x_geom_diff(x_geom->clone()); // this will be the geometry of the result feature
-        for( auto&& y: pLayerMethod ) {
+        for( OGRFeature *y: apoMethod ) {
             OGRGeometry *y_geom = y->GetGeometryRef();
             if (!y_geom)
                 continue;
@@ -3278,11 +4111,9 @@ OGRErr OGRLayer::Identity( OGRLayer *pLayerMethod,
             }
             if (CPLGetLastErrorType() != CE_None) {
                 if (!bSkipFailures) {
-                    ret = OGRERR_FAILURE;
-                    goto done;
+                    return OGRERR_FAILURE;
                 } else {
                     CPLErrorReset();
-                    ret = OGRERR_NONE;
                 }
             }
 
@@ -3290,11 +4121,9 @@ OGRErr OGRLayer::Identity( OGRLayer *pLayerMethod,
             OGRGeometryUniquePtr poIntersection(x_geom->Intersection(y_geom));
             if (CPLGetLastErrorType() != CE_None || poIntersection == nullptr) {
                 if (!bSkipFailures) {
-                    ret = OGRERR_FAILURE;
-                    goto done;
+                    return OGRERR_FAILURE;
                 } else {
                     CPLErrorReset();
-                    ret = OGRERR_NONE;
                 }
             }
             else if( poIntersection->IsEmpty() ||
@@ -3307,8 +4136,8 @@ OGRErr OGRLayer::Identity( OGRLayer *pLayerMethod,
             else
             {
                 OGRFeatureUniquePtr z(new OGRFeature(poDefnResult));
-                z->SetFieldsFrom(x.get(), mapInput);
-                z->SetFieldsFrom(y.get(), mapMethod);
+                z->SetFieldsFrom(x, mapInput);
+                z->SetFieldsFrom(y, mapMethod);
                 if( bPromoteToMulti )
                     poIntersection.reset(promote_to_multi(poIntersection.release()));
                 z->SetGeometryDirectly(poIntersection.release());
@@ -3317,8 +4146,7 @@ OGRErr OGRLayer::Identity( OGRLayer *pLayerMethod,
                     OGRGeometryUniquePtr x_geom_diff_new(x_geom_diff->Difference(y_geom));
                     if (CPLGetLastErrorType() != CE_None || x_geom_diff_new == nullptr) {
                         if (!bSkipFailures) {
-                            ret = OGRERR_FAILURE;
-                            goto done;
+                            return OGRERR_FAILURE;
                         } else {
                             CPLErrorReset();
                         }
@@ -3326,15 +4154,7 @@ OGRErr OGRLayer::Identity( OGRLayer *pLayerMethod,
                         x_geom_diff.swap(x_geom_diff_new);
                     }
                 }
-                ret = pLayerResult->CreateFeature(z.get());
-                if (ret != OGRERR_NONE) {
-                    if (!bSkipFailures) {
-                        goto done;
-                    } else {
-                        CPLErrorReset();
-                        ret = OGRERR_NONE;
-                    }
-                }
+                apoResults.push_back(std::move(z));
             }
         }
 
@@ -3347,21 +4167,15 @@ OGRErr OGRLayer::Identity( OGRLayer *pLayerMethod,
         else
         {
             OGRFeatureUniquePtr z(new OGRFeature(poDefnResult));
-            z->SetFieldsFrom(x.get(), mapInput);
+            z->SetFieldsFrom(x, mapInput);
             if( bPromoteToMulti )
                 x_geom_diff.reset(promote_to_multi(x_geom_diff.release()));
             z->SetGeometryDirectly(x_geom_diff.release());
-            ret = pLayerResult->CreateFeature(z.get());
-            if (ret != OGRERR_NONE) {
-                if (!bSkipFailures) {
-                    goto done;
-                } else {
-                    CPLErrorReset();
-                    ret = OGRERR_NONE;
-                }
-            }
+            apoResults.push_back(std::move(z));
         }
-    }
+        return OGRERR_NONE;
+    });
+    if (ret != OGRERR_NONE) goto done;
     if (pfnProgress && !pfnProgress(1.0, "", pProgressArg)) {
       CPLError(CE_Failure, CPLE_UserInterrupt, "User terminated");
       ret = OGRERR_FAILURE;
@@ -3369,7 +4183,6 @@ OGRErr OGRLayer::Identity( OGRLayer *pLayerMethod,
     }
 done:
     // release resources
-    pLayerMethod->SetSpatialFilter(pGeometryMethodFilter);
     if (pGeometryMethodFilter) delete pGeometryMethodFilter;
     if (mapInput) VSIFree(mapInput);
     if (mapMethod) VSIFree(mapMethod);
@@ -3395,8 +4208,8 @@ done:
  * layer, then the attribute in the result feature will get the value
  * from the feature of the method layer (even if it is undefined).
  *
- * \note For best performance use the minimum amount of features in
- * the method layer and copy it into a memory layer.
+ * \note The features of the method layer are loaded in memory and
+ * spatially indexed once, so that it is read only once.
  *
  * \note This method relies on GEOS support. Do not use unless the
  * GEOS support is compiled in.
@@ -3418,6 +4231,10 @@ done:
  *     result features with lower dimension geometry that would
  *     otherwise be added to the result layer. The default is to add
  *     but only if the result layer has an unknown geometry type.
+ * <li>NUM_THREADS=number_of_threads/ALL_CPUS. (GDAL >= 2.4) Number of
+ *     threads used to compute the result features. Results are
+ *     written in the same order as with a single thread. Defaults to
+ *     the value of the GDAL_NUM_THREADS configuration option, or 1.
  * </ul>
  *
  * This function is the same as the C++ method OGRLayer::Identity().
@@ -3484,8 +4301,8 @@ OGRErr OGR_L_Identity( OGRLayerH pLayerInput,
  * the attribute in the result feature the originates from the method
  * layer will get the value from the feature of the method layer.
  *
- * \note For best performance use the minimum amount of features in
- * the method layer and copy it into a memory layer.
+ * \note The features of the method layer are loaded in memory and
+ * spatially indexed once, so that it is read only once.
  *
  * \note This method relies on GEOS support. Do not use unless the
  * GEOS support is compiled in.
@@ -3500,6 +4317,10 @@ OGRErr OGR_L_Identity( OGRLayerH pLayerInput,
  *     will be created from the fields of the input layer.
  * <li>METHOD_PREFIX=string. Set a prefix for the field names that
  *     will be created from the fields of the method layer.
+ * <li>NUM_THREADS=number_of_threads/ALL_CPUS. (GDAL >= 2.4) Number of
+ *     threads used to compute the result features. Results are
+ *     written in the same order as with a single thread. Defaults to
+ *     the value of the GDAL_NUM_THREADS configuration option, or 1.
  * </ul>
  *
  * This method is the same as the C function OGR_L_Update().
@@ -3538,9 +4359,9 @@ OGRErr OGRLayer::Update( OGRLayer *pLayerMethod,
     OGRGeometry *pGeometryMethodFilter = nullptr;
     int *mapInput = nullptr;
     int *mapMethod = nullptr;
-    double progress_max = static_cast<double>(GetFeatureCount(FALSE)) + static_cast<double>(pLayerMethod->GetFeatureCount(FALSE));
-    double progress_counter = 0;
-    double progress_ticker = 0;
+    OGRLayerOverlayIndex oIndexMethod;
+    OGRLayerOverlayRunner oRunner(pLayerResult, papszOptions, pfnProgress, pProgressArg,
+                                  static_cast<double>(GetFeatureCount(FALSE)) + static_cast<double>(pLayerMethod->GetFeatureCount(FALSE)));
     int bSkipFailures = CPLTestBool(CSLFetchNameValueDef(papszOptions, "SKIP_FAILURES", "NO"));
     int bPromoteToMulti = CPLTestBool(CSLFetchNameValueDef(papszOptions, "PROMOTE_TO_MULTI", "NO"));
 
@@ -3559,40 +4380,29 @@ OGRErr OGRLayer::Update( OGRLayer *pLayerMethod,
     ret = set_result_schema(pLayerResult, poDefnInput, poDefnMethod, mapInput, mapMethod, false, papszOptions);
     if (ret != OGRERR_NONE) goto done;
     poDefnResult = pLayerResult->GetLayerDefn();
+    oIndexMethod.Load(pLayerMethod);
 
     // add clipped features from the input layer
-    for( auto&& x: this ) {
-
-        if (pfnProgress) {
-            double p = progress_counter/progress_max;
-            if (p > progress_ticker) {
-                if (!pfnProgress(p, "", pProgressArg)) {
-                    CPLError(CE_Failure, CPLE_UserInterrupt, "User terminated");
-                    ret = OGRERR_FAILURE;
-                    goto done;
-                }
-            }
-            progress_counter += 1.0;
-        }
-
-        // set up the filter on method layer
+    ret = oRunner.Run(this,
+        [&](OGRFeature *x, std::vector<OGRFeatureUniquePtr> &apoResults) -> OGRErr
+    {
+        // select the features of the method layer
+        std::vector<OGRFeature*> apoMethod;
         CPLErrorReset();
-        OGRGeometry *x_geom = set_filter_from(pLayerMethod, pGeometryMethodFilter, x.get());
+        OGRGeometry *x_geom = select_from(oIndexMethod, pGeometryMethodFilter, x, apoMethod);
         if (CPLGetLastErrorType() != CE_None) {
             if (!bSkipFailures) {
-                ret = OGRERR_FAILURE;
-                goto done;
+                return OGRERR_FAILURE;
             } else {
                 CPLErrorReset();
-                ret = OGRERR_NONE;
             }
         }
         if (!x_geom) {
-            continue;
+            return OGRERR_NONE;
         }
 
         OGRGeometryUniquePtr x_geom_diff(x_geom->clone()); //this will be the geometry of a result feature
-        for( auto&& y: pLayerMethod ) {
+        for( OGRFeature *y: apoMethod ) {
             OGRGeometry *y_geom = y->GetGeometryRef();
             if (!y_geom) continue;
             if (x_geom_diff) {
@@ -3600,11 +4410,9 @@ OGRErr OGRLayer::Update( OGRLayer *pLayerMethod,
                 OGRGeometryUniquePtr x_geom_diff_new(x_geom_diff->Difference(y_geom));
                 if (CPLGetLastErrorType() != CE_None || x_geom_diff_new == nullptr) {
                     if (!bSkipFailures) {
-                        ret = OGRERR_FAILURE;
-                        goto done;
+                        return OGRERR_FAILURE;
                     } else {
                         CPLErrorReset();
-                        ret = OGRERR_NONE;
                     }
                 } else {
                     x_geom_diff.swap(x_geom_diff_new);
@@ -3619,53 +4427,29 @@ OGRErr OGRLayer::Update( OGRLayer *pLayerMethod,
         else
         {
             OGRFeatureUniquePtr z(new OGRFeature(poDefnResult));
-            z->SetFieldsFrom(x.get(), mapInput);
+            z->SetFieldsFrom(x, mapInput);
             if( bPromoteToMulti )
                 x_geom_diff.reset(promote_to_multi(x_geom_diff.release()));
             z->SetGeometryDirectly(x_geom_diff.release());
-            ret = pLayerResult->CreateFeature(z.get());
-            if (ret != OGRERR_NONE) {
-                if (!bSkipFailures) {
-                    goto done;
-                } else {
-                    CPLErrorReset();
-                    ret = OGRERR_NONE;
-                }
-            }
-        }
-    }
-
-    // restore the original filter and add features from the update layer
-    pLayerMethod->SetSpatialFilter(pGeometryMethodFilter);
-    for( auto&& y: pLayerMethod ) {
-
-        if (pfnProgress) {
-            double p = progress_counter/progress_max;
-            if (p > progress_ticker) {
-                if (!pfnProgress(p, "", pProgressArg)) {
-                    CPLError(CE_Failure, CPLE_UserInterrupt, "User terminated");
-                    ret = OGRERR_FAILURE;
-                    goto done;
-                }
-            }
-            progress_counter += 1.0;
+            apoResults.push_back(std::move(z));
         }
+        return OGRERR_NONE;
+    });
+    if (ret != OGRERR_NONE) goto done;
 
+    // add features from the update layer
+    ret = oRunner.Run(oIndexMethod,
+        [&](OGRFeature *y, std::vector<OGRFeatureUniquePtr> &apoResults) -> OGRErr
+    {
         OGRGeometry *y_geom = y->StealGeometry();
-        if (!y_geom) continue;
+        if (!y_geom) return OGRERR_NONE;
         OGRFeatureUniquePtr z(new OGRFeature(poDefnResult));
-        if (mapMethod) z->SetFieldsFrom(y.get(), mapMethod);
+        if (mapMethod) z->SetFieldsFrom(y, mapMethod);
         z->SetGeometryDirectly(y_geom);
-        ret = pLayerResult->CreateFeature(z.get());
-        if (ret != OGRERR_NONE) {
-            if (!bSkipFailures) {
-                goto done;
-            } else {
-                CPLErrorReset();
-                ret = OGRERR_NONE;
-            }
-        }
-    }
+        apoResults.push_back(std::move(z));
+        return OGRERR_NONE;
+    });
+    if (ret != OGRERR_NONE) goto done;
     if (pfnProgress && !pfnProgress(1.0, "", pProgressArg)) {
       CPLError(CE_Failure, CPLE_UserInterrupt, "User terminated");
       ret = OGRERR_FAILURE;
@@ -3673,7 +4457,6 @@ OGRErr OGRLayer::Update( OGRLayer *pLayerMethod,
     }
 done:
     // release resources
-    pLayerMethod->SetSpatialFilter(pGeometryMethodFilter);
     if (pGeometryMethodFilter) delete pGeometryMethodFilter;
     if (mapInput) VSIFree(mapInput);
     if (mapMethod) VSIFree(mapMethod);
@@ -3701,8 +4484,8 @@ done:
  * the attribute in the result feature the originates from the method
  * layer will get the value from the feature of the method layer.
  *
- * \note For best performance use the minimum amount of features in
- * the method layer and copy it into a memory layer.
+ * \note The features of the method layer are loaded in memory and
+ * spatially indexed once, so that it is read only once.
  *
  * \note This method relies on GEOS support. Do not use unless the
  * GEOS support is compiled in.
@@ -3717,6 +4500,10 @@ done:
  *     will be created from the fields of the input layer.
  * <li>METHOD_PREFIX=string. Set a prefix for the field names that
  *     will be created from the fields of the method layer.
+ * <li>NUM_THREADS=number_of_threads/ALL_CPUS. (GDAL >= 2.4) Number of
+ *     threads used to compute the result features. Results are
+ *     written in the same order as with a single thread. Defaults to
+ *     the value of the GDAL_NUM_THREADS configuration option, or 1.
  * </ul>
  *
  * This function is the same as the C++ method OGRLayer::Update().
@@ -3776,8 +4563,8 @@ OGRErr OGR_L_Update( OGRLayerH pLayerInput,
  * schema of the result layer can be set by the user or, if it is
  * empty, is initialized to contain all fields in the input layer.
  *
- * \note For best performance use the minimum amount of features in
- * the method layer and copy it into a memory layer.
+ * \note The features of the method layer are loaded in memory and
+ * spatially indexed once, so that it is read only once.
  *
  * \note This method relies on GEOS support. Do not use unless the
  * GEOS support is compiled in.
@@ -3792,6 +4579,10 @@ OGRErr OGR_L_Update( OGRLayerH pLayerInput,
  *     will be created from the fields of the input layer.
  * <li>METHOD_PREFIX=string. Set a prefix for the field names that
  *     will be created from the fields of the method layer.
+ * <li>NUM_THREADS=number_of_threads/ALL_CPUS. (GDAL >= 2.4) Number of
+ *     threads used to compute the result features. Results are
+ *     written in the same order as with a single thread. Defaults to
+ *     the value of the GDAL_NUM_THREADS configuration option, or 1.
  * </ul>
  *
  * This method is the same as the C function OGR_L_Clip().
@@ -3828,9 +4619,9 @@ OGRErr OGRLayer::Clip( OGRLayer *pLayerMethod,
     OGRFeatureDefn *poDefnResult = nullptr;
     OGRGeometry *pGeometryMethodFilter = nullptr;
     int *mapInput = nullptr;
-    double progress_max = static_cast<double>(GetFeatureCount(FALSE));
-    double progress_counter = 0;
-    double progress_ticker = 0;
+    OGRLayerOverlayIndex oIndexMethod;
+    OGRLayerOverlayRunner oRunner(pLayerResult, papszOptions, pfnProgress, pProgressArg,
+                                  static_cast<double>(GetFeatureCount(FALSE)));
     int bSkipFailures = CPLTestBool(CSLFetchNameValueDef(papszOptions, "SKIP_FAILURES", "NO"));
     int bPromoteToMulti = CPLTestBool(CSLFetchNameValueDef(papszOptions, "PROMOTE_TO_MULTI", "NO"));
 
@@ -3847,39 +4638,28 @@ OGRErr OGRLayer::Clip( OGRLayer *pLayerMethod,
     if (ret != OGRERR_NONE) goto done;
 
     poDefnResult = pLayerResult->GetLayerDefn();
-    for( auto&& x: this ) {
-
-        if (pfnProgress) {
-            double p = progress_counter/progress_max;
-            if (p > progress_ticker) {
-                if (!pfnProgress(p, "", pProgressArg)) {
-                    CPLError(CE_Failure, CPLE_UserInterrupt, "User terminated");
-                    ret = OGRERR_FAILURE;
-                    goto done;
-                }
-            }
-            progress_counter += 1.0;
-        }
-
-        // set up the filter on method layer
+    oIndexMethod.Load(pLayerMethod);
+    ret = oRunner.Run(this,
+        [&](OGRFeature *x, std::vector<OGRFeatureUniquePtr> &apoResults) -> OGRErr
+    {
+        // select the features of the method layer
+        std::vector<OGRFeature*> apoMethod;
         CPLErrorReset();
-        OGRGeometry *x_geom = set_filter_from(pLayerMethod, pGeometryMethodFilter, x.get());
+        OGRGeometry *x_geom = select_from(oIndexMethod, pGeometryMethodFilter, x, apoMethod);
         if (CPLGetLastErrorType() != CE_None) {
             if (!bSkipFailures) {
-                ret = OGRERR_FAILURE;
-                goto done;
+                return OGRERR_FAILURE;
             } else {
                 CPLErrorReset();
-                ret = OGRERR_NONE;
             }
         }
         if (!x_geom) {
-            continue;
+            return OGRERR_NONE;
         }
 
         OGRGeometryUniquePtr geom; // this will be the geometry of the result feature
         // incrementally add area from y to geom
-        for( auto&& y: pLayerMethod ) {
+        for( OGRFeature *y: apoMethod ) {
             OGRGeometry *y_geom = y->GetGeometryRef();
             if (!y_geom) continue;
             if (!geom) {
@@ -3889,11 +4669,9 @@ OGRErr OGRLayer::Clip( OGRLayer *pLayerMethod,
                 OGRGeometryUniquePtr geom_new(geom->Union(y_geom));
                 if (CPLGetLastErrorType() != CE_None || geom_new == nullptr) {
                     if (!bSkipFailures) {
-                        ret = OGRERR_FAILURE;
-                        goto done;
+                        return OGRERR_FAILURE;
                     } else {
                         CPLErrorReset();
-                        ret = OGRERR_NONE;
                     }
                 } else {
                     geom.swap(geom_new);
@@ -3907,32 +4685,24 @@ OGRErr OGRLayer::Clip( OGRLayer *pLayerMethod,
             OGRGeometryUniquePtr poIntersection(x_geom->Intersection(geom.get()));
             if (CPLGetLastErrorType() != CE_None || poIntersection == nullptr) {
                 if (!bSkipFailures) {
-                    ret = OGRERR_FAILURE;
-                    goto done;
+                    return OGRERR_FAILURE;
                 } else {
                     CPLErrorReset();
-                    ret = OGRERR_NONE;
                 }
             }
             else if( !poIntersection->IsEmpty() )
             {
                 OGRFeatureUniquePtr z(new OGRFeature(poDefnResult));
-                z->SetFieldsFrom(x.get(), mapInput);
+                z->SetFieldsFrom(x, mapInput);
                 if( bPromoteToMulti )
                     poIntersection.reset(promote_to_multi(poIntersection.release()));
                 z->SetGeometryDirectly(poIntersection.release());
-                ret = pLayerResult->CreateFeature(z.get());
-                if (ret != OGRERR_NONE) {
-                    if (!bSkipFailures) {
-                        goto done;
-                    } else {
-                        CPLErrorReset();
-                        ret = OGRERR_NONE;
-                    }
-                }
+                apoResults.push_back(std::move(z));
             }
         }
-    }
+        return OGRERR_NONE;
+    });
+    if (ret != OGRERR_NONE) goto done;
     if (pfnProgress && !pfnProgress(1.0, "", pProgressArg)) {
       CPLError(CE_Failure, CPLE_UserInterrupt, "User terminated");
       ret = OGRERR_FAILURE;
@@ -3940,7 +4710,6 @@ OGRErr OGRLayer::Clip( OGRLayer *pLayerMethod,
     }
 done:
     // release resources
-    pLayerMethod->SetSpatialFilter(pGeometryMethodFilter);
     if (pGeometryMethodFilter) delete pGeometryMethodFilter;
     if (mapInput) VSIFree(mapInput);
     return ret;
@@ -3960,8 +4729,8 @@ done:
  * schema of the result layer can be set by the user or, if it is
  * empty, is initialized to contain all fields in the input layer.
  *
- * \note For best performance use the minimum amount of features in
- * the method layer and copy it into a memory layer.
+ * \note The features of the method layer are loaded in memory and
+ * spatially indexed once, so that it is read only once.
  *
  * \note This method relies on GEOS support. Do not use unless the
  * GEOS support is compiled in.
@@ -3976,6 +4745,10 @@ done:
  *     will be created from the fields of the input layer.
  * <li>METHOD_PREFIX=string. Set a prefix for the field names that
  *     will be created from the fields of the method layer.
+ * <li>NUM_THREADS=number_of_threads/ALL_CPUS. (GDAL >= 2.4) Number of
+ *     threads used to compute the result features. Results are
+ *     written in the same order as with a single thread. Defaults to
+ *     the value of the GDAL_NUM_THREADS configuration option, or 1.
  * </ul>
  *
  * This function is the same as the C++ method OGRLayer::Clip().
@@ -4035,8 +4808,8 @@ OGRErr OGR_L_Clip( OGRLayerH pLayerInput,
  * it is empty, is initialized to contain all fields in the input
  * layer.
  *
- * \note For best performance use the minimum amount of features in
- * the method layer and copy it into a memory layer.
+ * \note The features of the method layer are loaded in memory and
+ * spatially indexed once, so that it is read only once.
  *
  * \note This method relies on GEOS support. Do not use unless the
  * GEOS support is compiled in.
@@ -4051,6 +4824,10 @@ OGRErr OGR_L_Clip( OGRLayerH pLayerInput,
  *     will be created from the fields of the input layer.
  * <li>METHOD_PREFIX=string. Set a prefix for the field names that
  *     will be created from the fields of the method layer.
+ * <li>NUM_THREADS=number_of_threads/ALL_CPUS. (GDAL >= 2.4) Number of
+ *     threads used to compute the result features. Results are
+ *     written in the same order as with a single thread. Defaults to
+ *     the value of the GDAL_NUM_THREADS configuration option, or 1.
  * </ul>
  *
  * This method is the same as the C function OGR_L_Erase().
@@ -4087,9 +4864,9 @@ OGRErr OGRLayer::Erase( OGRLayer *pLayerMethod,
     OGRFeatureDefn *poDefnResult = nullptr;
     OGRGeometry *pGeometryMethodFilter = nullptr;
     int *mapInput = nullptr;
-    double progress_max = static_cast<double>(GetFeatureCount(FALSE));
-    double progress_counter = 0;
-    double progress_ticker = 0;
+    OGRLayerOverlayIndex oIndexMethod;
+    OGRLayerOverlayRunner oRunner(pLayerResult, papszOptions, pfnProgress, pProgressArg,
+                                  static_cast<double>(GetFeatureCount(FALSE)));
     int bSkipFailures = CPLTestBool(CSLFetchNameValueDef(papszOptions, "SKIP_FAILURES", "NO"));
     int bPromoteToMulti = CPLTestBool(CSLFetchNameValueDef(papszOptions, "PROMOTE_TO_MULTI", "NO"));
 
@@ -4106,51 +4883,38 @@ OGRErr OGRLayer::Erase( OGRLayer *pLayerMethod,
     ret = set_result_schema(pLayerResult, poDefnInput, nullptr, mapInput, nullptr, false, papszOptions);
     if (ret != OGRERR_NONE) goto done;
     poDefnResult = pLayerResult->GetLayerDefn();
+    oIndexMethod.Load(pLayerMethod);
 
-    for( auto&& x: this ) {
-
-        if (pfnProgress) {
-            double p = progress_counter/progress_max;
-            if (p > progress_ticker) {
-                if (!pfnProgress(p, "", pProgressArg)) {
-                    CPLError(CE_Failure, CPLE_UserInterrupt, "User terminated");
-                    ret = OGRERR_FAILURE;
-                    goto done;
-                }
-            }
-            progress_counter += 1.0;
-        }
-
-        // set up the filter on the method layer
+    ret = oRunner.Run(this,
+        [&](OGRFeature *x, std::vector<OGRFeatureUniquePtr> &apoResults) -> OGRErr
+    {
+        // select the features of the method layer
+        std::vector<OGRFeature*> apoMethod;
         CPLErrorReset();
-        OGRGeometry *x_geom = set_filter_from(pLayerMethod, pGeometryMethodFilter, x.get());
+        OGRGeometry *x_geom = select_from(oIndexMethod, pGeometryMethodFilter, x, apoMethod);
         if (CPLGetLastErrorType() != CE_None) {
             if (!bSkipFailures) {
-                ret = OGRERR_FAILURE;
-                goto done;
+                return OGRERR_FAILURE;
             } else {
                 CPLErrorReset();
-                ret = OGRERR_NONE;
             }
         }
         if (!x_geom) {
-            continue;
+            return OGRERR_NONE;
         }
 
         OGRGeometryUniquePtr geom(x_geom->clone()); // this will be the geometry of the result feature
         // incrementally erase y from geom
-        for( auto&& y: pLayerMethod ) {
+        for( OGRFeature *y: apoMethod ) {
             OGRGeometry *y_geom = y->GetGeometryRef();
             if (!y_geom) continue;
             CPLErrorReset();
             OGRGeometryUniquePtr geom_new(geom->Difference(y_geom));
             if (CPLGetLastErrorType() != CE_None || geom_new == nullptr) {
                 if (!bSkipFailures) {
-                    ret = OGRERR_FAILURE;
-                    goto done;
+                    return OGRERR_FAILURE;
                 } else {
                     CPLErrorReset();
-                    ret = OGRERR_NONE;
                 }
             } else {
                 geom.swap(geom_new);
@@ -4164,21 +4928,15 @@ OGRErr OGRLayer::Erase( OGRLayer *pLayerMethod,
         // add a new feature if there is remaining area
         if (!geom->IsEmpty()) {
             OGRFeatureUniquePtr z(new OGRFeature(poDefnResult));
-            z->SetFieldsFrom(x.get(), mapInput);
+            z->SetFieldsFrom(x, mapInput);
             if( bPromoteToMulti )
                 geom.reset(promote_to_multi(geom.release()));
             z->SetGeometryDirectly(geom.release());
-            ret = pLayerResult->CreateFeature(z.get());
-            if (ret != OGRERR_NONE) {
-                if (!bSkipFailures) {
-                    goto done;
-                } else {
-                    CPLErrorReset();
-                    ret = OGRERR_NONE;
-                }
-            }
+            apoResults.push_back(std::move(z));
         }
-    }
+        return OGRERR_NONE;
+    });
+    if (ret != OGRERR_NONE) goto done;
     if (pfnProgress && !pfnProgress(1.0, "", pProgressArg)) {
       CPLError(CE_Failure, CPLE_UserInterrupt, "User terminated");
       ret = OGRERR_FAILURE;
@@ -4186,7 +4944,6 @@ OGRErr OGRLayer::Erase( OGRLayer *pLayerMethod,
     }
 done:
     // release resources
-    pLayerMethod->SetSpatialFilter(pGeometryMethodFilter);
     if (pGeometryMethodFilter) delete pGeometryMethodFilter;
     if (mapInput) VSIFree(mapInput);
     return ret;
@@ -4206,8 +4963,8 @@ done:
  * it is empty, is initialized to contain all fields in the input
  * layer.
  *
- * \note For best performance use the minimum amount of features in
- * the method layer and copy it into a memory layer.
+ * \note The features of the method layer are loaded in memory and
+ * spatially indexed once, so that it is read only once.
  *
  * \note This method relies on GEOS support. Do not use unless the
  * GEOS support is compiled in.
@@ -4222,6 +4979,10 @@ done:
  *     will be created from the fields of the input layer.
  * <li>METHOD_PREFIX=string. Set a prefix for the field names that
  *     will be created from the fields of the method layer.
+ * <li>NUM_THREADS=number_of_threads/ALL_CPUS. (GDAL >= 2.4) Number of
+ *     threads used to compute the result features. Results are
+ *     written in the same order as with a single thread. Defaults to
+ *     the value of the GDAL_NUM_THREADS configuration option, or 1.
  * </ul>
  *
  * This function is the same as the C++ method OGRLayer::Erase().
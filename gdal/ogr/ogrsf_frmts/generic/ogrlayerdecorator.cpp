@@ -97,6 +97,25 @@ OGRFeature *OGRLayerDecorator::GetNextFeature()
     return m_poDecoratedLayer->GetNextFeature();
 }
 
+int         OGRLayerDecorator::GetNextFeatureBatch( OGRFeatureBatch* poBatch,
+                                                    int nMaxRows )
+{
+    if( !m_poDecoratedLayer ) return 0;
+    // Decorators that have their own layer definition go through their
+    // GetNextFeature()
+    if( poBatch->GetDefn() != m_poDecoratedLayer->GetLayerDefn() )
+        return OGRLayer::GetNextFeatureBatch(poBatch, nMaxRows);
+    return m_poDecoratedLayer->GetNextFeatureBatch(poBatch, nMaxRows);
+}
+
+int         OGRLayerDecorator::FillNextFeature( OGRFeature* poFeature )
+{
+    if( !m_poDecoratedLayer ) return FALSE;
+    if( poFeature->GetDefnRef() != m_poDecoratedLayer->GetLayerDefn() )
+        return OGRLayer::FillNextFeature(poFeature);
+    return m_poDecoratedLayer->FillNextFeature(poFeature);
+}
+
 OGRErr      OGRLayerDecorator::SetNextByIndex( GIntBig nIndex )
 {
     if( !m_poDecoratedLayer ) return OGRERR_FAILURE;
@@ -287,6 +287,31 @@ OGRFeature *OGRProxiedLayer::GetNextFeature()
     return poUnderlyingLayer->GetNextFeature();
 }
 
+/************************************************************************/
+/*                        GetNextFeatureBatch()                         */
+/************************************************************************/
+
+int         OGRProxiedLayer::GetNextFeatureBatch( OGRFeatureBatch* poBatch,
+                                                  int nMaxRows )
+{
+    if( poUnderlyingLayer == nullptr && !OpenUnderlyingLayer() ) return 0;
+    if( poBatch->GetDefn() != poUnderlyingLayer->GetLayerDefn() )
+        return OGRLayer::GetNextFeatureBatch(poBatch, nMaxRows);
+    return poUnderlyingLayer->GetNextFeatureBatch(poBatch, nMaxRows);
+}
+
+/************************************************************************/
+/*                          FillNextFeature()                           */
+/************************************************************************/
+
+int         OGRProxiedLayer::FillNextFeature( OGRFeature* poFeature )
+{
+    if( poUnderlyingLayer == nullptr && !OpenUnderlyingLayer() ) return FALSE;
+    if( poFeature->GetDefnRef() != poUnderlyingLayer->GetLayerDefn() )
+        return OGRLayer::FillNextFeature(poFeature);
+    return poUnderlyingLayer->FillNextFeature(poFeature);
+}
+
 /************************************************************************/
 /*                           SetNextByIndex()                           */
 /************************************************************************/
@@ -93,6 +93,19 @@ OGRFeature *OGRMutexedLayer::GetNextFeature()
     return OGRLayerDecorator::GetNextFeature();
 }
 
+int         OGRMutexedLayer::GetNextFeatureBatch( OGRFeatureBatch* poBatch,
+                                                  int nMaxRows )
+{
+    CPLMutexHolderOptionalLockD(m_hMutex);
+    return OGRLayerDecorator::GetNextFeatureBatch(poBatch, nMaxRows);
+}
+
+int         OGRMutexedLayer::FillNextFeature( OGRFeature* poFeature )
+{
+    CPLMutexHolderOptionalLockD(m_hMutex);
+    return OGRLayerDecorator::FillNextFeature(poFeature);
+}
+
 OGRErr      OGRMutexedLayer::SetNextByIndex( GIntBig nIndex )
 {
     CPLMutexHolderOptionalLockD(m_hMutex);
@@ -0,0 +1,633 @@
+/******************************************************************************
+ *
+ * Project:  OpenGIS Simple Features Reference Implementation
+ * Purpose:  Persistent spatial index stored next to a data file, for
+ *           drivers without a native spatial index.
+ *
+ ******************************************************************************
+ * Copyright (c) 2018, GDAL contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ ****************************************************************************/
+
+#include "ogrsidecarspatialindex.h"
+#include "cpl_conv.h"
+#include "cpl_error.h"
+
+#include <algorithm>
+#include <cstring>
+#include <limits>
+
+CPL_CVSID("$Id$")
+
+//! @cond Doxygen_Suppress
+
+/*
+ * File layout, all values being little endian:
+ *
+ *   char[8]    magic "OGRSIDX\0"
+ *   uint32     version (1)
+ *   uint32     number of entries per node
+ *   uint64     size of the data file
+ *   int64      modification time of the data file
+ *   uint64     number of items
+ *   uint32     length of the geometry field name
+ *   char[]     geometry field name, padded with nul characters to a
+ *              multiple of 8 bytes
+ *   node[]     the items sorted along a Hilbert curve, followed by each
+ *              upper level of the tree up to the root.  A node is the
+ *              envelope (4 doubles) followed by a uint64 which is the FID
+ *              for the items, and the index of the first child for the
+ *              upper levels.
+ *   uint64[]   offset of each item
+ */
+
+static const char SIDX_MAGIC[8] = { 'O', 'G', 'R', 'S', 'I', 'D', 'X', '\0' };
+static const GUInt32 SIDX_VERSION = 1;
+static const int SIDX_NODE_SIZE = 16;
+static const int SIDX_NODE_BYTES = 4 * 8 + 8;
+
+/************************************************************************/
+/*                         ComputeLevelEnds()                           */
+/*                                                                      */
+/*      Returns the index, in the node array, of the end of each        */
+/*      level, starting with the items.                                 */
+/************************************************************************/
+
+static std::vector<GUIntBig> ComputeLevelEnds( GUIntBig nItemCount,
+                                               int nNodeSize )
+{
+    std::vector<GUIntBig> anLevelEnds;
+    GUIntBig nCount = nItemCount;
+    GUIntBig nTotal = nItemCount;
+    anLevelEnds.push_back(nTotal);
+    while( nCount > 1 )
+    {
+        nCount = (nCount + nNodeSize - 1) / nNodeSize;
+        nTotal += nCount;
+        anLevelEnds.push_back(nTotal);
+    }
+    return anLevelEnds;
+}
+
+/************************************************************************/
+/*                            HilbertCode()                             */
+/************************************************************************/
+
+static GUInt32 HilbertCode( GUInt32 nX, GUInt32 nY )
+{
+    const GUInt32 N = 1U << 16;
+    GUInt32 nCode = 0;
+    for( GUInt32 nS = N / 2; nS > 0; nS /= 2 )
+    {
+        const GUInt32 nRX = (nX & nS) ? 1 : 0;
+        const GUInt32 nRY = (nY & nS) ? 1 : 0;
+        nCode += nS * nS * ((3 * nRX) ^ nRY);
+        if( nRY == 0 )
+        {
+            if( nRX == 1 )
+            {
+                nX = N - 1 - nX;
+                nY = N - 1 - nY;
+            }
+            std::swap(nX, nY);
+        }
+    }
+    return nCode;
+}
+
+/************************************************************************/
+/*                         Serialization helpers                        */
+/************************************************************************/
+
+namespace {
+
+void WriteUInt32( std::vector<GByte> &abyBuffer, GUInt32 nValue )
+{
+    CPL_LSBPTR32(&nValue);
+    const GByte *pabyValue = reinterpret_cast<const GByte *>(&nValue);
+    abyBuffer.insert(abyBuffer.end(), pabyValue, pabyValue + sizeof(nValue));
+}
+
+void WriteUInt64( std::vector<GByte> &abyBuffer, GUIntBig nValue )
+{
+    CPL_LSBPTR64(&nValue);
+    const GByte *pabyValue = reinterpret_cast<const GByte *>(&nValue);
+    abyBuffer.insert(abyBuffer.end(), pabyValue, pabyValue + sizeof(nValue));
+}
+
+void WriteDouble( std::vector<GByte> &abyBuffer, double dfValue )
+{
+    CPL_LSBPTR64(&dfValue);
+    const GByte *pabyValue = reinterpret_cast<const GByte *>(&dfValue);
+    abyBuffer.insert(abyBuffer.end(), pabyValue, pabyValue + sizeof(dfValue));
+}
+
+void WriteNode( std::vector<GByte> &abyBuffer,
+                const OGRSidecarSpatialIndex::Node &sNode )
+{
+    WriteDouble(abyBuffer, sNode.dfMinX);
+    WriteDouble(abyBuffer, sNode.dfMinY);
+    WriteDouble(abyBuffer, sNode.dfMaxX);
+    WriteDouble(abyBuffer, sNode.dfMaxY);
+    WriteUInt64(abyBuffer, sNode.nRef);
+}
+
+GUInt32 ReadUInt32( const GByte *pabyData )
+{
+    GUInt32 nValue = 0;
+    memcpy(&nValue, pabyData, sizeof(nValue));
+    CPL_LSBPTR32(&nValue);
+    return nValue;
+}
+
+GUIntBig ReadUInt64( const GByte *pabyData )
+{
+    GUIntBig nValue = 0;
+    memcpy(&nValue, pabyData, sizeof(nValue));
+    CPL_LSBPTR64(&nValue);
+    return nValue;
+}
+
+double ReadDouble( const GByte *pabyData )
+{
+    double dfValue = 0;
+    memcpy(&dfValue, pabyData, sizeof(dfValue));
+    CPL_LSBPTR64(&dfValue);
+    return dfValue;
+}
+
+void ReadNodes( const GByte *pabyData, size_t nCount,
+                OGRSidecarSpatialIndex::Node *pasNodes )
+{
+    for( size_t i = 0; i < nCount; i++ )
+    {
+        const GByte *pabyNode = pabyData + i * SIDX_NODE_BYTES;
+        pasNodes[i].dfMinX = ReadDouble(pabyNode);
+        pasNodes[i].dfMinY = ReadDouble(pabyNode + 8);
+        pasNodes[i].dfMaxX = ReadDouble(pabyNode + 16);
+        pasNodes[i].dfMaxY = ReadDouble(pabyNode + 24);
+        pasNodes[i].nRef = ReadUInt64(pabyNode + 32);
+    }
+}
+
+bool Intersects( const OGRSidecarSpatialIndex::Node &sNode,
+                 const OGREnvelope &sEnvelope )
+{
+    return !(sNode.dfMaxX < sEnvelope.MinX || sNode.dfMaxY < sEnvelope.MinY ||
+             sEnvelope.MaxX < sNode.dfMinX || sEnvelope.MaxY < sNode.dfMinY);
+}
+
+} // namespace
+
+/************************************************************************/
+/*                      ~OGRSidecarSpatialIndex()                       */
+/************************************************************************/
+
+OGRSidecarSpatialIndex::~OGRSidecarSpatialIndex()
+{
+    if( m_fp != nullptr )
+        VSIFCloseL(m_fp);
+}
+
+/************************************************************************/
+/*                            GetFilename()                             */
+/************************************************************************/
+
+CPLString OGRSidecarSpatialIndex::GetFilename( const char *pszDataFilename )
+{
+    return CPLString(pszDataFilename) + ".sidx";
+}
+
+/************************************************************************/
+/*                               Build()                                */
+/*                                                                      */
+/*      Writes the index of the items, which are reordered.             */
+/************************************************************************/
+
+bool OGRSidecarSpatialIndex::Build( const char *pszDataFilename,
+                                    const char *pszGeomFieldName,
+                                    std::vector<Item> &asItems )
+{
+    VSIStatBufL sStat;
+    if( VSIStatL(pszDataFilename, &sStat) != 0 )
+    {
+        CPLError(CE_Failure, CPLE_FileIO, "Cannot stat %s", pszDataFilename);
+        return false;
+    }
+
+/* -------------------------------------------------------------------- */
+/*      Sort the items along the Hilbert curve of their centers.        */
+/* -------------------------------------------------------------------- */
+    OGREnvelope sExtent;
+    for( const auto &sItem : asItems )
+        sExtent.Merge(sItem.sEnvelope);
+
+    const double dfWidth = sExtent.MaxX - sExtent.MinX;
+    const double dfHeight = sExtent.MaxY - sExtent.MinY;
+    const double dfMaxCoord = 65535.0;
+    std::vector<std::pair<GUInt32, size_t>> anCodes;
+    anCodes.reserve(asItems.size());
+    for( size_t i = 0; i < asItems.size(); i++ )
+    {
+        const OGREnvelope &sEnv = asItems[i].sEnvelope;
+        const double dfX = (sEnv.MinX + sEnv.MaxX) / 2 - sExtent.MinX;
+        const double dfY = (sEnv.MinY + sEnv.MaxY) / 2 - sExtent.MinY;
+        const GUInt32 nX = dfWidth > 0 ?
+            static_cast<GUInt32>(dfMaxCoord * dfX / dfWidth) : 0;
+        const GUInt32 nY = dfHeight > 0 ?
+            static_cast<GUInt32>(dfMaxCoord * dfY / dfHeight) : 0;
+        anCodes.push_back(std::make_pair(HilbertCode(nX, nY), i));
+    }
+    std::stable_sort(anCodes.begin(), anCodes.end(),
+                     [](const std::pair<GUInt32, size_t> &a,
+                        const std::pair<GUInt32, size_t> &b)
+                     { return a.first < b.first; });
+    {
+        std::vector<Item> asSorted;
+        asSorted.reserve(asItems.size());
+        for( const auto &oCode : anCodes )
+            asSorted.push_back(asItems[oCode.second]);
+        asItems.swap(asSorted);
+    }
+
+/* -------------------------------------------------------------------- */
+/*      Build the levels of the tree.                                   */
+/* -------------------------------------------------------------------- */
+    const GUIntBig nItemCount = asItems.size();
+    const std::vector<GUIntBig> anLevelEnds =
+        ComputeLevelEnds(nItemCount, SIDX_NODE_SIZE);
+    std::vector<Node> asNodes;
+    asNodes.reserve(static_cast<size_t>(anLevelEnds.back()));
+    for( const auto &sItem : asItems )
+    {
+        Node sNode;
+        sNode.dfMinX = sItem.sEnvelope.MinX;
+        sNode.dfMinY = sItem.sEnvelope.MinY;
+        sNode.dfMaxX = sItem.sEnvelope.MaxX;
+        sNode.dfMaxY = sItem.sEnvelope.MaxY;
+        sNode.nRef = static_cast<GUIntBig>(sItem.nFID);
+        asNodes.push_back(sNode);
+    }
+    for( size_t iLevel = 1; iLevel < anLevelEnds.size(); iLevel++ )
+    {
+        const size_t nChildStart = iLevel == 1 ? 0 :
+            static_cast<size_t>(anLevelEnds[iLevel - 2]);
+        const size_t nChildEnd = static_cast<size_t>(anLevelEnds[iLevel - 1]);
+        for( size_t i = nChildStart; i < nChildEnd; i += SIDX_NODE_SIZE )
+        {
+            Node sNode = asNodes[i];
+            sNode.nRef = i;
+            const size_t nEnd = std::min(i + SIDX_NODE_SIZE, nChildEnd);
+            for( size_t j = i + 1; j < nEnd; j++ )
+            {
+                sNode.dfMinX = std::min(sNode.dfMinX, asNodes[j].dfMinX);
+                sNode.dfMinY = std::min(sNode.dfMinY, asNodes[j].dfMinY);
+                sNode.dfMaxX = std::max(sNode.dfMaxX, asNodes[j].dfMaxX);
+                sNode.dfMaxY = std::max(sNode.dfMaxY, asNodes[j].dfMaxY);
+            }
+            asNodes.push_back(sNode);
+        }
+    }
+
+/* -------------------------------------------------------------------- */
+/*      Write the file.                                                 */
+/* -------------------------------------------------------------------- */
+    std::vector<GByte> abyBuffer(SIDX_MAGIC, SIDX_MAGIC + sizeof(SIDX_MAGIC));
+    WriteUInt32(abyBuffer, SIDX_VERSION);
+    WriteUInt32(abyBuffer, SIDX_NODE_SIZE);
+    WriteUInt64(abyBuffer, static_cast<GUIntBig>(sStat.st_size));
+    WriteUInt64(abyBuffer, static_cast<GUIntBig>(sStat.st_mtime));
+    WriteUInt64(abyBuffer, nItemCount);
+    const GUInt32 nNameLen = static_cast<GUInt32>(strlen(pszGeomFieldName));
+    WriteUInt32(abyBuffer, nNameLen);
+    abyBuffer.insert(abyBuffer.end(), pszGeomFieldName,
+                     pszGeomFieldName + nNameLen);
+    abyBuffer.resize((abyBuffer.size() + 7) / 8 * 8);
+    for( const auto &sNode : asNodes )
+        WriteNode(abyBuffer, sNode);
+    for( const auto &sItem : asItems )
+        WriteUInt64(abyBuffer, sItem.nOffset);
+
+    const CPLString osFilename(GetFilename(pszDataFilename));
+    VSILFILE *fp = VSIFOpenL(osFilename, "wb");
+    if( fp == nullptr )
+    {
+        CPLError(CE_Failure, CPLE_OpenFailed, "Cannot create %s",
+                 osFilename.c_str());
+        return false;
+    }
+    bool bOK = VSIFWriteL(abyBuffer.data(), abyBuffer.size(), 1, fp) == 1;
+    bOK &= VSIFCloseL(fp) == 0;
+    if( !bOK )
+    {
+        CPLError(CE_Failure, CPLE_FileIO, "Cannot write %s",
+                 osFilename.c_str());
+        VSIUnlink(osFilename);
+        return false;
+    }
+
+    CPLDebug("OGR", "Built spatial index %s of " CPL_FRMT_GUIB " features",
+             osFilename.c_str(), nItemCount);
+    return true;
+}
+
+/************************************************************************/
+/*                                Open()                                */
+/*                                                                      */
+/*      Returns nullptr if there is no index, or if it is out of date   */
+/*      or for another geometry field.                                  */
+/************************************************************************/
+
+OGRSidecarSpatialIndex *
+OGRSidecarSpatialIndex::Open( const char *pszDataFilename,
+                              const char *pszGeomFieldName )
+{
+    const CPLString osFilename(GetFilename(pszDataFilename));
+    VSIStatBufL sStat;
+    VSIStatBufL sDataStat;
+    if( VSIStatExL(osFilename, &sStat, VSI_STAT_EXISTS_FLAG) != 0 ||
+        VSIStatL(pszDataFilename, &sDataStat) != 0 )
+        return nullptr;
+
+    VSILFILE *fp = VSIFOpenL(osFilename, "rb");
+    if( fp == nullptr )
+        return nullptr;
+
+    OGRSidecarSpatialIndex *poIndex = new OGRSidecarSpatialIndex();
+    poIndex->m_osFilename = osFilename;
+    poIndex->m_fp = fp;
+
+    GByte abyHeader[44];
+    if( VSIFReadL(abyHeader, sizeof(abyHeader), 1, fp) != 1 ||
+        memcmp(abyHeader, SIDX_MAGIC, sizeof(SIDX_MAGIC)) != 0 ||
+        ReadUInt32(abyHeader + 8) != SIDX_VERSION )
+    {
+        CPLDebug("OGR", "%s is not a valid spatial index", osFilename.c_str());
+        delete poIndex;
+        return nullptr;
+    }
+
+    poIndex->m_nNodeSize = static_cast<int>(ReadUInt32(abyHeader + 12));
+    const GUIntBig nSourceSize = ReadUInt64(abyHeader + 16);
+    const GIntBig nSourceMTime = static_cast<GIntBig>(ReadUInt64(abyHeader + 24));
+    poIndex->m_nItemCount = ReadUInt64(abyHeader + 32);
+    const GUInt32 nNameLen = ReadUInt32(abyHeader + 40);
+
+    if( nSourceSize != static_cast<GUIntBig>(sDataStat.st_size) ||
+        nSourceMTime != static_cast<GIntBig>(sDataStat.st_mtime) )
+    {
+        CPLDebug("OGR", "%s is out of date", osFilename.c_str());
+        delete poIndex;
+        return nullptr;
+    }
+
+    if( poIndex->m_nNodeSize < 2 || nNameLen > 1024 * 1024 ||
+        poIndex->m_nItemCount >
+            static_cast<GUIntBig>(sStat.st_size) / SIDX_NODE_BYTES )
+    {
+        CPLDebug("OGR", "%s is corrupted", osFilename.c_str());
+        delete poIndex;
+        return nullptr;
+    }
+
+    CPLString osName;
+    osName.resize(nNameLen);
+    if( nNameLen > 0 && VSIFReadL(&osName[0], nNameLen, 1, fp) != 1 )
+    {
+        delete poIndex;
+        return nullptr;
+    }
+    if( osName != pszGeomFieldName )
+    {
+        CPLDebug("OGR", "%s indexes geometry field %s",
+                 osFilename.c_str(), osName.c_str());
+        delete poIndex;
+        return nullptr;
+    }
+
+    poIndex->m_anLevelEnds =
+        ComputeLevelEnds(poIndex->m_nItemCount, poIndex->m_nNodeSize);
+    const GUIntBig nNodeCount = poIndex->m_anLevelEnds.back();
+    poIndex->m_nNodesOffset = (sizeof(abyHeader) + nNameLen + 7) / 8 * 8;
+    poIndex->m_nOffsetsOffset =
+        poIndex->m_nNodesOffset + nNodeCount * SIDX_NODE_BYTES;
+    if( poIndex->m_nOffsetsOffset + poIndex->m_nItemCount * 8 >
+            static_cast<vsi_l_offset>(sStat.st_size) )
+    {
+        CPLDebug("OGR", "%s is truncated", osFilename.c_str());
+        delete poIndex;
+        return nullptr;
+    }
+
+/* -------------------------------------------------------------------- */
+/*      Load the upper levels of the tree, the items being read on      */
+/*      demand.                                                         */
+/* -------------------------------------------------------------------- */
+    const size_t nUpperCount =
+        static_cast<size_t>(nNodeCount - poIndex->m_nItemCount);
+    if( nUpperCount > 0 )
+    {
+        std::vector<GByte> abyNodes(nUpperCount * SIDX_NODE_BYTES);
+        poIndex->m_asUpperNodes.resize(nUpperCount);
+        if( VSIFSeekL(fp, poIndex->m_nNodesOffset +
+                          poIndex->m_nItemCount * SIDX_NODE_BYTES,
+                      SEEK_SET) != 0 ||
+            VSIFReadL(abyNodes.data(), abyNodes.size(), 1, fp) != 1 )
+        {
+            delete poIndex;
+            return nullptr;
+        }
+        ReadNodes(abyNodes.data(), nUpperCount,
+                  poIndex->m_asUpperNodes.data());
+    }
+
+    // Search() follows the child references without checking them, so
+    // make sure that each node points to its own children in the level
+    // below, as written by Build().
+    const std::vector<GUIntBig> &anLevelEnds = poIndex->m_anLevelEnds;
+    for( size_t iLevel = 1; iLevel < anLevelEnds.size(); iLevel++ )
+    {
+        const GUIntBig nChildStart = iLevel == 1 ? 0 : anLevelEnds[iLevel - 2];
+        for( GUIntBig i = anLevelEnds[iLevel - 1]; i < anLevelEnds[iLevel];
+             i++ )
+        {
+            const GUIntBig nExpectedRef = nChildStart +
+                (i - anLevelEnds[iLevel - 1]) * poIndex->m_nNodeSize;
+            if( poIndex->m_asUpperNodes[
+                    static_cast<size_t>(i - poIndex->m_nItemCount)].nRef !=
+                        nExpectedRef )
+            {
+                CPLDebug("OGR", "%s is corrupted", osFilename.c_str());
+                delete poIndex;
+                return nullptr;
+            }
+        }
+    }
+
+    return poIndex;
+}
+
+/************************************************************************/
+/*                                Drop()                                */
+/************************************************************************/
+
+bool OGRSidecarSpatialIndex::Drop( const char *pszDataFilename )
+{
+    const CPLString osFilename(GetFilename(pszDataFilename));
+    VSIStatBufL sStat;
+    if( VSIStatExL(osFilename, &sStat, VSI_STAT_EXISTS_FLAG) != 0 )
+        return false;
+    return VSIUnlink(osFilename) == 0;
+}
+
+/************************************************************************/
+/*                             ReadLeaves()                             */
+/*                                                                      */
+/*      Reads a run of items and their offsets.                         */
+/************************************************************************/
+
+bool OGRSidecarSpatialIndex::ReadLeaves( GUIntBig nFirst, int nCount )
+{
+    GByte abyNodes[SIDX_NODE_BYTES * 64];
+    GByte abyOffsets[8 * 64];
+    CPLAssert( nCount <= 64 );
+
+    m_asLeafBuffer.resize(nCount);
+    m_anOffsetBuffer.resize(nCount);
+    if( VSIFSeekL(m_fp, m_nNodesOffset + nFirst * SIDX_NODE_BYTES,
+                  SEEK_SET) != 0 ||
+        VSIFReadL(abyNodes, SIDX_NODE_BYTES * nCount, 1, m_fp) != 1 ||
+        VSIFSeekL(m_fp, m_nOffsetsOffset + nFirst * 8, SEEK_SET) != 0 ||
+        VSIFReadL(abyOffsets, 8 * nCount, 1, m_fp) != 1 )
+    {
+        CPLError(CE_Failure, CPLE_FileIO, "Cannot read %s",
+                 m_osFilename.c_str());
+        return false;
+    }
+    ReadNodes(abyNodes, nCount, m_asLeafBuffer.data());
+    for( int i = 0; i < nCount; i++ )
+        m_anOffsetBuffer[i] = ReadUInt64(abyOffsets + 8 * i);
+    return true;
+}
+
+/************************************************************************/
+/*                               Search()                               */
+/*                                                                      */
+/*      Returns the items whose envelope intersects the passed one,     */
+/*      sorted by increasing offset, then FID.                          */
+/************************************************************************/
+
+bool OGRSidecarSpatialIndex::Search( const OGREnvelope &sEnvelope,
+                                     std::vector<Item> &asResults )
+{
+    asResults.clear();
+    if( m_nItemCount == 0 )
+        return true;
+
+    // Only an index with a single item has no upper level.
+    if( m_anLevelEnds.size() == 1 )
+    {
+        if( !ReadLeaves(0, 1) )
+            return false;
+        if( Intersects(m_asLeafBuffer[0], sEnvelope) )
+        {
+            Item sItem;
+            sItem.sEnvelope.MinX = m_asLeafBuffer[0].dfMinX;
+            sItem.sEnvelope.MinY = m_asLeafBuffer[0].dfMinY;
+            sItem.sEnvelope.MaxX = m_asLeafBuffer[0].dfMaxX;
+            sItem.sEnvelope.MaxY = m_asLeafBuffer[0].dfMaxY;
+            sItem.nFID = static_cast<GIntBig>(m_asLeafBuffer[0].nRef);
+            sItem.nOffset = m_anOffsetBuffer[0];
+            asResults.push_back(sItem);
+        }
+        return true;
+    }
+
+    // Stack of (level, index in the node array) of the nodes to visit.
+    std::vector<std::pair<size_t, GUIntBig>> aoStack;
+    const size_t nRootLevel = m_anLevelEnds.size() - 1;
+    const GUIntBig nRoot = m_anLevelEnds.back() - 1;
+    if( Intersects(m_asUpperNodes[static_cast<size_t>(nRoot - m_nItemCount)],
+                   sEnvelope) )
+        aoStack.push_back(std::make_pair(nRootLevel, nRoot));
+
+    while( !aoStack.empty() )
+    {
+        const size_t nLevel = aoStack.back().first;
+        const Node &sNode =
+            m_asUpperNodes[static_cast<size_t>(aoStack.back().second -
+                                               m_nItemCount)];
+        aoStack.pop_back();
+
+        const GUIntBig nFirstChild = sNode.nRef;
+        const GUIntBig nLastChild =
+            std::min(nFirstChild + m_nNodeSize, m_anLevelEnds[nLevel - 1]);
+        if( nLevel == 1 )
+        {
+            int nRemaining = static_cast<int>(nLastChild - nFirstChild);
+            GUIntBig nFirst = nFirstChild;
+            while( nRemaining > 0 )
+            {
+                const int nCount = std::min(nRemaining, 64);
+                if( !ReadLeaves(nFirst, nCount) )
+                    return false;
+                for( int i = 0; i < nCount; i++ )
+                {
+                    const Node &sLeaf = m_asLeafBuffer[i];
+                    if( !Intersects(sLeaf, sEnvelope) )
+                        continue;
+                    Item sItem;
+                    sItem.sEnvelope.MinX = sLeaf.dfMinX;
+                    sItem.sEnvelope.MinY = sLeaf.dfMinY;
+                    sItem.sEnvelope.MaxX = sLeaf.dfMaxX;
+                    sItem.sEnvelope.MaxY = sLeaf.dfMaxY;
+                    sItem.nFID = static_cast<GIntBig>(sLeaf.nRef);
+                    sItem.nOffset = m_anOffsetBuffer[i];
+                    asResults.push_back(sItem);
+                }
+                nFirst += nCount;
+                nRemaining -= nCount;
+            }
+        }
+        else
+        {
+            for( GUIntBig i = nFirstChild; i < nLastChild; i++ )
+            {
+                if( Intersects(
+                        m_asUpperNodes[static_cast<size_t>(i - m_nItemCount)],
+                        sEnvelope) )
+                {
+                    aoStack.push_back(std::make_pair(nLevel - 1, i));
+                }
+            }
+        }
+    }
+
+    std::sort(asResults.begin(), asResults.end(),
+              [](const Item &a, const Item &b)
+              {
+                  if( a.nOffset != b.nOffset )
+                      return a.nOffset < b.nOffset;
+                  return a.nFID < b.nFID;
+              });
+    return true;
+}
+
+//! @endcond
@@ -0,0 +1,107 @@
+/******************************************************************************
+ * $Id$
+ *
+ * Project:  OpenGIS Simple Features Reference Implementation
+ * Purpose:  Persistent spatial index stored next to a data file, for
+ *           drivers without a native spatial index.
+ *
+ ******************************************************************************
+ * Copyright (c) 2018, GDAL contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ ****************************************************************************/
+
+#ifndef OGRSIDECARSPATIALINDEX_H_INCLUDED
+#define OGRSIDECARSPATIALINDEX_H_INCLUDED
+
+#include "cpl_string.h"
+#include "cpl_vsi.h"
+#include "ogr_core.h"
+
+#include <vector>
+
+/*! @cond Doxygen_Suppress */
+
+/************************************************************************/
+/*                        OGRSidecarSpatialIndex                        */
+/*                                                                      */
+/*      Packed Hilbert R-tree of the envelopes of the features of a     */
+/*      layer, stored in a <data file>.sidx file.  Each item records    */
+/*      the FID of a feature and an optional driver specific offset,    */
+/*      typically the position of the feature in the data file.  The    */
+/*      index records the size and modification time of the data       */
+/*      file, and is ignored once the data file has changed.            */
+/************************************************************************/
+
+class CPL_DLL OGRSidecarSpatialIndex
+{
+  public:
+    struct Item
+    {
+        OGREnvelope     sEnvelope{};
+        GIntBig         nFID = 0;
+        GUIntBig        nOffset = 0;
+    };
+
+    struct Node
+    {
+        double          dfMinX;
+        double          dfMinY;
+        double          dfMaxX;
+        double          dfMaxY;
+        GUIntBig        nRef;
+    };
+
+  private:
+    CPLString           m_osFilename{};
+    VSILFILE           *m_fp = nullptr;
+    GUIntBig            m_nItemCount = 0;
+    int                 m_nNodeSize = 0;
+    vsi_l_offset        m_nNodesOffset = 0;
+    vsi_l_offset        m_nOffsetsOffset = 0;
+    std::vector<GUIntBig> m_anLevelEnds{};
+    std::vector<Node>   m_asUpperNodes{};
+    std::vector<Node>   m_asLeafBuffer{};
+    std::vector<GUIntBig> m_anOffsetBuffer{};
+
+    OGRSidecarSpatialIndex() = default;
+
+    bool                ReadLeaves( GUIntBig nFirst, int nCount );
+
+    CPL_DISALLOW_COPY_ASSIGN(OGRSidecarSpatialIndex)
+
+  public:
+                       ~OGRSidecarSpatialIndex();
+
+    static CPLString    GetFilename( const char *pszDataFilename );
+    static bool         Build( const char *pszDataFilename,
+                               const char *pszGeomFieldName,
+                               std::vector<Item> &asItems );
+    static OGRSidecarSpatialIndex *Open( const char *pszDataFilename,
+                                         const char *pszGeomFieldName );
+    static bool         Drop( const char *pszDataFilename );
+
+    GUIntBig            GetItemCount() const { return m_nItemCount; }
+    bool                Search( const OGREnvelope &sEnvelope,
+                                std::vector<Item> &asResults );
+};
+
+/*! @endcond */
+
+#endif /* ndef OGRSIDECARSPATIALINDEX_H_INCLUDED */
@@ -210,6 +210,27 @@ OGRFeature *OGRWarpedLayer::WarpedFeatureToSrcFeature(OGRFeature* poFeature)
     return poSrcFeature;
 }
 
+/************************************************************************/
+/*                        GetNextFeatureBatch()                         */
+/************************************************************************/
+
+int OGRWarpedLayer::GetNextFeatureBatch( OGRFeatureBatch* poBatch,
+                                         int nMaxRows )
+{
+    // Geometries must be reprojected: go through GetNextFeature().
+    return OGRLayer::GetNextFeatureBatch(poBatch, nMaxRows);
+}
+
+/************************************************************************/
+/*                          FillNextFeature()                           */
+/************************************************************************/
+
+int OGRWarpedLayer::FillNextFeature( OGRFeature* poFeature )
+{
+    // Geometries must be reprojected: go through GetNextFeature().
+    return OGRLayer::FillNextFeature(poFeature);
+}
+
 /************************************************************************/
 /*                          GetNextFeature()                            */
 /************************************************************************/
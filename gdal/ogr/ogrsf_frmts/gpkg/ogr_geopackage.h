@@ -365,7 +365,11 @@ class OGRGeoPackageLayer : public OGRLayer, public IOGRSQLiteGetSpatialWhere
     void                BuildFeatureDefn( const char *pszLayerName,
                                            sqlite3_stmt *hStmt );
 
-    OGRFeature*         TranslateFeature(sqlite3_stmt* hStmt);
+    OGRFeature*         TranslateFeature(sqlite3_stmt* hStmt,
+                                         OGRFeature* poReusedFeature = nullptr);
+    OGRFeature*         GetNextFeatureInternal(OGRFeature* poReusedFeature);
+    void                TranslateFeatureBatch(sqlite3_stmt* hStmt,
+                                              OGRFeatureBatch* poBatch);
 
   public:
 
@@ -375,6 +379,9 @@ class OGRGeoPackageLayer : public OGRLayer, public IOGRSQLiteGetSpatialWhere
     /* OGR API methods */
 
     OGRFeature*         GetNextFeature() override;
+    int                 GetNextFeatureBatch( OGRFeatureBatch* poBatch,
+                                             int nMaxRows ) override;
+    int                 FillNextFeature( OGRFeature* poFeature ) override;
     const char*         GetFIDColumn() override;
     void                ResetReading() override;
     int                 TestCapability( const char * ) override;
@@ -481,6 +488,9 @@ class OGRGeoPackageTableLayer final : public OGRGeoPackageLayer
     OGRErr              SetAttributeFilter( const char *pszQuery ) override;
     OGRErr              SyncToDisk() override;
     OGRFeature*         GetNextFeature() override;
+    int                 GetNextFeatureBatch( OGRFeatureBatch* poBatch,
+                                             int nMaxRows ) override;
+    int                 FillNextFeature( OGRFeature* poFeature ) override;
     OGRFeature*         GetFeature(GIntBig nFID) override;
     OGRErr              StartTransaction() override;
     OGRErr              CommitTransaction() override;
@@ -598,6 +608,9 @@ class OGRGeoPackageSelectLayer final : public OGRGeoPackageLayer, public IOGRSQL
     virtual void        ResetReading() override;
 
     virtual OGRFeature *GetNextFeature() override;
+    virtual int         GetNextFeatureBatch( OGRFeatureBatch* poBatch,
+                                             int nMaxRows ) override;
+    virtual int         FillNextFeature( OGRFeature* poFeature ) override;
     virtual GIntBig     GetFeatureCount( int ) override;
 
     virtual void        SetSpatialFilter( OGRGeometry * poGeom ) override { SetSpatialFilter(0, poGeom); }
@@ -100,6 +100,34 @@ void OGRGeoPackageLayer::ClearStatement()
 
 OGRFeature *OGRGeoPackageLayer::GetNextFeature()
 
+{
+    return GetNextFeatureInternal(nullptr);
+}
+
+/************************************************************************/
+/*                          FillNextFeature()                           */
+/************************************************************************/
+
+int OGRGeoPackageLayer::FillNextFeature( OGRFeature* poFeature )
+
+{
+    if( poFeature->GetDefnRef() != m_poFeatureDefn )
+        return OGRLayer::FillNextFeature(poFeature);
+
+    return GetNextFeatureInternal(poFeature) != nullptr;
+}
+
+/************************************************************************/
+/*                       GetNextFeatureInternal()                       */
+/*                                                                      */
+/*      Return the next feature matching the filters.  If               */
+/*      poReusedFeature is not NULL, it is refilled and returned        */
+/*      instead of a new feature.                                       */
+/************************************************************************/
+
+OGRFeature *OGRGeoPackageLayer::GetNextFeatureInternal(
+    OGRFeature* poReusedFeature )
+
 {
     for( ; true; )
     {
@@ -136,7 +164,8 @@ OGRFeature *OGRGeoPackageLayer::GetNextFeature()
             bDoStep = true;
         }
 
-        OGRFeature *poFeature = TranslateFeature(m_poQueryStatement);
+        OGRFeature *poFeature =
+            TranslateFeature(m_poQueryStatement, poReusedFeature);
 
         if( (m_poFilterGeom == nullptr
             || FilterGeometry( poFeature->GetGeomFieldRef(m_iGeomFieldFilter) ) )
@@ -144,21 +173,57 @@ OGRFeature *OGRGeoPackageLayer::GetNextFeature()
                 || m_poAttrQuery->Evaluate( poFeature )) )
             return poFeature;
 
-        delete poFeature;
+        if( poFeature != poReusedFeature )
+            delete poFeature;
+    }
+}
+
+/************************************************************************/
+/*                       ImportGPkgGeometryInto()                       */
+/*                                                                      */
+/*      Import a GeoPackage geometry blob into an existing geometry of  */
+/*      the same type, so that its coordinate arrays are reused.        */
+/************************************************************************/
+
+static bool ImportGPkgGeometryInto( const GByte* pabyGpkg, size_t nGpkgLen,
+                                    OGRGeometry* poGeom )
+{
+    GPkgHeader oHeader;
+    if( GPkgHeaderFromWKB(pabyGpkg, nGpkgLen, &oHeader) != OGRERR_NONE )
+        return false;
+
+    const GByte* pabyWkb = pabyGpkg + oHeader.nHeaderLen;
+    const size_t nWkbLen = nGpkgLen - oHeader.nHeaderLen;
+    OGRwkbGeometryType eType = wkbUnknown;
+    if( nWkbLen < 5 ||
+        OGRReadWKBGeometryType(pabyWkb, wkbVariantOldOgc,
+                               &eType) != OGRERR_NONE ||
+        eType != poGeom->getGeometryType() )
+    {
+        return false;
     }
+
+    return poGeom->importFromWkb(pabyWkb, static_cast<int>(nWkbLen),
+                                 wkbVariantOldOgc) == OGRERR_NONE;
 }
 
 /************************************************************************/
 /*                         TranslateFeature()                           */
+/*                                                                      */
+/*      If poReusedFeature is not NULL, it is refilled and returned     */
+/*      instead of a new feature, reusing its geometry and field        */
+/*      buffers when possible.                                          */
 /************************************************************************/
 
-OGRFeature *OGRGeoPackageLayer::TranslateFeature( sqlite3_stmt* hStmt )
+OGRFeature *OGRGeoPackageLayer::TranslateFeature( sqlite3_stmt* hStmt,
+                                                  OGRFeature* poReusedFeature )
 
 {
 /* -------------------------------------------------------------------- */
 /*      Create a feature from the current result.                       */
 /* -------------------------------------------------------------------- */
-    OGRFeature *poFeature = new OGRFeature( m_poFeatureDefn );
+    OGRFeature *poFeature = poReusedFeature != nullptr ?
+        poReusedFeature : new OGRFeature( m_poFeatureDefn );
 
 /* -------------------------------------------------------------------- */
 /*      Set FID if we have a column to set it from.                     */
@@ -192,19 +257,35 @@ OGRFeature *OGRGeoPackageLayer::TranslateFeature( sqlite3_stmt* hStmt )
             int iGpkgSize = sqlite3_column_bytes(hStmt, iGeomCol);
             // coverity[tainted_data_return]
             GByte *pabyGpkg = (GByte *)sqlite3_column_blob(hStmt, iGeomCol);
-            OGRGeometry *poGeom = GPkgGeometryToOGR(pabyGpkg, iGpkgSize, nullptr);
-            if ( poGeom == nullptr )
+            OGRGeometry *poReusedGeom = poReusedFeature != nullptr ?
+                poReusedFeature->GetGeometryRef() : nullptr;
+            if( poReusedGeom != nullptr &&
+                ImportGPkgGeometryInto(pabyGpkg, iGpkgSize, poReusedGeom) )
             {
-                // Try also spatialite geometry blobs
-                if( OGRSQLiteLayer::ImportSpatiaLiteGeometry( pabyGpkg, iGpkgSize,
-                                                              &poGeom ) != OGRERR_NONE )
+                poReusedGeom->assignSpatialReference(poSrs);
+            }
+            else
+            {
+                OGRGeometry *poGeom =
+                    GPkgGeometryToOGR(pabyGpkg, iGpkgSize, nullptr);
+                if ( poGeom == nullptr )
                 {
-                    CPLError( CE_Failure, CPLE_AppDefined, "Unable to read geometry");
+                    // Try also spatialite geometry blobs
+                    if( OGRSQLiteLayer::ImportSpatiaLiteGeometry(
+                            pabyGpkg, iGpkgSize, &poGeom ) != OGRERR_NONE )
+                    {
+                        CPLError( CE_Failure, CPLE_AppDefined,
+                                  "Unable to read geometry");
+                    }
                 }
+                if( poGeom != nullptr )
+                    poGeom->assignSpatialReference(poSrs);
+                poFeature->SetGeometryDirectly( poGeom );
             }
-            if( poGeom != nullptr )
-                poGeom->assignSpatialReference(poSrs);
-            poFeature->SetGeometryDirectly( poGeom );
+        }
+        else if( poReusedFeature != nullptr )
+        {
+            poFeature->SetGeometryDirectly( nullptr );
         }
     }
 
@@ -215,7 +296,11 @@ OGRFeature *OGRGeoPackageLayer::TranslateFeature( sqlite3_stmt* hStmt )
     {
         OGRFieldDefn *poFieldDefn = m_poFeatureDefn->GetFieldDefn( iField );
         if ( poFieldDefn->IsIgnored() )
+        {
+            if( poReusedFeature != nullptr )
+                poFeature->UnsetField( iField );
             continue;
+        }
 
         const int iRawField = panFieldOrdinals[iField];
 
@@ -259,6 +344,8 @@ OGRFeature *OGRGeoPackageLayer::TranslateFeature( sqlite3_stmt* hStmt )
                 int nYear, nMonth, nDay;
                 if( sscanf(pszTxt, "%d-%d-%d", &nYear, &nMonth, &nDay) == 3 )
                     poFeature->SetField(iField, nYear, nMonth, nDay, 0, 0, 0, 0);
+                else if( poReusedFeature != nullptr )
+                    poFeature->UnsetField( iField );
                 break;
             }
 
@@ -268,6 +355,8 @@ OGRFeature *OGRGeoPackageLayer::TranslateFeature( sqlite3_stmt* hStmt )
                 OGRField sField;
                 if( OGRParseXMLDateTime(pszTxt, &sField) )
                     poFeature->SetField(iField, &sField);
+                else if( poReusedFeature != nullptr )
+                    poFeature->UnsetField( iField );
                 break;
             }
 
@@ -284,6 +373,220 @@ OGRFeature *OGRGeoPackageLayer::TranslateFeature( sqlite3_stmt* hStmt )
     return poFeature;
 }
 
+/************************************************************************/
+/*                        GetNextFeatureBatch()                         */
+/************************************************************************/
+
+int OGRGeoPackageLayer::GetNextFeatureBatch( OGRFeatureBatch* poBatch,
+                                             int nMaxRows )
+
+{
+    if( m_poFilterGeom != nullptr || m_poAttrQuery != nullptr ||
+        poBatch->GetDefn() != m_poFeatureDefn )
+    {
+        return OGRLayer::GetNextFeatureBatch(poBatch, nMaxRows);
+    }
+
+    poBatch->Reset();
+    while( poBatch->GetRowCount() < nMaxRows )
+    {
+        if( m_poQueryStatement == nullptr )
+        {
+            ResetStatement();
+            if (m_poQueryStatement == nullptr)
+                break;
+        }
+
+        if( bDoStep )
+        {
+            int rc = sqlite3_step( m_poQueryStatement );
+            if( rc != SQLITE_ROW )
+            {
+                if ( rc != SQLITE_DONE )
+                {
+                    sqlite3_reset(m_poQueryStatement);
+                    CPLError( CE_Failure, CPLE_AppDefined,
+                            "In GetNextFeatureBatch(): sqlite3_step() : %s",
+                            sqlite3_errmsg(m_poDS->GetDB()) );
+                }
+
+                ClearStatement();
+                break;
+            }
+        }
+        else
+        {
+            bDoStep = true;
+        }
+
+        TranslateFeatureBatch(m_poQueryStatement, poBatch);
+    }
+
+    return poBatch->GetRowCount();
+}
+
+/************************************************************************/
+/*                        IsLittleEndianISOWKB()                        */
+/*                                                                      */
+/*      Whether a WKB blob is little endian and uses the ISO geometry   */
+/*      type codes, as written by the driver, and can thus be copied    */
+/*      as it is into a feature batch.                                  */
+/************************************************************************/
+
+static bool IsLittleEndianISOWKB( const GByte* pabyWkb, size_t nWkbLen )
+{
+    if( nWkbLen < 5 || pabyWkb[0] != wkbNDR )
+        return false;
+    GUInt32 nType = 0;
+    memcpy(&nType, pabyWkb + 1, 4);
+    CPL_LSBPTR32(&nType);
+    return nType < 4000 &&
+           nType % 1000 >= wkbPoint && nType % 1000 <= wkbTriangle;
+}
+
+/************************************************************************/
+/*                       TranslateFeatureBatch()                        */
+/*                                                                      */
+/*      Same as TranslateFeature(), but appends the current result     */
+/*      to a feature batch.                                             */
+/************************************************************************/
+
+void OGRGeoPackageLayer::TranslateFeatureBatch( sqlite3_stmt* hStmt,
+                                                OGRFeatureBatch* poBatch )
+
+{
+    GIntBig nFID = iNextShapeId;
+    if( iFIDCol >= 0 )
+    {
+        nFID = sqlite3_column_int64( hStmt, iFIDCol );
+        if( m_pszFidColumn == nullptr && nFID == 0 )
+        {
+            // Miht be the case for views with joins.
+            nFID = iNextShapeId;
+        }
+    }
+    poBatch->AddRow( nFID );
+
+    iNextShapeId++;
+
+    m_nFeaturesRead++;
+
+/* -------------------------------------------------------------------- */
+/*      Process Geometry if we have a column.                           */
+/* -------------------------------------------------------------------- */
+    if( iGeomCol >= 0 &&
+        sqlite3_column_type(hStmt, iGeomCol) != SQLITE_NULL &&
+        !m_poFeatureDefn->GetGeomFieldDefn(0)->IsIgnored() )
+    {
+        const int iGpkgSize = sqlite3_column_bytes(hStmt, iGeomCol);
+        // coverity[tainted_data_return]
+        const GByte *pabyGpkg = static_cast<const GByte*>(
+            sqlite3_column_blob(hStmt, iGeomCol));
+        GPkgHeader oHeader;
+        if( GPkgHeaderFromWKB(pabyGpkg, iGpkgSize, &oHeader) == OGRERR_NONE &&
+            !oHeader.bEmpty &&
+            IsLittleEndianISOWKB(pabyGpkg + oHeader.nHeaderLen,
+                                 iGpkgSize - oHeader.nHeaderLen) )
+        {
+            // The GeoPackage stores ISO WKB: copy it as it is
+            poBatch->SetGeometryWkb( 0, pabyGpkg + oHeader.nHeaderLen,
+                                     iGpkgSize - oHeader.nHeaderLen );
+        }
+        else
+        {
+            OGRGeometry *poGeom =
+                GPkgGeometryToOGR(pabyGpkg, iGpkgSize, nullptr);
+            if ( poGeom == nullptr )
+            {
+                // Try also spatialite geometry blobs
+                if( OGRSQLiteLayer::ImportSpatiaLiteGeometry( pabyGpkg,
+                                                              iGpkgSize,
+                                                              &poGeom ) !=
+                                                                OGRERR_NONE )
+                {
+                    CPLError( CE_Failure, CPLE_AppDefined,
+                              "Unable to read geometry");
+                }
+            }
+            poBatch->SetGeometry( 0, poGeom );
+            delete poGeom;
+        }
+    }
+
+/* -------------------------------------------------------------------- */
+/*      set the fields.                                                 */
+/* -------------------------------------------------------------------- */
+    for( int iField = 0; iField < m_poFeatureDefn->GetFieldCount(); iField++ )
+    {
+        OGRFieldDefn *poFieldDefn = m_poFeatureDefn->GetFieldDefn( iField );
+        if ( poFieldDefn->IsIgnored() )
+            continue;
+
+        const int iRawField = panFieldOrdinals[iField];
+
+        if( sqlite3_column_type( hStmt, iRawField ) == SQLITE_NULL )
+            continue;
+
+        switch( poFieldDefn->GetType() )
+        {
+            case OFTInteger:
+                poBatch->SetFieldInteger( iField,
+                    sqlite3_column_int( hStmt, iRawField ) );
+                break;
+
+            case OFTInteger64:
+                poBatch->SetFieldInteger64( iField,
+                    sqlite3_column_int64( hStmt, iRawField ) );
+                break;
+
+            case OFTReal:
+                poBatch->SetFieldDouble( iField,
+                    sqlite3_column_double( hStmt, iRawField ) );
+                break;
+
+            case OFTBinary:
+            {
+                const int nBytes = sqlite3_column_bytes( hStmt, iRawField );
+                // coverity[tainted_data_return]
+                const GByte* pabyData = reinterpret_cast<const GByte*>(
+                    sqlite3_column_blob( hStmt, iRawField ) );
+                poBatch->SetFieldBinary( iField, pabyData, nBytes );
+                break;
+            }
+
+            case OFTDate:
+            {
+                const char* pszTxt = (const char*)sqlite3_column_text( hStmt, iRawField );
+                int nYear, nMonth, nDay;
+                if( sscanf(pszTxt, "%d-%d-%d", &nYear, &nMonth, &nDay) == 3 )
+                    poBatch->SetFieldDateTime(iField, nYear, nMonth, nDay);
+                break;
+            }
+
+            case OFTDateTime:
+            {
+                const char* pszTxt = (const char*)sqlite3_column_text( hStmt, iRawField );
+                OGRField sField;
+                if( OGRParseXMLDateTime(pszTxt, &sField) )
+                    poBatch->SetFieldRaw(iField, &sField);
+                break;
+            }
+
+            case OFTString:
+            {
+                const char* pszTxt = reinterpret_cast<const char*>(
+                    sqlite3_column_text( hStmt, iRawField ) );
+                const int nBytes = sqlite3_column_bytes( hStmt, iRawField );
+                poBatch->SetFieldString( iField, pszTxt, nBytes );
+                break;
+            }
+
+            default:
+                break;
+        }
+    }
+}
+
 /************************************************************************/
 /*                      GetFIDColumn()                                  */
 /************************************************************************/
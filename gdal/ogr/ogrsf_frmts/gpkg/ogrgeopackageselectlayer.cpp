@@ -84,6 +84,28 @@ OGRFeature *OGRGeoPackageSelectLayer::GetNextFeature()
     return poBehaviour->GetNextFeature();
 }
 
+/************************************************************************/
+/*                        GetNextFeatureBatch()                         */
+/************************************************************************/
+
+int OGRGeoPackageSelectLayer::GetNextFeatureBatch( OGRFeatureBatch* poBatch,
+                                                   int nMaxRows )
+{
+    // Filters may be evaluated by the common behaviour: go through
+    // GetNextFeature().
+    return OGRLayer::GetNextFeatureBatch(poBatch, nMaxRows);
+}
+
+/************************************************************************/
+/*                          FillNextFeature()                           */
+/************************************************************************/
+
+int OGRGeoPackageSelectLayer::FillNextFeature( OGRFeature* poFeature )
+{
+    // Same as GetNextFeatureBatch().
+    return OGRLayer::FillNextFeature(poFeature);
+}
+
 /************************************************************************/
 /*                           GetNextFeature()                           */
 /************************************************************************/
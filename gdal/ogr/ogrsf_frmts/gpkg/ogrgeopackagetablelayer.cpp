@@ -2103,6 +2103,50 @@ OGRFeature* OGRGeoPackageTableLayer::GetNextFeature()
     return poFeature;
 }
 
+/************************************************************************/
+/*                        GetNextFeatureBatch()                         */
+/************************************************************************/
+
+int OGRGeoPackageTableLayer::GetNextFeatureBatch( OGRFeatureBatch* poBatch,
+                                                  int nMaxRows )
+{
+    if( !m_bFeatureDefnCompleted )
+        GetLayerDefn();
+    if( m_bDeferredCreation && RunDeferredCreationIfNecessary() != OGRERR_NONE )
+    {
+        poBatch->Reset();
+        return 0;
+    }
+
+    CreateSpatialIndexIfNecessary();
+
+    // The FID column, when exposed as a regular field, is read from the
+    // same column as the FID, so nothing to patch here.
+    return OGRGeoPackageLayer::GetNextFeatureBatch(poBatch, nMaxRows);
+}
+
+/************************************************************************/
+/*                          FillNextFeature()                           */
+/************************************************************************/
+
+int OGRGeoPackageTableLayer::FillNextFeature( OGRFeature* poFeature )
+{
+    if( !m_bFeatureDefnCompleted )
+        GetLayerDefn();
+    if( m_bDeferredCreation && RunDeferredCreationIfNecessary() != OGRERR_NONE )
+        return FALSE;
+
+    CreateSpatialIndexIfNecessary();
+
+    if( !OGRGeoPackageLayer::FillNextFeature(poFeature) )
+        return FALSE;
+    if( m_iFIDAsRegularColumnIndex >= 0 )
+    {
+        poFeature->SetField(m_iFIDAsRegularColumnIndex, poFeature->GetFID());
+    }
+    return TRUE;
+}
+
 /************************************************************************/
 /*                        GetFeature()                                  */
 /************************************************************************/
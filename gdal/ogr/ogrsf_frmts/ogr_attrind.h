@@ -34,6 +34,28 @@
 
 //! @cond Doxygen_Suppress
 
+/************************************************************************/
+/*                          OGRAttrIndexRange                           */
+/*                                                                      */
+/*      Constraint on the key of an index : equality on the first       */
+/*      nEqualCount key fields, and optionally a range or a string      */
+/*      prefix on the following key field.  The OGRField values are     */
+/*      of the type of the corresponding key fields.                    */
+/************************************************************************/
+
+struct CPL_DLL OGRAttrIndexRange
+{
+    int             nEqualCount = 0;
+    const OGRField *pasEqual = nullptr;
+
+    const OGRField *psMin = nullptr;
+    bool            bMinIncluded = true;
+    const OGRField *psMax = nullptr;
+    bool            bMaxIncluded = true;
+
+    const char     *pszPrefix = nullptr;
+};
+
 /************************************************************************/
 /*                             OGRAttrIndex                             */
 /*                                                                      */
@@ -52,6 +74,12 @@ public:
     virtual GIntBig  *GetAllMatches( OGRField *psKey ) = 0;
     virtual GIntBig  *GetAllMatches( OGRField *psKey, GIntBig* panFIDList, int* nFIDCount, int* nLength ) = 0;
 
+    virtual int       GetKeyFieldCount() { return 1; }
+    virtual int       GetKeyField( int iKey );
+
+    virtual GIntBig  *GetRangeMatches( const OGRAttrIndexRange& sRange,
+                                       GIntBig *pnFIDCount );
+
     virtual OGRErr AddEntry( OGRField *psKey, GIntBig nFID ) = 0;
     virtual OGRErr RemoveEntry( OGRField *psKey, GIntBig nFID ) = 0;
 
@@ -83,13 +111,22 @@ public:
     virtual OGRErr DropIndex( int iField ) = 0;
     virtual OGRErr IndexAllFeatures( int iField = -1 ) = 0;
 
+    virtual OGRErr CreateCompoundIndex( int nFieldCount,
+                                        const int *panFields );
+    virtual OGRErr DropCompoundIndex( int nFieldCount,
+                                      const int *panFields );
+
     virtual OGRErr AddToIndex( OGRFeature *poFeature, int iField = -1 ) = 0;
     virtual OGRErr RemoveFromIndex( OGRFeature *poFeature ) = 0;
 
     virtual OGRAttrIndex *GetFieldIndex( int iField ) = 0;
+
+    virtual int    GetAttrIndexCount() { return 0; }
+    virtual OGRAttrIndex *GetAttrIndex( int /* i */ ) { return nullptr; }
 };
 
 OGRLayerAttrIndex CPL_DLL *OGRCreateDefaultLayerIndex();
+OGRLayerAttrIndex CPL_DLL *OGRCreateMILayerIndex();
 
 //! @endcond
 
@@ -145,6 +145,9 @@ class CPL_DLL OGRLayer : public GDALMajorObject
 
     virtual void        ResetReading() = 0;
     virtual OGRFeature *GetNextFeature() CPL_WARN_UNUSED_RESULT = 0;
+    virtual int         GetNextFeatureBatch( OGRFeatureBatch* poBatch,
+                                             int nMaxRows );
+    virtual int         FillNextFeature( OGRFeature* poFeature );
     virtual OGRErr      SetNextByIndex( GIntBig nIndex );
     virtual OGRFeature *GetFeature( GIntBig nFID )  CPL_WARN_UNUSED_RESULT;
 
@@ -246,6 +249,7 @@ class CPL_DLL OGRLayer : public GDALMajorObject
     OGRLayerAttrIndex   *GetIndex() { return m_poAttrIndex; }
     int                 GetGeomFieldFilter() const { return m_iGeomFieldFilter; }
     const char          *GetAttrQueryString() const { return m_pszAttrQueryString; }
+    OGRFeatureQuery     *GetAttrQuery() { return m_poAttrQuery; }
 //! @endcond
 
     /** Convert a OGRLayer* to a OGRLayerH.
@@ -75,6 +75,9 @@ class OGROpenFileGDBLayer final: public OGRLayer
     int               BuildLayerDefinition();
     int               BuildGeometryColumnGDBv10();
     OGRFeature       *GetCurrentFeature();
+    void              AddCurrentFeatureToBatch(OGRFeatureBatch* poBatch);
+    void              InsertInSpatialIndex(const OGRField* psField, int iRow);
+    OGRGeometry      *GetGeometryFromField(const OGRField* psField);
 
     FileGDBOGRGeometryConverter* m_poGeomConverter;
 
@@ -128,6 +131,8 @@ public:
 
   virtual void        ResetReading() override;
   virtual OGRFeature* GetNextFeature() override;
+  virtual int         GetNextFeatureBatch( OGRFeatureBatch* poBatch,
+                                           int nMaxRows ) override;
   virtual OGRFeature* GetFeature( GIntBig nFeatureId ) override;
   virtual OGRErr      SetNextByIndex( GIntBig nIndex ) override;
 
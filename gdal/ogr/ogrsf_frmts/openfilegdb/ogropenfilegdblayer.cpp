@@ -1455,6 +1455,60 @@ OGRErr OGROpenFileGDBLayer::SetAttributeFilter( const char* pszFilter )
     return eErr;
 }
 
+/***********************************************************************/
+/*                       InsertInSpatialIndex()                        */
+/***********************************************************************/
+
+void OGROpenFileGDBLayer::InsertInSpatialIndex(const OGRField* psField,
+                                               int iRow)
+{
+    OGREnvelope sFeatureEnvelope;
+    if( m_poLyrTable->GetFeatureExtent(psField, &sFeatureEnvelope) )
+    {
+        CPLRectObj sBounds;
+        sBounds.minx = sFeatureEnvelope.MinX;
+        sBounds.miny = sFeatureEnvelope.MinY;
+        sBounds.maxx = sFeatureEnvelope.MaxX;
+        sBounds.maxy = sFeatureEnvelope.MaxY;
+        CPLQuadTreeInsertWithBounds(m_pQuadTree,
+                                    (void*)(size_t)iRow,
+                                    &sBounds);
+    }
+}
+
+/***********************************************************************/
+/*                       GetGeometryFromField()                        */
+/***********************************************************************/
+
+OGRGeometry* OGROpenFileGDBLayer::GetGeometryFromField(const OGRField* psField)
+{
+    OGRGeometry* poGeom = m_poGeomConverter->GetAsGeometry(psField);
+    if( poGeom != nullptr )
+    {
+        OGRwkbGeometryType eFlattenType = wkbFlatten(poGeom->getGeometryType());
+        if( eFlattenType == wkbPolygon )
+            poGeom = OGRGeometryFactory::forceToMultiPolygon(poGeom);
+        else if( eFlattenType == wkbCurvePolygon)
+        {
+            OGRMultiSurface* poMS = new OGRMultiSurface();
+            poMS->addGeometryDirectly( poGeom );
+            poGeom = poMS;
+        }
+        else if( eFlattenType == wkbLineString )
+            poGeom = OGRGeometryFactory::forceToMultiLineString(poGeom);
+        else if (eFlattenType == wkbCompoundCurve)
+        {
+            OGRMultiCurve* poMC = new OGRMultiCurve();
+            poMC->addGeometryDirectly( poGeom );
+            poGeom = poMC;
+        }
+
+        poGeom->assignSpatialReference(
+            m_poFeatureDefn->GetGeomFieldDefn(0)->GetSpatialRef() );
+    }
+    return poGeom;
+}
+
 /***********************************************************************/
 /*                         GetCurrentFeature()                         */
 /***********************************************************************/
@@ -1479,21 +1533,7 @@ OGRFeature* OGROpenFileGDBLayer::GetCurrentFeature()
             if( psField != nullptr )
             {
                 if( m_eSpatialIndexState == SPI_IN_BUILDING )
-                {
-                    OGREnvelope sFeatureEnvelope;
-                    if( m_poLyrTable->GetFeatureExtent(psField,
-                                                       &sFeatureEnvelope) )
-                    {
-                        CPLRectObj sBounds;
-                        sBounds.minx = sFeatureEnvelope.MinX;
-                        sBounds.miny = sFeatureEnvelope.MinY;
-                        sBounds.maxx = sFeatureEnvelope.MaxX;
-                        sBounds.maxy = sFeatureEnvelope.MaxY;
-                        CPLQuadTreeInsertWithBounds(m_pQuadTree,
-                                                    (void*)(size_t)iRow,
-                                                    &sBounds);
-                    }
-                }
+                    InsertInSpatialIndex(psField, iRow);
 
                 if( m_poFilterGeom != nullptr &&
                     m_eSpatialIndexState != SPI_COMPLETED &&
@@ -1503,30 +1543,9 @@ OGRFeature* OGROpenFileGDBLayer::GetCurrentFeature()
                     return nullptr;
                 }
 
-                OGRGeometry* poGeom = m_poGeomConverter->GetAsGeometry(psField);
+                OGRGeometry* poGeom = GetGeometryFromField(psField);
                 if( poGeom != nullptr )
                 {
-                    OGRwkbGeometryType eFlattenType = wkbFlatten(poGeom->getGeometryType());
-                    if( eFlattenType == wkbPolygon )
-                        poGeom = OGRGeometryFactory::forceToMultiPolygon(poGeom);
-                    else if( eFlattenType == wkbCurvePolygon)
-                    {
-                        OGRMultiSurface* poMS = new OGRMultiSurface();
-                        poMS->addGeometryDirectly( poGeom );
-                        poGeom = poMS;
-                    }
-                    else if( eFlattenType == wkbLineString )
-                        poGeom = OGRGeometryFactory::forceToMultiLineString(poGeom);
-                    else if (eFlattenType == wkbCompoundCurve)
-                    {
-                        OGRMultiCurve* poMC = new OGRMultiCurve();
-                        poMC->addGeometryDirectly( poGeom );
-                        poGeom = poMC;
-                    }
-
-                    poGeom->assignSpatialReference(
-                        m_poFeatureDefn->GetGeomFieldDefn(0)->GetSpatialRef() );
-
                     if( poFeature == nullptr )
                         poFeature = new OGRFeature(m_poFeatureDefn);
                     poFeature->SetGeometryDirectly( poGeom );
@@ -1668,6 +1687,113 @@ OGRFeature* OGROpenFileGDBLayer::GetNextFeature()
     }
 }
 
+/***********************************************************************/
+/*                     AddCurrentFeatureToBatch()                      */
+/***********************************************************************/
+
+void OGROpenFileGDBLayer::AddCurrentFeatureToBatch(OGRFeatureBatch* poBatch)
+{
+    int iOGRIdx = 0;
+    int iRow = m_poLyrTable->GetCurRow();
+    poBatch->AddRow(iRow + 1);
+    for(int iGDBIdx=0;iGDBIdx<m_poLyrTable->GetFieldCount();iGDBIdx++)
+    {
+        if( iGDBIdx == m_iGeomFieldIdx )
+        {
+            if( m_poFeatureDefn->GetGeomFieldDefn(0)->IsIgnored() )
+            {
+                if( m_eSpatialIndexState == SPI_IN_BUILDING )
+                    m_eSpatialIndexState = SPI_INVALID;
+                continue;
+            }
+
+            const OGRField* psField = m_poLyrTable->GetFieldValue(iGDBIdx);
+            if( psField != nullptr )
+            {
+                if( m_eSpatialIndexState == SPI_IN_BUILDING )
+                    InsertInSpatialIndex(psField, iRow);
+
+                OGRGeometry* poGeom = GetGeometryFromField(psField);
+                if( poGeom != nullptr )
+                {
+                    poBatch->SetGeometry(0, poGeom);
+                    delete poGeom;
+                }
+            }
+        }
+        else
+        {
+            if( !m_poFeatureDefn->GetFieldDefn(iOGRIdx)->IsIgnored() )
+            {
+                const OGRField* psField = m_poLyrTable->GetFieldValue(iGDBIdx);
+                if( psField != nullptr )
+                {
+                    if( iGDBIdx == m_iFieldToReadAsBinary )
+                        poBatch->SetFieldString(iOGRIdx,
+                                    (const char*) psField->Binary.paData);
+                    else
+                        poBatch->SetFieldRaw(iOGRIdx, psField);
+                }
+            }
+            iOGRIdx ++;
+        }
+    }
+
+    if( m_poLyrTable->HasDeletedFeaturesListed() )
+    {
+        poBatch->SetFieldInteger(m_poFeatureDefn->GetFieldCount() - 1,
+                                 m_poLyrTable->IsCurRowDeleted());
+    }
+}
+
+/***********************************************************************/
+/*                        GetNextFeatureBatch()                        */
+/***********************************************************************/
+
+int OGROpenFileGDBLayer::GetNextFeatureBatch( OGRFeatureBatch* poBatch,
+                                              int nMaxRows )
+{
+    if( !BuildLayerDefinition() )
+    {
+        poBatch->Reset();
+        return 0;
+    }
+
+    // Only the sequential reading without filter is done natively
+    if( m_poFilterGeom != nullptr || m_poAttrQuery != nullptr ||
+        m_poIterator != nullptr || m_nFilteredFeatureCount >= 0 ||
+        poBatch->GetDefn() != m_poFeatureDefn )
+    {
+        return OGRLayer::GetNextFeatureBatch(poBatch, nMaxRows);
+    }
+
+    poBatch->Reset();
+    if( m_bEOF )
+        return 0;
+
+    while( poBatch->GetRowCount() < nMaxRows )
+    {
+        if( m_iCurFeat == m_poLyrTable->GetTotalRecordCount() )
+            break;
+        m_iCurFeat = m_poLyrTable->GetAndSelectNextNonEmptyRow(m_iCurFeat);
+        if( m_iCurFeat < 0 )
+        {
+            m_bEOF = TRUE;
+            break;
+        }
+        m_iCurFeat ++;
+        AddCurrentFeatureToBatch(poBatch);
+        if( m_eSpatialIndexState == SPI_IN_BUILDING &&
+            m_iCurFeat == m_poLyrTable->GetTotalRecordCount() )
+        {
+            CPLDebug("OpenFileGDB", "SPI_COMPLETED");
+            m_eSpatialIndexState = SPI_COMPLETED;
+        }
+    }
+
+    return poBatch->GetRowCount();
+}
+
 /***********************************************************************/
 /*                          GetFeature()                               */
 /***********************************************************************/
@@ -53,7 +53,12 @@
 /* ==================================================================== */
 OGRFeature *SHPReadOGRFeature( SHPHandle hSHP, DBFHandle hDBF,
                                OGRFeatureDefn * poDefn, int iShape,
-                               SHPObject *psShape, const char *pszSHPEncoding );
+                               SHPObject *psShape, const char *pszSHPEncoding,
+                               OGRFeature *poReusedFeature = nullptr );
+bool SHPReadOGRFeatureBatch( SHPHandle hSHP, DBFHandle hDBF,
+                             OGRFeatureDefn * poDefn, int iShape,
+                             const char *pszSHPEncoding,
+                             OGRFeatureBatch* poBatch );
 OGRGeometry *SHPReadOGRObject( SHPHandle hSHP, int iShape, SHPObject *psShape );
 OGRFeatureDefn *SHPReadOGRFeatureDefn( const char * pszName,
                                        SHPHandle hSHP, DBFHandle hDBF,
@@ -200,7 +205,9 @@ class OGRShapeLayer final: public OGRAbstractProxiedLayer
 
     const char         *GetFullName() { return pszFullName; }
 
-    OGRFeature *        FetchShape( int iShapeId );
+    OGRFeature *        FetchShape( int iShapeId,
+                                    OGRFeature* poReusedFeature = nullptr );
+    OGRFeature *        GetNextFeatureInternal( OGRFeature* poReusedFeature );
     int                 GetFeatureCountWithSpatialFilterOnly();
 
   public:
@@ -215,6 +222,9 @@ class OGRShapeLayer final: public OGRAbstractProxiedLayer
 
     void                ResetReading() override;
     OGRFeature *        GetNextFeature() override;
+    int                 GetNextFeatureBatch( OGRFeatureBatch* poBatch,
+                                             int nMaxRows ) override;
+    int                 FillNextFeature( OGRFeature* poFeature ) override;
     virtual OGRErr      SetNextByIndex( GIntBig nIndex ) override;
 
     OGRFeature         *GetFeature( GIntBig nFeatureId ) override;
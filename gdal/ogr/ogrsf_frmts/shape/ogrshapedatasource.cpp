@@ -1186,6 +1186,7 @@ OGRErr OGRShapeDataSource::DeleteLayer( int iLayer )
     VSIUnlink( CPLResetExtension(pszFilename, "dbf") );
     VSIUnlink( CPLResetExtension(pszFilename, "prj") );
     VSIUnlink( CPLResetExtension(pszFilename, "qix") );
+    VSIUnlink( CPLResetExtension(pszFilename, "oai") );
 
     CPLFree( pszFilename );
 
@@ -218,7 +218,7 @@ static CPLErr OGRShapeDriverDelete( const char *pszDataSource )
 
     static const char * const apszExtensions[] =
         { "shp", "shx", "dbf", "sbn", "sbx", "prj", "idm", "ind",
-          "qix", "cpg", nullptr };
+          "oai", "qix", "cpg", nullptr };
 
     if( VSI_ISREG(sStatBuf.st_mode)
         && (EQUAL(CPLGetExtension(pszDataSource), "shp")
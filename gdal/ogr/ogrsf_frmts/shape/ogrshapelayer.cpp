@@ -759,9 +759,12 @@ OGRErr OGRShapeLayer::SetNextByIndex( GIntBig nIndex )
 /*                                                                      */
 /*      Take a shape id, a geometry, and a feature, and set the feature */
 /*      if the shapeid bbox intersects the geometry.                    */
+/*      poReusedFeature, if not NULL, is refilled instead of creating   */
+/*      a new feature.                                                  */
 /************************************************************************/
 
-OGRFeature *OGRShapeLayer::FetchShape( int iShapeId )
+OGRFeature *OGRShapeLayer::FetchShape( int iShapeId,
+                                       OGRFeature* poReusedFeature )
 
 {
     OGRFeature *poFeature = nullptr;
@@ -781,7 +784,8 @@ OGRFeature *OGRShapeLayer::FetchShape( int iShapeId )
             || psShape->nSHPType == SHPT_NULL )
         {
             poFeature = SHPReadOGRFeature( hSHP, hDBF, poFeatureDefn,
-                                           iShapeId, psShape, osEncoding );
+                                           iShapeId, psShape, osEncoding,
+                                           poReusedFeature );
         }
         else if( m_sFilterEnvelope.MaxX < psShape->dfXMin
                  || m_sFilterEnvelope.MaxY < psShape->dfYMin
@@ -794,13 +798,15 @@ OGRFeature *OGRShapeLayer::FetchShape( int iShapeId )
         else
         {
             poFeature = SHPReadOGRFeature( hSHP, hDBF, poFeatureDefn,
-                                           iShapeId, psShape, osEncoding );
+                                           iShapeId, psShape, osEncoding,
+                                           poReusedFeature );
         }
     }
     else
     {
         poFeature = SHPReadOGRFeature( hSHP, hDBF, poFeatureDefn,
-                                       iShapeId, nullptr, osEncoding );
+                                       iShapeId, nullptr, osEncoding,
+                                       poReusedFeature );
     }
 
     return poFeature;
@@ -812,6 +818,34 @@ OGRFeature *OGRShapeLayer::FetchShape( int iShapeId )
 
 OGRFeature *OGRShapeLayer::GetNextFeature()
 
+{
+    return GetNextFeatureInternal( nullptr );
+}
+
+/************************************************************************/
+/*                          FillNextFeature()                           */
+/************************************************************************/
+
+int OGRShapeLayer::FillNextFeature( OGRFeature* poFeature )
+
+{
+    if( poFeature->GetDefnRef() != poFeatureDefn )
+        return OGRLayer::FillNextFeature( poFeature );
+
+    return GetNextFeatureInternal( poFeature ) != nullptr;
+}
+
+/************************************************************************/
+/*                       GetNextFeatureInternal()                       */
+/*                                                                      */
+/*      Return the next feature matching the filters.  If               */
+/*      poReusedFeature is not NULL, it is refilled and returned        */
+/*      instead of a new feature.                                       */
+/************************************************************************/
+
+OGRFeature *OGRShapeLayer::GetNextFeatureInternal(
+    OGRFeature* poReusedFeature )
+
 {
     if( !TouchLayer() )
         return nullptr;
@@ -844,7 +878,8 @@ OGRFeature *OGRShapeLayer::GetNextFeature()
             // Check the shape object's geometry, and if it matches
             // any spatial filter, return it.
             poFeature =
-                FetchShape(static_cast<int>(panMatchingFIDs[iMatchingFID]));
+                FetchShape(static_cast<int>(panMatchingFIDs[iMatchingFID]),
+                           poReusedFeature);
 
             iMatchingFID++;
         }
@@ -862,10 +897,10 @@ OGRFeature *OGRShapeLayer::GetNextFeature()
                 else if( VSIFEofL(VSI_SHP_GetVSIL(hDBF->fp)) )
                     return nullptr;  //* I/O error.
                 else
-                    poFeature = FetchShape(iNextShapeId);
+                    poFeature = FetchShape(iNextShapeId, poReusedFeature);
             }
             else
-                poFeature = FetchShape(iNextShapeId);
+                poFeature = FetchShape(iNextShapeId, poReusedFeature);
 
             iNextShapeId++;
         }
@@ -887,11 +922,61 @@ OGRFeature *OGRShapeLayer::GetNextFeature()
                 return poFeature;
             }
 
-            delete poFeature;
+            if( poFeature != poReusedFeature )
+                delete poFeature;
         }
     }
 }
 
+/************************************************************************/
+/*                        GetNextFeatureBatch()                         */
+/************************************************************************/
+
+int OGRShapeLayer::GetNextFeatureBatch( OGRFeatureBatch* poBatch,
+                                        int nMaxRows )
+
+{
+    if( m_poAttrQuery != nullptr || m_poFilterGeom != nullptr ||
+        panMatchingFIDs != nullptr )
+    {
+        return OGRLayer::GetNextFeatureBatch(poBatch, nMaxRows);
+    }
+
+    poBatch->Reset();
+    if( !TouchLayer() )
+        return 0;
+    if( poBatch->GetDefn() != poFeatureDefn )
+        return OGRLayer::GetNextFeatureBatch(poBatch, nMaxRows);
+
+/* -------------------------------------------------------------------- */
+/*      Read the records directly into the batch, skipping the          */
+/*      deleted ones as GetNextFeature() does.                          */
+/* -------------------------------------------------------------------- */
+    while( poBatch->GetRowCount() < nMaxRows &&
+           iNextShapeId < nTotalShapeCount )
+    {
+        if( hDBF )
+        {
+            if( DBFIsRecordDeleted( hDBF, iNextShapeId ) )
+            {
+                iNextShapeId++;
+                continue;
+            }
+            if( VSIFEofL(VSI_SHP_GetVSIL(hDBF->fp)) )
+                break;  // I/O error.
+        }
+
+        if( SHPReadOGRFeatureBatch( hSHP, hDBF, poFeatureDefn, iNextShapeId,
+                                    osEncoding, poBatch ) )
+        {
+            m_nFeaturesRead++;
+        }
+        iNextShapeId++;
+    }
+
+    return poBatch->GetRowCount();
+}
+
 /************************************************************************/
 /*                             GetFeature()                             */
 /************************************************************************/
@@ -1399,42 +1484,23 @@ int OGRShapeLayer::GetFeatureCountWithSpatialFilterOnly()
             else
             {
 /* -------------------------------------------------------------------- */
-/*      Fallback to full intersect test (using GEOS) if we still        */
-/*      don't know for sure.                                            */
+/*      Fallback to the full test of the geometry against the filter    */
+/*      if we still don't know for sure.                                */
 /* -------------------------------------------------------------------- */
-                if( OGRGeometryFactory::haveGEOS() )
+                // Read the full geometry.
+                if( poGeometry == nullptr )
                 {
-                    // Read the full geometry.
-                    if( poGeometry == nullptr )
-                    {
-                        if( psShape == &sShape )
-                            psShape = SHPReadObject( hSHP, iShape);
-                        if( psShape )
-                        {
-                            poGeometry =
-                                SHPReadOGRObject( hSHP, iShape, psShape );
-                            psShape = nullptr;
-                        }
-                    }
-                    if( poGeometry == nullptr )
-                    {
-                        nFeatureCount++;
-                    }
-                    else if( m_pPreparedFilterGeom != nullptr )
+                    if( psShape == &sShape )
+                        psShape = SHPReadObject( hSHP, iShape);
+                    if( psShape )
                     {
-                        if( OGRPreparedGeometryIntersects(m_pPreparedFilterGeom,
-                                                          poGeometry) )
-                        {
-                            nFeatureCount++;
-                        }
+                        poGeometry =
+                            SHPReadOGRObject( hSHP, iShape, psShape );
+                        psShape = nullptr;
                     }
-                    else if( m_poFilterGeom->Intersects( poGeometry ) )
-                        nFeatureCount++;
                 }
-                else
-                {
+                if( poGeometry == nullptr || FilterGeometry( poGeometry ) )
                     nFeatureCount++;
-                }
             }
 
             delete poGeometry;
@@ -76,19 +76,21 @@ static void RingStartEnd( SHPObject *psShape, int ring, int *start, int *end )
 /************************************************************************/
 /*                        CreateLinearRing                              */
 /************************************************************************/
-static OGRLinearRing * CreateLinearRing(
-    SHPObject *psShape, int ring, bool bHasZ, bool bHasM )
+static bool SetLinearRingPoints(
+    OGRLinearRing *poRing, SHPObject *psShape, int ring,
+    bool bHasZ, bool bHasM )
 {
     int nRingStart = 0;
     int nRingEnd = 0;
     RingStartEnd( psShape, ring, &nRingStart, &nRingEnd );
 
-    OGRLinearRing * const poRing = new OGRLinearRing();
     if( !(nRingEnd >= nRingStart) )
-        return poRing;
+        return false;
 
     const int nRingPoints = nRingEnd - nRingStart + 1;
 
+    // The dimension resets are no-ops on a new ring, but matter when a
+    // ring read from a previous shape is refilled.
     if( bHasZ && bHasM )
         poRing->setPoints(
             nRingPoints, psShape->padfX + nRingStart,
@@ -96,15 +98,29 @@ static OGRLinearRing * CreateLinearRing(
             psShape->padfZ + nRingStart,
             psShape->padfM ? psShape->padfM + nRingStart : nullptr );
     else if( bHasM )
+    {
+        poRing->set3D(FALSE);
         poRing->setPointsM(
             nRingPoints, psShape->padfX + nRingStart,
             psShape->padfY + nRingStart,
             psShape->padfM ? psShape->padfM + nRingStart :nullptr );
+    }
     else
+    {
+        poRing->setMeasured(FALSE);
         poRing->setPoints(
             nRingPoints, psShape->padfX + nRingStart,
             psShape->padfY + nRingStart );
+    }
+
+    return true;
+}
 
+static OGRLinearRing * CreateLinearRing(
+    SHPObject *psShape, int ring, bool bHasZ, bool bHasM )
+{
+    OGRLinearRing * const poRing = new OGRLinearRing();
+    SetLinearRingPoints( poRing, psShape, ring, bHasZ, bHasM );
     return poRing;
 }
 
@@ -391,6 +407,97 @@ OGRGeometry *SHPReadOGRObject( SHPHandle hSHP, int iShape, SHPObject *psShape )
     return poOGR;
 }
 
+/************************************************************************/
+/*                         SHPRefillOGRObject()                         */
+/*                                                                      */
+/*      Refill a geometry returned by SHPReadOGRObject() for a          */
+/*      previous shape with the content of psShape, reusing its         */
+/*      coordinate arrays.  Only points, single part arcs and single    */
+/*      ring polygons are handled.  Returns false if the geometry       */
+/*      does not have the structure SHPReadOGRObject() would build.     */
+/************************************************************************/
+
+static bool SHPRefillOGRObject( SHPObject *psShape, OGRGeometry *poGeom )
+{
+    const OGRwkbGeometryType eFlatType =
+        wkbFlatten(poGeom->getGeometryType());
+
+    if( psShape->nSHPType == SHPT_POINT
+        || psShape->nSHPType == SHPT_POINTZ
+        || psShape->nSHPType == SHPT_POINTM )
+    {
+        if( eFlatType != wkbPoint )
+            return false;
+
+        OGRPoint oPoint( psShape->padfX[0], psShape->padfY[0] );
+        if( psShape->nSHPType == SHPT_POINTZ )
+        {
+            oPoint.setZ( psShape->padfZ[0] );
+            if( psShape->bMeasureIsUsed )
+                oPoint.setM( psShape->padfM[0] );
+        }
+        else if( psShape->nSHPType == SHPT_POINTM )
+        {
+            oPoint.setM( psShape->padfM[0] );
+        }
+        *(poGeom->toPoint()) = oPoint;
+        return true;
+    }
+
+    if( psShape->nSHPType == SHPT_ARC
+        || psShape->nSHPType == SHPT_ARCM
+        || psShape->nSHPType == SHPT_ARCZ )
+    {
+        if( eFlatType != wkbLineString || psShape->nParts != 1 )
+            return false;
+
+        OGRLineString *poOGRLine = poGeom->toLineString();
+        if( psShape->nSHPType == SHPT_ARCZ )
+            poOGRLine->setPoints( psShape->nVertices,
+                                  psShape->padfX, psShape->padfY,
+                                  psShape->padfZ, psShape->padfM );
+        else if( psShape->nSHPType == SHPT_ARCM )
+        {
+            poOGRLine->set3D(FALSE);
+            poOGRLine->setPointsM( psShape->nVertices,
+                                   psShape->padfX, psShape->padfY,
+                                   psShape->padfM );
+        }
+        else
+        {
+            poOGRLine->setMeasured(FALSE);
+            poOGRLine->setPoints( psShape->nVertices,
+                                  psShape->padfX, psShape->padfY );
+        }
+        return true;
+    }
+
+    if( psShape->nSHPType == SHPT_POLYGON
+        || psShape->nSHPType == SHPT_POLYGONM
+        || psShape->nSHPType == SHPT_POLYGONZ )
+    {
+        if( eFlatType != wkbPolygon || psShape->nParts != 1 )
+            return false;
+
+        OGRPolygon *poOGRPoly = poGeom->toPolygon();
+        OGRLinearRing *poRing = poOGRPoly->getExteriorRing();
+        if( poRing == nullptr || poOGRPoly->getNumInteriorRings() != 0 )
+            return false;
+
+        const bool bHasZ = psShape->nSHPType == SHPT_POLYGONZ;
+        const bool bHasM = bHasZ || psShape->nSHPType == SHPT_POLYGONM;
+        if( !SetLinearRingPoints( poRing, psShape, 0, bHasZ, bHasM ) )
+            return false;
+
+        // The polygon dimension is not derived from the one of its ring.
+        poOGRPoly->set3D( poRing->Is3D() );
+        poOGRPoly->setMeasured( poRing->IsMeasured() );
+        return true;
+    }
+
+    return false;
+}
+
 /************************************************************************/
 /*                         SHPWriteOGRObject()                          */
 /************************************************************************/
@@ -1136,13 +1243,78 @@ OGRFeatureDefn *SHPReadOGRFeatureDefn( const char * pszName,
     return poDefn;
 }
 
+/************************************************************************/
+/*                            SHPParseDate()                            */
+/************************************************************************/
+
+static void SHPParseDate( const char* pszDateValue, OGRField* psFld )
+{
+    memset( psFld, 0, sizeof(*psFld) );
+
+    if( strlen(pszDateValue) >= 10 &&
+        pszDateValue[2] == '/' && pszDateValue[5] == '/' )
+    {
+        psFld->Date.Month = static_cast<GByte>(atoi(pszDateValue + 0));
+        psFld->Date.Day   = static_cast<GByte>(atoi(pszDateValue + 3));
+        psFld->Date.Year  = static_cast<GInt16>(atoi(pszDateValue + 6));
+    }
+    else
+    {
+        const int nFullDate = atoi(pszDateValue);
+        psFld->Date.Year = static_cast<GInt16>(nFullDate / 10000);
+        psFld->Date.Month = static_cast<GByte>((nFullDate / 100) % 100);
+        psFld->Date.Day = static_cast<GByte>(nFullDate % 100);
+    }
+}
+
+/************************************************************************/
+/*                      SHPSetOGRObjectDimension()                      */
+/*                                                                      */
+/*      Set/unset the Z and M flags of a geometry read from the         */
+/*      shapefile to match the layer geometry type.                     */
+/************************************************************************/
+
+static void SHPSetOGRObjectDimension( OGRFeatureDefn * poDefn,
+                                      OGRGeometry *poGeometry )
+{
+    const OGRwkbGeometryType eMyGeomType =
+        poDefn->GetGeomFieldDefn(0)->GetType();
+
+    if( eMyGeomType != wkbUnknown )
+    {
+        OGRwkbGeometryType eGeomInType =
+            poGeometry->getGeometryType();
+        if( wkbHasZ(eMyGeomType) && !wkbHasZ(eGeomInType) )
+        {
+            poGeometry->set3D(TRUE);
+        }
+        else if( !wkbHasZ(eMyGeomType) && wkbHasZ(eGeomInType) )
+        {
+            poGeometry->set3D(FALSE);
+        }
+        if( wkbHasM(eMyGeomType) && !wkbHasM(eGeomInType) )
+        {
+            poGeometry->setMeasured(TRUE);
+        }
+        else if( !wkbHasM(eMyGeomType) && wkbHasM(eGeomInType) )
+        {
+            poGeometry->setMeasured(FALSE);
+        }
+    }
+}
+
 /************************************************************************/
 /*                         SHPReadOGRFeature()                          */
+/*                                                                      */
+/*      If poReusedFeature is not NULL, it is refilled and returned     */
+/*      instead of a new feature, reusing its geometry and field        */
+/*      buffers when possible.                                          */
 /************************************************************************/
 
 OGRFeature *SHPReadOGRFeature( SHPHandle hSHP, DBFHandle hDBF,
                                OGRFeatureDefn * poDefn, int iShape,
-                               SHPObject *psShape, const char *pszSHPEncoding )
+                               SHPObject *psShape, const char *pszSHPEncoding,
+                               OGRFeature *poReusedFeature )
 
 {
     if( iShape < 0
@@ -1166,14 +1338,32 @@ OGRFeature *SHPReadOGRFeature( SHPHandle hSHP, DBFHandle hDBF,
         return nullptr;
     }
 
-    OGRFeature  *poFeature = new OGRFeature( poDefn );
+    OGRFeature  *poFeature = poReusedFeature != nullptr ?
+        poReusedFeature : new OGRFeature( poDefn );
 
 /* -------------------------------------------------------------------- */
 /*      Fetch geometry from Shapefile to OGRFeature.                    */
 /* -------------------------------------------------------------------- */
     if( hSHP != nullptr )
     {
-        if( !poDefn->IsGeometryIgnored() )
+        OGRGeometry* poReusedGeometry = poReusedFeature != nullptr ?
+            poReusedFeature->GetGeometryRef() : nullptr;
+        if( poDefn->IsGeometryIgnored() )
+        {
+            if( psShape != nullptr )
+                SHPDestroyObject( psShape );
+            if( poReusedGeometry != nullptr )
+                poFeature->SetGeometryDirectly( nullptr );
+        }
+        else if( poReusedGeometry != nullptr &&
+                 (psShape != nullptr ||
+                  (psShape = SHPReadObject( hSHP, iShape )) != nullptr) &&
+                 SHPRefillOGRObject( psShape, poReusedGeometry ) )
+        {
+            SHPDestroyObject( psShape );
+            SHPSetOGRObjectDimension( poDefn, poReusedGeometry );
+        }
+        else
         {
             OGRGeometry* poGeometry =
                 SHPReadOGRObject( hSHP, iShape, psShape );
@@ -1187,40 +1377,10 @@ OGRFeature *SHPReadOGRFeature( SHPHandle hSHP, DBFHandle hDBF,
             // It is NOT required here to test poGeometry == NULL.
 
             if( poGeometry )
-            {
-                // Set/unset flags.
-                const OGRwkbGeometryType eMyGeomType =
-                    poFeature->GetDefnRef()->GetGeomFieldDefn(0)->GetType();
-
-                if( eMyGeomType != wkbUnknown )
-                {
-                    OGRwkbGeometryType eGeomInType =
-                        poGeometry->getGeometryType();
-                    if( wkbHasZ(eMyGeomType) && !wkbHasZ(eGeomInType) )
-                    {
-                        poGeometry->set3D(TRUE);
-                    }
-                    else if( !wkbHasZ(eMyGeomType) && wkbHasZ(eGeomInType) )
-                    {
-                        poGeometry->set3D(FALSE);
-                    }
-                    if( wkbHasM(eMyGeomType) && !wkbHasM(eGeomInType) )
-                    {
-                        poGeometry->setMeasured(TRUE);
-                    }
-                    else if( !wkbHasM(eMyGeomType) && wkbHasM(eGeomInType) )
-                    {
-                        poGeometry->setMeasured(FALSE);
-                    }
-                }
-            }
+                SHPSetOGRObjectDimension( poDefn, poGeometry );
 
             poFeature->SetGeometryDirectly( poGeometry );
         }
-        else if( psShape != nullptr )
-        {
-            SHPDestroyObject( psShape );
-        }
     }
 
 /* -------------------------------------------------------------------- */
@@ -1233,7 +1393,11 @@ OGRFeature *SHPReadOGRFeature( SHPHandle hSHP, DBFHandle hDBF,
     {
         const OGRFieldDefn * const poFieldDefn = poDefn->GetFieldDefn(iField);
         if( poFieldDefn->IsIgnored() )
+        {
+            if( poReusedFeature != nullptr )
+                poFeature->UnsetField( iField );
             continue;
+        }
 
         switch( poFieldDefn->GetType() )
         {
@@ -1290,27 +1454,119 @@ OGRFeature *SHPReadOGRFeature( SHPHandle hSHP, DBFHandle hDBF,
               // (trimmed by DBFReadStringAttribute) to indicate null
               // values for dates (#4265).
               if( pszDateValue[0] == '\0' )
+              {
+                  if( poReusedFeature != nullptr )
+                      poFeature->UnsetField( iField );
                   continue;
+              }
 
               OGRField sFld;
-              memset( &sFld, 0, sizeof(sFld) );
+              SHPParseDate( pszDateValue, &sFld );
+              poFeature->SetField( iField, &sFld );
+          }
+          break;
+
+          default:
+            CPLAssert( false );
+        }
+    }
+
+    if( poFeature != nullptr )
+        poFeature->SetFID( iShape );
+
+    return poFeature;
+}
+
+/************************************************************************/
+/*                       SHPReadOGRFeatureBatch()                       */
+/*                                                                      */
+/*      Append a shape and its attributes to a feature batch, with      */
+/*      the same conversions as SHPReadOGRFeature(), but without        */
+/*      instantiating a OGRFeature.                                     */
+/************************************************************************/
+
+bool SHPReadOGRFeatureBatch( SHPHandle hSHP, DBFHandle hDBF,
+                             OGRFeatureDefn * poDefn, int iShape,
+                             const char *pszSHPEncoding,
+                             OGRFeatureBatch* poBatch )
+
+{
+    if( iShape < 0
+        || (hSHP != nullptr && iShape >= hSHP->nRecords)
+        || (hDBF != nullptr && iShape >= hDBF->nRecords) )
+    {
+        CPLError( CE_Failure, CPLE_AppDefined,
+                  "Attempt to read shape with feature id (%d) out of available"
+                  " range.", iShape );
+        return false;
+    }
+
+    poBatch->AddRow( iShape );
+
+    if( hSHP != nullptr && !poDefn->IsGeometryIgnored() )
+    {
+        OGRGeometry* poGeometry = SHPReadOGRObject( hSHP, iShape, nullptr );
+        if( poGeometry )
+        {
+            SHPSetOGRObjectDimension( poDefn, poGeometry );
+            poBatch->SetGeometry( 0, poGeometry );
+            delete poGeometry;
+        }
+    }
+
+    for( int iField = 0;
+         hDBF != nullptr && iField < poDefn->GetFieldCount();
+         iField++ )
+    {
+        const OGRFieldDefn * const poFieldDefn = poDefn->GetFieldDefn(iField);
+        if( poFieldDefn->IsIgnored() )
+            continue;
 
-              if( strlen(pszDateValue) >= 10 &&
-                  pszDateValue[2] == '/' && pszDateValue[5] == '/' )
+        switch( poFieldDefn->GetType() )
+        {
+          case OFTString:
+          {
+              const char * const pszFieldVal =
+                  DBFReadStringAttribute( hDBF, iShape, iField );
+              if( pszFieldVal != nullptr && pszFieldVal[0] != '\0' )
               {
-                  sFld.Date.Month = static_cast<GByte>(atoi(pszDateValue + 0));
-                  sFld.Date.Day   = static_cast<GByte>(atoi(pszDateValue + 3));
-                  sFld.Date.Year  = static_cast<GInt16>(atoi(pszDateValue + 6));
+                if( pszSHPEncoding[0] != '\0' )
+                {
+                    char * const pszUTF8Field =
+                        CPLRecode( pszFieldVal, pszSHPEncoding, CPL_ENC_UTF8);
+                    poBatch->SetFieldString( iField, pszUTF8Field );
+                    CPLFree( pszUTF8Field );
+                }
+                else
+                    poBatch->SetFieldString( iField, pszFieldVal );
               }
-              else
+              break;
+          }
+          case OFTInteger:
+          case OFTInteger64:
+          case OFTReal:
+          {
+              if( !DBFIsAttributeNULL( hDBF, iShape, iField ) )
               {
-                  const int nFullDate = atoi(pszDateValue);
-                  sFld.Date.Year = static_cast<GInt16>(nFullDate / 10000);
-                  sFld.Date.Month = static_cast<GByte>((nFullDate / 100) % 100);
-                  sFld.Date.Day = static_cast<GByte>(nFullDate % 100);
+                  poBatch->SetFieldFromString(
+                      iField,
+                      DBFReadStringAttribute( hDBF, iShape, iField ) );
               }
+              break;
+          }
+          case OFTDate:
+          {
+              if( DBFIsAttributeNULL( hDBF, iShape, iField ) )
+                  continue;
 
-              poFeature->SetField( iField, &sFld );
+              const char* const pszDateValue =
+                  DBFReadStringAttribute(hDBF,iShape,iField);
+              if( pszDateValue[0] == '\0' )
+                  continue;
+
+              OGRField sFld;
+              SHPParseDate( pszDateValue, &sFld );
+              poBatch->SetFieldRaw( iField, &sFld );
           }
           break;
 
@@ -1319,10 +1575,7 @@ OGRFeature *SHPReadOGRFeature( SHPHandle hSHP, DBFHandle hDBF,
         }
     }
 
-    if( poFeature != nullptr )
-        poFeature->SetFID( iShape );
-
-    return poFeature;
+    return true;
 }
 
 /************************************************************************/
@@ -53,8 +53,7 @@ CPL_CVSID("$Id$")
 /*      Does input match pattern?                                       */
 /************************************************************************/
 
-static int swq_test_like( const char *input, const char *pattern,
-                          char chEscape )
+int swq_test_like( const char *input, const char *pattern, char chEscape )
 
 {
     if( input == nullptr || pattern == nullptr )
@@ -116,6 +115,29 @@ static int swq_test_like( const char *input, const char *pattern,
         return 1;
 }
 
+/************************************************************************/
+/*                       swq_test_string_equal()                        */
+/*                                                                      */
+/*      Case insensitive equality of strings or timestamps.  When       */
+/*      comparing timestamps, the +00 at the end might be discarded     */
+/*      if the other member has no explicit timezone.                   */
+/************************************************************************/
+
+int swq_test_string_equal( const char *pszA, const char *pszB )
+
+{
+    const size_t nLenA = strlen(pszA);
+    const size_t nLenB = strlen(pszB);
+    if( nLenA > 3 && nLenB > 3 )
+    {
+        if( strcmp(pszA + nLenA - 3, "+00") == 0 && pszB[nLenB - 3] == ':' )
+            return EQUALN(pszA, pszB, nLenB);
+        if( pszA[nLenA - 3] == ':' && strcmp(pszB + nLenB - 3, "+00") == 0 )
+            return EQUALN(pszA, pszB, nLenA);
+    }
+    return strcasecmp(pszA, pszB) == 0;
+}
+
 /************************************************************************/
 /*                        OGRHStoreGetValue()                           */
 /************************************************************************/
@@ -732,35 +754,14 @@ swq_expr_node *SWQGeneralEvaluator( swq_expr_node *node,
         {
           case SWQ_EQ:
           {
-            // When comparing timestamps, the +00 at the end might be discarded
-            // if the other member has no explicit timezone.
             if( (sub_node_values[0]->field_type == SWQ_TIMESTAMP ||
                  sub_node_values[0]->field_type == SWQ_STRING) &&
                 (sub_node_values[1]->field_type == SWQ_TIMESTAMP ||
-                 sub_node_values[1]->field_type == SWQ_STRING) &&
-                strlen(sub_node_values[0]->string_value) > 3 &&
-                strlen(sub_node_values[1]->string_value) > 3 &&
-                (strcmp(sub_node_values[0]->string_value + strlen(sub_node_values[0]->string_value)-3, "+00") == 0 &&
-                 sub_node_values[1]->string_value[strlen(sub_node_values[1]->string_value)-3] == ':') )
-            {
-                poRet->int_value =
-                    EQUALN(sub_node_values[0]->string_value,
-                           sub_node_values[1]->string_value,
-                           strlen(sub_node_values[1]->string_value));
-            }
-            else if( (sub_node_values[0]->field_type == SWQ_TIMESTAMP ||
-                      sub_node_values[0]->field_type == SWQ_STRING) &&
-                     (sub_node_values[1]->field_type == SWQ_TIMESTAMP ||
-                      sub_node_values[1]->field_type == SWQ_STRING) &&
-                     strlen(sub_node_values[0]->string_value) > 3 &&
-                     strlen(sub_node_values[1]->string_value) > 3 &&
-                     (sub_node_values[0]->string_value[strlen(sub_node_values[0]->string_value)-3] == ':') &&
-                      strcmp(sub_node_values[1]->string_value + strlen(sub_node_values[1]->string_value)-3, "+00") == 0)
+                 sub_node_values[1]->field_type == SWQ_STRING) )
             {
                 poRet->int_value =
-                    EQUALN(sub_node_values[0]->string_value,
-                           sub_node_values[1]->string_value,
-                           strlen(sub_node_values[0]->string_value));
+                    swq_test_string_equal(sub_node_values[0]->string_value,
+                                          sub_node_values[1]->string_value);
             }
             else
             {
@@ -223,6 +223,10 @@ char CPL_DLL **VSIGetFileSystemsPrefixes( void );
 
 void CPL_DLL   *VSIFGetNativeFileDescriptorL( VSILFILE* );
 
+const void CPL_DLL *VSIFAcquireReadViewL( VSILFILE* fp, vsi_l_offset nOffset,
+                                          size_t nSize, void** ppViewHandle );
+void CPL_DLL    VSIFReleaseReadViewL( VSILFILE* fp, void* pViewHandle );
+
 /* ==================================================================== */
 /*      Memory allocation                                               */
 /* ==================================================================== */
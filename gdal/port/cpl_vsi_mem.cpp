@@ -43,9 +43,11 @@
 #endif
 
 #include <algorithm>
+#include <functional>
 #include <map>
 #include <string>
 #include <utility>
+#include <vector>
 
 #include "cpl_atomic_ops.h"
 #include "cpl_conv.h"
@@ -60,11 +62,14 @@ CPL_CVSID("$Id$")
 /*
 ** Notes on Multithreading:
 **
-** VSIMemFilesystemHandler: This class maintains a mutex to protect
-** access and update of the oFileList array which has all the "files" in
-** the memory filesystem area.  It is expected that multiple threads would
-** want to create and read different files at the same time and so might
-** collide access oFileList without the mutex.
+** VSIMemFilesystemHandler: This class maintains the table of all the
+** "files" in the memory filesystem area.  It is expected that multiple
+** threads would want to create and read different files at the same time,
+** so the table is split in shards selected by a hash of the filename, each
+** protected by its own mutex.  Operations on a single file only lock the
+** shard of that file, so threads working on different files rarely contend.
+** Operations spanning several files (ReadDirEx(), Rename()) lock the shards
+** one after the other, or all of them in index order.
 **
 ** VSIMemFile: In theory we could allow different threads to update the
 ** the same memory file, but for simplicity we restrict to single writer,
@@ -143,6 +148,9 @@ class VSIMemHandle final : public VSIVirtualHandle
     int Eof() override;
     int Close() override;
     int Truncate( vsi_l_offset nNewSize ) override;
+    const void *AcquireReadView( vsi_l_offset nOffset, size_t nSize,
+                                 void** ppViewHandle ) override;
+    void ReleaseReadView( void* ) override {}
 };
 
 /************************************************************************/
@@ -156,12 +164,22 @@ class VSIMemFilesystemHandler final : public VSIFilesystemHandler
     CPL_DISALLOW_COPY_ASSIGN(VSIMemFilesystemHandler)
 
   public:
-    std::map<CPLString, VSIMemFile*> oFileList{};
-    CPLMutex        *hMutex = nullptr;
+    static constexpr int SHARD_COUNT = 32;
 
-    VSIMemFilesystemHandler() = default;
+    struct Shard
+    {
+        std::map<CPLString, VSIMemFile*> oFileList{};
+        // Created in the constructor: CPLMutexHolder(CPLMutex**) would go
+        // through the process-wide mutex creation lock at each call.
+        CPLMutex        *hMutex = nullptr;
+    };
+    Shard            aoShards[SHARD_COUNT];
+
+    VSIMemFilesystemHandler();
     ~VSIMemFilesystemHandler() override;
 
+    Shard&           GetShard( const CPLString& osFilename );
+
     // TODO(schwehr): Fix VSIFileFromMemBuffer so that using is not needed.
     using VSIFilesystemHandler::Open;
 
@@ -300,6 +318,26 @@ int VSIMemHandle::Close()
     return 0;
 }
 
+/************************************************************************/
+/*                          AcquireReadView()                           */
+/************************************************************************/
+
+// The view points directly into the file buffer. The open handle holds a
+// reference on poFile, so the buffer stays alive as long as the views
+// are released before Close() and no write reallocates it.
+const void *VSIMemHandle::AcquireReadView( vsi_l_offset nOffset,
+                                           size_t nSize,
+                                           void** ppViewHandle )
+{
+    *ppViewHandle = nullptr;
+    if( nSize == 0 || nOffset > poFile->nLength ||
+        nSize > poFile->nLength - nOffset )
+        return nullptr;
+
+    *ppViewHandle = poFile;
+    return poFile->pabyData + static_cast<size_t>(nOffset);
+}
+
 /************************************************************************/
 /*                                Seek()                                */
 /************************************************************************/
@@ -467,6 +505,19 @@ int VSIMemHandle::Truncate( vsi_l_offset nNewSize )
 /* ==================================================================== */
 /************************************************************************/
 
+/************************************************************************/
+/*                       VSIMemFilesystemHandler()                      */
+/************************************************************************/
+
+VSIMemFilesystemHandler::VSIMemFilesystemHandler()
+{
+    for( auto& oShard : aoShards )
+    {
+        oShard.hMutex = CPLCreateMutex();
+        CPLReleaseMutex( oShard.hMutex );
+    }
+}
+
 /************************************************************************/
 /*                      ~VSIMemFilesystemHandler()                      */
 /************************************************************************/
@@ -474,15 +525,28 @@ int VSIMemHandle::Truncate( vsi_l_offset nNewSize )
 VSIMemFilesystemHandler::~VSIMemFilesystemHandler()
 
 {
-    for( const auto &iter : oFileList )
+    for( auto& oShard : aoShards )
     {
-        CPLAtomicDec(&iter.second->nRefCount);
-        delete iter.second;
+        for( const auto &iter : oShard.oFileList )
+        {
+            CPLAtomicDec(&iter.second->nRefCount);
+            delete iter.second;
+        }
+
+        if( oShard.hMutex != nullptr )
+            CPLDestroyMutex( oShard.hMutex );
+        oShard.hMutex = nullptr;
     }
+}
 
-    if( hMutex != nullptr )
-        CPLDestroyMutex( hMutex );
-    hMutex = nullptr;
+/************************************************************************/
+/*                                GetShard()                            */
+/************************************************************************/
+
+VSIMemFilesystemHandler::Shard&
+VSIMemFilesystemHandler::GetShard( const CPLString& osFilename )
+{
+    return aoShards[std::hash<std::string>()(osFilename) % SHARD_COUNT];
 }
 
 /************************************************************************/
@@ -495,7 +559,6 @@ VSIMemFilesystemHandler::Open( const char *pszFilename,
                                bool bSetError )
 
 {
-    CPLMutexHolder oHolder( &hMutex );
     const CPLString osFilename = NormalizePath(pszFilename);
     if( osFilename.empty() )
         return nullptr;
@@ -511,9 +574,13 @@ VSIMemFilesystemHandler::Open( const char *pszFilename,
 /* -------------------------------------------------------------------- */
 /*      Get the filename we are opening, create if needed.              */
 /* -------------------------------------------------------------------- */
+    Shard& oShard = GetShard(osFilename);
+    CPLMutexHolder oHolder( oShard.hMutex );
+
     VSIMemFile *poFile = nullptr;
-    if( oFileList.find(osFilename) != oFileList.end() )
-        poFile = oFileList[osFilename];
+    const auto oIter = oShard.oFileList.find(osFilename);
+    if( oIter != oShard.oFileList.end() )
+        poFile = oIter->second;
 
     // If no file and opening in read, error out.
     if( strstr(pszAccess, "w") == nullptr
@@ -533,7 +600,7 @@ VSIMemFilesystemHandler::Open( const char *pszFilename,
     {
         poFile = new VSIMemFile;
         poFile->osFilename = osFilename;
-        oFileList[poFile->osFilename] = poFile;
+        oShard.oFileList[poFile->osFilename] = poFile;
         CPLAtomicInc(&(poFile->nRefCount));  // For file list.
         poFile->nMaxLength = nMaxLength;
     }
@@ -580,8 +647,6 @@ int VSIMemFilesystemHandler::Stat( const char * pszFilename,
                                    int /* nFlags */ )
 
 {
-    CPLMutexHolder oHolder( &hMutex );
-
     const CPLString osFilename = NormalizePath(pszFilename);
 
     memset( pStatBuf, 0, sizeof(VSIStatBufL) );
@@ -593,13 +658,17 @@ int VSIMemFilesystemHandler::Stat( const char * pszFilename,
         return 0;
     }
 
-    if( oFileList.find(osFilename) == oFileList.end() )
+    Shard& oShard = GetShard(osFilename);
+    CPLMutexHolder oHolder( oShard.hMutex );
+
+    const auto oIter = oShard.oFileList.find(osFilename);
+    if( oIter == oShard.oFileList.end() )
     {
         errno = ENOENT;
         return -1;
     }
 
-    VSIMemFile *poFile = oFileList[osFilename];
+    VSIMemFile *poFile = oIter->second;
 
     memset( pStatBuf, 0, sizeof(VSIStatBufL) );
 
@@ -625,32 +694,35 @@ int VSIMemFilesystemHandler::Stat( const char * pszFilename,
 int VSIMemFilesystemHandler::Unlink( const char * pszFilename )
 
 {
-    CPLMutexHolder oHolder( &hMutex );
-    return Unlink_unlocked(pszFilename);
+    const CPLString osFilename = NormalizePath(pszFilename);
+    CPLMutexHolder oHolder( GetShard(osFilename).hMutex );
+    return Unlink_unlocked(osFilename);
 }
 
 /************************************************************************/
 /*                           Unlink_unlocked()                          */
 /************************************************************************/
 
+// The caller must hold the mutex of the shard of the (normalized) filename.
 int VSIMemFilesystemHandler::Unlink_unlocked( const char * pszFilename )
 
 {
     const CPLString osFilename = NormalizePath(pszFilename);
+    Shard& oShard = GetShard(osFilename);
 
-    if( oFileList.find(osFilename) == oFileList.end() )
+    const auto oIter = oShard.oFileList.find(osFilename);
+    if( oIter == oShard.oFileList.end() )
     {
         errno = ENOENT;
         return -1;
     }
 
-    VSIMemFile *poFile = oFileList[osFilename];
+    VSIMemFile *poFile = oIter->second;
+    oShard.oFileList.erase( oIter );
 
     if( CPLAtomicDec(&(poFile->nRefCount)) == 0 )
         delete poFile;
 
-    oFileList.erase( oFileList.find(osFilename) );
-
     return 0;
 }
 
@@ -662,11 +734,12 @@ int VSIMemFilesystemHandler::Mkdir( const char * pszPathname,
                                     long /* nMode */ )
 
 {
-    CPLMutexHolder oHolder( &hMutex );
-
     const CPLString osPathname = NormalizePath(pszPathname);
 
-    if( oFileList.find(osPathname) != oFileList.end() )
+    Shard& oShard = GetShard(osPathname);
+    CPLMutexHolder oHolder( oShard.hMutex );
+
+    if( oShard.oFileList.find(osPathname) != oShard.oFileList.end() )
     {
         errno = EEXIST;
         return -1;
@@ -676,7 +749,7 @@ int VSIMemFilesystemHandler::Mkdir( const char * pszPathname,
 
     poFile->osFilename = osPathname;
     poFile->bIsDirectory = true;
-    oFileList[osPathname] = poFile;
+    oShard.oFileList[osPathname] = poFile;
     CPLAtomicInc(&(poFile->nRefCount));  // Referenced by file list.
 
     return 0;
@@ -700,48 +773,45 @@ char **VSIMemFilesystemHandler::ReadDirEx( const char *pszPath,
                                            int nMaxFiles )
 
 {
-    CPLMutexHolder oHolder( &hMutex );
-
     const CPLString osPath = NormalizePath(pszPath);
 
-    char **papszDir = nullptr;
     size_t nPathLen = osPath.size();
 
     if( nPathLen > 0 && osPath.back() == '/' )
         nPathLen--;
 
-    // In case of really big number of files in the directory, CSLAddString
-    // can be slow (see #2158). We then directly build the list.
-    int nItems = 0;
-    int nAllocatedItems = 0;
-
-    for( const auto& iter : oFileList )
+    // Collect the entries of all shards, and sort them to return them in
+    // the same order as if there was a single table.
+    std::vector<CPLString> aosEntries;
+    for( auto& oShard : aoShards )
     {
-        const char *pszFilePath = iter.second->osFilename.c_str();
-        if( EQUALN(osPath, pszFilePath, nPathLen)
-            && pszFilePath[nPathLen] == '/'
-            && strstr(pszFilePath+nPathLen+1, "/") == nullptr )
+        CPLMutexHolder oHolder( oShard.hMutex );
+        for( const auto& iter : oShard.oFileList )
         {
-            if( nItems == 0 )
+            const char *pszFilePath = iter.second->osFilename.c_str();
+            if( EQUALN(osPath, pszFilePath, nPathLen)
+                && pszFilePath[nPathLen] == '/'
+                && strstr(pszFilePath+nPathLen+1, "/") == nullptr )
             {
-                papszDir = static_cast<char**>(CPLCalloc(2, sizeof(char*)));
-                nAllocatedItems = 1;
+                aosEntries.push_back(pszFilePath+nPathLen+1);
             }
-            else if( nItems >= nAllocatedItems )
-            {
-                nAllocatedItems = nAllocatedItems * 2;
-                papszDir = static_cast<char**>(
-                    CPLRealloc(papszDir, (nAllocatedItems + 2)*sizeof(char*)) );
-            }
-
-            papszDir[nItems] = CPLStrdup(pszFilePath+nPathLen+1);
-            papszDir[nItems+1] = nullptr;
-
-            nItems++;
-            if( nMaxFiles > 0 && nItems > nMaxFiles )
-                break;
         }
     }
+    if( aosEntries.empty() )
+        return nullptr;
+    std::sort(aosEntries.begin(), aosEntries.end());
+    if( nMaxFiles > 0 &&
+        aosEntries.size() > static_cast<size_t>(nMaxFiles) + 1 )
+    {
+        aosEntries.resize(static_cast<size_t>(nMaxFiles) + 1);
+    }
+
+    // In case of really big number of files in the directory, CSLAddString
+    // can be slow (see #2158). We then directly build the list.
+    char **papszDir = static_cast<char**>(
+        CPLCalloc(aosEntries.size() + 1, sizeof(char*)));
+    for( size_t i = 0; i < aosEntries.size(); i++ )
+        papszDir[i] = CPLStrdup(aosEntries[i]);
 
     return papszDir;
 }
@@ -754,39 +824,61 @@ int VSIMemFilesystemHandler::Rename( const char *pszOldPath,
                                      const char *pszNewPath )
 
 {
-    CPLMutexHolder oHolder( &hMutex );
-
     const CPLString osOldPath = NormalizePath(pszOldPath);
     const CPLString osNewPath = NormalizePath(pszNewPath);
 
     if( osOldPath.compare(osNewPath) == 0 )
         return 0;
 
-    if( oFileList.find(osOldPath) == oFileList.end() )
+    // The renamed file and its children, if it is a directory, are spread
+    // over all shards: lock them all, in index order to avoid deadlocks.
+    for( auto& oShard : aoShards )
+        CPLAcquireMutex( oShard.hMutex, 1000.0 );
+
+    int nRet = 0;
+    Shard& oOldShard = GetShard(osOldPath);
+    if( oOldShard.oFileList.find(osOldPath) == oOldShard.oFileList.end() )
     {
         errno = ENOENT;
-        return -1;
+        nRet = -1;
     }
-
-    std::map<CPLString, VSIMemFile*>::iterator it = oFileList.find(osOldPath);
-    while( it != oFileList.end() && it->first.ifind(osOldPath) == 0 )
+    else
     {
-        const CPLString osRemainder = it->first.substr(osOldPath.size());
-        if( osRemainder.empty() || osRemainder[0] == '/' )
+        std::vector<std::pair<CPLString, VSIMemFile*>> aoMoved;
+        for( auto& oShard : aoShards )
         {
-            const CPLString osNewFullPath = osNewPath + osRemainder;
-            Unlink_unlocked(osNewFullPath);
-            oFileList[osNewFullPath] = it->second;
-            it->second->osFilename = osNewFullPath;
-            oFileList.erase(it++);
+            auto it = oShard.oFileList.begin();
+            while( it != oShard.oFileList.end() )
+            {
+                // Children are matched case insensitively, as they always
+                // have been.
+                if( it->first.ifind(osOldPath) == 0 &&
+                    (it->first.size() == osOldPath.size() ||
+                     it->first[osOldPath.size()] == '/') )
+                {
+                    aoMoved.push_back(*it);
+                    oShard.oFileList.erase(it++);
+                }
+                else
+                {
+                    ++it;
+                }
+            }
         }
-        else
+        for( auto& oMoved : aoMoved )
         {
-            ++it;
+            const CPLString osNewFullPath =
+                osNewPath + oMoved.first.substr(osOldPath.size());
+            Unlink_unlocked(osNewFullPath);
+            GetShard(osNewFullPath).oFileList[osNewFullPath] = oMoved.second;
+            oMoved.second->osFilename = osNewFullPath;
         }
     }
 
-    return 0;
+    for( int i = SHARD_COUNT - 1; i >= 0; i-- )
+        CPLReleaseMutex( aoShards[i].hMutex );
+
+    return nRet;
 }
 
 /************************************************************************/
@@ -926,9 +1018,11 @@ VSILFILE *VSIFileFromMemBuffer( const char *pszFilename,
     poFile->nAllocLength = nDataLength;
 
     {
-        CPLMutexHolder oHolder( &poHandler->hMutex );
+        VSIMemFilesystemHandler::Shard& oShard =
+            poHandler->GetShard(osFilename);
+        CPLMutexHolder oHolder( oShard.hMutex );
         poHandler->Unlink_unlocked(osFilename);
-        poHandler->oFileList[poFile->osFilename] = poFile;
+        oShard.oFileList[poFile->osFilename] = poFile;
         CPLAtomicInc(&(poFile->nRefCount));
     }
 
@@ -971,12 +1065,14 @@ GByte *VSIGetMemFileBuffer( const char *pszFilename,
     const CPLString osFilename =
         VSIMemFilesystemHandler::NormalizePath(pszFilename);
 
-    CPLMutexHolder oHolder( &poHandler->hMutex );
+    VSIMemFilesystemHandler::Shard& oShard = poHandler->GetShard(osFilename);
+    CPLMutexHolder oHolder( oShard.hMutex );
 
-    if( poHandler->oFileList.find(osFilename) == poHandler->oFileList.end() )
+    const auto oIter = oShard.oFileList.find(osFilename);
+    if( oIter == oShard.oFileList.end() )
         return nullptr;
 
-    VSIMemFile *poFile = poHandler->oFileList[osFilename];
+    VSIMemFile *poFile = oIter->second;
     GByte *pabyData = poFile->pabyData;
     if( pnDataLength != nullptr )
         *pnDataLength = poFile->nLength;
@@ -989,7 +1085,7 @@ GByte *VSIGetMemFileBuffer( const char *pszFilename,
         else
             poFile->bOwnData = false;
 
-        poHandler->oFileList.erase( poHandler->oFileList.find(osFilename) );
+        oShard.oFileList.erase( oIter );
         CPLAtomicDec(&(poFile->nRefCount));
         delete poFile;
     }
@@ -71,6 +71,9 @@ class CPL_DLL VSIVirtualHandle {
     virtual VSIRangeStatus GetRangeStatus( CPL_UNUSED vsi_l_offset nOffset,
                                            CPL_UNUSED vsi_l_offset nLength )
                                           { return VSI_RANGE_STATUS_UNKNOWN; }
+    virtual const void *AcquireReadView( vsi_l_offset nOffset, size_t nSize,
+                                         void** ppViewHandle );
+    virtual void      ReleaseReadView( void* pViewHandle );
 
     virtual           ~VSIVirtualHandle() { }
 };
@@ -209,6 +212,14 @@ protected:
     virtual std::vector<CPLString> GetExtensions() = 0;
     virtual VSIArchiveReader* CreateReader(const char* pszArchiveFileName) = 0;
 
+    /* Persistence of the listing of archives across processes, when */
+    /* CPL_VSIL_ARCHIVE_INDEX_DIR is set. */
+    virtual bool SerializeFileOffset(const VSIArchiveEntryFileOffset* poOffset, CPLString& osOut);
+    virtual VSIArchiveEntryFileOffset* DeserializeFileOffset(const char* pszIn);
+    CPLString GetPersistedIndexFilename(const char* archiveFilename);
+    VSIArchiveContent* LoadPersistedContent(const char* archiveFilename, const VSIStatBufL& sStat);
+    void SavePersistedContent(const char* archiveFilename, const VSIArchiveContent* content);
+
 public:
     VSIArchiveFilesystemHandler();
     virtual ~VSIArchiveFilesystemHandler();
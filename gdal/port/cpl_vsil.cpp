@@ -1700,6 +1700,103 @@ void *VSIFGetNativeFileDescriptorL( VSILFILE* fp )
     return poFileHandle->GetNativeFileDescriptor();
 }
 
+/************************************************************************/
+/*                        VSIFAcquireReadViewL()                        */
+/************************************************************************/
+
+/**
+ * \fn VSIVirtualHandle::AcquireReadView( vsi_l_offset nOffset,
+ *                                        size_t nSize,
+ *                                        void** ppViewHandle )
+ * \brief Borrow a read-only view of a range of bytes of the file.
+ *
+ * See VSIFAcquireReadViewL() for the lifetime of the view and the file
+ * systems that return a memory mapping.
+ *
+ * @param nOffset offset of the first byte of the range.
+ * @param nSize number of bytes of the range. Must not be 0.
+ * @param ppViewHandle pointer to a location receiving the opaque handle
+ *                     to pass to ReleaseReadView(). Must not be NULL.
+ *
+ * @return a pointer to the range content, or NULL in case of error
+ *         (typically if the range extends beyond the end of file)
+ * @since GDAL 2.4
+ */
+
+/**
+ * \brief Borrow a read-only view of a range of bytes of the file.
+ *
+ * The returned pointer gives access to nSize bytes starting at nOffset
+ * without requiring the caller to provide a buffer. Depending on the
+ * file system, the view may be a memory mapping of a local file, a direct
+ * pointer into a /vsimem/ file, or a private buffer filled by a regular read.
+ *
+ * The content of the view must not be modified. It remains valid, whatever
+ * the subsequent VSIFSeekL() or VSIFReadL() operations on the handle, until
+ * VSIFReleaseReadViewL() is called with the handle returned in *ppViewHandle.
+ * Writing into the file or truncating it while a view is alive results in
+ * undefined content of the view. All views must be released before the
+ * file handle is closed.
+ *
+ * Only the local file system of POSIX systems currently returns a memory
+ * mapping, for ranges of at least 64 KB. /vsimem/ returns a pointer into the
+ * file content, and all other file systems (including the local file system
+ * on Windows) return a private buffer. With a memory mapping, truncation of
+ * the file, by this or another process, is not only a matter of content: on
+ * most systems, accessing the part of the view beyond the new end of file
+ * raises a SIGBUS signal that terminates the process. Callers that cannot
+ * rule out concurrent truncation should read into their own buffer instead.
+ *
+ * The current position of the file handle is not modified.
+ *
+ * @param fp file handle opened with VSIFOpenL().
+ * @param nOffset offset of the first byte of the range.
+ * @param nSize number of bytes of the range. Must not be 0.
+ * @param ppViewHandle pointer to a location receiving the opaque handle
+ *                     to pass to VSIFReleaseReadViewL(). Must not be NULL.
+ *
+ * @return a pointer to the range content, or NULL in case of error
+ *         (typically if the range extends beyond the end of file)
+ * @since GDAL 2.4
+ */
+
+const void *VSIFAcquireReadViewL( VSILFILE* fp, vsi_l_offset nOffset,
+                                  size_t nSize, void** ppViewHandle )
+{
+    VSIVirtualHandle *poFileHandle = reinterpret_cast<VSIVirtualHandle *>( fp );
+
+    return poFileHandle->AcquireReadView(nOffset, nSize, ppViewHandle);
+}
+
+/************************************************************************/
+/*                        VSIFReleaseReadViewL()                        */
+/************************************************************************/
+
+/**
+ * \fn VSIVirtualHandle::ReleaseReadView( void* pViewHandle )
+ * \brief Release a view acquired with AcquireReadView().
+ *
+ * @param pViewHandle the handle returned by AcquireReadView() in
+ *                    *ppViewHandle. NULL is accepted and ignored.
+ * @since GDAL 2.4
+ */
+
+/**
+ * \brief Release a view acquired with VSIFAcquireReadViewL().
+ *
+ * @param fp file handle on which the view was acquired.
+ * @param pViewHandle the handle returned by VSIFAcquireReadViewL() in
+ *                    *ppViewHandle. NULL is accepted and ignored.
+ * @since GDAL 2.4
+ */
+
+void VSIFReleaseReadViewL( VSILFILE* fp, void* pViewHandle )
+{
+    VSIVirtualHandle *poFileHandle = reinterpret_cast<VSIVirtualHandle *>( fp );
+
+    poFileHandle->ReleaseReadView(pViewHandle);
+}
+
 /************************************************************************/
 /*                      VSIGetDiskFreeSpace()                           */
 /************************************************************************/
@@ -2048,4 +2145,45 @@ int VSIVirtualHandle::ReadMultiRange( int nRanges, void ** ppData,
     return nRet;
 }
 
+/************************************************************************/
+/*                          AcquireReadView()                           */
+/************************************************************************/
+
+// Base implementation: the view is a private copy of the range, and the
+// view handle is that buffer.
+const void *VSIVirtualHandle::AcquireReadView( vsi_l_offset nOffset,
+                                               size_t nSize,
+                                               void** ppViewHandle )
+{
+    *ppViewHandle = nullptr;
+    if( nSize == 0 )
+        return nullptr;
+
+    void* pBuffer = VSI_MALLOC_VERBOSE(nSize);
+    if( pBuffer == nullptr )
+        return nullptr;
+
+    const vsi_l_offset nCurOffset = Tell();
+    const bool bOK = Seek(nOffset, SEEK_SET) == 0 &&
+                     Read(pBuffer, 1, nSize) == nSize;
+    Seek(nCurOffset, SEEK_SET);
+    if( !bOK )
+    {
+        VSIFree(pBuffer);
+        return nullptr;
+    }
+
+    *ppViewHandle = pBuffer;
+    return pBuffer;
+}
+
+/************************************************************************/
+/*                          ReleaseReadView()                           */
+/************************************************************************/
+
+void VSIVirtualHandle::ReleaseReadView( void* pViewHandle )
+{
+    VSIFree(pViewHandle);
+}
+
 #endif  // #ifndef DOXYGEN_SKIP
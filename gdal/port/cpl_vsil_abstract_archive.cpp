@@ -43,6 +43,7 @@
 #include "cpl_conv.h"
 #include "cpl_error.h"
 #include "cpl_multiproc.h"
+#include "cpl_sha256.h"
 #include "cpl_string.h"
 #include "cpl_vsi.h"
 
@@ -146,6 +147,236 @@ static CPLString GetStrippedFilename(const CPLString& osFileName,
     return osRet;
 }
 
+/************************************************************************/
+/*                        SerializeFileOffset()                         */
+/************************************************************************/
+
+bool VSIArchiveFilesystemHandler::SerializeFileOffset(
+    const VSIArchiveEntryFileOffset* /* poOffset */, CPLString& /* osOut */ )
+{
+    return false;
+}
+
+/************************************************************************/
+/*                       DeserializeFileOffset()                        */
+/************************************************************************/
+
+VSIArchiveEntryFileOffset* VSIArchiveFilesystemHandler::DeserializeFileOffset(
+    const char* /* pszIn */ )
+{
+    return nullptr;
+}
+
+/************************************************************************/
+/*                    GetAbsoluteArchiveFilename()                      */
+/************************************************************************/
+
+// Return the archive filename made absolute against the current directory,
+// without "." components, so that the persisted listing of an archive does
+// not depend on the directory it was opened from.
+static CPLString GetAbsoluteArchiveFilename( const char* archiveFilename )
+{
+    CPLString osFilename(archiveFilename);
+    if( CPLIsFilenameRelative(archiveFilename) )
+    {
+        char* pszCurDir = CPLGetCurrentDir();
+        if( pszCurDir != nullptr )
+        {
+            while( STARTS_WITH(osFilename, "./") )
+                osFilename = osFilename.substr(2);
+            osFilename = CPLFormFilename(pszCurDir, osFilename, nullptr);
+            CPLFree(pszCurDir);
+        }
+    }
+    size_t nPos;
+    while( (nPos = osFilename.find("/./")) != std::string::npos )
+        osFilename.erase(nPos, 2);
+    return osFilename;
+}
+
+/************************************************************************/
+/*                     GetPersistedIndexFilename()                      */
+/************************************************************************/
+
+// Return the name of the file where the listing of the archive is
+// persisted, or an empty string if CPL_VSIL_ARCHIVE_INDEX_DIR is not set.
+CPLString VSIArchiveFilesystemHandler::GetPersistedIndexFilename(
+    const char* archiveFilename )
+{
+    const char* pszDir =
+        CPLGetConfigOption("CPL_VSIL_ARCHIVE_INDEX_DIR", nullptr);
+    if( pszDir == nullptr || pszDir[0] == '\0' )
+        return CPLString();
+
+    CPLString osKey(GetPrefix());
+    osKey += '/';
+    osKey += GetAbsoluteArchiveFilename(archiveFilename);
+    GByte abyHash[CPL_SHA256_HASH_SIZE] = {};
+    CPL_SHA256(osKey.data(), osKey.size(), abyHash);
+    char* pszHash = CPLBinaryToHex(CPL_SHA256_HASH_SIZE, abyHash);
+    CPLString osIndexFilename(CPLFormFilename(pszDir, pszHash, "idx"));
+    CPLFree(pszHash);
+    return osIndexFilename;
+}
+
+/************************************************************************/
+/*                        LoadPersistedContent()                        */
+/************************************************************************/
+
+// Load the listing of the archive saved by SavePersistedContent(), if it is
+// still valid for the current size and modification time of the archive.
+VSIArchiveContent* VSIArchiveFilesystemHandler::LoadPersistedContent(
+    const char* archiveFilename, const VSIStatBufL& sStat )
+{
+    const CPLString osIndexFilename =
+        GetPersistedIndexFilename(archiveFilename);
+    if( osIndexFilename.empty() )
+        return nullptr;
+
+    VSILFILE* fp = VSIFOpenL(osIndexFilename, "rb");
+    if( fp == nullptr )
+        return nullptr;
+
+    char* pszEscapedArchiveFilename =
+        CPLEscapeString(GetAbsoluteArchiveFilename(archiveFilename), -1,
+                        CPLES_URL);
+    const CPLString osExpectedArchive(
+        CPLString("archive=") + pszEscapedArchiveFilename);
+    CPLFree(pszEscapedArchiveFilename);
+
+    VSIArchiveContent* content = nullptr;
+    const char* pszLine = CPLReadLineL(fp);
+    if( pszLine && EQUAL(pszLine, "GDAL_VSI_ARCHIVE_INDEX 1") &&
+        (pszLine = CPLReadLineL(fp)) != nullptr &&
+        osExpectedArchive == pszLine &&
+        (pszLine = CPLReadLineL(fp)) != nullptr &&
+        STARTS_WITH(pszLine, "size=") &&
+        CPLScanUIntBig(pszLine + strlen("size="),
+                       static_cast<int>(strlen(pszLine + strlen("size=")))) ==
+            static_cast<GUIntBig>(sStat.st_size) &&
+        (pszLine = CPLReadLineL(fp)) != nullptr &&
+        STARTS_WITH(pszLine, "mtime=") &&
+        CPLAtoGIntBig(pszLine + strlen("mtime=")) ==
+            static_cast<GIntBig>(sStat.st_mtime) &&
+        (pszLine = CPLReadLineL(fp)) != nullptr &&
+        STARTS_WITH(pszLine, "entries=") )
+    {
+        const int nEntries = atoi(pszLine + strlen("entries="));
+        if( nEntries > 0 && nEntries < 100 * 1000 * 1000 )
+        {
+            content = new VSIArchiveContent;
+            content->mTime = sStat.st_mtime;
+            content->nFileSize = static_cast<vsi_l_offset>(sStat.st_size);
+            content->entries = static_cast<VSIArchiveEntry *>(
+                VSI_CALLOC_VERBOSE(nEntries, sizeof(VSIArchiveEntry)));
+            if( content->entries == nullptr )
+            {
+                delete content;
+                content = nullptr;
+            }
+        }
+        while( content != nullptr && content->nEntries < nEntries )
+        {
+            pszLine = CPLReadLineL(fp);
+            char** papszTokens = pszLine ?
+                CSLTokenizeString2(pszLine, "\t", CSLT_ALLOWEMPTYTOKENS) :
+                nullptr;
+            VSIArchiveEntryFileOffset* poOffset = nullptr;
+            if( CSLCount(papszTokens) != 5 ||
+                (!EQUAL(papszTokens[4], "-") &&
+                 (poOffset = DeserializeFileOffset(papszTokens[4])) ==
+                                                                nullptr) )
+            {
+                CSLDestroy(papszTokens);
+                delete content;
+                content = nullptr;
+                break;
+            }
+            int nLength = 0;
+            VSIArchiveEntry& entry = content->entries[content->nEntries];
+            entry.fileName = CPLUnescapeString(papszTokens[0], &nLength,
+                                               CPLES_URL);
+            entry.bIsDir = atoi(papszTokens[1]);
+            entry.uncompressed_size = CPLScanUIntBig(
+                papszTokens[2], static_cast<int>(strlen(papszTokens[2])));
+            entry.nModifiedTime = CPLAtoGIntBig(papszTokens[3]);
+            entry.file_pos = poOffset;
+            content->nEntries++;
+            CSLDestroy(papszTokens);
+        }
+    }
+    CPL_IGNORE_RET_VAL(VSIFCloseL(fp));
+
+    if( content )
+    {
+        CPLDebug("VSIArchive", "Using persisted listing %s for %s",
+                 osIndexFilename.c_str(), archiveFilename);
+    }
+    return content;
+}
+
+/************************************************************************/
+/*                        SavePersistedContent()                        */
+/************************************************************************/
+
+void VSIArchiveFilesystemHandler::SavePersistedContent(
+    const char* archiveFilename, const VSIArchiveContent* content )
+{
+    const CPLString osIndexFilename =
+        GetPersistedIndexFilename(archiveFilename);
+    if( osIndexFilename.empty() || content->nEntries == 0 )
+        return;
+
+    CPLString osContent("GDAL_VSI_ARCHIVE_INDEX 1\n");
+    char* pszEscaped = CPLEscapeString(
+        GetAbsoluteArchiveFilename(archiveFilename), -1, CPLES_URL);
+    osContent += CPLSPrintf("archive=%s\n", pszEscaped);
+    CPLFree(pszEscaped);
+    osContent += CPLSPrintf("size=" CPL_FRMT_GUIB "\n",
+                            static_cast<GUIntBig>(content->nFileSize));
+    osContent += CPLSPrintf("mtime=" CPL_FRMT_GIB "\n",
+                            static_cast<GIntBig>(content->mTime));
+    osContent += CPLSPrintf("entries=%d\n", content->nEntries);
+    for( int i = 0; i < content->nEntries; i++ )
+    {
+        const VSIArchiveEntry& entry = content->entries[i];
+        CPLString osOffset("-");
+        if( entry.file_pos != nullptr &&
+            !SerializeFileOffset(entry.file_pos, osOffset) )
+        {
+            return;
+        }
+        pszEscaped = CPLEscapeString(entry.fileName, -1, CPLES_URL);
+        osContent += CPLSPrintf("%s\t%d\t" CPL_FRMT_GUIB "\t" CPL_FRMT_GIB "\t",
+                                pszEscaped, entry.bIsDir ? 1 : 0,
+                                static_cast<GUIntBig>(entry.uncompressed_size),
+                                entry.nModifiedTime);
+        CPLFree(pszEscaped);
+        osContent += osOffset;
+        osContent += '\n';
+    }
+
+    // Write to a temporary file and rename it, so that concurrent processes
+    // never see a partially written index.
+    const CPLString osTmpFilename(
+        osIndexFilename + CPLSPrintf("." CPL_FRMT_GIB ".tmp", CPLGetPID()));
+    VSILFILE* fp = VSIFOpenL(osTmpFilename, "wb");
+    if( fp == nullptr )
+    {
+        CPLDebug("VSIArchive", "Cannot create %s", osTmpFilename.c_str());
+        return;
+    }
+    const bool bOK =
+        VSIFWriteL(osContent.data(), 1, osContent.size(), fp) ==
+                                                        osContent.size();
+    if( VSIFCloseL(fp) != 0 || !bOK ||
+        VSIRename(osTmpFilename, osIndexFilename) != 0 )
+    {
+        CPLDebug("VSIArchive", "Cannot write %s", osIndexFilename.c_str());
+        VSIUnlink(osTmpFilename);
+    }
+}
+
 /************************************************************************/
 /*                       GetContentOfArchive()                          */
 /************************************************************************/
@@ -177,6 +408,16 @@ const VSIArchiveContent* VSIArchiveFilesystemHandler::GetContentOfArchive(
         }
     }
 
+    {
+        VSIArchiveContent* content =
+            LoadPersistedContent(archiveFilename, sStat);
+        if( content )
+        {
+            oFileList[archiveFilename] = content;
+            return content;
+        }
+    }
+
     bool bMustClose = poReader == nullptr;
     if( poReader == nullptr )
     {
@@ -282,6 +523,8 @@ const VSIArchiveContent* VSIArchiveFilesystemHandler::GetContentOfArchive(
     if( bMustClose )
         delete(poReader);
 
+    SavePersistedContent(archiveFilename, content);
+
     return content;
 }
 
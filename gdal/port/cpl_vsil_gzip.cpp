@@ -114,6 +114,8 @@
 CPL_CVSID("$Id$")
 
 constexpr int Z_BUFSIZE = 65536;  // Original size is 16384
+// Maximum number of compressed bytes between 2 snapshots of a zip member.
+constexpr int MAX_ZIP_SNAPSHOT_BYTE_INTERVAL = 8 * 1024 * 1024;
 constexpr int gz_magic[2] = {0x1f, 0x8b};  // gzip magic header
 
 // gzip flag byte.
@@ -392,6 +394,15 @@ VSIGZipHandle::VSIGZipHandle( VSIVirtualHandle* poBaseHandle,
     {
         snapshot_byte_interval = std::max(
             static_cast<vsi_l_offset>(Z_BUFSIZE), compressed_size / 100);
+        // Zip members (no base filename) are not duplicated through
+        // VSIGZipFilesystemHandler::SaveInfo(), so we can afford denser
+        // snapshots to speed up random access in large members.
+        if( pszBaseFileName == nullptr )
+        {
+            snapshot_byte_interval = std::min(
+                snapshot_byte_interval,
+                static_cast<vsi_l_offset>(MAX_ZIP_SNAPSHOT_BYTE_INTERVAL));
+        }
         snapshots = static_cast<GZipSnapshot *>(
             CPLCalloc(sizeof(GZipSnapshot),
                       static_cast<size_t>(
@@ -1183,6 +1194,992 @@ int VSIGZipHandle::Close()
     return 0;
 }
 
+/************************************************************************/
+/* ==================================================================== */
+/*                       VSIGZipReadHandleMT                            */
+/* ==================================================================== */
+/************************************************************************/
+
+// Read-only handle that uncompresses ahead, on a pool of worker threads,
+// gzip files made of independently decodable segments:
+// - BGZF files, i.e. a sequence of gzip members, each of them with a 'BC'
+//   extra subfield giving its compressed size, and a ISIZE trailer giving
+//   its uncompressed size. The index of segments can be built without
+//   uncompressing anything.
+// - single members written with independent blocks, as done by
+//   pigz --independent or VSIGZipWriteHandleMT, where each block ends with
+//   the 0x00 0x00 0xff 0xff 0x00 0x00 0x00 0xff 0xff sequence of a
+//   Z_SYNC_FLUSH followed by a Z_FULL_FLUSH. The uncompressed size of those
+//   segments is only known once they have been uncompressed.
+// Segments are delivered to the reader in order.
+// Files that turn out not to have that structure, such as concatenations
+// of regular gzip members, are read through a sequential VSIGZipHandle from
+// the point where the inconsistency is detected.
+
+class VSIGZipReadHandleMT final : public VSIVirtualHandle
+{
+    CPL_DISALLOW_COPY_ASSIGN(VSIGZipReadHandleMT)
+
+    struct Segment
+    {
+        vsi_l_offset       nCompressedOffset = 0;  // start of deflate data
+        size_t             nCompressedSize = 0;
+        size_t             nUncompressedSize = 0;
+        bool               bUncompressedSizeKnown = false;
+        uLong              nExpectedCRC = 0;  // BGZF only
+    };
+
+    struct Job
+    {
+        VSIGZipReadHandleMT *pParent_ = nullptr;
+        size_t             nSegment_ = 0;
+        bool               bBGZF_ = false;
+        size_t             nExpectedSize_ = 0;
+        uLong              nExpectedCRC_ = 0;
+        std::string        sCompressedData_{};
+        std::string        sUncompressedData_{};
+        uLong              nCRC_ = 0;
+        bool               bStreamEnd_ = false;
+        bool               bOK_ = false;
+        bool               bFinished_ = false;
+        bool               bOrphan_ = false;
+    };
+
+    VSIVirtualHandle*  poBaseHandle_ = nullptr;
+    CPLString          osBaseFilename_{};
+    vsi_l_offset       nFileSize_ = 0;
+    bool               bBGZF_ = false;
+    int                nThreads_ = 0;
+    std::unique_ptr<CPLWorkerThreadPool> poPool_{};
+    std::mutex         sMutex_{};
+    std::map<size_t, Job*> oMapJobs_{};
+
+    std::vector<Segment> aoSegments_{};
+    // Uncompressed offsets of the first segments whose size is known. Has
+    // one more element than the number of such segments.
+    std::vector<vsi_l_offset> anUncompressedOffsets_{};
+    vsi_l_offset       nNextScanOffset_ = 0;
+    bool               bScanFinished_ = false;
+    uLong              nStreamCRC_ = 0;  // independent blocks mode only
+
+    vsi_l_offset       nCurOffset_ = 0;
+    size_t             nCurSegment_ = 0;
+    std::string        sCurData_{};
+    bool               bCurDataValid_ = false;
+    bool               bEOF_ = false;
+    bool               bError_ = false;
+    std::string        osErrorMsg_{};
+    VSIVirtualHandle*  poSequentialHandle_ = nullptr;
+
+    static void InflateJob(void* inData);
+
+    void SetError( const char* pszFmt, ... ) CPL_PRINT_FUNC_FORMAT (2, 3);
+    bool SwitchToSequentialReader();
+
+    bool ScanNextSegment();
+    bool ScanNextBGZFMember();
+    bool ScanNextIndependentBlock();
+    bool CollectFinishedJobs();
+    bool SubmitJobs(size_t nFirstSegment);
+    bool WaitForSegment(size_t nSegment);
+    bool LoadSegmentContaining(vsi_l_offset nOffset);
+    int  GetReadAheadCount() const { return 2 * nThreads_; }
+
+  public:
+    VSIGZipReadHandleMT( VSIVirtualHandle* poBaseHandle,
+                         const char* pszBaseFilename,
+                         vsi_l_offset nFileSize,
+                         vsi_l_offset nFirstDataOffset,
+                         bool bBGZF,
+                         int nThreads );
+    ~VSIGZipReadHandleMT() override;
+
+    static bool ParseHeader( const GByte* pabyData, size_t nDataSize,
+                             size_t& nHeaderSize, int& nBSize );
+
+    int Seek( vsi_l_offset nOffset, int nWhence ) override;
+    vsi_l_offset Tell() override;
+    size_t Read( void *pBuffer, size_t nSize, size_t nMemb ) override;
+    size_t Write( const void *pBuffer, size_t nSize, size_t nMemb ) override;
+    int Eof() override;
+    int Flush() override;
+    int Close() override;
+};
+
+// Sequence emitted by a Z_SYNC_FLUSH followed by a Z_FULL_FLUSH.
+constexpr char szIndependentBlockMarker[] =
+    "\x00\x00\xFF\xFF\x00\x00\x00\xFF\xFF";
+constexpr size_t INDEPENDENT_BLOCK_MARKER_SIZE = 9;
+
+// Upper bound for the size of a compressed segment. Above, there is no
+// benefit in parallel decompression and we would use too much memory.
+constexpr size_t MAX_SEGMENT_SIZE = 32 * 1024 * 1024;
+
+// Compressed files smaller than that are uncompressed sequentially, as
+// fast as detecting their structure.
+constexpr vsi_l_offset MIN_MT_READ_FILE_SIZE = 1024 * 1024;
+
+/************************************************************************/
+/*                        VSIGZipReadHandleMT()                         */
+/************************************************************************/
+
+VSIGZipReadHandleMT::VSIGZipReadHandleMT( VSIVirtualHandle* poBaseHandle,
+                                          const char* pszBaseFilename,
+                                          vsi_l_offset nFileSize,
+                                          vsi_l_offset nFirstDataOffset,
+                                          bool bBGZF,
+                                          int nThreads ) :
+    poBaseHandle_(poBaseHandle),
+    osBaseFilename_(pszBaseFilename),
+    nFileSize_(nFileSize),
+    bBGZF_(bBGZF),
+    nThreads_(nThreads),
+    // In BGZF mode, we scan from the start of the member header.
+    nNextScanOffset_(bBGZF ? 0 : nFirstDataOffset)
+{
+    anUncompressedOffsets_.push_back(0);
+}
+
+/************************************************************************/
+/*                       ~VSIGZipReadHandleMT()                         */
+/************************************************************************/
+
+VSIGZipReadHandleMT::~VSIGZipReadHandleMT()
+{
+    Close();
+}
+
+/************************************************************************/
+/*                               Close()                                */
+/************************************************************************/
+
+int VSIGZipReadHandleMT::Close()
+{
+    if( poPool_ )
+    {
+        poPool_->WaitCompletion(0);
+        poPool_.reset();
+    }
+    for( auto& oIter: oMapJobs_ )
+        delete oIter.second;
+    oMapJobs_.clear();
+
+    int nRet = 0;
+    if( poBaseHandle_ )
+    {
+        nRet = poBaseHandle_->Close();
+        delete poBaseHandle_;
+        poBaseHandle_ = nullptr;
+    }
+    if( poSequentialHandle_ )
+    {
+        nRet = poSequentialHandle_->Close();
+        delete poSequentialHandle_;
+        poSequentialHandle_ = nullptr;
+    }
+    return nRet;
+}
+
+/************************************************************************/
+/*                              SetError()                              */
+/************************************************************************/
+
+// Record an error, that is only reported if the file cannot be read
+// sequentially either.
+void VSIGZipReadHandleMT::SetError( const char* pszFmt, ... )
+{
+    va_list args;
+    va_start(args, pszFmt);
+    osErrorMsg_ = CPLString().vPrintf(pszFmt, args);
+    va_end(args);
+    CPLDebug("GZIP", "%s", osErrorMsg_.c_str());
+    bError_ = true;
+}
+
+/************************************************************************/
+/*                      SwitchToSequentialReader()                      */
+/************************************************************************/
+
+// Continue reading with a sequential VSIGZipHandle, positioned at the
+// current offset, after an inconsistency with the structure expected for
+// multi-threaded decompression.
+bool VSIGZipReadHandleMT::SwitchToSequentialReader()
+{
+    if( poSequentialHandle_ )
+        return true;
+    if( poBaseHandle_ == nullptr )
+        return false;
+
+    if( poPool_ )
+    {
+        poPool_->WaitCompletion(0);
+        poPool_.reset();
+    }
+    for( auto& oIter: oMapJobs_ )
+        delete oIter.second;
+    oMapJobs_.clear();
+    sCurData_.clear();
+    bCurDataValid_ = false;
+
+    CPLDebug("GZIP", "Falling back to sequential decompression of %s",
+             osBaseFilename_.c_str());
+    // The VSIGZipHandle takes ownership of the base handle.
+    VSIGZipHandle* poHandle = new VSIGZipHandle(poBaseHandle_,
+                                                osBaseFilename_.c_str(),
+                                                0, nFileSize_);
+    poBaseHandle_ = nullptr;
+    if( !poHandle->IsInitOK() )
+    {
+        delete poHandle;
+        CPLError(CE_Failure, CPLE_AppDefined, "%s", osErrorMsg_.c_str());
+        return false;
+    }
+    poSequentialHandle_ = VSICreateBufferedReaderHandle(poHandle);
+    if( poSequentialHandle_->Seek(nCurOffset_, SEEK_SET) != 0 )
+    {
+        delete poSequentialHandle_;
+        poSequentialHandle_ = nullptr;
+        CPLError(CE_Failure, CPLE_AppDefined, "%s", osErrorMsg_.c_str());
+        return false;
+    }
+    bError_ = false;
+    return true;
+}
+
+/************************************************************************/
+/*                            ParseHeader()                             */
+/************************************************************************/
+
+// Parse a gzip member header. nBSize is set to the value of the BSIZE field
+// of a BGZF 'BC' extra subfield, or -1 if there is none.
+bool VSIGZipReadHandleMT::ParseHeader( const GByte* pabyData,
+                                       size_t nDataSize,
+                                       size_t& nHeaderSize, int& nBSize )
+{
+    nBSize = -1;
+    if( nDataSize < 10 ||
+        pabyData[0] != gz_magic[0] || pabyData[1] != gz_magic[1] ||
+        pabyData[2] != Z_DEFLATED || (pabyData[3] & RESERVED) != 0 )
+    {
+        return false;
+    }
+    const int nFlags = pabyData[3];
+    size_t nPos = 10;
+    if( (nFlags & EXTRA_FIELD) != 0 )
+    {
+        if( nPos + 2 > nDataSize )
+            return false;
+        const size_t nXLen = pabyData[nPos] | (pabyData[nPos+1] << 8);
+        nPos += 2;
+        if( nPos + nXLen > nDataSize )
+            return false;
+        const size_t nXEnd = nPos + nXLen;
+        while( nPos + 4 <= nXEnd )
+        {
+            const size_t nSubLen = pabyData[nPos+2] | (pabyData[nPos+3] << 8);
+            if( pabyData[nPos] == 'B' && pabyData[nPos+1] == 'C' &&
+                nSubLen == 2 && nPos + 6 <= nXEnd )
+            {
+                nBSize = pabyData[nPos+4] | (pabyData[nPos+5] << 8);
+            }
+            nPos += 4 + nSubLen;
+        }
+        nPos = nXEnd;
+    }
+    if( (nFlags & ORIG_NAME) != 0 )
+    {
+        while( nPos < nDataSize && pabyData[nPos] != 0 )
+            nPos++;
+        nPos++;
+    }
+    if( (nFlags & COMMENT) != 0 )
+    {
+        while( nPos < nDataSize && pabyData[nPos] != 0 )
+            nPos++;
+        nPos++;
+    }
+    if( (nFlags & HEAD_CRC) != 0 )
+        nPos += 2;
+    if( nPos > nDataSize )
+        return false;
+    nHeaderSize = nPos;
+    return true;
+}
+
+/************************************************************************/
+/*                        ScanNextBGZFMember()                          */
+/************************************************************************/
+
+bool VSIGZipReadHandleMT::ScanNextBGZFMember()
+{
+    GByte abyHeader[512] = {};
+    const size_t nToRead = static_cast<size_t>(std::min(
+        static_cast<vsi_l_offset>(sizeof(abyHeader)),
+        nFileSize_ - nNextScanOffset_));
+    size_t nHeaderSize = 0;
+    int nBSize = -1;
+    if( poBaseHandle_->Seek(nNextScanOffset_, SEEK_SET) != 0 ||
+        poBaseHandle_->Read(abyHeader, 1, nToRead) != nToRead ||
+        !ParseHeader(abyHeader, nToRead, nHeaderSize, nBSize) ||
+        nBSize < 0 ||
+        static_cast<size_t>(nBSize) + 1 < nHeaderSize + 8 ||
+        nNextScanOffset_ + nBSize + 1 > nFileSize_ )
+    {
+        SetError("Invalid BGZF member at offset " CPL_FRMT_GUIB,
+                 nNextScanOffset_);
+        return false;
+    }
+
+    const vsi_l_offset nMemberEnd = nNextScanOffset_ + nBSize + 1;
+    GByte abyTrailer[8] = {};
+    if( poBaseHandle_->Seek(nMemberEnd - 8, SEEK_SET) != 0 ||
+        poBaseHandle_->Read(abyTrailer, 1, 8) != 8 )
+    {
+        SetError("Cannot read BGZF trailer");
+        return false;
+    }
+    GUInt32 nCRC = 0;
+    GUInt32 nISize = 0;
+    memcpy(&nCRC, abyTrailer, 4);
+    memcpy(&nISize, abyTrailer + 4, 4);
+    CPL_LSBPTR32(&nCRC);
+    CPL_LSBPTR32(&nISize);
+
+    Segment oSegment;
+    oSegment.nCompressedOffset = nNextScanOffset_ + nHeaderSize;
+    oSegment.nCompressedSize = nBSize + 1 - nHeaderSize - 8;
+    oSegment.nUncompressedSize = nISize;
+    oSegment.bUncompressedSizeKnown = true;
+    oSegment.nExpectedCRC = nCRC;
+    aoSegments_.push_back(oSegment);
+    anUncompressedOffsets_.push_back(anUncompressedOffsets_.back() + nISize);
+
+    nNextScanOffset_ = nMemberEnd;
+    if( nNextScanOffset_ == nFileSize_ )
+        bScanFinished_ = true;
+    return true;
+}
+
+/************************************************************************/
+/*                      ScanNextIndependentBlock()                      */
+/************************************************************************/
+
+bool VSIGZipReadHandleMT::ScanNextIndependentBlock()
+{
+    constexpr size_t nMarkerSize = INDEPENDENT_BLOCK_MARKER_SIZE;
+    const vsi_l_offset nStart = nNextScanOffset_;
+    const vsi_l_offset nEndData = nFileSize_ - 8;  // before CRC32 and ISIZE
+    vsi_l_offset nEnd = nEndData;
+    vsi_l_offset nPos = nStart;
+    std::string osBuffer;
+    while( nPos < nEndData )
+    {
+        const size_t nToRead = static_cast<size_t>(std::min(
+            static_cast<vsi_l_offset>(Z_BUFSIZE * 16), nEndData - nPos));
+        osBuffer.resize(nToRead);
+        if( poBaseHandle_->Seek(nPos, SEEK_SET) != 0 ||
+            poBaseHandle_->Read(&osBuffer[0], 1, nToRead) != nToRead )
+        {
+            SetError("Cannot read compressed data");
+            return false;
+        }
+        const size_t nMarkerPos =
+            osBuffer.find(szIndependentBlockMarker, 0, nMarkerSize);
+        if( nMarkerPos != std::string::npos )
+        {
+            nEnd = nPos + nMarkerPos + nMarkerSize;
+            break;
+        }
+        if( nPos + nToRead >= nEndData )
+            break;
+        // Keep an overlap in case the marker crosses the buffer boundary.
+        nPos += nToRead - (nMarkerSize - 1);
+        if( nPos - nStart > MAX_SEGMENT_SIZE )
+        {
+            SetError("Too large independent block at offset " CPL_FRMT_GUIB,
+                     nStart);
+            return false;
+        }
+    }
+    if( nEnd - nStart > MAX_SEGMENT_SIZE )
+    {
+        SetError("Too large independent block at offset " CPL_FRMT_GUIB,
+                 nStart);
+        return false;
+    }
+
+    Segment oSegment;
+    oSegment.nCompressedOffset = nStart;
+    oSegment.nCompressedSize = static_cast<size_t>(nEnd - nStart);
+    aoSegments_.push_back(oSegment);
+
+    nNextScanOffset_ = nEnd;
+    if( nNextScanOffset_ == nEndData )
+        bScanFinished_ = true;
+    return true;
+}
+
+/************************************************************************/
+/*                          ScanNextSegment()                           */
+/************************************************************************/
+
+bool VSIGZipReadHandleMT::ScanNextSegment()
+{
+    if( bScanFinished_ )
+        return false;
+    if( !(bBGZF_ ? ScanNextBGZFMember() : ScanNextIndependentBlock()) )
+    {
+        bError_ = true;
+        return false;
+    }
+    return true;
+}
+
+/************************************************************************/
+/*                             InflateJob()                             */
+/************************************************************************/
+
+void VSIGZipReadHandleMT::InflateJob(void* inData)
+{
+    Job* psJob = static_cast<Job*>(inData);
+
+    z_stream sStream;
+    memset(&sStream, 0, sizeof(sStream));
+    bool bOK = inflateInit2(&sStream, -MAX_WBITS) == Z_OK;
+    if( bOK )
+    {
+        sStream.next_in = reinterpret_cast<Bytef*>(
+            &psJob->sCompressedData_[0]);
+        sStream.avail_in = static_cast<uInt>(psJob->sCompressedData_.size());
+
+        std::string& osOut = psJob->sUncompressedData_;
+        osOut.resize( psJob->bBGZF_ ?
+                        std::max(static_cast<size_t>(1),
+                                 psJob->nExpectedSize_) :
+                        std::max(static_cast<size_t>(Z_BUFSIZE),
+                                 4 * psJob->sCompressedData_.size()) );
+        size_t nOutSize = 0;
+        while( true )
+        {
+            sStream.next_out = reinterpret_cast<Bytef*>(&osOut[nOutSize]);
+            sStream.avail_out = static_cast<uInt>(osOut.size() - nOutSize);
+            const int ret = inflate(&sStream, Z_NO_FLUSH);
+            nOutSize = osOut.size() - sStream.avail_out;
+            if( ret == Z_STREAM_END )
+            {
+                psJob->bStreamEnd_ = true;
+                break;
+            }
+            if( ret != Z_OK && ret != Z_BUF_ERROR )
+            {
+                bOK = false;
+                break;
+            }
+            if( sStream.avail_out != 0 )
+            {
+                // All input consumed, or no progress possible.
+                break;
+            }
+            if( psJob->bBGZF_ || osOut.size() > 64 * MAX_SEGMENT_SIZE )
+            {
+                bOK = false;
+                break;
+            }
+            osOut.resize(osOut.size() * 2);
+        }
+        osOut.resize(nOutSize);
+        if( sStream.avail_in != 0 )
+            bOK = false;
+        inflateEnd(&sStream);
+
+        psJob->nCRC_ = crc32(0U,
+            reinterpret_cast<const Bytef*>(osOut.data()),
+            static_cast<uInt>(osOut.size()));
+        if( psJob->bBGZF_ &&
+            (!psJob->bStreamEnd_ || nOutSize != psJob->nExpectedSize_ ||
+             psJob->nCRC_ != psJob->nExpectedCRC_) )
+        {
+            bOK = false;
+        }
+    }
+    psJob->sCompressedData_.clear();
+
+    {
+        std::lock_guard<std::mutex> oLock(psJob->pParent_->sMutex_);
+        psJob->bOK_ = bOK;
+        psJob->bFinished_ = true;
+    }
+}
+
+/************************************************************************/
+/*                         CollectFinishedJobs()                        */
+/************************************************************************/
+
+// Record, in order, the uncompressed size of segments that were not known
+// yet, and discard orphaned jobs.
+bool VSIGZipReadHandleMT::CollectFinishedJobs()
+{
+    std::lock_guard<std::mutex> oLock(sMutex_);
+    for( auto oIter = oMapJobs_.begin(); oIter != oMapJobs_.end(); )
+    {
+        Job* psJob = oIter->second;
+        if( psJob->bFinished_ && psJob->bOrphan_ )
+        {
+            delete psJob;
+            oIter = oMapJobs_.erase(oIter);
+        }
+        else
+        {
+            ++oIter;
+        }
+    }
+
+    while( anUncompressedOffsets_.size() <= aoSegments_.size() )
+    {
+        const size_t nSegment = anUncompressedOffsets_.size() - 1;
+        auto oIter = oMapJobs_.find(nSegment);
+        if( oIter == oMapJobs_.end() || !oIter->second->bFinished_ )
+            break;
+        Job* psJob = oIter->second;
+        if( !psJob->bOK_ )
+        {
+            SetError("Decompression of segment %d failed",
+                     static_cast<int>(nSegment));
+            return false;
+        }
+        const bool bLastSegment =
+            bScanFinished_ && nSegment + 1 == aoSegments_.size();
+        if( psJob->bStreamEnd_ != bLastSegment )
+        {
+            SetError("Unexpected end of deflate stream in segment %d",
+                     static_cast<int>(nSegment));
+            return false;
+        }
+        const size_t nSize = psJob->sUncompressedData_.size();
+        aoSegments_[nSegment].nUncompressedSize = nSize;
+        aoSegments_[nSegment].bUncompressedSizeKnown = true;
+        anUncompressedOffsets_.push_back(anUncompressedOffsets_.back() + nSize);
+        nStreamCRC_ = crc32_combine(nStreamCRC_, psJob->nCRC_,
+                                    static_cast<z_off_t>(nSize));
+
+        if( bLastSegment )
+        {
+            GByte abyTrailer[8] = {};
+            GUInt32 nCRC = 0;
+            GUInt32 nISize = 0;
+            if( poBaseHandle_->Seek(nFileSize_ - 8, SEEK_SET) != 0 ||
+                poBaseHandle_->Read(abyTrailer, 1, 8) != 8 )
+            {
+                SetError("Cannot read gzip trailer");
+                return false;
+            }
+            memcpy(&nCRC, abyTrailer, 4);
+            memcpy(&nISize, abyTrailer + 4, 4);
+            CPL_LSBPTR32(&nCRC);
+            CPL_LSBPTR32(&nISize);
+            if( nCRC != nStreamCRC_ ||
+                nISize != static_cast<GUInt32>(anUncompressedOffsets_.back()) )
+            {
+                SetError("CRC error. Got %X instead of %X",
+                         static_cast<unsigned int>(nStreamCRC_),
+                         static_cast<unsigned int>(nCRC));
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+/************************************************************************/
+/*                             SubmitJobs()                             */
+/************************************************************************/
+
+// Make sure that segments [nFirstSegment, nFirstSegment + read ahead count[
+// are being uncompressed, and discard uncompressed data outside of that
+// window.
+bool VSIGZipReadHandleMT::SubmitJobs(size_t nFirstSegment)
+{
+    const size_t nLastSegment = nFirstSegment + GetReadAheadCount();
+    while( aoSegments_.size() < nLastSegment && !bScanFinished_ )
+    {
+        if( !ScanNextSegment() )
+            break;
+    }
+    if( bError_ )
+        return false;
+
+    if( poPool_ == nullptr )
+    {
+        poPool_.reset(new CPLWorkerThreadPool());
+        if( !poPool_->Setup(nThreads_, nullptr, nullptr, false) )
+        {
+            poPool_.reset();
+            SetError("Cannot create worker threads");
+            return false;
+        }
+    }
+
+    {
+        std::lock_guard<std::mutex> oLock(sMutex_);
+        for( auto oIter = oMapJobs_.begin(); oIter != oMapJobs_.end(); )
+        {
+            const size_t nSegment = oIter->first;
+            Job* psJob = oIter->second;
+            // Keep unfinished jobs needed to learn segment sizes.
+            if( (nSegment < nFirstSegment || nSegment >= nLastSegment) &&
+                nSegment + 1 < anUncompressedOffsets_.size() )
+            {
+                if( psJob->bFinished_ )
+                {
+                    delete psJob;
+                    oIter = oMapJobs_.erase(oIter);
+                    continue;
+                }
+                psJob->bOrphan_ = true;
+            }
+            ++oIter;
+        }
+    }
+
+    for( size_t i = nFirstSegment;
+         i < std::min(nLastSegment, aoSegments_.size()); ++i )
+    {
+        {
+            std::lock_guard<std::mutex> oLock(sMutex_);
+            auto oIter = oMapJobs_.find(i);
+            if( oIter != oMapJobs_.end() )
+            {
+                oIter->second->bOrphan_ = false;
+                continue;
+            }
+        }
+
+        const Segment& oSegment = aoSegments_[i];
+        Job* psJob = new Job();
+        psJob->pParent_ = this;
+        psJob->nSegment_ = i;
+        psJob->bBGZF_ = bBGZF_;
+        psJob->nExpectedSize_ = oSegment.nUncompressedSize;
+        psJob->nExpectedCRC_ = oSegment.nExpectedCRC;
+        psJob->sCompressedData_.resize(oSegment.nCompressedSize);
+        if( oSegment.nCompressedSize != 0 &&
+            (poBaseHandle_->Seek(oSegment.nCompressedOffset, SEEK_SET) != 0 ||
+             poBaseHandle_->Read(&psJob->sCompressedData_[0], 1,
+                                 oSegment.nCompressedSize) !=
+                                            oSegment.nCompressedSize) )
+        {
+            SetError("Cannot read compressed data");
+            delete psJob;
+            return false;
+        }
+        {
+            std::lock_guard<std::mutex> oLock(sMutex_);
+            oMapJobs_[i] = psJob;
+        }
+        poPool_->SubmitJob(VSIGZipReadHandleMT::InflateJob, psJob);
+    }
+    return true;
+}
+
+/************************************************************************/
+/*                           WaitForSegment()                           */
+/************************************************************************/
+
+bool VSIGZipReadHandleMT::WaitForSegment(size_t nSegment)
+{
+    while( true )
+    {
+        {
+            std::lock_guard<std::mutex> oLock(sMutex_);
+            auto oIter = oMapJobs_.find(nSegment);
+            if( oIter == oMapJobs_.end() )
+                return false;
+            if( oIter->second->bFinished_ )
+                break;
+        }
+        poPool_->WaitEvent();
+    }
+    return CollectFinishedJobs();
+}
+
+/************************************************************************/
+/*                       LoadSegmentContaining()                        */
+/************************************************************************/
+
+// Make sCurData_ contain the uncompressed segment that contains nOffset.
+// Returns false at end of file or in case of error.
+bool VSIGZipReadHandleMT::LoadSegmentContaining(vsi_l_offset nOffset)
+{
+    if( bCurDataValid_ &&
+        nOffset >= anUncompressedOffsets_[nCurSegment_] &&
+        nOffset < anUncompressedOffsets_[nCurSegment_ + 1] )
+    {
+        return true;
+    }
+
+    while( !bError_ )
+    {
+        // Is the offset in a segment of known location ?
+        if( nOffset < anUncompressedOffsets_.back() )
+        {
+            // Find the last segment starting at or before nOffset. Empty
+            // segments are skipped that way.
+            const auto oIter = std::upper_bound(anUncompressedOffsets_.begin(),
+                                                anUncompressedOffsets_.end(),
+                                                nOffset);
+            const size_t nSegment =
+                static_cast<size_t>(oIter - anUncompressedOffsets_.begin()) - 1;
+            if( !SubmitJobs(nSegment) || !WaitForSegment(nSegment) )
+                return false;
+
+            Job* psJob;
+            {
+                std::lock_guard<std::mutex> oLock(sMutex_);
+                auto oJobIter = oMapJobs_.find(nSegment);
+                psJob = oJobIter->second;
+                oMapJobs_.erase(oJobIter);
+            }
+            if( !psJob->bOK_ )
+            {
+                SetError("Decompression of segment %d failed",
+                         static_cast<int>(nSegment));
+                delete psJob;
+                return false;
+            }
+            sCurData_.swap(psJob->sUncompressedData_);
+            delete psJob;
+            nCurSegment_ = nSegment;
+            bCurDataValid_ = true;
+            return true;
+        }
+
+        // Otherwise learn the size of the next segment.
+        const size_t nNextUnknown = anUncompressedOffsets_.size() - 1;
+        if( nNextUnknown == aoSegments_.size() )
+        {
+            if( bScanFinished_ )
+                return false;
+            if( !ScanNextSegment() )
+                return false;
+            if( bBGZF_ )
+                continue;
+        }
+        if( !SubmitJobs(nNextUnknown) || !WaitForSegment(nNextUnknown) )
+            return false;
+    }
+    return false;
+}
+
+/************************************************************************/
+/*                                Read()                                */
+/************************************************************************/
+
+size_t VSIGZipReadHandleMT::Read( void *pBuffer, size_t nSize, size_t nMemb )
+{
+    if( poSequentialHandle_ )
+        return poSequentialHandle_->Read(pBuffer, nSize, nMemb);
+    if( nSize == 0 || nMemb == 0 )
+        return 0;
+
+    const size_t nToRead = nSize * nMemb;
+    GByte* pabyDest = static_cast<GByte*>(pBuffer);
+    size_t nRead = 0;
+    while( nRead < nToRead )
+    {
+        if( bError_ || !LoadSegmentContaining(nCurOffset_) )
+        {
+            if( bError_ && SwitchToSequentialReader() )
+            {
+                nRead += poSequentialHandle_->Read(pabyDest + nRead, 1,
+                                                   nToRead - nRead);
+                return nRead / nSize;
+            }
+            bEOF_ = true;
+            break;
+        }
+        const size_t nOffsetInSegment = static_cast<size_t>(
+            nCurOffset_ - anUncompressedOffsets_[nCurSegment_]);
+        const size_t nChunk = std::min(nToRead - nRead,
+                                       sCurData_.size() - nOffsetInSegment);
+        memcpy(pabyDest + nRead, sCurData_.data() + nOffsetInSegment, nChunk);
+        nRead += nChunk;
+        nCurOffset_ += nChunk;
+    }
+    return nRead / nSize;
+}
+
+/************************************************************************/
+/*                                Seek()                                */
+/************************************************************************/
+
+int VSIGZipReadHandleMT::Seek( vsi_l_offset nOffset, int nWhence )
+{
+    if( poSequentialHandle_ )
+        return poSequentialHandle_->Seek(nOffset, nWhence);
+    bEOF_ = false;
+    if( nWhence == SEEK_SET )
+    {
+        nCurOffset_ = nOffset;
+    }
+    else if( nWhence == SEEK_CUR )
+    {
+        nCurOffset_ += nOffset;
+    }
+    else
+    {
+        // Need to establish the uncompressed size of the whole file.
+        while( !bError_ )
+        {
+            if( bScanFinished_ &&
+                anUncompressedOffsets_.size() == aoSegments_.size() + 1 )
+            {
+                break;
+            }
+            const size_t nNextUnknown = anUncompressedOffsets_.size() - 1;
+            if( nNextUnknown == aoSegments_.size() )
+            {
+                ScanNextSegment();
+                if( bBGZF_ )
+                    continue;
+            }
+            if( bError_ || nNextUnknown == aoSegments_.size() )
+                break;
+            if( !SubmitJobs(nNextUnknown) || !WaitForSegment(nNextUnknown) )
+                break;
+        }
+        if( bError_ )
+        {
+            return SwitchToSequentialReader() ?
+                poSequentialHandle_->Seek(nOffset, nWhence) : -1;
+        }
+        nCurOffset_ = anUncompressedOffsets_.back() + nOffset;
+    }
+    return 0;
+}
+
+/************************************************************************/
+/*                                Tell()                                */
+/************************************************************************/
+
+vsi_l_offset VSIGZipReadHandleMT::Tell()
+{
+    if( poSequentialHandle_ )
+        return poSequentialHandle_->Tell();
+    return nCurOffset_;
+}
+
+/************************************************************************/
+/*                                Eof()                                 */
+/************************************************************************/
+
+int VSIGZipReadHandleMT::Eof()
+{
+    if( poSequentialHandle_ )
+        return poSequentialHandle_->Eof();
+    return bEOF_ ? 1 : 0;
+}
+
+/************************************************************************/
+/*                               Write()                                */
+/************************************************************************/
+
+size_t VSIGZipReadHandleMT::Write( const void * /* pBuffer */,
+                                   size_t /* nSize */,
+                                   size_t /* nMemb */ )
+{
+    CPLError(CE_Failure, CPLE_NotSupported,
+             "VSIFWriteL is not supported on GZip streams");
+    return 0;
+}
+
+/************************************************************************/
+/*                               Flush()                                */
+/************************************************************************/
+
+int VSIGZipReadHandleMT::Flush()
+{
+    return 0;
+}
+
+/************************************************************************/
+/*                     VSICreateGZipReadHandleMT()                      */
+/************************************************************************/
+
+// Returns a multi-threaded reading handle if the file has a structure
+// that allows it, or nullptr. The base handle is taken ownership of only
+// in case of success.
+static VSIVirtualHandle* VSICreateGZipReadHandleMT(
+                                            VSIVirtualHandle* poBaseHandle,
+                                            const char* pszBaseFilename,
+                                            vsi_l_offset nFileSize,
+                                            int nThreads )
+{
+    // Read the first member header, and for BGZF files the header of the
+    // second member, to check that this is not a concatenation of gzip
+    // members of which only the first one has a 'BC' subfield.
+    GByte abyHeader[512] = {};
+    size_t nToRead = static_cast<size_t>(std::min(
+        static_cast<vsi_l_offset>(sizeof(abyHeader)), nFileSize));
+    size_t nHeaderSize = 0;
+    int nBSize = -1;
+    if( poBaseHandle->Seek(0, SEEK_SET) != 0 ||
+        poBaseHandle->Read(abyHeader, 1, nToRead) != nToRead ||
+        !VSIGZipReadHandleMT::ParseHeader(abyHeader, nToRead,
+                                          nHeaderSize, nBSize) ||
+        nHeaderSize + 8 > nFileSize )
+    {
+        return nullptr;
+    }
+
+    bool bBGZF = false;
+    if( nBSize >= 0 )
+    {
+        const vsi_l_offset nSecondMember =
+            static_cast<vsi_l_offset>(nBSize) + 1;
+        if( nSecondMember > nFileSize )
+            return nullptr;
+        if( nSecondMember < nFileSize )
+        {
+            nToRead = static_cast<size_t>(std::min(
+                static_cast<vsi_l_offset>(sizeof(abyHeader)),
+                nFileSize - nSecondMember));
+            size_t nSecondHeaderSize = 0;
+            int nSecondBSize = -1;
+            if( poBaseHandle->Seek(nSecondMember, SEEK_SET) != 0 ||
+                poBaseHandle->Read(abyHeader, 1, nToRead) != nToRead ||
+                !VSIGZipReadHandleMT::ParseHeader(abyHeader, nToRead,
+                                                  nSecondHeaderSize,
+                                                  nSecondBSize) ||
+                nSecondBSize < 0 )
+            {
+                return nullptr;
+            }
+        }
+        bBGZF = true;
+    }
+    else
+    {
+        // Only worth it if there is an independent block marker in the
+        // first compressed bytes.
+        std::string osBuffer;
+        osBuffer.resize(static_cast<size_t>(std::min(
+            static_cast<vsi_l_offset>(Z_BUFSIZE * 16), nFileSize)));
+        if( poBaseHandle->Seek(0, SEEK_SET) != 0 ||
+            poBaseHandle->Read(&osBuffer[0], 1, osBuffer.size()) !=
+                                                            osBuffer.size() ||
+            osBuffer.find(szIndependentBlockMarker, nHeaderSize,
+                          INDEPENDENT_BLOCK_MARKER_SIZE) == std::string::npos )
+        {
+            return nullptr;
+        }
+    }
+
+    CPLDebug("GZIP", "Using multi-threaded decompression (%s)",
+             bBGZF ? "BGZF" : "independent blocks");
+    return new VSIGZipReadHandleMT(poBaseHandle, pszBaseFilename, nFileSize,
+                                   nHeaderSize, bBGZF, nThreads);
+}
+
 /************************************************************************/
 /* ==================================================================== */
 /*                       VSIGZipWriteHandleMT                           */
@@ -1848,6 +2845,23 @@ VSIGZipWriteHandle::VSIGZipWriteHandle( VSIVirtualHandle *poBaseHandle,
     }
 }
 
+/************************************************************************/
+/*                        VSIGZipGetThreadCount()                       */
+/************************************************************************/
+
+static int VSIGZipGetThreadCount()
+{
+    const char* pszThreads = CPLGetConfigOption("GDAL_NUM_THREADS", nullptr);
+    if( pszThreads == nullptr )
+        return 1;
+    int nThreads = 0;
+    if( EQUAL(pszThreads, "ALL_CPUS") )
+        nThreads = CPLGetNumCPUs();
+    else
+        nThreads = atoi(pszThreads);
+    return std::max(1, std::min(128, nThreads));
+}
+
 /************************************************************************/
 /*                       VSICreateGZipWritable()                        */
 /************************************************************************/
@@ -1856,22 +2870,13 @@ VSIVirtualHandle* VSICreateGZipWritable( VSIVirtualHandle* poBaseHandle,
                                          int nDeflateTypeIn,
                                          int bAutoCloseBaseHandle )
 {
-    const char* pszThreads = CPLGetConfigOption("GDAL_NUM_THREADS", nullptr);
-    if( pszThreads )
+    const int nThreads = VSIGZipGetThreadCount();
+    if( nThreads > 1 )
     {
-        int nThreads = 0;
-        if( EQUAL(pszThreads, "ALL_CPUS") )
-            nThreads = CPLGetNumCPUs();
-        else
-            nThreads = atoi(pszThreads);
-        nThreads = std::max(1, std::min(128, nThreads));
-        if( nThreads > 1 )
-        {
-            return new VSIGZipWriteHandleMT( poBaseHandle,
-                                                nThreads,
-                                                nDeflateTypeIn,
-                                                CPL_TO_BOOL(bAutoCloseBaseHandle) );
-        }
+        return new VSIGZipWriteHandleMT( poBaseHandle,
+                                            nThreads,
+                                            nDeflateTypeIn,
+                                            CPL_TO_BOOL(bAutoCloseBaseHandle) );
     }
     return new VSIGZipWriteHandle( poBaseHandle,
                                    nDeflateTypeIn,
@@ -2176,6 +3181,31 @@ VSIVirtualHandle* VSIGZipFilesystemHandler::Open( const char *pszFilename,
 /*      Otherwise we are in the read access case.                       */
 /* -------------------------------------------------------------------- */
 
+    // Files made of independently compressed segments can be uncompressed
+    // ahead on several threads. Small files are not worth it, and their
+    // size is known without seeking to their end.
+    const int nThreads = VSIGZipGetThreadCount();
+    VSIStatBufL sStat;
+    if( nThreads > 1 && EQUAL(pszAccess, "rb") &&
+        poFSHandler->Stat( pszFilename + strlen("/vsigzip/"), &sStat,
+                           VSI_STAT_SIZE_FLAG ) == 0 &&
+        static_cast<vsi_l_offset>(sStat.st_size) >= MIN_MT_READ_FILE_SIZE )
+    {
+        VSIVirtualHandle* poVirtualHandle =
+            poFSHandler->Open( pszFilename + strlen("/vsigzip/"), "rb" );
+        if( poVirtualHandle == nullptr )
+            return nullptr;
+        VSIVirtualHandle* poMTHandle =
+            VSICreateGZipReadHandleMT(poVirtualHandle,
+                                      pszFilename + strlen("/vsigzip/"),
+                                      static_cast<vsi_l_offset>(sStat.st_size),
+                                      nThreads);
+        if( poMTHandle )
+            return poMTHandle;
+        poVirtualHandle->Close();
+        delete poVirtualHandle;
+    }
+
     VSIGZipHandle* poGZIPHandle = OpenGZipReadOnly(pszFilename, pszAccess);
     if( poGZIPHandle )
         // Wrap the VSIGZipHandle inside a buffered reader that will
@@ -2411,7 +3441,9 @@ const char* VSIGZipFilesystemHandler::GetOptions()
     return
     "<Options>"
     "  <Option name='GDAL_NUM_THREADS' type='string' "
-        "description='Number of threads for compression. Either a integer or ALL_CPUS'/>"
+        "description='Number of threads for compression, and for "
+        "decompression of BGZF files or files with independent blocks. "
+        "Either a integer or ALL_CPUS'/>"
     "  <Option name='CPL_VSIL_DEFLATE_CHUNK_SIZE' type='string' "
         "description='Chunk of uncompressed data for parallelization. "
         "Use K(ilobytes) or M(egabytes) suffix' default='1M'/>"
@@ -2433,6 +3465,11 @@ const char* VSIGZipFilesystemHandler::GetOptions()
  * All portions of the file system underneath the base
  * path "/vsigzip/" will be handled by this driver.
  *
+ * When the GDAL_NUM_THREADS configuration option is set to a value greater
+ * than one, or ALL_CPUS, BGZF files and files compressed with independent
+ * blocks (pigz --independent, or multi-threaded /vsigzip/ writing) are
+ * uncompressed ahead of the reader by worker threads. (GDAL >= 2.4)
+ *
  * Additional documentation is to be found at:
  * http://trac.osgeo.org/gdal/wiki/UserDocs/ReadInZip
  *
@@ -2630,6 +3667,10 @@ class VSIZipFilesystemHandler final : public VSIArchiveFilesystemHandler
     const char* GetPrefix() override { return "/vsizip"; }
     std::vector<CPLString> GetExtensions() override;
     VSIArchiveReader* CreateReader( const char* pszZipFileName ) override;
+    bool SerializeFileOffset( const VSIArchiveEntryFileOffset* poOffset,
+                              CPLString& osOut ) override;
+    VSIArchiveEntryFileOffset* DeserializeFileOffset(
+                                            const char* pszIn ) override;
 
     VSIVirtualHandle *Open( const char *pszFilename,
                             const char *pszAccess,
@@ -2735,6 +3776,43 @@ std::vector<CPLString> VSIZipFilesystemHandler::GetExtensions()
     return oList;
 }
 
+/************************************************************************/
+/*                        SerializeFileOffset()                         */
+/************************************************************************/
+
+bool VSIZipFilesystemHandler::SerializeFileOffset(
+    const VSIArchiveEntryFileOffset* poOffset, CPLString& osOut )
+{
+    const VSIZipEntryFileOffset* poZipOffset =
+        static_cast<const VSIZipEntryFileOffset*>(poOffset);
+    osOut.Printf(CPL_FRMT_GUIB ":" CPL_FRMT_GUIB,
+                 static_cast<GUIntBig>(
+                     poZipOffset->m_file_pos.pos_in_zip_directory),
+                 static_cast<GUIntBig>(poZipOffset->m_file_pos.num_of_file));
+    return true;
+}
+
+/************************************************************************/
+/*                       DeserializeFileOffset()                        */
+/************************************************************************/
+
+VSIArchiveEntryFileOffset* VSIZipFilesystemHandler::DeserializeFileOffset(
+    const char* pszIn )
+{
+    const char* pszColon = strchr(pszIn, ':');
+    if( pszColon == nullptr || pszIn[0] < '0' || pszIn[0] > '9' ||
+        pszColon[1] < '0' || pszColon[1] > '9' )
+    {
+        return nullptr;
+    }
+    unz_file_pos file_pos;
+    file_pos.pos_in_zip_directory = CPLScanUIntBig(
+        pszIn, static_cast<int>(pszColon - pszIn));
+    file_pos.num_of_file = CPLScanUIntBig(
+        pszColon + 1, static_cast<int>(strlen(pszColon + 1)));
+    return new VSIZipEntryFileOffset(file_pos);
+}
+
 /************************************************************************/
 /*                           CreateReader()                             */
 /************************************************************************/
@@ -3091,6 +4169,9 @@ const char* VSIZipFilesystemHandler::GetOptions()
     "  <Option name='CPL_VSIL_DEFLATE_CHUNK_SIZE' type='string' "
         "description='Chunk of uncompressed data for parallelization. "
         "Use K(ilobytes) or M(egabytes) suffix' default='1M'/>"
+    "  <Option name='CPL_VSIL_ARCHIVE_INDEX_DIR' type='string' "
+        "description='Directory where the listing of zip files is persisted "
+        "and reused by other processes'/>"
     "</Options>";
 }
 
@@ -3298,6 +4379,11 @@ void VSIZipWriteHandle::StartNewFile( VSIZipWriteHandle* poSubFile )
  *
  * Directory listing is available through VSIReadDir().
  *
+ * If the CPL_VSIL_ARCHIVE_INDEX_DIR configuration option is set to a writable
+ * directory, the listing of the archive is saved there and reused by other
+ * processes, as long as the size and modification time of the archive
+ * are unchanged. (GDAL >= 2.4)
+ *
  * Since GDAL 1.8.0, write capabilities are available. They allow creating
  * a new zip file and adding new files to an already existing (or just created)
  * zip file. Read and write operations cannot be interleaved : the new zip must
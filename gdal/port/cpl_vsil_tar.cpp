@@ -429,6 +429,10 @@ public:
     const char* GetPrefix() override { return "/vsitar"; }
     std::vector<CPLString> GetExtensions() override;
     VSIArchiveReader* CreateReader(const char* pszTarFileName) override;
+    bool SerializeFileOffset( const VSIArchiveEntryFileOffset* poOffset,
+                              CPLString& osOut ) override;
+    VSIArchiveEntryFileOffset* DeserializeFileOffset(
+                                            const char* pszIn ) override;
 
     VSIVirtualHandle *Open( const char *pszFilename,
                             const char *pszAccess,
@@ -448,6 +452,36 @@ std::vector<CPLString> VSITarFilesystemHandler::GetExtensions()
     return oList;
 }
 
+/************************************************************************/
+/*                        SerializeFileOffset()                         */
+/************************************************************************/
+
+bool VSITarFilesystemHandler::SerializeFileOffset(
+    const VSIArchiveEntryFileOffset* poOffset, CPLString& osOut )
+{
+    const VSITarEntryFileOffset* poTarOffset =
+        static_cast<const VSITarEntryFileOffset*>(poOffset);
+#ifdef HAVE_FUZZER_FRIENDLY_ARCHIVE
+    if( !poTarOffset->m_osFileName.empty() )
+        return false;
+#endif
+    osOut.Printf(CPL_FRMT_GUIB, poTarOffset->m_nOffset);
+    return true;
+}
+
+/************************************************************************/
+/*                       DeserializeFileOffset()                        */
+/************************************************************************/
+
+VSIArchiveEntryFileOffset* VSITarFilesystemHandler::DeserializeFileOffset(
+    const char* pszIn )
+{
+    if( pszIn[0] < '0' || pszIn[0] > '9' )
+        return nullptr;
+    return new VSITarEntryFileOffset(
+        CPLScanUIntBig(pszIn, static_cast<int>(strlen(pszIn))));
+}
+
 /************************************************************************/
 /*                           CreateReader()                             */
 /************************************************************************/
@@ -572,6 +606,11 @@ VSIVirtualHandle* VSITarFilesystemHandler::Open( const char *pszFilename,
  *
  * Directory listing is available through VSIReadDir().
  *
+ * If the CPL_VSIL_ARCHIVE_INDEX_DIR configuration option is set to a writable
+ * directory, the listing of the archive is saved there and reused by other
+ * processes, which avoids scanning the whole archive, as long as the size and
+ * modification time of the archive are unchanged. (GDAL >= 2.4)
+ *
  * @since GDAL 1.8.0
  */
 
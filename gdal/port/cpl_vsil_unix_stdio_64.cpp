@@ -70,6 +70,9 @@
 #  include <fcntl.h>
 #endif
 #include <sys/stat.h>
+#ifdef HAVE_MMAP
+#include <sys/mman.h>
+#endif
 #ifdef HAVE_STATVFS
 #include <sys/statvfs.h>
 #endif
@@ -78,14 +81,20 @@
 #include <unistd.h>
 #endif
 
+#include <algorithm>
+#include <mutex>
 #include <new>
+#include <vector>
 
+#include "cpl_atomic_ops.h"
 #include "cpl_config.h"
 #include "cpl_conv.h"
 #include "cpl_error.h"
 #include "cpl_multiproc.h"
 #include "cpl_string.h"
+#include "cpl_virtualmem.h"
 #include "cpl_vsi_error.h"
+#include "cpl_worker_thread_pool.h"
 
 CPL_CVSID("$Id$")
 
@@ -109,6 +118,9 @@ CPL_CVSID("$Id$")
 #ifndef VSI_FTRUNCATE64
 #define VSI_FTRUNCATE64 ftruncate64
 #endif
+#ifndef VSI_PREAD64
+#define VSI_PREAD64 pread
+#endif
 
 #else /* not UNIX_STDIO_64 */
 
@@ -130,6 +142,9 @@ CPL_CVSID("$Id$")
 #ifndef VSI_FTRUNCATE64
 #define VSI_FTRUNCATE64 ftruncate
 #endif
+#ifndef VSI_PREAD64
+#define VSI_PREAD64 pread
+#endif
 
 #endif /* ndef UNIX_STDIO_64 */
 
@@ -150,9 +165,7 @@ class VSIUnixStdioFilesystemHandler final : public VSIFilesystemHandler
 
 public:
     VSIUnixStdioFilesystemHandler() = default;
-#ifdef VSI_COUNT_BYTES_READ
     ~VSIUnixStdioFilesystemHandler() override;
-#endif
 
     VSIVirtualHandle *Open( const char *pszFilename,
                             const char *pszAccess,
@@ -166,6 +179,7 @@ public:
     char **ReadDirEx( const char *pszDirname, int nMaxFiles ) override;
     GIntBig GetDiskFreeSpace( const char* pszDirname ) override;
     int SupportsSparseFiles( const char* pszPath ) override;
+    int HasOptimizedReadMultiRange( const char* pszPath ) override;
 
 #ifdef VSI_COUNT_BYTES_READ
     void             AddToTotal(vsi_l_offset nBytes);
@@ -205,6 +219,9 @@ class VSIUnixStdioHandle final : public VSIVirtualHandle
     int Seek( vsi_l_offset nOffsetIn, int nWhence ) override;
     vsi_l_offset Tell() override;
     size_t Read( void *pBuffer, size_t nSize, size_t nMemb ) override;
+    int ReadMultiRange( int nRanges, void ** ppData,
+                        const vsi_l_offset* panOffsets,
+                        const size_t* panSizes ) override;
     size_t Write( const void *pBuffer, size_t nSize, size_t nMemb ) override;
     int Eof() override;
     int Flush() override;
@@ -214,6 +231,9 @@ class VSIUnixStdioHandle final : public VSIVirtualHandle
         return reinterpret_cast<void *>(static_cast<size_t>(fileno(fp))); }
     VSIRangeStatus GetRangeStatus( vsi_l_offset nOffset,
                                    vsi_l_offset nLength ) override;
+    const void *AcquireReadView( vsi_l_offset nOffset, size_t nSize,
+                                 void** ppViewHandle ) override;
+    void ReleaseReadView( void* pViewHandle ) override;
 };
 
 /************************************************************************/
@@ -377,6 +397,189 @@ int VSIUnixStdioHandle::Flush()
     return fflush( fp );
 }
 
+/************************************************************************/
+/*                      VSIUnixStdioGetReadThreads()                    */
+/************************************************************************/
+
+// Number of threads used to issue concurrent positional reads, for
+// ReadMultiRange() and large Read() requests.
+static int VSIUnixStdioGetReadThreads()
+{
+    const char* pszThreads =
+        CPLGetConfigOption("CPL_VSIL_LOCAL_READ_NUM_THREADS", "1");
+    const int nThreads = EQUAL(pszThreads, "ALL_CPUS") ? CPLGetNumCPUs()
+                                                         : atoi(pszThreads);
+    return std::max(1, std::min(128, nThreads));
+}
+
+/************************************************************************/
+/*                         VSIUnixStdioPRead()                          */
+/************************************************************************/
+
+// Read up to nSize bytes at nOffset without touching the file position.
+// Returns the number of bytes read, which is lower than nSize only at end
+// of file or in case of error.
+static size_t VSIUnixStdioPRead( int fd, void* pBuffer, vsi_l_offset nOffset,
+                                 size_t nSize )
+{
+    size_t nDone = 0;
+    while( nDone < nSize )
+    {
+        const ssize_t nRet =
+            VSI_PREAD64(fd, static_cast<GByte*>(pBuffer) + nDone,
+                        nSize - nDone, nOffset + nDone);
+        if( nRet < 0 )
+        {
+            if( errno == EINTR )
+                continue;
+            CPLDebug("VSI", "pread() failed: %s", VSIStrerror(errno));
+            break;
+        }
+        if( nRet == 0 )
+            break;
+        nDone += static_cast<size_t>(nRet);
+    }
+    return nDone;
+}
+
+/************************************************************************/
+/*                     VSIUnixStdioParallelPRead()                      */
+/************************************************************************/
+
+// Below that amount of data, starting threads costs more than it brings.
+constexpr size_t MIN_PARALLEL_READ_SIZE = 1024 * 1024;
+// Ranges are split in pieces of at least that size to balance the work
+// between threads.
+constexpr size_t MIN_PARALLEL_READ_PIECE_SIZE = 256 * 1024;
+
+namespace {
+struct VSIUnixStdioReadPiece
+{
+    GByte        *pabyDst;
+    vsi_l_offset  nOffset;
+    size_t        nSize;
+};
+
+struct VSIUnixStdioParallelReadJob
+{
+    int                                        fd;
+    const std::vector<VSIUnixStdioReadPiece>  *paoPieces;
+    volatile int                              *pnNextPiece;
+    volatile int                              *pnErrors;
+};
+} // namespace
+
+static void VSIUnixStdioParallelReadFunc( void* pData )
+{
+    VSIUnixStdioParallelReadJob* psJob =
+        static_cast<VSIUnixStdioParallelReadJob*>(pData);
+    const int nPieces = static_cast<int>(psJob->paoPieces->size());
+    while( *(psJob->pnErrors) == 0 )
+    {
+        const int iPiece = CPLAtomicInc(psJob->pnNextPiece) - 1;
+        if( iPiece >= nPieces )
+            break;
+        const VSIUnixStdioReadPiece& oPiece = (*psJob->paoPieces)[iPiece];
+        if( VSIUnixStdioPRead(psJob->fd, oPiece.pabyDst, oPiece.nOffset,
+                              oPiece.nSize) != oPiece.nSize )
+        {
+            CPLAtomicInc(psJob->pnErrors);
+        }
+    }
+}
+
+// Pools of worker threads of concurrent reads, kept between reads so that
+// threads are not started for each of them. A read takes a pool for itself,
+// so that WaitCompletion() only waits for its own jobs, and gives it back.
+static std::mutex gMutexReadThreadPools;
+static std::vector<CPLWorkerThreadPool*> gapoReadThreadPools;
+
+static CPLWorkerThreadPool* VSIUnixStdioAcquireReadThreadPool( int nThreads )
+{
+    {
+        std::lock_guard<std::mutex> oLock(gMutexReadThreadPools);
+        while( !gapoReadThreadPools.empty() )
+        {
+            CPLWorkerThreadPool* poPool = gapoReadThreadPools.back();
+            gapoReadThreadPools.pop_back();
+            if( poPool->GetThreadCount() == nThreads )
+                return poPool;
+            delete poPool;
+        }
+    }
+    CPLWorkerThreadPool* poPool = new (std::nothrow) CPLWorkerThreadPool();
+    if( poPool != nullptr && !poPool->Setup(nThreads, nullptr, nullptr) )
+    {
+        delete poPool;
+        poPool = nullptr;
+    }
+    return poPool;
+}
+
+static void VSIUnixStdioReleaseReadThreadPool( CPLWorkerThreadPool* poPool )
+{
+    std::lock_guard<std::mutex> oLock(gMutexReadThreadPools);
+    gapoReadThreadPools.push_back(poPool);
+}
+
+static void VSIUnixStdioDestroyReadThreadPools()
+{
+    std::lock_guard<std::mutex> oLock(gMutexReadThreadPools);
+    for( auto poPool : gapoReadThreadPools )
+        delete poPool;
+    gapoReadThreadPools.clear();
+}
+
+// Read all the ranges, using up to nThreads threads that pick pieces of
+// the ranges in turn. Returns true if all ranges could be entirely read.
+static bool VSIUnixStdioParallelPRead( int fd, int nRanges, void ** ppData,
+                                       const vsi_l_offset* panOffsets,
+                                       const size_t* panSizes,
+                                       size_t nTotalSize, int nThreads )
+{
+    const size_t nPieceSize =
+        std::max(MIN_PARALLEL_READ_PIECE_SIZE,
+                 nTotalSize / (4 * static_cast<size_t>(nThreads)));
+    std::vector<VSIUnixStdioReadPiece> aoPieces;
+    for( int i = 0; i < nRanges; i++ )
+    {
+        for( size_t nPos = 0; nPos < panSizes[i]; nPos += nPieceSize )
+        {
+            VSIUnixStdioReadPiece oPiece;
+            oPiece.pabyDst = static_cast<GByte*>(ppData[i]) + nPos;
+            oPiece.nOffset = panOffsets[i] + nPos;
+            oPiece.nSize = std::min(nPieceSize, panSizes[i] - nPos);
+            aoPieces.push_back(oPiece);
+        }
+    }
+    nThreads = std::min(nThreads, static_cast<int>(aoPieces.size()));
+
+    volatile int nNextPiece = 0;
+    volatile int nErrors = 0;
+    VSIUnixStdioParallelReadJob sJob;
+    sJob.fd = fd;
+    sJob.paoPieces = &aoPieces;
+    sJob.pnNextPiece = &nNextPiece;
+    sJob.pnErrors = &nErrors;
+
+    // The calling thread takes its share of the work too.
+    CPLWorkerThreadPool* poPool = nThreads > 1 ?
+        VSIUnixStdioAcquireReadThreadPool(nThreads - 1) : nullptr;
+    if( poPool != nullptr )
+    {
+        const std::vector<void*> apData(nThreads - 1, &sJob);
+        poPool->SubmitJobs(VSIUnixStdioParallelReadFunc, apData);
+    }
+    VSIUnixStdioParallelReadFunc(&sJob);
+    if( poPool != nullptr )
+    {
+        poPool->WaitCompletion();
+        VSIUnixStdioReleaseReadThreadPool(poPool);
+    }
+
+    return nErrors == 0;
+}
+
 /************************************************************************/
 /*                                Read()                                */
 /************************************************************************/
@@ -384,6 +587,52 @@ int VSIUnixStdioHandle::Flush()
 size_t VSIUnixStdioHandle::Read( void * pBuffer, size_t nSize, size_t nCount )
 
 {
+/* -------------------------------------------------------------------- */
+/*      Large reads are served by concurrent positional reads when      */
+/*      enabled, so that several requests are in flight at once.        */
+/* -------------------------------------------------------------------- */
+    const size_t nToRead = nSize * nCount;
+    if( nSize > 0 && !bModeAppendReadWrite &&
+        nToRead >= MIN_PARALLEL_READ_SIZE &&
+        VSIUnixStdioGetReadThreads() > 1 )
+    {
+        struct stat sStat;
+        if( fstat(fileno(fp), &sStat) == 0 && S_ISREG(sStat.st_mode) )
+        {
+            if( bLastOpWrite )
+                fflush(fp);
+            const vsi_l_offset nFileSize =
+                static_cast<vsi_l_offset>(sStat.st_size);
+            const size_t nAvailable =
+                m_nOffset >= nFileSize ? 0 :
+                static_cast<size_t>(std::min(
+                    static_cast<vsi_l_offset>(nToRead), nFileSize - m_nOffset));
+            void* pData = pBuffer;
+            if( nAvailable == 0 ||
+                VSIUnixStdioParallelPRead(fileno(fp), 1, &pData, &m_nOffset,
+                                          &nAvailable, nAvailable,
+                                          VSIUnixStdioGetReadThreads()) )
+            {
+#ifdef VSI_COUNT_BYTES_READ
+                nTotalBytesRead += nAvailable;
+#endif
+                // As with fread(), a trailing partial element is consumed
+                // but not counted.
+                const size_t nResult = nAvailable / nSize;
+                m_nOffset += nAvailable;
+                // Resynchronize the stdio position, dropping its buffer.
+                if( VSI_FSEEK64( fp, m_nOffset, SEEK_SET ) != 0 )
+                {
+                    VSIDebug1("Read calling seek failed. %d", m_nOffset);
+                }
+                bLastOpWrite = false;
+                bLastOpRead = false;
+                bAtEOF = nResult != nCount;
+                return nResult;
+            }
+        }
+    }
+
 /* -------------------------------------------------------------------- */
 /*      If a fwrite() is followed by an fread(), the POSIX rules are    */
 /*      that some of the write may still be buffered and lost.  We      */
@@ -438,6 +687,53 @@ size_t VSIUnixStdioHandle::Read( void * pBuffer, size_t nSize, size_t nCount )
     return nResult;
 }
 
+/************************************************************************/
+/*                           ReadMultiRange()                           */
+/************************************************************************/
+
+int VSIUnixStdioHandle::ReadMultiRange( int nRanges, void ** ppData,
+                                        const vsi_l_offset* panOffsets,
+                                        const size_t* panSizes )
+{
+    // Positional reads neither go through the stdio buffer nor move the
+    // file position, so no seek is needed between ranges.
+    if( bLastOpWrite )
+        fflush(fp);
+    const int fd = fileno(fp);
+
+    size_t nTotalSize = 0;
+    for( int i = 0; i < nRanges; i++ )
+        nTotalSize += panSizes[i];
+
+    int nRet = 0;
+    const int nThreads = VSIUnixStdioGetReadThreads();
+    if( nThreads > 1 && nTotalSize >= MIN_PARALLEL_READ_SIZE )
+    {
+        if( !VSIUnixStdioParallelPRead(fd, nRanges, ppData, panOffsets,
+                                       panSizes, nTotalSize, nThreads) )
+            nRet = -1;
+    }
+    else
+    {
+        for( int i = 0; i < nRanges; i++ )
+        {
+            if( VSIUnixStdioPRead(fd, ppData[i], panOffsets[i],
+                                  panSizes[i]) != panSizes[i] )
+            {
+                nRet = -1;
+                break;
+            }
+        }
+    }
+
+#ifdef VSI_COUNT_BYTES_READ
+    if( nRet == 0 )
+        nTotalBytesRead += nTotalSize;
+#endif
+
+    return nRet;
+}
+
 /************************************************************************/
 /*                               Write()                                */
 /************************************************************************/
@@ -581,19 +877,109 @@ VSIRangeStatus VSIUnixStdioHandle::GetRangeStatus( vsi_l_offset
 #endif
 }
 
+/************************************************************************/
+/*                          AcquireReadView()                           */
+/************************************************************************/
+
+// Below that size, a regular read into a private buffer is cheaper than
+// setting up and tearing down a mapping.
+constexpr size_t MIN_MMAP_READ_VIEW_SIZE = 64 * 1024;
+
+namespace {
+struct VSIUnixStdioReadView
+{
+    void   *pMapBase = nullptr;
+    size_t  nMapSize = 0;
+    void   *pBufferViewHandle = nullptr;
+};
+} // namespace
+
+const void *VSIUnixStdioHandle::AcquireReadView( vsi_l_offset nOffset,
+                                                 size_t nSize,
+                                                 void** ppViewHandle )
+{
+    *ppViewHandle = nullptr;
+    if( nSize == 0 )
+        return nullptr;
+
+#ifdef HAVE_MMAP
+    if( nSize >= MIN_MMAP_READ_VIEW_SIZE )
+    {
+        // Make sure pending writes are visible through the mapping.
+        if( bLastOpWrite )
+            fflush(fp);
+
+        const int fd = fileno(fp);
+        struct stat sStat;
+        if( fstat(fd, &sStat) == 0 &&
+            S_ISREG(sStat.st_mode) &&
+            nOffset + nSize >= nOffset &&
+            nOffset + nSize <= static_cast<vsi_l_offset>(sStat.st_size) )
+        {
+            const size_t nPageSize = CPLGetPageSize();
+            const vsi_l_offset nAlignedOffset =
+                (nOffset / nPageSize) * nPageSize;
+            const size_t nDelta = static_cast<size_t>(nOffset - nAlignedOffset);
+            void* pMapBase = mmap(nullptr, nSize + nDelta, PROT_READ,
+                                  MAP_SHARED, fd,
+                                  static_cast<off_t>(nAlignedOffset));
+            if( pMapBase != MAP_FAILED )
+            {
+                VSIUnixStdioReadView* psView = new VSIUnixStdioReadView();
+                psView->pMapBase = pMapBase;
+                psView->nMapSize = nSize + nDelta;
+                *ppViewHandle = psView;
+                return static_cast<GByte*>(pMapBase) + nDelta;
+            }
+            CPLDebug("VSI", "mmap() failed: %s", VSIStrerror(errno));
+        }
+    }
+#endif
+
+    void* pBufferViewHandle = nullptr;
+    const void* pRet = VSIVirtualHandle::AcquireReadView(nOffset, nSize,
+                                                         &pBufferViewHandle);
+    if( pRet == nullptr )
+        return nullptr;
+    VSIUnixStdioReadView* psView = new VSIUnixStdioReadView();
+    psView->pBufferViewHandle = pBufferViewHandle;
+    *ppViewHandle = psView;
+    return pRet;
+}
+
+/************************************************************************/
+/*                          ReleaseReadView()                           */
+/************************************************************************/
+
+void VSIUnixStdioHandle::ReleaseReadView( void* pViewHandle )
+{
+    VSIUnixStdioReadView* psView =
+        static_cast<VSIUnixStdioReadView*>(pViewHandle);
+    if( psView == nullptr )
+        return;
+#ifdef HAVE_MMAP
+    if( psView->pMapBase != nullptr )
+        munmap(psView->pMapBase, psView->nMapSize);
+#endif
+    VSIVirtualHandle::ReleaseReadView(psView->pBufferViewHandle);
+    delete psView;
+}
+
 /************************************************************************/
 /* ==================================================================== */
 /*                       VSIUnixStdioFilesystemHandler                  */
 /* ==================================================================== */
 /************************************************************************/
 
-#ifdef VSI_COUNT_BYTES_READ
 /************************************************************************/
 /*                     ~VSIUnixStdioFilesystemHandler()                 */
 /************************************************************************/
 
 VSIUnixStdioFilesystemHandler::~VSIUnixStdioFilesystemHandler()
 {
+    VSIUnixStdioDestroyReadThreadPools();
+
+#ifdef VSI_COUNT_BYTES_READ
     CPLDebug( "VSI",
               "~VSIUnixStdioFilesystemHandler() : nTotalBytesRead = "
               CPL_FRMT_GUIB,
@@ -602,8 +988,8 @@ VSIUnixStdioFilesystemHandler::~VSIUnixStdioFilesystemHandler()
     if( hMutex != nullptr )
         CPLDestroyMutex( hMutex );
     hMutex = nullptr;
-}
 #endif
+}
 
 /************************************************************************/
 /*                                Open()                                */
@@ -861,6 +1247,17 @@ int VSIUnixStdioFilesystemHandler::SupportsSparseFiles( const char*
 #endif
 }
 
+/************************************************************************/
+/*                     HasOptimizedReadMultiRange()                     */
+/************************************************************************/
+
+int VSIUnixStdioFilesystemHandler::HasOptimizedReadMultiRange(
+                                            const char* /* pszPath */ )
+{
+    // Only worth batching ranges together when they are read concurrently.
+    return VSIUnixStdioGetReadThreads() > 1;
+}
+
 #ifdef VSI_COUNT_BYTES_READ
 /************************************************************************/
 /*                            AddToTotal()                              */
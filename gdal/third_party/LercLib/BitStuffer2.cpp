@@ -445,32 +445,26 @@ void BitStuffer2::BitStuff(Byte** ppByte, const vector<unsigned int>& dataVec, i
   m_tmpBitStuffVec.resize(numUInts);
   unsigned int* dstPtr = &m_tmpBitStuffVec[0];
 
-  memset(dstPtr, 0, numBytes);
-
-  // do the stuffing
+  // do the stuffing: collect the bits in a 64 bit accumulator and flush it
+  // one uint at a time, which avoids the branch on the uint boundary
   const unsigned int* srcPtr = &dataVec[0];
-  int bitPos = 0;
-  assert(numBits <= 32); // to avoid coverity warning about large shift a bit later, when doing (*srcPtr++) >> (32 - bitPos)
+  unsigned long long acc = 0;
+  int numBitsAcc = 0;
+  assert(numBits <= 32);
 
   for (unsigned int i = 0; i < numElements; i++)
   {
-    if (32 - bitPos >= numBits)
-    {
-      *dstPtr |= (*srcPtr++) << bitPos;
-      bitPos += numBits;
-      if (bitPos == 32)    // shift >= 32 is undefined
-      {
-        dstPtr++;
-        bitPos = 0;
-      }
-    }
-    else
+    acc |= (unsigned long long)(*srcPtr++) << numBitsAcc;
+    numBitsAcc += numBits;
+    if (numBitsAcc >= 32)
     {
-      *dstPtr++ |= (*srcPtr) << bitPos;
-      *dstPtr |= (*srcPtr++) >> (32 - bitPos);
-      bitPos += numBits - 32;
+      *dstPtr++ = (unsigned int)acc;
+      acc >>= 32;
+      numBitsAcc -= 32;
     }
   }
+  if (numBitsAcc > 0)
+    *dstPtr = (unsigned int)acc;
 
   // copy the bytes to the outgoing byte stream
   int numBytesUsed = numBytes - NumTailBytesNotNeeded(numElements, numBits);
@@ -501,7 +495,8 @@ bool BitStuffer2::BitUnStuff(const Byte** ppByte, size_t& nBytesRemaining, vecto
 
   try
   {
-    m_tmpBitStuffVec.resize(numUInts);
+    // one uint more, so that the 64 bit reads below stay in the buffer
+    m_tmpBitStuffVec.resize(numUInts + 1);
   }
   catch( const std::bad_alloc& )
   {
@@ -509,6 +504,7 @@ bool BitStuffer2::BitUnStuff(const Byte** ppByte, size_t& nBytesRemaining, vecto
   }
 
   m_tmpBitStuffVec[numUInts - 1] = 0;    // set last uint to 0
+  m_tmpBitStuffVec[numUInts] = 0;
 
   // copy the bytes from the incoming byte stream
   int numBytesUsed = numBytes - NumTailBytesNotNeeded(numElements, numBits);
@@ -516,30 +512,18 @@ bool BitStuffer2::BitUnStuff(const Byte** ppByte, size_t& nBytesRemaining, vecto
   if (nBytesRemaining < (size_t)numBytesUsed || !memcpy(&m_tmpBitStuffVec[0], *ppByte, numBytesUsed))
     return false;
 
-  // do the un-stuffing
-  unsigned int* srcPtr = &m_tmpBitStuffVec[0];
+  // do the un-stuffing: each value is extracted from the 64 bits starting at
+  // its uint, so there is no branch on the values crossing a uint boundary
+  const unsigned int* srcPtr = &m_tmpBitStuffVec[0];
   unsigned int* dstPtr = &dataVec[0];
-  int bitPos = 0;
-  int nb = 32 - numBits;
+  const unsigned long long mask = (1ULL << numBits) - 1;
+  size_t bitPos = 0;
 
-  for (unsigned int i = 0; i < numElements; i++)
+  for (unsigned int i = 0; i < numElements; i++, bitPos += numBits)
   {
-    if (nb - bitPos >= 0)
-    {
-      *dstPtr++ = ((*srcPtr) << (nb - bitPos)) >> nb;
-      bitPos += numBits;
-      if (bitPos == 32)    // shift >= 32 is undefined
-      {
-        srcPtr++;
-        bitPos = 0;
-      }
-    }
-    else
-    {
-      *dstPtr = (*srcPtr++) >> bitPos;
-      *dstPtr++ |= ((*srcPtr) << (64 - numBits - bitPos)) >> nb;
-      bitPos -= nb;
-    }
+    const unsigned int* p = srcPtr + (bitPos >> 5);
+    unsigned long long val = p[0] | ((unsigned long long)p[1] << 32);
+    dstPtr[i] = (unsigned int)((val >> (bitPos & 31)) & mask);
   }
 
   *ppByte += numBytesUsed;
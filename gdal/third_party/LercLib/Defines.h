@@ -41,6 +41,12 @@ Contributors:  Thomas Maurer, Lucian Plesea
 #define CHECK_FOR_NAN
 #endif
 
+// SSE2 versions of the (de)quantization loops, giving the same results as
+// the scalar code. Not when the compiler may fuse the scalar multiply-adds.
+#if defined(GDAL_COMPILATION) && (defined(__x86_64) || defined(_M_X64)) && !defined(__FMA__)
+#define LERC_USE_SSE2
+#endif
+
 NAMESPACE_LERC_START
 
 typedef unsigned char Byte;
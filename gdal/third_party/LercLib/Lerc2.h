@@ -35,6 +35,10 @@ Contributors:  Thomas Maurer
 #include "Huffman.h"
 #include "RLE.h"
 
+#ifdef LERC_USE_SSE2
+#include <emmintrin.h>
+#endif
+
 NAMESPACE_LERC_START
 
 /**   Lerc2 v1
@@ -183,6 +187,23 @@ private:
   template<class T>
   bool Quantize(const T* dataBuf, int num, T zMin, std::vector<unsigned int>& quantVec) const;
 
+  // inner loops of GetValidDataAndStats(), Quantize() and ReadTile() on contiguous values
+  template<class T>
+  static void ComputeStats(const T* dataBuf, int num, T& zMin, T& zMax, int& cntSameVal);
+
+  template<class T>
+  static void QuantizeLossy(const T* dataBuf, int num, double zMin, double scale, unsigned int* dstPtr);
+
+  template<class T>
+  static void Dequantize(const unsigned int* srcPtr, int num, double offset, double invScale, double zMax, T* dstPtr);
+
+#ifdef LERC_USE_SSE2
+  static void ComputeStats(const float* dataBuf, int num, float& zMin, float& zMax, int& cntSameVal);
+  static void QuantizeLossy(const float* dataBuf, int num, double zMin, double scale, unsigned int* dstPtr);
+  static void Dequantize(const unsigned int* srcPtr, int num, double offset, double invScale, double zMax, float* dstPtr);
+  static void Dequantize(const unsigned int* srcPtr, int num, double offset, double invScale, double zMax, double* dstPtr);
+#endif
+
   template<class T>
   int NumBytesTile(int numValidPixel, T zMin, T zMax, bool tryLut, BlockEncodeMode& blockEncodeMode,
                    const std::vector<std::pair<unsigned int, unsigned int> >& sortedQuantVec) const;
@@ -973,37 +994,31 @@ bool Lerc2::GetValidDataAndStats(const T* data, int i0, int i1, int j0, int j1,
   zMax = 0;
   tryLut = false;
 
-  T prevVal = 0;
   int cnt = 0, cntSameVal = 0;
   int nDim = hd.nDim;
 
+  // gather the valid values, then compute the stats on them in one pass
+
   if (hd.numValidPixel == hd.nCols * hd.nRows)    // all valid, no mask
   {
-    for (int i = i0; i < i1; i++)
+    if (nDim == 1)
     {
-      int k = i * hd.nCols + j0;
-      int m = k * nDim + iDim;
-
-      for (int j = j0; j < j1; j++, k++, m += nDim)
+      for (int i = i0; i < i1; i++)
       {
-        T val = data[m];
-        dataBuf[cnt] = val;
-
-        if (cnt > 0)
-        {
-          if (val < zMin)
-            zMin = val;
-          else if (val > zMax)
-            zMax = val;
-
-          if (val == prevVal)
-            cntSameVal++;
-        }
-        else
-          zMin = zMax = val;    // init
+        const T* rowPtr = &data[i * hd.nCols + j0];
+        std::copy(rowPtr, rowPtr + (j1 - j0), &dataBuf[cnt]);
+        cnt += j1 - j0;
+      }
+    }
+    else
+    {
+      for (int i = i0; i < i1; i++)
+      {
+        int k = i * hd.nCols + j0;
+        int m = k * nDim + iDim;
 
-        prevVal = val;
-        cnt++;
+        for (int j = j0; j < j1; j++, k++, m += nDim)
+          dataBuf[cnt++] = data[m];
       }
     }
   }
@@ -1016,29 +1031,12 @@ bool Lerc2::GetValidDataAndStats(const T* data, int i0, int i1, int j0, int j1,
 
       for (int j = j0; j < j1; j++, k++, m += nDim)
         if (m_bitMask.IsValid(k))
-        {
-          T val = data[m];
-          dataBuf[cnt] = val;
-
-          if (cnt > 0)
-          {
-            if (val < zMin)
-              zMin = val;
-            else if (val > zMax)
-              zMax = val;
-
-            if (val == prevVal)
-              cntSameVal++;
-          }
-          else
-            zMin = zMax = val;    // init
-
-          prevVal = val;
-          cnt++;
-        }
+          dataBuf[cnt++] = data[m];
     }
   }
 
+  ComputeStats(dataBuf, cnt, zMin, zMax, cntSameVal);
+
   if (cnt > 4)
     tryLut = (zMax > zMin + hd.maxZError) && (2 * cntSameVal > cnt);
 
@@ -1083,9 +1081,8 @@ bool Lerc2::Quantize(const T* dataBuf, int num, T zMin, std::vector<unsigned int
     double scale = 1 / (2 * m_headerInfo.maxZError);
     double zMinDbl = (double)zMin;
 
-    for (int i = 0; i < num; i++)
-      quantVec[i] = (unsigned int)(((double)dataBuf[i] - zMinDbl) * scale + 0.5);    // ok, consistent with ComputeMaxVal(...)
-      //quantVec[i] = (unsigned int)((dataBuf[i] - zMin) * scale + 0.5);    // bad, not consistent with ComputeMaxVal(...)
+    if (num > 0)
+      QuantizeLossy(dataBuf, num, zMinDbl, scale, &quantVec[0]);
   }
 
   return true;
@@ -1093,6 +1090,204 @@ bool Lerc2::Quantize(const T* dataBuf, int num, T zMin, std::vector<unsigned int
 
 // -------------------------------------------------------------------------- ;
 
+template<class T>
+void Lerc2::ComputeStats(const T* dataBuf, int num, T& zMin, T& zMax, int& cntSameVal)
+{
+  T prevVal = 0;
+
+  for (int cnt = 0; cnt < num; cnt++)
+  {
+    T val = dataBuf[cnt];
+
+    if (cnt > 0)
+    {
+      if (val < zMin)
+        zMin = val;
+      else if (val > zMax)
+        zMax = val;
+
+      if (val == prevVal)
+        cntSameVal++;
+    }
+    else
+      zMin = zMax = val;    // init
+
+    prevVal = val;
+  }
+}
+
+// -------------------------------------------------------------------------- ;
+
+template<class T>
+void Lerc2::QuantizeLossy(const T* dataBuf, int num, double zMin, double scale, unsigned int* dstPtr)
+{
+  for (int i = 0; i < num; i++)
+    dstPtr[i] = (unsigned int)(((double)dataBuf[i] - zMin) * scale + 0.5);    // ok, consistent with ComputeMaxVal(...)
+    //dstPtr[i] = (unsigned int)((dataBuf[i] - zMin) * scale + 0.5);    // bad, not consistent with ComputeMaxVal(...)
+}
+
+// -------------------------------------------------------------------------- ;
+
+template<class T>
+void Lerc2::Dequantize(const unsigned int* srcPtr, int num, double offset, double invScale, double zMax, T* dstPtr)
+{
+  for (int i = 0; i < num; i++)
+  {
+    double z = offset + srcPtr[i] * invScale;
+    dstPtr[i] = (T)std::min(z, zMax);    // make sure we stay in the orig range
+  }
+}
+
+// -------------------------------------------------------------------------- ;
+
+#ifdef LERC_USE_SSE2
+
+// The SSE2 versions below do the same operations as the generic ones above,
+// in the same order, so they give bit identical results.
+
+inline void Lerc2::ComputeStats(const float* dataBuf, int num, float& zMin, float& zMax, int& cntSameVal)
+{
+  // a NaN first value, or a zero extremum that could be -0 or +0 depending on
+  // the order of the comparisons, are left to the generic version
+  if (num < 8 || dataBuf[0] != dataBuf[0])
+  {
+    ComputeStats<float>(dataBuf, num, zMin, zMax, cntSameVal);
+    return;
+  }
+
+  // MINPS / MAXPS return their second operand if the first one is NaN, like
+  // the comparisons of the scalar code
+  __m128 minV = _mm_set1_ps(dataBuf[0]);
+  __m128 maxV = minV;
+  __m128i cntSameV = _mm_setzero_si128();
+  int i = 1;
+  for (; i + 4 <= num; i += 4)
+  {
+    __m128 val = _mm_loadu_ps(dataBuf + i);
+    __m128 prevVal = _mm_loadu_ps(dataBuf + i - 1);
+    minV = _mm_min_ps(val, minV);
+    maxV = _mm_max_ps(val, maxV);
+    cntSameV = _mm_sub_epi32(cntSameV, _mm_castps_si128(_mm_cmpeq_ps(val, prevVal)));
+  }
+
+  float minArr[4], maxArr[4];
+  int cntArr[4];
+  _mm_storeu_ps(minArr, minV);
+  _mm_storeu_ps(maxArr, maxV);
+  _mm_storeu_si128((__m128i*)cntArr, cntSameV);
+
+  float zMinLocal = minArr[0], zMaxLocal = maxArr[0];
+  int cnt = cntArr[0] + cntArr[1] + cntArr[2] + cntArr[3];
+  for (int k = 1; k < 4; k++)
+  {
+    if (minArr[k] < zMinLocal)
+      zMinLocal = minArr[k];
+    if (maxArr[k] > zMaxLocal)
+      zMaxLocal = maxArr[k];
+  }
+  for (; i < num; i++)
+  {
+    float val = dataBuf[i];
+    if (val < zMinLocal)
+      zMinLocal = val;
+    else if (val > zMaxLocal)
+      zMaxLocal = val;
+    if (val == dataBuf[i - 1])
+      cnt++;
+  }
+
+  if (zMinLocal == 0 || zMaxLocal == 0)
+  {
+    ComputeStats<float>(dataBuf, num, zMin, zMax, cntSameVal);
+    return;
+  }
+
+  zMin = zMinLocal;
+  zMax = zMaxLocal;
+  cntSameVal += cnt;
+}
+
+// -------------------------------------------------------------------------- ;
+
+inline void Lerc2::QuantizeLossy(const float* dataBuf, int num, double zMin, double scale, unsigned int* dstPtr)
+{
+  const __m128d zMinV = _mm_set1_pd(zMin);
+  const __m128d scaleV = _mm_set1_pd(scale);
+  const __m128d halfV = _mm_set1_pd(0.5);
+  int i = 0;
+  for (; i + 4 <= num; i += 4)
+  {
+    __m128 val = _mm_loadu_ps(dataBuf + i);
+    __m128d lo = _mm_cvtps_pd(val);
+    __m128d hi = _mm_cvtps_pd(_mm_movehl_ps(val, val));
+    lo = _mm_add_pd(_mm_mul_pd(_mm_sub_pd(lo, zMinV), scaleV), halfV);
+    hi = _mm_add_pd(_mm_mul_pd(_mm_sub_pd(hi, zMinV), scaleV), halfV);
+
+    // the quantized values are below 2^30, so the signed conversion is
+    // exact, but leave NaN to the generic version
+    if (_mm_movemask_pd(_mm_cmpunord_pd(lo, hi)) != 0)
+    {
+      QuantizeLossy<float>(dataBuf + i, 4, zMin, scale, dstPtr + i);
+      continue;
+    }
+    __m128i q = _mm_unpacklo_epi64(_mm_cvttpd_epi32(lo), _mm_cvttpd_epi32(hi));
+    _mm_storeu_si128((__m128i*)(dstPtr + i), q);
+  }
+  QuantizeLossy<float>(dataBuf + i, num - i, zMin, scale, dstPtr + i);
+}
+
+// -------------------------------------------------------------------------- ;
+
+// unsigned int to double: the signed conversion of the value with its top bit
+// flipped, plus 2^31, is exact
+#define LERC_UINT_TO_PD_LO(v) _mm_add_pd(_mm_cvtepi32_pd(v), _mm_set1_pd(2147483648.0))
+#define LERC_UINT_TO_PD_HI(v) _mm_add_pd(_mm_cvtepi32_pd(_mm_srli_si128(v, 8)), _mm_set1_pd(2147483648.0))
+
+inline void Lerc2::Dequantize(const unsigned int* srcPtr, int num, double offset, double invScale, double zMax, float* dstPtr)
+{
+  const __m128i signV = _mm_set1_epi32((int)0x80000000U);
+  const __m128d offsetV = _mm_set1_pd(offset);
+  const __m128d invScaleV = _mm_set1_pd(invScale);
+  const __m128d zMaxV = _mm_set1_pd(zMax);
+  int i = 0;
+  for (; i + 4 <= num; i += 4)
+  {
+    __m128i v = _mm_xor_si128(_mm_loadu_si128((const __m128i*)(srcPtr + i)), signV);
+    __m128d lo = _mm_add_pd(offsetV, _mm_mul_pd(LERC_UINT_TO_PD_LO(v), invScaleV));
+    __m128d hi = _mm_add_pd(offsetV, _mm_mul_pd(LERC_UINT_TO_PD_HI(v), invScaleV));
+    // std::min(z, zMax) is (zMax < z) ? zMax : z, which is MINPD(zMax, z)
+    lo = _mm_min_pd(zMaxV, lo);
+    hi = _mm_min_pd(zMaxV, hi);
+    _mm_storeu_ps(dstPtr + i, _mm_movelh_ps(_mm_cvtpd_ps(lo), _mm_cvtpd_ps(hi)));
+  }
+  Dequantize<float>(srcPtr + i, num - i, offset, invScale, zMax, dstPtr + i);
+}
+
+inline void Lerc2::Dequantize(const unsigned int* srcPtr, int num, double offset, double invScale, double zMax, double* dstPtr)
+{
+  const __m128i signV = _mm_set1_epi32((int)0x80000000U);
+  const __m128d offsetV = _mm_set1_pd(offset);
+  const __m128d invScaleV = _mm_set1_pd(invScale);
+  const __m128d zMaxV = _mm_set1_pd(zMax);
+  int i = 0;
+  for (; i + 4 <= num; i += 4)
+  {
+    __m128i v = _mm_xor_si128(_mm_loadu_si128((const __m128i*)(srcPtr + i)), signV);
+    __m128d lo = _mm_add_pd(offsetV, _mm_mul_pd(LERC_UINT_TO_PD_LO(v), invScaleV));
+    __m128d hi = _mm_add_pd(offsetV, _mm_mul_pd(LERC_UINT_TO_PD_HI(v), invScaleV));
+    _mm_storeu_pd(dstPtr + i, _mm_min_pd(zMaxV, lo));
+    _mm_storeu_pd(dstPtr + i + 2, _mm_min_pd(zMaxV, hi));
+  }
+  Dequantize<double>(srcPtr + i, num - i, offset, invScale, zMax, dstPtr + i);
+}
+
+#undef LERC_UINT_TO_PD_LO
+#undef LERC_UINT_TO_PD_HI
+
+#endif    // LERC_USE_SSE2
+
+// -------------------------------------------------------------------------- ;
+
 template<class T>
 int Lerc2::NumBytesTile(int numValidPixel, T zMin, T zMax, bool tryLut, BlockEncodeMode& blockEncodeMode,
                          const std::vector<std::pair<unsigned int, unsigned int> >& sortedQuantVec) const
@@ -1305,15 +1500,26 @@ bool Lerc2::ReadTile(const Byte** ppByte, size_t& nBytesRemainingInOut, T* data,
 
       if (bufferVec.size() == maxElementCount)    // all valid
       {
-        for (int i = i0; i < i1; i++)
+        if (nDim == 1)
         {
-          int k = i * nCols + j0;
-          int m = k * nDim + iDim;
-
-          for (int j = j0; j < j1; j++, k++, m += nDim)
+          for (int i = i0; i < i1; i++)
+          {
+            Dequantize(srcPtr, j1 - j0, offset, invScale, zMax, &data[i * nCols + j0]);
+            srcPtr += j1 - j0;
+          }
+        }
+        else
+        {
+          for (int i = i0; i < i1; i++)
           {
-            double z = offset + *srcPtr++ * invScale;
-            data[m] = (T)std::min(z, zMax);    // make sure we stay in the orig range
+            int k = i * nCols + j0;
+            int m = k * nDim + iDim;
+
+            for (int j = j0; j < j1; j++, k++, m += nDim)
+            {
+              double z = offset + *srcPtr++ * invScale;
+              data[m] = (T)std::min(z, zMax);    // make sure we stay in the orig range
+            }
           }
         }
       }
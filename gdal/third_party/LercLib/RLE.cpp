@@ -315,13 +315,15 @@ bool RLE::decompress(const Byte* arrRLE, size_t nBytesRemaining, Byte* arr, size
 
     if (cnt > 0)
     {
-      while (i--) arr[arrIdx++] = *srcPtr++;
+      memcpy(arr + arrIdx, srcPtr, i);
+      srcPtr += i;
     }
     else
     {
       Byte b = *srcPtr++;
-      while (i--) arr[arrIdx++] = b;
+      memset(arr + arrIdx, b, i);
     }
+    arrIdx += i;
 
     nBytesRemaining -= m + 2;
     cnt = readCount(&srcPtr);